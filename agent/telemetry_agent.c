@@ -10,193 +10,1561 @@
 
 #include "telemetry_agent.h"
 #include "../os/include/osal_wakeup.h"
+#include "../os/include/osal_poll.h"
 #include "../os/include/osal_thread.h"
 #include "../core/ring_buffer.h"
+#include "../core/telemetry_protocol.h"
+#include "../core/sharded_counter.h"
+#include "../core/event_sampling.h"
+#include "../core/span.h"
+#include "../os/include/osal_time.h"
 
 #include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
 
-// Maximum number of events to process per wakeup (0 means no limit)
-#define TELEMETRY_AGENT_MAX_DRAIN_PER_WAKEUP 50
+// Ready descriptors handled per poller wait
+#define TELEMETRY_AGENT_POLL_EVENTS 8
+
+// Descriptor served by the agent loop for telemetry_agent_watch
+typedef struct agent_watch_s
+{
+    atomic_int fd;                      // Watched descriptor, -1 while the slot is free
+    telemetry_agent_watch_fn callback;  // Run on the agent thread when fd is ready
+    void* context;                      // Passed to callback
+} agent_watch_t;
 
 // Internal structure for the telemetry agent
 struct telemetry_agent
 {
-    osal_thread_t* consumer_thread;  // The background thread that does the work
-    osal_wakeup_t* wakeup;          // Used to wake up the thread when new events arrive
+    osal_thread_t* consumer_thread;  // The background thread that does the work
+    osal_wakeup_t* wakeup;          // Used to wake up the thread when new events arrive
+    osal_poller_t* poller;          // Waits on the wakeup, timer, blocked transport and watches, NULL with a futex wakeup
+    osal_timer_t* schedule_timer;   // Expires at the next heartbeat, metrics batch or resync, NULL without poller
+    uint64_t armed_deadline_ns;     // Deadline schedule_timer is armed for, 0 when disarmed (agent thread only)
+
+    atomic_bool stop_requested;     // Flag to tell the thread to stop
+
+    _Atomic(ring_buffer_t*) rings[TELEMETRY_AGENT_MAX_RINGS];  // Where events are stored, slot 0 is the start ring
+    atomic_uint ring_count;          // Slots claimed, a claimed slot may still read NULL for a moment
+    size_t next_ring;                // Ring drained first on the next wakeup (agent thread only)
+    signal_ring_t* signal_ring;      // Events from signal handlers, may be NULL
+    atomic_flag consumer_busy;       // Held while popping the producer rings, by the agent or a crash flush
+    transport_c_t* transport;        // How to send the events
+    int transport_fd;                // Transport descriptor polled while sends would block, -1 if none
+    bool transport_blocked;          // A send would have blocked, the rest of drain_batch waits (agent thread only)
+    bool transport_polled;           // transport_fd is in the poller (agent thread only)
+    bool final_drain;                // Stopping, sends that would block count as errors (agent thread only)
+    size_t blocked_index;            // First unsent event of drain_batch while blocked (agent thread only)
+    size_t blocked_count;            // Events in drain_batch while blocked (agent thread only)
+    uint32_t fragment_offset;        // Payload bytes of the pooled event being fragmented already sent (agent thread only)
+    uint32_t fragment_transfer;      // Transfer id of that event (agent thread only)
+    atomic_uint blocked_events;      // Events held back by a blocked transport, read by telemetry_agent_flush
+
+    uint32_t max_batch_events;       // Events in a transport batch before it is flushed, 0 for no limit
+    size_t max_batch_bytes;          // Payload bytes in a transport batch before it is flushed, 0 for no limit
+    uint64_t max_linger_ns;          // Longest wait of the first event of a batch for the flush
+    atomic_uint batch_events;        // Events sent since the last flush, read by telemetry_agent_flush
+    size_t batch_bytes;              // Payload bytes of those events (agent thread only)
+    uint64_t batch_start_ns;         // When the first of them was sent (agent thread only)
+    bool batch_full;                 // A full batch ended the drain pass, more events may wait (agent thread only)
+    atomic_bool flush_requested;     // telemetry_agent_flush wants the batch flushed without lingering
+
+    agent_watch_t watches[TELEMETRY_AGENT_MAX_WATCHES];  // Extra descriptors served by the agent loop
+
+    atomic_uint_fast64_t sent_count;    // How many events we've sent
+    sharded_counter_t* wakeup_count;    // How many times we've been woken up, bumped by every producer
+    atomic_uint_fast64_t send_error_count;  // How many events and batches the transport rejected
+    atomic_uint_fast64_t heartbeat_count;   // How many heartbeats we've sent
+    atomic_uint_fast64_t metrics_batch_count;   // How many metrics batches we've sent
+    atomic_uint_fast64_t sketched_count;        // How many events went into sketches
+    atomic_uint_fast64_t sketch_batch_count;    // How many sketch batches we've sent
+
+    uint64_t heartbeat_interval_ns;  // Time between heartbeats, 0 when disabled
+    uint64_t next_heartbeat_ns;      // When the next heartbeat is due (agent thread only)
+
+    telemetry_metrics_t* metrics;    // Metrics to publish, may be NULL
+    uint64_t metrics_interval_ns;    // Time between metrics batches, 0 publishes only on stop
+    uint64_t next_metrics_ns;        // When the next metrics batch is due (agent thread only)
+    size_t sampling_policies_published; // Sampling policies whose suppressed counters are in metrics (agent thread only)
+
+    telemetry_sketches_t* sketches;  // Quantile sketches filled from events, may be NULL
+
+    telemetry_event_t drain_batch[TELEMETRY_AGENT_DRAIN_BATCH];  // Events being processed (agent thread only)
+
+    uint8_t* message_buffer;         // Scratch space for metrics batches (agent thread only)
+    size_t message_capacity;         // Size of message_buffer
+
+    uint64_t start_time_ns;          // When the agent was started
+    uint64_t next_resync_ns;         // When the clock calibration is checked next (agent thread only)
+    uint32_t message_sequence;       // Sequence counter for protocol messages (agent thread only)
+    bool coarse_clock;               // Holds a reference to the coarse clock service
+    bool owned;                      // Agent and message buffer allocated, not in caller storage
+};
+
+_Static_assert(sizeof(struct telemetry_agent) <= TELEMETRY_AGENT_STATE_BYTES, "TELEMETRY_AGENT_STATE_BYTES is too small");
+
+/**
+ * @brief Returns an attached ring buffer.
+ *
+ * @param agent The agent.
+ * @param index Slot index, below the ring count.
+ * @return The ring, NULL if the slot is claimed but not yet filled.
+ */
+static inline ring_buffer_t* agent_ring(const telemetry_agent_t* agent, size_t index)
+{
+    return atomic_load_explicit((_Atomic(ring_buffer_t*)*)&agent->rings[index], memory_order_acquire);
+}
+
+/**
+ * @brief Returns the number of ring slots claimed.
+ *
+ * @param agent The agent.
+ * @return Slot count.
+ */
+static inline size_t agent_ring_count(const telemetry_agent_t* agent)
+{
+    return atomic_load_explicit((atomic_uint*)&agent->ring_count, memory_order_acquire);
+}
+
+/**
+ * @brief Builds and sends one heartbeat message.
+ *
+ * Reads the health counters with relaxed loads, so producers are never
+ * slowed down by a heartbeat.
+ *
+ * @param agent The agent doing the work.
+ * @param now_ns Current monotonic time.
+ */
+static void send_heartbeat(telemetry_agent_t* agent, uint64_t now_ns)
+{
+    uint8_t message[TELEMETRY_HEADER_LEN + TELEMETRY_HEARTBEAT_PAYLOAD_LEN];
+
+    // Collect the counters
+    telemetry_heartbeat_t heartbeat;
+    heartbeat.uptime_ns = now_ns - agent->start_time_ns;
+    heartbeat.sent_count = atomic_load_explicit(&agent->sent_count, memory_order_relaxed);
+    heartbeat.wakeup_count = sharded_counter_sum(agent->wakeup_count);
+    heartbeat.transport_error_count = atomic_load_explicit(&agent->send_error_count, memory_order_relaxed);
+    heartbeat.ring_dropped = 0;
+    heartbeat.ring_count = 0;
+    heartbeat.ring_capacity = 0;
+
+    // Totals over all attached rings
+    for(size_t index = 0; index < agent_ring_count(agent); index++)
+    {
+        const ring_buffer_t* ring = agent_ring(agent, index);
+
+        if(ring == NULL)
+            continue;
+
+        heartbeat.ring_dropped += ring_buffer_dropped(ring);
+        heartbeat.ring_count += (uint32_t)ring_buffer_count(ring);
+        heartbeat.ring_capacity += (uint32_t)ring_buffer_capacity(ring);
+    }
+
+    heartbeat.ring_dropped += signal_ring_dropped(agent->signal_ring);
+
+    // Header first, then the payload right behind it
+    telemetry_header_t header;
+    telemetry_header_v1_make(&header, TELEMETRY_HEART_BEAT_BATCH, agent->message_sequence, now_ns, TELEMETRY_HEARTBEAT_PAYLOAD_LEN);
+
+    size_t length = telemetry_encode_header_v1(message, sizeof(message), &header);
+    length += telemetry_encode_heartbeat_v1(&message[length], sizeof(message) - length, &heartbeat);
+
+    if(length != sizeof(message))
+        return;
+
+    agent->message_sequence++;
+
+    if(agent->transport->send_message(agent->transport->context, message, length))
+    {
+        atomic_fetch_add_explicit(&agent->heartbeat_count, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Sends a snapshot of all metrics.
+ *
+ * The snapshot is split into as many metrics batch messages as needed to
+ * stay within the configured message size. The suppressed counters of ids
+ * that got a sampling policy since the last snapshot are registered first.
+ *
+ * @param agent The agent doing the work.
+ * @param now_ns Current monotonic time.
+ */
+static void send_metrics(telemetry_agent_t* agent, uint64_t now_ns)
+{
+    const size_t header_length = telemetry_header_v1_length();
+    const size_t sampling_policies = telemetry_event_sampling_policy_count();
+    size_t cursor = 0;
+
+    // A full registry leaves the count behind, so the next snapshot tries again
+    if(sampling_policies != agent->sampling_policies_published &&
+       telemetry_event_sampling_register_metrics(agent->metrics) >= sampling_policies)
+    {
+        agent->sampling_policies_published = sampling_policies;
+    }
+
+    while(1)
+    {
+        // Encode the payload behind the space reserved for the header
+        const size_t payload_length = telemetry_metrics_encode(agent->metrics,
+                                                               &agent->message_buffer[header_length],
+                                                               agent->message_capacity - header_length,
+                                                               &cursor);
+
+        // Every metric has been encoded
+        if(payload_length == 0)
+            return;
+
+        telemetry_header_t header;
+        telemetry_header_v1_make(&header, TELEMETRY_METRICS_BATCH, agent->message_sequence, now_ns, (uint32_t)payload_length);
+
+        if(telemetry_encode_header_v1(agent->message_buffer, agent->message_capacity, &header) != header_length)
+            return;
+
+        agent->message_sequence++;
+
+        if(agent->transport->send_message(agent->transport->context, agent->message_buffer, header_length + payload_length))
+        {
+            atomic_fetch_add_explicit(&agent->metrics_batch_count, 1, memory_order_relaxed);
+        }
+        else
+        {
+            atomic_fetch_add_explicit(&agent->send_error_count, 1, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Sends all non-empty sketches and empties them.
+ *
+ * Each batch covers the samples since the previous one; the collector
+ * merges consecutive batches for longer windows.
+ *
+ * @param agent The agent doing the work.
+ * @param now_ns Current monotonic time.
+ */
+static void send_sketches(telemetry_agent_t* agent, uint64_t now_ns)
+{
+    const size_t header_length = telemetry_header_v1_length();
+    size_t cursor = 0;
+
+    while(1)
+    {
+        // Encode the payload behind the space reserved for the header
+        const size_t payload_length = telemetry_sketches_encode(agent->sketches,
+                                                                &agent->message_buffer[header_length],
+                                                                agent->message_capacity - header_length,
+                                                                &cursor);
+
+        // Every sketch has been encoded
+        if(payload_length == 0)
+            break;
+
+        telemetry_header_t header;
+        telemetry_header_v1_make(&header, TELEMETRY_SKETCH_BATCH, agent->message_sequence, now_ns, (uint32_t)payload_length);
+
+        if(telemetry_encode_header_v1(agent->message_buffer, agent->message_capacity, &header) != header_length)
+            break;
+
+        agent->message_sequence++;
+
+        if(agent->transport->send_message(agent->transport->context, agent->message_buffer, header_length + payload_length))
+        {
+            atomic_fetch_add_explicit(&agent->sketch_batch_count, 1, memory_order_relaxed);
+        }
+        else
+        {
+            atomic_fetch_add_explicit(&agent->send_error_count, 1, memory_order_relaxed);
+        }
+    }
+
+    telemetry_sketches_reset(agent->sketches);
+}
+
+/**
+ * @brief Flushes the transport batch.
+ *
+ * Hands the sends the transport queued to the OS and starts a new batch.
+ *
+ * @param agent The agent doing the work.
+ */
+static void flush_batch(telemetry_agent_t* agent)
+{
+    if(agent->transport->flush != NULL && !agent->transport->flush(agent->transport->context))
+        atomic_fetch_add_explicit(&agent->send_error_count, 1, memory_order_relaxed);
+
+    agent->batch_bytes = 0;
+    atomic_store_explicit(&agent->batch_events, 0u, memory_order_release);
+}
+
+/**
+ * @brief Adds a sent event to the transport batch.
+ *
+ * Flushes once the batch reaches max_batch_events or max_batch_bytes and
+ * marks the drain pass as done.
+ *
+ * @param agent The agent doing the work.
+ * @param event The event the transport took.
+ */
+static void add_to_batch(telemetry_agent_t* agent, const telemetry_event_t* event)
+{
+    const unsigned batch_events = atomic_load_explicit(&agent->batch_events, memory_order_relaxed) + 1u;
+
+    // The linger runs from the first event
+    if(batch_events == 1u)
+        agent->batch_start_ns = osal_telemetry_now_monotonic_ns();
+
+    agent->batch_bytes += event->payload_size;
+    atomic_store_explicit(&agent->batch_events, batch_events, memory_order_relaxed);
+
+    if((agent->max_batch_events != 0 && batch_events >= agent->max_batch_events) ||
+       (agent->max_batch_bytes != 0 && agent->batch_bytes >= agent->max_batch_bytes))
+    {
+        flush_batch(agent);
+        agent->batch_full = true;
+    }
+}
+
+/**
+ * @brief Returns when the linger of the transport batch ends.
+ *
+ * Saturates, so a linger of UINT64_MAX (size limits only) never wraps
+ * into the past.
+ *
+ * @param agent The agent.
+ * @return Monotonic deadline in nanoseconds.
+ */
+static uint64_t linger_deadline(const telemetry_agent_t* agent)
+{
+    if(agent->max_linger_ns > UINT64_MAX - agent->batch_start_ns)
+        return UINT64_MAX;
+
+    return agent->batch_start_ns + agent->max_linger_ns;
+}
+
+/**
+ * @brief Flushes the transport batch once it lingered long enough.
+ *
+ * A transport without a flush hook sent every event already, its batch
+ * only bounds the drain pass and never lingers.
+ *
+ * @param agent The agent doing the work.
+ * @param now_ns Current monotonic time.
+ */
+static void flush_batch_if_due(telemetry_agent_t* agent, uint64_t now_ns)
+{
+    const bool requested = atomic_exchange_explicit(&agent->flush_requested, false, memory_order_acq_rel);
+
+    if(atomic_load_explicit(&agent->batch_events, memory_order_relaxed) == 0)
+        return;
+
+    if(requested || agent->transport->flush == NULL || agent->max_linger_ns == 0 ||
+       now_ns >= linger_deadline(agent))
+        flush_batch(agent);
+}
+
+/**
+ * @brief Sends heartbeats, metrics and sketch batches that are due.
+ *
+ * @param agent The agent doing the work.
+ * @param force Send even if the intervals have not elapsed yet.
+ */
+static void publish_if_due(telemetry_agent_t* agent, bool force)
+{
+    // Transport can't carry binary messages
+    if(agent->transport->send_message == NULL)
+        return;
+
+    const uint64_t now_ns = osal_telemetry_now_monotonic_ns();
+    bool published = false;
+
+    // Heartbeats are skipped entirely when disabled
+    if(agent->heartbeat_interval_ns != 0 && (force || now_ns >= agent->next_heartbeat_ns))
+    {
+        send_heartbeat(agent, now_ns);
+        agent->next_heartbeat_ns = now_ns + agent->heartbeat_interval_ns;
+        published = true;
+    }
+
+    // Metrics without an interval still get a final snapshot on stop
+    if((agent->metrics != NULL || agent->sketches != NULL) &&
+       (force || (agent->metrics_interval_ns != 0 && now_ns >= agent->next_metrics_ns)))
+    {
+        if(agent->metrics != NULL)
+            send_metrics(agent, now_ns);
+
+        if(agent->sketches != NULL)
+            send_sketches(agent, now_ns);
+
+        agent->next_metrics_ns = now_ns + agent->metrics_interval_ns;
+        published = true;
+    }
+
+    // Reports do not linger, they go out with the events sent so far
+    if(published)
+        flush_batch(agent);
+}
+
+/**
+ * @brief Returns when the next scheduled agent task is due.
+ *
+ * The earliest of the heartbeat, the metrics batch, the clock resync and
+ * the end of the linger of an unflushed batch, so the agent thread wakes
+ * for them even when no events arrive.
+ *
+ * @param agent The agent.
+ * @return Monotonic deadline in nanoseconds.
+ */
+static uint64_t next_deadline(const telemetry_agent_t* agent)
+{
+    uint64_t deadline_ns = agent->next_resync_ns;
+
+    if(agent->transport->send_message != NULL)
+    {
+        if(agent->heartbeat_interval_ns != 0 && agent->next_heartbeat_ns < deadline_ns)
+            deadline_ns = agent->next_heartbeat_ns;
+
+        if((agent->metrics != NULL || agent->sketches != NULL) && agent->metrics_interval_ns != 0 &&
+           agent->next_metrics_ns < deadline_ns)
+            deadline_ns = agent->next_metrics_ns;
+    }
+
+    if(atomic_load_explicit(&agent->batch_events, memory_order_relaxed) != 0 &&
+       linger_deadline(agent) < deadline_ns)
+        deadline_ns = linger_deadline(agent);
+
+    return deadline_ns;
+}
+
+/**
+ * @brief Re-syncs the OSAL clock calibration once per interval.
+ *
+ * Producers timestamp events from the CPU counter when available; the agent
+ * keeps its conversion aligned with CLOCK_MONOTONIC.
+ *
+ * @param agent The agent doing the work.
+ */
+static void resync_clock_if_due(telemetry_agent_t* agent)
+{
+    const uint64_t now_ns = osal_telemetry_now_monotonic_ns();
+
+    if(now_ns < agent->next_resync_ns)
+        return;
+
+    osal_time_resync();
+    agent->next_resync_ns = now_ns + OSAL_TIME_RESYNC_INTERVAL_NS;
+}
+
+/**
+ * @brief Starts or stops polling the transport for room to write.
+ *
+ * @param agent The agent doing the work.
+ * @param blocked true once a send would have blocked, false when sends go through again.
+ */
+static void set_transport_blocked(telemetry_agent_t* agent, bool blocked)
+{
+    if(agent->transport_blocked == blocked)
+        return;
+
+    agent->transport_blocked = blocked;
+
+    // Only polled while blocked, an idle socket can report errors forever
+    if(blocked && agent->poller != NULL && agent->transport_fd >= 0)
+    {
+        agent->transport_polled = osal_poller_add(agent->poller, agent->transport_fd, OSAL_POLL_WRITABLE,
+                                                  &agent->transport_fd);
+    }
+    else if(!blocked && agent->transport_polled)
+    {
+        (void)osal_poller_remove(agent->poller, agent->transport_fd);
+        agent->transport_polled = false;
+    }
+}
+
+/**
+ * @brief Tells whether a failed send should be retried later.
+ *
+ * @param agent The agent doing the work.
+ * @return true if the transport would have blocked and the agent is not stopping.
+ */
+static bool send_would_block(const telemetry_agent_t* agent)
+{
+    return !agent->final_drain && agent->transport->would_block != NULL &&
+           agent->transport->would_block(agent->transport->context);
+}
+
+/**
+ * @brief Sends the payload of a pooled event as fragment messages.
+ *
+ * Each message carries as many payload bytes as the smaller of the message
+ * buffer and the transport limit leaves room for. A send that would block
+ * keeps agent->fragment_offset, so the retry continues the same transfer.
+ *
+ * @param agent The agent doing the work.
+ * @param event Pooled event to send.
+ * @param message_limit Largest message the transport accepts.
+ * @return true once every fragment was sent.
+ */
+static bool send_event_fragments(telemetry_agent_t* agent, const telemetry_event_t* event, size_t message_limit)
+{
+    const size_t header_length = telemetry_header_v1_length();
+    const size_t message_bytes = (message_limit < agent->message_capacity) ? message_limit : agent->message_capacity;
+    const size_t fragment_bytes = message_bytes - header_length - TELEMETRY_EVENT_FRAGMENT_HEADER_LEN;
+    const uint8_t* payload = telemetry_event_payload(event);
+    const uint64_t now_ns = osal_telemetry_now_monotonic_ns();
+
+    if(payload == NULL)
+        return false;
+
+    // A transfer is named after the sequence counter of its first message
+    if(agent->fragment_offset == 0)
+        agent->fragment_transfer = agent->message_sequence;
+
+    do
+    {
+        const size_t remaining = event->payload_size - agent->fragment_offset;
+
+        telemetry_event_fragment_t fragment = {
+            .event_id = event->event_id,
+            .transfer_id = agent->fragment_transfer,
+            .timestamp_ns = event->timestamp,
+            .payload_len = event->payload_size,
+            .fragment_offset = agent->fragment_offset,
+            .level = event->level,
+            .data = &payload[agent->fragment_offset],
+            .data_length = (uint32_t)((remaining < fragment_bytes) ? remaining : fragment_bytes),
+        };
+
+        // Encode the payload behind the space reserved for the header
+        const size_t payload_length = telemetry_encode_event_fragment_v1(&agent->message_buffer[header_length],
+                                                                         message_bytes - header_length, &fragment);
+
+        if(payload_length == 0)
+            return false;
+
+        telemetry_header_t header;
+        telemetry_header_v1_make(&header, TELEMETRY_EVENT_FRAGMENT, agent->message_sequence, now_ns, (uint32_t)payload_length);
+
+        if(telemetry_encode_header_v1(agent->message_buffer, agent->message_capacity, &header) != header_length)
+            return false;
+
+        agent->message_sequence++;
+
+        if(!agent->transport->send_message(agent->transport->context, agent->message_buffer, header_length + payload_length))
+            return false;
+
+        agent->fragment_offset += fragment.data_length;
+
+    } while(agent->fragment_offset < event->payload_size);
+
+    agent->fragment_offset = 0;
+
+    return true;
+}
+
+/**
+ * @brief Hands one event to the transport.
+ *
+ * A pooled payload goes out as fragment messages when the transport takes
+ * messages large enough for a fragment, so its size is not bound by one
+ * datagram; every other event goes through send_event.
+ *
+ * @param agent The agent doing the work.
+ * @param event Event to send.
+ * @return true if the transport took the event.
+ */
+static bool send_one_event(telemetry_agent_t* agent, const telemetry_event_t* event)
+{
+    if(telemetry_event_is_pooled(event) && agent->transport->send_message != NULL &&
+       agent->transport->max_message_bytes != NULL)
+    {
+        const size_t message_limit = agent->transport->max_message_bytes(agent->transport->context);
+
+        // Room for at least one payload byte per fragment
+        if(message_limit > telemetry_header_v1_length() + TELEMETRY_EVENT_FRAGMENT_HEADER_LEN)
+            return send_event_fragments(agent, event, message_limit);
+    }
+
+    return agent->transport->send_event(agent->transport->context, event);
+}
+
+/**
+ * @brief Sends events of the drain batch from first on.
+ *
+ * Stops at the first event the transport would block on; that event and
+ * the rest of the batch stay in agent->drain_batch for the next try.
+ *
+ * @param agent The agent doing the work.
+ * @param first First event to send.
+ * @param batch_count Events in agent->drain_batch.
+ * @return true if every event was handled, false if the transport would block.
+ */
+static bool send_events(telemetry_agent_t* agent, size_t first, size_t batch_count)
+{
+    for(size_t index = first; index < batch_count; index++)
+    {
+        telemetry_event_t* event = &agent->drain_batch[index];
+
+        // Sketched events are summarized instead of sent
+        if(telemetry_sketches_absorb(agent->sketches, event))
+        {
+            atomic_fetch_add_explicit(&agent->sketched_count, 1, memory_order_relaxed);
+        }
+        else if(send_one_event(agent, event))
+        {
+            // Send succeeded, increment sent count
+            atomic_fetch_add_explicit(&agent->sent_count, 1, memory_order_relaxed);
+            add_to_batch(agent, event);
+        }
+        else if(send_would_block(agent))
+        {
+            // Keep the rest, it is retried once the transport has room
+            agent->blocked_index = index;
+            agent->blocked_count = batch_count;
+            atomic_store_explicit(&agent->blocked_events, (unsigned)(batch_count - index), memory_order_release);
+            set_transport_blocked(agent, true);
+            return false;
+        }
+        else
+        {
+            // Count transport failures for the heartbeat, a fragmented event is dropped whole
+            atomic_fetch_add_explicit(&agent->send_error_count, 1, memory_order_relaxed);
+            agent->fragment_offset = 0;
+        }
+
+        // The transport is done with the payload, a pooled block goes back to its pool
+        telemetry_event_release_payload(event);
+    }
+
+    if(agent->transport_blocked)
+    {
+        atomic_store_explicit(&agent->blocked_events, 0u, memory_order_release);
+        set_transport_blocked(agent, false);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sends the events of the drain batch.
+ *
+ * @param agent The agent doing the work.
+ * @param batch_count Events in agent->drain_batch.
+ * @return true if every event was handled, false if the transport would block.
+ */
+static bool send_batch(telemetry_agent_t* agent, size_t batch_count)
+{
+    // Producers may have stored raw ticks, convert the whole batch at once
+    telemetry_span_resolve_records(agent->drain_batch, batch_count);
+    telemetry_event_resolve_timestamps(agent->drain_batch, batch_count);
+
+    return send_events(agent, 0, batch_count);
+}
+
+/**
+ * @brief Takes the events queued by signal handlers and sends them.
+ *
+ * @param agent The agent doing the work.
+ * @return false if the transport would block.
+ */
+static bool drain_signal_ring(telemetry_agent_t* agent)
+{
+    size_t batch_count = 0;
+
+    // Only a handful of events, no per wakeup limit
+    do
+    {
+        batch_count = 0;
+
+        while(batch_count < TELEMETRY_AGENT_DRAIN_BATCH &&
+              signal_ring_pop(agent->signal_ring, &agent->drain_batch[batch_count]))
+        {
+            batch_count++;
+        }
+
+        if(!send_batch(agent, batch_count))
+            return false;
+    }
+    while(batch_count == TELEMETRY_AGENT_DRAIN_BATCH);
+
+    return true;
+}
+
+/**
+ * @brief Takes events from one ring buffer and sends them.
+ *
+ * Pulls events from the buffer and sends them until empty or the
+ * transport batch is full.
+ *
+ * @param agent The agent doing the work.
+ * @param ring The ring buffer to drain.
+ * @return false if the transport would block.
+ */
+static bool drain_one_ring(telemetry_agent_t* agent, ring_buffer_t* ring)
+{
+    while(!agent->batch_full)
+    {
+        // Take no more than the transport batch has room for (no wait if empty)
+        size_t limit = TELEMETRY_AGENT_DRAIN_BATCH;
+        size_t batch_count = 0;
+
+        if(agent->max_batch_events != 0)
+        {
+            const size_t room = agent->max_batch_events - atomic_load_explicit(&agent->batch_events, memory_order_relaxed);
+
+            if(room < limit)
+                limit = room;
+        }
+
+        while(batch_count < limit && ring_buffer_pop(ring, &agent->drain_batch[batch_count]))
+        {
+            batch_count++;
+        }
+
+        if(batch_count == 0)
+        {
+            // Buffer empty, done
+            return true;
+        }
+
+        if(!send_batch(agent, batch_count))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Takes events from all attached ring buffers and sends them.
+ *
+ * Ends the pass once the transport batch is full and starts one ring
+ * further on each call, so a busy ring does not always go first and the
+ * others still get drained during a burst. Events held back by a blocked
+ * transport go first; while it stays blocked nothing more is popped and
+ * the rings absorb the backlog.
+ *
+ * @param agent The agent doing the work.
+ * @return false if the transport would block.
+ */
+static bool drain_ring_send_event(telemetry_agent_t* agent)
+{
+    // Check inputs
+    if(agent == NULL || agent->transport->send_event == NULL)
+    {
+        return true;
+    }
+
+    agent->batch_full = false;
+
+    // The held back events were popped first, keep the order
+    if(agent->transport_blocked && !send_events(agent, agent->blocked_index, agent->blocked_count))
+        return false;
+
+    // Usually last words, send them first
+    if(agent->signal_ring != NULL && !drain_signal_ring(agent))
+        return false;
+
+    const size_t ring_count = agent_ring_count(agent);
+
+    // A crash flush owns the producer rings, the next wakeup retries
+    if(ring_count == 0 || atomic_flag_test_and_set_explicit(&agent->consumer_busy, memory_order_acquire))
+        return true;
+
+    bool drained = true;
+
+    for(size_t offset = 0; offset < ring_count && drained && !agent->batch_full; offset++)
+    {
+        ring_buffer_t* ring = agent_ring(agent, (agent->next_ring + offset) % ring_count);
+
+        if(ring != NULL)
+            drained = drain_one_ring(agent, ring);
+    }
+
+    agent->next_ring = (agent->next_ring + 1u) % ring_count;
+
+    atomic_flag_clear_explicit(&agent->consumer_busy, memory_order_release);
+
+    return drained;
+}
+
+/**
+ * @brief Arms the schedule timer for a deadline unless it already is.
+ *
+ * @param agent The agent doing the work.
+ * @param deadline_ns Monotonic deadline, after now_ns.
+ * @param now_ns Current monotonic time.
+ * @return true if the timer ends the wait at the deadline.
+ */
+static bool arm_schedule_timer(telemetry_agent_t* agent, uint64_t deadline_ns, uint64_t now_ns)
+{
+    if(agent->armed_deadline_ns == deadline_ns)
+        return true;
+
+    if(!osal_timer_start(agent->schedule_timer, deadline_ns - now_ns, 0))
+        return false;
+
+    agent->armed_deadline_ns = deadline_ns;
+
+    return true;
+}
+
+/**
+ * @brief Waits until there is something to do.
+ *
+ * With a poller one wait covers the wakeup, the schedule timer, the
+ * transport while it would block and the watched descriptors, whose
+ * callbacks run here. With the futex wakeup it is a timed wait, and a
+ * blocked transport is retried every TELEMETRY_AGENT_BLOCKED_RETRY_NS.
+ *
+ * @param agent The agent doing the work.
+ */
+static void wait_for_work(telemetry_agent_t* agent)
+{
+    const uint64_t now_ns = osal_telemetry_now_monotonic_ns();
+
+    // Queued sends go out before the thread sleeps, unless the batch may still linger
+    flush_batch_if_due(agent, now_ns);
+
+    const uint64_t deadline_ns = next_deadline(agent);
+    uint64_t timeout_ns = (deadline_ns > now_ns) ? deadline_ns - now_ns : 0;
+
+    // A full batch ended the drain pass, only look at what is ready and go on
+    if(agent->batch_full)
+        timeout_ns = 0;
+
+    // Nothing reports when an unpolled transport has room again
+    const bool retry = agent->transport_blocked && !agent->transport_polled;
+
+    if(agent->poller == NULL)
+    {
+        if(retry && timeout_ns > TELEMETRY_AGENT_BLOCKED_RETRY_NS)
+            timeout_ns = TELEMETRY_AGENT_BLOCKED_RETRY_NS;
+
+        (void)osal_wakeup_wait_timeout(agent->wakeup, timeout_ns);
+        return;
+    }
+
+    // The timer keeps the deadline exact, the poller itself only has milliseconds
+    if(timeout_ns != 0 && arm_schedule_timer(agent, deadline_ns, now_ns))
+        timeout_ns = OSAL_WAIT_FOREVER;
+
+    if(retry && timeout_ns > TELEMETRY_AGENT_BLOCKED_RETRY_NS)
+        timeout_ns = TELEMETRY_AGENT_BLOCKED_RETRY_NS;
+
+    osal_poll_event_t events[TELEMETRY_AGENT_POLL_EVENTS];
+    const int count = osal_poller_wait(agent->poller, events, TELEMETRY_AGENT_POLL_EVENTS, timeout_ns);
+
+    for(int index = 0; index < count; index++)
+    {
+        void* context = events[index].context;
+
+        if(context == (void*)&agent->wakeup)
+        {
+            // Consume the notifications, the drain that follows handles them
+            (void)osal_wakeup_wait_timeout(agent->wakeup, 0);
+        }
+        else if(context == (void*)&agent->schedule_timer)
+        {
+            (void)osal_timer_expirations(agent->schedule_timer);
+            agent->armed_deadline_ns = 0;
+        }
+        else if(context != (void*)&agent->transport_fd)
+        {
+            // A watched descriptor; a writable transport needs nothing, the drain retries
+            const agent_watch_t* watch = (const agent_watch_t*)context;
+            watch->callback(watch->context, events[index].events);
+        }
+    }
+
+    // A broken poller must not spin the thread
+    if(count < 0)
+        osal_thread_sleep_ns(TELEMETRY_AGENT_BLOCKED_RETRY_NS);
+}
+
+/**
+ * @brief The main loop for the background thread.
+ *
+ * Waits for wakeup, then processes events.
+ *
+ * @param arg Pointer to the agent.
+ * @return Always NULL.
+ */
+static void* consumer_thread_main(void* arg)
+{
+    telemetry_agent_t* agent = (telemetry_agent_t*) arg;
+
+    if(agent == NULL)
+        return NULL;
+
+    while(1)
+    {
+        // Wait for wakeup, a writable transport, a watched descriptor, or until the next
+        // heartbeat, metrics batch or resync is due
+        wait_for_work(agent);
+
+        // Process events
+        (void)drain_ring_send_event(agent);
+
+        // Check stop flag
+        if(atomic_load_explicit(&agent->stop_requested, memory_order_acquire) == true)
+        {
+            // Give a blocked transport a moment to take the rest
+            const uint64_t give_up_ns = osal_telemetry_now_monotonic_ns() + TELEMETRY_AGENT_STOP_DRAIN_NS;
+
+            while(osal_telemetry_now_monotonic_ns() < give_up_ns)
+            {
+                if(!drain_ring_send_event(agent))
+                    osal_thread_sleep_ns(TELEMETRY_AGENT_FLUSH_POLL_NS);
+                else if(!agent->batch_full)
+                    break;
+            }
+
+            // Final process before exit, sends that still would block count as errors
+            agent->final_drain = true;
+
+            do
+            {
+                (void)drain_ring_send_event(agent);
+            }
+            while(agent->batch_full);
+
+            // Last heartbeat and metrics carry the final counters
+            publish_if_due(agent, true);
+            flush_batch(agent);
+            break;
+        }
+
+        // Report health and metrics when the interval elapsed
+        publish_if_due(agent, false);
+
+        // Keep the event clock aligned
+        resync_clock_if_due(agent);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Frees the agent and its message buffer unless they are in caller storage.
+ *
+ * The OSAL objects, counter and signal ring leave caller storage alone themselves.
+ *
+ * @param agent The agent.
+ */
+static void free_agent(telemetry_agent_t* agent)
+{
+    osal_timer_destroy(agent->schedule_timer);
+    osal_poller_destroy(agent->poller);
+    osal_wakeup_destroy(agent->wakeup);
+    signal_ring_free(agent->signal_ring);
+    sharded_counter_free(agent->wakeup_count);
+
+    if(!agent->owned)
+        return;
+
+    free(agent->message_buffer);
+    free(agent);
+}
+
+/**
+ * @brief Creates agent, thread, and wakeup mechanism.
+ *
+ * With memory every part is placed in it in the order of
+ * TELEMETRY_AGENT_STORAGE_BYTES, without memory every part is allocated.
+ *
+ * @param out_agent Where to store the agent pointer.
+ * @param memory Aligned caller storage, NULL to allocate.
+ * @param memory_bytes Size of memory.
+ * @param ring_handle The buffer to read from.
+ * @param transport How to send events.
+ * @param config Agent settings, NULL for defaults.
+ * @return true on success, false on failure.
+ */
+static bool start_agent(telemetry_agent_t** out_agent, uint8_t* memory, size_t memory_bytes,
+                        ring_buffer_t* ring_handle, transport_c_t* transport, const telemetry_agent_config_t* config)
+{
+    // Check inputs
+    if(out_agent == NULL || ring_handle == NULL || transport == NULL || transport->send_event == NULL)
+    {
+        return false;
+    }
+
+    // Use the defaults when no config is given
+    telemetry_agent_config_t defaults;
+    if(config == NULL)
+    {
+        telemetry_agent_config_init(&defaults);
+        config = &defaults;
+    }
+
+    // A message must at least hold the header and a small payload
+    if(config->max_message_bytes < telemetry_header_v1_length() + TELEMETRY_HEARTBEAT_PAYLOAD_LEN)
+    {
+        return false;
+    }
+
+    // Sketched events are never sent one by one, so the sketches need a way out
+    if(config->sketches != NULL && (transport->send_message == NULL || transport->max_message_bytes == NULL ||
+       transport->max_message_bytes(transport->context) == 0))
+    {
+        return false;
+    }
+
+    // Caller storage must hold every part, the parts check their own share again
+    if(memory != NULL && (config->max_message_bytes > memory_bytes ||
+       memory_bytes < TELEMETRY_AGENT_STORAGE_BYTES(config->max_message_bytes, config->signal_ring_capacity)))
+    {
+        return false;
+    }
+
+    // Allocate agent, or take it from the start of the storage
+    telemetry_agent_t* agent = NULL;
+
+    if(memory != NULL)
+    {
+        agent = (telemetry_agent_t*)memory;
+        memset(agent, 0, sizeof(*agent));
+        memory += TELEMETRY_AGENT_STATE_BYTES;
+    }
+    else
+    {
+        agent = (telemetry_agent_t*)calloc(1, sizeof(*agent));
+
+        if(agent == NULL)
+            return false;
+
+        agent->owned = true;
+    }
+
+    // Set handles, more rings can be attached later
+    atomic_init(&agent->rings[0], ring_handle);
+    for(size_t index = 1; index < TELEMETRY_AGENT_MAX_RINGS; index++)
+    {
+        atomic_init(&agent->rings[index], NULL);
+    }
+    atomic_init(&agent->ring_count, 1u);
+    atomic_flag_clear(&agent->consumer_busy);
+    agent->transport = transport;
+    agent->transport_fd = (transport->poll_fd != NULL) ? transport->poll_fd(transport->context) : -1;
+    atomic_init(&agent->blocked_events, 0u);
+    for(size_t index = 0; index < TELEMETRY_AGENT_MAX_WATCHES; index++)
+    {
+        atomic_init(&agent->watches[index].fd, -1);
+    }
+
+    // Init atomics
+    atomic_init(&agent->stop_requested, false);
+    atomic_init(&agent->sent_count, 0);
+    atomic_init(&agent->send_error_count, 0);
+    atomic_init(&agent->heartbeat_count, 0);
+    atomic_init(&agent->metrics_batch_count, 0);
+    atomic_init(&agent->sketched_count, 0);
+    atomic_init(&agent->sketch_batch_count, 0);
+
+    // Calibrate the clock here rather than on the first event
+    osal_time_init();
+
+    // Heartbeat schedule, the first one goes out as soon as the thread runs
+    agent->heartbeat_interval_ns = config->heartbeat_interval_ns;
+    agent->start_time_ns = osal_telemetry_now_monotonic_ns();
+    agent->next_resync_ns = agent->start_time_ns + OSAL_TIME_RESYNC_INTERVAL_NS;
+    agent->next_heartbeat_ns = agent->start_time_ns;
+    agent->message_sequence = 0;
+
+    // Metrics schedule, the first snapshot goes out after one interval
+    agent->metrics = config->metrics;
+    agent->metrics_interval_ns = config->metrics_interval_ns;
+    agent->next_metrics_ns = agent->start_time_ns + config->metrics_interval_ns;
+    agent->sampling_policies_published = 0;
+    agent->sketches = config->sketches;
+    agent->max_batch_events = config->max_batch_events;
+    agent->max_batch_bytes = config->max_batch_bytes;
+    agent->max_linger_ns = config->max_linger_ns;
+
+    // Scratch buffer for metrics batches, set up once so the loop never allocates
+    agent->message_capacity = config->max_message_bytes;
+
+    if(memory != NULL)
+    {
+        agent->message_buffer = memory;
+        memset(agent->message_buffer, 0, agent->message_capacity);
+        memory += TELEMETRY_STORAGE_ROUND(agent->message_capacity);
+    }
+    else
+    {
+        agent->message_buffer = (uint8_t*)calloc(1, agent->message_capacity);
+    }
+
+    if(agent->message_buffer == NULL)
+    {
+        free(agent);
+        return false;
+    }
+
+    // Producers on different cores bump the wakeup count, keep it off a shared line
+    bool counter_ready = false;
+
+    if(memory != NULL)
+    {
+        counter_ready = sharded_counter_init_static(&agent->wakeup_count, memory,
+                                                    SHARDED_COUNTER_STORAGE_BYTES(SHARDED_COUNTER_DEFAULT_SHARDS), 0);
+        memory += SHARDED_COUNTER_STORAGE_BYTES(SHARDED_COUNTER_DEFAULT_SHARDS);
+    }
+    else
+    {
+        counter_ready = sharded_counter_init(&agent->wakeup_count, 0);
+    }
+
+    if(!counter_ready)
+    {
+        free_agent(agent);
+        return false;
+    }
+
+    // Reserved now, a signal handler can not allocate
+    if(config->signal_ring_capacity != 0)
+    {
+        bool signal_ready = false;
+
+        if(memory != NULL)
+        {
+            signal_ready = signal_ring_init_static(&agent->signal_ring, memory,
+                                                   SIGNAL_RING_STORAGE_BYTES(config->signal_ring_capacity),
+                                                   config->signal_ring_capacity);
+            memory += SIGNAL_RING_STORAGE_BYTES(config->signal_ring_capacity);
+        }
+        else
+        {
+            signal_ready = signal_ring_init(&agent->signal_ring, config->signal_ring_capacity);
+        }
+
+        if(!signal_ready)
+        {
+            free_agent(agent);
+            return false;
+        }
+    }
+
+    // Create wakeup
+    if(memory != NULL)
+    {
+        agent->wakeup = osal_wakeup_create_static_ex(memory, OSAL_WAKEUP_STORAGE_BYTES, config->wakeup_backend);
+        memory += TELEMETRY_STORAGE_ROUND(OSAL_WAKEUP_STORAGE_BYTES);
+    }
+    else
+    {
+        agent->wakeup = osal_wakeup_create_ex(config->wakeup_backend);
+    }
+
+    if(agent->wakeup == NULL)
+    {
+        free_agent(agent);
+        return false;
+    }
+
+    // Poller and schedule timer, a futex wakeup has no descriptor to poll
+    const int wakeup_fd = osal_wakeup_fd(agent->wakeup);
+
+    if(wakeup_fd >= 0)
+    {
+        if(memory != NULL)
+        {
+            agent->poller = osal_poller_create_static(memory, OSAL_POLLER_STORAGE_BYTES);
+            agent->schedule_timer = osal_timer_create_static(memory + TELEMETRY_STORAGE_ROUND(OSAL_POLLER_STORAGE_BYTES),
+                                                             OSAL_TIMER_STORAGE_BYTES);
+        }
+        else
+        {
+            agent->poller = osal_poller_create();
+            agent->schedule_timer = osal_timer_create();
+        }
+
+        if(agent->poller == NULL || agent->schedule_timer == NULL ||
+           !osal_poller_add(agent->poller, wakeup_fd, OSAL_POLL_READABLE, &agent->wakeup) ||
+           !osal_poller_add(agent->poller, osal_timer_fd(agent->schedule_timer), OSAL_POLL_READABLE, &agent->schedule_timer))
+        {
+            free_agent(agent);
+            return false;
+        }
+    }
+
+    if(memory != NULL)
+        memory += TELEMETRY_STORAGE_ROUND(OSAL_POLLER_STORAGE_BYTES) + TELEMETRY_STORAGE_ROUND(OSAL_TIMER_STORAGE_BYTES);
+
+    // Coarse timestamps for the lifetime of the agent
+    if(config->coarse_clock_period_ns != 0)
+    {
+        if(!osal_time_coarse_start(config->coarse_clock_period_ns))
+        {
+            free_agent(agent);
+            return false;
+        }
+
+        agent->coarse_clock = true;
+    }
+
+    // Create thread
+    int rc = 0;
+
+    if(memory != NULL)
+    {
+        rc = osal_thread_create_static(&agent->consumer_thread, memory, OSAL_THREAD_STORAGE_BYTES,
+                                       consumer_thread_main, agent, "telemetry_agent", &config->thread_attr);
+    }
+    else
+    {
+        rc = osal_thread_create_ex(&agent->consumer_thread, consumer_thread_main, agent, "telemetry_agent",
+                                   &config->thread_attr);
+    }
+
+    if(rc != 0 || agent->consumer_thread == NULL)
+    {
+        // Cleanup on failure
+        if(agent->coarse_clock)
+            osal_time_coarse_stop();
+
+        free_agent(agent);
+        return false;
+    }
+
+    // Return agent
+    *out_agent = agent;
+
+    return true;
+}
+
+/**
+ * @brief Fills an agent configuration with default values.
+ *
+ * @param config The configuration to initialize.
+ */
+void telemetry_agent_config_init(telemetry_agent_config_t* config)
+{
+    if(config == NULL)
+        return;
 
-    atomic_bool stop_requested;     // Flag to tell the thread to stop
+    config->heartbeat_interval_ns = TELEMETRY_AGENT_DEFAULT_HEARTBEAT_INTERVAL_NS;
+    config->metrics = NULL;
+    config->metrics_interval_ns = TELEMETRY_AGENT_DEFAULT_METRICS_INTERVAL_NS;
+    config->sketches = NULL;
+    config->max_message_bytes = TELEMETRY_AGENT_DEFAULT_MAX_MESSAGE_BYTES;
+    config->coarse_clock_period_ns = 0;
+    config->signal_ring_capacity = TELEMETRY_AGENT_DEFAULT_SIGNAL_RING_CAPACITY;
+    osal_thread_attr_init(&config->thread_attr);
+    config->wakeup_backend = OSAL_WAKEUP_BACKEND_DEFAULT;
+    config->max_batch_events = TELEMETRY_AGENT_DEFAULT_MAX_BATCH_EVENTS;
+    config->max_batch_bytes = TELEMETRY_AGENT_DEFAULT_MAX_BATCH_BYTES;
+    config->max_linger_ns = TELEMETRY_AGENT_DEFAULT_MAX_LINGER_NS;
+}
 
-    ring_buffer_t* ring_buff_handle; // Where events are stored
-    transport_c_t* transport;        // How to send the events
+/**
+ * @brief Starts the telemetry agent.
+ *
+ * Creates agent, thread, and wakeup mechanism with the default settings.
+ *
+ * @param out_agent Where to store the agent pointer.
+ * @param ring_handle The buffer to read from.
+ * @param transport How to send events.
+ * @return true on success, false on failure.
+ */
+bool telemetry_agent_start(telemetry_agent_t** out_agent, ring_buffer_t* ring_handle, transport_c_t* transport)
+{
+    return telemetry_agent_start_ex(out_agent, ring_handle, transport, NULL);
+}
 
-    atomic_uint_fast64_t sent_count;    // How many events we've sent
-    atomic_uint_fast64_t wakeup_count;  // How many times we've been woken up
-};
+/**
+ * @brief Starts the telemetry agent with explicit settings.
+ *
+ * Creates agent, thread, and wakeup mechanism.
+ *
+ * @param out_agent Where to store the agent pointer.
+ * @param ring_handle The buffer to read from.
+ * @param transport How to send events.
+ * @param config Agent settings, NULL for defaults.
+ * @return true on success, false on failure.
+ */
+bool telemetry_agent_start_ex(telemetry_agent_t** out_agent, ring_buffer_t* ring_handle, transport_c_t* transport,
+                              const telemetry_agent_config_t* config)
+{
+    return start_agent(out_agent, NULL, 0, ring_handle, transport, config);
+}
 
 /**
- * @brief Takes events from the ring buffer and sends them.
+ * @brief Starts the telemetry agent in caller storage.
  *
- * Pulls events from the buffer and sends them until empty.
+ * Creates agent, thread, and wakeup mechanism without allocating.
  *
- * @param agent The agent doing the work.
- * @return Always NULL.
+ * @param out_agent Where to store the agent pointer.
+ * @param memory Storage aligned to TELEMETRY_STORAGE_ALIGN.
+ * @param memory_bytes Size of memory.
+ * @param ring_handle The buffer to read from.
+ * @param transport How to send events.
+ * @param config Agent settings, NULL for defaults.
+ * @return true on success, false on failure.
  */
-static void* drain_ring_send_event(telemetry_agent_t* agent)
+bool telemetry_agent_start_static(telemetry_agent_t** out_agent, void* memory, size_t memory_bytes,
+                                  ring_buffer_t* ring_handle, transport_c_t* transport,
+                                  const telemetry_agent_config_t* config)
 {
-    // Check inputs
-    if(agent == NULL || agent->ring_buff_handle == NULL || agent->transport->send_event == NULL)
+    if(!telemetry_storage_aligned(memory))
+        return false;
+
+    return start_agent(out_agent, (uint8_t*)memory, memory_bytes, ring_handle, transport, config);
+}
+
+/**
+ * @brief Notifies the telemetry agent.
+ *
+ * Wakes up the agent to process events.
+ *
+ * @param agent The agent to notify.
+ */
+void telemetry_agent_notify(telemetry_agent_t* agent)
+{
+    // Check input
+    if(agent == NULL)
     {
-        return NULL;
+        return;
     }
 
-    uint32_t drained = 0;  // Count processed events
+    // Increment wakeup count in this thread's slot
+    sharded_counter_add(agent->wakeup_count, 1);
 
-    while(1)
+    // Wake the thread
+    osal_wakeup_notify(agent->wakeup);
+}
+
+/**
+ * @brief Emits an event from a signal or fault handler.
+ *
+ * Only touches the stack, the signal ring and the wakeup object.
+ * The timestamp is raw ticks, converted by whoever sends the event.
+ *
+ * @param agent The agent.
+ * @param event_id Event id.
+ * @param payload Payload bytes, may be NULL when payload_size is 0.
+ * @param payload_size Payload size.
+ * @param level Severity level.
+ * @return true if queued, false if the signal ring is full or missing.
+ */
+bool telemetry_agent_emit_signal_safe(telemetry_agent_t* agent, uint32_t event_id, const void* payload,
+                                      size_t payload_size, telemetry_level_t level)
+{
+    telemetry_event_t event;
+
+    if(agent == NULL || agent->signal_ring == NULL || payload_size > TELEMETRY_EVENT_PAYLOAD_MAX ||
+       (payload == NULL && payload_size != 0))
     {
-        telemetry_event_t event;  // Space for event
+        return false;
+    }
 
-        // Get event from buffer (no wait if empty)
-        if(!ring_buffer_pop(agent->ring_buff_handle, &event))
-        {
-            // Buffer empty, done
-            return NULL;
-        }
+    event.event_id = event_id;
+    event.level = (uint8_t)level;
+    event.reserved = TELEMETRY_EVENT_FLAG_RAW_TICKS;
+    event.payload_size = (uint16_t)payload_size;
+    // The clock was initialized when the agent started, so this is a plain counter read
+    event.timestamp = osal_telemetry_now_ticks();
 
-        // Send event
-        const bool ok = agent->transport->send_event(agent->transport->context, &event);
+    if(payload_size != 0)
+        memcpy(event.payload, payload, payload_size);
 
-        if(ok)  // If send succeeded
-        {
-            // Increment sent count
-            atomic_fetch_add_explicit(&agent->sent_count, 1, memory_order_relaxed);
-        }
+    if(!signal_ring_push(agent->signal_ring, &event))
+        return false;
 
-        // Check drain limit
-        if(TELEMETRY_AGENT_MAX_DRAIN_PER_WAKEUP != 0)
-        {
-            drained++;
-            if(drained >= TELEMETRY_AGENT_MAX_DRAIN_PER_WAKEUP)
-            {
-                // Hit limit, stop
-                return NULL;
-            }
-        }
+    osal_wakeup_notify(agent->wakeup);
+
+    return true;
+}
+
+/**
+ * @brief Sends one event through the signal-safe transport path.
+ *
+ * @param agent The agent.
+ * @param event Event, raw ticks are converted in place.
+ * @return true if the transport accepted it.
+ */
+static bool crash_send(telemetry_agent_t* agent, telemetry_event_t* event)
+{
+    telemetry_span_resolve_record_signal_safe(event);
+
+    if((event->reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) != 0)
+    {
+        event->timestamp = osal_time_ticks_to_ns_signal_safe(event->timestamp);
+        event->reserved &= (uint8_t)~TELEMETRY_EVENT_FLAG_RAW_TICKS;
     }
+
+    return agent->transport->send_event_signal_safe(agent->transport->context, event);
 }
 
 /**
- * @brief The main loop for the background thread.
+ * @brief Sends queued events synchronously from a crash handler.
  *
- * Waits for wakeup, then processes events.
+ * Sketched event ids are sent as plain events, there is no later sketch
+ * batch to carry them. Blocks of pooled events are not given back, their
+ * pool is not async-signal-safe.
  *
- * @param arg Pointer to the agent.
- * @return Always NULL.
+ * @param agent The agent.
+ * @return Number of events the transport accepted.
  */
-static void* consumer_thread_main(void* arg)
+size_t telemetry_agent_crash_flush(telemetry_agent_t* agent)
 {
-    telemetry_agent_t* agent = (telemetry_agent_t*) arg;
+    telemetry_event_t event;
+    size_t sent = 0;
 
-    if(agent == NULL)
-        return NULL;
+    if(agent == NULL || agent->transport->send_event_signal_safe == NULL)
+        return 0;
 
-    while(1)
+    // Safe against the agent thread, the queue has many consumers
+    while(signal_ring_pop(agent->signal_ring, &event))
     {
-        // Wait for wakeup
-        osal_wakeup_wait(agent->wakeup);
-
-        // Process events
-        drain_ring_send_event(agent);
+        if(crash_send(agent, &event))
+            sent++;
+    }
 
-        // Check stop flag
-        if(atomic_load_explicit(&agent->stop_requested, memory_order_acquire) == true)
+    // Producer rings have a single consumer; skip them if the agent is popping right now
+    if(!atomic_flag_test_and_set_explicit(&agent->consumer_busy, memory_order_acquire))
+    {
+        for(size_t index = 0; index < agent_ring_count(agent); index++)
         {
-            // Final process before exit
-            drain_ring_send_event(agent);
-            break;
+            ring_buffer_t* ring = agent_ring(agent, index);
+
+            while(ring != NULL && ring_buffer_pop(ring, &event))
+            {
+                if(crash_send(agent, &event))
+                    sent++;
+            }
         }
+
+        atomic_flag_clear_explicit(&agent->consumer_busy, memory_order_release);
     }
 
-    return NULL;
+    atomic_fetch_add_explicit(&agent->sent_count, sent, memory_order_relaxed);
+
+    return sent;
 }
 
 /**
- * @brief Starts the telemetry agent.
+ * @brief Adds a ring buffer for the agent to drain.
  *
- * Creates agent, thread, and wakeup mechanism.
+ * Lock free, may be called from any thread while the agent runs. Rings
+ * stay attached until the agent is stopped and must outlive it.
  *
- * @param out_agent Where to store the agent pointer.
- * @param ring_handle The buffer to read from.
- * @param transport How to send events.
- * @return true on success, false on failure.
+ * @param agent The agent.
+ * @param ring_handle The ring buffer, filled by one producer thread.
+ * @return true on success, false if TELEMETRY_AGENT_MAX_RINGS rings are attached.
  */
-bool telemetry_agent_start(telemetry_agent_t** out_agent, ring_buffer_t* ring_handle, transport_c_t* transport)
+bool telemetry_agent_attach_ring(telemetry_agent_t* agent, ring_buffer_t* ring_handle)
 {
-    // Check inputs
-    if(out_agent == NULL || ring_handle == NULL || transport->send_event == NULL)
-    {
+    if(agent == NULL || ring_handle == NULL)
         return false;
-    }
 
-    // Allocate agent
-    telemetry_agent_t* agent = (telemetry_agent_t*)calloc(1, sizeof(*agent));
+    unsigned slot = atomic_load_explicit(&agent->ring_count, memory_order_relaxed);
 
-    if(agent == NULL)
-        return false;
+    // Claim a slot, then fill it; the agent skips claimed slots that are still empty
+    do
+    {
+        if(slot >= TELEMETRY_AGENT_MAX_RINGS)
+            return false;
+    }
+    while(!atomic_compare_exchange_weak_explicit(&agent->ring_count, &slot, slot + 1u,
+                                                 memory_order_acq_rel, memory_order_relaxed));
 
-    // Set handles
-    agent->ring_buff_handle = ring_handle;
-    agent->transport = transport;
+    atomic_store_explicit(&agent->rings[slot], ring_handle, memory_order_release);
 
-    // Init atomics
-    atomic_init(&agent->stop_requested, false);
-    atomic_init(&agent->sent_count, 0);
-    atomic_init(&agent->wakeup_count, 0);
+    return true;
+}
 
-    // Create wakeup
-    agent->wakeup = osal_wakeup_create();
+/**
+ * @brief Serves one more descriptor from the agent thread.
+ *
+ * Lock free like telemetry_agent_attach_ring: a free slot is claimed with a
+ * compare and swap of its descriptor and filled before the descriptor is
+ * registered, so the agent never sees an empty one. A failed registration
+ * gives its slot back.
+ *
+ * @param agent The agent.
+ * @param fd Descriptor, watched until the agent is stopped.
+ * @param events OSAL_POLL_READABLE and/or OSAL_POLL_WRITABLE.
+ * @param callback Run on the agent thread with the ready events.
+ * @param context Passed to callback.
+ * @return true on success, false without a poller, on a bad fd or with every slot taken.
+ */
+bool telemetry_agent_watch(telemetry_agent_t* agent, int fd, uint32_t events, telemetry_agent_watch_fn callback,
+                           void* context)
+{
+    if(agent == NULL || agent->poller == NULL || fd < 0 || callback == NULL)
+        return false;
 
-    if(agent->wakeup == NULL)
+    for(size_t slot = 0; slot < TELEMETRY_AGENT_MAX_WATCHES; slot++)
     {
-        free(agent);
-        return false;
-    }
+        agent_watch_t* watch = &agent->watches[slot];
+        int free_fd = -1;
 
-    // Create thread
-    const int rc = osal_thread_create(&agent->consumer_thread, consumer_thread_main, agent, "telemetry_agent");
+        if(!atomic_compare_exchange_strong_explicit(&watch->fd, &free_fd, fd, memory_order_acq_rel, memory_order_relaxed))
+            continue;
 
-    if(rc != 0 || agent->consumer_thread == NULL)
-    {
-        // Cleanup on failure
-        osal_wakeup_destroy(agent->wakeup);
-        free(agent);
+        watch->callback = callback;
+        watch->context = context;
+
+        if(osal_poller_add(agent->poller, fd, events, watch))
+            return true;
+
+        // Nothing was registered with this slot, the next watch may take it
+        atomic_store_explicit(&watch->fd, -1, memory_order_release);
         return false;
     }
 
-    // Return agent
-    *out_agent = agent;
-
-    return true;
+    return false;
 }
+
 /**
- * @brief Notifies the telemetry agent.
+ * @brief Waits until the attached ring buffers are empty.
  *
- * Wakes up the agent to process events.
+ * Keeps waking the agent and polls the rings every
+ * TELEMETRY_AGENT_FLUSH_POLL_NS, and for the events a blocked transport
+ * holds back and the transport batch, which the agent flushes without
+ * waiting for the linger. Events flushed last may still be on their way
+ * through the transport when this returns.
  *
- * @param agent The agent to notify.
+ * @param agent The agent.
+ * @param timeout_ns Longest wait in nanoseconds.
+ * @return true if all rings were drained, false on timeout.
  */
-void telemetry_agent_notify(telemetry_agent_t* agent)
+bool telemetry_agent_flush(telemetry_agent_t* agent, uint64_t timeout_ns)
 {
-    // Check input
     if(agent == NULL)
+        return false;
+
+    const uint64_t deadline_ns = osal_telemetry_now_monotonic_ns() + timeout_ns;
+
+    while(1)
     {
-        return;
-    }
+        bool empty = (signal_ring_count(agent->signal_ring) == 0 &&
+                      atomic_load_explicit(&agent->blocked_events, memory_order_acquire) == 0 &&
+                      atomic_load_explicit(&agent->batch_events, memory_order_acquire) == 0);
 
-    // Increment wakeup count
-    atomic_fetch_add_explicit(&agent->wakeup_count, 1, memory_order_relaxed);
+        for(size_t index = 0; index < agent_ring_count(agent) && empty; index++)
+        {
+            const ring_buffer_t* ring = agent_ring(agent, index);
 
-    // Wake the thread
-    osal_wakeup_notify(agent->wakeup);
+            if(ring != NULL && ring_buffer_count(ring) != 0)
+                empty = false;
+        }
+
+        if(empty)
+            return true;
+
+        if(osal_telemetry_now_monotonic_ns() >= deadline_ns)
+            return false;
+
+        // The batch goes out without lingering
+        atomic_store_explicit(&agent->flush_requested, true, memory_order_release);
+        osal_wakeup_notify(agent->wakeup);
+        osal_thread_sleep_ns(TELEMETRY_AGENT_FLUSH_POLL_NS);
+    }
 }
 
 /**
@@ -224,9 +1592,12 @@ void telemetry_agent_stop(telemetry_agent_t* agent)
     osal_thread_destroy(agent->consumer_thread);
     agent->consumer_thread = NULL;
 
-    // Destroy wakeup
-    osal_wakeup_destroy(agent->wakeup);
-    agent->wakeup = NULL;
+    // Release the coarse clock, it stops with the last user
+    if(agent->coarse_clock)
+    {
+        osal_time_coarse_stop();
+        agent->coarse_clock = false;
+    }
 
     // Shutdown transport
     if(agent->transport->shutdown)
@@ -234,7 +1605,7 @@ void telemetry_agent_stop(telemetry_agent_t* agent)
         agent->transport->shutdown(agent->transport->context);
     }
 
-    free(agent);
+    free_agent(agent);
 }
 
 /**
@@ -262,5 +1633,89 @@ uint64_t telemetry_agent_wakeup_count(const telemetry_agent_t* agent)
     if(agent == NULL)
         return 0;
 
-    return atomic_load_explicit(&agent->wakeup_count, memory_order_relaxed);
+    return sharded_counter_sum(agent->wakeup_count);
+}
+
+/**
+ * @brief Gets the transport error count.
+ *
+ * @param agent The agent.
+ * @return Number of events the transport failed to send.
+ */
+uint64_t telemetry_agent_send_error_count(const telemetry_agent_t* agent)
+{
+    if(agent == NULL)
+        return 0;
+
+    return atomic_load_explicit(&agent->send_error_count, memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the heartbeat count.
+ *
+ * @param agent The agent.
+ * @return Number of heartbeat messages sent.
+ */
+uint64_t telemetry_agent_heartbeat_count(const telemetry_agent_t* agent)
+{
+    if(agent == NULL)
+        return 0;
+
+    return atomic_load_explicit(&agent->heartbeat_count, memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the metrics batch count.
+ *
+ * @param agent The agent.
+ * @return Number of metrics batch messages sent.
+ */
+uint64_t telemetry_agent_metrics_batch_count(const telemetry_agent_t* agent)
+{
+    if(agent == NULL)
+        return 0;
+
+    return atomic_load_explicit(&agent->metrics_batch_count, memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the sketched event count.
+ *
+ * @param agent The agent.
+ * @return Number of events absorbed into quantile sketches.
+ */
+uint64_t telemetry_agent_sketched_count(const telemetry_agent_t* agent)
+{
+    if(agent == NULL)
+        return 0;
+
+    return atomic_load_explicit(&agent->sketched_count, memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the sketch batch count.
+ *
+ * @param agent The agent.
+ * @return Number of sketch batch messages sent.
+ */
+uint64_t telemetry_agent_sketch_batch_count(const telemetry_agent_t* agent)
+{
+    if(agent == NULL)
+        return 0;
+
+    return atomic_load_explicit(&agent->sketch_batch_count, memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the thread placement that took effect.
+ *
+ * @param agent The agent.
+ * @return OSAL_THREAD_APPLIED_* bits of the agent thread.
+ */
+uint32_t telemetry_agent_thread_applied(const telemetry_agent_t* agent)
+{
+    if(agent == NULL)
+        return 0;
+
+    return osal_thread_applied(agent->consumer_thread);
 }
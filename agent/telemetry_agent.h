@@ -13,7 +13,13 @@
 #include <stdbool.h>
 #include "../api/type.h"
 #include "../core/ring_buffer.h"
+#include "../core/metrics.h"
+#include "../core/quantile_sketch.h"
+#include "../core/signal_ring.h"
+#include "../core/sharded_counter.h"
+#include "../core/static_storage.h"
 #include "../os/include/osal_wakeup.h"
+#include "../os/include/osal_poll.h"
 #include "../os/include/osal_thread.h"
 #include "../transport/transport_c.h"
 
@@ -28,6 +34,119 @@
     */
     typedef struct telemetry_agent telemetry_agent_t;
 
+    // Callback of a watched descriptor, run on the agent thread with the ready OSAL_POLL_* events
+    typedef void (*telemetry_agent_watch_fn)(void* context, uint32_t events);
+
+    // Default interval between heartbeat messages (1 second)
+    #define TELEMETRY_AGENT_DEFAULT_HEARTBEAT_INTERVAL_NS 1000000000ull
+    // Default interval between metrics batches (1 second)
+    #define TELEMETRY_AGENT_DEFAULT_METRICS_INTERVAL_NS 1000000000ull
+    // Default size limit of one protocol message, matches the UDP transport default MTU
+    #define TELEMETRY_AGENT_DEFAULT_MAX_MESSAGE_BYTES 512u
+    // Ring buffers one agent drains, including the one passed to start
+    #ifndef TELEMETRY_AGENT_MAX_RINGS
+        #define TELEMETRY_AGENT_MAX_RINGS 64u
+    #endif
+    // Poll period of telemetry_agent_flush (100 us)
+    #define TELEMETRY_AGENT_FLUSH_POLL_NS 100000ull
+    // Default number of events reserved for telemetry_agent_emit_signal_safe
+    #define TELEMETRY_AGENT_DEFAULT_SIGNAL_RING_CAPACITY 64u
+    // Events popped before they are processed together
+    #define TELEMETRY_AGENT_DRAIN_BATCH 16u
+    // Default number of events handed to the transport before it is flushed
+    #define TELEMETRY_AGENT_DEFAULT_MAX_BATCH_EVENTS 64u
+    // Default payload bytes handed to the transport before it is flushed (64 KB)
+    #define TELEMETRY_AGENT_DEFAULT_MAX_BATCH_BYTES 65536u
+    // Default time a batch waits for more events before it is flushed, 0 flushes before every wait
+    #define TELEMETRY_AGENT_DEFAULT_MAX_LINGER_NS 0ull
+    // Extra descriptors telemetry_agent_watch can add to the agent loop
+    #define TELEMETRY_AGENT_MAX_WATCHES 8u
+    // Retry period of a blocked transport when the agent has no poller (1 ms)
+    #define TELEMETRY_AGENT_BLOCKED_RETRY_NS 1000000ull
+    // Time a blocked transport gets to drain on stop before its events count as errors (100 ms)
+    #define TELEMETRY_AGENT_STOP_DRAIN_NS 100000000ull
+
+    // Bytes of agent state in static storage, the ring table and the drain batch dominate
+    #define TELEMETRY_AGENT_STATE_BYTES \
+        TELEMETRY_STORAGE_ROUND(TELEMETRY_AGENT_MAX_RINGS * sizeof(void*) + TELEMETRY_AGENT_DRAIN_BATCH * sizeof(telemetry_event_t) + \
+                                TELEMETRY_AGENT_MAX_WATCHES * 3u * sizeof(void*) + 512u)
+
+    // Storage for telemetry_agent_start_static : state, message buffer, wakeup counter,
+    // signal ring (capacity a power of two, or 0), wakeup, poller, timer and thread objects
+    #define TELEMETRY_AGENT_STORAGE_BYTES(max_message_bytes, signal_ring_capacity) \
+        (TELEMETRY_AGENT_STATE_BYTES + TELEMETRY_STORAGE_ROUND(max_message_bytes) + \
+         SHARDED_COUNTER_STORAGE_BYTES(SHARDED_COUNTER_DEFAULT_SHARDS) + \
+         (((signal_ring_capacity) != 0u) ? SIGNAL_RING_STORAGE_BYTES(signal_ring_capacity) : 0u) + \
+         TELEMETRY_STORAGE_ROUND(OSAL_WAKEUP_STORAGE_BYTES) + TELEMETRY_STORAGE_ROUND(OSAL_POLLER_STORAGE_BYTES) + \
+         TELEMETRY_STORAGE_ROUND(OSAL_TIMER_STORAGE_BYTES) + TELEMETRY_STORAGE_ROUND(OSAL_THREAD_STORAGE_BYTES))
+
+    // Storage for telemetry_agent_start_static with the default settings
+    #define TELEMETRY_AGENT_DEFAULT_STORAGE_BYTES \
+        TELEMETRY_AGENT_STORAGE_BYTES(TELEMETRY_AGENT_DEFAULT_MAX_MESSAGE_BYTES, TELEMETRY_AGENT_DEFAULT_SIGNAL_RING_CAPACITY)
+
+    /**
+     * @brief Optional agent settings.
+     *
+     * Initialize with telemetry_agent_config_init() and override the fields you need.
+     */
+    typedef struct telemetry_agent_config_s
+    {
+        // Interval between heartbeat messages in nanoseconds, 0 disables heartbeats.
+        // Heartbeats are only sent when the transport provides send_message.
+        uint64_t heartbeat_interval_ns;
+
+        // Metrics registry to publish, NULL for none. Must outlive the agent. The agent adds the
+        // suppressed counters of ids with a sampling policy to it, see event_sampling.h.
+        telemetry_metrics_t* metrics;
+
+        // Interval between metrics batches in nanoseconds, 0 disables periodic publishing.
+        uint64_t metrics_interval_ns;
+
+        // Quantile sketches, NULL for none. Events with a registered id are added to their
+        // sketch instead of being sent, and the sketches are shipped and emptied every
+        // metrics interval. Requires send_message and a non-zero max_message_bytes.
+        // Must outlive the agent.
+        telemetry_sketches_t* sketches;
+
+        // Largest protocol message the transport accepts; bigger snapshots are split.
+        size_t max_message_bytes;
+
+        // Publish period of the coarse clock used by TELEMETRY_CLOCK_COARSE, 0 leaves the
+        // service off and coarse timestamps come from CLOCK_MONOTONIC_COARSE.
+        uint64_t coarse_clock_period_ns;
+
+        // Events reserved up front for telemetry_agent_emit_signal_safe, 0 disables that path.
+        uint32_t signal_ring_capacity;
+
+        // Placement of the agent thread : CPU affinity, SCHED_FIFO/SCHED_RR priority, stack
+        // size and a hook run on the thread before its loop. Refused settings fall back to
+        // the defaults, telemetry_agent_thread_applied() reports what took effect.
+        osal_thread_attr_t thread_attr;
+
+        // Mechanism producers use to wake the agent thread. The futex backend skips the
+        // system call while the agent is busy draining; the default follows the build.
+        // With eventfd the agent waits in a poller on the wakeup, a deadline timer, the
+        // transport socket while it would block and telemetry_agent_watch descriptors.
+        osal_wakeup_backend_t wakeup_backend;
+
+        // Flush policy. Sent events form a transport batch that is flushed (transport_c_t::flush)
+        // once it holds max_batch_events events or max_batch_bytes payload bytes, or once its
+        // first event waited max_linger_ns; 0 disables a size limit. A full batch also ends
+        // the drain pass, so heartbeats and watches get their turn during a burst. With
+        // max_linger_ns 0 the batch is flushed before every wait, a longer linger trades
+        // latency for fewer and larger flushes.
+        uint32_t max_batch_events;
+        size_t max_batch_bytes;
+        uint64_t max_linger_ns;
+    } telemetry_agent_config_t;
+
+    /**
+     * @brief Fills an agent configuration with default values.
+     *
+     * @param config The configuration to initialize.
+     */
+    void telemetry_agent_config_init(telemetry_agent_config_t* config);
+
     /**
      * @brief Starts the telemetry agent.
      *
@@ -40,6 +159,40 @@
      */
     bool telemetry_agent_start(telemetry_agent_t** out_agent, ring_buffer_t* ring_handle, transport_c_t* transport);
 
+    /**
+     * @brief Starts the telemetry agent with explicit settings.
+     *
+     * Same as telemetry_agent_start() but takes a configuration. A NULL config uses the defaults.
+     *
+     * @param out_agent Pointer to store the created agent.
+     * @param ring_handle The ring buffer to read events from.
+     * @param transport The transport to send events with.
+     * @param config Agent settings, or NULL for defaults.
+     * @return true if started successfully, false otherwise.
+     */
+    bool telemetry_agent_start_ex(telemetry_agent_t** out_agent, ring_buffer_t* ring_handle, transport_c_t* transport,
+                                  const telemetry_agent_config_t* config);
+
+    /**
+     * @brief Starts the telemetry agent in caller storage.
+     *
+     * Same as telemetry_agent_start_ex() but allocates nothing: the agent state,
+     * its message buffer, wakeup counter, signal ring, wakeup and thread objects
+     * are all placed in memory. The thread stack still comes from the system.
+     *
+     * @param out_agent Pointer to store the created agent.
+     * @param memory Storage aligned to TELEMETRY_STORAGE_ALIGN, valid until telemetry_agent_stop().
+     * @param memory_bytes Size of memory, at least TELEMETRY_AGENT_STORAGE_BYTES of the
+     *        configured max_message_bytes and signal_ring_capacity.
+     * @param ring_handle The ring buffer to read events from.
+     * @param transport The transport to send events with.
+     * @param config Agent settings, or NULL for defaults.
+     * @return true if started successfully, false otherwise.
+     */
+    bool telemetry_agent_start_static(telemetry_agent_t** out_agent, void* memory, size_t memory_bytes,
+                                      ring_buffer_t* ring_handle, transport_c_t* transport,
+                                      const telemetry_agent_config_t* config);
+
     /**
      * @brief Stops the telemetry agent.
      *
@@ -49,6 +202,48 @@
      */
     void telemetry_agent_stop(telemetry_agent_t* agent);
 
+    /**
+     * @brief Adds a ring buffer for the agent to drain.
+     *
+     * Each producer thread needs its own ring buffer; the agent drains all of them.
+     *
+     * @param agent The agent.
+     * @param ring_handle The ring buffer to read events from, must outlive the agent.
+     * @return true on success, false if TELEMETRY_AGENT_MAX_RINGS rings are attached.
+     */
+    bool telemetry_agent_attach_ring(telemetry_agent_t* agent, ring_buffer_t* ring_handle);
+
+    /**
+     * @brief Serves one more descriptor from the agent thread.
+     *
+     * The agent waits on the descriptor together with its wakeup and timers
+     * and runs the callback on its own thread whenever it is ready, level
+     * triggered. The rings are drained after every wake, so a callback may
+     * push events. Only available with the eventfd wakeup backend.
+     *
+     * @param agent The agent.
+     * @param fd Descriptor, stays open and watched until the agent is stopped.
+     * @param events OSAL_POLL_READABLE and/or OSAL_POLL_WRITABLE.
+     * @param callback Called with context and the ready OSAL_POLL_* events.
+     * @param context Passed to the callback.
+     * @return true on success, false without a poller, on a bad fd or if
+     *         TELEMETRY_AGENT_MAX_WATCHES descriptors are watched.
+     */
+    bool telemetry_agent_watch(telemetry_agent_t* agent, int fd, uint32_t events, telemetry_agent_watch_fn callback,
+                               void* context);
+
+    /**
+     * @brief Waits until the agent has emptied its ring buffers.
+     *
+     * Also waits for events held back while the transport would block, and
+     * has the agent flush its transport batch without waiting for the linger.
+     *
+     * @param agent The agent.
+     * @param timeout_ns Longest wait in nanoseconds.
+     * @return true if all rings were drained, false on timeout.
+     */
+    bool telemetry_agent_flush(telemetry_agent_t* agent, uint64_t timeout_ns);
+
     /**
      * @brief Notifies the telemetry agent.
      *
@@ -58,6 +253,38 @@
      */
     void telemetry_agent_notify(telemetry_agent_t* agent);
 
+    /**
+     * @brief Emits an event from a signal or fault handler.
+     *
+     * Async-signal-safe: builds the event on the stack with a raw tick
+     * timestamp, pushes it to the agent's pre-reserved signal ring with
+     * lock-free atomics and wakes the agent with write(2) or FUTEX_WAKE. Any thread may
+     * call it, the level and event id filters are not applied.
+     *
+     * @param agent The agent, started with a non-zero signal_ring_capacity.
+     * @param event_id Event id.
+     * @param payload Payload bytes, may be NULL when payload_size is 0.
+     * @param payload_size Payload size, at most TELEMETRY_EVENT_PAYLOAD_MAX.
+     * @param level Severity level.
+     * @return true if queued, false if the signal ring is full or missing.
+     */
+    bool telemetry_agent_emit_signal_safe(telemetry_agent_t* agent, uint32_t event_id, const void* payload,
+                                          size_t payload_size, telemetry_level_t level);
+
+    /**
+     * @brief Sends queued events synchronously from a crash handler.
+     *
+     * Async-signal-safe. Pops the signal ring and, unless the agent thread
+     * is in the middle of draining them, the producer rings, and hands every
+     * event to the transport's send_event_signal_safe on the calling thread.
+     * Does nothing if the transport has no such function. Events a crashed
+     * producer was pushing or the agent had already popped may be lost.
+     *
+     * @param agent The agent.
+     * @return Number of events the transport accepted.
+     */
+    size_t telemetry_agent_crash_flush(telemetry_agent_t* agent);
+
     /**
      * @brief Gets the number of events sent.
      *
@@ -78,6 +305,59 @@
      */
     uint64_t telemetry_agent_wakeup_count(const telemetry_agent_t* agent);
 
+    /**
+     * @brief Gets the number of transport errors.
+     *
+     * Returns how many events and metrics or sketch batches the transport failed to send.
+     *
+     * @param agent The agent to query.
+     * @return Number of failed sends.
+     */
+    uint64_t telemetry_agent_send_error_count(const telemetry_agent_t* agent);
+
+    /**
+     * @brief Gets the number of heartbeats sent.
+     *
+     * @param agent The agent to query.
+     * @return Number of heartbeat messages handed to the transport.
+     */
+    uint64_t telemetry_agent_heartbeat_count(const telemetry_agent_t* agent);
+
+    /**
+     * @brief Gets the number of metrics batches sent.
+     *
+     * @param agent The agent to query.
+     * @return Number of metrics batch messages handed to the transport.
+     */
+    uint64_t telemetry_agent_metrics_batch_count(const telemetry_agent_t* agent);
+
+    /**
+     * @brief Gets the number of events added to quantile sketches.
+     *
+     * @param agent The agent to query.
+     * @return Number of events absorbed into sketches instead of being sent.
+     */
+    uint64_t telemetry_agent_sketched_count(const telemetry_agent_t* agent);
+
+    /**
+     * @brief Gets the number of sketch batches sent.
+     *
+     * @param agent The agent to query.
+     * @return Number of sketch batch messages handed to the transport.
+     */
+    uint64_t telemetry_agent_sketch_batch_count(const telemetry_agent_t* agent);
+
+    /**
+     * @brief Gets the thread placement that took effect.
+     *
+     * The affinity and scheduling bits are set once the agent thread has
+     * started; a setting the system refused is missing.
+     *
+     * @param agent The agent to query.
+     * @return OSAL_THREAD_APPLIED_* bits of the agent thread.
+     */
+    uint32_t telemetry_agent_thread_applied(const telemetry_agent_t* agent);
+
 
 
 #ifdef __cplusplus
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * @file config.hpp
+ * @brief Settings of the C++ telemetry facade.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../transport/transport.hpp"
+
+extern "C" {
+    #include "../agent/telemetry_agent.h"
+}
+
+namespace telemetry {
+
+    // Default events per producer ring buffer
+    constexpr size_t kDefaultRingCapacity = 1024;
+    // Default number of producer ring buffers
+    constexpr size_t kDefaultMaxProducers = 8;
+    // Default longest wait for the rings to drain at teardown (100 ms)
+    constexpr uint64_t kDefaultFlushTimeoutNs = 100000000ull;
+
+    // Everything telemetry::Telemetry allocates and starts in its constructor
+    struct Config
+    {
+        size_t ring_capacity = kDefaultRingCapacity;        // Events per producer ring buffer
+        size_t max_producers = kDefaultMaxProducers;        // Ring buffers allocated up front, at most TELEMETRY_AGENT_MAX_RINGS
+        uint64_t flush_timeout_ns = kDefaultFlushTimeoutNs; // Longest wait for the rings to drain at teardown
+        size_t payload_block_size = 0;                      // Bytes per block of the large payload pool, 0 for no pool, at most 65535
+        size_t payload_block_count = 0;                     // Blocks in the large payload pool
+        ring_buffer_options_t ring_options;                 // Huge pages, pre-faulting, locking and NUMA node of the rings;
+                                                            // OSAL_MEMORY_NODE_LOCAL follows the thread that claims a ring
+        transport::Config transport;                        // Passed to ITransport::Init
+        telemetry_agent_config_t agent;                     // Agent settings, defaults of telemetry_agent_config_init
+
+        Config()
+        {
+            telemetry_agent_config_init(&agent);
+            ring_buffer_options_init(&ring_options);
+        }
+    };
+
+}
@@ -0,0 +1,464 @@
+/**
+ * @file telemetry.cpp
+ * @brief Runtime helpers of the C++ API.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include "telemetry.hpp"
+#include "../core/telemetry_protocol.h"
+#include "../transport/transport_adapter.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+
+namespace telemetry {
+
+namespace {
+
+    // Instances that are alive, checked by threads that exit with a handle.
+    // Only taken on construction, destruction, the first local() of a thread and thread exit.
+    std::mutex& live_lock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    std::vector<uint64_t>& live_instances()
+    {
+        static std::vector<uint64_t> instances;
+        return instances;
+    }
+
+    // Thread local handles of all threads, so a destroyed instance can invalidate them
+    struct LocalHandle
+    {
+        uint64_t instance_id;
+        Producer* producer;
+    };
+
+    std::vector<LocalHandle>& local_handles()
+    {
+        static std::vector<LocalHandle> handles;
+        return handles;
+    }
+
+    std::atomic<uint64_t> next_instance_id{1};
+
+}
+
+namespace detail {
+
+    // Handles of one thread, one per instance it emitted through
+    struct LocalProducers
+    {
+        struct Entry
+        {
+            uint64_t instance_id;
+            Producer producer;
+        };
+
+        std::vector<std::unique_ptr<Entry>> entries;
+
+        // Gives the rings back to instances that are still alive
+        ~LocalProducers()
+        {
+            std::lock_guard<std::mutex> guard(live_lock());
+            const std::vector<uint64_t>& live = live_instances();
+            std::vector<LocalHandle>& handles = local_handles();
+
+            for(std::unique_ptr<Entry>& entry : entries)
+            {
+                Producer* producer = &entry->producer;
+                handles.erase(std::remove_if(handles.begin(), handles.end(),
+                                             [producer](const LocalHandle& handle) { return handle.producer == producer; }),
+                              handles.end());
+
+                if(std::find(live.begin(), live.end(), entry->instance_id) == live.end())
+                {
+                    // The instance and its rings are gone, nothing to release
+                    entry->producer.detach();
+                }
+            }
+
+            entries.clear();
+        }
+    };
+
+    thread_local LocalProducers local_producers;
+
+}
+
+/**
+ * @brief Releases the ring of the handle.
+ */
+Producer::~Producer()
+{
+    release();
+}
+
+/**
+ * @brief Takes over the ring of another handle.
+ *
+ * @param other Handle to move from, invalid afterwards.
+ */
+Producer::Producer(Producer&& other) noexcept
+    : owner_(other.owner_), slot_(other.slot_), ring_(other.ring_), agent_(other.agent_), pool_(other.pool_)
+{
+    other.owner_ = nullptr;
+    other.ring_ = nullptr;
+    other.agent_ = nullptr;
+    other.pool_ = nullptr;
+}
+
+/**
+ * @brief Releases this handle's ring and takes over the ring of another handle.
+ *
+ * @param other Handle to move from, invalid afterwards.
+ * @return This handle.
+ */
+Producer& Producer::operator=(Producer&& other) noexcept
+{
+    if(this != &other)
+    {
+        release();
+
+        owner_ = other.owner_;
+        slot_ = other.slot_;
+        ring_ = other.ring_;
+        agent_ = other.agent_;
+        pool_ = other.pool_;
+
+        other.owner_ = nullptr;
+        other.ring_ = nullptr;
+        other.agent_ = nullptr;
+        other.pool_ = nullptr;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Gives the ring back to its Telemetry.
+ *
+ * Events still in the ring are sent by the agent as usual.
+ */
+void Producer::release()
+{
+    if(owner_ != nullptr)
+        owner_->release(slot_);
+
+    owner_ = nullptr;
+    ring_ = nullptr;
+    agent_ = nullptr;
+    pool_ = nullptr;
+}
+
+/**
+ * @brief Forgets the ring without giving it back, for a Telemetry that is gone.
+ */
+void Producer::detach()
+{
+    owner_ = nullptr;
+    ring_ = nullptr;
+    agent_ = nullptr;
+    pool_ = nullptr;
+}
+
+/**
+ * @brief Creates the transport, rings and agent.
+ *
+ * Everything is allocated here, so emitting never allocates; a failed step
+ * undoes the earlier ones and leaves started() false.
+ *
+ * @param transport Transport to send through, initialized with config.transport.
+ * @param config Settings.
+ */
+Telemetry::Telemetry(std::unique_ptr<transport::ITransport> transport, const Config& config)
+    : config_(config), transport_(std::move(transport)), instance_id_(next_instance_id.fetch_add(1, std::memory_order_relaxed))
+{
+    if(transport_ == nullptr || config_.max_producers == 0 || config_.max_producers > TELEMETRY_AGENT_MAX_RINGS)
+        return;
+
+    if(!transport_->Init(config_.transport))
+        return;
+
+    transport_ready_ = true;
+    c_transport_ = transport_adapter::make_transport_adapter(*transport_);
+
+    // All rings up front, producers only claim them
+    rings_.assign(config_.max_producers, nullptr);
+    claimed_.reset(new std::atomic<bool>[config_.max_producers]);
+
+    for(size_t slot = 0; slot < config_.max_producers; slot++)
+    {
+        claimed_[slot].store(false, std::memory_order_relaxed);
+
+        if(!ring_buffer_init_ex(&rings_[slot], config_.ring_capacity, &config_.ring_options))
+        {
+            shutdown();
+            return;
+        }
+    }
+
+    // Large payloads go through the pool, the agent gives the blocks back
+    if(config_.payload_block_size != 0 && config_.payload_block_count != 0)
+    {
+        const size_t message_limit = transport_->maxMessageBytes();
+
+        // Refuse blocks no event could fill, and transports whose messages hold no fragment
+        if(config_.payload_block_size > TELEMETRY_EVENT_POOLED_PAYLOAD_MAX ||
+           (message_limit != 0 && message_limit <= telemetry_header_v1_length() + TELEMETRY_EVENT_FRAGMENT_HEADER_LEN) ||
+           !memory_pool_init(&payload_pool_, config_.payload_block_size, config_.payload_block_count))
+        {
+            payload_pool_ = nullptr;
+            shutdown();
+            return;
+        }
+    }
+
+    if(!telemetry_agent_start_ex(&agent_, rings_[0], &c_transport_, &config_.agent))
+    {
+        agent_ = nullptr;
+        shutdown();
+        return;
+    }
+
+    for(size_t slot = 1; slot < config_.max_producers; slot++)
+    {
+        (void)telemetry_agent_attach_ring(agent_, rings_[slot]);
+    }
+
+    std::lock_guard<std::mutex> guard(live_lock());
+    live_instances().push_back(instance_id_);
+}
+
+/**
+ * @brief Flushes and stops everything.
+ */
+Telemetry::~Telemetry()
+{
+    {
+        // Threads exiting from now on leave this instance alone
+        std::lock_guard<std::mutex> guard(live_lock());
+        std::vector<uint64_t>& live = live_instances();
+        live.erase(std::remove(live.begin(), live.end(), instance_id_), live.end());
+
+        // Handles still cached by other threads forget the rings freed below
+        for(LocalHandle& handle : local_handles())
+        {
+            if(handle.instance_id == instance_id_)
+                handle.producer->detach();
+        }
+    }
+
+    if(agent_ != nullptr)
+        (void)telemetry_agent_flush(agent_, config_.flush_timeout_ns);
+
+    shutdown();
+}
+
+/**
+ * @brief Stops the agent, shuts the transport down and frees the rings and the payload pool.
+ */
+void Telemetry::shutdown()
+{
+    // Stopping the agent also shuts the transport down
+    if(agent_ != nullptr)
+    {
+        telemetry_agent_stop(agent_);
+        agent_ = nullptr;
+    }
+    else if(transport_ready_)
+    {
+        transport_->shutdown();
+    }
+
+    transport_ready_ = false;
+
+    for(ring_buffer_t*& ring : rings_)
+    {
+        if(ring != nullptr)
+            ring_buffer_free(ring);
+
+        ring = nullptr;
+    }
+
+    // After the agent, its final drain still returns blocks
+    memory_pool_free(payload_pool_);
+    payload_pool_ = nullptr;
+}
+
+/**
+ * @brief Claims a free ring buffer.
+ *
+ * Lock free; scans the rings for one that is not claimed. With
+ * OSAL_MEMORY_NUMA_BIND on the calling thread's node the ring's pages are
+ * moved to that node if they are elsewhere, one system call per claim.
+ *
+ * @return Handle owning the ring, invalid if none is free or the instance did not start.
+ */
+Producer Telemetry::producer()
+{
+    if(agent_ == nullptr)
+        return Producer();
+
+    for(size_t slot = 0; slot < rings_.size(); slot++)
+    {
+        bool expected = false;
+
+        if(!claimed_[slot].load(std::memory_order_relaxed) &&
+           claimed_[slot].compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            // The constructor's thread placed the ring, move it to the claiming thread's node
+            if((config_.ring_options.memory_flags & OSAL_MEMORY_NUMA_BIND) != 0 &&
+               config_.ring_options.numa_node == OSAL_MEMORY_NODE_LOCAL)
+            {
+                (void)ring_buffer_bind_node(rings_[slot], OSAL_MEMORY_NODE_LOCAL);
+            }
+
+            return Producer(this, slot, rings_[slot], agent_, payload_pool_);
+        }
+    }
+
+    return Producer();
+}
+
+/**
+ * @brief Returns the calling thread's handle.
+ *
+ * The first call of a thread claims a ring; the ring is given back when
+ * the thread exits. If all rings are taken the handle is invalid and its
+ * emits return false; the next call tries to claim again. The destructor
+ * invalidates the handles of all threads, so their emits after it return
+ * false instead of touching freed rings.
+ *
+ * @return Handle of the calling thread.
+ */
+Producer& Telemetry::local()
+{
+    detail::LocalProducers& local_producers = detail::local_producers;
+
+    for(std::unique_ptr<detail::LocalProducers::Entry>& entry : local_producers.entries)
+    {
+        if(entry->instance_id == instance_id_)
+        {
+            if(!entry->producer.valid())
+                entry->producer = producer();
+
+            return entry->producer;
+        }
+    }
+
+    local_producers.entries.push_back(std::unique_ptr<detail::LocalProducers::Entry>(new detail::LocalProducers::Entry{ instance_id_, producer() }));
+    Producer& handle = local_producers.entries.back()->producer;
+
+    {
+        std::lock_guard<std::mutex> guard(live_lock());
+        local_handles().push_back(LocalHandle{ instance_id_, &handle });
+    }
+
+    return handle;
+}
+
+/**
+ * @brief Waits until the agent has emptied all rings.
+ *
+ * @param timeout_ns Longest wait in nanoseconds.
+ * @return true if all rings were drained, false on timeout or if the instance did not start.
+ */
+bool Telemetry::flush(uint64_t timeout_ns)
+{
+    return telemetry_agent_flush(agent_, timeout_ns);
+}
+
+/**
+ * @brief Marks a ring as free.
+ *
+ * The release store pairs with the acquire of the next claim, so the next
+ * producer of the ring sees everything the previous one pushed.
+ *
+ * @param slot Ring index.
+ */
+void Telemetry::release(size_t slot)
+{
+    if(claimed_ != nullptr && slot < rings_.size())
+        claimed_[slot].store(false, std::memory_order_release);
+}
+
+namespace schema {
+
+/**
+ * @brief Formats a payload field by field.
+ *
+ * Lets a receiver print events of any described type without the type
+ * itself, e.g. from a description shipped with the collector.
+ *
+ * @param fields Field descriptions, from describe<T>().
+ * @param field_count Number of fields.
+ * @param payload Event payload.
+ * @param length Payload size.
+ * @param output Output buffer, always NUL terminated.
+ * @param output_capacity Output buffer size.
+ * @return Length of the text written.
+ */
+size_t format_fields(const FieldInfo* fields, size_t field_count, const uint8_t* payload, size_t length,
+                     char* output, size_t output_capacity)
+{
+    size_t position = 0;
+
+    if(output == nullptr || output_capacity == 0)
+        return 0;
+
+    output[0] = '\0';
+
+    if(fields == nullptr || payload == nullptr)
+        return 0;
+
+    for(size_t index = 0; index < field_count; index++)
+    {
+        const FieldInfo& field = fields[index];
+
+        if(static_cast<size_t>(field.offset) + field.size > length)
+            break;
+
+        const uint8_t* source = payload + field.offset;
+        const char* separator = (index == 0) ? "" : " ";
+        int written = 0;
+
+        switch(field.type)
+        {
+            case FieldType::U8:   written = std::snprintf(output + position, output_capacity - position, "%s%s=%" PRIu8, separator, field.name, detail::load<uint8_t>(source)); break;
+            case FieldType::U16:  written = std::snprintf(output + position, output_capacity - position, "%s%s=%" PRIu16, separator, field.name, detail::load<uint16_t>(source)); break;
+            case FieldType::U32:  written = std::snprintf(output + position, output_capacity - position, "%s%s=%" PRIu32, separator, field.name, detail::load<uint32_t>(source)); break;
+            case FieldType::U64:  written = std::snprintf(output + position, output_capacity - position, "%s%s=%" PRIu64, separator, field.name, detail::load<uint64_t>(source)); break;
+            case FieldType::I8:   written = std::snprintf(output + position, output_capacity - position, "%s%s=%" PRId8, separator, field.name, detail::load<int8_t>(source)); break;
+            case FieldType::I16:  written = std::snprintf(output + position, output_capacity - position, "%s%s=%" PRId16, separator, field.name, detail::load<int16_t>(source)); break;
+            case FieldType::I32:  written = std::snprintf(output + position, output_capacity - position, "%s%s=%" PRId32, separator, field.name, detail::load<int32_t>(source)); break;
+            case FieldType::I64:  written = std::snprintf(output + position, output_capacity - position, "%s%s=%" PRId64, separator, field.name, detail::load<int64_t>(source)); break;
+            case FieldType::F32:  written = std::snprintf(output + position, output_capacity - position, "%s%s=%g", separator, field.name, static_cast<double>(detail::load<float>(source))); break;
+            case FieldType::F64:  written = std::snprintf(output + position, output_capacity - position, "%s%s=%g", separator, field.name, detail::load<double>(source)); break;
+            case FieldType::BOOL: written = std::snprintf(output + position, output_capacity - position, "%s%s=%s", separator, field.name, (source[0] != 0) ? "true" : "false"); break;
+            default:              written = std::snprintf(output + position, output_capacity - position, "%s%s=?", separator, field.name); break;
+        }
+
+        if(written <= 0)
+            break;
+
+        // Truncated output ends the text
+        if(static_cast<size_t>(written) >= output_capacity - position)
+        {
+            position = output_capacity - 1u;
+            break;
+        }
+
+        position += static_cast<size_t>(written);
+    }
+
+    return position;
+}
+
+}
+}
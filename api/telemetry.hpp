@@ -0,0 +1,591 @@
+#pragma once
+
+/**
+ * @file telemetry.hpp
+ * @brief C++ API of the telemetry framework.
+ *
+ * telemetry::Telemetry owns the transport, the producer ring buffers and
+ * the agent. The constructor allocates and starts everything; each
+ * producer thread then emits through its own handle without locks, and the
+ * destructor flushes for a bounded time before it stops the agent.
+ *
+ *     telemetry::Config config;
+ *     config.transport.endpoint = "127.0.0.1:9000";
+ *     telemetry::Telemetry telemetry(std::make_unique<transport::UdpTransport>(), config);
+ *
+ *     telemetry.local().emit<TELEMETRY_LEVEL_INFO>(stats);
+ *
+ * Typed event schemas: an event type lists its fields once and gets a
+ * fixed layout encoder into telemetry_event_t.payload, a decoder and a
+ * field description for the receiver. Offsets and the payload size are
+ * compile time constants, so encoding is a fixed sequence of stores with
+ * no length checks.
+ *
+ *     struct LinkStats
+ *     {
+ *         uint32_t rx_packets;
+ *         uint16_t queue;
+ *         float load;
+ *
+ *         static constexpr uint32_t telemetry_event_id = 0x100;
+ *         static constexpr auto telemetry_fields = telemetry::schema::fields(
+ *             telemetry::schema::field("rx_packets", &LinkStats::rx_packets),
+ *             telemetry::schema::field("queue", &LinkStats::queue),
+ *             telemetry::schema::field("load", &LinkStats::load));
+ *     };
+ *
+ *     telemetry_event_t event;
+ *     telemetry::schema::make_event(event, stats, TELEMETRY_LEVEL_INFO);
+ *
+ * Payload layout: the fields back to back in declaration order, without
+ * padding, each little-endian (floating point as IEEE 754 bits).
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+extern "C" {
+    #include "../core/event.h"
+    #include "../core/ring_buffer.h"
+    #include "../core/span.h"
+    #include "../agent/telemetry_agent.h"
+}
+
+#include "telemetry_emit.h"
+#include "config.hpp"
+#include "../transport/transport.hpp"
+
+namespace telemetry {
+namespace schema {
+
+    // Wire type of a field
+    enum class FieldType : uint8_t
+    {
+        U8 = 1, U16, U32, U64,
+        I8, I16, I32, I64,
+        F32, F64,
+        BOOL
+    };
+
+    // Description of one field, what a receiver needs to read it
+    struct FieldInfo
+    {
+        const char* name;
+        FieldType type;
+        uint16_t offset;        // Byte offset in the payload
+        uint16_t size;          // Bytes on the wire
+    };
+
+    namespace detail {
+
+        // Wire type of a C++ type, only fixed size scalars are allowed
+        template <typename T>
+        constexpr FieldType field_type()
+        {
+            if constexpr(std::is_same_v<T, bool>)
+                return FieldType::BOOL;
+            else if constexpr(std::is_enum_v<T>)
+                return field_type<std::underlying_type_t<T>>();
+            else if constexpr(std::is_same_v<T, float>)
+                return FieldType::F32;
+            else if constexpr(std::is_same_v<T, double>)
+                return FieldType::F64;
+            else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>)
+                return (sizeof(T) == 1) ? FieldType::I8 : (sizeof(T) == 2) ? FieldType::I16 :
+                       (sizeof(T) == 4) ? FieldType::I32 : FieldType::I64;
+            else if constexpr(std::is_integral_v<T>)
+                return (sizeof(T) == 1) ? FieldType::U8 : (sizeof(T) == 2) ? FieldType::U16 :
+                       (sizeof(T) == 4) ? FieldType::U32 : FieldType::U64;
+            else
+                static_assert(sizeof(T) == 0, "schema fields must be integers, enums, bool, float or double");
+
+            return FieldType::U8;
+        }
+
+        // Unsigned integer with the same size as T
+        template <size_t Size> struct Bits;
+        template <> struct Bits<1> { using type = uint8_t; };
+        template <> struct Bits<2> { using type = uint16_t; };
+        template <> struct Bits<4> { using type = uint32_t; };
+        template <> struct Bits<8> { using type = uint64_t; };
+
+        // Stores a value little-endian, the loop has a constant count and unrolls
+        template <typename T>
+        inline void store(uint8_t* destination, const T& value)
+        {
+            typename Bits<sizeof(T)>::type bits;
+            std::memcpy(&bits, &value, sizeof(T));
+
+            for(size_t index = 0; index < sizeof(T); index++)
+            {
+                destination[index] = static_cast<uint8_t>(bits >> (8u * index));
+            }
+        }
+
+        // Loads a little-endian value
+        template <typename T>
+        inline T load(const uint8_t* source)
+        {
+            typename Bits<sizeof(T)>::type bits = 0;
+
+            for(size_t index = 0; index < sizeof(T); index++)
+            {
+                bits = static_cast<typename Bits<sizeof(T)>::type>(bits | (static_cast<typename Bits<sizeof(T)>::type>(source[index]) << (8u * index)));
+            }
+
+            if constexpr(std::is_same_v<T, bool>)
+            {
+                return (bits != 0);
+            }
+            else
+            {
+                T value;
+                std::memcpy(&value, &bits, sizeof(T));
+                return value;
+            }
+        }
+    }
+
+    // One field of an event type: its name and the member holding it
+    template <typename Owner, typename T>
+    struct Field
+    {
+        using owner_type = Owner;
+        using value_type = T;
+
+        static constexpr FieldType type = detail::field_type<T>();
+        static constexpr size_t size = sizeof(T);
+
+        const char* name;
+        T Owner::* member;
+    };
+
+    // Declares a field
+    template <typename Owner, typename T>
+    constexpr Field<Owner, T> field(const char* name, T Owner::* member)
+    {
+        return Field<Owner, T>{ name, member };
+    }
+
+    // Declares the field list of an event type, in wire order
+    template <typename... Fields>
+    constexpr std::tuple<Fields...> fields(Fields... list)
+    {
+        return std::tuple<Fields...>(list...);
+    }
+
+    // Number of fields of an event type
+    template <typename T>
+    constexpr size_t field_count = std::tuple_size_v<std::decay_t<decltype(T::telemetry_fields)>>;
+
+    namespace detail {
+
+        // Wire size of the fields before Index
+        template <typename T, size_t... Before>
+        constexpr size_t offset_of(std::index_sequence<Before...>)
+        {
+            return (size_t{0} + ... + std::tuple_element_t<Before, std::decay_t<decltype(T::telemetry_fields)>>::size);
+        }
+    }
+
+    // Byte offset of field Index
+    template <typename T, size_t Index>
+    constexpr size_t field_offset = detail::offset_of<T>(std::make_index_sequence<Index>{});
+
+    // Payload size of an event type
+    template <typename T>
+    constexpr size_t payload_size = field_offset<T, field_count<T>>;
+
+    namespace detail {
+
+        template <typename T, size_t... Index>
+        inline void encode_fields(const T& value, uint8_t* payload, std::index_sequence<Index...>)
+        {
+            (store(payload + field_offset<T, Index>, value.*(std::get<Index>(T::telemetry_fields).member)), ...);
+        }
+
+        template <typename T, size_t... Index>
+        inline void decode_fields(const uint8_t* payload, T& value, std::index_sequence<Index...>)
+        {
+            ((value.*(std::get<Index>(T::telemetry_fields).member) =
+                load<typename std::tuple_element_t<Index, std::decay_t<decltype(T::telemetry_fields)>>::value_type>(payload + field_offset<T, Index>)), ...);
+        }
+
+        template <typename T, size_t... Index>
+        constexpr std::array<FieldInfo, sizeof...(Index)> describe_fields(std::index_sequence<Index...>)
+        {
+            return {{ FieldInfo{ std::get<Index>(T::telemetry_fields).name,
+                                 std::tuple_element_t<Index, std::decay_t<decltype(T::telemetry_fields)>>::type,
+                                 static_cast<uint16_t>(field_offset<T, Index>),
+                                 static_cast<uint16_t>(std::tuple_element_t<Index, std::decay_t<decltype(T::telemetry_fields)>>::size) }... }};
+        }
+
+        template <typename T>
+        constexpr bool check_schema()
+        {
+            static_assert(payload_size<T> <= TELEMETRY_EVENT_PAYLOAD_MAX, "event schema does not fit TELEMETRY_EVENT_PAYLOAD_MAX");
+            static_assert(T::telemetry_event_id < TELEMETRY_EVENT_ID_RESERVED_BASE, "event id is in the framework reserved range");
+            return true;
+        }
+    }
+
+    // Writes the fields into a payload of at least payload_size<T> bytes
+    template <typename T>
+    inline void encode(const T& value, uint8_t* payload)
+    {
+        static_assert(detail::check_schema<T>());
+        detail::encode_fields(value, payload, std::make_index_sequence<field_count<T>>{});
+    }
+
+    // Receiver side : reads the fields, false if the payload size does not match the schema
+    template <typename T>
+    inline bool decode(const uint8_t* payload, size_t length, T& value)
+    {
+        if(payload == nullptr || length != payload_size<T>)
+            return false;
+
+        detail::decode_fields(payload, value, std::make_index_sequence<field_count<T>>{});
+        return true;
+    }
+
+    // Receiver side : decodes an event of this type, false for other event ids
+    template <typename T>
+    inline bool decode(const telemetry_event_t& event, T& value)
+    {
+        return (event.event_id == T::telemetry_event_id) && decode(event.payload, event.payload_size, value);
+    }
+
+    // Field names, types and offsets, e.g. for a receiver printing unknown payloads
+    template <typename T>
+    constexpr std::array<FieldInfo, field_count<T>> describe()
+    {
+        return detail::describe_fields<T>(std::make_index_sequence<field_count<T>>{});
+    }
+
+    // Fills an event of this type and stamps it with the clock chosen for its id and level
+    template <typename T>
+    inline void make_event(telemetry_event_t& event, const T& value, telemetry_level_t level)
+    {
+        event.event_id = T::telemetry_event_id;
+        event.level = static_cast<uint8_t>(level);
+        event.reserved = 0;
+        event.payload_size = static_cast<uint16_t>(payload_size<T>);
+
+        encode(value, event.payload);
+        telemetry_event_stamp(&event, telemetry_event_clock_for(T::telemetry_event_id, level));
+    }
+
+    // Emits a typed event through the level, id and sampling checks of telemetry_emit.h.
+    // Below TELEMETRY_MIN_LEVEL the call compiles to nothing; a disabled id costs one load.
+    template <telemetry_level_t Level, typename T>
+    inline bool emit(ring_buffer_t* ring, const T& value, telemetry_agent_t* agent = nullptr)
+    {
+        if constexpr(!TELEMETRY_LEVEL_COMPILED(Level))
+        {
+            (void)ring;
+            (void)value;
+            (void)agent;
+            return false;
+        }
+        else
+        {
+            if(!telemetry_emit_admitted(T::telemetry_event_id))
+                return false;
+
+            telemetry_event_t event;
+            make_event(event, value, Level);
+
+            if(!ring_buffer_push(ring, &event))
+                return false;
+
+            if(agent != nullptr)
+                telemetry_agent_notify(agent);
+
+            return true;
+        }
+    }
+
+    // Formats a payload as "name=value ..." using a description, returns the text length.
+    // Stops at the first field that lies outside the payload.
+    size_t format_fields(const FieldInfo* fields, size_t field_count, const uint8_t* payload, size_t length,
+                         char* output, size_t output_capacity);
+
+}
+
+    class Telemetry;
+
+    namespace detail {
+        struct LocalProducers;
+    }
+
+    // Emit handle of one producer thread, owns one ring buffer of a Telemetry while it lives.
+    // Not thread safe: a handle must only be used by one thread at a time.
+    class Producer
+    {
+    public:
+        Producer() = default;
+        ~Producer();
+
+        Producer(Producer&& other) noexcept;
+        Producer& operator=(Producer&& other) noexcept;
+        Producer(const Producer&) = delete;
+        Producer& operator=(const Producer&) = delete;
+
+        // false for a default constructed handle or when all rings were taken
+        bool valid() const { return ring_ != nullptr; }
+
+        // Ring buffer of this handle, e.g. for a telemetry::log::Logger
+        ring_buffer_t* ring() const { return ring_; }
+
+        // Agent to notify after a push
+        telemetry_agent_t* agent() const { return agent_; }
+
+        // Events this handle's ring dropped because it was full
+        uint64_t dropped() const { return (ring_ != nullptr) ? ring_buffer_dropped(ring_) : 0; }
+
+        // Builds and pushes an event through the checks of telemetry_emit.h, false if filtered, sampled out or full
+        bool emit(uint32_t event_id, const void* payload, size_t payload_size, telemetry_level_t level)
+        {
+            if(!TELEMETRY_LEVEL_COMPILED(level) || !telemetry_emit_admitted(event_id))
+                return false;
+
+            return telemetry_emit(ring_, agent_, event_id, payload, payload_size, level);
+        }
+
+        // Pushes a typed event, see telemetry::schema
+        template <telemetry_level_t Level, typename T>
+        bool emit(const T& value)
+        {
+            return (ring_ != nullptr) && schema::emit<Level>(ring_, value, agent_);
+        }
+
+        // Block of config.payload_block_size bytes for emitPayload, nullptr if there is no pool or it is empty
+        void* allocPayload() { return memory_pool_alloc(pool_); }
+
+        // Pushes an event whose payload is a block from allocPayload without copying it.
+        // The block is given up in every case: the agent returns it after the send, a
+        // filtered, sampled out or dropped event returns it right away. Transports with
+        // ITransport::maxMessageBytes(), such as UDP, get the payload as TELEMETRY_EVENT_FRAGMENT
+        // messages of that size; others get it whole through sendEvent().
+        bool emitPayload(uint32_t event_id, void* block, size_t payload_size, telemetry_level_t level)
+        {
+            if(ring_ == nullptr || !TELEMETRY_LEVEL_COMPILED(level) || !telemetry_emit_admitted(event_id))
+            {
+                memory_pool_release(pool_, block);
+                return false;
+            }
+
+            return telemetry_emit_pooled(ring_, agent_, event_id, pool_, block, payload_size, level);
+        }
+
+    private:
+        friend class Telemetry;
+        friend struct detail::LocalProducers;
+
+        Producer(Telemetry* owner, size_t slot, ring_buffer_t* ring, telemetry_agent_t* agent, memory_pool_t* pool)
+            : owner_(owner), slot_(slot), ring_(ring), agent_(agent), pool_(pool)
+        {
+        }
+
+        void release();
+        void detach();
+
+        Telemetry* owner_ = nullptr;
+        size_t slot_ = 0;
+        ring_buffer_t* ring_ = nullptr;
+        telemetry_agent_t* agent_ = nullptr;
+        memory_pool_t* pool_ = nullptr;
+    };
+
+    // Transport, producer rings and agent in one object
+    class Telemetry
+    {
+    public:
+        // Initializes the transport, allocates all rings and starts the agent; check started()
+        explicit Telemetry(std::unique_ptr<transport::ITransport> transport, const Config& config = Config());
+
+        // Flushes for at most config.flush_timeout_ns, stops the agent and frees the rings.
+        // Every Producer from producer() must be gone by now; local() handles are invalidated.
+        ~Telemetry();
+
+        Telemetry(const Telemetry&) = delete;
+        Telemetry& operator=(const Telemetry&) = delete;
+
+        // false if a step of the constructor failed, nothing is running then
+        bool started() const { return agent_ != nullptr; }
+
+        // Claims a free ring buffer, returns an invalid handle if all are taken
+        Producer producer();
+
+        // Handle of the calling thread, claimed on first use and released when the thread exits.
+        // The destructor invalidates the handles of all threads: an emit that happens after it
+        // returns false, an emit running concurrently with it is a bug.
+        Producer& local();
+
+        // Waits until the agent has emptied all rings, false on timeout
+        bool flush(uint64_t timeout_ns);
+
+        // Async-signal-safe emit into the reserved signal ring (config.agent.signal_ring_capacity),
+        // for signal and fault handlers on any thread. The filters are not applied.
+        bool emitFromSignal(uint32_t event_id, const void* payload, size_t payload_size, telemetry_level_t level) noexcept
+        {
+            return telemetry_agent_emit_signal_safe(agent_, event_id, payload, payload_size, level);
+        }
+
+        // Async-signal-safe synchronous send of the queued events, call last in a crash handler
+        size_t crashFlush() noexcept { return telemetry_agent_crash_flush(agent_); }
+
+        telemetry_agent_t* agent() const { return agent_; }
+        transport::ITransport* transport() const { return transport_.get(); }
+
+        // Pool of large payloads, nullptr unless config.payload_block_size and payload_block_count are set
+        memory_pool_t* payloadPool() const { return payload_pool_; }
+
+    private:
+        friend class Producer;
+
+        void release(size_t slot);
+        void shutdown();
+
+        Config config_;
+        std::unique_ptr<transport::ITransport> transport_;
+        bool transport_ready_ = false;
+        transport_c_t c_transport_{};
+        telemetry_agent_t* agent_ = nullptr;
+        std::vector<ring_buffer_t*> rings_;
+        std::unique_ptr<std::atomic<bool>[]> claimed_;
+        memory_pool_t* payload_pool_ = nullptr;
+        uint64_t instance_id_ = 0;      // Key of the thread local handles, never reused
+    };
+
+    // Measures the scope it lives in and pushes a span record through a producer when it ends.
+    // Spans of one thread nest; create and destroy a span on the same thread.
+    class Span
+    {
+    public:
+        Span(Producer& producer, uint32_t name_id, telemetry_level_t level = TELEMETRY_LEVEL_INFO)
+            : producer_(producer)
+        {
+            if(TELEMETRY_LEVEL_COMPILED(level) && producer.valid())
+                telemetry_span_begin(&span_, name_id, level);
+        }
+
+        // Continues a trace from another thread or process
+        Span(Producer& producer, uint32_t name_id, uint64_t trace_id, uint64_t parent_id,
+             telemetry_level_t level = TELEMETRY_LEVEL_INFO)
+            : producer_(producer)
+        {
+            if(TELEMETRY_LEVEL_COMPILED(level) && producer.valid())
+                telemetry_span_begin_with_parent(&span_, name_id, level, trace_id, parent_id);
+        }
+
+        ~Span()
+        {
+            end();
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        // Ends the span early, later calls do nothing
+        void end()
+        {
+            if(span_.active && telemetry_span_end(&span_, producer_.ring()) && producer_.agent() != nullptr)
+                telemetry_agent_notify(producer_.agent());
+        }
+
+        // false if the span is filtered out or already ended
+        bool active() const { return span_.active; }
+        uint64_t traceId() const { return span_.trace_id; }
+        uint64_t spanId() const { return span_.span_id; }
+
+    private:
+        Producer& producer_;
+        telemetry_span_t span_{};
+    };
+
+    // Ring buffer of Capacity events in its own storage, nothing is allocated.
+    // Declare it static or as a member; it must not move while in use.
+    template <size_t Capacity>
+    class StaticRing
+    {
+    public:
+        static_assert(Capacity > 0, "a ring needs at least one slot");
+
+        StaticRing() { (void)ring_buffer_init_static(&ring_, storage_, sizeof(storage_), Capacity); }
+        ~StaticRing() { ring_buffer_free(ring_); }
+
+        StaticRing(const StaticRing&) = delete;
+        StaticRing& operator=(const StaticRing&) = delete;
+
+        ring_buffer_t* get() const { return ring_; }
+
+    private:
+        alignas(TELEMETRY_STORAGE_ALIGN) uint8_t storage_[RING_BUFFER_STORAGE_BYTES(Capacity)];
+        ring_buffer_t* ring_ = nullptr;
+    };
+
+    // Agent in its own storage, sized for MaxMessageBytes protocol messages and a signal
+    // ring of SignalRingCapacity events; starting it allocates nothing but the thread stack.
+    template <size_t MaxMessageBytes = TELEMETRY_AGENT_DEFAULT_MAX_MESSAGE_BYTES,
+              size_t SignalRingCapacity = TELEMETRY_AGENT_DEFAULT_SIGNAL_RING_CAPACITY>
+    class StaticAgent
+    {
+    public:
+        static_assert((SignalRingCapacity & (SignalRingCapacity - 1u)) == 0, "the signal ring capacity must be 0 or a power of two");
+
+        StaticAgent() = default;
+        ~StaticAgent() { stop(); }
+
+        StaticAgent(const StaticAgent&) = delete;
+        StaticAgent& operator=(const StaticAgent&) = delete;
+
+        // Starts the agent on a ring; max_message_bytes and signal_ring_capacity of config
+        // are replaced by the template arguments. false if already running or on failure.
+        bool start(ring_buffer_t* ring, transport_c_t* transport, const telemetry_agent_config_t* config = nullptr)
+        {
+            if(agent_ != nullptr)
+                return false;
+
+            telemetry_agent_config_t settings;
+            if(config != nullptr)
+                settings = *config;
+            else
+                telemetry_agent_config_init(&settings);
+
+            settings.max_message_bytes = MaxMessageBytes;
+            settings.signal_ring_capacity = static_cast<uint32_t>(SignalRingCapacity);
+
+            if(!telemetry_agent_start_static(&agent_, storage_, sizeof(storage_), ring, transport, &settings))
+                agent_ = nullptr;
+
+            return agent_ != nullptr;
+        }
+
+        // Stops the agent, the storage can be started again afterwards
+        void stop()
+        {
+            if(agent_ != nullptr)
+                telemetry_agent_stop(agent_);
+
+            agent_ = nullptr;
+        }
+
+        telemetry_agent_t* get() const { return agent_; }
+
+    private:
+        alignas(TELEMETRY_STORAGE_ALIGN) uint8_t storage_[TELEMETRY_AGENT_STORAGE_BYTES(MaxMessageBytes, SignalRingCapacity)];
+        telemetry_agent_t* agent_ = nullptr;
+    };
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+/**
+ * @file telemetry_emit.h
+ * @brief Filtered event emission for C and C++.
+ *
+ * Three checks run before an event is built:
+ * - TELEMETRY_MIN_LEVEL, fixed at build time (CMake option of the same
+ *   name). Emits below it are constant false conditions and generate no
+ *   code; their arguments are never evaluated.
+ * - The runtime per event id bitmap of core/event_filter.h, one relaxed
+ *   load. A disabled id skips the payload expressions, the timestamp and
+ *   the push.
+ * - The sampling and rate limit policies of core/event_sampling.h, one more
+ *   relaxed load for ids without a policy. Suppressed events are counted.
+ *
+ *     TELEMETRY_EMIT_INFO(ring, agent, LINK_EVENT_ID, &stats, sizeof(stats));
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "../core/event.h"
+#include "../core/event_filter.h"
+#include "../core/event_sampling.h"
+#include "../core/ring_buffer.h"
+#include "../agent/telemetry_agent.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Lowest level that is compiled in, as a number : 0 DEBUG, 1 INFO, 2 WARNING, 3 ERROR
+#ifndef TELEMETRY_MIN_LEVEL
+    #define TELEMETRY_MIN_LEVEL 0
+#endif
+
+// Constant expression for a constant level, true if emits of that level are compiled in
+#define TELEMETRY_LEVEL_COMPILED(level) ((int)(level) >= TELEMETRY_MIN_LEVEL)
+
+/**
+ * @brief Builds an event and pushes it, without filtering.
+ *
+ * @param ring Ring buffer of the calling producer.
+ * @param agent Agent to notify after the push, may be NULL.
+ * @param event_id Event identifier.
+ * @param payload Payload bytes, may be NULL when payload_size is 0.
+ * @param payload_size Payload size, at most TELEMETRY_EVENT_PAYLOAD_MAX.
+ * @param level Event severity level.
+ * @return true if the event was pushed, false if it is invalid or the ring is full.
+ */
+static inline bool telemetry_emit(ring_buffer_t* ring, telemetry_agent_t* agent, uint32_t event_id,
+                                  const void* payload, size_t payload_size, telemetry_level_t level)
+{
+    telemetry_event_t event;
+
+    if(!telemetry_event_make(&event, event_id, payload, payload_size, level) || !ring_buffer_push(ring, &event))
+        return false;
+
+    if(agent != NULL)
+        telemetry_agent_notify(agent);
+
+    return true;
+}
+
+/**
+ * @brief Pushes an event whose payload is a memory pool block, without filtering.
+ *
+ * Ownership of the block always passes on: to the agent, which gives it
+ * back after the transport sent it, or back to the pool if the event is
+ * invalid or the ring is full. Events the agent never took are given back
+ * by ring_buffer_free, so free the ring before the pool.
+ *
+ * @param ring Ring buffer of the calling producer.
+ * @param agent Agent to notify after the push, may be NULL.
+ * @param event_id Event identifier.
+ * @param pool Pool the block was taken from.
+ * @param block Block holding the payload.
+ * @param payload_size Payload bytes in the block.
+ * @param level Event severity level.
+ * @return true if the event was pushed.
+ */
+static inline bool telemetry_emit_pooled(ring_buffer_t* ring, telemetry_agent_t* agent, uint32_t event_id,
+                                         memory_pool_t* pool, void* block, size_t payload_size, telemetry_level_t level)
+{
+    telemetry_event_t event;
+
+    if(!telemetry_event_make_pooled(&event, event_id, pool, block, payload_size, level) || !ring_buffer_push(ring, &event))
+    {
+        memory_pool_release(pool, block);
+        return false;
+    }
+
+    if(agent != NULL)
+        telemetry_agent_notify(agent);
+
+    return true;
+}
+
+// Runtime checks of an emit : the id is enabled and its sampling policy keeps the event
+static inline bool telemetry_emit_admitted(uint32_t event_id)
+{
+    return telemetry_event_filter_enabled(event_id) && telemetry_event_sampling_keep(event_id);
+}
+
+// Emits an event if its level is compiled in, its id is enabled and sampling keeps it.
+// The payload expressions are only evaluated for events that are emitted.
+#define TELEMETRY_EMIT(ring, agent, event_id, payload, payload_size, level)                     \
+    do                                                                                          \
+    {                                                                                           \
+        if(TELEMETRY_LEVEL_COMPILED(level) && telemetry_emit_admitted(event_id))                 \
+            (void)telemetry_emit((ring), (agent), (event_id), (payload), (payload_size), (level)); \
+    }                                                                                           \
+    while(0)
+
+#define TELEMETRY_EMIT_DEBUG(ring, agent, event_id, payload, payload_size) \
+    TELEMETRY_EMIT(ring, agent, event_id, payload, payload_size, TELEMETRY_LEVEL_DEBUG)
+#define TELEMETRY_EMIT_INFO(ring, agent, event_id, payload, payload_size) \
+    TELEMETRY_EMIT(ring, agent, event_id, payload, payload_size, TELEMETRY_LEVEL_INFO)
+#define TELEMETRY_EMIT_WARNING(ring, agent, event_id, payload, payload_size) \
+    TELEMETRY_EMIT(ring, agent, event_id, payload, payload_size, TELEMETRY_LEVEL_WARNING)
+#define TELEMETRY_EMIT_ERROR(ring, agent, event_id, payload, payload_size) \
+    TELEMETRY_EMIT(ring, agent, event_id, payload, payload_size, TELEMETRY_LEVEL_ERROR)
+
+
+#ifdef __cplusplus
+    }
+#endif
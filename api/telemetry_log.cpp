@@ -0,0 +1,221 @@
+/**
+ * @file telemetry_log.cpp
+ * @brief Format registry and logger of the deferred-format logging.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include "telemetry_log.hpp"
+
+#include <mutex>
+
+namespace telemetry {
+namespace log {
+
+namespace {
+
+    // Formats by id - 1, only grows
+    std::mutex registry_lock;
+    std::vector<Format>& registry()
+    {
+        static std::vector<Format> formats;
+        return formats;
+    }
+
+}
+
+/**
+ * @brief Registers a format string.
+ *
+ * @param text Format string, must stay valid for the life of the process.
+ * @param arg_types Packed type of each argument.
+ * @param arg_count Number of arguments.
+ * @return Format id, 0 on failure.
+ */
+uint32_t register_format(const char* text, const uint8_t* arg_types, size_t arg_count)
+{
+    if(text == nullptr || arg_count > TELEMETRY_LOG_MAX_ARGS || (arg_count > 0 && arg_types == nullptr))
+        return 0;
+
+    std::lock_guard<std::mutex> guard(registry_lock);
+    std::vector<Format>& formats = registry();
+
+    if(formats.size() >= TELEMETRY_LOG_MAX_FORMAT_ID)
+        return 0;
+
+    Format format;
+    format.text = text;
+    format.arg_count = static_cast<uint8_t>(arg_count);
+    if(arg_count > 0)
+        std::memcpy(format.arg_types, arg_types, arg_count);
+
+    formats.push_back(format);
+
+    return static_cast<uint32_t>(formats.size());
+}
+
+/**
+ * @brief Looks up a registered format.
+ *
+ * @param format_id Format id.
+ * @param format Receives a copy of the format.
+ * @return true if the id is registered.
+ */
+bool find_format(uint32_t format_id, Format& format)
+{
+    std::lock_guard<std::mutex> guard(registry_lock);
+    const std::vector<Format>& formats = registry();
+
+    if(format_id == 0 || format_id > formats.size())
+        return false;
+
+    format = formats[format_id - 1u];
+    return true;
+}
+
+/**
+ * @brief Returns the number of registered formats.
+ *
+ * @return Highest format id.
+ */
+uint32_t format_count()
+{
+    std::lock_guard<std::mutex> guard(registry_lock);
+    return static_cast<uint32_t>(registry().size());
+}
+
+/**
+ * @brief Creates a logger for one ring buffer.
+ *
+ * @param ring Ring buffer to push log events into.
+ * @param agent Agent to notify after each push, may be NULL.
+ */
+Logger::Logger(ring_buffer_t* ring, telemetry_agent_t* agent)
+    : ring_(ring), agent_(agent)
+{
+}
+
+/**
+ * @brief Registers the format of a call site.
+ *
+ * Two threads reaching a new site together may both register; the first
+ * stored id wins and the other entry stays unused.
+ *
+ * @param site Call site state.
+ * @param format Format string.
+ * @param arg_types Packed argument types.
+ * @param arg_count Number of arguments.
+ * @return Format id, 0 on failure.
+ */
+uint32_t Logger::resolve(Site& site, const char* format, const uint8_t* arg_types, size_t arg_count)
+{
+    uint32_t format_id = register_format(format, arg_types, arg_count);
+    uint32_t expected = 0;
+
+    if(format_id == 0)
+        return 0;
+
+    if(!site.format_id.compare_exchange_strong(expected, format_id, std::memory_order_acq_rel))
+        return expected;
+
+    return format_id;
+}
+
+/**
+ * @brief Pushes the dictionary events of one format.
+ *
+ * The format is marked as shipped only when all of its chunks were
+ * pushed; otherwise the next log line of the format tries again.
+ *
+ * @param format_id Format to ship.
+ * @return true if all chunks were pushed.
+ */
+bool Logger::shipFormat(uint32_t format_id)
+{
+    Format format;
+
+    if(!find_format(format_id, format))
+        return false;
+
+    const size_t format_length = std::strlen(format.text);
+    size_t offset = 0;
+
+    // An empty format still needs one entry
+    do
+    {
+        telemetry_log_dictionary_t entry;
+        entry.format_id = format_id;
+        entry.format_length = static_cast<uint32_t>(format_length);
+        entry.offset = static_cast<uint32_t>(offset);
+        entry.arg_count = format.arg_count;
+        std::memcpy(entry.arg_types, format.arg_types, sizeof(entry.arg_types));
+        entry.chunk = format.text + offset;
+        entry.chunk_length = format_length - offset;
+
+        telemetry_event_t event;
+        size_t chunk_written = 0;
+
+        const size_t length = telemetry_log_dictionary_encode(event.payload, TELEMETRY_EVENT_PAYLOAD_MAX, &entry, &chunk_written);
+        if(length == 0)
+            return false;
+
+        event.event_id = TELEMETRY_LOG_DICTIONARY_EVENT_ID;
+        event.level = TELEMETRY_LEVEL_INFO;
+        event.reserved = 0;
+        event.payload_size = static_cast<uint16_t>(length);
+        telemetry_event_stamp(&event, TELEMETRY_CLOCK_PRECISE);
+
+        if(!push(event))
+            return false;
+
+        offset += chunk_written;
+    }
+    while(offset < format_length);
+
+    if(format_id >= shipped_.size())
+        shipped_.resize(format_id + 1u, false);
+
+    shipped_[format_id] = true;
+    return true;
+}
+
+/**
+ * @brief Ships all registered formats again.
+ *
+ * @return true if every format was pushed.
+ */
+bool Logger::publishDictionary()
+{
+    const uint32_t count = format_count();
+    bool all_pushed = true;
+
+    for(uint32_t format_id = 1; format_id <= count; format_id++)
+    {
+        if(!shipFormat(format_id))
+            all_pushed = false;
+    }
+
+    return all_pushed;
+}
+
+/**
+ * @brief Pushes an event and notifies the agent.
+ *
+ * @param event Event to push.
+ * @return false if the ring buffer is full.
+ */
+bool Logger::push(telemetry_event_t& event)
+{
+    if(ring_ == nullptr || !ring_buffer_push(ring_, &event))
+    {
+        return false;
+    }
+
+    if(agent_ != nullptr)
+        telemetry_agent_notify(agent_);
+
+    return true;
+}
+
+}
+}
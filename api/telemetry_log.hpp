@@ -0,0 +1,229 @@
+#pragma once
+
+/**
+ * @file telemetry_log.hpp
+ * @brief Deferred-format logging front end.
+ *
+ * printf style logging that never formats on the device. Each call site
+ * registers its format string once, on first use, and gets a format id.
+ * A log call then packs only the id and the binary arguments into one
+ * telemetry event. The format strings are shipped once per logger as
+ * dictionary events, and tools/log_reconstruct turns the stream back into
+ * text offline. See core/log_record.h for the encoding.
+ *
+ *     telemetry::log::Logger logger(ring, agent);
+ *     TELEMETRY_LOG(logger, TELEMETRY_LEVEL_INFO, "rx queue %u depth %d", queue, depth);
+ *
+ * A logger pushes into one ring buffer, so it must only be used by that
+ * ring's producer thread.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+extern "C" {
+    #include "../core/event.h"
+    #include "../core/log_record.h"
+    #include "../core/ring_buffer.h"
+    #include "../agent/telemetry_agent.h"
+}
+
+#include "telemetry_emit.h"
+
+namespace telemetry {
+namespace log {
+
+    // Per call site state, constant initialized so the first check costs one load
+    struct Site
+    {
+        std::atomic<uint32_t> format_id{0};     // 0 until the format is registered
+    };
+
+    // Registered format, the string must outlive the process (normally a literal)
+    struct Format
+    {
+        const char* text = nullptr;
+        uint8_t arg_count = 0;
+        uint8_t arg_types[TELEMETRY_LOG_MAX_ARGS] = {};
+    };
+
+    // Registers a format, returns its id or 0 if the table is full or there are too many arguments.
+    // Thread safe; called by the first log call of each site.
+    uint32_t register_format(const char* text, const uint8_t* arg_types, size_t arg_count);
+
+    // Copies a registered format, returns false for an unknown id
+    bool find_format(uint32_t format_id, Format& format);
+
+    // Number of registered formats, ids run from 1 to this value
+    uint32_t format_count();
+
+    namespace detail {
+
+        // Packed type of an argument type
+        template <typename T>
+        constexpr uint8_t arg_type()
+        {
+            using Arg = std::decay_t<T>;
+
+            if constexpr(std::is_same_v<Arg, bool>)
+                return TELEMETRY_LOG_ARG_UNSIGNED;
+            else if constexpr(std::is_enum_v<Arg>)
+                return arg_type<std::underlying_type_t<Arg>>();
+            else if constexpr(std::is_integral_v<Arg> && std::is_signed_v<Arg>)
+                return TELEMETRY_LOG_ARG_SIGNED;
+            else if constexpr(std::is_integral_v<Arg>)
+                return TELEMETRY_LOG_ARG_UNSIGNED;
+            else if constexpr(std::is_same_v<Arg, float>)
+                return TELEMETRY_LOG_ARG_FLOAT;
+            else if constexpr(std::is_floating_point_v<Arg>)
+                return TELEMETRY_LOG_ARG_DOUBLE;
+            else if constexpr(std::is_same_v<Arg, const char*> || std::is_same_v<Arg, char*> ||
+                              std::is_same_v<Arg, std::string_view> || std::is_same_v<Arg, std::string>)
+                return TELEMETRY_LOG_ARG_STRING;
+            else if constexpr(std::is_pointer_v<Arg> || std::is_null_pointer_v<Arg>)
+                return TELEMETRY_LOG_ARG_POINTER;
+            else
+                static_assert(sizeof(Arg) == 0, "unsupported log argument type");
+
+            return 0;
+        }
+
+        // Packs one argument at payload + length, returns false if it does not fit
+        template <typename T>
+        bool pack(uint8_t* payload, size_t& length, const T& value)
+        {
+            constexpr uint8_t type = arg_type<T>();
+            const size_t capacity = TELEMETRY_EVENT_PAYLOAD_MAX - length;
+            size_t written = 0;
+
+            if constexpr(type == TELEMETRY_LOG_ARG_STRING)
+            {
+                std::string_view text;
+
+                // String literals arrive as arrays and are never NULL
+                if constexpr(std::is_pointer_v<T>)
+                    text = (value != nullptr) ? std::string_view(value) : std::string_view();
+                else
+                    text = std::string_view(value);
+
+                written = telemetry_log_put_string(payload + length, capacity, text.data(), text.size());
+            }
+            else if constexpr(type == TELEMETRY_LOG_ARG_POINTER)
+                written = telemetry_log_put_unsigned(payload + length, capacity, reinterpret_cast<uintptr_t>(value));
+            else if constexpr(type == TELEMETRY_LOG_ARG_FLOAT)
+                written = telemetry_log_put_float(payload + length, capacity, value);
+            else if constexpr(type == TELEMETRY_LOG_ARG_DOUBLE)
+                written = telemetry_log_put_double(payload + length, capacity, static_cast<double>(value));
+            else if constexpr(type == TELEMETRY_LOG_ARG_SIGNED)
+                written = telemetry_log_put_signed(payload + length, capacity, static_cast<int64_t>(value));
+            else
+                written = telemetry_log_put_unsigned(payload + length, capacity, static_cast<uint64_t>(value));
+
+            length += written;
+            return (written != 0);
+        }
+    }
+
+    class Logger
+    {
+        public:
+            // agent is notified after each push, may be NULL
+            Logger(ring_buffer_t* ring, telemetry_agent_t* agent = nullptr);
+
+            Logger(const Logger&) = delete;
+            Logger& operator=(const Logger&) = delete;
+
+            // Logs one line, use TELEMETRY_LOG rather than calling this directly.
+            // Returns false and counts the line in dropped() if the event or its dictionary entry could not be pushed.
+            template <typename... Args>
+            bool write(Site& site, telemetry_level_t level, const char* format, const Args&... args);
+
+            // Ships every registered format again, e.g. after the receiver restarted
+            bool publishDictionary();
+
+            // Log lines lost because the ring buffer was full or the line did not fit
+            uint64_t dropped() const { return dropped_; }
+
+        private:
+            // Registers the site's format on its first call
+            uint32_t resolve(Site& site, const char* format, const uint8_t* arg_types, size_t arg_count);
+            // Pushes the dictionary events of one format
+            bool shipFormat(uint32_t format_id);
+            // Pushes an event and wakes the agent
+            bool push(telemetry_event_t& event);
+
+        private:
+            ring_buffer_t* ring_;
+            telemetry_agent_t* agent_;
+            std::vector<bool> shipped_;         // Formats already sent through this logger, by id
+            uint64_t dropped_ = 0;
+    };
+
+    template <typename... Args>
+    bool Logger::write(Site& site, telemetry_level_t level, const char* format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= TELEMETRY_LOG_MAX_ARGS, "too many log arguments");
+
+        uint32_t format_id = site.format_id.load(std::memory_order_acquire);
+
+        if(format_id == 0)
+        {
+            // Trailing 0 keeps the array valid without arguments
+            static constexpr uint8_t arg_types[] = { detail::arg_type<Args>()..., 0 };
+            format_id = resolve(site, format, arg_types, sizeof...(Args));
+        }
+
+        // The dictionary entry goes out before the first line that uses it
+        if(format_id == 0 || ((format_id >= shipped_.size() || !shipped_[format_id]) && !shipFormat(format_id)))
+        {
+            dropped_++;
+            return false;
+        }
+
+        telemetry_event_t event;
+        event.event_id = telemetry_log_event_id(format_id);
+        event.level = static_cast<uint8_t>(level);
+        event.reserved = 0;
+
+        size_t length = 0;
+        if(!(detail::pack(event.payload, length, args) && ...))
+        {
+            dropped_++;
+            return false;
+        }
+
+        event.payload_size = static_cast<uint16_t>(length);
+        telemetry_event_stamp(&event, telemetry_event_clock_for(event.event_id, level));
+
+        if(!push(event))
+        {
+            dropped_++;
+            return false;
+        }
+
+        return true;
+    }
+
+}
+}
+
+// Logs a printf style line without formatting it, the format must be a string literal.
+// Lines below TELEMETRY_MIN_LEVEL generate no code when the level is a constant.
+#define TELEMETRY_LOG(logger, level, ...)                                           \
+    do                                                                              \
+    {                                                                               \
+        if(TELEMETRY_LEVEL_COMPILED(level))                                         \
+        {                                                                           \
+            static ::telemetry::log::Site telemetry_log_site_;                      \
+            (logger).write(telemetry_log_site_, (level), __VA_ARGS__);              \
+        }                                                                           \
+    }                                                                               \
+    while(0)
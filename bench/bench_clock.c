@@ -0,0 +1,117 @@
+/**
+ * @file bench_clock.c
+ * @brief Timestamp cost benchmark.
+ *
+ * Compares clock_gettime(CLOCK_MONOTONIC), the OSAL monotonic time, the raw
+ * tick read, the coarse clock and telemetry_event_make() with the precise,
+ * the raw tick and the coarse clock, the bulk tick conversion done by the agent, and reports the
+ * calibration error of the OSAL clock against CLOCK_MONOTONIC.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "event.h"
+#include "osal_time.h"
+
+#define BENCH_CALLS 10000000ull
+#define BENCH_BULK_BATCH 16u
+
+// Sink so the compiler keeps every call
+static volatile uint64_t sink;
+
+static uint64_t read_clock_gettime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t make_event(void)
+{
+    static telemetry_event_t event;
+    telemetry_event_make(&event, 1, NULL, 0, TELEMETRY_LEVEL_INFO);
+    return event.timestamp;
+}
+
+static uint64_t make_event_ticks(void)
+{
+    static telemetry_event_t event;
+    telemetry_event_make(&event, 1, NULL, 0, TELEMETRY_LEVEL_DEBUG);
+    return event.timestamp;
+}
+
+static uint64_t make_event_coarse(void)
+{
+    static telemetry_event_t event;
+    telemetry_event_make(&event, 2, NULL, 0, TELEMETRY_LEVEL_INFO);
+    return event.timestamp;
+}
+
+// One element of an agent sized batch, the cost is per converted value
+static uint64_t convert_bulk(void)
+{
+    static uint64_t values[BENCH_BULK_BATCH];
+    static unsigned position;
+
+    if(position == 0)
+    {
+        osal_time_ticks_to_ns_bulk(values, BENCH_BULK_BATCH);
+    }
+
+    position = (position + 1u) % BENCH_BULK_BATCH;
+    return values[position];
+}
+
+/**
+ * @brief Measures the average cost of one call.
+ *
+ * @param read Function to call.
+ * @return Nanoseconds per call.
+ */
+static double run(uint64_t (*read)(void))
+{
+    const uint64_t start_ns = read_clock_gettime();
+
+    for(uint64_t index = 0; index < BENCH_CALLS; index++)
+    {
+        sink = read();
+    }
+
+    return (double)(read_clock_gettime() - start_ns) / (double)BENCH_CALLS;
+}
+
+int main(void)
+{
+    const osal_clock_source_t source = osal_time_init();
+
+    printf("clock source      : %s\n", (source == OSAL_CLOCK_SOURCE_TSC) ? "cpu counter" : "clock_gettime");
+    printf("ticks per second  : %llu\n", (unsigned long long)osal_time_ticks_per_second());
+
+    printf("%-28s %10s\n", "call", "ns/call");
+    printf("%-28s %10.2f\n", "clock_gettime(MONOTONIC)", run(read_clock_gettime));
+    printf("%-28s %10.2f\n", "osal_telemetry_now_ticks", run(osal_telemetry_now_ticks));
+    printf("%-28s %10.2f\n", "osal_telemetry_now_monotonic", run(osal_telemetry_now_monotonic_ns));
+    printf("%-28s %10.2f\n", "telemetry_event_make", run(make_event));
+
+    telemetry_event_set_level_clock(TELEMETRY_LEVEL_DEBUG, TELEMETRY_CLOCK_TICKS);
+    printf("%-28s %10.2f\n", "telemetry_event_make (ticks)", run(make_event_ticks));
+    printf("%-28s %10.2f\n", "ticks_to_ns_bulk per value", run(convert_bulk));
+
+    printf("%-28s %10.2f\n", "coarse (MONOTONIC_COARSE)", run(osal_telemetry_now_coarse_ns));
+    osal_time_coarse_start(0);
+    telemetry_event_set_id_clock(2, TELEMETRY_CLOCK_COARSE);
+    printf("%-28s %10.2f\n", "coarse (service)", run(osal_telemetry_now_coarse_ns));
+    printf("%-28s %10.2f\n", "telemetry_event_make (coarse)", run(make_event_coarse));
+    osal_time_coarse_stop();
+
+    // Error after a resync, the benchmark above took long enough to measure the rate
+    osal_time_resync();
+    const int64_t error_ns = (int64_t)(osal_telemetry_now_monotonic_ns() - read_clock_gettime());
+    printf("offset to CLOCK_MONOTONIC : %lld ns\n", (long long)error_ns);
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file bench_filter.c
+ * @brief Cost of filtered emits.
+ *
+ * Measures an emit whose level is below the build time minimum, an emit
+ * whose id is disabled in the runtime bitmap, and an enabled emit, each
+ * with a payload that takes some work to build. The first two must cost
+ * about as much as the empty loop and never build the payload.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+// As a release build configured with -DTELEMETRY_MIN_LEVEL=INFO
+#undef TELEMETRY_MIN_LEVEL
+#define TELEMETRY_MIN_LEVEL 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "telemetry_emit.h"
+
+#define BENCH_CALLS 10000000ull
+#define BENCH_EVENT_ID_ENABLED  10u
+#define BENCH_EVENT_ID_DISABLED 11u
+
+// Sink so the compiler keeps every loop
+static volatile uint64_t sink;
+static ring_buffer_t* ring;
+static uint64_t payload_builds;
+static uint8_t payload[64];
+
+static uint64_t read_clock_gettime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+// Payload work an application would do, kept out of line so it is not folded away
+__attribute__((noinline)) static const void* build_payload(uint64_t value)
+{
+    payload_builds++;
+    for(size_t index = 0; index < sizeof(payload); index++)
+    {
+        payload[index] = (uint8_t)(value >> (index % 8u));
+    }
+    return payload;
+}
+
+static void empty_loop(uint64_t index)
+{
+    sink = index;
+}
+
+static void emit_compiled_out(uint64_t index)
+{
+    TELEMETRY_EMIT_DEBUG(ring, NULL, BENCH_EVENT_ID_ENABLED, build_payload(index), sizeof(payload));
+    sink = index;
+}
+
+static void emit_disabled_id(uint64_t index)
+{
+    TELEMETRY_EMIT_INFO(ring, NULL, BENCH_EVENT_ID_DISABLED, build_payload(index), sizeof(payload));
+    sink = index;
+}
+
+static void emit_enabled(uint64_t index)
+{
+    static telemetry_event_t event;
+
+    TELEMETRY_EMIT_INFO(ring, NULL, BENCH_EVENT_ID_ENABLED, build_payload(index), sizeof(payload));
+    // Keep the ring from filling, the consumer side is part of the measured cost
+    ring_buffer_pop(ring, &event);
+    sink = index;
+}
+
+/**
+ * @brief Measures the average cost of one call.
+ *
+ * @param call Function to call.
+ * @return Nanoseconds per call.
+ */
+static double run(void (*call)(uint64_t))
+{
+    const uint64_t start_ns = read_clock_gettime();
+
+    for(uint64_t index = 0; index < BENCH_CALLS; index++)
+    {
+        call(index);
+    }
+
+    return (double)(read_clock_gettime() - start_ns) / (double)BENCH_CALLS;
+}
+
+/**
+ * @brief Runs one row and prints its cost and the payloads it built.
+ */
+static void report(const char* name, void (*call)(uint64_t))
+{
+    payload_builds = 0;
+    const double ns_per_call = run(call);
+    printf("%-28s %10.2f %14llu\n", name, ns_per_call, (unsigned long long)payload_builds);
+}
+
+int main(void)
+{
+    if(!ring_buffer_init(&ring, 1024))
+    {
+        fprintf(stderr, "ring buffer allocation failed\n");
+        return 1;
+    }
+
+    telemetry_event_filter_set(BENCH_EVENT_ID_DISABLED, false);
+
+    printf("%-28s %10s %14s\n", "emit", "ns/call", "payload builds");
+    report("empty loop", empty_loop);
+    report("below TELEMETRY_MIN_LEVEL", emit_compiled_out);
+    report("disabled event id", emit_disabled_id);
+    report("enabled (push and pop)", emit_enabled);
+
+    ring_buffer_free(ring);
+    return 0;
+}
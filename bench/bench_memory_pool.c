@@ -0,0 +1,171 @@
+/**
+ * @file bench_memory_pool.c
+ * @brief Memory pool versus malloc benchmark.
+ *
+ * Every thread takes a few blocks and gives them back in a loop, the way
+ * producers hand payload blocks to the agent. The malloc variant uses
+ * malloc and free, the pool variant memory_pool_alloc and
+ * memory_pool_release. Prints alloc/release pairs per second per thread count.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory_pool.h"
+#include "osal_thread.h"
+#include "osal_time.h"
+
+#define BENCH_ROUNDS_PER_THREAD 1000000ull
+#define BENCH_HELD_BLOCKS 4u
+#define BENCH_BLOCK_SIZE 256u
+#define BENCH_MAX_THREADS 8u
+
+static memory_pool_t* pool;
+
+static atomic_bool start_flag;
+static atomic_uint ready_threads;
+
+/**
+ * @brief Waits until all benchmark threads are created.
+ */
+static void wait_for_start(void)
+{
+    atomic_fetch_add_explicit(&ready_threads, 1, memory_order_relaxed);
+
+    while(!atomic_load_explicit(&start_flag, memory_order_acquire))
+    {
+    }
+}
+
+static void* malloc_worker(void* arg)
+{
+    void* held[BENCH_HELD_BLOCKS];
+
+    (void)arg;
+    wait_for_start();
+
+    for(uint64_t round = 0; round < BENCH_ROUNDS_PER_THREAD; round++)
+    {
+        for(unsigned index = 0; index < BENCH_HELD_BLOCKS; index++)
+        {
+            held[index] = malloc(BENCH_BLOCK_SIZE);
+            // Touch the block so the allocation is not optimized away
+            memset(held[index], (int)index, 8);
+        }
+
+        for(unsigned index = 0; index < BENCH_HELD_BLOCKS; index++)
+        {
+            free(held[index]);
+        }
+    }
+
+    return NULL;
+}
+
+static void* pool_worker(void* arg)
+{
+    void* held[BENCH_HELD_BLOCKS];
+
+    (void)arg;
+    wait_for_start();
+
+    for(uint64_t round = 0; round < BENCH_ROUNDS_PER_THREAD; round++)
+    {
+        for(unsigned index = 0; index < BENCH_HELD_BLOCKS; index++)
+        {
+            held[index] = memory_pool_alloc(pool);
+            if(held[index] == NULL)
+            {
+                fprintf(stderr, "pool exhausted\n");
+                exit(1);
+            }
+            memset(held[index], (int)index, 8);
+        }
+
+        for(unsigned index = 0; index < BENCH_HELD_BLOCKS; index++)
+        {
+            memory_pool_release(pool, held[index]);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Runs one variant with the given number of threads.
+ *
+ * @param worker Thread entry for the variant.
+ * @param threads Number of threads.
+ * @return Alloc/release pairs per second over all threads.
+ */
+static double run(osal_thread_fn_t worker, unsigned threads)
+{
+    osal_thread_t* handles[BENCH_MAX_THREADS];
+
+    atomic_store(&start_flag, false);
+    atomic_store(&ready_threads, 0);
+
+    for(unsigned index = 0; index < threads; index++)
+    {
+        if(osal_thread_create(&handles[index], worker, NULL, "bench") != 0)
+        {
+            fprintf(stderr, "thread creation failed\n");
+            exit(1);
+        }
+    }
+
+    while(atomic_load(&ready_threads) != threads)
+    {
+    }
+
+    const uint64_t start_ns = osal_telemetry_now_monotonic_ns();
+    atomic_store_explicit(&start_flag, true, memory_order_release);
+
+    for(unsigned index = 0; index < threads; index++)
+    {
+        osal_thread_join(handles[index]);
+        osal_thread_destroy(handles[index]);
+    }
+
+    const uint64_t elapsed_ns = osal_telemetry_now_monotonic_ns() - start_ns;
+
+    return (double)(BENCH_ROUNDS_PER_THREAD * BENCH_HELD_BLOCKS * threads) * 1e9 / (double)elapsed_ns;
+}
+
+int main(void)
+{
+    // Large enough for full size magazines
+    if(!memory_pool_init(&pool, BENCH_BLOCK_SIZE, 2u * MEMORY_POOL_MAGAZINES * MEMORY_POOL_MAGAZINE_SIZE))
+    {
+        return 1;
+    }
+
+    printf("%-8s %20s %20s %8s\n", "threads", "malloc pairs/s", "pool pairs/s", "speedup");
+
+    for(unsigned threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2)
+    {
+        const double malloc_rate = run(malloc_worker, threads);
+        const double pool_rate = run(pool_worker, threads);
+
+        printf("%-8u %20.0f %20.0f %7.2fx\n", threads, malloc_rate, pool_rate, pool_rate / malloc_rate);
+    }
+
+    memory_pool_stats_t stats;
+    memory_pool_stats(pool, &stats);
+
+    if(stats.in_use != 0 || stats.failures != 0)
+    {
+        fprintf(stderr, "memory pool lost blocks\n");
+        return 1;
+    }
+
+    printf("pool high water %zu of %zu blocks\n", stats.high_water, stats.block_count);
+
+    memory_pool_free(pool);
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file bench_ring_alloc.c
+ * @brief First burst latency of rings with different slot allocations.
+ *
+ * A fresh ring is filled once; with calloc slots every new page costs a
+ * fault inside the burst. The same burst is repeated on the now warm ring
+ * as the baseline. Prints the average push time of the first and the warm
+ * burst, the slowest 64-push chunk of the first burst and the options that
+ * took effect.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ring_buffer.h"
+#include "osal_memory.h"
+#include "osal_time.h"
+
+#define BENCH_RING_CAPACITY 65536u
+#define BENCH_CHUNK 64u
+#define BENCH_REPEATS 5u
+
+typedef struct bench_variant_s {
+    const char* name;
+    uint32_t memory_flags;
+} bench_variant_t;
+
+typedef struct bench_result_s {
+    double first_ns;            // Average push of the first burst
+    double warm_ns;             // Average push of a burst on the warm ring
+    double worst_chunk_ns;      // Slowest chunk of the first burst, per push
+    uint32_t applied;
+} bench_result_t;
+
+/**
+ * @brief Fills the ring once and times it.
+ *
+ * @param ring Ring to fill, emptied afterwards.
+ * @param worst_chunk_ns Receives the slowest chunk per push, may be NULL.
+ * @return Average push time in nanoseconds.
+ */
+static double fill_ring(ring_buffer_t* ring, double* worst_chunk_ns)
+{
+    telemetry_event_t event;
+    double worst = 0.0;
+
+    memset(&event, 0, sizeof(event));
+    event.event_id = 1;
+    event.payload_size = 64;
+
+    const uint64_t start_ns = osal_telemetry_now_monotonic_ns();
+    uint64_t chunk_start_ns = start_ns;
+
+    for(uint32_t index = 1; index <= BENCH_RING_CAPACITY; index++)
+    {
+        (void)ring_buffer_push(ring, &event);
+
+        if(index % BENCH_CHUNK == 0)
+        {
+            const uint64_t now_ns = osal_telemetry_now_monotonic_ns();
+            const double chunk = (double)(now_ns - chunk_start_ns) / BENCH_CHUNK;
+
+            if(chunk > worst)
+                worst = chunk;
+
+            chunk_start_ns = now_ns;
+        }
+    }
+
+    const uint64_t elapsed_ns = osal_telemetry_now_monotonic_ns() - start_ns;
+
+    while(ring_buffer_pop(ring, &event))
+    {
+    }
+
+    if(worst_chunk_ns != NULL)
+        *worst_chunk_ns = worst;
+
+    return (double)elapsed_ns / BENCH_RING_CAPACITY;
+}
+
+/**
+ * @brief Runs one allocation variant, keeping the best of the repeats.
+ *
+ * @param variant Allocation options.
+ * @param out_result Receives the timings.
+ * @return true on success, false if the ring could not be created.
+ */
+static bool run_variant(const bench_variant_t* variant, bench_result_t* out_result)
+{
+    ring_buffer_options_t options;
+
+    ring_buffer_options_init(&options);
+    options.memory_flags = variant->memory_flags;
+
+    memset(out_result, 0, sizeof(*out_result));
+
+    for(unsigned repeat = 0; repeat < BENCH_REPEATS; repeat++)
+    {
+        ring_buffer_t* ring;
+        double worst = 0.0;
+
+        if(!ring_buffer_init_ex(&ring, BENCH_RING_CAPACITY, &options))
+            return false;
+
+        const double first = fill_ring(ring, &worst);
+        const double warm = fill_ring(ring, NULL);
+
+        if(repeat == 0 || first < out_result->first_ns)
+        {
+            out_result->first_ns = first;
+            out_result->worst_chunk_ns = worst;
+        }
+
+        if(repeat == 0 || warm < out_result->warm_ns)
+            out_result->warm_ns = warm;
+
+        out_result->applied = ring_buffer_memory_flags(ring);
+
+        ring_buffer_free(ring);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Prints the options of a mapping.
+ *
+ * @param applied OSAL_MEMORY_* bits.
+ */
+static void print_applied(uint32_t applied)
+{
+    if(applied == 0)
+        printf(" -");
+    if((applied & OSAL_MEMORY_HUGE_PAGES) != 0)
+        printf(" hugetlb");
+    if((applied & OSAL_MEMORY_TRANSPARENT_HUGE_PAGES) != 0)
+        printf(" thp");
+    if((applied & OSAL_MEMORY_PREFAULT) != 0)
+        printf(" prefault");
+    if((applied & OSAL_MEMORY_LOCK) != 0)
+        printf(" mlock");
+    if((applied & OSAL_MEMORY_NUMA_BIND) != 0)
+        printf(" numa");
+    printf("\n");
+}
+
+int main(void)
+{
+    static const bench_variant_t variants[] = {
+        { "calloc", 0 },
+        { "prefault", OSAL_MEMORY_PREFAULT },
+        { "huge", OSAL_MEMORY_HUGE_PAGES },
+        { "huge+prefault", OSAL_MEMORY_HUGE_PAGES | OSAL_MEMORY_PREFAULT },
+        { "all", OSAL_MEMORY_HUGE_PAGES | OSAL_MEMORY_PREFAULT | OSAL_MEMORY_LOCK | OSAL_MEMORY_NUMA_BIND },
+    };
+
+    // A fixed threshold keeps glibc from serving later callocs from already touched heap pages
+    (void)mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+
+    osal_time_init();
+
+    printf("ring of %u events, %zu bytes of slots, best of %u\n",
+           BENCH_RING_CAPACITY, (size_t)(BENCH_RING_CAPACITY + 1u) * sizeof(telemetry_event_t), BENCH_REPEATS);
+    printf("%-14s %14s %14s %18s  %s\n", "slots", "first ns/push", "warm ns/push", "worst chunk ns", "applied");
+
+    for(size_t index = 0; index < sizeof(variants) / sizeof(variants[0]); index++)
+    {
+        bench_result_t result;
+
+        if(!run_variant(&variants[index], &result))
+        {
+            fprintf(stderr, "%s: ring allocation failed\n", variants[index].name);
+            return 1;
+        }
+
+        printf("%-14s %14.1f %14.1f %18.1f ", variants[index].name, result.first_ns, result.warm_ns, result.worst_chunk_ns);
+        print_applied(result.applied);
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file bench_sharded_counter.c
+ * @brief Sharded counter versus shared atomic counter benchmark.
+ *
+ * Every thread increments the same logical counter. The shared variant
+ * uses one atomic_fetch_add target, the sharded variant uses
+ * sharded_counter_add. Prints total increments per second per thread count.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sharded_counter.h"
+#include "osal_thread.h"
+#include "osal_time.h"
+
+#define BENCH_INCREMENTS_PER_THREAD 5000000ull
+#define BENCH_MAX_THREADS 8u
+
+// Shared counter on its own line so only the benchmark threads touch it
+static _Alignas(64) atomic_uint_fast64_t shared_counter;
+static sharded_counter_t* sharded;
+
+static atomic_bool start_flag;
+static atomic_uint ready_threads;
+
+/**
+ * @brief Waits until all benchmark threads are created.
+ */
+static void wait_for_start(void)
+{
+    atomic_fetch_add_explicit(&ready_threads, 1, memory_order_relaxed);
+
+    while(!atomic_load_explicit(&start_flag, memory_order_acquire))
+    {
+    }
+}
+
+static void* shared_worker(void* arg)
+{
+    (void)arg;
+    wait_for_start();
+
+    for(uint64_t index = 0; index < BENCH_INCREMENTS_PER_THREAD; index++)
+    {
+        atomic_fetch_add_explicit(&shared_counter, 1, memory_order_relaxed);
+    }
+
+    return NULL;
+}
+
+static void* sharded_worker(void* arg)
+{
+    (void)arg;
+    wait_for_start();
+
+    for(uint64_t index = 0; index < BENCH_INCREMENTS_PER_THREAD; index++)
+    {
+        sharded_counter_add(sharded, 1);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Runs one variant with the given number of threads.
+ *
+ * @param worker Thread entry for the variant.
+ * @param threads Number of threads.
+ * @return Increments per second over all threads.
+ */
+static double run(osal_thread_fn_t worker, unsigned threads)
+{
+    osal_thread_t* handles[BENCH_MAX_THREADS];
+
+    atomic_store(&start_flag, false);
+    atomic_store(&ready_threads, 0);
+
+    for(unsigned index = 0; index < threads; index++)
+    {
+        if(osal_thread_create(&handles[index], worker, NULL, "bench") != 0)
+        {
+            fprintf(stderr, "thread creation failed\n");
+            exit(1);
+        }
+    }
+
+    while(atomic_load(&ready_threads) != threads)
+    {
+    }
+
+    const uint64_t start_ns = osal_telemetry_now_monotonic_ns();
+    atomic_store_explicit(&start_flag, true, memory_order_release);
+
+    for(unsigned index = 0; index < threads; index++)
+    {
+        osal_thread_join(handles[index]);
+        osal_thread_destroy(handles[index]);
+    }
+
+    const uint64_t elapsed_ns = osal_telemetry_now_monotonic_ns() - start_ns;
+
+    return (double)(BENCH_INCREMENTS_PER_THREAD * threads) * 1e9 / (double)elapsed_ns;
+}
+
+int main(void)
+{
+    if(!sharded_counter_init(&sharded, 0))
+    {
+        return 1;
+    }
+
+    printf("%-8s %20s %20s %8s\n", "threads", "shared inc/s", "sharded inc/s", "speedup");
+
+    for(unsigned threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2)
+    {
+        atomic_store(&shared_counter, 0);
+        const double shared_rate = run(shared_worker, threads);
+        const double sharded_rate = run(sharded_worker, threads);
+
+        printf("%-8u %20.0f %20.0f %7.2fx\n", threads, shared_rate, sharded_rate, sharded_rate / shared_rate);
+    }
+
+    // Both variants must have counted every increment
+    uint64_t expected = 0;
+    for(unsigned threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2)
+    {
+        expected += BENCH_INCREMENTS_PER_THREAD * threads;
+    }
+
+    if(sharded_counter_sum(sharded) != expected)
+    {
+        fprintf(stderr, "sharded counter lost increments\n");
+        return 1;
+    }
+
+    sharded_counter_free(sharded);
+
+    return 0;
+}
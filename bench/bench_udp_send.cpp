@@ -0,0 +1,223 @@
+/**
+ * @file bench_udp_send.cpp
+ * @brief sendto versus sendmmsg versus io_uring UDP send benchmark.
+ *
+ * Sends fixed size datagrams to a loopback receiver that never reads, so
+ * only the sender side is measured. The transport variants send one
+ * datagram per sendMessage and flush every batch, the way the agent
+ * flushes before it waits; the time includes the shutdown that waits for
+ * the last io_uring sends. sendmmsg is the batched system call without
+ * the transport, for reference.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "udp_transport.hpp"
+
+extern "C" {
+    #include "osal_time.h"
+}
+
+#define BENCH_DATAGRAMS 200000u
+#define BENCH_DATAGRAM_BYTES 128u
+#define BENCH_BATCH 32u
+#define BENCH_REPEATS 3u
+
+// One transport variant
+struct BenchVariant
+{
+    const char* name;
+    bool io_uring;
+    bool sqpoll;
+    bool registered_buffers;
+};
+
+/**
+ * @brief Sends through the UDP transport.
+ *
+ * @param variant Transport options.
+ * @param endpoint Receiver "host:port".
+ * @param out_applied Receives the io_uring options that took effect.
+ * @return Nanoseconds per datagram, negative on failure.
+ */
+static double transport_send(const BenchVariant& variant, const char* endpoint, uint32_t& out_applied)
+{
+    transport::UdpTransport udp;
+    transport::Config config;
+    uint8_t datagram[BENCH_DATAGRAM_BYTES];
+
+    std::memset(datagram, 0x5A, sizeof(datagram));
+
+    config.endpoint = endpoint;
+    config.io_uring = variant.io_uring;
+    config.io_uring_sqpoll = variant.sqpoll;
+    config.io_uring_registered_buffers = variant.registered_buffers;
+
+    if(!udp.Init(config) || udp.usesIoUring() != variant.io_uring)
+        return -1.0;
+
+    out_applied = udp.ioUringApplied();
+
+    const uint64_t start_ns = osal_telemetry_now_monotonic_ns();
+
+    for(uint32_t index = 0; index < BENCH_DATAGRAMS; index++)
+    {
+        if(!udp.sendMessage(datagram, sizeof(datagram)))
+            return -1.0;
+
+        if((index % BENCH_BATCH) == BENCH_BATCH - 1u)
+            (void)udp.flush();
+    }
+
+    (void)udp.flush();
+    udp.shutdown();
+
+    const uint64_t elapsed_ns = osal_telemetry_now_monotonic_ns() - start_ns;
+
+    return static_cast<double> (elapsed_ns) / BENCH_DATAGRAMS;
+}
+
+/**
+ * @brief Sends with sendmmsg, BENCH_BATCH datagrams per call.
+ *
+ * @param address Receiver address.
+ * @return Nanoseconds per datagram, negative on failure.
+ */
+static double sendmmsg_send(const sockaddr_in& address)
+{
+    mmsghdr messages[BENCH_BATCH];
+    iovec vectors[BENCH_BATCH];
+    uint8_t datagram[BENCH_DATAGRAM_BYTES];
+
+    std::memset(datagram, 0x5A, sizeof(datagram));
+    std::memset(messages, 0, sizeof(messages));
+
+    for(uint32_t index = 0; index < BENCH_BATCH; index++)
+    {
+        vectors[index].iov_base = datagram;
+        vectors[index].iov_len = sizeof(datagram);
+        messages[index].msg_hdr.msg_name = const_cast<sockaddr_in*>(&address);
+        messages[index].msg_hdr.msg_namelen = sizeof(address);
+        messages[index].msg_hdr.msg_iov = &vectors[index];
+        messages[index].msg_hdr.msg_iovlen = 1;
+    }
+
+    const int sender = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if(sender < 0)
+        return -1.0;
+
+    int send_buffer = 1 << 20;
+    (void)::setsockopt(sender, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer));
+
+    const uint64_t start_ns = osal_telemetry_now_monotonic_ns();
+
+    for(uint32_t sent = 0; sent < BENCH_DATAGRAMS; )
+    {
+        const int count = ::sendmmsg(sender, messages, BENCH_BATCH, 0);
+
+        if(count <= 0)
+        {
+            ::close(sender);
+            return -1.0;
+        }
+
+        sent += static_cast<uint32_t> (count);
+    }
+
+    const uint64_t elapsed_ns = osal_telemetry_now_monotonic_ns() - start_ns;
+
+    ::close(sender);
+
+    return static_cast<double> (elapsed_ns) / BENCH_DATAGRAMS;
+}
+
+int main(void)
+{
+    static const BenchVariant variants[] = {
+        { "sendto", false, false, false },
+        { "io_uring", true, false, false },
+        { "io_uring+sqpoll", true, true, false },
+        { "io_uring+regbuf", true, false, true },
+    };
+
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+
+    osal_time_init();
+
+    // A receiver that never reads, the kernel drops what does not fit
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const int receiver = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if(receiver < 0 || ::bind(receiver, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+       ::getsockname(receiver, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+    {
+        std::fprintf(stderr, "loopback receiver failed\n");
+        return 1;
+    }
+
+    const std::string endpoint = "127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+
+    std::printf("%u datagrams of %u bytes, flush every %u, best of %u\n",
+                BENCH_DATAGRAMS, BENCH_DATAGRAM_BYTES, BENCH_BATCH, BENCH_REPEATS);
+    std::printf("%-16s %14s %s\n", "path", "ns/datagram", "applied");
+
+    for(const BenchVariant& variant : variants)
+    {
+        double best = -1.0;
+        uint32_t applied = 0;
+
+        for(unsigned repeat = 0; repeat < BENCH_REPEATS; repeat++)
+        {
+            const double result = transport_send(variant, endpoint.c_str(), applied);
+
+            if(result < 0.0)
+            {
+                // io_uring missing or disabled, the transport sends with sendto instead
+                best = -1.0;
+                break;
+            }
+
+            if(best < 0.0 || result < best)
+                best = result;
+        }
+
+        if(best < 0.0)
+        {
+            std::printf("%-16s %14s\n", variant.name, "unavailable");
+            continue;
+        }
+
+        std::printf("%-16s %14.1f %s%s\n", variant.name, best,
+                    (applied & OSAL_URING_SQPOLL) != 0 ? "sqpoll " : "",
+                    (applied & OSAL_URING_REGISTERED_BUFFERS) != 0 ? "registered" : "");
+    }
+
+    double best = -1.0;
+
+    for(unsigned repeat = 0; repeat < BENCH_REPEATS; repeat++)
+    {
+        const double result = sendmmsg_send(address);
+
+        if(result >= 0.0 && (best < 0.0 || result < best))
+            best = result;
+    }
+
+    std::printf("%-16s %14.1f\n", "sendmmsg", best);
+
+    ::close(receiver);
+
+    return 0;
+}
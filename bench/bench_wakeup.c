@@ -0,0 +1,151 @@
+/**
+ * @file bench_wakeup.c
+ * @brief eventfd versus futex wakeup benchmark.
+ *
+ * Two measurements per backend. The notify cost is the time of
+ * osal_wakeup_notify while the waiter is busy, the common case of a
+ * producer notifying an agent that is still draining. The wake latency is
+ * half the round trip of a ping-pong between two threads that sleep on a
+ * wakeup object each, so every notify has to wake a sleeping thread.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "osal_thread.h"
+#include "osal_time.h"
+#include "osal_wakeup.h"
+
+#define BENCH_NOTIFIES 2000000u
+#define BENCH_ROUND_TRIPS 20000u
+#define BENCH_REPEATS 3u
+
+typedef struct bench_pong_s {
+    osal_wakeup_t* ping;        // Woken by the main thread
+    osal_wakeup_t* pong;        // Woken by the pong thread
+} bench_pong_t;
+
+/**
+ * @brief Notifies with nobody waiting.
+ *
+ * @param backend Backend to measure.
+ * @return Nanoseconds per notify, negative on failure.
+ */
+static double notify_cost(osal_wakeup_backend_t backend)
+{
+    osal_wakeup_t* wakeup = osal_wakeup_create_ex(backend);
+
+    if(wakeup == NULL)
+        return -1.0;
+
+    const uint64_t start_ns = osal_telemetry_now_monotonic_ns();
+
+    for(uint32_t index = 0; index < BENCH_NOTIFIES; index++)
+    {
+        osal_wakeup_notify(wakeup);
+    }
+
+    const uint64_t elapsed_ns = osal_telemetry_now_monotonic_ns() - start_ns;
+
+    osal_wakeup_destroy(wakeup);
+
+    return (double)elapsed_ns / BENCH_NOTIFIES;
+}
+
+static void* pong_worker(void* arg)
+{
+    bench_pong_t* pong = (bench_pong_t*)arg;
+
+    // One round trip more than the main thread, the last ping ends the loop
+    for(uint32_t index = 0; index <= BENCH_ROUND_TRIPS; index++)
+    {
+        osal_wakeup_wait(pong->ping);
+        osal_wakeup_notify(pong->pong);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Ping-pongs between two threads.
+ *
+ * @param backend Backend to measure.
+ * @return Nanoseconds from a notify to the waiter running, negative on failure.
+ */
+static double wake_latency(osal_wakeup_backend_t backend)
+{
+    bench_pong_t pong;
+    osal_thread_t* thread = NULL;
+
+    pong.ping = osal_wakeup_create_ex(backend);
+    pong.pong = osal_wakeup_create_ex(backend);
+
+    if(pong.ping == NULL || pong.pong == NULL || osal_thread_create(&thread, pong_worker, &pong, "bench_pong") != 0)
+    {
+        osal_wakeup_destroy(pong.ping);
+        osal_wakeup_destroy(pong.pong);
+        return -1.0;
+    }
+
+    // First round trip outside the timing, the thread is running afterwards
+    osal_wakeup_notify(pong.ping);
+    osal_wakeup_wait(pong.pong);
+
+    const uint64_t start_ns = osal_telemetry_now_monotonic_ns();
+
+    for(uint32_t index = 0; index < BENCH_ROUND_TRIPS; index++)
+    {
+        osal_wakeup_notify(pong.ping);
+        osal_wakeup_wait(pong.pong);
+    }
+
+    const uint64_t elapsed_ns = osal_telemetry_now_monotonic_ns() - start_ns;
+
+    osal_thread_join(thread);
+    osal_thread_destroy(thread);
+    osal_wakeup_destroy(pong.ping);
+    osal_wakeup_destroy(pong.pong);
+
+    return (double)elapsed_ns / (2.0 * BENCH_ROUND_TRIPS);
+}
+
+int main(void)
+{
+    static const osal_wakeup_backend_t backends[] = { OSAL_WAKEUP_BACKEND_EVENTFD, OSAL_WAKEUP_BACKEND_FUTEX };
+    static const char* const names[] = { "eventfd", "futex" };
+
+    osal_time_init();
+
+    printf("%u notifies, %u round trips, best of %u\n", BENCH_NOTIFIES, BENCH_ROUND_TRIPS, BENCH_REPEATS);
+    printf("%-8s %16s %18s\n", "backend", "notify ns (busy)", "wake latency ns");
+
+    for(size_t index = 0; index < sizeof(backends) / sizeof(backends[0]); index++)
+    {
+        double best_notify = -1.0;
+        double best_latency = -1.0;
+
+        for(unsigned repeat = 0; repeat < BENCH_REPEATS; repeat++)
+        {
+            const double notify = notify_cost(backends[index]);
+            const double latency = wake_latency(backends[index]);
+
+            if(notify < 0.0 || latency < 0.0)
+            {
+                fprintf(stderr, "%s: wakeup setup failed\n", names[index]);
+                return 1;
+            }
+
+            if(best_notify < 0.0 || notify < best_notify)
+                best_notify = notify;
+
+            if(best_latency < 0.0 || latency < best_latency)
+                best_latency = latency;
+        }
+
+        printf("%-8s %16.1f %18.1f\n", names[index], best_notify, best_latency);
+    }
+
+    return 0;
+}
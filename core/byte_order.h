@@ -0,0 +1,63 @@
+/**
+ * @file byte_order.h
+ * @brief Big-endian integer helpers shared by the wire encoders.
+ *
+ * Internal to the core: the protocol header, metrics batches, sketch
+ * batches and log arguments all write fixed width integers most
+ * significant byte first through these. The caller checks the space.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Writes a u16 big-endian (2 bytes)
+static inline void telemetry_put_u16_be(uint8_t* buffer, uint16_t value)
+{
+    buffer[0] = (uint8_t)(value >> 8);
+    buffer[1] = (uint8_t)(value & 0xFF);
+}
+
+// Writes a u32 big-endian (4 bytes)
+static inline void telemetry_put_u32_be(uint8_t* buffer, uint32_t value)
+{
+    buffer[0] = (uint8_t)(value >> 24);
+    buffer[1] = (uint8_t)(value >> 16);
+    buffer[2] = (uint8_t)(value >> 8);
+    buffer[3] = (uint8_t)(value & 0xFF);
+}
+
+// Writes a u64 big-endian (8 bytes)
+static inline void telemetry_put_u64_be(uint8_t* buffer, uint64_t value)
+{
+    telemetry_put_u32_be(buffer, (uint32_t)(value >> 32));
+    telemetry_put_u32_be(buffer + 4, (uint32_t)value);
+}
+
+// Reads a big-endian u16 (2 bytes)
+static inline uint16_t telemetry_get_u16_be(const uint8_t* buffer)
+{
+    return (uint16_t)(((uint16_t)buffer[0] << 8) | buffer[1]);
+}
+
+// Reads a big-endian u32 (4 bytes)
+static inline uint32_t telemetry_get_u32_be(const uint8_t* buffer)
+{
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) | ((uint32_t)buffer[2] << 8) | (uint32_t)buffer[3];
+}
+
+// Reads a big-endian u64 (8 bytes)
+static inline uint64_t telemetry_get_u64_be(const uint8_t* buffer)
+{
+    return ((uint64_t)telemetry_get_u32_be(buffer) << 32) | telemetry_get_u32_be(buffer + 4);
+}
+
+#ifdef __cplusplus
+    }
+#endif
@@ -10,10 +10,89 @@
 
 #include "event.h"
 #include "osal_time.h"
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <string.h>
 #include <time.h>
 
+// Timestamps converted per osal_time_ticks_to_ns_bulk call
+#define EVENT_RESOLVE_CHUNK 32u
+
+// Override slot layout : event id in the high half, an occupied bit and the clock code below
+#define EVENT_CLOCK_SLOT_OCCUPIED   0x100u
+#define EVENT_CLOCK_SLOT_FOLLOW     0x00u   // Clock code of a cleared override
+#define EVENT_CLOCK_SLOT_CODE_MASK  0xFFu
+
+_Static_assert(sizeof(telemetry_event_block_t) <= TELEMETRY_EVENT_PAYLOAD_MAX, "a pool handle must fit the inline payload");
+
+_Static_assert((TELEMETRY_EVENT_CLOCK_OVERRIDES & (TELEMETRY_EVENT_CLOCK_OVERRIDES - 1u)) == 0,
+               "TELEMETRY_EVENT_CLOCK_OVERRIDES must be a power of two");
+
+// Clock per level, read on every telemetry_event_make
+static atomic_uchar level_clocks[TELEMETRY_LEVEL_COUNT];
+
+// Clock per event id, open addressing, slots are only ever added
+static atomic_uint_fast64_t id_clocks[TELEMETRY_EVENT_CLOCK_OVERRIDES];
+static atomic_uint id_clock_count;  // Occupied slots, lets telemetry_event_make skip the lookup
+
+
+// Local function definitions
+
+/**
+ * @brief Returns the first probe slot of an event id.
+ *
+ * @param event_id Event identifier.
+ * @return Slot index.
+ */
+static inline size_t id_clock_home(uint32_t event_id)
+{
+    return (size_t)((event_id * 0x9E3779B1u) & (TELEMETRY_EVENT_CLOCK_OVERRIDES - 1u));
+}
+
+/**
+ * @brief Stores the clock code of an event id, claiming a slot if needed.
+ *
+ * @param event_id Event identifier.
+ * @param code Clock plus one, or EVENT_CLOCK_SLOT_FOLLOW.
+ * @param claim Claim a free slot if the id has none.
+ * @return false if the id has no slot and none could be claimed.
+ */
+static bool id_clock_store(uint32_t event_id, unsigned code, bool claim)
+{
+    const uint64_t key = (uint64_t)event_id << 32;
+    const uint64_t value = key | EVENT_CLOCK_SLOT_OCCUPIED | code;
+    size_t slot = id_clock_home(event_id);
+
+    for(size_t probe = 0; probe < TELEMETRY_EVENT_CLOCK_OVERRIDES; probe++)
+    {
+        uint64_t current = atomic_load_explicit(&id_clocks[slot], memory_order_relaxed);
+
+        // Claim an empty slot; if another thread wins it, look at what it stored
+        if(current == 0)
+        {
+            if(!claim)
+                return false;
+
+            if(atomic_compare_exchange_strong_explicit(&id_clocks[slot], &current, value,
+                                                       memory_order_relaxed, memory_order_relaxed))
+            {
+                atomic_fetch_add_explicit(&id_clock_count, 1u, memory_order_relaxed);
+                return true;
+            }
+        }
+
+        if((current & ~(uint64_t)0xFFFFFFFFu) == key)
+        {
+            atomic_store_explicit(&id_clocks[slot], value, memory_order_relaxed);
+            return true;
+        }
+
+        slot = (slot + 1u) & (TELEMETRY_EVENT_CLOCK_OVERRIDES - 1u);
+    }
+
+    return false;
+}
+
 
 // Function definitions
 
@@ -50,11 +129,11 @@ bool telemetry_event_make(telemetry_event_t * event,
     // Initialize event fields
     event->event_id = event_id;
     event->level = level;
-    event->reserved = 0x00;  // Reserved for future use
+    event->reserved = 0x00;  // Flags, set by the stamp below
     event->payload_size = (uint16_t) payload_size;
 
-    // Set the timestamp
-    event->timestamp = osal_telemetry_now_monotonic_ns();
+    // Set the timestamp with the clock chosen for the id or the level
+    telemetry_event_stamp(event, telemetry_event_clock_for(event_id, level));
 
     // Copy the payload to the struct
     if(payload_size > 0)
@@ -72,3 +151,257 @@ bool telemetry_event_make(telemetry_event_t * event,
 
     return true;
 }
+
+/**
+ * @brief Initializes an event whose payload lives in a memory pool block.
+ *
+ * Only the handle is stored in the event, so the ring copies a few bytes
+ * whatever the payload size. The block belongs to the event from here on:
+ * whoever consumes it calls telemetry_event_release_payload once sent.
+ *
+ * @param event      Event structure to initialize.
+ * @param event_id   Unique identifier for the event.
+ * @param pool       Pool the block was taken from.
+ * @param block      Block holding the payload, from memory_pool_alloc(pool).
+ * @param payload_size Payload bytes in the block, at most the block size and TELEMETRY_EVENT_POOLED_PAYLOAD_MAX.
+ * @param level      Event severity level.
+ * @return true on success, false on failure; the caller still owns the block then.
+ */
+bool telemetry_event_make_pooled(telemetry_event_t* event, uint32_t event_id, memory_pool_t* pool, void* block,
+                                 size_t payload_size, telemetry_level_t level)
+{
+    telemetry_event_block_t handle;
+
+    if(event == NULL || payload_size > TELEMETRY_EVENT_POOLED_PAYLOAD_MAX || payload_size > memory_pool_block_size(pool))
+        return false;
+
+    handle.pool = pool;
+    handle.index = memory_pool_index(pool, block);
+
+    if(handle.index == MEMORY_POOL_INVALID_INDEX)
+        return false;
+
+    event->event_id = event_id;
+    event->level = level;
+    event->reserved = TELEMETRY_EVENT_FLAG_POOLED;
+    event->payload_size = (uint16_t)payload_size;
+
+    telemetry_event_stamp(event, telemetry_event_clock_for(event_id, level));
+
+    memcpy(event->payload, &handle, sizeof(handle));
+
+    return true;
+}
+
+/**
+ * @brief Gives the block of a pooled event back to its pool.
+ *
+ * The event is left with an empty inline payload, so a second call does
+ * nothing.
+ *
+ * @param event Event that was consumed.
+ */
+void telemetry_event_release_payload(telemetry_event_t* event)
+{
+    telemetry_event_block_t handle;
+
+    if(event == NULL || !telemetry_event_is_pooled(event))
+        return;
+
+    memcpy(&handle, event->payload, sizeof(handle));
+
+    memory_pool_release(handle.pool, memory_pool_block(handle.pool, handle.index));
+
+    event->reserved &= (uint8_t)~TELEMETRY_EVENT_FLAG_POOLED;
+    event->payload_size = 0;
+}
+
+/**
+ * @brief Selects the clock telemetry_event_make uses for a level.
+ *
+ * TELEMETRY_CLOCK_TICKS leaves only a counter read on the producer; the
+ * agent converts the timestamp before the event is sent.
+ * TELEMETRY_CLOCK_COARSE is a single load of the coarse clock.
+ *
+ * @param level Event severity level.
+ * @param clock Clock for events of this level.
+ */
+void telemetry_event_set_level_clock(telemetry_level_t level, telemetry_clock_t clock)
+{
+    if((unsigned)level >= TELEMETRY_LEVEL_COUNT)
+        return;
+
+    atomic_store_explicit(&level_clocks[level], (unsigned char)clock, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the clock used for a level.
+ *
+ * @param level Event severity level.
+ * @return Clock for events of this level.
+ */
+telemetry_clock_t telemetry_event_level_clock(telemetry_level_t level)
+{
+    if((unsigned)level >= TELEMETRY_LEVEL_COUNT)
+        return TELEMETRY_CLOCK_PRECISE;
+
+    return (telemetry_clock_t)atomic_load_explicit(&level_clocks[level], memory_order_relaxed);
+}
+
+/**
+ * @brief Selects the clock telemetry_event_make uses for one event id.
+ *
+ * Lets a few chatty ids use TELEMETRY_CLOCK_COARSE or TELEMETRY_CLOCK_TICKS
+ * while the rest of their level keeps precise time.
+ *
+ * @param event_id Event identifier.
+ * @param clock Clock for events with this id.
+ * @return true on success, false if TELEMETRY_EVENT_CLOCK_OVERRIDES ids
+ *         already have an override or the clock is invalid.
+ */
+bool telemetry_event_set_id_clock(uint32_t event_id, telemetry_clock_t clock)
+{
+    if((unsigned)clock > (unsigned)TELEMETRY_CLOCK_COARSE)
+        return false;
+
+    return id_clock_store(event_id, (unsigned)clock + 1u, true);
+}
+
+/**
+ * @brief Removes the clock override of an event id.
+ *
+ * The id uses its level's clock again. The slot stays reserved for the id.
+ *
+ * @param event_id Event identifier.
+ */
+void telemetry_event_clear_id_clock(uint32_t event_id)
+{
+    (void)id_clock_store(event_id, EVENT_CLOCK_SLOT_FOLLOW, false);
+}
+
+/**
+ * @brief Returns the clock used for an event.
+ *
+ * @param event_id Event identifier.
+ * @param level Event severity level.
+ * @return The id override if there is one, otherwise the level clock.
+ */
+telemetry_clock_t telemetry_event_clock_for(uint32_t event_id, telemetry_level_t level)
+{
+    // No overrides, no lookup
+    if(atomic_load_explicit(&id_clock_count, memory_order_relaxed) != 0)
+    {
+        const uint64_t key = (uint64_t)event_id << 32;
+        size_t slot = id_clock_home(event_id);
+
+        for(size_t probe = 0; probe < TELEMETRY_EVENT_CLOCK_OVERRIDES; probe++)
+        {
+            const uint64_t current = atomic_load_explicit(&id_clocks[slot], memory_order_relaxed);
+
+            if(current == 0)
+                break;
+
+            if((current & ~(uint64_t)0xFFFFFFFFu) == key)
+            {
+                const unsigned code = (unsigned)(current & EVENT_CLOCK_SLOT_CODE_MASK);
+
+                if(code != EVENT_CLOCK_SLOT_FOLLOW)
+                    return (telemetry_clock_t)(code - 1u);
+
+                break;
+            }
+
+            slot = (slot + 1u) & (TELEMETRY_EVENT_CLOCK_OVERRIDES - 1u);
+        }
+    }
+
+    return telemetry_event_level_clock(level);
+}
+
+/**
+ * @brief Sets the timestamp of an event.
+ *
+ * @param event Event to stamp.
+ * @param clock Clock to read.
+ */
+void telemetry_event_stamp(telemetry_event_t* event, telemetry_clock_t clock)
+{
+    if(event == NULL)
+        return;
+
+    if(clock == TELEMETRY_CLOCK_TICKS)
+    {
+        event->timestamp = osal_telemetry_now_ticks();
+        event->reserved |= TELEMETRY_EVENT_FLAG_RAW_TICKS;
+        return;
+    }
+
+    if(clock == TELEMETRY_CLOCK_COARSE)
+        event->timestamp = osal_telemetry_now_coarse_ns();
+    else
+        event->timestamp = osal_telemetry_now_monotonic_ns();
+
+    event->reserved &= (uint8_t)~TELEMETRY_EVENT_FLAG_RAW_TICKS;
+}
+
+/**
+ * @brief Returns the timestamp of an event in nanoseconds.
+ *
+ * @param event Event to read.
+ * @return Monotonic nanoseconds.
+ */
+uint64_t telemetry_event_timestamp_ns(const telemetry_event_t* event)
+{
+    if(event == NULL)
+        return 0;
+
+    if((event->reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) != 0)
+        return osal_time_ticks_to_ns(event->timestamp);
+
+    return event->timestamp;
+}
+
+/**
+ * @brief Converts the raw tick timestamps of a batch to nanoseconds.
+ *
+ * The flagged timestamps are gathered and converted with one calibration
+ * read per chunk, then written back with the flag cleared.
+ *
+ * @param events Events drained from a ring buffer.
+ * @param count Number of events.
+ */
+void telemetry_event_resolve_timestamps(telemetry_event_t* events, size_t count)
+{
+    uint64_t ticks[EVENT_RESOLVE_CHUNK];
+    telemetry_event_t* owners[EVENT_RESOLVE_CHUNK];
+
+    if(events == NULL)
+        return;
+
+    size_t index = 0;
+
+    while(index < count)
+    {
+        size_t gathered = 0;
+
+        // Gather the raw timestamps
+        for(; index < count && gathered < EVENT_RESOLVE_CHUNK; index++)
+        {
+            if((events[index].reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) != 0)
+            {
+                ticks[gathered] = events[index].timestamp;
+                owners[gathered] = &events[index];
+                gathered++;
+            }
+        }
+
+        osal_time_ticks_to_ns_bulk(ticks, gathered);
+
+        // Write them back as nanoseconds
+        for(size_t converted = 0; converted < gathered; converted++)
+        {
+            owners[converted]->timestamp = ticks[converted];
+            owners[converted]->reserved &= (uint8_t)~TELEMETRY_EVENT_FLAG_RAW_TICKS;
+        }
+    }
+}
@@ -2,8 +2,10 @@
 #pragma once
 
 #include "../api/type.h"
+#include "memory_pool.h"
 #include <stddef.h>         // size_t   
 #include <stdbool.h>        // bool
+#include <string.h>         // memcpy
 
 // Ensure compatibility with C++ compilers
 #ifdef __cplusplus
@@ -15,6 +17,21 @@
     #define TELEMETRY_EVENT_PAYLOAD_MAX 128
 #endif
 
+// Event ids that can have their own clock, see telemetry_event_set_id_clock
+#ifndef TELEMETRY_EVENT_CLOCK_OVERRIDES
+    #define TELEMETRY_EVENT_CLOCK_OVERRIDES 64u
+#endif
+
+// Event ids from here on are used by the framework itself (log records, dictionaries)
+#define TELEMETRY_EVENT_ID_RESERVED_BASE 0xF0000000u
+
+// Flags stored in telemetry_event_t.reserved
+#define TELEMETRY_EVENT_FLAG_RAW_TICKS  0x01u   // timestamp holds osal ticks, not nanoseconds
+#define TELEMETRY_EVENT_FLAG_POOLED     0x02u   // payload lives in a memory pool block, see telemetry_event_make_pooled
+
+// Largest payload of a pooled event, bounded by payload_size
+#define TELEMETRY_EVENT_POOLED_PAYLOAD_MAX 0xFFFFu
+
 // Telemetry event severity levels
 typedef enum telemetry_level_e{
     TELEMETRY_LEVEL_DEBUG = 0,
@@ -23,17 +40,32 @@ typedef enum telemetry_level_e{
     TELEMETRY_LEVEL_ERROR
 }telemetry_level_t;
 
+#define TELEMETRY_LEVEL_COUNT 4u
+
+// How telemetry_event_make timestamps an event
+typedef enum telemetry_clock_e{
+    TELEMETRY_CLOCK_PRECISE = 0,    // Monotonic nanoseconds, converted on the producer
+    TELEMETRY_CLOCK_TICKS,          // Raw counter ticks, converted to nanoseconds by the agent
+    TELEMETRY_CLOCK_COARSE          // Coarse monotonic nanoseconds, see osal_telemetry_now_coarse_ns()
+}telemetry_clock_t;
+
 
 // Telemetry event structure definition
 typedef struct telemetry_event_s{
     uint32_t event_id;
     uint8_t level;
-    uint8_t reserved;       // Padding for alignment
+    uint8_t reserved;       // TELEMETRY_EVENT_FLAG_* bits
     uint16_t payload_size;
     uint64_t timestamp;
     uint8_t  payload[TELEMETRY_EVENT_PAYLOAD_MAX];
 }telemetry_event_t;
 
+// Handle stored at the start of payload[] of a pooled event
+typedef struct telemetry_event_block_s{
+    memory_pool_t* pool;
+    uint32_t index;
+}telemetry_event_block_t;
+
 // Function to create a telemetry event
 bool telemetry_event_make(
     telemetry_event_t* event,
@@ -43,12 +75,67 @@ bool telemetry_event_make(
     telemetry_level_t level
 );
 
+// Event whose payload is a memory pool block; on success the event owns the block
+bool telemetry_event_make_pooled(
+    telemetry_event_t* event,
+    uint32_t event_id,
+    memory_pool_t* pool,
+    void* block,
+    size_t payload_size,
+    telemetry_level_t level
+);
+
+// Consumer side : give the block of a pooled event back, no-op for inline events
+void telemetry_event_release_payload(telemetry_event_t* event);
+
+// Clock used by telemetry_event_make for a level, TELEMETRY_CLOCK_PRECISE by default
+void telemetry_event_set_level_clock(telemetry_level_t level, telemetry_clock_t clock);
+telemetry_clock_t telemetry_event_level_clock(telemetry_level_t level);
+
+// Clock for one event id, takes precedence over the level. Returns false when the override table is full.
+bool telemetry_event_set_id_clock(uint32_t event_id, telemetry_clock_t clock);
+void telemetry_event_clear_id_clock(uint32_t event_id);
+
+// Clock telemetry_event_make uses for an event id and level
+telemetry_clock_t telemetry_event_clock_for(uint32_t event_id, telemetry_level_t level);
+
+// Set the timestamp of an event with the given clock
+void telemetry_event_stamp(telemetry_event_t* event, telemetry_clock_t clock);
+
+// Timestamp in nanoseconds, converting raw ticks if needed
+uint64_t telemetry_event_timestamp_ns(const telemetry_event_t* event);
+
+// Consumer side : convert all raw tick timestamps of a batch to nanoseconds
+void telemetry_event_resolve_timestamps(telemetry_event_t* events, size_t count);
+
 // utility function to get max payload size
 static inline size_t telemetry_event_payload_max(void)
 {
     return TELEMETRY_EVENT_PAYLOAD_MAX;
 }
 
+// true if the payload of the event lives in a memory pool block
+static inline bool telemetry_event_is_pooled(const telemetry_event_t* event)
+{
+    return (event->reserved & TELEMETRY_EVENT_FLAG_POOLED) != 0;
+}
+
+// Payload bytes of an inline or pooled event, payload_size of them; async-signal-safe
+static inline const uint8_t* telemetry_event_payload(const telemetry_event_t* event)
+{
+    telemetry_event_block_t handle;
+
+    if(event == NULL)
+        return NULL;
+
+    if(!telemetry_event_is_pooled(event))
+        return event->payload;
+
+    memcpy(&handle, event->payload, sizeof(handle));
+
+    return (const uint8_t*)memory_pool_block(handle.pool, handle.index);
+}
+
 
 #ifdef __cplusplus
     }
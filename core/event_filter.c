@@ -0,0 +1,55 @@
+/**
+ * @file event_filter.c
+ * @brief Runtime per event id filter.
+ *
+ * Writers flip single bits with atomic read-modify-write operations; the
+ * emit path only loads the word holding its id.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include "event_filter.h"
+
+_Static_assert((TELEMETRY_EVENT_FILTER_IDS % 64u) == 0, "TELEMETRY_EVENT_FILTER_IDS must be a multiple of 64");
+
+// Disabled bit per id, all ids enabled at start
+uint64_t telemetry_event_filter_disabled[TELEMETRY_EVENT_FILTER_WORDS];
+
+
+// Global function definitions
+
+/**
+ * @brief Enables or disables events with one id.
+ *
+ * Takes effect for producers with their next emit; an event already
+ * being built when the bit changes is still pushed.
+ *
+ * @param event_id Event identifier.
+ * @param enabled false to drop events with this id before they are built.
+ * @return true on success, false if the id is not below TELEMETRY_EVENT_FILTER_IDS.
+ */
+bool telemetry_event_filter_set(uint32_t event_id, bool enabled)
+{
+    if(event_id >= TELEMETRY_EVENT_FILTER_IDS)
+        return false;
+
+    const uint64_t bit = (uint64_t)1u << (event_id % 64u);
+
+    if(enabled)
+        __atomic_fetch_and(&telemetry_event_filter_disabled[event_id / 64u], ~bit, __ATOMIC_RELAXED);
+    else
+        __atomic_fetch_or(&telemetry_event_filter_disabled[event_id / 64u], bit, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+/**
+ * @brief Enables all event ids.
+ */
+void telemetry_event_filter_reset(void)
+{
+    for(size_t index = 0; index < TELEMETRY_EVENT_FILTER_WORDS; index++)
+    {
+        __atomic_store_n(&telemetry_event_filter_disabled[index], 0, __ATOMIC_RELAXED);
+    }
+}
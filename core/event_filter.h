@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../api/type.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Event ids covered by the runtime filter, ids from here on are always enabled
+#ifndef TELEMETRY_EVENT_FILTER_IDS
+    #define TELEMETRY_EVENT_FILTER_IDS 4096u
+#endif
+
+#define TELEMETRY_EVENT_FILTER_WORDS (TELEMETRY_EVENT_FILTER_IDS / 64u)
+
+/*
+ * Runtime enable bit per event id, checked by the emit macros of
+ * api/telemetry_emit.h before any payload work.
+ * A set bit disables the id, so the zero initialized bitmap enables all ids.
+ * The words are accessed with the GCC __atomic builtins rather than C11
+ * _Atomic because the check is inlined into C++ translation units as well.
+ * Do not access the array directly, use the functions below.
+ */
+extern uint64_t telemetry_event_filter_disabled[TELEMETRY_EVENT_FILTER_WORDS];
+
+// Enables or disables one id. Returns false for ids outside the filter, they stay enabled.
+bool telemetry_event_filter_set(uint32_t event_id, bool enabled);
+
+// Enables every id again
+void telemetry_event_filter_reset(void);
+
+// Producer side : one relaxed load, true if events with this id should be built
+static inline bool telemetry_event_filter_enabled(uint32_t event_id)
+{
+    if(event_id >= TELEMETRY_EVENT_FILTER_IDS)
+        return true;
+
+    const uint64_t word = __atomic_load_n(&telemetry_event_filter_disabled[event_id / 64u], __ATOMIC_RELAXED);
+
+    return ((word >> (event_id % 64u)) & 1u) == 0;
+}
+
+
+#ifdef __cplusplus
+    }
+#endif
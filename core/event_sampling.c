@@ -0,0 +1,420 @@
+/**
+ * @file event_sampling.c
+ * @brief Per event id sampling and rate limiting.
+ *
+ * Policies live in a small open addressing table. A slot belongs to its id
+ * from the first telemetry_event_sampling_set on, so the suppressed counter
+ * a metric points at never changes owner; removing a policy only clears its
+ * stages and the active bit.
+ *
+ * The token bucket is the generic cell rate algorithm: a single theoretical
+ * arrival time advances by one emission interval per kept event, and an
+ * event is kept while that time is at most burst - 1 intervals ahead of now.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include "event_sampling.h"
+#include "sharded_counter.h"
+#include "osal_time.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+_Static_assert((TELEMETRY_EVENT_SAMPLING_POLICIES & (TELEMETRY_EVENT_SAMPLING_POLICIES - 1u)) == 0,
+               "TELEMETRY_EVENT_SAMPLING_POLICIES must be a power of two");
+
+// Probability threshold that keeps every event, thresholds compare against 32 random bits
+#define SAMPLING_KEEP_ALL_THRESHOLD ((uint64_t)1 << 32)
+
+#define SAMPLING_NS_PER_SECOND 1000000000ull
+
+// Struct declaration
+
+typedef struct sampling_slot_s {
+    _Alignas(64) atomic_uint owner;             // Event id + 1, 0 while the slot is free
+    atomic_uint one_in_n;
+    atomic_uint_fast64_t threshold;             // Probability scaled to 2^32
+    atomic_uint_fast64_t interval_ns;           // Time per token, 0 without a rate limit
+    atomic_uint_fast64_t tolerance_ns;          // (burst - 1) * interval_ns
+    _Alignas(64) atomic_uint_fast64_t arrival_ns;   // Theoretical arrival time, written by kept events
+    _Atomic(sharded_counter_t*) suppressed;
+} sampling_slot_t;
+
+// Active bit per id, all ids unsampled at start
+uint64_t telemetry_event_sampling_active[TELEMETRY_EVENT_FILTER_WORDS];
+
+static sampling_slot_t sampling_slots[TELEMETRY_EVENT_SAMPLING_POLICIES];
+
+// Slots claimed so far, bumped once a claimed slot has its counter
+static atomic_size_t sampling_slot_count;
+
+// One in n countdown per slot and generator state of the calling thread
+static _Thread_local uint32_t thread_countdown[TELEMETRY_EVENT_SAMPLING_POLICIES];
+static _Thread_local uint64_t thread_random_state;
+
+
+// Local function definitions
+
+/**
+ * @brief Returns the first slot to probe for an id.
+ *
+ * @param event_id Event identifier.
+ * @return Slot index.
+ */
+static inline size_t sampling_home_slot(uint32_t event_id)
+{
+    return (size_t)((event_id * 0x9E3779B1u) & (TELEMETRY_EVENT_SAMPLING_POLICIES - 1u));
+}
+
+/**
+ * @brief Finds the slot owned by an id.
+ *
+ * @param event_id Event identifier.
+ * @return Slot index, or TELEMETRY_EVENT_SAMPLING_POLICIES if the id has none.
+ */
+static size_t sampling_find_slot(uint32_t event_id)
+{
+    size_t slot = sampling_home_slot(event_id);
+
+    for(size_t probe = 0; probe < TELEMETRY_EVENT_SAMPLING_POLICIES; probe++)
+    {
+        const unsigned owner = atomic_load_explicit(&sampling_slots[slot].owner, memory_order_acquire);
+
+        if(owner == event_id + 1u)
+            return slot;
+
+        // Slots are never released, a free slot ends the probe sequence
+        if(owner == 0)
+            break;
+
+        slot = (slot + 1u) & (TELEMETRY_EVENT_SAMPLING_POLICIES - 1u);
+    }
+
+    return TELEMETRY_EVENT_SAMPLING_POLICIES;
+}
+
+/**
+ * @brief Finds or claims the slot of an id.
+ *
+ * The suppressed counter is allocated before the slot is claimed, so a
+ * claimed slot only lacks it for the moment between the two stores.
+ *
+ * @param event_id Event identifier.
+ * @return Slot index, or TELEMETRY_EVENT_SAMPLING_POLICIES if the table is full.
+ */
+static size_t sampling_claim_slot(uint32_t event_id)
+{
+    size_t slot = sampling_find_slot(event_id);
+
+    if(slot != TELEMETRY_EVENT_SAMPLING_POLICIES)
+        return slot;
+
+    sharded_counter_t* counter;
+
+    if(!sharded_counter_init(&counter, 0))
+        return TELEMETRY_EVENT_SAMPLING_POLICIES;
+
+    slot = sampling_home_slot(event_id);
+
+    for(size_t probe = 0; probe < TELEMETRY_EVENT_SAMPLING_POLICIES; probe++)
+    {
+        unsigned owner = 0;
+
+        if(atomic_compare_exchange_strong_explicit(&sampling_slots[slot].owner, &owner, event_id + 1u,
+                                                   memory_order_acq_rel, memory_order_acquire))
+        {
+            atomic_store_explicit(&sampling_slots[slot].suppressed, counter, memory_order_release);
+            atomic_fetch_add_explicit(&sampling_slot_count, 1, memory_order_release);
+            return slot;
+        }
+
+        // Another thread claimed it for the same id
+        if(owner == event_id + 1u)
+            break;
+
+        slot = (slot + 1u) & (TELEMETRY_EVENT_SAMPLING_POLICIES - 1u);
+    }
+
+    sharded_counter_free(counter);
+
+    return sampling_find_slot(event_id);
+}
+
+/**
+ * @brief Returns 32 random bits from the calling thread's generator.
+ *
+ * xorshift64*, seeded on first use from the thread's state address and
+ * the counter so threads do not share a sequence.
+ *
+ * @return Random value.
+ */
+static inline uint32_t sampling_random(void)
+{
+    uint64_t state = thread_random_state;
+
+    if(state == 0)
+    {
+        // splitmix64 finalizer spreads the seed bits
+        state = (uint64_t)(uintptr_t)&thread_random_state ^ osal_telemetry_now_ticks();
+        state = (state ^ (state >> 30)) * 0xBF58476D1CE4E5B9ull;
+        state = (state ^ (state >> 27)) * 0x94D049BB133111EBull;
+        state = (state ^ (state >> 31)) | 1u;
+    }
+
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    thread_random_state = state;
+
+    return (uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+/**
+ * @brief Takes a token from a slot's bucket.
+ *
+ * Reads the precise clock: a coarse time only moves once per tick, which
+ * would cap every bucket at burst events per tick whatever its rate. Only
+ * ids with a rate limit get here.
+ *
+ * @param slot Slot with a rate limit.
+ * @param interval_ns Time per token.
+ * @return true if a token was available.
+ */
+static bool sampling_take_token(sampling_slot_t* slot, uint64_t interval_ns)
+{
+    const uint64_t now_ns = osal_telemetry_now_monotonic_ns();
+    const uint64_t tolerance_ns = atomic_load_explicit(&slot->tolerance_ns, memory_order_relaxed);
+    uint64_t arrival_ns = atomic_load_explicit(&slot->arrival_ns, memory_order_relaxed);
+
+    while(1)
+    {
+        // More than burst tokens ahead, the bucket is empty
+        if(arrival_ns > now_ns + tolerance_ns)
+            return false;
+
+        const uint64_t next_ns = ((arrival_ns > now_ns) ? arrival_ns : now_ns) + interval_ns;
+
+        if(atomic_compare_exchange_weak_explicit(&slot->arrival_ns, &arrival_ns, next_ns,
+                                                 memory_order_relaxed, memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+}
+
+
+// Global function definitions
+
+/**
+ * @brief Fills a policy that keeps every event.
+ *
+ * @param policy Policy to initialize.
+ */
+void telemetry_sampling_policy_init(telemetry_sampling_policy_t* policy)
+{
+    if(policy == NULL)
+        return;
+
+    policy->one_in_n = 1;
+    policy->probability = 1.0;
+    policy->rate_per_second = 0;
+    policy->burst = 1;
+}
+
+/**
+ * @brief Sets or removes the sampling policy of an id.
+ *
+ * Takes effect with the producers' next emit. Stages change one by one, so
+ * an emit racing the call may see a mix of the old and new policy.
+ *
+ * @param event_id Event identifier, below TELEMETRY_EVENT_FILTER_IDS.
+ * @param policy Policy to apply, NULL or keep-all to remove it.
+ * @return true on success, false on invalid values or a full table.
+ */
+bool telemetry_event_sampling_set(uint32_t event_id, const telemetry_sampling_policy_t* policy)
+{
+    if(event_id >= TELEMETRY_EVENT_FILTER_IDS)
+        return false;
+
+    if(policy != NULL && (!(policy->probability >= 0.0 && policy->probability <= 1.0) ||
+                          (policy->rate_per_second != 0 && policy->burst == 0)))
+    {
+        return false;
+    }
+
+    const uint64_t bit = (uint64_t)1u << (event_id % 64u);
+    const bool keep_all = (policy == NULL) ||
+                          (policy->one_in_n <= 1u && policy->probability >= 1.0 && policy->rate_per_second == 0);
+
+    if(keep_all)
+    {
+        __atomic_fetch_and(&telemetry_event_sampling_active[event_id / 64u], ~bit, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    const size_t index = sampling_claim_slot(event_id);
+
+    if(index == TELEMETRY_EVENT_SAMPLING_POLICIES)
+        return false;
+
+    sampling_slot_t* slot = &sampling_slots[index];
+    uint64_t interval_ns = (policy->rate_per_second == 0) ? 0 : (SAMPLING_NS_PER_SECOND / policy->rate_per_second);
+
+    // Above one event per ns the interval rounds to 0, which would mean no limit
+    if(policy->rate_per_second != 0 && interval_ns == 0)
+        interval_ns = 1;
+
+    atomic_store_explicit(&slot->one_in_n, (policy->one_in_n <= 1u) ? 1u : policy->one_in_n, memory_order_relaxed);
+    atomic_store_explicit(&slot->threshold, (uint64_t)(policy->probability * (double)SAMPLING_KEEP_ALL_THRESHOLD),
+                          memory_order_relaxed);
+    atomic_store_explicit(&slot->tolerance_ns, (policy->burst == 0) ? 0 : (uint64_t)(policy->burst - 1u) * interval_ns,
+                          memory_order_relaxed);
+    // A new limit starts with a full bucket
+    atomic_store_explicit(&slot->arrival_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->interval_ns, interval_ns, memory_order_relaxed);
+
+    __atomic_fetch_or(&telemetry_event_sampling_active[event_id / 64u], bit, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/**
+ * @brief Returns how many events of an id were suppressed.
+ *
+ * @param event_id Event identifier.
+ * @return Suppressed events, 0 for ids that never had a policy.
+ */
+uint64_t telemetry_event_sampling_suppressed(uint32_t event_id)
+{
+    const size_t index = sampling_find_slot(event_id);
+
+    if(index == TELEMETRY_EVENT_SAMPLING_POLICIES)
+        return 0;
+
+    return sharded_counter_sum(atomic_load_explicit(&sampling_slots[index].suppressed, memory_order_acquire));
+}
+
+/**
+ * @brief Publishes the suppressed count of an id as a counter metric.
+ *
+ * The agent ships it with the other metrics; received events times
+ * (received + suppressed) / received estimates the produced count.
+ *
+ * @param metrics Registry the agent publishes.
+ * @param event_id Event identifier with a policy.
+ * @param metric_id Metric id for the counter.
+ * @return true on success.
+ */
+bool telemetry_event_sampling_register_metric(telemetry_metrics_t* metrics, uint32_t event_id, uint32_t metric_id)
+{
+    const size_t index = sampling_find_slot(event_id);
+
+    if(metrics == NULL || index == TELEMETRY_EVENT_SAMPLING_POLICIES)
+        return false;
+
+    sharded_counter_t* counter = atomic_load_explicit(&sampling_slots[index].suppressed, memory_order_acquire);
+
+    return (counter != NULL) && (telemetry_metrics_register_sharded(metrics, metric_id, counter) != NULL);
+}
+
+/**
+ * @brief Returns how many ids have had a policy.
+ *
+ * Slots are never released, so the count only grows; the agent compares it
+ * with the count it last published.
+ *
+ * @return Number of claimed slots.
+ */
+size_t telemetry_event_sampling_policy_count(void)
+{
+    return atomic_load_explicit(&sampling_slot_count, memory_order_acquire);
+}
+
+/**
+ * @brief Registers the suppressed counters of all ids that have had a policy.
+ *
+ * Each counter gets metric id TELEMETRY_SAMPLING_SUPPRESSED_METRIC_BASE +
+ * event id; ids already registered keep their handle.
+ *
+ * @param metrics Registry the agent publishes.
+ * @return Number of counters registered, less than the policy count if the registry is full.
+ */
+size_t telemetry_event_sampling_register_metrics(telemetry_metrics_t* metrics)
+{
+    size_t registered = 0;
+
+    if(metrics == NULL)
+        return 0;
+
+    for(size_t index = 0; index < TELEMETRY_EVENT_SAMPLING_POLICIES; index++)
+    {
+        const unsigned owner = atomic_load_explicit(&sampling_slots[index].owner, memory_order_acquire);
+
+        if(owner != 0 &&
+           telemetry_event_sampling_register_metric(metrics, owner - 1u, TELEMETRY_SAMPLING_SUPPRESSED_METRIC_BASE + (owner - 1u)))
+        {
+            registered++;
+        }
+    }
+
+    return registered;
+}
+
+/**
+ * @brief Applies the policy of an id to one event.
+ *
+ * @param event_id Event identifier whose active bit is set.
+ * @return true to keep the event, false if it was suppressed and counted.
+ */
+bool telemetry_event_sampling_decide(uint32_t event_id)
+{
+    const size_t index = sampling_find_slot(event_id);
+
+    if(index == TELEMETRY_EVENT_SAMPLING_POLICIES)
+        return true;
+
+    sampling_slot_t* slot = &sampling_slots[index];
+    bool keep = true;
+
+    const unsigned one_in_n = atomic_load_explicit(&slot->one_in_n, memory_order_relaxed);
+
+    if(one_in_n > 1u)
+    {
+        // Keeps the first event, then every n-th
+        if(thread_countdown[index] == 0)
+            thread_countdown[index] = one_in_n - 1u;
+        else
+        {
+            thread_countdown[index]--;
+            keep = false;
+        }
+    }
+
+    if(keep)
+    {
+        const uint64_t threshold = atomic_load_explicit(&slot->threshold, memory_order_relaxed);
+
+        if(threshold < SAMPLING_KEEP_ALL_THRESHOLD && (uint64_t)sampling_random() >= threshold)
+            keep = false;
+    }
+
+    if(keep)
+    {
+        const uint64_t interval_ns = atomic_load_explicit(&slot->interval_ns, memory_order_relaxed);
+
+        // Only events the samplers kept use up tokens
+        if(interval_ns != 0 && !sampling_take_token(slot, interval_ns))
+            keep = false;
+    }
+
+    if(!keep)
+    {
+        sharded_counter_t* counter = atomic_load_explicit(&slot->suppressed, memory_order_acquire);
+
+        if(counter != NULL)
+            sharded_counter_add(counter, 1);
+    }
+
+    return keep;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../api/type.h"
+#include "event_filter.h"
+#include "metrics.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Event ids that can have a sampling policy at the same time
+#ifndef TELEMETRY_EVENT_SAMPLING_POLICIES
+    #define TELEMETRY_EVENT_SAMPLING_POLICIES 64u
+#endif
+
+// Metric ids of the suppressed counters the agent publishes, base + event id
+#define TELEMETRY_SAMPLING_SUPPRESSED_METRIC_BASE 0xF0000000u
+
+/*
+ * Per event id sampling and rate limiting, checked by the emit paths after
+ * the filter of event_filter.h and before the event is built and pushed.
+ * Applies to ids below TELEMETRY_EVENT_FILTER_IDS.
+ *
+ * A policy keeps an event only if every configured stage keeps it:
+ * 1. one_in_n : every n-th event of each thread, starting with the first.
+ * 2. probability : a thread local xorshift generator, no shared state.
+ * 3. rate_per_second / burst : token bucket shared by all threads, one
+ *    compare and swap per kept event, on the precise monotonic clock.
+ * Every suppressed event is counted, so the collector can scale the
+ * received events back up. An agent with a metrics registry publishes the
+ * counter of every id that has had a policy under metric id
+ * TELEMETRY_SAMPLING_SUPPRESSED_METRIC_BASE + event id; ids from that base
+ * on are reserved for it.
+ *
+ * Ids without a policy cost one relaxed load of a bitmap word, like the
+ * filter. The words are accessed with the GCC __atomic builtins so the
+ * check can be inlined into C++ as well; use the functions below.
+ */
+extern uint64_t telemetry_event_sampling_active[TELEMETRY_EVENT_FILTER_WORDS];
+
+typedef struct telemetry_sampling_policy_s {
+    uint32_t one_in_n;          // Keep one event in n per thread, 0 or 1 keeps all
+    double probability;         // Keep an event with this probability, 1.0 keeps all
+    uint32_t rate_per_second;   // Token bucket refill rate, 0 for no rate limit
+    uint32_t burst;             // Events the bucket allows back to back, at least 1
+} telemetry_sampling_policy_t;
+
+// Fills a policy that keeps every event
+void telemetry_sampling_policy_init(telemetry_sampling_policy_t* policy);
+
+// Sets the policy of an id, NULL or a keep-all policy removes it. Returns false for ids outside the
+// filter, invalid values or when TELEMETRY_EVENT_SAMPLING_POLICIES other ids already have a policy.
+bool telemetry_event_sampling_set(uint32_t event_id, const telemetry_sampling_policy_t* policy);
+
+// Events of an id suppressed so far, cumulative for the lifetime of the process
+uint64_t telemetry_event_sampling_suppressed(uint32_t event_id);
+
+// Publishes the suppressed count of an id as a counter metric, the id needs a policy first
+bool telemetry_event_sampling_register_metric(telemetry_metrics_t* metrics, uint32_t event_id, uint32_t metric_id);
+
+// Number of ids that have had a policy, only grows
+size_t telemetry_event_sampling_policy_count(void);
+
+// Registers the suppressed counter of every id that has had a policy under its reserved metric id,
+// returns how many are registered. Called by the agent when the policy count changed.
+size_t telemetry_event_sampling_register_metrics(telemetry_metrics_t* metrics);
+
+// Slow path of telemetry_event_sampling_keep for ids with a policy
+bool telemetry_event_sampling_decide(uint32_t event_id);
+
+// Producer side : true if the event should be built and pushed
+static inline bool telemetry_event_sampling_keep(uint32_t event_id)
+{
+    if(event_id >= TELEMETRY_EVENT_FILTER_IDS)
+        return true;
+
+    const uint64_t word = __atomic_load_n(&telemetry_event_sampling_active[event_id / 64u], __ATOMIC_RELAXED);
+
+    if(((word >> (event_id % 64u)) & 1u) == 0)
+        return true;
+
+    return telemetry_event_sampling_decide(event_id);
+}
+
+
+#ifdef __cplusplus
+    }
+#endif
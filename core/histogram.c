@@ -0,0 +1,460 @@
+/**
+ * @file histogram.c
+ * @brief Log-linear latency histogram implementation.
+ *
+ * Bucket mapping, lock-free recording, snapshots, percentiles and the
+ * compact wire encoding.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+
+#include "histogram.h"
+#include "telemetry_protocol.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Struct declaration
+
+typedef struct telemetry_histogram_s {
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t sum;
+    atomic_uint_fast64_t min;
+    atomic_uint_fast64_t max;
+    atomic_uint_fast64_t buckets[TELEMETRY_HISTOGRAM_BUCKETS];
+} telemetry_histogram_t;
+
+// Local function definitions
+
+/**
+ * @brief Adds one to a counter owned by a single writer.
+ *
+ * A relaxed load and store is enough because no other thread writes it,
+ * and readers still see whole values.
+ *
+ * @param counter Counter to increment.
+ * @param delta Amount to add.
+ */
+static inline void single_writer_add(atomic_uint_fast64_t* counter, uint64_t delta)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + delta, memory_order_relaxed);
+}
+
+// Global function definitions
+
+/**
+ * @brief Returns the bucket holding a value.
+ *
+ * Values below the sub-bucket count map to themselves. Larger values use
+ * their bit length to pick the group and the next bits below the leading
+ * one to pick the linear sub-bucket.
+ *
+ * @param value Value to map.
+ * @return Bucket index, always below TELEMETRY_HISTOGRAM_BUCKETS.
+ */
+size_t telemetry_histogram_bucket_index(uint64_t value)
+{
+    if(value < TELEMETRY_HISTOGRAM_SUB_BUCKETS)
+    {
+        return (size_t)value;
+    }
+
+    const unsigned exponent = 63u - (unsigned)__builtin_clzll(value);
+    const unsigned shift = exponent - TELEMETRY_HISTOGRAM_SUB_BUCKET_BITS;
+    const size_t group = (size_t)shift + 1u;
+    const size_t sub_bucket = (size_t)(value >> shift) - TELEMETRY_HISTOGRAM_SUB_BUCKETS;
+
+    return (group * TELEMETRY_HISTOGRAM_SUB_BUCKETS) + sub_bucket;
+}
+
+/**
+ * @brief Returns the smallest value of a bucket.
+ *
+ * @param index Bucket index.
+ * @return Lowest value mapped to the bucket.
+ */
+uint64_t telemetry_histogram_bucket_lower(size_t index)
+{
+    const size_t group = index / TELEMETRY_HISTOGRAM_SUB_BUCKETS;
+    const uint64_t sub_bucket = index % TELEMETRY_HISTOGRAM_SUB_BUCKETS;
+
+    if(group == 0)
+    {
+        return sub_bucket;
+    }
+
+    return ((uint64_t)TELEMETRY_HISTOGRAM_SUB_BUCKETS + sub_bucket) << (group - 1u);
+}
+
+/**
+ * @brief Returns the largest value of a bucket.
+ *
+ * @param index Bucket index.
+ * @return Highest value mapped to the bucket.
+ */
+uint64_t telemetry_histogram_bucket_upper(size_t index)
+{
+    const size_t group = index / TELEMETRY_HISTOGRAM_SUB_BUCKETS;
+
+    if(group == 0)
+    {
+        return telemetry_histogram_bucket_lower(index);
+    }
+
+    return telemetry_histogram_bucket_lower(index) + ((1ull << (group - 1u)) - 1u);
+}
+
+/**
+ * @brief Initializes a histogram.
+ *
+ * All buckets are allocated here, recording never allocates.
+ *
+ * @param out_histogram Receives the histogram.
+ * @return true on success, false on failure.
+ */
+bool telemetry_histogram_init(telemetry_histogram_t** out_histogram)
+{
+    if(out_histogram == NULL)
+    {
+        return false;
+    }
+
+    telemetry_histogram_t* histogram = (telemetry_histogram_t*)calloc(1, sizeof(*histogram));
+
+    if(histogram == NULL)
+    {
+        return false;
+    }
+
+    atomic_init(&histogram->count, 0);
+    atomic_init(&histogram->sum, 0);
+    atomic_init(&histogram->min, UINT64_MAX);
+    atomic_init(&histogram->max, 0);
+
+    for(size_t index = 0; index < TELEMETRY_HISTOGRAM_BUCKETS; index++)
+    {
+        atomic_init(&histogram->buckets[index], 0);
+    }
+
+    *out_histogram = histogram;
+
+    return true;
+}
+
+/**
+ * @brief Frees a histogram.
+ *
+ * @param histogram Histogram instance.
+ */
+void telemetry_histogram_free(telemetry_histogram_t* histogram)
+{
+    free(histogram);
+}
+
+/**
+ * @brief Records a value from the single writer thread.
+ *
+ * Uses relaxed loads and stores only, no read-modify-write instructions.
+ *
+ * @param histogram Histogram instance.
+ * @param value Value to record.
+ */
+void telemetry_histogram_record(telemetry_histogram_t* histogram, uint64_t value)
+{
+    if(histogram == NULL)
+        return;
+
+    // Bounds first, a reader that sees the bucket usually sees them too; the snapshot clamps the rest
+    if(value < atomic_load_explicit(&histogram->min, memory_order_relaxed))
+    {
+        atomic_store_explicit(&histogram->min, value, memory_order_relaxed);
+    }
+
+    if(value > atomic_load_explicit(&histogram->max, memory_order_relaxed))
+    {
+        atomic_store_explicit(&histogram->max, value, memory_order_relaxed);
+    }
+
+    single_writer_add(&histogram->buckets[telemetry_histogram_bucket_index(value)], 1);
+    single_writer_add(&histogram->sum, value);
+    single_writer_add(&histogram->count, 1);
+}
+
+/**
+ * @brief Records a value when several threads write the histogram.
+ *
+ * @param histogram Histogram instance.
+ * @param value Value to record.
+ */
+void telemetry_histogram_record_shared(telemetry_histogram_t* histogram, uint64_t value)
+{
+    if(histogram == NULL)
+        return;
+
+    // Lower the minimum if needed
+    uint64_t current = atomic_load_explicit(&histogram->min, memory_order_relaxed);
+    while(value < current &&
+          !atomic_compare_exchange_weak_explicit(&histogram->min, &current, value, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+
+    // Raise the maximum if needed
+    current = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    while(value > current &&
+          !atomic_compare_exchange_weak_explicit(&histogram->max, &current, value, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+
+    atomic_fetch_add_explicit(&histogram->buckets[telemetry_histogram_bucket_index(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Copies the current state of a histogram.
+ *
+ * The count is recomputed from the copied buckets, so percentiles of the
+ * snapshot are consistent even if the writer was recording meanwhile. For
+ * the same reason min and max are kept inside the first and last non-empty
+ * copied buckets: a bound the writer has not stored yet is taken from the
+ * bucket instead.
+ *
+ * @param histogram Histogram instance.
+ * @param out Receives the copy.
+ */
+void telemetry_histogram_snapshot(const telemetry_histogram_t* histogram, telemetry_histogram_snapshot_t* out)
+{
+    if(histogram == NULL || out == NULL)
+        return;
+
+    uint64_t count = 0;
+    size_t first = TELEMETRY_HISTOGRAM_BUCKETS;
+    size_t last = 0;
+
+    for(size_t index = 0; index < TELEMETRY_HISTOGRAM_BUCKETS; index++)
+    {
+        out->buckets[index] = atomic_load_explicit(&histogram->buckets[index], memory_order_relaxed);
+        count += out->buckets[index];
+
+        if(out->buckets[index] != 0)
+        {
+            if(first == TELEMETRY_HISTOGRAM_BUCKETS)
+                first = index;
+
+            last = index;
+        }
+    }
+
+    out->count = count;
+    out->sum = atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+    out->min = 0;
+    out->max = 0;
+
+    if(count == 0)
+        return;
+
+    // The smallest copied value lies in the first non-empty bucket, the largest in the last
+    const uint64_t min = atomic_load_explicit(&histogram->min, memory_order_relaxed);
+    const uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+
+    out->min = (min < telemetry_histogram_bucket_lower(first) || min > telemetry_histogram_bucket_upper(first)) ?
+               telemetry_histogram_bucket_lower(first) : min;
+    out->max = (max < telemetry_histogram_bucket_lower(last) || max > telemetry_histogram_bucket_upper(last)) ?
+               telemetry_histogram_bucket_upper(last) : max;
+}
+
+/**
+ * @brief Adds one snapshot into another.
+ *
+ * Snapshots from different threads, intervals or devices merge exactly
+ * because they share the same bucket layout.
+ *
+ * @param dst Snapshot to add to.
+ * @param src Snapshot to add.
+ */
+void telemetry_histogram_snapshot_merge(telemetry_histogram_snapshot_t* dst, const telemetry_histogram_snapshot_t* src)
+{
+    if(dst == NULL || src == NULL || src->count == 0)
+        return;
+
+    for(size_t index = 0; index < TELEMETRY_HISTOGRAM_BUCKETS; index++)
+    {
+        dst->buckets[index] += src->buckets[index];
+    }
+
+    if(dst->count == 0 || src->min < dst->min)
+    {
+        dst->min = src->min;
+    }
+
+    if(src->max > dst->max)
+    {
+        dst->max = src->max;
+    }
+
+    dst->count += src->count;
+    dst->sum += src->sum;
+}
+
+/**
+ * @brief Returns the value at a percentile.
+ *
+ * The result is the highest value of the bucket holding the requested
+ * rank, clamped to the recorded min and max.
+ *
+ * @param snapshot Snapshot to query.
+ * @param percentile Percentile from 0 to 100.
+ * @return Value at the percentile, 0 for an empty snapshot.
+ */
+uint64_t telemetry_histogram_snapshot_percentile(const telemetry_histogram_snapshot_t* snapshot, double percentile)
+{
+    if(snapshot == NULL || snapshot->count == 0)
+        return 0;
+
+    if(percentile < 0.0)
+        percentile = 0.0;
+
+    if(percentile > 100.0)
+        percentile = 100.0;
+
+    // Rank of the sample we are looking for, at least the first one
+    uint64_t rank = (uint64_t)((percentile / 100.0) * (double)snapshot->count + 0.5);
+    if(rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+
+    for(size_t index = 0; index < TELEMETRY_HISTOGRAM_BUCKETS; index++)
+    {
+        seen += snapshot->buckets[index];
+
+        if(seen >= rank)
+        {
+            uint64_t value = telemetry_histogram_bucket_upper(index);
+
+            if(value > snapshot->max)
+                value = snapshot->max;
+
+            if(value < snapshot->min)
+                value = snapshot->min;
+
+            return value;
+        }
+    }
+
+    return snapshot->max;
+}
+
+/**
+ * @brief Encodes a snapshot.
+ *
+ * Only non-empty buckets are written, with the index stored as the
+ * distance from the previous one, so typical latency histograms take a few
+ * dozen bytes.
+ *
+ * @param snapshot Snapshot to encode.
+ * @param encoded_buffer Output buffer.
+ * @param buffer_capacity Output buffer size.
+ * @return Bytes written, 0 if the buffer is too small.
+ */
+size_t telemetry_histogram_encode(const telemetry_histogram_snapshot_t* snapshot, uint8_t* encoded_buffer, size_t buffer_capacity)
+{
+    size_t position = 0;
+
+    if(snapshot == NULL || encoded_buffer == NULL || buffer_capacity < 1)
+        return 0;
+
+    // Layout marker, a decoder with a different layout rejects the data
+    encoded_buffer[position++] = (uint8_t)TELEMETRY_HISTOGRAM_SUB_BUCKET_BITS;
+
+    size_t non_empty = 0;
+    for(size_t index = 0; index < TELEMETRY_HISTOGRAM_BUCKETS; index++)
+    {
+        if(snapshot->buckets[index] != 0)
+            non_empty++;
+    }
+
+    if(!telemetry_append_varint(encoded_buffer, buffer_capacity, &position, snapshot->count) ||
+       !telemetry_append_varint(encoded_buffer, buffer_capacity, &position, snapshot->sum) ||
+       !telemetry_append_varint(encoded_buffer, buffer_capacity, &position, snapshot->min) ||
+       !telemetry_append_varint(encoded_buffer, buffer_capacity, &position, snapshot->max) ||
+       !telemetry_append_varint(encoded_buffer, buffer_capacity, &position, non_empty))
+    {
+        return 0;
+    }
+
+    size_t next_index = 0;
+
+    for(size_t index = 0; index < TELEMETRY_HISTOGRAM_BUCKETS; index++)
+    {
+        if(snapshot->buckets[index] == 0)
+            continue;
+
+        if(!telemetry_append_varint(encoded_buffer, buffer_capacity, &position, index - next_index) ||
+           !telemetry_append_varint(encoded_buffer, buffer_capacity, &position, snapshot->buckets[index]))
+        {
+            return 0;
+        }
+
+        next_index = index + 1;
+    }
+
+    return position;
+}
+
+/**
+ * @brief Decodes a snapshot.
+ *
+ * @param snapshot Receives the snapshot.
+ * @param buffer Input buffer.
+ * @param buffer_length Readable bytes.
+ * @return Bytes consumed, 0 on error.
+ */
+size_t telemetry_histogram_decode(telemetry_histogram_snapshot_t* snapshot, const uint8_t* buffer, size_t buffer_length)
+{
+    size_t position = 0;
+    uint64_t non_empty = 0;
+
+    if(snapshot == NULL || buffer == NULL || buffer_length < 1)
+        return 0;
+
+    if(buffer[position++] != (uint8_t)TELEMETRY_HISTOGRAM_SUB_BUCKET_BITS)
+        return 0;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    if(!telemetry_read_varint(&snapshot->count, buffer, buffer_length, &position) ||
+       !telemetry_read_varint(&snapshot->sum, buffer, buffer_length, &position) ||
+       !telemetry_read_varint(&snapshot->min, buffer, buffer_length, &position) ||
+       !telemetry_read_varint(&snapshot->max, buffer, buffer_length, &position) ||
+       !telemetry_read_varint(&non_empty, buffer, buffer_length, &position))
+    {
+        return 0;
+    }
+
+    uint64_t next_index = 0;
+
+    for(uint64_t bucket = 0; bucket < non_empty; bucket++)
+    {
+        uint64_t delta = 0;
+        uint64_t count = 0;
+
+        if(!telemetry_read_varint(&delta, buffer, buffer_length, &position) ||
+           !telemetry_read_varint(&count, buffer, buffer_length, &position))
+        {
+            return 0;
+        }
+
+        const uint64_t index = next_index + delta;
+
+        if(index >= TELEMETRY_HISTOGRAM_BUCKETS)
+            return 0;
+
+        snapshot->buckets[index] = count;
+        next_index = index + 1;
+    }
+
+    return position;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file histogram.h
+ * @brief Fixed-memory log-linear latency histogram.
+ *
+ * Values are grouped by power of two, and every power of two is split into
+ * 2^TELEMETRY_HISTOGRAM_SUB_BUCKET_BITS linear sub-buckets, so the bucket
+ * width is at most 1/16 of the value with the default setting. The whole
+ * 64-bit range is covered with a fixed bucket array; recording is O(1) and
+ * never allocates.
+ *
+ * Concurrency: telemetry_histogram_record() is for a single writer thread
+ * and uses plain relaxed stores; any number of threads may take snapshots
+ * at the same time. telemetry_histogram_record_shared() allows several
+ * writers at the cost of atomic read-modify-write operations.
+ *
+ * Wire encoding (used inside metrics batches, varints are LEB128):
+ * u8 sub-bucket bits, varint count, sum, min, max, varint number of
+ * non-empty buckets, then (varint index delta, varint bucket count) pairs.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../api/type.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Linear sub-buckets per power of two, as a number of bits
+#ifndef TELEMETRY_HISTOGRAM_SUB_BUCKET_BITS
+    #define TELEMETRY_HISTOGRAM_SUB_BUCKET_BITS 4
+#endif
+
+#define TELEMETRY_HISTOGRAM_SUB_BUCKETS     (1u << TELEMETRY_HISTOGRAM_SUB_BUCKET_BITS)
+
+// Values below SUB_BUCKETS are exact, then one group per remaining bit length
+#define TELEMETRY_HISTOGRAM_BUCKETS         ((64u - TELEMETRY_HISTOGRAM_SUB_BUCKET_BITS + 1u) * TELEMETRY_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct telemetry_histogram_s telemetry_histogram_t;
+
+// Plain copy of a histogram, safe to read, merge and encode without atomics
+typedef struct telemetry_histogram_snapshot_s {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;               // 0 when count is 0
+    uint64_t max;
+    uint64_t buckets[TELEMETRY_HISTOGRAM_BUCKETS];
+} telemetry_histogram_snapshot_t;
+
+
+// global histogram functions
+bool telemetry_histogram_init(telemetry_histogram_t** out_histogram);
+void telemetry_histogram_free(telemetry_histogram_t* histogram);
+
+// Writer thread : record one value
+void telemetry_histogram_record(telemetry_histogram_t* histogram, uint64_t value);
+
+// Any thread : record one value when several threads share the histogram
+void telemetry_histogram_record_shared(telemetry_histogram_t* histogram, uint64_t value);
+
+// Reader threads : copy the current state
+void telemetry_histogram_snapshot(const telemetry_histogram_t* histogram, telemetry_histogram_snapshot_t* out);
+
+
+// Snapshot functions
+void telemetry_histogram_snapshot_merge(telemetry_histogram_snapshot_t* dst, const telemetry_histogram_snapshot_t* src);
+uint64_t telemetry_histogram_snapshot_percentile(const telemetry_histogram_snapshot_t* snapshot, double percentile);
+
+size_t telemetry_histogram_encode(const telemetry_histogram_snapshot_t* snapshot, uint8_t* encoded_buffer, size_t buffer_capacity);
+size_t telemetry_histogram_decode(telemetry_histogram_snapshot_t* snapshot, const uint8_t* buffer, size_t buffer_length);
+
+
+// Helper functions
+size_t telemetry_histogram_bucket_index(uint64_t value);
+uint64_t telemetry_histogram_bucket_lower(size_t index);
+uint64_t telemetry_histogram_bucket_upper(size_t index);
+
+
+#ifdef __cplusplus
+    }
+#endif
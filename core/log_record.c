@@ -0,0 +1,484 @@
+/**
+ * @file log_record.c
+ * @brief Deferred-format log event encoding and offline formatting.
+ *
+ * Argument packing used by the logging front end, the dictionary event
+ * encoding, and the printf style formatter used by the receiving tools.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+
+#include "log_record.h"
+#include "telemetry_protocol.h"
+#include "byte_order.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Largest conversion specification copied for snprintf, e.g. "%-+#012.6ll" plus the conversion
+#define LOG_SPEC_MAX 32u
+
+// Local function definitions
+
+/**
+ * @brief Appends formatted text, keeping the output NUL terminated.
+ *
+ * @param output Output buffer.
+ * @param output_capacity Output buffer size, not 0.
+ * @param position Current length, advanced by the text that fit.
+ * @param format printf format.
+ */
+static void append_text(char* output, size_t output_capacity, size_t* position, const char* format, ...)
+{
+    if(*position + 1u >= output_capacity)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    const int written = vsnprintf(&output[*position], output_capacity - *position, format, args);
+    va_end(args);
+
+    if(written <= 0)
+        return;
+
+    // Truncated output stops at the end of the buffer
+    if((size_t)written >= output_capacity - *position)
+        *position = output_capacity - 1u;
+    else
+        *position += (size_t)written;
+}
+
+/**
+ * @brief Appends one argument for a conversion specification.
+ *
+ * The flags, width and precision of the specification are kept, its
+ * length modifier is replaced by the one matching the packed type.
+ *
+ * @param output Output buffer.
+ * @param output_capacity Output buffer size.
+ * @param position Current length.
+ * @param spec Specification without length modifier and conversion, starts with '%'.
+ * @param conversion Conversion character.
+ * @param arg_type Packed type.
+ * @param args Packed arguments, advanced past the argument.
+ * @param args_length Remaining packed bytes, reduced by the argument.
+ * @return false if the argument is missing or damaged.
+ */
+static bool append_argument(char* output, size_t output_capacity, size_t* position,
+                            const char* spec, char conversion, uint8_t arg_type,
+                            const uint8_t** args, size_t* args_length)
+{
+    char full_spec[LOG_SPEC_MAX + 4u];
+    uint64_t value = 0;
+    size_t consumed = 0;
+
+    switch(arg_type)
+    {
+        case TELEMETRY_LOG_ARG_UNSIGNED:
+        case TELEMETRY_LOG_ARG_SIGNED:
+        case TELEMETRY_LOG_ARG_POINTER:
+        {
+            consumed = telemetry_decode_varint(&value, *args, *args_length);
+            if(consumed == 0)
+                return false;
+
+            // Undo the zigzag mapping
+            const int64_t signed_value = (int64_t)(value >> 1) ^ -(int64_t)(value & 1u);
+
+            if(arg_type == TELEMETRY_LOG_ARG_SIGNED)
+                value = (uint64_t)signed_value;
+
+            if(conversion == 'c')
+            {
+                snprintf(full_spec, sizeof(full_spec), "%sc", spec);
+                append_text(output, output_capacity, position, full_spec, (int)value);
+            }
+            else if(conversion == 'p' || (arg_type == TELEMETRY_LOG_ARG_POINTER && strchr("diuoxX", conversion) == NULL))
+            {
+                snprintf(full_spec, sizeof(full_spec), "%sp", spec);
+                append_text(output, output_capacity, position, full_spec, (void*)(uintptr_t)value);
+            }
+            else if(strchr("uoxX", conversion) != NULL)
+            {
+                snprintf(full_spec, sizeof(full_spec), "%sll%c", spec, conversion);
+                append_text(output, output_capacity, position, full_spec, (unsigned long long)value);
+            }
+            else if(strchr("di", conversion) != NULL || arg_type == TELEMETRY_LOG_ARG_SIGNED)
+            {
+                snprintf(full_spec, sizeof(full_spec), "%slld", spec);
+                append_text(output, output_capacity, position, full_spec, (long long)value);
+            }
+            else
+            {
+                snprintf(full_spec, sizeof(full_spec), "%sllu", spec);
+                append_text(output, output_capacity, position, full_spec, (unsigned long long)value);
+            }
+            break;
+        }
+
+        case TELEMETRY_LOG_ARG_FLOAT:
+        case TELEMETRY_LOG_ARG_DOUBLE:
+        {
+            double number;
+            consumed = (arg_type == TELEMETRY_LOG_ARG_FLOAT) ? 4u : 8u;
+
+            if(*args_length < consumed)
+                return false;
+
+            if(arg_type == TELEMETRY_LOG_ARG_FLOAT)
+            {
+                const uint32_t bits = telemetry_get_u32_be(*args);
+                float single;
+                memcpy(&single, &bits, sizeof(single));
+                number = (double)single;
+            }
+            else
+            {
+                const uint64_t bits = telemetry_get_u64_be(*args);
+                memcpy(&number, &bits, sizeof(number));
+            }
+
+            const char shown = (strchr("fFeEgGaA", conversion) != NULL) ? conversion : 'g';
+            snprintf(full_spec, sizeof(full_spec), "%s%c", spec, shown);
+            append_text(output, output_capacity, position, full_spec, number);
+            break;
+        }
+
+        case TELEMETRY_LOG_ARG_STRING:
+        {
+            char text[TELEMETRY_EVENT_PAYLOAD_MAX + 1u];
+
+            consumed = telemetry_decode_varint(&value, *args, *args_length);
+            if(consumed == 0 || value > *args_length - consumed || value >= sizeof(text))
+                return false;
+
+            memcpy(text, *args + consumed, (size_t)value);
+            text[value] = '\0';
+            consumed += (size_t)value;
+
+            snprintf(full_spec, sizeof(full_spec), "%ss", spec);
+            append_text(output, output_capacity, position, full_spec, text);
+            break;
+        }
+
+        default:
+            return false;
+    }
+
+    *args += consumed;
+    *args_length -= consumed;
+
+    return true;
+}
+
+
+// Function definitions
+
+/**
+ * @brief Packs an unsigned integer.
+ *
+ * @param buffer Output buffer.
+ * @param buffer_capacity Output buffer size.
+ * @param value Value to pack.
+ * @return Bytes written, 0 if it does not fit.
+ */
+size_t telemetry_log_put_unsigned(uint8_t* buffer, size_t buffer_capacity, uint64_t value)
+{
+    if(buffer == NULL)
+        return 0;
+
+    return telemetry_encode_varint(buffer, buffer_capacity, value);
+}
+
+/**
+ * @brief Packs a signed integer, small magnitudes take few bytes.
+ *
+ * @param buffer Output buffer.
+ * @param buffer_capacity Output buffer size.
+ * @param value Value to pack.
+ * @return Bytes written, 0 if it does not fit.
+ */
+size_t telemetry_log_put_signed(uint8_t* buffer, size_t buffer_capacity, int64_t value)
+{
+    const uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+
+    return telemetry_log_put_unsigned(buffer, buffer_capacity, zigzag);
+}
+
+/**
+ * @brief Packs a float.
+ *
+ * @param buffer Output buffer.
+ * @param buffer_capacity Output buffer size.
+ * @param value Value to pack.
+ * @return Bytes written, 0 if it does not fit.
+ */
+size_t telemetry_log_put_float(uint8_t* buffer, size_t buffer_capacity, float value)
+{
+    uint32_t bits;
+
+    if(buffer == NULL || buffer_capacity < sizeof(bits))
+        return 0;
+
+    memcpy(&bits, &value, sizeof(bits));
+    telemetry_put_u32_be(buffer, bits);
+
+    return sizeof(bits);
+}
+
+/**
+ * @brief Packs a double.
+ *
+ * @param buffer Output buffer.
+ * @param buffer_capacity Output buffer size.
+ * @param value Value to pack.
+ * @return Bytes written, 0 if it does not fit.
+ */
+size_t telemetry_log_put_double(uint8_t* buffer, size_t buffer_capacity, double value)
+{
+    uint64_t bits;
+
+    if(buffer == NULL || buffer_capacity < sizeof(bits))
+        return 0;
+
+    memcpy(&bits, &value, sizeof(bits));
+    telemetry_put_u64_be(buffer, bits);
+
+    return sizeof(bits);
+}
+
+/**
+ * @brief Packs a string, truncating it to the space left.
+ *
+ * @param buffer Output buffer.
+ * @param buffer_capacity Output buffer size.
+ * @param value String bytes, may be NULL.
+ * @param length Number of bytes.
+ * @return Bytes written, 0 if not even the length fits.
+ */
+size_t telemetry_log_put_string(uint8_t* buffer, size_t buffer_capacity, const char* value, size_t length)
+{
+    if(buffer == NULL || buffer_capacity == 0)
+        return 0;
+
+    if(value == NULL)
+        length = 0;
+
+    size_t header;
+
+    // Shorten the string until the length and the bytes fit
+    while(1)
+    {
+        header = telemetry_encode_varint(buffer, buffer_capacity, length);
+        if(header == 0)
+            return 0;
+
+        if(length <= buffer_capacity - header)
+            break;
+
+        length = buffer_capacity - header;
+    }
+
+    if(length > 0)
+        memcpy(&buffer[header], value, length);
+
+    return header + length;
+}
+
+/**
+ * @brief Encodes one dictionary event payload.
+ *
+ * @param encoded_buffer Output buffer, normally the event payload.
+ * @param buffer_capacity Output buffer size.
+ * @param entry Format id, types and the chunk to write.
+ * @param chunk_written Receives how many chunk bytes fit.
+ * @return Bytes written, 0 on invalid input or if the header does not fit.
+ */
+size_t telemetry_log_dictionary_encode(uint8_t* encoded_buffer, size_t buffer_capacity,
+                                       const telemetry_log_dictionary_t* entry, size_t* chunk_written)
+{
+    size_t position = 0;
+    size_t written;
+
+    if(encoded_buffer == NULL || entry == NULL || chunk_written == NULL || entry->arg_count > TELEMETRY_LOG_MAX_ARGS)
+        return 0;
+
+    if(entry->chunk_length > 0 && entry->chunk == NULL)
+        return 0;
+
+    const uint64_t fields[3] = { entry->format_id, entry->format_length, entry->offset };
+
+    for(size_t index = 0; index < 3u; index++)
+    {
+        written = telemetry_encode_varint(&encoded_buffer[position], buffer_capacity - position, fields[index]);
+        if(written == 0)
+            return 0;
+
+        position += written;
+    }
+
+    if(buffer_capacity - position < 1u + entry->arg_count)
+        return 0;
+
+    encoded_buffer[position++] = entry->arg_count;
+    memcpy(&encoded_buffer[position], entry->arg_types, entry->arg_count);
+    position += entry->arg_count;
+
+    // The chunk fills the rest
+    size_t chunk_length = entry->chunk_length;
+    if(chunk_length > buffer_capacity - position)
+        chunk_length = buffer_capacity - position;
+
+    if(chunk_length > 0)
+        memcpy(&encoded_buffer[position], entry->chunk, chunk_length);
+
+    *chunk_written = chunk_length;
+
+    return position + chunk_length;
+}
+
+/**
+ * @brief Decodes one dictionary event payload.
+ *
+ * @param entry Receives the fields, the chunk points into buffer.
+ * @param buffer Payload bytes.
+ * @param buffer_length Payload size.
+ * @return true on success, false if the payload is malformed.
+ */
+bool telemetry_log_dictionary_decode(telemetry_log_dictionary_t* entry, const uint8_t* buffer, size_t buffer_length)
+{
+    uint64_t fields[3];
+    size_t position = 0;
+
+    if(entry == NULL || buffer == NULL)
+        return false;
+
+    for(size_t index = 0; index < 3u; index++)
+    {
+        const size_t consumed = telemetry_decode_varint(&fields[index], &buffer[position], buffer_length - position);
+        if(consumed == 0 || fields[index] > UINT32_MAX)
+            return false;
+
+        position += consumed;
+    }
+
+    if(position >= buffer_length)
+        return false;
+
+    const uint8_t arg_count = buffer[position++];
+    if(arg_count > TELEMETRY_LOG_MAX_ARGS || buffer_length - position < arg_count)
+        return false;
+
+    entry->format_id = (uint32_t)fields[0];
+    entry->format_length = (uint32_t)fields[1];
+    entry->offset = (uint32_t)fields[2];
+    entry->arg_count = arg_count;
+    memcpy(entry->arg_types, &buffer[position], arg_count);
+    position += arg_count;
+
+    entry->chunk = (const char*)&buffer[position];
+    entry->chunk_length = buffer_length - position;
+
+    // A chunk past the end of the format is damaged
+    if(entry->offset > entry->format_length || entry->chunk_length > entry->format_length - entry->offset)
+        return false;
+
+    return true;
+}
+
+/**
+ * @brief Formats a log event as text.
+ *
+ * Supports the printf conversions d i u o x X c p f F e E g G a A s with
+ * flags, width and precision; length modifiers are ignored because the
+ * packed type decides. '*' width or precision is not supported and is
+ * printed as written.
+ *
+ * @param output Output buffer.
+ * @param output_capacity Output buffer size.
+ * @param format Format string from the dictionary, NUL terminated.
+ * @param arg_types Argument types from the dictionary.
+ * @param arg_count Number of arguments.
+ * @param args Log event payload.
+ * @param args_length Payload size.
+ * @return Length of the text, 0 on invalid input.
+ */
+size_t telemetry_log_format(char* output, size_t output_capacity, const char* format,
+                            const uint8_t* arg_types, size_t arg_count,
+                            const uint8_t* args, size_t args_length)
+{
+    size_t position = 0;
+    size_t arg_index = 0;
+
+    if(output == NULL || output_capacity == 0 || format == NULL || (arg_count > 0 && arg_types == NULL))
+        return 0;
+
+    output[0] = '\0';
+
+    if(args == NULL)
+        args_length = 0;
+
+    const char* cursor = format;
+
+    while(*cursor != '\0' && position + 1u < output_capacity)
+    {
+        if(*cursor != '%')
+        {
+            output[position++] = *cursor++;
+            continue;
+        }
+
+        if(cursor[1] == '%')
+        {
+            output[position++] = '%';
+            cursor += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision, skip the length modifier
+        char spec[LOG_SPEC_MAX];
+        size_t spec_length = 0;
+        const char* start = cursor;
+
+        spec[spec_length++] = *cursor++;
+        while(*cursor != '\0' && strchr("-+ #0123456789.", *cursor) != NULL && spec_length < LOG_SPEC_MAX - 1u)
+        {
+            spec[spec_length++] = *cursor++;
+        }
+        spec[spec_length] = '\0';
+
+        while(*cursor != '\0' && strchr("hlLqjzt", *cursor) != NULL)
+        {
+            cursor++;
+        }
+
+        const char conversion = *cursor;
+
+        if(conversion == '\0' || strchr("diuoxXcpfFeEgGaAs", conversion) == NULL)
+        {
+            // Not a conversion this formatter knows, print it as written
+            const size_t literal = (size_t)(cursor - start) + ((conversion != '\0') ? 1u : 0u);
+            append_text(output, output_capacity, &position, "%.*s", (int)literal, start);
+            cursor = start + literal;
+            continue;
+        }
+
+        cursor++;
+
+        if(arg_index >= arg_count ||
+           !append_argument(output, output_capacity, &position, spec, conversion, arg_types[arg_index], &args, &args_length))
+        {
+            append_text(output, output_capacity, &position, "<?>");
+            // A damaged argument makes the rest unreadable
+            args_length = 0;
+        }
+
+        arg_index++;
+    }
+
+    output[position] = '\0';
+
+    return position;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file log_record.h
+ * @brief Binary encoding of deferred-format log events.
+ *
+ * A log call site sends only an id for its format string and its
+ * arguments in binary form. The format strings travel once, as dictionary
+ * events, and the receiving side formats the text offline.
+ *
+ * Log event: event_id is TELEMETRY_LOG_EVENT_ID_BASE + format id, the
+ * payload holds the arguments in call order (varints are LEB128, floating
+ * point values are IEEE 754 bits written big-endian):
+ * - TELEMETRY_LOG_ARG_UNSIGNED, TELEMETRY_LOG_ARG_POINTER : varint
+ * - TELEMETRY_LOG_ARG_SIGNED : zigzag varint
+ * - TELEMETRY_LOG_ARG_FLOAT : 4 bytes, TELEMETRY_LOG_ARG_DOUBLE : 8 bytes
+ * - TELEMETRY_LOG_ARG_STRING : varint length, then the bytes, truncated to
+ *   what fits in the payload
+ *
+ * Dictionary event: event_id is TELEMETRY_LOG_DICTIONARY_EVENT_ID, the
+ * payload is varint format id, varint format length, varint chunk offset,
+ * u8 argument count, one byte per argument type, then the chunk of the
+ * format string (the rest of the payload, not NUL terminated). Long
+ * formats are split over several dictionary events.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>         // int64_t
+#include "event.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Event carrying a chunk of the format dictionary
+#define TELEMETRY_LOG_DICTIONARY_EVENT_ID   (TELEMETRY_EVENT_ID_RESERVED_BASE + 0x01u)
+// Log events use TELEMETRY_LOG_EVENT_ID_BASE + format id
+#define TELEMETRY_LOG_EVENT_ID_BASE         (TELEMETRY_EVENT_ID_RESERVED_BASE + 0x01000000u)
+// Largest format id, format ids start at 1
+#define TELEMETRY_LOG_MAX_FORMAT_ID         0x00FFFFFFu
+// Largest number of arguments of one log call
+#define TELEMETRY_LOG_MAX_ARGS              16u
+
+// How an argument is packed
+typedef enum telemetry_log_arg_e {
+    TELEMETRY_LOG_ARG_UNSIGNED  = 1,
+    TELEMETRY_LOG_ARG_SIGNED    = 2,
+    TELEMETRY_LOG_ARG_FLOAT     = 3,
+    TELEMETRY_LOG_ARG_DOUBLE    = 4,
+    TELEMETRY_LOG_ARG_STRING    = 5,
+    TELEMETRY_LOG_ARG_POINTER   = 6
+} telemetry_log_arg_t;
+
+// One dictionary event, the chunk points into the encoded payload after decoding
+typedef struct telemetry_log_dictionary_s {
+    uint32_t format_id;
+    uint32_t format_length;     // Length of the whole format string
+    uint32_t offset;            // Position of the chunk in the format string
+    uint8_t arg_count;
+    uint8_t arg_types[TELEMETRY_LOG_MAX_ARGS];
+    const char* chunk;
+    size_t chunk_length;
+} telemetry_log_dictionary_t;
+
+
+// Event id of a format id
+static inline uint32_t telemetry_log_event_id(uint32_t format_id)
+{
+    return TELEMETRY_LOG_EVENT_ID_BASE + format_id;
+}
+
+// Returns true and the format id if the event id belongs to a log event
+static inline bool telemetry_log_format_id(uint32_t event_id, uint32_t* format_id)
+{
+    if(event_id <= TELEMETRY_LOG_EVENT_ID_BASE || event_id > TELEMETRY_LOG_EVENT_ID_BASE + TELEMETRY_LOG_MAX_FORMAT_ID)
+        return false;
+
+    *format_id = event_id - TELEMETRY_LOG_EVENT_ID_BASE;
+    return true;
+}
+
+
+// Argument packing, each returns bytes written or 0 if the value does not fit
+size_t telemetry_log_put_unsigned(uint8_t* buffer, size_t buffer_capacity, uint64_t value);
+size_t telemetry_log_put_signed(uint8_t* buffer, size_t buffer_capacity, int64_t value);
+size_t telemetry_log_put_float(uint8_t* buffer, size_t buffer_capacity, float value);
+size_t telemetry_log_put_double(uint8_t* buffer, size_t buffer_capacity, double value);
+
+// Strings longer than the remaining space are truncated, NULL is packed as an empty string
+size_t telemetry_log_put_string(uint8_t* buffer, size_t buffer_capacity, const char* value, size_t length);
+
+
+// Dictionary functions
+
+// Writes the entry header and as much of its chunk as fits, *chunk_written receives the chunk bytes written.
+// Returns bytes written, 0 if not even the header fits.
+size_t telemetry_log_dictionary_encode(uint8_t* encoded_buffer, size_t buffer_capacity,
+                                       const telemetry_log_dictionary_t* entry, size_t* chunk_written);
+
+bool telemetry_log_dictionary_decode(telemetry_log_dictionary_t* entry, const uint8_t* buffer, size_t buffer_length);
+
+
+// Formats a log event as text like snprintf, the output is always NUL terminated.
+// Arguments missing from the payload print as "<?>". Returns the length of the text written.
+size_t telemetry_log_format(char* output, size_t output_capacity, const char* format,
+                            const uint8_t* arg_types, size_t arg_count,
+                            const uint8_t* args, size_t args_length);
+
+
+#ifdef __cplusplus
+    }
+#endif
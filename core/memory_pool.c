@@ -0,0 +1,736 @@
+/**
+ * @file memory_pool.c
+ * @brief Lock-free fixed size block pool.
+ *
+ * The shared free list is a Treiber stack of block indices. Its head packs
+ * the top index + 1 in the low 32 bits and a tag in the high 32 bits that
+ * every change increments, so a pop that read a stale next link fails its
+ * compare and swap. Links live in a separate array, never in the blocks,
+ * so a block is all payload and a stale read never touches user data.
+ *
+ * Magazines are owned by one thread each. A thread exit destructor gives
+ * them back; it only touches pools still in the live pool registry, so a
+ * thread may outlive the pools it used.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include "memory_pool.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#define MEMORY_POOL_CACHE_LINE 64u
+
+// Struct declaration
+
+typedef struct memory_pool_magazine_s {
+    _Alignas(MEMORY_POOL_CACHE_LINE) atomic_uint_fast64_t owner;  // Thread token, 0 when free
+    atomic_uint count;              // Written by the owner only, read by the statistics
+    uint32_t blocks[MEMORY_POOL_MAGAZINE_SIZE];
+} memory_pool_magazine_t;
+
+typedef struct memory_pool_s {
+    // Read mostly
+    uint8_t* blocks;                // block_count * block_size bytes
+    atomic_uint* next;              // Link per block : index + 1 of the block below, 0 at the bottom
+    size_t block_size;
+    size_t block_count;
+    unsigned block_shift;           // log2 of block_size if it is a power of two, else 0
+    uint32_t magazine_capacity;     // Blocks a magazine may hold, 0 without magazines
+    uint64_t id;                    // Unique per pool, tells a new pool from a freed one at the same address
+    atomic_uint drain_epoch;        // Bumped by a failed alloc, owners then empty their magazines
+    bool owned;                     // Allocated by memory_pool_init, freed by memory_pool_free
+    struct memory_pool_s* next_live;
+
+    _Alignas(MEMORY_POOL_CACHE_LINE) atomic_uint_fast64_t head;    // tag << 32 | top index + 1
+    atomic_size_t outstanding;      // Blocks outside the shared stack
+    atomic_size_t high_water;
+    atomic_uint_fast64_t failures;
+
+    memory_pool_magazine_t magazines[MEMORY_POOL_MAGAZINES];
+} memory_pool_t;
+
+_Static_assert(sizeof(memory_pool_t) <= MEMORY_POOL_STATE_BYTES, "MEMORY_POOL_STATE_BYTES is too small");
+_Static_assert(sizeof(atomic_uint) == sizeof(uint32_t), "block links must match MEMORY_POOL_STORAGE_BYTES");
+
+// Magazine of the calling thread in one pool
+typedef struct memory_pool_thread_cache_s {
+    memory_pool_t* pool;
+    uint64_t pool_id;
+    memory_pool_magazine_t* magazine;   // NULL if all magazines were taken
+    unsigned drain_epoch;
+} memory_pool_thread_cache_t;
+
+// Live pools, changed by init and free, read by exiting threads
+static memory_pool_t* live_pools = NULL;
+static atomic_flag live_lock = ATOMIC_FLAG_INIT;
+static atomic_uint_fast64_t next_pool_id = 1;
+static atomic_uint freed_pools = 0;         // Bumped by every free, tells full caches to look for stale entries
+
+static atomic_uint_fast64_t next_thread_token = 1;
+static _Thread_local uint64_t thread_token = 0;
+static _Thread_local memory_pool_thread_cache_t thread_caches[MEMORY_POOL_THREAD_CACHES];
+static _Thread_local unsigned thread_caches_full = 0;    // freed_pools + 1 when all entries were live, else 0
+
+// Thread exit hook, created once
+static tss_t exit_key;
+static once_flag exit_key_once = ONCE_FLAG_INIT;
+static bool exit_key_ready = false;
+
+// Local function definitions
+
+static void lock_live(void)
+{
+    while(atomic_flag_test_and_set_explicit(&live_lock, memory_order_acquire))
+    {
+    }
+}
+
+static void unlock_live(void)
+{
+    atomic_flag_clear_explicit(&live_lock, memory_order_release);
+}
+
+/**
+ * @brief Checks if a pool is still alive, the registry lock must be held.
+ *
+ * @param pool Pool pointer.
+ * @param pool_id Id the pool had.
+ * @return true if the same pool is in the registry.
+ */
+static bool pool_live(const memory_pool_t* pool, uint64_t pool_id)
+{
+    for(const memory_pool_t* live = live_pools; live != NULL; live = live->next_live)
+    {
+        if(live == pool)
+            return (live->id == pool_id);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Pops a block index from the shared stack.
+ *
+ * @param pool The pool.
+ * @return Index, or MEMORY_POOL_INVALID_INDEX when the stack is empty.
+ */
+static uint32_t stack_pop(memory_pool_t* pool)
+{
+    uint64_t head = atomic_load_explicit(&pool->head, memory_order_acquire);
+
+    while(1)
+    {
+        const uint32_t top = (uint32_t)head;
+
+        if(top == 0)
+            return MEMORY_POOL_INVALID_INDEX;
+
+        // May be stale if another thread pops first, the tag then fails the exchange
+        const uint32_t below = atomic_load_explicit(&pool->next[top - 1u], memory_order_relaxed);
+        const uint64_t replacement = (((head >> 32) + 1u) << 32) | below;
+
+        if(atomic_compare_exchange_weak_explicit(&pool->head, &head, replacement,
+                                                 memory_order_acquire, memory_order_acquire))
+        {
+            break;
+        }
+    }
+
+    // Track the peak of blocks handed out of the stack
+    const size_t outstanding = atomic_fetch_add_explicit(&pool->outstanding, 1, memory_order_relaxed) + 1u;
+    size_t peak = atomic_load_explicit(&pool->high_water, memory_order_relaxed);
+
+    while(outstanding > peak &&
+          !atomic_compare_exchange_weak_explicit(&pool->high_water, &peak, outstanding,
+                                                 memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+
+    return (uint32_t)head - 1u;
+}
+
+/**
+ * @brief Pushes a block index onto the shared stack.
+ *
+ * @param pool The pool.
+ * @param index Block index.
+ */
+static void stack_push(memory_pool_t* pool, uint32_t index)
+{
+    uint64_t head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+
+    while(1)
+    {
+        atomic_store_explicit(&pool->next[index], (uint32_t)head, memory_order_relaxed);
+
+        const uint64_t replacement = (((head >> 32) + 1u) << 32) | (uint64_t)(index + 1u);
+
+        if(atomic_compare_exchange_weak_explicit(&pool->head, &head, replacement,
+                                                 memory_order_release, memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    atomic_fetch_sub_explicit(&pool->outstanding, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Moves blocks from a magazine to the shared stack.
+ *
+ * @param pool The pool.
+ * @param magazine Magazine of the calling thread.
+ * @param keep Blocks to leave in the magazine.
+ */
+static void magazine_spill(memory_pool_t* pool, memory_pool_magazine_t* magazine, uint32_t keep)
+{
+    uint32_t count = atomic_load_explicit(&magazine->count, memory_order_relaxed);
+
+    while(count > keep)
+    {
+        stack_push(pool, magazine->blocks[--count]);
+    }
+
+    atomic_store_explicit(&magazine->count, count, memory_order_relaxed);
+}
+
+/**
+ * @brief Gives the magazines of an exiting thread back.
+ *
+ * @param value Unused, the caches are thread local.
+ */
+static void thread_exit(void* value)
+{
+    (void)value;
+
+    lock_live();
+
+    for(size_t entry = 0; entry < MEMORY_POOL_THREAD_CACHES; entry++)
+    {
+        memory_pool_thread_cache_t* cache = &thread_caches[entry];
+
+        if(cache->magazine != NULL && pool_live(cache->pool, cache->pool_id))
+        {
+            magazine_spill(cache->pool, cache->magazine, 0);
+            atomic_store_explicit(&cache->magazine->owner, 0, memory_order_release);
+        }
+
+        cache->pool = NULL;
+        cache->magazine = NULL;
+    }
+
+    unlock_live();
+}
+
+static void create_exit_key(void)
+{
+    exit_key_ready = (tss_create(&exit_key, thread_exit) == thrd_success);
+}
+
+/**
+ * @brief Finds or claims the calling thread's magazine, the slow path.
+ *
+ * @param pool The pool.
+ * @return Cache entry, NULL if the thread has no free entry.
+ */
+static memory_pool_thread_cache_t* claim_cache(memory_pool_t* pool)
+{
+    memory_pool_thread_cache_t* free_cache = NULL;
+
+    const unsigned freed = atomic_load_explicit(&freed_pools, memory_order_relaxed);
+
+    if(thread_token == 0)
+        thread_token = atomic_fetch_add_explicit(&next_thread_token, 1, memory_order_relaxed);
+
+    // No pool was freed since all entries were found live, the extra pool goes without a magazine
+    if(thread_caches_full == freed + 1u)
+        return NULL;
+
+    lock_live();
+
+    for(size_t entry = 0; entry < MEMORY_POOL_THREAD_CACHES; entry++)
+    {
+        memory_pool_thread_cache_t* cache = &thread_caches[entry];
+
+        // Entries of freed pools are reused
+        if(cache->pool != NULL && !pool_live(cache->pool, cache->pool_id))
+            cache->pool = NULL;
+
+        if(cache->pool == NULL && free_cache == NULL)
+            free_cache = cache;
+    }
+
+    unlock_live();
+
+    if(free_cache == NULL)
+    {
+        thread_caches_full = freed + 1u;
+        return NULL;
+    }
+
+    thread_caches_full = 0;
+
+    call_once(&exit_key_once, create_exit_key);
+
+    // Without an exit hook the blocks would stay cached after the thread is gone
+    if(!exit_key_ready || tss_set(exit_key, thread_caches) != thrd_success)
+        return NULL;
+
+    free_cache->pool = pool;
+    free_cache->pool_id = pool->id;
+    free_cache->magazine = NULL;
+    free_cache->drain_epoch = atomic_load_explicit(&pool->drain_epoch, memory_order_relaxed);
+
+    for(size_t slot = 0; slot < MEMORY_POOL_MAGAZINES && pool->magazine_capacity != 0; slot++)
+    {
+        memory_pool_magazine_t* magazine = &pool->magazines[slot];
+        uint_fast64_t expected = 0;
+
+        if(atomic_load_explicit(&magazine->owner, memory_order_relaxed) == 0 &&
+           atomic_compare_exchange_strong_explicit(&magazine->owner, &expected, thread_token,
+                                                   memory_order_acquire, memory_order_relaxed))
+        {
+            free_cache->magazine = magazine;
+            break;
+        }
+    }
+
+    return free_cache;
+}
+
+/**
+ * @brief Returns the calling thread's magazine in a pool.
+ *
+ * Empties the magazine if a failed alloc asked for it.
+ *
+ * @param pool The pool.
+ * @return Magazine, NULL if the thread has none in this pool or just emptied it.
+ */
+static inline memory_pool_magazine_t* thread_magazine(memory_pool_t* pool)
+{
+    memory_pool_thread_cache_t* cache = NULL;
+
+    for(size_t entry = 0; entry < MEMORY_POOL_THREAD_CACHES; entry++)
+    {
+        if(thread_caches[entry].pool == pool && thread_caches[entry].pool_id == pool->id)
+        {
+            cache = &thread_caches[entry];
+            break;
+        }
+    }
+
+    if(cache == NULL)
+    {
+        cache = claim_cache(pool);
+
+        if(cache == NULL)
+            return NULL;
+    }
+
+    const unsigned drain_epoch = atomic_load_explicit(&pool->drain_epoch, memory_order_relaxed);
+
+    if(cache->drain_epoch != drain_epoch)
+    {
+        // This call uses the shared stack too, so no block is cached again right away
+        cache->drain_epoch = drain_epoch;
+
+        if(cache->magazine != NULL)
+        {
+            magazine_spill(pool, cache->magazine, 0);
+            return NULL;
+        }
+    }
+
+    return cache->magazine;
+}
+
+/**
+ * @brief Rounds a block size up to MEMORY_POOL_BLOCK_ALIGN.
+ *
+ * @param block_size Requested usable bytes per block.
+ * @return Rounded block size.
+ */
+static inline size_t round_block_size(size_t block_size)
+{
+    return (block_size + MEMORY_POOL_BLOCK_ALIGN - 1u) & ~(size_t)(MEMORY_POOL_BLOCK_ALIGN - 1u);
+}
+
+/**
+ * @brief Sets up a pool whose memory is in place and registers it.
+ *
+ * @param pool Pool with blocks and next set.
+ * @param block_size Rounded block size.
+ * @param block_count Number of blocks.
+ */
+static void setup_pool(memory_pool_t* pool, size_t block_size, size_t block_count)
+{
+    const size_t share = block_count / (2u * MEMORY_POOL_MAGAZINES);
+
+    pool->block_size = block_size;
+    pool->block_count = block_count;
+    pool->block_shift = ((block_size & (block_size - 1u)) == 0) ? (unsigned)__builtin_ctzll(block_size) : 0u;
+    // A magazine moves half its capacity at once, so it needs at least two blocks
+    pool->magazine_capacity = (share < 2u) ? 0u : (uint32_t)((share < MEMORY_POOL_MAGAZINE_SIZE) ? share : MEMORY_POOL_MAGAZINE_SIZE);
+    pool->id = atomic_fetch_add_explicit(&next_pool_id, 1, memory_order_relaxed);
+    atomic_init(&pool->drain_epoch, 0);
+
+    // Block 0 ends up on top
+    for(size_t index = 0; index < block_count; index++)
+    {
+        atomic_init(&pool->next[index], (index + 1u < block_count) ? (unsigned)(index + 2u) : 0u);
+    }
+
+    atomic_init(&pool->head, 1u);
+    atomic_init(&pool->outstanding, 0);
+    atomic_init(&pool->high_water, 0);
+    atomic_init(&pool->failures, 0);
+
+    for(size_t slot = 0; slot < MEMORY_POOL_MAGAZINES; slot++)
+    {
+        atomic_init(&pool->magazines[slot].owner, 0);
+        atomic_init(&pool->magazines[slot].count, 0);
+    }
+
+    lock_live();
+    pool->next_live = live_pools;
+    live_pools = pool;
+    unlock_live();
+}
+
+// Global function definitions
+
+/**
+ * @brief Initializes a memory pool.
+ *
+ * All blocks are allocated here; alloc and release never call malloc.
+ *
+ * @param out_pool Receives the pool.
+ * @param block_size Usable bytes per block, rounded up to MEMORY_POOL_BLOCK_ALIGN.
+ * @param block_count Number of blocks, below MEMORY_POOL_INVALID_INDEX.
+ * @return true on success, false on failure.
+ */
+bool memory_pool_init(memory_pool_t** out_pool, size_t block_size, size_t block_count)
+{
+    if(out_pool == NULL || block_size == 0 || block_count == 0 || block_count >= MEMORY_POOL_INVALID_INDEX)
+        return false;
+
+    block_size = round_block_size(block_size);
+
+    if(block_size > (SIZE_MAX - MEMORY_POOL_CACHE_LINE) / block_count)
+        return false;
+
+    memory_pool_t* pool = (memory_pool_t*)aligned_alloc(MEMORY_POOL_CACHE_LINE,
+        (sizeof(*pool) + MEMORY_POOL_CACHE_LINE - 1u) & ~(size_t)(MEMORY_POOL_CACHE_LINE - 1u));
+
+    if(pool == NULL)
+        return false;
+
+    // Blocks start on a cache line, so neighbouring pools never share one
+    const size_t area = (block_size * block_count + MEMORY_POOL_CACHE_LINE - 1u) & ~(size_t)(MEMORY_POOL_CACHE_LINE - 1u);
+
+    pool->blocks = (uint8_t*)aligned_alloc(MEMORY_POOL_CACHE_LINE, area);
+    pool->next = (atomic_uint*)calloc(block_count, sizeof(*pool->next));
+
+    if(pool->blocks == NULL || pool->next == NULL)
+    {
+        free(pool->blocks);
+        free(pool->next);
+        free(pool);
+        return false;
+    }
+
+    pool->owned = true;
+    setup_pool(pool, block_size, block_count);
+
+    *out_pool = pool;
+
+    return true;
+}
+
+/**
+ * @brief Initializes a memory pool in caller storage.
+ *
+ * Nothing is allocated; the state, the blocks and their links are placed
+ * in memory, which must stay valid until memory_pool_free.
+ *
+ * @param out_pool Receives the pool.
+ * @param memory Storage aligned to TELEMETRY_STORAGE_ALIGN.
+ * @param memory_bytes Size of memory, at least MEMORY_POOL_STORAGE_BYTES(block_size, block_count).
+ * @param block_size Usable bytes per block, rounded up to MEMORY_POOL_BLOCK_ALIGN.
+ * @param block_count Number of blocks, below MEMORY_POOL_INVALID_INDEX.
+ * @return true on success, false on failure.
+ */
+bool memory_pool_init_static(memory_pool_t** out_pool, void* memory, size_t memory_bytes, size_t block_size, size_t block_count)
+{
+    if(out_pool == NULL || block_size == 0 || block_count == 0 || block_count >= MEMORY_POOL_INVALID_INDEX ||
+       !telemetry_storage_aligned(memory))
+        return false;
+
+    block_size = round_block_size(block_size);
+
+    if(block_size > (SIZE_MAX / 2u) / block_count ||
+       memory_bytes < MEMORY_POOL_STORAGE_BYTES(block_size, block_count))
+        return false;
+
+    // State, then the blocks on the next cache line, then the links
+    memory_pool_t* pool = (memory_pool_t*)memory;
+    memset(pool, 0, sizeof(*pool));
+
+    pool->blocks = (uint8_t*)memory + MEMORY_POOL_STATE_BYTES;
+    pool->next = (atomic_uint*)(pool->blocks + TELEMETRY_STORAGE_ROUND(block_size * block_count));
+    pool->owned = false;
+    setup_pool(pool, block_size, block_count);
+
+    *out_pool = pool;
+
+    return true;
+}
+
+/**
+ * @brief Frees a pool and all its blocks.
+ *
+ * Threads that used the pool may still exit later, they skip it. A pool
+ * in caller storage is only unregistered, its memory can be used again.
+ *
+ * @param pool Pool to free, no block may be used afterwards.
+ */
+void memory_pool_free(memory_pool_t* pool)
+{
+    if(pool == NULL)
+        return;
+
+    lock_live();
+
+    for(memory_pool_t** link = &live_pools; *link != NULL; link = &(*link)->next_live)
+    {
+        if(*link == pool)
+        {
+            *link = pool->next_live;
+            break;
+        }
+    }
+
+    atomic_fetch_add_explicit(&freed_pools, 1, memory_order_relaxed);
+
+    unlock_live();
+
+    if(!pool->owned)
+        return;
+
+    free(pool->blocks);
+    free(pool->next);
+    free(pool);
+}
+
+/**
+ * @brief Takes a block.
+ *
+ * Served from the calling thread's magazine, refilled from the shared
+ * stack half a magazine at a time.
+ *
+ * @param pool The pool.
+ * @return Block of memory_pool_block_size() bytes, NULL if none is free.
+ */
+void* memory_pool_alloc(memory_pool_t* pool)
+{
+    if(pool == NULL)
+        return NULL;
+
+    memory_pool_magazine_t* magazine = thread_magazine(pool);
+    uint32_t index = MEMORY_POOL_INVALID_INDEX;
+
+    if(magazine != NULL)
+    {
+        uint32_t count = atomic_load_explicit(&magazine->count, memory_order_relaxed);
+
+        if(count == 0)
+        {
+            // Refill, keeping the last popped block for this call
+            for(uint32_t moved = 0; moved < pool->magazine_capacity / 2u; moved++)
+            {
+                const uint32_t popped = stack_pop(pool);
+
+                if(popped == MEMORY_POOL_INVALID_INDEX)
+                    break;
+
+                magazine->blocks[count++] = popped;
+            }
+        }
+
+        if(count != 0)
+            index = magazine->blocks[--count];
+
+        atomic_store_explicit(&magazine->count, count, memory_order_relaxed);
+    }
+    else
+    {
+        index = stack_pop(pool);
+    }
+
+    if(index == MEMORY_POOL_INVALID_INDEX)
+    {
+        // Other threads return their cached blocks on their next call
+        atomic_fetch_add_explicit(&pool->drain_epoch, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&pool->failures, 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    return pool->blocks + (size_t)index * pool->block_size;
+}
+
+/**
+ * @brief Gives a block back.
+ *
+ * Goes to the calling thread's magazine; a full magazine first moves half
+ * of its blocks to the shared stack.
+ *
+ * @param pool The pool.
+ * @param block Block from memory_pool_alloc() of this pool, NULL is ignored.
+ */
+void memory_pool_release(memory_pool_t* pool, void* block)
+{
+    const uint32_t index = memory_pool_index(pool, block);
+
+    if(index == MEMORY_POOL_INVALID_INDEX)
+        return;
+
+    memory_pool_magazine_t* magazine = thread_magazine(pool);
+
+    if(magazine == NULL)
+    {
+        stack_push(pool, index);
+        return;
+    }
+
+    uint32_t count = atomic_load_explicit(&magazine->count, memory_order_relaxed);
+
+    if(count == pool->magazine_capacity)
+    {
+        magazine_spill(pool, magazine, pool->magazine_capacity / 2u);
+        count = atomic_load_explicit(&magazine->count, memory_order_relaxed);
+    }
+
+    magazine->blocks[count] = index;
+    atomic_store_explicit(&magazine->count, count + 1u, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the index of a block.
+ *
+ * @param pool The pool.
+ * @param block Block pointer.
+ * @return Index, MEMORY_POOL_INVALID_INDEX if the pointer is not the start of a block of this pool.
+ */
+uint32_t memory_pool_index(const memory_pool_t* pool, const void* block)
+{
+    if(pool == NULL || block == NULL)
+        return MEMORY_POOL_INVALID_INDEX;
+
+    const uintptr_t start = (uintptr_t)pool->blocks;
+    const uintptr_t address = (uintptr_t)block;
+
+    if(address < start || address >= start + pool->block_size * pool->block_count)
+        return MEMORY_POOL_INVALID_INDEX;
+
+    const size_t offset = (size_t)(address - start);
+
+    // Release is on the hot path, skip the division for power of two sizes
+    if(pool->block_shift != 0)
+    {
+        if((offset & (pool->block_size - 1u)) != 0)
+            return MEMORY_POOL_INVALID_INDEX;
+
+        return (uint32_t)(offset >> pool->block_shift);
+    }
+
+    if(offset % pool->block_size != 0)
+        return MEMORY_POOL_INVALID_INDEX;
+
+    return (uint32_t)(offset / pool->block_size);
+}
+
+/**
+ * @brief Returns the block with an index.
+ *
+ * @param pool The pool.
+ * @param index Block index.
+ * @return Block, NULL if the index is out of range.
+ */
+void* memory_pool_block(const memory_pool_t* pool, uint32_t index)
+{
+    if(pool == NULL || index >= pool->block_count)
+        return NULL;
+
+    return pool->blocks + (size_t)index * pool->block_size;
+}
+
+/**
+ * @brief Reads the pool statistics.
+ *
+ * Magazine counts are read while their owners run, so the snapshot can be
+ * off by the blocks that move while it is taken.
+ *
+ * @param pool The pool.
+ * @param out_stats Receives the statistics.
+ */
+void memory_pool_stats(const memory_pool_t* pool, memory_pool_stats_t* out_stats)
+{
+    if(out_stats == NULL)
+        return;
+
+    out_stats->block_size = 0;
+    out_stats->block_count = 0;
+    out_stats->in_use = 0;
+    out_stats->high_water = 0;
+    out_stats->failures = 0;
+
+    if(pool == NULL)
+        return;
+
+    size_t cached = 0;
+
+    for(size_t slot = 0; slot < MEMORY_POOL_MAGAZINES; slot++)
+    {
+        cached += atomic_load_explicit((atomic_uint*)&pool->magazines[slot].count, memory_order_relaxed);
+    }
+
+    const size_t outstanding = atomic_load_explicit((atomic_size_t*)&pool->outstanding, memory_order_relaxed);
+
+    out_stats->block_size = pool->block_size;
+    out_stats->block_count = pool->block_count;
+    out_stats->in_use = (outstanding > cached) ? (outstanding - cached) : 0;
+    out_stats->high_water = atomic_load_explicit((atomic_size_t*)&pool->high_water, memory_order_relaxed);
+    out_stats->failures = atomic_load_explicit((atomic_uint_fast64_t*)&pool->failures, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the usable size of a block.
+ *
+ * @param pool The pool.
+ * @return Bytes per block after rounding.
+ */
+size_t memory_pool_block_size(const memory_pool_t* pool)
+{
+    if(pool == NULL)
+        return 0;
+
+    return pool->block_size;
+}
+
+/**
+ * @brief Returns the number of blocks.
+ *
+ * @param pool The pool.
+ * @return Blocks in the pool.
+ */
+size_t memory_pool_block_count(const memory_pool_t* pool)
+{
+    if(pool == NULL)
+        return 0;
+
+    return pool->block_count;
+}
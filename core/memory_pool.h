@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../api/type.h"
+#include "static_storage.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Most blocks a per thread magazine caches
+#ifndef MEMORY_POOL_MAGAZINE_SIZE
+    #define MEMORY_POOL_MAGAZINE_SIZE 32u
+#endif
+
+// Magazines per pool, threads beyond this use the shared stack directly
+#ifndef MEMORY_POOL_MAGAZINES
+    #define MEMORY_POOL_MAGAZINES 16u
+#endif
+
+// Pools one thread can keep a magazine in at the same time, further pools use the shared stack
+#ifndef MEMORY_POOL_THREAD_CACHES
+    #define MEMORY_POOL_THREAD_CACHES 4u
+#endif
+
+// Block sizes are rounded up to a multiple of this
+#define MEMORY_POOL_BLOCK_ALIGN 16u
+
+// Index of no block
+#define MEMORY_POOL_INVALID_INDEX 0xFFFFFFFFu
+
+// Bytes of pool state in static storage, mostly the magazines
+#define MEMORY_POOL_STATE_BYTES \
+    (2u * TELEMETRY_STORAGE_ALIGN + MEMORY_POOL_MAGAZINES * TELEMETRY_STORAGE_ROUND(16u + 4u * MEMORY_POOL_MAGAZINE_SIZE))
+
+// Storage for memory_pool_init_static : state, blocks, then one link per block
+#define MEMORY_POOL_STORAGE_BYTES(block_size, block_count) \
+    (MEMORY_POOL_STATE_BYTES + \
+     TELEMETRY_STORAGE_ROUND((((size_t)(block_size) + MEMORY_POOL_BLOCK_ALIGN - 1u) & ~(size_t)(MEMORY_POOL_BLOCK_ALIGN - 1u)) * (size_t)(block_count)) + \
+     TELEMETRY_STORAGE_ROUND((size_t)(block_count) * sizeof(uint32_t)))
+
+/*
+ * Fixed size block pool, allocated once. Alloc and release are lock
+ * free; only pool free and thread exit take a short registry lock.
+ * Free blocks sit on an index based Treiber stack whose head carries a
+ * tag against ABA. In front of it a thread claims one magazine per pool on
+ * first use and keeps it until it exits; alloc and release on a magazine
+ * are plain loads and stores without atomic read-modify-write. Magazines
+ * hold at most a block_count / (2 * MEMORY_POOL_MAGAZINES) share, so
+ * caches never hide more than half of the pool.
+ * An alloc that finds no block asks all threads to return their cached
+ * blocks; each does so on its next pool call or when it exits.
+ */
+typedef struct memory_pool_s memory_pool_t;
+
+// Pool statistics, a snapshot that may be slightly off while other threads run
+typedef struct memory_pool_stats_s {
+    size_t block_size;          // Usable bytes per block
+    size_t block_count;         // Blocks in the pool
+    size_t in_use;              // Blocks allocated and not released
+    size_t high_water;          // Most blocks outside the shared stack at once, counts cached blocks too
+    uint64_t failures;          // Allocations that found no free block
+} memory_pool_stats_t;
+
+
+// global memory pool functions, free only after the other threads stopped using the pool
+bool memory_pool_init(memory_pool_t** out_pool, size_t block_size, size_t block_count);
+void memory_pool_free(memory_pool_t* pool);
+
+// Same as memory_pool_init, in caller storage of MEMORY_POOL_STORAGE_BYTES(block_size, block_count) bytes
+bool memory_pool_init_static(memory_pool_t** out_pool, void* memory, size_t memory_bytes, size_t block_size, size_t block_count);
+
+// Any thread : take a block, NULL when the pool is exhausted
+void* memory_pool_alloc(memory_pool_t* pool);
+
+// Any thread : give a block back, blocks of other pools are ignored
+void memory_pool_release(memory_pool_t* pool, void* block);
+
+// Block index for handles, and back; MEMORY_POOL_INVALID_INDEX / NULL for foreign pointers or indices
+uint32_t memory_pool_index(const memory_pool_t* pool, const void* block);
+void* memory_pool_block(const memory_pool_t* pool, uint32_t index);
+
+
+// Helper functions
+void memory_pool_stats(const memory_pool_t* pool, memory_pool_stats_t* out_stats);
+size_t memory_pool_block_size(const memory_pool_t* pool);
+size_t memory_pool_block_count(const memory_pool_t* pool);
+
+
+
+#ifdef __cplusplus
+    }
+#endif
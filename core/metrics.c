@@ -0,0 +1,523 @@
+/**
+ * @file metrics.c
+ * @brief Telemetry metrics implementation.
+ *
+ * Fixed-capacity registry of counters, gauges and histograms updated with
+ * atomics, and the metrics batch encoding used by the agent.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+
+#include "metrics.h"
+#include "telemetry_protocol.h"
+#include "byte_order.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Each metric gets its own cache line so hot counters don't share one
+#define METRICS_CACHE_LINE 64u
+
+// Struct declaration
+
+struct telemetry_metric_s {
+    _Alignas(METRICS_CACHE_LINE) atomic_uint type;  // 0 until the slot is registered
+    atomic_uint_fast64_t key;           // metric_id + 1 once claimed, 0 while free
+    uint32_t metric_id;
+
+    atomic_uint_fast64_t value;         // Counter total or gauge bits
+    telemetry_histogram_t* histogram;   // Only for histograms
+    sharded_counter_t* sharded;         // Counter backed by per-thread slots, summed on encode
+};
+
+struct telemetry_metrics_s {
+    telemetry_metric_t* metrics;
+    size_t capacity;
+
+    atomic_size_t claimed;              // Slots below this index may be claimed
+};
+
+// Local function definitions
+
+/**
+ * @brief Returns the number of slots that may hold a registered metric.
+ *
+ * @param metrics Registry instance.
+ * @return Number of slots to scan.
+ */
+static inline size_t claimed_slots(const telemetry_metrics_t* metrics)
+{
+    size_t claimed = atomic_load_explicit(&metrics->claimed, memory_order_acquire);
+
+    return (claimed > metrics->capacity) ? metrics->capacity : claimed;
+}
+
+/**
+ * @brief Encodes one metric record.
+ *
+ * @param metric Metric to encode.
+ * @param type Registered metric type.
+ * @param buffer Output buffer.
+ * @param capacity Output buffer size.
+ * @return Bytes written, 0 if the record does not fit.
+ */
+static size_t encode_record(const telemetry_metric_t* metric, unsigned type, uint8_t* buffer, size_t capacity)
+{
+    size_t position = 0;
+
+    if(capacity < 1)
+        return 0;
+
+    buffer[position++] = (uint8_t)type;
+
+    if(!telemetry_append_varint(buffer, capacity, &position, metric->metric_id))
+        return 0;
+
+    if(type == TELEMETRY_METRIC_COUNTER)
+    {
+        // Sharded counters are summed here, on the agent thread
+        const uint64_t total = (metric->sharded != NULL) ?
+                               sharded_counter_sum(metric->sharded) :
+                               atomic_load_explicit(&metric->value, memory_order_relaxed);
+
+        if(!telemetry_append_varint(buffer, capacity, &position, total))
+            return 0;
+
+        return position;
+    }
+
+    if(type == TELEMETRY_METRIC_GAUGE)
+    {
+        // Zigzag keeps small negative gauges small on the wire
+        const int64_t gauge = (int64_t)atomic_load_explicit(&metric->value, memory_order_relaxed);
+        const uint64_t zigzag = ((uint64_t)gauge << 1) ^ (uint64_t)(gauge >> 63);
+
+        if(!telemetry_append_varint(buffer, capacity, &position, zigzag))
+            return 0;
+
+        return position;
+    }
+
+    // Histogram, snapshotted so the encoded buckets and count agree
+    telemetry_histogram_snapshot_t snapshot;
+    telemetry_histogram_snapshot(metric->histogram, &snapshot);
+
+    const size_t written = telemetry_histogram_encode(&snapshot, &buffer[position], capacity - position);
+
+    if(written == 0)
+        return 0;
+
+    return position + written;
+}
+
+// Global function definitions
+
+/**
+ * @brief Initializes a metrics registry.
+ *
+ * Allocates all metric slots up front, so producers never allocate.
+ *
+ * @param out_metrics Receives the registry.
+ * @param max_metrics Number of metrics that can be registered.
+ * @return true on success, false on failure.
+ */
+bool telemetry_metrics_init(telemetry_metrics_t** out_metrics, size_t max_metrics)
+{
+    if(out_metrics == NULL || max_metrics == 0)
+    {
+        return false;
+    }
+
+    telemetry_metrics_t* metrics = (telemetry_metrics_t*)calloc(1, sizeof(*metrics));
+
+    if(metrics == NULL)
+    {
+        return false;
+    }
+
+    // Slots are cache line aligned, so round the allocation up for aligned_alloc
+    size_t bytes = max_metrics * sizeof(telemetry_metric_t);
+    bytes = (bytes + METRICS_CACHE_LINE - 1) & ~((size_t)METRICS_CACHE_LINE - 1);
+
+    metrics->metrics = (telemetry_metric_t*)aligned_alloc(METRICS_CACHE_LINE, bytes);
+
+    if(metrics->metrics == NULL)
+    {
+        free(metrics);
+        return false;
+    }
+
+    memset(metrics->metrics, 0, bytes);
+
+    for(size_t index = 0; index < max_metrics; index++)
+    {
+        atomic_init(&metrics->metrics[index].type, 0);
+        atomic_init(&metrics->metrics[index].key, 0);
+        atomic_init(&metrics->metrics[index].value, 0);
+    }
+
+    metrics->capacity = max_metrics;
+    atomic_init(&metrics->claimed, 0);
+
+    *out_metrics = metrics;
+
+    return true;
+}
+
+/**
+ * @brief Frees a metrics registry.
+ *
+ * Metric handles become invalid.
+ *
+ * @param metrics Registry instance.
+ */
+void telemetry_metrics_free(telemetry_metrics_t* metrics)
+{
+    if(metrics == NULL)
+        return;
+
+    for(size_t index = 0; index < claimed_slots(metrics); index++)
+    {
+        telemetry_histogram_free(metrics->metrics[index].histogram);
+    }
+
+    free(metrics->metrics);
+    free(metrics);
+}
+
+/**
+ * @brief Looks up or claims the slot for a metric.
+ *
+ * Slots are claimed in order with a compare-and-swap of their key, and a
+ * registration scans from the first slot. Two threads registering the same
+ * id therefore race for the same free slot: the loser finds the winner's
+ * key there and returns that slot once it is published.
+ *
+ * @param metrics Registry instance.
+ * @param metric_id Identifier shipped to the collector.
+ * @param type Metric kind.
+ * @param sharded Sharded counter backing a counter, or NULL.
+ * @return Metric handle, or NULL on failure.
+ */
+static telemetry_metric_t* register_metric(telemetry_metrics_t* metrics, uint32_t metric_id,
+                                           telemetry_metric_type_t type, sharded_counter_t* sharded)
+{
+    if(metrics == NULL || type < TELEMETRY_METRIC_COUNTER || type > TELEMETRY_METRIC_HISTOGRAM)
+    {
+        return NULL;
+    }
+
+    // Allocated before the claim, a claimed slot is always published
+    telemetry_histogram_t* histogram = NULL;
+
+    if(type == TELEMETRY_METRIC_HISTOGRAM && !telemetry_histogram_init(&histogram))
+    {
+        return NULL;
+    }
+
+    const uint_fast64_t key = (uint_fast64_t)metric_id + 1u;
+
+    for(size_t index = 0; index < metrics->capacity; index++)
+    {
+        telemetry_metric_t* metric = &metrics->metrics[index];
+        uint_fast64_t current = atomic_load_explicit(&metric->key, memory_order_acquire);
+
+        if(current == 0 &&
+           atomic_compare_exchange_strong_explicit(&metric->key, &current, key, memory_order_acq_rel, memory_order_acquire))
+        {
+            metric->metric_id = metric_id;
+            metric->sharded = sharded;
+            metric->histogram = histogram;
+
+            // Let the encoder scan up to this slot
+            size_t claimed = atomic_load_explicit(&metrics->claimed, memory_order_relaxed);
+            while(claimed < index + 1 &&
+                  !atomic_compare_exchange_weak_explicit(&metrics->claimed, &claimed, index + 1,
+                                                         memory_order_release, memory_order_relaxed))
+            {
+            }
+
+            // Publish the slot to the agent
+            atomic_store_explicit(&metric->type, (unsigned)type, memory_order_release);
+
+            return metric;
+        }
+
+        // Claimed by a registration of another id, or of this one
+        if(current == key)
+        {
+            unsigned registered;
+
+            // The winner publishes right after its claim
+            while((registered = atomic_load_explicit(&metric->type, memory_order_acquire)) == 0)
+            {
+            }
+
+            telemetry_histogram_free(histogram);
+
+            return (registered == (unsigned)type) ? metric : NULL;
+        }
+    }
+
+    // Registry full
+    telemetry_histogram_free(histogram);
+
+    return NULL;
+}
+
+/**
+ * @brief Registers a metric.
+ *
+ * Safe to call from several threads. Registering an id again returns the
+ * existing handle when the type matches.
+ *
+ * @param metrics Registry instance.
+ * @param metric_id Identifier shipped to the collector.
+ * @param type Metric kind.
+ * @return Metric handle, or NULL if the registry is full, the type is invalid
+ *         or the id is already used with another type.
+ */
+telemetry_metric_t* telemetry_metrics_register(telemetry_metrics_t* metrics, uint32_t metric_id, telemetry_metric_type_t type)
+{
+    return register_metric(metrics, metric_id, type, NULL);
+}
+
+/**
+ * @brief Registers a counter backed by a sharded counter.
+ *
+ * Producers add through sharded_counter_add() (or telemetry_metric_add()),
+ * and the agent sums the slots when it publishes metrics. The sharded
+ * counter must outlive the registry.
+ *
+ * @param metrics Registry instance.
+ * @param metric_id Identifier shipped to the collector.
+ * @param counter Sharded counter providing the value.
+ * @return Metric handle, or NULL on failure.
+ */
+telemetry_metric_t* telemetry_metrics_register_sharded(telemetry_metrics_t* metrics, uint32_t metric_id, sharded_counter_t* counter)
+{
+    if(counter == NULL)
+    {
+        return NULL;
+    }
+
+    telemetry_metric_t* metric = register_metric(metrics, metric_id, TELEMETRY_METRIC_COUNTER, counter);
+
+    // An existing plain counter with this id can't be switched over
+    if(metric != NULL && metric->sharded != counter)
+    {
+        return NULL;
+    }
+
+    return metric;
+}
+
+/**
+ * @brief Adds to a counter.
+ *
+ * @param metric Counter handle.
+ * @param delta Amount to add.
+ */
+void telemetry_metric_add(telemetry_metric_t* metric, uint64_t delta)
+{
+    if(metric == NULL)
+        return;
+
+    if(metric->sharded != NULL)
+    {
+        sharded_counter_add(metric->sharded, delta);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&metric->value, delta, memory_order_relaxed);
+}
+
+/**
+ * @brief Sets a gauge.
+ *
+ * @param metric Gauge handle.
+ * @param value New value.
+ */
+void telemetry_metric_set(telemetry_metric_t* metric, int64_t value)
+{
+    if(metric == NULL)
+        return;
+
+    atomic_store_explicit(&metric->value, (uint64_t)value, memory_order_relaxed);
+}
+
+/**
+ * @brief Records a sample in a histogram.
+ *
+ * Safe to call from several producer threads.
+ *
+ * @param metric Histogram handle.
+ * @param value Sample value.
+ */
+void telemetry_metric_record(telemetry_metric_t* metric, uint64_t value)
+{
+    if(metric == NULL || metric->histogram == NULL)
+        return;
+
+    telemetry_histogram_record_shared(metric->histogram, value);
+}
+
+/**
+ * @brief Encodes metric records into a metrics batch payload.
+ *
+ * Starts at *cursor and writes as many records as fit, then stores the index
+ * to continue from. A record that does not fit into an empty payload is
+ * skipped so the caller always makes progress.
+ *
+ * @param metrics Registry instance.
+ * @param encoded_buffer Output buffer for the payload.
+ * @param buffer_capacity Output buffer size.
+ * @param cursor Index of the next metric, 0 for a new snapshot.
+ * @return Bytes written, 0 when there is nothing left to encode.
+ */
+size_t telemetry_metrics_encode(const telemetry_metrics_t* metrics, uint8_t* encoded_buffer, size_t buffer_capacity, size_t* cursor)
+{
+    if(metrics == NULL || encoded_buffer == NULL || cursor == NULL || buffer_capacity < 2)
+    {
+        return 0;
+    }
+
+    const size_t slots = claimed_slots(metrics);
+    size_t position = 2;            // Room for the record count
+    uint16_t records = 0;
+
+    while(*cursor < slots && records < UINT16_MAX)
+    {
+        const telemetry_metric_t* metric = &metrics->metrics[*cursor];
+        unsigned type = atomic_load_explicit(&metric->type, memory_order_acquire);
+
+        if(type != 0)
+        {
+            size_t written = encode_record(metric, type, &encoded_buffer[position], buffer_capacity - position);
+
+            if(written == 0)
+            {
+                // Record too large even for an empty payload, skip it
+                if(records == 0)
+                {
+                    (*cursor)++;
+                    continue;
+                }
+
+                // Payload full, continue in the next batch
+                break;
+            }
+
+            position += written;
+            records++;
+        }
+
+        (*cursor)++;
+    }
+
+    if(records == 0)
+    {
+        return 0;
+    }
+
+    telemetry_put_u16_be(encoded_buffer, records);
+
+    return position;
+}
+
+/**
+ * @brief Decodes the record count of a metrics payload.
+ *
+ * @param record_count Receives the number of records.
+ * @param buffer Payload buffer.
+ * @param buffer_length Payload length.
+ * @return Bytes consumed, 0 on error.
+ */
+size_t telemetry_metrics_decode_count(uint16_t* record_count, const uint8_t* buffer, size_t buffer_length)
+{
+    if(record_count == NULL || buffer == NULL || buffer_length < 2)
+    {
+        return 0;
+    }
+
+    *record_count = telemetry_get_u16_be(buffer);
+
+    return 2;
+}
+
+/**
+ * @brief Decodes one metric record.
+ *
+ * @param record Receives the decoded record.
+ * @param buffer Input positioned at a record.
+ * @param buffer_length Readable bytes.
+ * @return Bytes consumed, 0 on error.
+ */
+size_t telemetry_metrics_decode_record(telemetry_metric_record_t* record, const uint8_t* buffer, size_t buffer_length)
+{
+    size_t position = 0;
+    uint64_t value = 0;
+
+    if(record == NULL || buffer == NULL || buffer_length < 1)
+    {
+        return 0;
+    }
+
+    memset(record, 0, sizeof(*record));
+    record->type = buffer[position++];
+
+    if(!telemetry_read_varint(&value, buffer, buffer_length, &position))
+        return 0;
+
+    record->metric_id = (uint32_t)value;
+
+    switch(record->type)
+    {
+        case TELEMETRY_METRIC_COUNTER:
+            if(!telemetry_read_varint(&record->counter, buffer, buffer_length, &position))
+                return 0;
+            return position;
+
+        case TELEMETRY_METRIC_GAUGE:
+            if(!telemetry_read_varint(&value, buffer, buffer_length, &position))
+                return 0;
+            record->gauge = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+            return position;
+
+        case TELEMETRY_METRIC_HISTOGRAM:
+            break;
+
+        default:
+            return 0;
+    }
+
+    const size_t consumed = telemetry_histogram_decode(&record->histogram, &buffer[position], buffer_length - position);
+
+    if(consumed == 0)
+        return 0;
+
+    return position + consumed;
+}
+
+/**
+ * @brief Returns the number of registered metrics.
+ *
+ * @param metrics Registry instance.
+ * @return Number of registered metrics.
+ */
+size_t telemetry_metrics_count(const telemetry_metrics_t* metrics)
+{
+    if(metrics == NULL)
+        return 0;
+
+    size_t registered = 0;
+
+    for(size_t index = 0; index < claimed_slots(metrics); index++)
+    {
+        if(atomic_load_explicit(&metrics->metrics[index].type, memory_order_acquire) != 0)
+            registered++;
+    }
+
+    return registered;
+}
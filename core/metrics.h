@@ -0,0 +1,88 @@
+/**
+ * @file metrics.h
+ * @brief Producer-side metrics aggregated in memory.
+ *
+ * Counters, gauges and histograms are updated in place by producer threads
+ * and shipped by the agent as TELEMETRY_METRICS_BATCH messages, instead of
+ * emitting one telemetry event per sample.
+ *
+ * Metrics batch payload (v1, big-endian, varints are LEB128):
+ * - u16 record count
+ * - per record: u8 type, varint metric id, then
+ *   - counter:   varint value
+ *   - gauge:     varint zigzag encoded value
+ *   - histogram: telemetry_histogram_encode() output, see histogram.h
+ *
+ * All values are cumulative since registration, so a lost batch does not
+ * lose data; the collector derives rates from consecutive batches.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../api/type.h"
+#include "sharded_counter.h"
+#include "histogram.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Metric kinds, also used as the record type on the wire
+typedef enum telemetry_metric_type_e {
+    TELEMETRY_METRIC_COUNTER    = 1,
+    TELEMETRY_METRIC_GAUGE      = 2,
+    TELEMETRY_METRIC_HISTOGRAM  = 3
+} telemetry_metric_type_t;
+
+typedef struct telemetry_metrics_s telemetry_metrics_t;
+typedef struct telemetry_metric_s telemetry_metric_t;
+
+// One decoded metrics record, used by receivers and tests
+typedef struct telemetry_metric_record_s {
+    uint32_t metric_id;
+    uint8_t  type;
+
+    uint64_t counter;           // counter value
+    int64_t  gauge;             // gauge value
+
+    telemetry_histogram_snapshot_t histogram;   // histogram value
+} telemetry_metric_record_t;
+
+
+// Registry functions
+bool telemetry_metrics_init(telemetry_metrics_t** out_metrics, size_t max_metrics);
+void telemetry_metrics_free(telemetry_metrics_t* metrics);
+
+// Register a metric, returns the existing handle if the id is already registered with the same type
+telemetry_metric_t* telemetry_metrics_register(telemetry_metrics_t* metrics, uint32_t metric_id, telemetry_metric_type_t type);
+
+// Register a counter whose value is the sum of a caller owned sharded counter
+telemetry_metric_t* telemetry_metrics_register_sharded(telemetry_metrics_t* metrics, uint32_t metric_id, sharded_counter_t* counter);
+
+// Producer threads : update a metric
+void telemetry_metric_add(telemetry_metric_t* metric, uint64_t delta);
+void telemetry_metric_set(telemetry_metric_t* metric, int64_t value);
+void telemetry_metric_record(telemetry_metric_t* metric, uint64_t value);
+
+// Agent thread : encode records starting at *cursor, advances *cursor, returns bytes written
+size_t telemetry_metrics_encode(const telemetry_metrics_t* metrics, uint8_t* encoded_buffer, size_t buffer_capacity, size_t* cursor);
+
+// Decode the record count at the start of a metrics payload, returns bytes consumed
+size_t telemetry_metrics_decode_count(uint16_t* record_count, const uint8_t* buffer, size_t buffer_length);
+
+// Decode one record, returns bytes consumed or 0 on error
+size_t telemetry_metrics_decode_record(telemetry_metric_record_t* record, const uint8_t* buffer, size_t buffer_length);
+
+
+// Helper functions
+size_t telemetry_metrics_count(const telemetry_metrics_t* metrics);
+
+
+#ifdef __cplusplus
+    }
+#endif
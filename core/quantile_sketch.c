@@ -0,0 +1,1093 @@
+/**
+ * @file quantile_sketch.c
+ * @brief Quantile sketch implementation.
+ *
+ * Logarithmic bin mapping with bounded, lowest-collapsing bin stores, the
+ * event id keyed sketch set used by the agent, and the sketch batch
+ * encoding.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+
+#include "quantile_sketch.h"
+#include "telemetry_protocol.h"
+#include "byte_order.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Accuracy is carried on the wire in parts per million
+#define SKETCH_ACCURACY_SCALE 1000000.0
+
+// Struct declaration
+
+// Bins for one sign, a window of max_bins consecutive keys starting at offset
+typedef struct sketch_store_s {
+    uint64_t* counts;
+    size_t bins;
+    int32_t offset;             // Key of counts[0]
+    int32_t min_key;            // Lowest non-empty key, valid when total != 0
+    int32_t max_key;            // Highest non-empty key, valid when total != 0
+    uint64_t total;
+} sketch_store_t;
+
+struct telemetry_sketch_s {
+    double relative_accuracy;
+    double gamma;
+    double log_gamma;
+
+    uint64_t count;
+    uint64_t zero_count;
+    double sum;
+    double min;
+    double max;
+
+    sketch_store_t positive;
+    sketch_store_t negative;    // Keyed by magnitude
+};
+
+typedef struct sketch_entry_s {
+    uint32_t event_id;
+    uint8_t value_type;         // 0 for an unused slot
+    uint16_t payload_offset;
+    telemetry_sketch_t* sketch;
+} sketch_entry_t;
+
+struct telemetry_sketches_s {
+    sketch_entry_t* entries;    // Open addressing table keyed by event id
+    size_t table_size;          // Power of two
+    size_t capacity;            // Sketches that can be registered
+    size_t registered;
+
+    double relative_accuracy;
+    size_t max_bins;
+};
+
+// Local function definitions
+
+/**
+ * @brief Appends a double as its IEEE 754 bits, big-endian.
+ *
+ * @param buffer Output buffer.
+ * @param capacity Output buffer size.
+ * @param position Current write position, advanced on success.
+ * @param value Value to write.
+ * @return true if the value fit.
+ */
+static inline bool append_double(uint8_t* buffer, size_t capacity, size_t* position, double value)
+{
+    uint64_t bits;
+
+    if(capacity - *position < sizeof(bits))
+        return false;
+
+    memcpy(&bits, &value, sizeof(bits));
+    telemetry_put_u64_be(&buffer[*position], bits);
+    *position += sizeof(bits);
+
+    return true;
+}
+
+/**
+ * @brief Reads a double written by append_double().
+ *
+ * @param value Decoded value.
+ * @param buffer Input buffer.
+ * @param length Input buffer size.
+ * @param position Current read position, advanced on success.
+ * @return true if a value was read.
+ */
+static inline bool read_double(double* value, const uint8_t* buffer, size_t length, size_t* position)
+{
+    if(length - *position < sizeof(uint64_t))
+        return false;
+
+    const uint64_t bits = telemetry_get_u64_be(&buffer[*position]);
+    memcpy(value, &bits, sizeof(*value));
+    *position += sizeof(bits);
+
+    return true;
+}
+
+/**
+ * @brief Moves the bin window so it starts at new_offset.
+ *
+ * Non-empty keys below the new window are collapsed into its first bin.
+ *
+ * @param store Bin store.
+ * @param new_offset Key of the first bin after the move.
+ */
+static void store_shift(sketch_store_t* store, int32_t new_offset)
+{
+    uint64_t collapsed = 0;
+
+    for(int32_t key = store->min_key; key < new_offset && key <= store->max_key; key++)
+    {
+        collapsed += store->counts[key - store->offset];
+    }
+
+    const int32_t keep_from = (store->min_key > new_offset) ? store->min_key : new_offset;
+
+    if(keep_from <= store->max_key)
+    {
+        const size_t kept = (size_t)(store->max_key - keep_from) + 1u;
+        const size_t target = (size_t)(keep_from - new_offset);
+
+        memmove(&store->counts[target], &store->counts[keep_from - store->offset], kept * sizeof(uint64_t));
+
+        // Clear everything the moved range does not cover
+        memset(store->counts, 0, target * sizeof(uint64_t));
+        memset(&store->counts[target + kept], 0, (store->bins - target - kept) * sizeof(uint64_t));
+    }
+    else
+    {
+        memset(store->counts, 0, store->bins * sizeof(uint64_t));
+    }
+
+    store->offset = new_offset;
+    store->counts[0] += collapsed;
+}
+
+/**
+ * @brief Adds samples to a bin.
+ *
+ * When the keys no longer fit into the window the lowest ones are
+ * collapsed, so the highest magnitudes keep their accuracy.
+ *
+ * @param store Bin store.
+ * @param key Bin key.
+ * @param samples Number of samples to add.
+ */
+static void store_add(sketch_store_t* store, int32_t key, uint64_t samples)
+{
+    if(store->total == 0)
+    {
+        store->offset = key;
+        store->min_key = key;
+        store->max_key = key;
+    }
+    else
+    {
+        int32_t low = (key < store->min_key) ? key : store->min_key;
+        const int32_t high = (key > store->max_key) ? key : store->max_key;
+
+        // Too wide for the window, give up the lowest keys
+        if((int64_t)high - (int64_t)low + 1 > (int64_t)store->bins)
+        {
+            low = high - (int32_t)store->bins + 1;
+
+            if(key < low)
+                key = low;
+        }
+
+        if(low < store->offset || (int64_t)high >= (int64_t)store->offset + (int64_t)store->bins)
+        {
+            store_shift(store, low);
+        }
+
+        store->min_key = low;
+        store->max_key = high;
+    }
+
+    store->counts[key - store->offset] += samples;
+    store->total += samples;
+}
+
+/**
+ * @brief Empties a bin store.
+ *
+ * @param store Bin store.
+ */
+static void store_reset(sketch_store_t* store)
+{
+    if(store->total != 0)
+    {
+        memset(store->counts, 0, store->bins * sizeof(uint64_t));
+    }
+
+    store->total = 0;
+    store->offset = 0;
+    store->min_key = 0;
+    store->max_key = 0;
+}
+
+/**
+ * @brief Encodes the non-empty bins of a store.
+ *
+ * @param store Bin store.
+ * @param buffer Output buffer.
+ * @param capacity Output buffer size.
+ * @param position Current write position, advanced on success.
+ * @return true if the bins fit.
+ */
+static bool store_encode(const sketch_store_t* store, uint8_t* buffer, size_t capacity, size_t* position)
+{
+    uint64_t non_empty = 0;
+
+    if(store->total != 0)
+    {
+        for(int32_t key = store->min_key; key <= store->max_key; key++)
+        {
+            if(store->counts[key - store->offset] != 0)
+                non_empty++;
+        }
+    }
+
+    if(!telemetry_append_varint(buffer, capacity, position, non_empty))
+        return false;
+
+    if(non_empty == 0)
+        return true;
+
+    bool first = true;
+    int32_t previous = 0;
+
+    for(int32_t key = store->min_key; key <= store->max_key; key++)
+    {
+        const uint64_t samples = store->counts[key - store->offset];
+
+        if(samples == 0)
+            continue;
+
+        // First key is absolute and may be negative, the others are deltas
+        const uint64_t key_field = first ?
+                                   (((uint64_t)(int64_t)key << 1) ^ (uint64_t)((int64_t)key >> 63)) :
+                                   (uint64_t)(key - previous);
+
+        if(!telemetry_append_varint(buffer, capacity, position, key_field) ||
+           !telemetry_append_varint(buffer, capacity, position, samples))
+        {
+            return false;
+        }
+
+        first = false;
+        previous = key;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Decodes bins written by store_encode() and adds them to a store.
+ *
+ * @param store Bin store.
+ * @param buffer Input buffer.
+ * @param length Input buffer size.
+ * @param position Current read position, advanced on success.
+ * @return true on success.
+ */
+static bool store_decode(sketch_store_t* store, const uint8_t* buffer, size_t length, size_t* position)
+{
+    uint64_t non_empty = 0;
+    int64_t key = 0;
+
+    if(!telemetry_read_varint(&non_empty, buffer, length, position))
+        return false;
+
+    for(uint64_t bin = 0; bin < non_empty; bin++)
+    {
+        uint64_t key_field = 0;
+        uint64_t samples = 0;
+
+        if(!telemetry_read_varint(&key_field, buffer, length, position) ||
+           !telemetry_read_varint(&samples, buffer, length, position))
+        {
+            return false;
+        }
+
+        key = (bin == 0) ?
+              ((int64_t)(key_field >> 1) ^ -(int64_t)(key_field & 1)) :
+              key + (int64_t)key_field;
+
+        if(key < INT32_MIN || key > INT32_MAX)
+            return false;
+
+        store_add(store, (int32_t)key, samples);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Initializes a bin store.
+ *
+ * @param store Bin store.
+ * @param bins Number of bins.
+ * @return true on success.
+ */
+static bool store_init(sketch_store_t* store, size_t bins)
+{
+    store->counts = (uint64_t*)calloc(bins, sizeof(uint64_t));
+    store->bins = bins;
+    store_reset(store);
+
+    return (store->counts != NULL);
+}
+
+/**
+ * @brief Sets the accuracy dependent constants of a sketch.
+ *
+ * @param sketch Sketch instance.
+ * @param relative_accuracy Accuracy, between 0 and 1.
+ */
+static void sketch_set_accuracy(telemetry_sketch_t* sketch, double relative_accuracy)
+{
+    sketch->relative_accuracy = relative_accuracy;
+    sketch->gamma = (1.0 + relative_accuracy) / (1.0 - relative_accuracy);
+    sketch->log_gamma = log(sketch->gamma);
+}
+
+/**
+ * @brief Returns the bin key of a positive magnitude.
+ *
+ * @param sketch Sketch instance.
+ * @param magnitude Finite value magnitude, at least TELEMETRY_SKETCH_MIN_INDEXABLE.
+ * @return Bin key, within int32 for accuracies from TELEMETRY_SKETCH_MIN_RELATIVE_ACCURACY.
+ */
+static inline int32_t sketch_key(const telemetry_sketch_t* sketch, double magnitude)
+{
+    return (int32_t)ceil(log(magnitude) / sketch->log_gamma);
+}
+
+/**
+ * @brief Returns the representative value of a bin.
+ *
+ * The value is the point of the bin with the same relative distance to
+ * both bounds, so any sample in the bin is within the sketch accuracy.
+ *
+ * @param sketch Sketch instance.
+ * @param key Bin key.
+ * @return Representative magnitude.
+ */
+static inline double sketch_value(const telemetry_sketch_t* sketch, int32_t key)
+{
+    return 2.0 * exp((double)key * sketch->log_gamma) / (1.0 + sketch->gamma);
+}
+
+/**
+ * @brief Returns the table slot of an event id.
+ *
+ * @param sketches Sketch set.
+ * @param event_id Event id to look for.
+ * @return Matching or first free slot, NULL if the table is full.
+ */
+static sketch_entry_t* find_slot(const telemetry_sketches_t* sketches, uint32_t event_id)
+{
+    // Fibonacci hashing spreads sequential ids over the table
+    size_t slot = (size_t)((event_id * 2654435761u) & (sketches->table_size - 1));
+
+    for(size_t probe = 0; probe < sketches->table_size; probe++)
+    {
+        sketch_entry_t* entry = &sketches->entries[slot];
+
+        if(entry->value_type == 0 || entry->event_id == event_id)
+            return entry;
+
+        slot = (slot + 1) & (sketches->table_size - 1);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Reads the sampled value from an event payload.
+ *
+ * @param entry Registration of the event id.
+ * @param event Event to read from.
+ * @param value Receives the value.
+ * @return false if the payload is too short for the value.
+ */
+static bool read_payload_value(const sketch_entry_t* entry, const telemetry_event_t* event, double* value)
+{
+    static const uint8_t sizes[] = { 0, 2, 2, 4, 4, 8, 8, 4, 8 };
+    if((size_t)entry->payload_offset + sizes[entry->value_type] > event->payload_size)
+        return false;
+
+    // Inline or in a pool block
+    const uint8_t* data = telemetry_event_payload(event);
+
+    if(data == NULL)
+        return false;
+
+    data += entry->payload_offset;
+
+    switch(entry->value_type)
+    {
+        case TELEMETRY_SKETCH_VALUE_U16: { uint16_t v; memcpy(&v, data, sizeof(v)); *value = (double)v; break; }
+        case TELEMETRY_SKETCH_VALUE_I16: { int16_t v;  memcpy(&v, data, sizeof(v)); *value = (double)v; break; }
+        case TELEMETRY_SKETCH_VALUE_U32: { uint32_t v; memcpy(&v, data, sizeof(v)); *value = (double)v; break; }
+        case TELEMETRY_SKETCH_VALUE_I32: { int32_t v;  memcpy(&v, data, sizeof(v)); *value = (double)v; break; }
+        case TELEMETRY_SKETCH_VALUE_U64: { uint64_t v; memcpy(&v, data, sizeof(v)); *value = (double)v; break; }
+        case TELEMETRY_SKETCH_VALUE_I64: { int64_t v;  memcpy(&v, data, sizeof(v)); *value = (double)v; break; }
+        case TELEMETRY_SKETCH_VALUE_FLOAT: { float v;  memcpy(&v, data, sizeof(v)); *value = (double)v; break; }
+        case TELEMETRY_SKETCH_VALUE_DOUBLE: memcpy(value, data, sizeof(*value)); break;
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+// Global function definitions
+
+/**
+ * @brief Initializes a sketch.
+ *
+ * @param out_sketch Receives the sketch.
+ * @param relative_accuracy Accuracy between TELEMETRY_SKETCH_MIN_RELATIVE_ACCURACY and 1, 0 for the default.
+ * @param max_bins Bins per sign, 0 for the default.
+ * @return true on success, false on failure.
+ */
+bool telemetry_sketch_init(telemetry_sketch_t** out_sketch, double relative_accuracy, size_t max_bins)
+{
+    if(out_sketch == NULL || relative_accuracy < 0.0 || relative_accuracy >= 1.0 ||
+       (relative_accuracy != 0.0 && relative_accuracy < TELEMETRY_SKETCH_MIN_RELATIVE_ACCURACY))
+    {
+        return false;
+    }
+
+    if(relative_accuracy == 0.0)
+        relative_accuracy = TELEMETRY_SKETCH_DEFAULT_RELATIVE_ACCURACY;
+
+    if(max_bins == 0)
+        max_bins = TELEMETRY_SKETCH_DEFAULT_MAX_BINS;
+
+    telemetry_sketch_t* sketch = (telemetry_sketch_t*)calloc(1, sizeof(*sketch));
+
+    if(sketch == NULL)
+    {
+        return false;
+    }
+
+    if(!store_init(&sketch->positive, max_bins) || !store_init(&sketch->negative, max_bins))
+    {
+        telemetry_sketch_free(sketch);
+        return false;
+    }
+
+    sketch_set_accuracy(sketch, relative_accuracy);
+    telemetry_sketch_reset(sketch);
+
+    *out_sketch = sketch;
+
+    return true;
+}
+
+/**
+ * @brief Frees a sketch.
+ *
+ * @param sketch Sketch instance.
+ */
+void telemetry_sketch_free(telemetry_sketch_t* sketch)
+{
+    if(sketch == NULL)
+        return;
+
+    free(sketch->positive.counts);
+    free(sketch->negative.counts);
+    free(sketch);
+}
+
+/**
+ * @brief Adds one sample.
+ *
+ * NaN and infinities are ignored, they have no bin.
+ *
+ * @param sketch Sketch instance.
+ * @param value Sample value.
+ */
+void telemetry_sketch_add(telemetry_sketch_t* sketch, double value)
+{
+    if(sketch == NULL || !isfinite(value))
+        return;
+
+    if(value >= TELEMETRY_SKETCH_MIN_INDEXABLE)
+    {
+        store_add(&sketch->positive, sketch_key(sketch, value), 1);
+    }
+    else if(value <= -TELEMETRY_SKETCH_MIN_INDEXABLE)
+    {
+        store_add(&sketch->negative, sketch_key(sketch, -value), 1);
+    }
+    else
+    {
+        sketch->zero_count++;
+    }
+
+    if(sketch->count == 0 || value < sketch->min)
+        sketch->min = value;
+
+    if(sketch->count == 0 || value > sketch->max)
+        sketch->max = value;
+
+    sketch->count++;
+    sketch->sum += value;
+}
+
+/**
+ * @brief Empties a sketch, keeping its accuracy.
+ *
+ * @param sketch Sketch instance.
+ */
+void telemetry_sketch_reset(telemetry_sketch_t* sketch)
+{
+    if(sketch == NULL)
+        return;
+
+    store_reset(&sketch->positive);
+    store_reset(&sketch->negative);
+
+    sketch->count = 0;
+    sketch->zero_count = 0;
+    sketch->sum = 0.0;
+    sketch->min = 0.0;
+    sketch->max = 0.0;
+}
+
+/**
+ * @brief Adds one sketch into another.
+ *
+ * The result is the sketch of both sample sets, with the same accuracy.
+ *
+ * @param dst Sketch to add to.
+ * @param src Sketch to add.
+ * @return false if the sketches use different accuracies.
+ */
+bool telemetry_sketch_merge(telemetry_sketch_t* dst, const telemetry_sketch_t* src)
+{
+    if(dst == NULL || src == NULL || dst->gamma != src->gamma)
+    {
+        return false;
+    }
+
+    if(src->count == 0)
+        return true;
+
+    const sketch_store_t* stores[2] = { &src->positive, &src->negative };
+    sketch_store_t* targets[2] = { &dst->positive, &dst->negative };
+
+    for(size_t store = 0; store < 2; store++)
+    {
+        if(stores[store]->total == 0)
+            continue;
+
+        for(int32_t key = stores[store]->min_key; key <= stores[store]->max_key; key++)
+        {
+            const uint64_t samples = stores[store]->counts[key - stores[store]->offset];
+
+            if(samples != 0)
+                store_add(targets[store], key, samples);
+        }
+    }
+
+    if(dst->count == 0 || src->min < dst->min)
+        dst->min = src->min;
+
+    if(dst->count == 0 || src->max > dst->max)
+        dst->max = src->max;
+
+    dst->count += src->count;
+    dst->zero_count += src->zero_count;
+    dst->sum += src->sum;
+
+    return true;
+}
+
+/**
+ * @brief Returns the value at a percentile.
+ *
+ * Walks the negative bins from the largest magnitude, then the zero bin,
+ * then the positive bins, to the bin holding the requested rank.
+ *
+ * @param sketch Sketch instance.
+ * @param percentile Percentile from 0 to 100.
+ * @return Value within the relative accuracy of the exact one, clamped to
+ *         the recorded min and max. 0.0 for an empty sketch.
+ */
+double telemetry_sketch_percentile(const telemetry_sketch_t* sketch, double percentile)
+{
+    if(sketch == NULL || sketch->count == 0)
+        return 0.0;
+
+    if(percentile < 0.0)
+        percentile = 0.0;
+
+    if(percentile > 100.0)
+        percentile = 100.0;
+
+    const double rank = (percentile / 100.0) * (double)(sketch->count - 1);
+    double value = sketch->max;
+    uint64_t seen = 0;
+    bool found = false;
+
+    const sketch_store_t* negative = &sketch->negative;
+    if(negative->total != 0)
+    {
+        for(int32_t key = negative->max_key; key >= negative->min_key && !found; key--)
+        {
+            seen += negative->counts[key - negative->offset];
+
+            if((double)seen > rank)
+            {
+                value = -sketch_value(sketch, key);
+                found = true;
+            }
+        }
+    }
+
+    seen += sketch->zero_count;
+    if(!found && (double)seen > rank)
+    {
+        value = 0.0;
+        found = true;
+    }
+
+    const sketch_store_t* positive = &sketch->positive;
+    if(!found && positive->total != 0)
+    {
+        for(int32_t key = positive->min_key; key <= positive->max_key && !found; key++)
+        {
+            seen += positive->counts[key - positive->offset];
+
+            if((double)seen > rank)
+            {
+                value = sketch_value(sketch, key);
+                found = true;
+            }
+        }
+    }
+
+    if(value < sketch->min)
+        value = sketch->min;
+
+    if(value > sketch->max)
+        value = sketch->max;
+
+    return value;
+}
+
+/**
+ * @brief Encodes a sketch.
+ *
+ * @param sketch Sketch instance.
+ * @param encoded_buffer Output buffer.
+ * @param buffer_capacity Output buffer size.
+ * @return Bytes written, 0 if the buffer is too small.
+ */
+size_t telemetry_sketch_encode(const telemetry_sketch_t* sketch, uint8_t* encoded_buffer, size_t buffer_capacity)
+{
+    size_t position = 0;
+
+    if(sketch == NULL || encoded_buffer == NULL)
+        return 0;
+
+    const uint64_t accuracy_ppm = (uint64_t)(sketch->relative_accuracy * SKETCH_ACCURACY_SCALE + 0.5);
+
+    if(!telemetry_append_varint(encoded_buffer, buffer_capacity, &position, accuracy_ppm) ||
+       !telemetry_append_varint(encoded_buffer, buffer_capacity, &position, sketch->count) ||
+       !append_double(encoded_buffer, buffer_capacity, &position, sketch->sum) ||
+       !append_double(encoded_buffer, buffer_capacity, &position, sketch->min) ||
+       !append_double(encoded_buffer, buffer_capacity, &position, sketch->max) ||
+       !telemetry_append_varint(encoded_buffer, buffer_capacity, &position, sketch->zero_count) ||
+       !store_encode(&sketch->positive, encoded_buffer, buffer_capacity, &position) ||
+       !store_encode(&sketch->negative, encoded_buffer, buffer_capacity, &position))
+    {
+        return 0;
+    }
+
+    return position;
+}
+
+/**
+ * @brief Decodes a sketch.
+ *
+ * The sketch keeps its bin count; data wider than that is collapsed the
+ * same way as when adding samples.
+ *
+ * @param sketch Initialized sketch, its content is replaced.
+ * @param buffer Input buffer.
+ * @param buffer_length Readable bytes.
+ * @return Bytes consumed, 0 on error.
+ */
+size_t telemetry_sketch_decode(telemetry_sketch_t* sketch, const uint8_t* buffer, size_t buffer_length)
+{
+    size_t position = 0;
+    uint64_t accuracy_ppm = 0;
+
+    if(sketch == NULL || buffer == NULL)
+        return 0;
+
+    if(!telemetry_read_varint(&accuracy_ppm, buffer, buffer_length, &position) ||
+       accuracy_ppm == 0 || accuracy_ppm >= (uint64_t)SKETCH_ACCURACY_SCALE)
+    {
+        return 0;
+    }
+
+    telemetry_sketch_reset(sketch);
+    sketch_set_accuracy(sketch, (double)accuracy_ppm / SKETCH_ACCURACY_SCALE);
+
+    if(!telemetry_read_varint(&sketch->count, buffer, buffer_length, &position) ||
+       !read_double(&sketch->sum, buffer, buffer_length, &position) ||
+       !read_double(&sketch->min, buffer, buffer_length, &position) ||
+       !read_double(&sketch->max, buffer, buffer_length, &position) ||
+       !telemetry_read_varint(&sketch->zero_count, buffer, buffer_length, &position) ||
+       !store_decode(&sketch->positive, buffer, buffer_length, &position) ||
+       !store_decode(&sketch->negative, buffer, buffer_length, &position))
+    {
+        telemetry_sketch_reset(sketch);
+        return 0;
+    }
+
+    return position;
+}
+
+/**
+ * @brief Returns the number of samples.
+ *
+ * @param sketch Sketch instance.
+ * @return Number of samples added since the last reset.
+ */
+uint64_t telemetry_sketch_count(const telemetry_sketch_t* sketch)
+{
+    return (sketch == NULL) ? 0 : sketch->count;
+}
+
+/**
+ * @brief Returns the sum of all samples.
+ *
+ * @param sketch Sketch instance.
+ * @return Exact sum of the samples.
+ */
+double telemetry_sketch_sum(const telemetry_sketch_t* sketch)
+{
+    return (sketch == NULL) ? 0.0 : sketch->sum;
+}
+
+/**
+ * @brief Returns the smallest sample.
+ *
+ * @param sketch Sketch instance.
+ * @return Exact minimum, 0.0 when empty.
+ */
+double telemetry_sketch_min(const telemetry_sketch_t* sketch)
+{
+    return (sketch == NULL) ? 0.0 : sketch->min;
+}
+
+/**
+ * @brief Returns the largest sample.
+ *
+ * @param sketch Sketch instance.
+ * @return Exact maximum, 0.0 when empty.
+ */
+double telemetry_sketch_max(const telemetry_sketch_t* sketch)
+{
+    return (sketch == NULL) ? 0.0 : sketch->max;
+}
+
+/**
+ * @brief Returns the relative accuracy of a sketch.
+ *
+ * @param sketch Sketch instance.
+ * @return Relative accuracy, between 0 and 1.
+ */
+double telemetry_sketch_relative_accuracy(const telemetry_sketch_t* sketch)
+{
+    return (sketch == NULL) ? 0.0 : sketch->relative_accuracy;
+}
+
+/**
+ * @brief Initializes a sketch set.
+ *
+ * Sketches are allocated on registration, absorbing events never
+ * allocates.
+ *
+ * @param out_sketches Receives the set.
+ * @param max_sketches Number of event ids that can be registered.
+ * @param relative_accuracy Accuracy of every sketch, at least TELEMETRY_SKETCH_MIN_RELATIVE_ACCURACY, 0 for the default.
+ * @param max_bins Bins per sign of every sketch, 0 for the default.
+ * @return true on success, false on failure.
+ */
+bool telemetry_sketches_init(telemetry_sketches_t** out_sketches, size_t max_sketches, double relative_accuracy, size_t max_bins)
+{
+    if(out_sketches == NULL || max_sketches == 0 || relative_accuracy < 0.0 || relative_accuracy >= 1.0 ||
+       (relative_accuracy != 0.0 && relative_accuracy < TELEMETRY_SKETCH_MIN_RELATIVE_ACCURACY))
+    {
+        return false;
+    }
+
+    telemetry_sketches_t* sketches = (telemetry_sketches_t*)calloc(1, sizeof(*sketches));
+
+    if(sketches == NULL)
+    {
+        return false;
+    }
+
+    // Keep the table at most half full so probes stay short
+    size_t table_size = 1;
+    while(table_size < max_sketches * 2)
+    {
+        table_size <<= 1;
+    }
+
+    sketches->entries = (sketch_entry_t*)calloc(table_size, sizeof(sketch_entry_t));
+
+    if(sketches->entries == NULL)
+    {
+        free(sketches);
+        return false;
+    }
+
+    sketches->table_size = table_size;
+    sketches->capacity = max_sketches;
+    sketches->registered = 0;
+    sketches->relative_accuracy = relative_accuracy;
+    sketches->max_bins = max_bins;
+
+    *out_sketches = sketches;
+
+    return true;
+}
+
+/**
+ * @brief Frees a sketch set and all its sketches.
+ *
+ * @param sketches Sketch set.
+ */
+void telemetry_sketches_free(telemetry_sketches_t* sketches)
+{
+    if(sketches == NULL)
+        return;
+
+    for(size_t slot = 0; slot < sketches->table_size; slot++)
+    {
+        telemetry_sketch_free(sketches->entries[slot].sketch);
+    }
+
+    free(sketches->entries);
+    free(sketches);
+}
+
+/**
+ * @brief Registers an event id to be sketched.
+ *
+ * Registering an id again updates how its value is read.
+ *
+ * @param sketches Sketch set.
+ * @param event_id Event id to sketch.
+ * @param value_type How the value is stored in the payload.
+ * @param payload_offset Byte offset of the value in the payload.
+ * @return false if the set is full or the arguments are invalid.
+ */
+bool telemetry_sketches_register(telemetry_sketches_t* sketches, uint32_t event_id,
+                                 telemetry_sketch_value_t value_type, size_t payload_offset)
+{
+    if(sketches == NULL || value_type < TELEMETRY_SKETCH_VALUE_U16 || value_type > TELEMETRY_SKETCH_VALUE_DOUBLE ||
+       payload_offset >= TELEMETRY_EVENT_PAYLOAD_MAX)
+    {
+        return false;
+    }
+
+    sketch_entry_t* entry = find_slot(sketches, event_id);
+
+    if(entry == NULL)
+    {
+        return false;
+    }
+
+    if(entry->value_type == 0)
+    {
+        if(sketches->registered >= sketches->capacity)
+            return false;
+
+        if(!telemetry_sketch_init(&entry->sketch, sketches->relative_accuracy, sketches->max_bins))
+            return false;
+
+        entry->event_id = event_id;
+        sketches->registered++;
+    }
+
+    entry->value_type = (uint8_t)value_type;
+    entry->payload_offset = (uint16_t)payload_offset;
+
+    return true;
+}
+
+/**
+ * @brief Adds an event to its sketch.
+ *
+ * @param sketches Sketch set.
+ * @param event Event taken from the ring buffer.
+ * @return true if the event was absorbed and must not be sent, false if it
+ *         is not sketched or its payload is too short.
+ */
+bool telemetry_sketches_absorb(telemetry_sketches_t* sketches, const telemetry_event_t* event)
+{
+    double value = 0.0;
+
+    if(sketches == NULL || event == NULL)
+        return false;
+
+    const sketch_entry_t* entry = find_slot(sketches, event->event_id);
+
+    if(entry == NULL || entry->value_type == 0 || !read_payload_value(entry, event, &value))
+        return false;
+
+    telemetry_sketch_add(entry->sketch, value);
+
+    return true;
+}
+
+/**
+ * @brief Encodes sketches into a sketch batch payload.
+ *
+ * Works like telemetry_metrics_encode(): starts at *cursor, writes as many
+ * records as fit and stores where to continue. Empty sketches are skipped,
+ * and so is a sketch too large for an empty payload.
+ *
+ * @param sketches Sketch set.
+ * @param encoded_buffer Output buffer for the payload.
+ * @param buffer_capacity Output buffer size.
+ * @param cursor Table position to continue from, 0 for a new snapshot.
+ * @return Bytes written, 0 when there is nothing left to encode.
+ */
+size_t telemetry_sketches_encode(const telemetry_sketches_t* sketches, uint8_t* encoded_buffer, size_t buffer_capacity, size_t* cursor)
+{
+    if(sketches == NULL || encoded_buffer == NULL || cursor == NULL || buffer_capacity < 2)
+    {
+        return 0;
+    }
+
+    size_t position = 2;            // Room for the record count
+    uint16_t records = 0;
+
+    while(*cursor < sketches->table_size && records < UINT16_MAX)
+    {
+        const sketch_entry_t* entry = &sketches->entries[*cursor];
+
+        if(entry->value_type != 0 && entry->sketch->count != 0)
+        {
+            size_t written = 0;
+            size_t record_position = position;
+
+            if(telemetry_append_varint(encoded_buffer, buffer_capacity, &record_position, entry->event_id))
+            {
+                written = telemetry_sketch_encode(entry->sketch, &encoded_buffer[record_position], buffer_capacity - record_position);
+            }
+
+            if(written == 0)
+            {
+                // Sketch too large even for an empty payload, skip it
+                if(records == 0)
+                {
+                    (*cursor)++;
+                    continue;
+                }
+
+                // Payload full, continue in the next batch
+                break;
+            }
+
+            position = record_position + written;
+            records++;
+        }
+
+        (*cursor)++;
+    }
+
+    if(records == 0)
+    {
+        return 0;
+    }
+
+    telemetry_put_u16_be(encoded_buffer, records);
+
+    return position;
+}
+
+/**
+ * @brief Empties every sketch of the set.
+ *
+ * @param sketches Sketch set.
+ */
+void telemetry_sketches_reset(telemetry_sketches_t* sketches)
+{
+    if(sketches == NULL)
+        return;
+
+    for(size_t slot = 0; slot < sketches->table_size; slot++)
+    {
+        telemetry_sketch_reset(sketches->entries[slot].sketch);
+    }
+}
+
+/**
+ * @brief Returns the sketch of an event id.
+ *
+ * @param sketches Sketch set.
+ * @param event_id Registered event id.
+ * @return Sketch, or NULL if the id is not registered.
+ */
+const telemetry_sketch_t* telemetry_sketches_find(const telemetry_sketches_t* sketches, uint32_t event_id)
+{
+    if(sketches == NULL)
+        return NULL;
+
+    const sketch_entry_t* entry = find_slot(sketches, event_id);
+
+    return (entry == NULL || entry->value_type == 0) ? NULL : entry->sketch;
+}
+
+/**
+ * @brief Decodes the record count of a sketch batch payload.
+ *
+ * @param record_count Receives the number of records.
+ * @param buffer Payload buffer.
+ * @param buffer_length Payload length.
+ * @return Bytes consumed, 0 on error.
+ */
+size_t telemetry_sketches_decode_count(uint16_t* record_count, const uint8_t* buffer, size_t buffer_length)
+{
+    if(record_count == NULL || buffer == NULL || buffer_length < 2)
+    {
+        return 0;
+    }
+
+    *record_count = telemetry_get_u16_be(buffer);
+
+    return 2;
+}
+
+/**
+ * @brief Decodes one sketch batch record.
+ *
+ * @param event_id Receives the event id.
+ * @param sketch Initialized sketch receiving the data.
+ * @param buffer Input positioned at a record.
+ * @param buffer_length Readable bytes.
+ * @return Bytes consumed, 0 on error.
+ */
+size_t telemetry_sketches_decode_record(uint32_t* event_id, telemetry_sketch_t* sketch, const uint8_t* buffer, size_t buffer_length)
+{
+    size_t position = 0;
+    uint64_t value = 0;
+
+    if(event_id == NULL || sketch == NULL || buffer == NULL)
+    {
+        return 0;
+    }
+
+    if(!telemetry_read_varint(&value, buffer, buffer_length, &position))
+        return 0;
+
+    *event_id = (uint32_t)value;
+
+    const size_t consumed = telemetry_sketch_decode(sketch, &buffer[position], buffer_length - position);
+
+    if(consumed == 0)
+        return 0;
+
+    return position + consumed;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file quantile_sketch.h
+ * @brief Mergeable quantile sketches for numeric event payloads.
+ *
+ * DDSketch style sketch: a sample v lands in bin ceil(log_gamma(|v|)) with
+ * gamma = (1 + a) / (1 - a), so every quantile is answered within relative
+ * accuracy a. Positive and negative samples have their own bins, values
+ * closer to zero than TELEMETRY_SKETCH_MIN_INDEXABLE are counted as zero.
+ * The bin count is bounded; when a sketch would need more bins the lowest
+ * magnitudes are collapsed, which keeps the high quantiles exact to a.
+ *
+ * A sketch set maps event ids to sketches. The agent absorbs matching
+ * events into their sketch instead of sending them, and ships the sketches
+ * as TELEMETRY_SKETCH_BATCH messages once per metrics interval.
+ *
+ * Sketch batch payload (v1, varints are LEB128, doubles are IEEE 754 bits
+ * written big-endian):
+ * - u16 record count
+ * - per record: varint event id, then the sketch encoding:
+ *   varint accuracy in parts per million, varint count, f64 sum, f64 min,
+ *   f64 max, varint zero count, then the positive and the negative bins,
+ *   each as varint non-empty bin count, zigzag varint first key, varint
+ *   count, then (varint key delta, varint count) pairs.
+ *
+ * Sketches are not thread safe: one thread (the agent) adds, encodes and
+ * resets them. Register all event ids before the agent is started.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../api/type.h"
+#include "event.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Relative accuracy used when 0 is passed (1 %)
+#define TELEMETRY_SKETCH_DEFAULT_RELATIVE_ACCURACY  0.01
+// Finest relative accuracy, one ppm on the wire; keeps every bin key in int32
+#define TELEMETRY_SKETCH_MIN_RELATIVE_ACCURACY      1e-6
+// Bins per sign used when 0 is passed, covers a 13x value range at 1 % before collapsing
+#define TELEMETRY_SKETCH_DEFAULT_MAX_BINS           128u
+// Magnitudes below this are counted in the zero bin
+#define TELEMETRY_SKETCH_MIN_INDEXABLE              1e-9
+
+// How the sampled value is stored in the event payload (native byte order)
+typedef enum telemetry_sketch_value_e {
+    TELEMETRY_SKETCH_VALUE_U16      = 1,
+    TELEMETRY_SKETCH_VALUE_I16      = 2,
+    TELEMETRY_SKETCH_VALUE_U32      = 3,
+    TELEMETRY_SKETCH_VALUE_I32      = 4,
+    TELEMETRY_SKETCH_VALUE_U64      = 5,
+    TELEMETRY_SKETCH_VALUE_I64      = 6,
+    TELEMETRY_SKETCH_VALUE_FLOAT    = 7,
+    TELEMETRY_SKETCH_VALUE_DOUBLE   = 8
+} telemetry_sketch_value_t;
+
+typedef struct telemetry_sketch_s telemetry_sketch_t;
+typedef struct telemetry_sketches_s telemetry_sketches_t;
+
+
+// Sketch functions
+bool telemetry_sketch_init(telemetry_sketch_t** out_sketch, double relative_accuracy, size_t max_bins);
+void telemetry_sketch_free(telemetry_sketch_t* sketch);
+
+void telemetry_sketch_add(telemetry_sketch_t* sketch, double value);
+void telemetry_sketch_reset(telemetry_sketch_t* sketch);
+
+// Adds src into dst, both must use the same relative accuracy
+bool telemetry_sketch_merge(telemetry_sketch_t* dst, const telemetry_sketch_t* src);
+
+// Value at a percentile from 0 to 100, 0.0 for an empty sketch
+double telemetry_sketch_percentile(const telemetry_sketch_t* sketch, double percentile);
+
+size_t telemetry_sketch_encode(const telemetry_sketch_t* sketch, uint8_t* encoded_buffer, size_t buffer_capacity);
+
+// Replaces the sketch content, the accuracy is taken from the encoding
+size_t telemetry_sketch_decode(telemetry_sketch_t* sketch, const uint8_t* buffer, size_t buffer_length);
+
+
+// Helper functions
+uint64_t telemetry_sketch_count(const telemetry_sketch_t* sketch);
+double telemetry_sketch_sum(const telemetry_sketch_t* sketch);
+double telemetry_sketch_min(const telemetry_sketch_t* sketch);
+double telemetry_sketch_max(const telemetry_sketch_t* sketch);
+double telemetry_sketch_relative_accuracy(const telemetry_sketch_t* sketch);
+
+
+// Sketch set functions
+bool telemetry_sketches_init(telemetry_sketches_t** out_sketches, size_t max_sketches, double relative_accuracy, size_t max_bins);
+void telemetry_sketches_free(telemetry_sketches_t* sketches);
+
+// Sample events with this id: the value is read at payload_offset
+bool telemetry_sketches_register(telemetry_sketches_t* sketches, uint32_t event_id,
+                                 telemetry_sketch_value_t value_type, size_t payload_offset);
+
+// Agent thread : add the event to its sketch, returns false if the event is not sketched
+bool telemetry_sketches_absorb(telemetry_sketches_t* sketches, const telemetry_event_t* event);
+
+// Agent thread : encode non-empty sketches starting at *cursor, advances *cursor, returns bytes written
+size_t telemetry_sketches_encode(const telemetry_sketches_t* sketches, uint8_t* encoded_buffer, size_t buffer_capacity, size_t* cursor);
+
+// Agent thread : empty all sketches after they were shipped
+void telemetry_sketches_reset(telemetry_sketches_t* sketches);
+
+// Returns the sketch of an event id, NULL if not registered
+const telemetry_sketch_t* telemetry_sketches_find(const telemetry_sketches_t* sketches, uint32_t event_id);
+
+// Decode the record count at the start of a sketch batch payload, returns bytes consumed
+size_t telemetry_sketches_decode_count(uint16_t* record_count, const uint8_t* buffer, size_t buffer_length);
+
+// Decode one record into an initialized sketch, returns bytes consumed or 0 on error
+size_t telemetry_sketches_decode_record(uint32_t* event_id, telemetry_sketch_t* sketch, const uint8_t* buffer, size_t buffer_length);
+
+
+#ifdef __cplusplus
+    }
+#endif
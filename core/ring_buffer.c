@@ -10,6 +10,8 @@
 
 #include "ring_buffer.h"
 #include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
 
 
 // Struct declaration
@@ -24,8 +26,13 @@ typedef struct ring_buffer_s {
     atomic_size_t tail;
 
     atomic_uint_fast64_t dropped;
+
+    bool owned;                     // Allocated by ring_buffer_init, freed by ring_buffer_free
+    osal_memory_t mapping;          // Slots of ring_buffer_init_ex, not mapped otherwise
 } ring_buffer_t;
 
+_Static_assert(sizeof(ring_buffer_t) <= RING_BUFFER_STATE_BYTES, "RING_BUFFER_STATE_BYTES is too small");
+
 // Local function definitions
 
 /**
@@ -98,6 +105,121 @@ bool ring_buffer_init(ring_buffer_t** out_rb, size_t capacity)
     atomic_store_explicit(&rb->tail, 0, memory_order_relaxed);
     atomic_store_explicit(&rb->dropped, 0, memory_order_relaxed);
 
+    rb->owned = true;
+
+    *out_rb = rb;
+
+    return true;
+}
+
+/**
+ * @brief Fills ring allocation options with the defaults.
+ *
+ * The defaults allocate the slots like ring_buffer_init.
+ *
+ * @param options Options to initialize.
+ */
+void ring_buffer_options_init(ring_buffer_options_t* options)
+{
+    if(options == NULL)
+        return;
+
+    options->memory_flags = 0;
+    options->numa_node = OSAL_MEMORY_NODE_LOCAL;
+}
+
+/**
+ * @brief Initializes a ring buffer with mapped slots.
+ *
+ * The slots are mapped with the memory options, so a large ring can be
+ * faulted in, locked and placed on the producer's NUMA node before the
+ * first burst. Options the system refuses are skipped, see
+ * ring_buffer_memory_flags.
+ *
+ * @param out_rb Receives the ring buffer.
+ * @param capacity Buffer capacity.
+ * @param options Allocation options, NULL or no memory flags for ring_buffer_init.
+ * @return true on success, false on failure.
+ */
+bool ring_buffer_init_ex(ring_buffer_t** out_rb, size_t capacity, const ring_buffer_options_t* options)
+{
+    if(options == NULL || options->memory_flags == 0)
+    {
+        return ring_buffer_init(out_rb, capacity);
+    }
+
+    if(out_rb == NULL || capacity == 0 || capacity >= SIZE_MAX / sizeof(telemetry_event_t))
+    {
+        return false;
+    }
+
+    ring_buffer_t* rb = (ring_buffer_t*)calloc(1, sizeof(*rb));
+
+    if(rb == NULL)
+    {
+        return false;
+    }
+
+    if(!osal_memory_map(&rb->mapping, (capacity + 1) * sizeof(telemetry_event_t), options->memory_flags, options->numa_node))
+    {
+        free(rb);
+        return false;
+    }
+
+    rb->buffer = (telemetry_event_t*)rb->mapping.address;
+    rb->capacity = capacity;
+    rb->allocation = capacity + 1;
+
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    atomic_init(&rb->dropped, 0);
+
+    rb->owned = true;
+
+    *out_rb = rb;
+
+    return true;
+}
+
+/**
+ * @brief Initializes a ring buffer in caller storage.
+ *
+ * Nothing is allocated; the state and the slots are placed in memory, which
+ * must stay valid until ring_buffer_free.
+ *
+ * @param out_rb Receives the ring buffer.
+ * @param memory Storage aligned to TELEMETRY_STORAGE_ALIGN.
+ * @param memory_bytes Size of memory, at least RING_BUFFER_STORAGE_BYTES(capacity).
+ * @param capacity Buffer capacity.
+ * @return true on success, false on failure.
+ */
+bool ring_buffer_init_static(ring_buffer_t** out_rb, void* memory, size_t memory_bytes, size_t capacity)
+{
+    if(out_rb == NULL || capacity == 0 || !telemetry_storage_aligned(memory))
+    {
+        return false;
+    }
+
+    if(capacity > (SIZE_MAX - RING_BUFFER_STATE_BYTES) / sizeof(telemetry_event_t) - 2u ||
+       memory_bytes < RING_BUFFER_STORAGE_BYTES(capacity))
+    {
+        return false;
+    }
+
+    // State first, the slots start on the next cache line
+    ring_buffer_t* rb = (ring_buffer_t*)memory;
+    memset(rb, 0, sizeof(*rb));
+
+    rb->buffer = (telemetry_event_t*)((uint8_t*)memory + RING_BUFFER_STATE_BYTES);
+    rb->capacity = capacity;
+    rb->allocation = capacity + 1;
+
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    atomic_init(&rb->dropped, 0);
+
+    rb->owned = false;
+
     *out_rb = rb;
 
     return true;
@@ -107,7 +229,10 @@ bool ring_buffer_init(ring_buffer_t** out_rb, size_t capacity)
 /**
  * @brief Frees the ring buffer.
  *
- * Deallocates memory and resets variables.
+ * Deallocates memory and resets variables. A ring in caller storage is
+ * only reset, the storage can be used again afterwards. Events still
+ * queued are discarded; the blocks of pooled ones go back to their pool,
+ * so the ring must be freed before that pool.
  *
  * @param rb Ring buffer instance.
  */
@@ -116,9 +241,24 @@ void ring_buffer_free(ring_buffer_t* rb)
     // Check the Null ptr
     if(rb == NULL)
         return;
-    
-    // Free the ring buffer
-    free(rb->buffer);
+
+    telemetry_event_t event;
+
+    // Nobody sends these any more, give their blocks back
+    while(ring_buffer_pop(rb, &event))
+        telemetry_event_release_payload(&event);
+
+    if(rb->owned)
+    {
+        if(rb->mapping.address != NULL)
+            osal_memory_unmap(&rb->mapping);
+        else
+            free(rb->buffer);
+
+        free(rb);
+        return;
+    }
+
     rb->buffer = NULL;
 
     // Initialize the variables to 0
@@ -243,3 +383,49 @@ uint64_t ring_buffer_dropped(const ring_buffer_t* rb)
     return (atomic_load_explicit(&rb->dropped, memory_order_relaxed));
     
 }
+
+/**
+ * @brief Returns the number of events the ring buffer can hold.
+ *
+ * @param rb Ring buffer instance.
+ * @return Capacity in events.
+ */
+size_t ring_buffer_capacity(const ring_buffer_t* rb)
+{
+    if(rb == NULL || rb->buffer == NULL)
+        return 0;
+
+    return rb->capacity;
+}
+
+/**
+ * @brief Moves the mapped slots of a ring to a NUMA node.
+ *
+ * Lets a ring allocated up front follow the thread that pushes into it.
+ * Pushes and pops may go on meanwhile, migration keeps the contents.
+ *
+ * @param rb Ring buffer from ring_buffer_init_ex with memory flags.
+ * @param numa_node Target node, OSAL_MEMORY_NODE_LOCAL for the calling thread's node.
+ * @return true if the slots are bound to the node.
+ */
+bool ring_buffer_bind_node(ring_buffer_t* rb, int numa_node)
+{
+    if(rb == NULL || rb->mapping.address == NULL)
+        return false;
+
+    return osal_memory_bind(&rb->mapping, numa_node);
+}
+
+/**
+ * @brief Returns the memory options that took effect for the slots.
+ *
+ * @param rb Ring buffer instance.
+ * @return OSAL_MEMORY_* bits, 0 for slots from ring_buffer_init or caller storage.
+ */
+uint32_t ring_buffer_memory_flags(const ring_buffer_t* rb)
+{
+    if(rb == NULL)
+        return 0;
+
+    return rb->mapping.applied;
+}
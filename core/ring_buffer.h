@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include "event.h"
+#include "static_storage.h"
+#include "osal_memory.h"
 
 #ifdef __cplusplus
     extern "C" {
@@ -11,11 +13,36 @@
 
 typedef struct ring_buffer_s ring_buffer_t;
 
+// Bytes of ring buffer state in static storage
+#define RING_BUFFER_STATE_BYTES 128u
+
+// Storage for ring_buffer_init_static with the given capacity, state followed by the slots
+#define RING_BUFFER_STORAGE_BYTES(capacity) \
+    (RING_BUFFER_STATE_BYTES + TELEMETRY_STORAGE_ROUND(((size_t)(capacity) + 1u) * sizeof(telemetry_event_t)))
+
+
+// Allocation options of ring_buffer_init_ex
+typedef struct ring_buffer_options_s {
+    uint32_t memory_flags;      // OSAL_MEMORY_* options for the slots, 0 allocates them like ring_buffer_init
+    int numa_node;              // Node for OSAL_MEMORY_NUMA_BIND, OSAL_MEMORY_NODE_LOCAL for the calling thread
+} ring_buffer_options_t;
 
 // global ring buffer functions
 bool ring_buffer_init(ring_buffer_t** out_rb, size_t capacity);
+// Discards queued events; pooled ones give their block back, so free the ring before its pool
 void ring_buffer_free(ring_buffer_t* rb);
 
+// Same as ring_buffer_init, with the slots mapped by osal_memory_map; NULL options allocate like ring_buffer_init
+void ring_buffer_options_init(ring_buffer_options_t* options);
+bool ring_buffer_init_ex(ring_buffer_t** out_rb, size_t capacity, const ring_buffer_options_t* options);
+
+// Same as ring_buffer_init, in caller storage of RING_BUFFER_STORAGE_BYTES(capacity) bytes
+bool ring_buffer_init_static(ring_buffer_t** out_rb, void* memory, size_t memory_bytes, size_t capacity);
+
+// Moves the slots of a ring from ring_buffer_init_ex to a NUMA node, OSAL_MEMORY_NODE_LOCAL for the calling
+// thread's; false for other rings or when the system refuses
+bool ring_buffer_bind_node(ring_buffer_t* rb, int numa_node);
+
 // Producer thread : push the event to the ring buffer
 bool ring_buffer_push(ring_buffer_t* rb, telemetry_event_t* event);
 
@@ -26,6 +53,8 @@ bool ring_buffer_pop(ring_buffer_t* rb, telemetry_event_t* out);
 // Helper functions
 size_t ring_buffer_count(const ring_buffer_t* rb);
 uint64_t ring_buffer_dropped(const ring_buffer_t* rb);
+size_t ring_buffer_capacity(const ring_buffer_t* rb);
+uint32_t ring_buffer_memory_flags(const ring_buffer_t* rb);
 
 
 
@@ -0,0 +1,247 @@
+/**
+ * @file sharded_counter.c
+ * @brief Sharded counter implementation.
+ *
+ * Per-thread cache line padded slots summed by the reader.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+
+#include "sharded_counter.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Slots are padded to this size so two threads never share a line
+#define SHARDED_COUNTER_CACHE_LINE 64u
+
+// Struct declaration
+
+typedef struct counter_shard_s {
+    _Alignas(SHARDED_COUNTER_CACHE_LINE) atomic_uint_fast64_t value;
+} counter_shard_t;
+
+typedef struct sharded_counter_s {
+    counter_shard_t* shards;
+    size_t shard_mask;              // shard count - 1, shard count is a power of two
+    bool owned;                     // Allocated by sharded_counter_init, freed by sharded_counter_free
+} sharded_counter_t;
+
+_Static_assert(SHARDED_COUNTER_CACHE_LINE == TELEMETRY_STORAGE_ALIGN, "a shard must fill one storage line");
+_Static_assert(sizeof(sharded_counter_t) <= TELEMETRY_STORAGE_ALIGN, "counter state must fit one storage line");
+
+// Thread slot numbers are handed out once per thread and shared by all counters
+static atomic_size_t next_thread_slot = 0;
+static _Thread_local size_t thread_slot = SIZE_MAX;
+
+// Local function definitions
+
+/**
+ * @brief Returns the slot number of the calling thread.
+ *
+ * Assigned on first use, so threads spread round robin over the shards.
+ *
+ * @return Slot number of this thread.
+ */
+static inline size_t current_thread_slot(void)
+{
+    if(thread_slot == SIZE_MAX)
+    {
+        thread_slot = atomic_fetch_add_explicit(&next_thread_slot, 1, memory_order_relaxed);
+    }
+
+    return thread_slot;
+}
+
+/**
+ * @brief Rounds up to the next power of two.
+ *
+ * @param value Requested shard count (non zero).
+ * @return Power of two not smaller than value.
+ */
+static inline size_t round_up_pow2(size_t value)
+{
+    size_t result = 1;
+
+    while(result < value)
+    {
+        result <<= 1;
+    }
+
+    return result;
+}
+
+// Global function definitions
+
+/**
+ * @brief Initializes a sharded counter.
+ *
+ * @param out_counter Receives the counter.
+ * @param shard_count Number of slots, rounded up to a power of two. 0 uses the default.
+ * @return true on success, false on failure.
+ */
+bool sharded_counter_init(sharded_counter_t** out_counter, size_t shard_count)
+{
+    if(out_counter == NULL)
+    {
+        return false;
+    }
+
+    if(shard_count == 0)
+    {
+        shard_count = SHARDED_COUNTER_DEFAULT_SHARDS;
+    }
+
+    shard_count = round_up_pow2(shard_count);
+
+    sharded_counter_t* counter = (sharded_counter_t*)calloc(1, sizeof(*counter));
+
+    if(counter == NULL)
+    {
+        return false;
+    }
+
+    // Each shard is exactly one cache line, so the size is a multiple of the alignment
+    counter->shards = (counter_shard_t*)aligned_alloc(SHARDED_COUNTER_CACHE_LINE, shard_count * sizeof(counter_shard_t));
+
+    if(counter->shards == NULL)
+    {
+        free(counter);
+        return false;
+    }
+
+    for(size_t index = 0; index < shard_count; index++)
+    {
+        atomic_init(&counter->shards[index].value, 0);
+    }
+
+    counter->shard_mask = shard_count - 1;
+    counter->owned = true;
+
+    *out_counter = counter;
+
+    return true;
+}
+
+/**
+ * @brief Initializes a sharded counter in caller storage.
+ *
+ * Nothing is allocated; memory must stay valid until sharded_counter_free.
+ *
+ * @param out_counter Receives the counter.
+ * @param memory Storage aligned to TELEMETRY_STORAGE_ALIGN.
+ * @param memory_bytes Size of memory, at least SHARDED_COUNTER_STORAGE_BYTES of the rounded count.
+ * @param shard_count Number of slots, rounded up to a power of two. 0 uses the default.
+ * @return true on success, false on failure.
+ */
+bool sharded_counter_init_static(sharded_counter_t** out_counter, void* memory, size_t memory_bytes, size_t shard_count)
+{
+    if(out_counter == NULL || !telemetry_storage_aligned(memory))
+    {
+        return false;
+    }
+
+    if(shard_count == 0)
+    {
+        shard_count = SHARDED_COUNTER_DEFAULT_SHARDS;
+    }
+
+    shard_count = round_up_pow2(shard_count);
+
+    if(memory_bytes < SHARDED_COUNTER_STORAGE_BYTES(shard_count))
+    {
+        return false;
+    }
+
+    // State on the first line, shards on the ones behind it
+    sharded_counter_t* counter = (sharded_counter_t*)memory;
+    memset(counter, 0, sizeof(*counter));
+
+    counter->shards = (counter_shard_t*)((uint8_t*)memory + TELEMETRY_STORAGE_ALIGN);
+
+    for(size_t index = 0; index < shard_count; index++)
+    {
+        atomic_init(&counter->shards[index].value, 0);
+    }
+
+    counter->shard_mask = shard_count - 1;
+    counter->owned = false;
+
+    *out_counter = counter;
+
+    return true;
+}
+
+/**
+ * @brief Frees a sharded counter.
+ *
+ * A counter in caller storage has nothing to free and is left as is.
+ *
+ * @param counter Counter instance.
+ */
+void sharded_counter_free(sharded_counter_t* counter)
+{
+    if(counter == NULL || !counter->owned)
+        return;
+
+    free(counter->shards);
+    free(counter);
+}
+
+/**
+ * @brief Adds to the calling thread's slot.
+ *
+ * The slot is only shared when there are more threads than shards, so the
+ * atomic add is normally uncontended and its cache line stays local.
+ *
+ * @param counter Counter instance.
+ * @param delta Amount to add.
+ */
+void sharded_counter_add(sharded_counter_t* counter, uint64_t delta)
+{
+    if(counter == NULL)
+        return;
+
+    counter_shard_t* shard = &counter->shards[current_thread_slot() & counter->shard_mask];
+
+    atomic_fetch_add_explicit(&shard->value, delta, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the sum of all slots.
+ *
+ * Increments that happen while summing may or may not be included.
+ *
+ * @param counter Counter instance.
+ * @return Counter total.
+ */
+uint64_t sharded_counter_sum(const sharded_counter_t* counter)
+{
+    if(counter == NULL)
+        return 0;
+
+    uint64_t total = 0;
+
+    for(size_t index = 0; index <= counter->shard_mask; index++)
+    {
+        total += atomic_load_explicit(&counter->shards[index].value, memory_order_relaxed);
+    }
+
+    return total;
+}
+
+/**
+ * @brief Returns the number of slots.
+ *
+ * @param counter Counter instance.
+ * @return Number of shards.
+ */
+size_t sharded_counter_shards(const sharded_counter_t* counter)
+{
+    if(counter == NULL)
+        return 0;
+
+    return counter->shard_mask + 1;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../api/type.h"
+#include "static_storage.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Shards used when sharded_counter_init is called with 0
+#define SHARDED_COUNTER_DEFAULT_SHARDS 16u
+
+/*
+ * Counter for values incremented from many threads.
+ * Each thread adds to its own cache line padded slot, the reader sums all
+ * slots. Increments never bounce a cache line between cores as long as
+ * there are no more threads than shards.
+ */
+typedef struct sharded_counter_s sharded_counter_t;
+
+// Storage for sharded_counter_init_static, shard_count must already be a power of two.
+// One cache line of state, then one cache line per shard.
+#define SHARDED_COUNTER_STORAGE_BYTES(shard_count) \
+    (TELEMETRY_STORAGE_ALIGN + (size_t)(shard_count) * TELEMETRY_STORAGE_ALIGN)
+
+
+// global sharded counter functions
+bool sharded_counter_init(sharded_counter_t** out_counter, size_t shard_count);
+void sharded_counter_free(sharded_counter_t* counter);
+
+// Same as sharded_counter_init, in caller storage of SHARDED_COUNTER_STORAGE_BYTES(rounded count) bytes
+bool sharded_counter_init_static(sharded_counter_t** out_counter, void* memory, size_t memory_bytes, size_t shard_count);
+
+// Producer threads : add to the calling thread's slot
+void sharded_counter_add(sharded_counter_t* counter, uint64_t delta);
+
+// Reader (agent) : sum of all slots, not a single atomic snapshot
+uint64_t sharded_counter_sum(const sharded_counter_t* counter);
+
+
+// Helper functions
+size_t sharded_counter_shards(const sharded_counter_t* counter);
+
+
+
+#ifdef __cplusplus
+    }
+#endif
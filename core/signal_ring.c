@@ -0,0 +1,334 @@
+/**
+ * @file signal_ring.c
+ * @brief Async-signal-safe event queue.
+ *
+ * Bounded multi producer, multi consumer queue in the style of Vyukov's
+ * array queue. A slot's sequence equals its position while it is free for
+ * a push and position + 1 once it holds an event, so a producer and a
+ * consumer each claim a slot with one compare and swap.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include "signal_ring.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest accepted capacity, keeps the position arithmetic far from wrapping
+#define SIGNAL_RING_MAX_CAPACITY ((size_t)1 << 20)
+
+// Struct declaration
+
+typedef struct signal_ring_slot_s {
+    atomic_size_t sequence;
+    telemetry_event_t event;
+} signal_ring_slot_t;
+
+typedef struct signal_ring_s {
+    signal_ring_slot_t* slots;
+    size_t mask;
+
+    _Alignas(64) atomic_size_t enqueue_position;
+    _Alignas(64) atomic_size_t dequeue_position;
+
+    atomic_uint_fast64_t dropped;
+
+    bool owned;                     // Allocated by signal_ring_init, freed by signal_ring_free
+} signal_ring_t;
+
+_Static_assert(sizeof(signal_ring_t) <= SIGNAL_RING_STATE_BYTES, "SIGNAL_RING_STATE_BYTES is too small");
+_Static_assert(sizeof(signal_ring_slot_t) == SIGNAL_RING_SLOT_BYTES, "SIGNAL_RING_SLOT_BYTES does not match the slot");
+
+// Local function definitions
+
+/**
+ * @brief Rounds a capacity up to a power of two.
+ *
+ * @param capacity Requested capacity (non zero).
+ * @return Power of two not smaller than capacity.
+ */
+static size_t round_capacity(size_t capacity)
+{
+    size_t rounded = 1;
+
+    while(rounded < capacity)
+    {
+        rounded <<= 1;
+    }
+
+    return rounded;
+}
+
+/**
+ * @brief Sets up a ring whose memory is in place.
+ *
+ * @param ring Ring with slots set.
+ * @param rounded Slot count, a power of two.
+ */
+static void setup_ring(signal_ring_t* ring, size_t rounded)
+{
+    // Every slot starts free for the push at its own position
+    for(size_t index = 0; index < rounded; index++)
+    {
+        atomic_init(&ring->slots[index].sequence, index);
+    }
+
+    ring->mask = rounded - 1u;
+    atomic_init(&ring->enqueue_position, 0);
+    atomic_init(&ring->dequeue_position, 0);
+    atomic_init(&ring->dropped, 0);
+}
+
+// Global function definitions
+
+/**
+ * @brief Initializes a signal ring.
+ *
+ * Fails if the atomics the queue relies on would need a lock, since a
+ * lock taken in a signal handler can deadlock.
+ *
+ * @param out_ring Receives the ring.
+ * @param capacity Minimum number of events, rounded up to a power of two.
+ * @return true on success, false on failure.
+ */
+bool signal_ring_init(signal_ring_t** out_ring, size_t capacity)
+{
+    if(out_ring == NULL || capacity == 0 || capacity > SIGNAL_RING_MAX_CAPACITY)
+        return false;
+
+    signal_ring_t* ring = (signal_ring_t*)calloc(1, sizeof(*ring));
+
+    if(ring == NULL)
+        return false;
+
+    if(!atomic_is_lock_free(&ring->enqueue_position) || !atomic_is_lock_free(&ring->dropped))
+    {
+        free(ring);
+        return false;
+    }
+
+    const size_t rounded = round_capacity(capacity);
+
+    ring->slots = (signal_ring_slot_t*)calloc(rounded, sizeof(*ring->slots));
+
+    if(ring->slots == NULL)
+    {
+        free(ring);
+        return false;
+    }
+
+    setup_ring(ring, rounded);
+    ring->owned = true;
+
+    *out_ring = ring;
+
+    return true;
+}
+
+/**
+ * @brief Initializes a signal ring in caller storage.
+ *
+ * Nothing is allocated; memory must stay valid until signal_ring_free.
+ *
+ * @param out_ring Receives the ring.
+ * @param memory Storage aligned to TELEMETRY_STORAGE_ALIGN.
+ * @param memory_bytes Size of memory, at least SIGNAL_RING_STORAGE_BYTES of the rounded capacity.
+ * @param capacity Minimum number of events, rounded up to a power of two.
+ * @return true on success, false on failure.
+ */
+bool signal_ring_init_static(signal_ring_t** out_ring, void* memory, size_t memory_bytes, size_t capacity)
+{
+    if(out_ring == NULL || capacity == 0 || capacity > SIGNAL_RING_MAX_CAPACITY || !telemetry_storage_aligned(memory))
+        return false;
+
+    const size_t rounded = round_capacity(capacity);
+
+    if(memory_bytes < SIGNAL_RING_STORAGE_BYTES(rounded))
+        return false;
+
+    signal_ring_t* ring = (signal_ring_t*)memory;
+    memset(ring, 0, sizeof(*ring));
+
+    if(!atomic_is_lock_free(&ring->enqueue_position) || !atomic_is_lock_free(&ring->dropped))
+        return false;
+
+    ring->slots = (signal_ring_slot_t*)((uint8_t*)memory + SIGNAL_RING_STATE_BYTES);
+    setup_ring(ring, rounded);
+    ring->owned = false;
+
+    *out_ring = ring;
+
+    return true;
+}
+
+/**
+ * @brief Frees a signal ring.
+ *
+ * A ring in caller storage has nothing to free and is left as is.
+ *
+ * @param ring Ring to free, no thread or handler may still use it.
+ */
+void signal_ring_free(signal_ring_t* ring)
+{
+    if(ring == NULL || !ring->owned)
+        return;
+
+    free(ring->slots);
+    free(ring);
+}
+
+/**
+ * @brief Pushes a copy of an event.
+ *
+ * Async-signal-safe.
+ *
+ * @param ring The ring.
+ * @param event Event to copy.
+ * @return true if queued, false if the ring is full (counted as dropped).
+ */
+bool signal_ring_push(signal_ring_t* ring, const telemetry_event_t* event)
+{
+    if(ring == NULL || event == NULL)
+        return false;
+
+    size_t position = atomic_load_explicit(&ring->enqueue_position, memory_order_relaxed);
+    signal_ring_slot_t* slot;
+
+    while(1)
+    {
+        slot = &ring->slots[position & ring->mask];
+
+        const size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+        if(difference == 0)
+        {
+            // Slot is free, claim the position
+            if(atomic_compare_exchange_weak_explicit(&ring->enqueue_position, &position, position + 1u,
+                                                     memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(difference < 0)
+        {
+            // The slot still holds the event from one lap earlier
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            // Another producer took the position
+            position = atomic_load_explicit(&ring->enqueue_position, memory_order_relaxed);
+        }
+    }
+
+    memcpy(&slot->event, event, sizeof(*event));
+
+    // Publish the event to consumers
+    atomic_store_explicit(&slot->sequence, position + 1u, memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief Pops the oldest event.
+ *
+ * Async-signal-safe.
+ *
+ * @param ring The ring.
+ * @param out Receives the event.
+ * @return true if an event was popped, false if the ring is empty.
+ */
+bool signal_ring_pop(signal_ring_t* ring, telemetry_event_t* out)
+{
+    if(ring == NULL || out == NULL)
+        return false;
+
+    size_t position = atomic_load_explicit(&ring->dequeue_position, memory_order_relaxed);
+    signal_ring_slot_t* slot;
+
+    while(1)
+    {
+        slot = &ring->slots[position & ring->mask];
+
+        const size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        const intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1u);
+
+        if(difference == 0)
+        {
+            // Slot holds an event, claim the position
+            if(atomic_compare_exchange_weak_explicit(&ring->dequeue_position, &position, position + 1u,
+                                                     memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(difference < 0)
+        {
+            // Nothing published at this position yet
+            return false;
+        }
+        else
+        {
+            // Another consumer took the position
+            position = atomic_load_explicit(&ring->dequeue_position, memory_order_relaxed);
+        }
+    }
+
+    memcpy(out, &slot->event, sizeof(*out));
+
+    // Free the slot for the push one lap later
+    atomic_store_explicit(&slot->sequence, position + ring->mask + 1u, memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief Returns the number of queued events.
+ *
+ * Approximate while other threads push or pop.
+ *
+ * @param ring The ring.
+ * @return Number of events.
+ */
+size_t signal_ring_count(const signal_ring_t* ring)
+{
+    if(ring == NULL)
+        return 0;
+
+    const size_t dequeued = atomic_load_explicit((atomic_size_t*)&ring->dequeue_position, memory_order_acquire);
+    const size_t enqueued = atomic_load_explicit((atomic_size_t*)&ring->enqueue_position, memory_order_acquire);
+
+    return (enqueued > dequeued) ? (enqueued - dequeued) : 0;
+}
+
+/**
+ * @brief Returns the number of events dropped because the ring was full.
+ *
+ * @param ring The ring.
+ * @return Dropped events.
+ */
+uint64_t signal_ring_dropped(const signal_ring_t* ring)
+{
+    if(ring == NULL)
+        return 0;
+
+    return atomic_load_explicit((atomic_uint_fast64_t*)&ring->dropped, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the capacity after rounding.
+ *
+ * @param ring The ring.
+ * @return Number of slots.
+ */
+size_t signal_ring_capacity(const signal_ring_t* ring)
+{
+    if(ring == NULL)
+        return 0;
+
+    return ring->mask + 1u;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "event.h"
+#include "static_storage.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/*
+ * Bounded queue of events that any thread, including a signal handler, may
+ * push to and pop from. Every slot carries a sequence number, so push and
+ * pop only use lock-free atomics and a copy of the event; nothing waits
+ * for another thread and nothing allocates after init.
+ *
+ * A push or pop interrupted by a signal handler that uses the same queue
+ * is not undone: the slot it claimed stays busy and events behind it are
+ * only popped once the interrupted call has finished.
+ */
+typedef struct signal_ring_s signal_ring_t;
+
+// Bytes of signal ring state in static storage, the positions sit on their own cache lines
+#define SIGNAL_RING_STATE_BYTES (3u * TELEMETRY_STORAGE_ALIGN)
+
+// Bytes of one slot : a sequence number and the event
+#define SIGNAL_RING_SLOT_BYTES (sizeof(size_t) + sizeof(telemetry_event_t))
+
+// Storage for signal_ring_init_static, capacity must already be a power of two
+#define SIGNAL_RING_STORAGE_BYTES(capacity) \
+    (SIGNAL_RING_STATE_BYTES + TELEMETRY_STORAGE_ROUND((size_t)(capacity) * SIGNAL_RING_SLOT_BYTES))
+
+
+// global signal ring functions, the capacity is rounded up to a power of two
+bool signal_ring_init(signal_ring_t** out_ring, size_t capacity);
+void signal_ring_free(signal_ring_t* ring);
+
+// Same as signal_ring_init, in caller storage of SIGNAL_RING_STORAGE_BYTES(rounded capacity) bytes
+bool signal_ring_init_static(signal_ring_t** out_ring, void* memory, size_t memory_bytes, size_t capacity);
+
+// Any thread or signal handler : push a copy of the event, false when full
+bool signal_ring_push(signal_ring_t* ring, const telemetry_event_t* event);
+
+// Any thread or signal handler : pop the oldest event, false when empty
+bool signal_ring_pop(signal_ring_t* ring, telemetry_event_t* out);
+
+
+// Helper functions
+size_t signal_ring_count(const signal_ring_t* ring);
+uint64_t signal_ring_dropped(const signal_ring_t* ring);
+size_t signal_ring_capacity(const signal_ring_t* ring);
+
+
+
+#ifdef __cplusplus
+    }
+#endif
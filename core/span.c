@@ -0,0 +1,368 @@
+/**
+ * @file span.c
+ * @brief Scoped spans for in-process tracing.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include "span.h"
+#include "event_filter.h"
+#include "telemetry_protocol.h"
+#include "osal_time.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+// Five varints of at most 10 bytes
+_Static_assert(TELEMETRY_EVENT_PAYLOAD_MAX >= 50, "a span record needs 50 payload bytes");
+
+// Span records converted per calibration read
+#define SPAN_RESOLVE_CHUNK 16u
+
+// Next free block of span ids, shared by all threads
+static atomic_uint_fast64_t next_id_block = 1;
+
+// Span ids of the calling thread's current block
+static _Thread_local uint64_t thread_next_id;
+static _Thread_local uint64_t thread_id_limit;
+
+// Innermost open span of the calling thread
+static _Thread_local telemetry_span_t* thread_current_span;
+
+
+// Local function definitions
+
+/**
+ * @brief Returns a new span id.
+ *
+ * Threads take blocks of TELEMETRY_SPAN_ID_BLOCK ids, so the shared counter
+ * is touched once per block rather than once per span.
+ *
+ * @return Span id, never 0.
+ */
+static inline uint64_t new_span_id(void)
+{
+    if(thread_next_id == thread_id_limit)
+    {
+        const uint64_t block = atomic_fetch_add_explicit(&next_id_block, 1u, memory_order_relaxed);
+        thread_next_id = block * TELEMETRY_SPAN_ID_BLOCK;
+        thread_id_limit = thread_next_id + TELEMETRY_SPAN_ID_BLOCK;
+    }
+
+    return thread_next_id++;
+}
+
+/**
+ * @brief Fills and opens a span.
+ *
+ * @param span Span to open.
+ * @param name_id What is measured.
+ * @param level Level of the record.
+ * @param trace_id Trace of the parent, ignored for a root span.
+ * @param parent_id Parent span id, 0 for a root span.
+ */
+static void span_open(telemetry_span_t* span, uint32_t name_id, telemetry_level_t level,
+                      uint64_t trace_id, uint64_t parent_id)
+{
+    span->name_id = name_id;
+    span->level = (uint8_t)level;
+    span->active = telemetry_event_filter_enabled(name_id);
+
+    // A disabled span takes no id and no timestamp, its children attach to its parent
+    if(!span->active)
+    {
+        span->enclosing = NULL;
+        return;
+    }
+
+    span->span_id = new_span_id();
+    span->parent_id = parent_id;
+    span->trace_id = (parent_id != 0) ? trace_id : span->span_id;
+
+    span->enclosing = thread_current_span;
+    thread_current_span = span;
+
+    span->start_ticks = osal_telemetry_now_ticks();
+}
+
+
+/**
+ * @brief Finds the duration field of a span record.
+ *
+ * @param event Span record event.
+ * @param duration Receives the duration.
+ * @return Offset of the duration varint, 0 for other events or a damaged payload.
+ */
+static size_t span_duration_offset(const telemetry_event_t* event, uint64_t* duration)
+{
+    uint64_t value;
+    size_t position = 0;
+
+    if(event->event_id != TELEMETRY_SPAN_EVENT_ID || event->payload_size > TELEMETRY_EVENT_PAYLOAD_MAX)
+        return 0;
+
+    // Name, trace, span and parent id come first
+    for(size_t index = 0; index < 4u; index++)
+    {
+        const size_t used = telemetry_decode_varint(&value, &event->payload[position], event->payload_size - position);
+
+        if(used == 0)
+            return 0;
+
+        position += used;
+    }
+
+    if(telemetry_decode_varint(duration, &event->payload[position], event->payload_size - position) == 0)
+        return 0;
+
+    return position;
+}
+
+/**
+ * @brief Writes the converted start and duration of a raw span record.
+ *
+ * The duration is the last field and is rewritten in place.
+ *
+ * @param event Raw tick span record.
+ * @param offset Offset of the duration varint.
+ * @param start_ns Start in nanoseconds.
+ * @param end_ns End in nanoseconds.
+ */
+static void span_write_resolved(telemetry_event_t* event, size_t offset, uint64_t start_ns, uint64_t end_ns)
+{
+    const size_t used = telemetry_encode_varint(&event->payload[offset], TELEMETRY_EVENT_PAYLOAD_MAX - offset,
+                                                (end_ns > start_ns) ? end_ns - start_ns : 0);
+
+    event->timestamp = start_ns;
+    event->payload_size = (uint16_t)(offset + used);
+    event->reserved &= (uint8_t)~TELEMETRY_EVENT_FLAG_RAW_TICKS;
+}
+
+
+// Global function definitions
+
+/**
+ * @brief Opens a span on the calling thread.
+ *
+ * @param span Span to open, kept by the caller until telemetry_span_end.
+ * @param name_id What is measured, an application chosen id.
+ * @param level Level of the span record.
+ */
+void telemetry_span_begin(telemetry_span_t* span, uint32_t name_id, telemetry_level_t level)
+{
+    if(span == NULL)
+        return;
+
+    const telemetry_span_t* parent = thread_current_span;
+
+    if(parent != NULL)
+        span_open(span, name_id, level, parent->trace_id, parent->span_id);
+    else
+        span_open(span, name_id, level, 0, 0);
+}
+
+/**
+ * @brief Opens a span under an explicit parent.
+ *
+ * Continues a trace begun on another thread or in another process; pass
+ * the trace and span id of the parent.
+ *
+ * @param span Span to open.
+ * @param name_id What is measured.
+ * @param level Level of the span record.
+ * @param trace_id Trace id of the parent.
+ * @param parent_id Span id of the parent, 0 starts a new trace.
+ */
+void telemetry_span_begin_with_parent(telemetry_span_t* span, uint32_t name_id, telemetry_level_t level,
+                                      uint64_t trace_id, uint64_t parent_id)
+{
+    if(span == NULL)
+        return;
+
+    span_open(span, name_id, level, trace_id, parent_id);
+}
+
+/**
+ * @brief Closes a span and pushes its record.
+ *
+ * Reads the counter once and pushes one event with the start tick and the
+ * duration in ticks; the agent converts them. The caller notifies the
+ * agent as after any push.
+ *
+ * @param span Span to close.
+ * @param ring Ring buffer of the calling producer.
+ * @return true if the record was pushed.
+ */
+bool telemetry_span_end(telemetry_span_t* span, ring_buffer_t* ring)
+{
+    if(span == NULL || !span->active)
+        return false;
+
+    const uint64_t end_ticks = osal_telemetry_now_ticks();
+
+    thread_current_span = span->enclosing;
+    span->active = false;
+
+    if(ring == NULL)
+        return false;
+
+    telemetry_event_t event;
+    size_t length = 0;
+
+    length += telemetry_encode_varint(&event.payload[length], TELEMETRY_EVENT_PAYLOAD_MAX - length, span->name_id);
+    length += telemetry_encode_varint(&event.payload[length], TELEMETRY_EVENT_PAYLOAD_MAX - length, span->trace_id);
+    length += telemetry_encode_varint(&event.payload[length], TELEMETRY_EVENT_PAYLOAD_MAX - length, span->span_id);
+    length += telemetry_encode_varint(&event.payload[length], TELEMETRY_EVENT_PAYLOAD_MAX - length, span->parent_id);
+    length += telemetry_encode_varint(&event.payload[length], TELEMETRY_EVENT_PAYLOAD_MAX - length,
+                                      (end_ticks > span->start_ticks) ? end_ticks - span->start_ticks : 0);
+
+    event.event_id = TELEMETRY_SPAN_EVENT_ID;
+    event.level = span->level;
+    event.reserved = TELEMETRY_EVENT_FLAG_RAW_TICKS;
+    event.payload_size = (uint16_t)length;
+    event.timestamp = span->start_ticks;
+
+    return ring_buffer_push(ring, &event);
+}
+
+/**
+ * @brief Returns the innermost open span of the calling thread.
+ *
+ * Use its trace_id and span_id to continue the trace elsewhere with
+ * telemetry_span_begin_with_parent.
+ *
+ * @return Open span, NULL if none.
+ */
+const telemetry_span_t* telemetry_span_current(void)
+{
+    return thread_current_span;
+}
+
+/**
+ * @brief Converts the raw tick span records of a batch to nanoseconds.
+ *
+ * Start and end ticks of a chunk of records are converted in one bulk
+ * call, so start and duration come from the same calibration. Records
+ * written in nanoseconds and other events are left alone; run it before
+ * telemetry_event_resolve_timestamps.
+ *
+ * @param events Events drained from a ring buffer.
+ * @param count Number of events.
+ */
+void telemetry_span_resolve_records(telemetry_event_t* events, size_t count)
+{
+    uint64_t ticks[2u * SPAN_RESOLVE_CHUNK];
+    telemetry_event_t* owners[SPAN_RESOLVE_CHUNK];
+    size_t offsets[SPAN_RESOLVE_CHUNK];
+
+    if(events == NULL)
+        return;
+
+    size_t index = 0;
+
+    while(index < count)
+    {
+        size_t gathered = 0;
+
+        // Gather start and end tick of each raw record
+        for(; index < count && gathered < SPAN_RESOLVE_CHUNK; index++)
+        {
+            telemetry_event_t* event = &events[index];
+            uint64_t duration = 0;
+
+            if(event->event_id != TELEMETRY_SPAN_EVENT_ID || (event->reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0)
+                continue;
+
+            const size_t offset = span_duration_offset(event, &duration);
+
+            if(offset == 0)
+                continue;
+
+            ticks[2u * gathered] = event->timestamp;
+            ticks[2u * gathered + 1u] = event->timestamp + duration;
+            owners[gathered] = event;
+            offsets[gathered] = offset;
+            gathered++;
+        }
+
+        osal_time_ticks_to_ns_bulk(ticks, 2u * gathered);
+
+        for(size_t converted = 0; converted < gathered; converted++)
+        {
+            span_write_resolved(owners[converted], offsets[converted], ticks[2u * converted], ticks[2u * converted + 1u]);
+        }
+    }
+}
+
+/**
+ * @brief Converts one raw tick span record from a signal handler.
+ *
+ * For the agent's crash flush, which cannot use the bulk conversion.
+ *
+ * @param event Event, left alone unless it is a raw tick span record.
+ */
+void telemetry_span_resolve_record_signal_safe(telemetry_event_t* event)
+{
+    uint64_t duration = 0;
+
+    if(event == NULL || event->event_id != TELEMETRY_SPAN_EVENT_ID || (event->reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0)
+        return;
+
+    const size_t offset = span_duration_offset(event, &duration);
+
+    if(offset != 0)
+    {
+        span_write_resolved(event, offset, osal_time_ticks_to_ns_signal_safe(event->timestamp),
+                            osal_time_ticks_to_ns_signal_safe(event->timestamp + duration));
+    }
+}
+
+/**
+ * @brief Decodes a span record.
+ *
+ * @param record Receives the fields.
+ * @param event Span record event.
+ * @return true on success, false for other events or a damaged payload.
+ */
+bool telemetry_span_record_decode(telemetry_span_record_t* record, const telemetry_event_t* event)
+{
+    uint64_t values[5];
+    size_t position = 0;
+
+    if(record == NULL || event == NULL || event->event_id != TELEMETRY_SPAN_EVENT_ID ||
+       event->payload_size > TELEMETRY_EVENT_PAYLOAD_MAX)
+    {
+        return false;
+    }
+
+    for(size_t index = 0; index < 5u; index++)
+    {
+        const size_t used = telemetry_decode_varint(&values[index], &event->payload[position], event->payload_size - position);
+
+        if(used == 0)
+            return false;
+
+        position += used;
+    }
+
+    if(values[0] > UINT32_MAX)
+        return false;
+
+    record->name_id = (uint32_t)values[0];
+    record->trace_id = values[1];
+    record->span_id = values[2];
+    record->parent_id = values[3];
+    record->start_ns = event->timestamp;
+    record->duration_ns = values[4];
+
+    // Not through an agent yet, e.g. popped straight from the ring
+    if((event->reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) != 0)
+    {
+        const uint64_t end_ns = osal_time_ticks_to_ns(event->timestamp + values[4]);
+
+        record->start_ns = osal_time_ticks_to_ns(event->timestamp);
+        record->duration_ns = (end_ns > record->start_ns) ? end_ns - record->start_ns : 0;
+    }
+
+    return true;
+}
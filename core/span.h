@@ -0,0 +1,92 @@
+/**
+ * @file span.h
+ * @brief Scoped spans for in-process tracing.
+ *
+ * A span measures one piece of work: begin reads the tick counter once,
+ * end reads it once more and pushes one span record event. Spans nest per
+ * thread: a span begun while another is open on the same thread becomes
+ * its child and shares its trace id. Nothing is allocated; the caller
+ * keeps the span, normally on the stack.
+ *
+ * Span record event: event_id is TELEMETRY_SPAN_EVENT_ID, the timestamp is
+ * the start in monotonic nanoseconds and the payload holds LEB128 varints:
+ * name id, trace id, span id, parent span id (0 for a root span) and the
+ * duration in nanoseconds.
+ *
+ * The producer leaves the record in ticks: the timestamp is the start tick
+ * with TELEMETRY_EVENT_FLAG_RAW_TICKS and the duration is in ticks. The
+ * agent converts both with telemetry_span_resolve_records in its bulk pass
+ * before the record is sent.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "event.h"
+#include "ring_buffer.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Event carrying one finished span
+#define TELEMETRY_SPAN_EVENT_ID (TELEMETRY_EVENT_ID_RESERVED_BASE + 0x02u)
+
+// Span ids a thread takes from the shared counter at once
+#define TELEMETRY_SPAN_ID_BLOCK 4096u
+
+// An open span, owned by the caller
+typedef struct telemetry_span_s {
+    uint64_t trace_id;          // Span id of the root span of the trace
+    uint64_t span_id;           // Unique within the process, never 0
+    uint64_t parent_id;         // 0 for a root span
+    uint64_t start_ticks;       // osal_telemetry_now_ticks() at begin
+    struct telemetry_span_s* enclosing;     // Span that was open on the thread before this one
+    uint32_t name_id;           // What is measured, an application chosen id
+    uint8_t level;
+    bool active;                // false if the name id was disabled at begin
+} telemetry_span_t;
+
+// A decoded span record
+typedef struct telemetry_span_record_s {
+    uint32_t name_id;
+    uint64_t trace_id;
+    uint64_t span_id;
+    uint64_t parent_id;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+} telemetry_span_record_t;
+
+
+// Opens a span as child of the thread's open span, or as a root span.
+// A name id disabled in core/event_filter.h gives an inactive span that records nothing.
+void telemetry_span_begin(telemetry_span_t* span, uint32_t name_id, telemetry_level_t level);
+
+// Opens a span under a parent from another thread or process, parent_id 0 starts a new trace
+void telemetry_span_begin_with_parent(telemetry_span_t* span, uint32_t name_id, telemetry_level_t level,
+                                      uint64_t trace_id, uint64_t parent_id);
+
+// Closes the span and pushes its record. Spans of a thread must end in reverse begin order,
+// on the thread that began them. Returns false if the span is inactive or the ring is full.
+bool telemetry_span_end(telemetry_span_t* span, ring_buffer_t* ring);
+
+// Innermost open span of the calling thread, NULL if none
+const telemetry_span_t* telemetry_span_current(void);
+
+// Consumer side : converts the start and duration of the raw tick span records of a batch to nanoseconds
+void telemetry_span_resolve_records(telemetry_event_t* events, size_t count);
+
+// Same for one event from a signal handler, other events are left alone
+void telemetry_span_resolve_record_signal_safe(telemetry_event_t* event);
+
+// Receiver side : decodes a span record event, converting a record still in ticks
+bool telemetry_span_record_decode(telemetry_span_record_t* record, const telemetry_event_t* event);
+
+
+#ifdef __cplusplus
+    }
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @file static_storage.h
+ * @brief Helpers for caller-provided storage.
+ *
+ * Every module that allocates at init time also has an _init_static
+ * variant that builds the object in memory the caller provides, typically
+ * a static array sized at compile time with the module's _STORAGE_BYTES
+ * macro. Such memory must be aligned to TELEMETRY_STORAGE_ALIGN; declare
+ * it with TELEMETRY_STORAGE.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Alignment of caller-provided storage, one cache line
+#define TELEMETRY_STORAGE_ALIGN 64u
+
+// Rounds a byte count up to a multiple of TELEMETRY_STORAGE_ALIGN
+#define TELEMETRY_STORAGE_ROUND(bytes) \
+    (((size_t)(bytes) + TELEMETRY_STORAGE_ALIGN - 1u) & ~(size_t)(TELEMETRY_STORAGE_ALIGN - 1u))
+
+// Declares an aligned byte array for an _init_static function, e.g.
+// static TELEMETRY_STORAGE(ring_memory, RING_BUFFER_STORAGE_BYTES(256));
+#ifdef __cplusplus
+    #define TELEMETRY_STORAGE(name, bytes) alignas(TELEMETRY_STORAGE_ALIGN) uint8_t name[bytes]
+#else
+    #define TELEMETRY_STORAGE(name, bytes) _Alignas(TELEMETRY_STORAGE_ALIGN) uint8_t name[bytes]
+#endif
+
+// true if memory is usable as storage : not NULL and aligned
+static inline bool telemetry_storage_aligned(const void* memory)
+{
+    return memory != NULL && ((uintptr_t)memory & (TELEMETRY_STORAGE_ALIGN - 1u)) == 0;
+}
+
+
+
+#ifdef __cplusplus
+    }
+#endif
@@ -3,64 +3,18 @@
  * @brief Telemetry protocol encoding/decoding implementation.
  *
  * Implements binary serialization and deserialization of telemetry protocol messages
- * using big-endian byte ordering. Provides helper functions for integer conversions
- * and message header encoding/decoding.
+ * using big-endian byte ordering (see byte_order.h). Provides the message header
+ * encoding/decoding and the varint helpers.
  *
  * @author Aravinthraj Ganesan
  */
 
 #include "telemetry_protocol.h"
+#include "byte_order.h"
+#include <stdint.h>
+#include <string.h>
 
 
-/**
- * @brief Convert unsigned 16-bit integer to big-endian format.
- *
- * @param[in] value Value in native byte order
- * @return Value converted to big-endian byte order
- */
-static inline uint16_t to_be_u16(uint16_t value)
-{
-    value = ((value >> 8) | (value << 8));
-    return value;
-}
-
-/**
- * @brief Convert unsigned 32-bit integer to big-endian format.
- *
- * @param[in] value Value in native byte order
- * @return Value converted to big-endian byte order
- */
-static inline uint32_t to_be_u32(uint32_t value)
-{
-    value = (((value & 0x000000FFu) << 24) |
-             ((value & 0x0000FF00u) << 8)  |
-             ((value & 0x00FF0000u) >> 8)  |
-             ((value & 0xFF000000u) >> 24) 
-            );
-
-    return value;
-}
-
-/**
- * @brief Convert unsigned 64-bit integer to big-endian format.
- *
- * @param[in] value Value in native byte order
- * @return Value converted to big-endian byte order
- */
-static inline uint64_t to_be_u64(uint64_t value)
-{
-    value = (((value & 0x00000000000000FFULL) << 56) |
-             ((value & 0x000000000000FF00ULL) << 40) |
-             ((value & 0x0000000000FF0000ULL) << 24) |
-             ((value & 0x00000000FF000000ULL) << 8)  |
-             ((value & 0x000000FF00000000ULL) >> 8)  |
-             ((value & 0x0000FF0000000000ULL) >> 24) |
-             ((value & 0x00FF000000000000ULL) >> 40) |
-             ((value & 0xFF00000000000000ULL) >> 56) 
-            );
-    return value;
-}
-
 /**
  * @brief Write unsigned 8-bit integer to buffer.
  *
@@ -72,62 +26,6 @@ static inline void put_u8(uint8_t* buffer, uint8_t value)
     buffer[0] = value;
 }
 
-/**
- * @brief Write unsigned 16-bit integer to buffer in big-endian format.
- *
- * @param[out] buffer Destination buffer (must hold at least 2 bytes)
- * @param[in]  value  Value to write in native byte order
- */
-static inline void put_u16_be(uint8_t* buffer, uint16_t value)
-{
-    /* Convert to big-endian format */
-    uint16_t buff_bigend = to_be_u16(value);
-
-    /* Write bytes to buffer */
-    buffer[0] = ((buff_bigend >> 0x08) & 0xFF);
-    buffer[1] = ((buff_bigend & 0xFF));
-}
-
-/**
- * @brief Write unsigned 32-bit integer to buffer in big-endian format.
- *
- * @param[out] buffer Destination buffer (must hold at least 4 bytes)
- * @param[in]  value  Value to write in native byte order
- */
-static inline void put_32_be(uint8_t* buffer, uint32_t value)
-{
-    /* Convert to big-endian format */
-    uint32_t buff_bigend = to_be_u32(value);
-
-    /* Write bytes to buffer */
-    buffer[0] = ((buff_bigend >> 24) & 0xFF);
-    buffer[1] = ((buff_bigend >> 16) & 0xFF);
-    buffer[2] = ((buff_bigend >> 8) & 0xFF);
-    buffer[3] = (buff_bigend & 0xFF);
-}
-
-/**
- * @brief Write unsigned 64-bit integer to buffer in big-endian format.
- *
- * @param[out] buffer Destination buffer (must hold at least 8 bytes)
- * @param[in]  value  Value to write in native byte order
- */
-static inline void put_64_be(uint8_t* buffer, uint64_t value)
-{
-    /* Convert to big-endian format */
-    uint64_t buff_bigend = to_be_u64(value);
-
-    /* Write bytes to buffer */
-    buffer[0] = ((buff_bigend >> 56) & 0xFF);
-    buffer[1] = ((buff_bigend >> 48) & 0xFF);
-    buffer[2] = ((buff_bigend >> 40) & 0xFF);
-    buffer[3] = ((buff_bigend >> 32) & 0xFF);
-    buffer[4] = ((buff_bigend >> 24) & 0xFF);
-    buffer[5] = ((buff_bigend >> 16) & 0xFF);
-    buffer[6] = ((buff_bigend >> 8) & 0xFF);
-    buffer[7] = (buff_bigend & 0xFF);
-}
-
 /**
  * @brief Read unsigned 8-bit integer from buffer.
  *
@@ -140,60 +38,6 @@ static inline uint8_t get_u8(const uint8_t* buffer)
     return value;
 }
 
-/**
- * @brief Read unsigned 16-bit integer from buffer in big-endian format.
- *
- * @param[in] buffer Source buffer (must hold at least 2 bytes)
- * @return Value converted from big-endian to native byte order
- */
-static inline uint16_t get_u16_be(const uint8_t* buffer)
-{
-    uint16_t value = 0;
-
-    value  = (uint16_t)(buffer[0] << 0x08);
-    value |= (uint16_t)buffer[1];
-
-    return value;
-}
-
-/**
- * @brief Read unsigned 32-bit integer from buffer in big-endian format.
- *
- * @param[in] buffer Source buffer (must hold at least 4 bytes)
- * @return Value converted from big-endian to native byte order
- */
-static inline uint32_t get_u32_be(const uint8_t* buffer)
-{
-    uint32_t value = 0;
-
-    value  = (uint32_t)(buffer[0] << 24);
-    value |= (uint32_t)(buffer[1] << 16);
-    value |= (uint32_t)(buffer[2] << 8);
-    value |= (uint32_t)(buffer[3]);
-
-    return value;
-}
-
-/**
- * @brief Read unsigned 64-bit integer from buffer in big-endian format.
- *
- * @param[in] buffer Source buffer (must hold at least 8 bytes)
- * @return Value converted from big-endian to native byte order
- */
-static inline uint64_t get_u64_be(const uint8_t* buffer)
-{
-    uint64_t value = 0;
-
-    value  = ((uint64_t)buffer[0] << 56);
-    value |= ((uint64_t)buffer[1] << 48); 
-    value |= ((uint64_t)buffer[2] << 40); 
-    value |= ((uint64_t)buffer[3] << 32); 
-    value |= ((uint64_t)buffer[4] << 24); 
-    value |= ((uint64_t)buffer[5] << 16); 
-    value |= ((uint64_t)buffer[6] << 8); 
-    value |= ((uint64_t)buffer[7]); 
-    return value;
-}
 
 // Offsets enum for telemetry header fields
 typedef enum telemetry_header_v1_offsets_e {
@@ -247,15 +91,15 @@ size_t telemetry_encode_header_v1(uint8_t* encoded_buffer, size_t buffer_capacit
         return 0;
     
     // Encode the header fields into big-endian format
-    put_32_be(&encoded_buffer[OFFSET_MAGIC_VALUE], header->magic_value);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_MAGIC_VALUE], header->magic_value);
     put_u8(&encoded_buffer[OFFSET_PROTOCOL_VERSION], header->protocol_version);
     put_u8(&encoded_buffer[OFFSET_HEADER_LENGTH], header->header_length);
-    put_u16_be(&encoded_buffer[OFFSET_MESSAGE_TYPE], header->message_type);
-    put_32_be(&encoded_buffer[OFFSET_SEQUENCE_NUMBER], header->sequence_counter);
-    put_64_be(&encoded_buffer[OFFSET_TIMESTAMP], header->timestamp_monotonic_ns);
-    put_32_be(&encoded_buffer[OFFSET_PAYLOAD_LENGTH], header->payload_len);
-    put_32_be(&encoded_buffer[OFFSET_CRC32],header->crc32); // CRC32 will be computed later, set to 0 for now
-    put_32_be(&encoded_buffer[OFFSET_RESERVED], header->reserved);
+    telemetry_put_u16_be(&encoded_buffer[OFFSET_MESSAGE_TYPE], header->message_type);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_SEQUENCE_NUMBER], header->sequence_counter);
+    telemetry_put_u64_be(&encoded_buffer[OFFSET_TIMESTAMP], header->timestamp_monotonic_ns);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_PAYLOAD_LENGTH], header->payload_len);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_CRC32],header->crc32); // CRC32 will be computed later, set to 0 for now
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_RESERVED], header->reserved);
         
     return HEADER_V1_SIZE;
 }
@@ -271,15 +115,15 @@ int telemetry_decode_header_v1(telemetry_header_t* decoded_header, const uint8_t
         return TELEM_RC_ERR_TRUNC;
     
     // Decode the header fields from big-endian format
-    decoded_header->magic_value           = get_u32_be(&buffer[OFFSET_MAGIC_VALUE]);
+    decoded_header->magic_value           = telemetry_get_u32_be(&buffer[OFFSET_MAGIC_VALUE]);
     decoded_header->protocol_version      = get_u8(&buffer[OFFSET_PROTOCOL_VERSION]);
     decoded_header->header_length         = get_u8(&buffer[OFFSET_HEADER_LENGTH]);
-    decoded_header->message_type          = get_u16_be(&buffer[OFFSET_MESSAGE_TYPE]);
-    decoded_header->sequence_counter      = get_u32_be(&buffer[OFFSET_SEQUENCE_NUMBER]);
-    decoded_header->timestamp_monotonic_ns= get_u64_be(&buffer[OFFSET_TIMESTAMP]);
-    decoded_header->payload_len           = get_u32_be(&buffer[OFFSET_PAYLOAD_LENGTH]);
-    decoded_header->crc32                 = get_u32_be(&buffer[OFFSET_CRC32]);
-    decoded_header->reserved              = get_u32_be(&buffer[OFFSET_RESERVED]);
+    decoded_header->message_type          = telemetry_get_u16_be(&buffer[OFFSET_MESSAGE_TYPE]);
+    decoded_header->sequence_counter      = telemetry_get_u32_be(&buffer[OFFSET_SEQUENCE_NUMBER]);
+    decoded_header->timestamp_monotonic_ns= telemetry_get_u64_be(&buffer[OFFSET_TIMESTAMP]);
+    decoded_header->payload_len           = telemetry_get_u32_be(&buffer[OFFSET_PAYLOAD_LENGTH]);
+    decoded_header->crc32                 = telemetry_get_u32_be(&buffer[OFFSET_CRC32]);
+    decoded_header->reserved              = telemetry_get_u32_be(&buffer[OFFSET_RESERVED]);
     
     // Validate magic value for protocol identification 
     if (decoded_header->magic_value != TELEMETRY_PROTOCOL_MAGIC_VALUE)
@@ -301,4 +145,288 @@ int telemetry_decode_header_v1(telemetry_header_t* decoded_header, const uint8_t
         return TELEM_RC_ERR_HEADER_LEN;
         
     return TELEM_RC_OK;
-}
\ No newline at end of file
+}
+
+// Offsets enum for heartbeat payload fields
+typedef enum telemetry_heartbeat_v1_offsets_e {
+    OFFSET_HB_UPTIME            = 0,
+    OFFSET_HB_SENT_COUNT        = 8,
+    OFFSET_HB_WAKEUP_COUNT      = 16,
+    OFFSET_HB_RING_DROPPED      = 24,
+    OFFSET_HB_TRANSPORT_ERRORS  = 32,
+    OFFSET_HB_RING_COUNT        = 40,
+    OFFSET_HB_RING_CAPACITY     = 44,
+    HEARTBEAT_V1_SIZE           = 48
+} telemetry_heartbeat_v1_offsets_t;
+
+
+/**
+ * @brief Encode a heartbeat payload to binary format (v1).
+ *
+ * @param[out] encoded_buffer   Output buffer to store encoded payload
+ * @param[in]  buffer_capacity  Size of output buffer in bytes
+ * @param[in]  heartbeat        Heartbeat counters to encode
+ * @return Number of bytes written on success (HEARTBEAT_V1_SIZE), 0 on error
+ */
+size_t telemetry_encode_heartbeat_v1(uint8_t* encoded_buffer, size_t buffer_capacity, const telemetry_heartbeat_t* heartbeat)
+{
+    // Validate input parameters
+    if (encoded_buffer == NULL || heartbeat == NULL)
+        return 0;
+
+    // Verify output buffer has sufficient capacity
+    if (buffer_capacity < HEARTBEAT_V1_SIZE)
+        return 0;
+
+    telemetry_put_u64_be(&encoded_buffer[OFFSET_HB_UPTIME], heartbeat->uptime_ns);
+    telemetry_put_u64_be(&encoded_buffer[OFFSET_HB_SENT_COUNT], heartbeat->sent_count);
+    telemetry_put_u64_be(&encoded_buffer[OFFSET_HB_WAKEUP_COUNT], heartbeat->wakeup_count);
+    telemetry_put_u64_be(&encoded_buffer[OFFSET_HB_RING_DROPPED], heartbeat->ring_dropped);
+    telemetry_put_u64_be(&encoded_buffer[OFFSET_HB_TRANSPORT_ERRORS], heartbeat->transport_error_count);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_HB_RING_COUNT], heartbeat->ring_count);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_HB_RING_CAPACITY], heartbeat->ring_capacity);
+
+    return HEARTBEAT_V1_SIZE;
+}
+
+/**
+ * @brief Decode a heartbeat payload from binary format (v1).
+ *
+ * @param[out] decoded_heartbeat Pointer to decoded heartbeat structure
+ * @param[in]  buffer            Binary payload data (after the header)
+ * @param[in]  buffer_length     Length of the payload buffer in bytes
+ * @return TELEM_RC_OK on success, error code on failure
+ */
+int telemetry_decode_heartbeat_v1(telemetry_heartbeat_t* decoded_heartbeat, const uint8_t* buffer, size_t buffer_length)
+{
+    // Validate input parameters
+    if (decoded_heartbeat == NULL || buffer == NULL)
+        return TELEM_RC_ERR_PARM;
+
+    // Verify input buffer has sufficient length
+    if (buffer_length < HEARTBEAT_V1_SIZE)
+        return TELEM_RC_ERR_TRUNC;
+
+    decoded_heartbeat->uptime_ns             = telemetry_get_u64_be(&buffer[OFFSET_HB_UPTIME]);
+    decoded_heartbeat->sent_count            = telemetry_get_u64_be(&buffer[OFFSET_HB_SENT_COUNT]);
+    decoded_heartbeat->wakeup_count          = telemetry_get_u64_be(&buffer[OFFSET_HB_WAKEUP_COUNT]);
+    decoded_heartbeat->ring_dropped          = telemetry_get_u64_be(&buffer[OFFSET_HB_RING_DROPPED]);
+    decoded_heartbeat->transport_error_count = telemetry_get_u64_be(&buffer[OFFSET_HB_TRANSPORT_ERRORS]);
+    decoded_heartbeat->ring_count            = telemetry_get_u32_be(&buffer[OFFSET_HB_RING_COUNT]);
+    decoded_heartbeat->ring_capacity         = telemetry_get_u32_be(&buffer[OFFSET_HB_RING_CAPACITY]);
+
+    return TELEM_RC_OK;
+}
+
+
+// Offsets enum for event fragment payload fields
+typedef enum telemetry_event_fragment_v1_offsets_e {
+    OFFSET_FRAG_EVENT_ID        = 0,
+    OFFSET_FRAG_TRANSFER_ID     = 4,
+    OFFSET_FRAG_TIMESTAMP       = 8,
+    OFFSET_FRAG_PAYLOAD_LEN     = 16,
+    OFFSET_FRAG_OFFSET          = 20,
+    OFFSET_FRAG_LEVEL           = 24,
+    OFFSET_FRAG_RESERVED_U8     = 25,
+    OFFSET_FRAG_RESERVED_U16    = 26,
+    EVENT_FRAGMENT_V1_SIZE      = 28
+} telemetry_event_fragment_v1_offsets_t;
+
+
+/**
+ * @brief Encode an event fragment payload to binary format (v1).
+ *
+ * @param[out] encoded_buffer   Output buffer to store encoded payload
+ * @param[in]  buffer_capacity  Size of output buffer in bytes
+ * @param[in]  fragment         Fragment to encode
+ * @return Number of bytes written on success, 0 on error
+ */
+size_t telemetry_encode_event_fragment_v1(uint8_t* encoded_buffer, size_t buffer_capacity, const telemetry_event_fragment_t* fragment)
+{
+    // Validate input parameters
+    if (encoded_buffer == NULL || fragment == NULL || (fragment->data == NULL && fragment->data_length != 0))
+        return 0;
+
+    // The fragment must lie within the event payload
+    if (fragment->fragment_offset > fragment->payload_len ||
+        fragment->data_length > fragment->payload_len - fragment->fragment_offset)
+        return 0;
+
+    // Verify output buffer has sufficient capacity
+    if (buffer_capacity < EVENT_FRAGMENT_V1_SIZE || buffer_capacity - EVENT_FRAGMENT_V1_SIZE < fragment->data_length)
+        return 0;
+
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_FRAG_EVENT_ID], fragment->event_id);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_FRAG_TRANSFER_ID], fragment->transfer_id);
+    telemetry_put_u64_be(&encoded_buffer[OFFSET_FRAG_TIMESTAMP], fragment->timestamp_ns);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_FRAG_PAYLOAD_LEN], fragment->payload_len);
+    telemetry_put_u32_be(&encoded_buffer[OFFSET_FRAG_OFFSET], fragment->fragment_offset);
+    put_u8(&encoded_buffer[OFFSET_FRAG_LEVEL], fragment->level);
+    put_u8(&encoded_buffer[OFFSET_FRAG_RESERVED_U8], 0);
+    telemetry_put_u16_be(&encoded_buffer[OFFSET_FRAG_RESERVED_U16], 0);
+
+    if (fragment->data_length != 0)
+        memcpy(&encoded_buffer[EVENT_FRAGMENT_V1_SIZE], fragment->data, fragment->data_length);
+
+    return EVENT_FRAGMENT_V1_SIZE + (size_t)fragment->data_length;
+}
+
+/**
+ * @brief Decode an event fragment payload from binary format (v1).
+ *
+ * @param[out] decoded_fragment Pointer to decoded fragment structure
+ * @param[in]  buffer           Binary payload data (after the header)
+ * @param[in]  buffer_length    Length of the payload buffer in bytes
+ * @return TELEM_RC_OK on success, error code on failure
+ */
+int telemetry_decode_event_fragment_v1(telemetry_event_fragment_t* decoded_fragment, const uint8_t* buffer, size_t buffer_length)
+{
+    // Validate input parameters
+    if (decoded_fragment == NULL || buffer == NULL)
+        return TELEM_RC_ERR_PARM;
+
+    // Verify input buffer has sufficient length
+    if (buffer_length < EVENT_FRAGMENT_V1_SIZE)
+        return TELEM_RC_ERR_TRUNC;
+
+    // Fragment lengths are carried in 32 bits
+    if (buffer_length - EVENT_FRAGMENT_V1_SIZE > UINT32_MAX)
+        return TELEM_RC_ERR_RANGE;
+
+    decoded_fragment->event_id        = telemetry_get_u32_be(&buffer[OFFSET_FRAG_EVENT_ID]);
+    decoded_fragment->transfer_id     = telemetry_get_u32_be(&buffer[OFFSET_FRAG_TRANSFER_ID]);
+    decoded_fragment->timestamp_ns    = telemetry_get_u64_be(&buffer[OFFSET_FRAG_TIMESTAMP]);
+    decoded_fragment->payload_len     = telemetry_get_u32_be(&buffer[OFFSET_FRAG_PAYLOAD_LEN]);
+    decoded_fragment->fragment_offset = telemetry_get_u32_be(&buffer[OFFSET_FRAG_OFFSET]);
+    decoded_fragment->level           = get_u8(&buffer[OFFSET_FRAG_LEVEL]);
+    decoded_fragment->data            = &buffer[EVENT_FRAGMENT_V1_SIZE];
+    decoded_fragment->data_length     = (uint32_t)(buffer_length - EVENT_FRAGMENT_V1_SIZE);
+
+    // A fragment reaching past the event payload is malformed
+    if (decoded_fragment->fragment_offset > decoded_fragment->payload_len ||
+        decoded_fragment->data_length > decoded_fragment->payload_len - decoded_fragment->fragment_offset)
+        return TELEM_RC_ERR_RANGE;
+
+    return TELEM_RC_OK;
+}
+
+
+/**
+ * @brief Write an unsigned integer as a LEB128 varint.
+ *
+ * Seven bits per byte, least significant group first; the top bit marks
+ * that more bytes follow.
+ *
+ * @param[out] encoded_buffer   Output buffer
+ * @param[in]  buffer_capacity  Size of output buffer in bytes
+ * @param[in]  value            Value to encode
+ * @return Number of bytes written, 0 if the buffer is too small
+ */
+size_t telemetry_encode_varint(uint8_t* encoded_buffer, size_t buffer_capacity, uint64_t value)
+{
+    size_t length = 0;
+
+    // Validate input parameters
+    if (encoded_buffer == NULL)
+        return 0;
+
+    do
+    {
+        if (length >= buffer_capacity)
+            return 0;
+
+        uint8_t byte = (uint8_t)(value & 0x7Fu);
+        value >>= 7;
+
+        // More groups follow
+        if (value != 0)
+            byte |= 0x80u;
+
+        encoded_buffer[length++] = byte;
+
+    } while (value != 0);
+
+    return length;
+}
+
+/**
+ * @brief Read a LEB128 varint.
+ *
+ * @param[out] value          Decoded value
+ * @param[in]  buffer         Input buffer
+ * @param[in]  buffer_length  Number of readable bytes
+ * @return Number of bytes consumed, 0 if the input is truncated or malformed
+ */
+size_t telemetry_decode_varint(uint64_t* value, const uint8_t* buffer, size_t buffer_length)
+{
+    uint64_t result = 0;
+    unsigned shift = 0;
+
+    // Validate input parameters
+    if (value == NULL || buffer == NULL)
+        return 0;
+
+    for (size_t index = 0; index < buffer_length; index++)
+    {
+        // A 64-bit value never needs more than 10 bytes
+        if (shift > 63)
+            return 0;
+
+        result |= ((uint64_t)(buffer[index] & 0x7Fu) << shift);
+
+        if ((buffer[index] & 0x80u) == 0)
+        {
+            *value = result;
+            return index + 1;
+        }
+
+        shift += 7;
+    }
+
+    // Ran out of input before the last byte
+    return 0;
+}
+
+/**
+ * @brief Append a varint at a write position.
+ *
+ * @param[out]    encoded_buffer   Output buffer
+ * @param[in]     buffer_capacity  Size of output buffer in bytes
+ * @param[in,out] position         Write position, advanced on success
+ * @param[in]     value            Value to encode
+ * @return true if the value fit
+ */
+bool telemetry_append_varint(uint8_t* encoded_buffer, size_t buffer_capacity, size_t* position, uint64_t value)
+{
+    // Validate input parameters
+    if (encoded_buffer == NULL || position == NULL || *position > buffer_capacity)
+        return false;
+
+    const size_t written = telemetry_encode_varint(&encoded_buffer[*position], buffer_capacity - *position, value);
+
+    *position += written;
+
+    return (written != 0);
+}
+
+/**
+ * @brief Read a varint at a read position.
+ *
+ * @param[out]    value          Decoded value
+ * @param[in]     buffer         Input buffer
+ * @param[in]     buffer_length  Number of readable bytes
+ * @param[in,out] position       Read position, advanced on success
+ * @return true if a value was read
+ */
+bool telemetry_read_varint(uint64_t* value, const uint8_t* buffer, size_t buffer_length, size_t* position)
+{
+    // Validate input parameters
+    if (buffer == NULL || position == NULL || *position > buffer_length)
+        return false;
+
+    const size_t consumed = telemetry_decode_varint(value, &buffer[*position], buffer_length - *position);
+
+    *position += consumed;
+
+    return (consumed != 0);
+}
@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include "../api/type.h"
 
@@ -63,7 +64,11 @@ typedef enum telemetry_msg_type_e {
     /** Heartbeat/keepalive batch message type */
     TELEMETRY_HEART_BEAT_BATCH  = 2,
     /** Metrics batch message type */
-    TELEMETRY_METRICS_BATCH     = 3
+    TELEMETRY_METRICS_BATCH     = 3,
+    /** Quantile sketch batch message type */
+    TELEMETRY_SKETCH_BATCH      = 4,
+    /** One piece of a pooled event payload */
+    TELEMETRY_EVENT_FRAGMENT    = 5
 } telemetry_msg_type_t;
 
 /**
@@ -89,6 +94,62 @@ typedef enum telemetry_rc_type {
     TELEM_RC_ERR_RANGE = -7
 } telemetry_rc_type_t;
 
+/**
+ * @struct telemetry_heartbeat_s
+ * @brief Agent health counters carried by a heartbeat batch message.
+ *
+ * All counters are cumulative since the agent started, so a collector can
+ * derive throughput and drop rates from two consecutive heartbeats.
+ */
+typedef struct telemetry_heartbeat_s {
+    /** Time since the agent started in nanoseconds */
+    uint64_t uptime_ns;
+    /** Events successfully handed to the transport */
+    uint64_t sent_count;
+    /** Wakeup notifications received from producers */
+    uint64_t wakeup_count;
+    /** Events dropped by producers because the ring buffer was full */
+    uint64_t ring_dropped;
+    /** Events rejected by the transport */
+    uint64_t transport_error_count;
+    /** Events waiting in the ring buffer when the heartbeat was built */
+    uint32_t ring_count;
+    /** Ring buffer capacity in events */
+    uint32_t ring_capacity;
+} telemetry_heartbeat_t;
+
+#define TELEMETRY_HEARTBEAT_PAYLOAD_LEN              (uint8_t)48u
+
+/**
+ * @struct telemetry_event_fragment_s
+ * @brief One piece of an event payload too large for a single message.
+ *
+ * A pooled payload is split into fragments that share a transfer id, the
+ * sequence counter of the first one. The collector places each fragment at
+ * its offset and has the event once payload_len bytes arrived; a transfer
+ * that never completes is dropped.
+ */
+typedef struct telemetry_event_fragment_s {
+    /** Event identifier */
+    uint32_t event_id;
+    /** Sequence counter of the message carrying the first fragment */
+    uint32_t transfer_id;
+    /** Event timestamp in nanoseconds */
+    uint64_t timestamp_ns;
+    /** Length of the whole event payload in bytes */
+    uint32_t payload_len;
+    /** Position of this fragment in the event payload */
+    uint32_t fragment_offset;
+    /** Event severity level */
+    uint8_t  level;
+    /** Fragment bytes; points into the buffer after decoding */
+    const uint8_t* data;
+    /** Number of fragment bytes */
+    uint32_t data_length;
+} telemetry_event_fragment_t;
+
+#define TELEMETRY_EVENT_FRAGMENT_HEADER_LEN          (uint8_t)28u
+
 
 /**
  * @brief Encode a telemetry header to binary format (v1).
@@ -117,6 +178,129 @@ int telemetry_decode_header_v1(telemetry_header_t* decoded_header, const uint8_t
 
 
 
+/**
+ * @brief Encode a heartbeat payload to binary format (v1).
+ *
+ * Serializes the agent health counters into big-endian binary format. The
+ * payload is placed directly after a header with message type
+ * TELEMETRY_HEART_BEAT_BATCH.
+ *
+ * @param[out] encoded_buffer   Output buffer to store encoded payload
+ * @param[in]  buffer_capacity  Size of output buffer in bytes
+ * @param[in]  heartbeat        Heartbeat counters to encode
+ * @return Number of bytes written on success, 0 on error
+ */
+size_t telemetry_encode_heartbeat_v1(uint8_t* encoded_buffer, size_t buffer_capacity, const telemetry_heartbeat_t* heartbeat);
+
+/**
+ * @brief Decode a heartbeat payload from binary format (v1).
+ *
+ * @param[out] decoded_heartbeat Pointer to decoded heartbeat structure
+ * @param[in]  buffer            Binary payload data (after the header)
+ * @param[in]  buffer_length     Length of the payload buffer in bytes
+ * @return TELEM_RC_OK on success, error code on failure
+ */
+int telemetry_decode_heartbeat_v1(telemetry_heartbeat_t* decoded_heartbeat, const uint8_t* buffer, size_t buffer_length);
+
+/**
+ * @brief Encode an event fragment payload to binary format (v1).
+ *
+ * Writes the fixed fragment fields in big-endian order followed by the
+ * fragment bytes. The payload is placed directly after a header with
+ * message type TELEMETRY_EVENT_FRAGMENT.
+ *
+ * @param[out] encoded_buffer   Output buffer to store encoded payload
+ * @param[in]  buffer_capacity  Size of output buffer in bytes
+ * @param[in]  fragment         Fragment to encode
+ * @return Number of bytes written on success, 0 on error
+ */
+size_t telemetry_encode_event_fragment_v1(uint8_t* encoded_buffer, size_t buffer_capacity, const telemetry_event_fragment_t* fragment);
+
+/**
+ * @brief Decode an event fragment payload from binary format (v1).
+ *
+ * The fragment bytes are not copied, decoded_fragment->data points into buffer.
+ *
+ * @param[out] decoded_fragment Pointer to decoded fragment structure
+ * @param[in]  buffer           Binary payload data (after the header)
+ * @param[in]  buffer_length    Length of the payload buffer in bytes
+ * @return TELEM_RC_OK on success, error code on failure
+ */
+int telemetry_decode_event_fragment_v1(telemetry_event_fragment_t* decoded_fragment, const uint8_t* buffer, size_t buffer_length);
+
+/**
+ * @brief Write an unsigned integer as a LEB128 varint.
+ *
+ * Small values take one byte, so batch payloads stay compact. Used by the
+ * metrics batch encoding.
+ *
+ * @param[out] encoded_buffer   Output buffer
+ * @param[in]  buffer_capacity  Size of output buffer in bytes
+ * @param[in]  value            Value to encode
+ * @return Number of bytes written (1 to 10), 0 if the buffer is too small
+ */
+size_t telemetry_encode_varint(uint8_t* encoded_buffer, size_t buffer_capacity, uint64_t value);
+
+/**
+ * @brief Read a LEB128 varint.
+ *
+ * @param[out] value          Decoded value
+ * @param[in]  buffer         Input buffer
+ * @param[in]  buffer_length  Number of readable bytes
+ * @return Number of bytes consumed, 0 if the input is truncated or malformed
+ */
+size_t telemetry_decode_varint(uint64_t* value, const uint8_t* buffer, size_t buffer_length);
+
+/**
+ * @brief Append a varint at a write position.
+ *
+ * Lets a record encoder chain fields without tracking each length.
+ *
+ * @param[out]    encoded_buffer   Output buffer
+ * @param[in]     buffer_capacity  Size of output buffer in bytes
+ * @param[in,out] position         Write position, advanced on success
+ * @param[in]     value            Value to encode
+ * @return true if the value fit
+ */
+bool telemetry_append_varint(uint8_t* encoded_buffer, size_t buffer_capacity, size_t* position, uint64_t value);
+
+/**
+ * @brief Read a varint at a read position.
+ *
+ * @param[out]    value          Decoded value
+ * @param[in]     buffer         Input buffer
+ * @param[in]     buffer_length  Number of readable bytes
+ * @param[in,out] position       Read position, advanced on success
+ * @return true if a value was read
+ */
+bool telemetry_read_varint(uint64_t* value, const uint8_t* buffer, size_t buffer_length, size_t* position);
+
+/**
+ * @brief Fill a v1 header for an outgoing message.
+ *
+ * Sets magic, version and header length to their v1 values and stores the
+ * message specific fields. CRC32 and reserved fields are cleared.
+ *
+ * @param[out] header           Header structure to fill
+ * @param[in]  message_type     One of telemetry_msg_type_t
+ * @param[in]  sequence_counter Per-sender message sequence number
+ * @param[in]  timestamp_ns     Monotonic timestamp in nanoseconds
+ * @param[in]  payload_len      Length of the payload following the header
+ */
+static inline void telemetry_header_v1_make(telemetry_header_t* header, uint16_t message_type,
+    uint32_t sequence_counter, uint64_t timestamp_ns, uint32_t payload_len)
+{
+    header->magic_value            = TELEMETRY_PROTOCOL_MAGIC_VALUE;
+    header->protocol_version       = TELEMETRY_PROTOCOL_VERSION_V1;
+    header->header_length          = TELEMETRY_HEADER_LEN;
+    header->message_type           = message_type;
+    header->sequence_counter       = sequence_counter;
+    header->timestamp_monotonic_ns = timestamp_ns;
+    header->payload_len            = payload_len;
+    header->crc32                  = 0;
+    header->reserved               = 0;
+}
+
 /**
  * @brief Get the fixed header length for telemetry protocol v1.
  *
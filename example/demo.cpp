@@ -1,10 +1,9 @@
-#include "ring_buffer.h"
-#include "transport.hpp"
-#include "transport_adapter.hpp"
-#include "mock_transport.hpp"
-#include "telemetry_agent.h"
+#include <cstdio>
+#include <memory>
+
+#include "telemetry.hpp"
 #include "udp_transport.hpp"
-#include "osal_time.h"
+#include "telemetry_log.hpp"
 
 #define MAXIMUM_NUM_OF_EVENTS 10u
 
@@ -12,60 +11,39 @@
 
 int main()
 {
+    // Send to the UDP console receiver
+    telemetry::Config config;
+    config.transport.endpoint = "127.0.0.1:9000";
+    config.transport.mtu = 512;
 
-    // Create and Initalize the ring buffer
-    ring_buffer_t* rb = nullptr;
-    ring_buffer_init(&rb, 1024);
-
-    // Create the Mock transport C++
-    /*transport::MockTransport mock(true);
-    transport::Config Cfg{};
-    mock.Init(Cfg);*/
-
-    // Create the transport in C++
-    transport::UdpTransport udp;
-    transport::Config Cfg{};
-    Cfg.endpoint = "127.0.0.1:9000";
-    Cfg.mtu = 512;
+    // Transport, rings and agent in one step
+    telemetry::Telemetry telemetry(std::make_unique<transport::UdpTransport>(), config);
 
-    // Initialize the udp
-    udp.Init(Cfg);
-
-    // Wrapper for C++ transport to C
-    transport_c_t c_transport = transport_adapter::make_transport_adapter(udp);
-
-    // Start the agent
-    telemetry_agent_t* agent = nullptr;
-    
-    if(telemetry_agent_start(&agent, rb, &c_transport) == false)
+    if(telemetry.started() == false)
     {
-        // if the agent is not started successfull then return
+        // if the telemetry is not started successfull then return
         return 1;
     }
 
+    // This thread's producer handle
+    telemetry::Producer& producer = telemetry.local();
+
     // push some events to test
-    for(int i = 0;i<MAXIMUM_NUM_OF_EVENTS;i++)
+    for(unsigned i = 0; i < MAXIMUM_NUM_OF_EVENTS; i++)
     {
-        // produce one event 
-        telemetry_event_t ev{};
-        ev.event_id = 1;
-        ev.level = 2;
-        ev.payload_size = 0;
-        ev.timestamp = osal_telemetry_now_monotonic_ns();
-
-        if(ring_buffer_push(rb, &ev) == true)
+        if(producer.emit(1, nullptr, 0, TELEMETRY_LEVEL_WARNING) == true)
         {
             std::fprintf(stderr, "UdpTransport sendEvent called\n");
-            telemetry_agent_notify(agent);
         }
     }
 
-    // stop the agent
-    telemetry_agent_stop(agent);
-
-    udp.shutdown();
-    ring_buffer_free(rb);
+    // Log lines are sent as format ids plus binary arguments, tools/log_reconstruct prints them
+    telemetry::log::Logger logger(producer.ring(), telemetry.agent());
+    for(unsigned i = 0; i < 3u; i++)
+    {
+        TELEMETRY_LOG(logger, TELEMETRY_LEVEL_INFO, "demo iteration %u of %u, load %.1f%%", i + 1u, 3u, 12.5 * i);
+    }
 
+    // Leaving the scope flushes and stops the agent
     return 0;
 }
-
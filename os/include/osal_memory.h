@@ -0,0 +1,62 @@
+/**
+ * @file osal_memory.h
+ * @brief OS abstraction layer for page level memory.
+ *
+ * Maps memory with options that keep page faults and remote NUMA accesses
+ * out of the first burst of events: huge pages, pre-faulting, locking and
+ * binding to a NUMA node. Every option falls back quietly when the system
+ * does not allow it; the mapping reports which options took effect.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Mapping options
+#define OSAL_MEMORY_HUGE_PAGES  0x01u   // Explicit huge pages, else transparent huge pages, else normal pages
+#define OSAL_MEMORY_PREFAULT    0x02u   // Fault every page in before returning
+#define OSAL_MEMORY_LOCK        0x04u   // Keep the pages resident (mlock)
+#define OSAL_MEMORY_NUMA_BIND   0x08u   // Prefer the pages on one NUMA node
+
+// Reported in osal_memory_t.applied when transparent huge pages were requested instead
+#define OSAL_MEMORY_TRANSPARENT_HUGE_PAGES 0x10u
+
+// Size explicit huge page mappings are rounded to
+#define OSAL_MEMORY_HUGE_PAGE_BYTES ((size_t)2u << 20)
+
+// NUMA node of the calling thread, for osal_memory_map
+#define OSAL_MEMORY_NODE_LOCAL (-1)
+
+// A mapping
+typedef struct osal_memory_s
+{
+    void* address;          // Start of the mapping, NULL if not mapped
+    size_t length;          // Mapped bytes, the request rounded up to whole pages
+    uint32_t applied;       // OSAL_MEMORY_* options that took effect
+    int node;               // Node the pages are bound to when applied has OSAL_MEMORY_NUMA_BIND
+} osal_memory_t;
+
+// Maps zeroed memory with the given options, false only if no memory could be mapped at all
+bool osal_memory_map(osal_memory_t* out_memory, size_t bytes, uint32_t flags, int numa_node);
+
+// Moves the pages of a mapping to a NUMA node and prefers it for later faults, OSAL_MEMORY_NODE_LOCAL
+// for the calling thread's node. Nothing to do if already bound there; false if the system refuses.
+bool osal_memory_bind(osal_memory_t* memory, int numa_node);
+
+// Unmaps memory from osal_memory_map, a zeroed mapping is ignored
+void osal_memory_unmap(osal_memory_t* memory);
+
+// NUMA node of the CPU the calling thread runs on, 0 if unknown
+int osal_memory_current_node(void);
+
+#ifdef __cplusplus
+    }
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file osal_poll.h
+ * @brief OS abstraction layer for waiting on many descriptors.
+ *
+ * A poller waits on any number of descriptors at once: wakeup objects
+ * (osal_wakeup_fd), timers (osal_timer_fd), sockets and pipes. Each
+ * registration carries a context pointer that comes back with its events,
+ * so one thread can serve several sources without a lookup. Backed by
+ * epoll on Linux.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Poller handle type
+typedef struct osal_poller osal_poller_t;
+
+// Bytes of caller storage for osal_poller_create_static
+#define OSAL_POLLER_STORAGE_BYTES 64u
+
+// Events of a descriptor
+#define OSAL_POLL_READABLE 0x01u    // Data to read, a notification or a timer expiry
+#define OSAL_POLL_WRITABLE 0x02u    // Room to write without blocking
+#define OSAL_POLL_ERROR    0x04u    // Error or hang-up, reported without being asked for
+
+// One ready descriptor
+typedef struct osal_poll_event_s
+{
+    void* context;          // Context given when the descriptor was added
+    uint32_t events;        // OSAL_POLL_* events that are ready
+} osal_poll_event_t;
+
+// Create a poller, return NULL on failure
+osal_poller_t* osal_poller_create(void);
+
+// Create a poller in caller storage of OSAL_POLLER_STORAGE_BYTES bytes, return NULL on failure
+osal_poller_t* osal_poller_create_static(void* memory, size_t memory_bytes);
+
+// Watch a descriptor for OSAL_POLL_READABLE and/or OSAL_POLL_WRITABLE, level triggered
+bool osal_poller_add(osal_poller_t* poller, int fd, uint32_t events, void* context);
+
+// Change the events and context of a watched descriptor
+bool osal_poller_modify(osal_poller_t* poller, int fd, uint32_t events, void* context);
+
+// Stop watching a descriptor
+bool osal_poller_remove(osal_poller_t* poller, int fd);
+
+// Wait up to timeout_ns (millisecond resolution, OSAL_WAIT_FOREVER blocks) for ready descriptors.
+// Return the number stored in out_events, 0 on timeout, -1 on error.
+int osal_poller_wait(osal_poller_t* poller, osal_poll_event_t* out_events, size_t max_events, uint64_t timeout_ns);
+
+// Destroy the poller, the watched descriptors stay open
+void osal_poller_destroy(osal_poller_t* poller);
+
+#ifdef __cplusplus
+    }
+#endif
@@ -10,6 +10,8 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
     extern "C" {
@@ -20,16 +22,76 @@ typedef struct osal_thread osal_thread_t;
 // Function pointer type for thread entry point
 typedef void* (*osal_thread_fn_t)(void*);
 
+// Bytes of caller storage for osal_thread_create_static
+#define OSAL_THREAD_STORAGE_BYTES 256u
+
+// CPUs an affinity mask can name
+#define OSAL_THREAD_MAX_CPUS 1024u
+
+// Placement that took effect, see osal_thread_applied
+#define OSAL_THREAD_APPLIED_AFFINITY   0x01u
+#define OSAL_THREAD_APPLIED_SCHEDULING 0x02u
+#define OSAL_THREAD_APPLIED_STACK_SIZE 0x04u
+
+// Scheduling policy of a new thread
+typedef enum osal_thread_policy_e
+{
+    OSAL_THREAD_POLICY_DEFAULT = 0,     // Inherited time sharing policy
+    OSAL_THREAD_POLICY_FIFO,            // Real time, first in first out (SCHED_FIFO)
+    OSAL_THREAD_POLICY_RR               // Real time, round robin (SCHED_RR)
+} osal_thread_policy_t;
+
+// Called on the new thread after its placement, before the entry function
+typedef void (*osal_thread_hook_t)(void* context);
+
+/**
+ * @brief Placement of a new thread.
+ *
+ * Initialize with osal_thread_attr_init(). The affinity and the policy
+ * are applied by the new thread itself; when the system refuses them
+ * (unknown CPUs, no CAP_SYS_NICE) the thread keeps the defaults and runs
+ * anyway. osal_thread_applied() tells what took effect.
+ */
+typedef struct osal_thread_attr_s
+{
+    uint64_t cpu_mask[OSAL_THREAD_MAX_CPUS / 64u];  // CPUs the thread may run on, all clear for any CPU
+    osal_thread_policy_t policy;                    // Scheduling policy
+    int priority;                                   // Priority for FIFO and RR, clamped to the policy range
+    size_t stack_size;                              // Stack bytes, 0 for the system default
+    osal_thread_hook_t pre_start;                   // Optional hook, runs on the new thread
+    void* pre_start_context;                        // Argument of pre_start
+} osal_thread_attr_t;
+
+// Fills thread attributes with the defaults : any CPU, default policy and stack, no hook.
+void osal_thread_attr_init(osal_thread_attr_t* attr);
+
+// Adds a CPU to the affinity mask, false if cpu is not below OSAL_THREAD_MAX_CPUS.
+bool osal_thread_attr_set_cpu(osal_thread_attr_t* attr, unsigned cpu);
 
 // Creates a new thread.
 int osal_thread_create(osal_thread_t ** out_thread, osal_thread_fn_t entry_fn, void* entry_arg, const char* thread_name);
 
+// Creates a new thread with placement attributes, NULL attr for the defaults.
+int osal_thread_create_ex(osal_thread_t ** out_thread, osal_thread_fn_t entry_fn, void* entry_arg, const char* thread_name,
+                          const osal_thread_attr_t* attr);
+
+// Creates a new thread whose handle is placed in caller storage of OSAL_THREAD_STORAGE_BYTES bytes.
+int osal_thread_create_static(osal_thread_t ** out_thread, void* memory, size_t memory_bytes,
+                              osal_thread_fn_t entry_fn, void* entry_arg, const char* thread_name,
+                              const osal_thread_attr_t* attr);
+
+// OSAL_THREAD_APPLIED_* bits, complete once the thread runs its entry function.
+uint32_t osal_thread_applied(const osal_thread_t* thread);
+
 // Waits for the thread to finish.
 int osal_thread_join(osal_thread_t* thread);
 
 // Cleans up thread resources.
 void osal_thread_destroy(osal_thread_t* thread);
 
+// Suspends the calling thread for at least the given time.
+void osal_thread_sleep_ns(uint64_t duration_ns);
+
 #ifdef __cplusplus
     }
 #endif
\ No newline at end of file
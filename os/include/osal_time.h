@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -8,6 +10,17 @@
  *
  * Provides time management functions for cross-platform compatibility.
  *
+ * Where the CPU has an invariant cycle counter (TSC on x86, the generic
+ * timer on ARM64), the monotonic time is read from it and converted to
+ * nanoseconds with a calibrated multiplier, which avoids a clock_gettime()
+ * per event. The conversion is anchored to CLOCK_MONOTONIC and corrected by
+ * osal_time_resync(). Otherwise clock_gettime(CLOCK_MONOTONIC) is used.
+ *
+ * The coarse clock is a cheaper, lower resolution time on the same base: a
+ * timer thread publishes the monotonic time into a shared cache line once
+ * per period and readers do a single relaxed load. Without the service
+ * running it falls back to CLOCK_MONOTONIC_COARSE.
+ *
  * @author Aravinthraj Ganesan
  */
 
@@ -15,8 +28,63 @@
     extern "C" {
 #endif
 
+// Clock backing osal_telemetry_now_monotonic_ns() and the tick functions
+typedef enum osal_clock_source_e {
+    OSAL_CLOCK_SOURCE_MONOTONIC = 1,    // clock_gettime(CLOCK_MONOTONIC), ticks are nanoseconds
+    OSAL_CLOCK_SOURCE_TSC       = 2     // Invariant CPU counter
+} osal_clock_source_t;
+
+// Suggested time between osal_time_resync() calls (1 second)
+#define OSAL_TIME_RESYNC_INTERVAL_NS 1000000000ull
+
+// Default publish period of the coarse clock service (1 ms)
+#define OSAL_TIME_COARSE_DEFAULT_PERIOD_NS 1000000ull
+// Accepted publish periods of the coarse clock service (10 us to 1 s)
+#define OSAL_TIME_COARSE_MIN_PERIOD_NS     10000ull
+#define OSAL_TIME_COARSE_MAX_PERIOD_NS     1000000000ull
+
 uint64_t osal_telemetry_now_monotonic_ns(void);
 
+// Select and calibrate the clock source. Called on first use; call it at startup to keep the
+// calibration (a few milliseconds) off the first event. Returns the selected source.
+osal_clock_source_t osal_time_init(void);
+
+// Selected clock source
+osal_clock_source_t osal_time_source(void);
+
+// Raw counter value, cheaper than the nanosecond time. Convert with osal_time_ticks_to_ns().
+uint64_t osal_telemetry_now_ticks(void);
+
+// Convert a tick value to monotonic nanoseconds using the current calibration
+uint64_t osal_time_ticks_to_ns(uint64_t ticks);
+
+// Convert a tick value from a signal handler. Never waits for a resync; if the handler interrupted
+// one, the result may be off by up to one resync step. Requires osal_time_init() to have returned.
+uint64_t osal_time_ticks_to_ns_signal_safe(uint64_t ticks);
+
+// Convert an array of tick values in place, reading the calibration once
+void osal_time_ticks_to_ns_bulk(uint64_t* values, size_t count);
+
+// Counter frequency, 1000000000 for the monotonic fallback
+uint64_t osal_time_ticks_per_second(void);
+
+// Correct the tick conversion against CLOCK_MONOTONIC. Call about once per second from a single
+// background thread (the agent does). Small errors are slewed so the time never goes backwards.
+void osal_time_resync(void);
+
+// Monotonic time at most one coarse period behind osal_telemetry_now_monotonic_ns()
+uint64_t osal_telemetry_now_coarse_ns(void);
+
+// Start the coarse clock service (a timerfd thread), reference counted. The first caller's
+// period is used, 0 selects OSAL_TIME_COARSE_DEFAULT_PERIOD_NS. Returns false on failure.
+bool osal_time_coarse_start(uint64_t period_ns);
+
+// Release one reference, the last one stops the service
+void osal_time_coarse_stop(void);
+
+// Staleness bound of osal_telemetry_now_coarse_ns() in nanoseconds
+uint64_t osal_time_coarse_resolution_ns(void);
+
 #ifdef __cplusplus
     }
-#endif
\ No newline at end of file
+#endif
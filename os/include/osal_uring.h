@@ -0,0 +1,71 @@
+/**
+ * @file osal_uring.h
+ * @brief OS abstraction layer for asynchronous socket sends.
+ *
+ * A send ring queues datagram sends in user memory and hands them to the
+ * kernel in one call, or in none when a kernel thread polls the queue.
+ * Completions are reaped in batches without blocking. Backed by io_uring
+ * on Linux through its system calls, no library needed; creation fails
+ * where io_uring is missing or disabled, so callers keep a synchronous path.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+struct msghdr;
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+// Send ring handle type
+typedef struct osal_uring osal_uring_t;
+
+// Options of osal_uring_create
+#define OSAL_URING_SQPOLL               0x01u   // A kernel thread takes queued sends, no system call per submit
+#define OSAL_URING_REGISTERED_BUFFERS   0x02u   // Zero-copy sends from a buffer registered once
+
+// Idle time after which the SQPOLL thread sleeps until the next submit (ms)
+#define OSAL_URING_SQPOLL_IDLE_MS 50u
+
+// One reaped completion
+typedef struct osal_uring_completion_s
+{
+    uint64_t user_data;     // Value given when the send was queued
+    int32_t result;         // Bytes sent, or a negative errno
+    bool release;           // The kernel is done with the buffer, false while a zero-copy send still reads it
+} osal_uring_completion_t;
+
+// Create a send ring for about entries sends in flight, return NULL if io_uring is unavailable.
+// buffer is registered for osal_uring_queue_send_fixed with OSAL_URING_REGISTERED_BUFFERS.
+osal_uring_t* osal_uring_create(uint32_t entries, uint32_t flags, void* buffer, size_t buffer_bytes);
+
+// Options that took effect, refused ones fall back to plain submits and copied sends
+uint32_t osal_uring_applied(const osal_uring_t* ring);
+
+// Queue a sendmsg, message and its iovec and address must stay valid until the completion
+bool osal_uring_queue_sendmsg(osal_uring_t* ring, int fd, const struct msghdr* message, uint64_t user_data);
+
+// Queue a zero-copy send of data inside the registered buffer to address, needs OSAL_URING_REGISTERED_BUFFERS.
+// Completes twice: the result with release false, then release once the buffer may be reused.
+bool osal_uring_queue_send_fixed(osal_uring_t* ring, int fd, const void* data, size_t length,
+                                 const void* address, uint32_t address_length, uint64_t user_data);
+
+// Hand every queued send to the kernel, return the number handed over or -1 on error
+int osal_uring_submit(osal_uring_t* ring);
+
+// Store up to max_completions completions, waiting for at least wait_count first, return the number stored
+size_t osal_uring_reap(osal_uring_t* ring, osal_uring_completion_t* out_completions, size_t max_completions,
+                       uint32_t wait_count);
+
+// Destroy the ring, reap every send first so no buffer is still in use
+void osal_uring_destroy(osal_uring_t* ring);
+
+#ifdef __cplusplus
+    }
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 
 #ifdef __cplusplus
@@ -10,18 +12,88 @@
 // Wakeup handle type
 typedef struct osal_wakeup osal_wakeup_t;
 
-// Create a wakeup object, return NULL on failure
+// Bytes of caller storage for osal_wakeup_create_static
+#define OSAL_WAKEUP_STORAGE_BYTES 64u
+
+// Mechanism behind a wakeup object
+typedef enum osal_wakeup_backend_e
+{
+    OSAL_WAKEUP_BACKEND_DEFAULT = 0,    // Build default : eventfd, or futex with OSAL_WAKEUP_DEFAULT_FUTEX
+    OSAL_WAKEUP_BACKEND_EVENTFD,        // eventfd : a write per notify and a read per wait
+    OSAL_WAKEUP_BACKEND_FUTEX           // futex word : no system call to notify while nobody sleeps
+} osal_wakeup_backend_t;
+
+// Create a wakeup object with the default backend, return NULL on failure
 osal_wakeup_t* osal_wakeup_create(void);
 
-// Notify the wakeup object to wake up waiting threads
+// Create a wakeup object with the given backend, return NULL on failure
+osal_wakeup_t* osal_wakeup_create_ex(osal_wakeup_backend_t backend);
+
+// Create a wakeup object in caller storage of OSAL_WAKEUP_STORAGE_BYTES bytes, return NULL on failure
+osal_wakeup_t* osal_wakeup_create_static(void* memory, size_t memory_bytes);
+
+// Create a wakeup object with the given backend in caller storage, return NULL on failure
+osal_wakeup_t* osal_wakeup_create_static_ex(void* memory, size_t memory_bytes, osal_wakeup_backend_t backend);
+
+// Backend of a wakeup object, never OSAL_WAKEUP_BACKEND_DEFAULT
+osal_wakeup_backend_t osal_wakeup_backend(const osal_wakeup_t* wakeup);
+
+// Notify the wakeup object to wake up waiting threads, async-signal-safe with both backends
 void osal_wakeup_notify(osal_wakeup_t* wakeup);
 
 // Wait until notified
 void osal_wakeup_wait(osal_wakeup_t* wakeup);
 
+// Wait until notified or timeout_ns elapsed, true if notified. OSAL_WAIT_FOREVER blocks like osal_wakeup_wait
+bool osal_wakeup_wait_timeout(osal_wakeup_t* wakeup, uint64_t timeout_ns);
+
+// Descriptor that polls readable while notifications are pending, -1 for the futex backend
+int osal_wakeup_fd(const osal_wakeup_t* wakeup);
+
 // Destroy the wakeup object
 void osal_wakeup_destroy(osal_wakeup_t* wakeup);
 
+// Timeout of osal_wakeup_wait_timeout that never elapses
+#define OSAL_WAIT_FOREVER UINT64_MAX
+
+// Periodic timer handle type, a timerfd on Linux
+typedef struct osal_timer osal_timer_t;
+
+// Bytes of caller storage for osal_timer_create_static
+#define OSAL_TIMER_STORAGE_BYTES 64u
+
+// What ended osal_wakeup_wait_timer
+#define OSAL_WAKEUP_NOTIFIED 0x01u     // The wakeup object was notified
+#define OSAL_WAKEUP_EXPIRED  0x02u     // The timer expired
+
+// Create a stopped timer on the monotonic clock, return NULL on failure
+osal_timer_t* osal_timer_create(void);
+
+// Create a stopped timer in caller storage of OSAL_TIMER_STORAGE_BYTES bytes, return NULL on failure
+osal_timer_t* osal_timer_create_static(void* memory, size_t memory_bytes);
+
+// Start the timer : first expiry after first_ns, then every period_ns (0 for a one-shot timer)
+bool osal_timer_start(osal_timer_t* timer, uint64_t first_ns, uint64_t period_ns);
+
+// Stop the timer and drop pending expirations
+void osal_timer_stop(osal_timer_t* timer);
+
+// Wait for the next expiry, return the expirations since the last wait (more than 1 if some were missed)
+uint64_t osal_timer_wait(osal_timer_t* timer);
+
+// Return and clear the expirations since the last wait without blocking
+uint64_t osal_timer_expirations(osal_timer_t* timer);
+
+// Destroy the timer
+void osal_timer_destroy(osal_timer_t* timer);
+
+// Descriptor that polls readable while expirations are pending
+int osal_timer_fd(const osal_timer_t* timer);
+
+// Wait on a wakeup object and a timer at once, return OSAL_WAKEUP_NOTIFIED and/or OSAL_WAKEUP_EXPIRED.
+// Both are consumed; the timer expirations are stored in out_expirations when it is not NULL.
+uint32_t osal_wakeup_wait_timer(osal_wakeup_t* wakeup, osal_timer_t* timer, uint64_t* out_expirations);
+
 
 
 
@@ -0,0 +1,260 @@
+/**
+ * @file osal_memory_linux.c
+ * @brief OS abstraction layer for page level memory on Linux.
+ *
+ * Anonymous mmap with MAP_HUGETLB or MADV_HUGEPAGE, mbind through the raw
+ * system call (no libnuma), MADV_POPULATE_WRITE or a touch loop to fault
+ * the pages in, and mlock.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#define _GNU_SOURCE
+
+#include "osal_memory.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Preferred policy of mbind : allocate on the node, fall back to others when it is full
+#define OSAL_MEMORY_MPOL_PREFERRED 1
+
+// mbind flag : migrate the pages already faulted in
+#define OSAL_MEMORY_MPOL_MF_MOVE 2u
+
+// Nodes the mbind mask can name
+#define OSAL_MEMORY_MAX_NODES 1024u
+
+// Faults a range in for writing without touching it from user space (Linux 5.14)
+#ifndef MADV_POPULATE_WRITE
+    #define MADV_POPULATE_WRITE 23
+#endif
+
+// Local function definitions
+
+/**
+ * @brief Returns the base page size.
+ *
+ * @return Page size in bytes.
+ */
+static size_t page_bytes(void)
+{
+    const long size = sysconf(_SC_PAGESIZE);
+
+    return (size > 0) ? (size_t)size : 4096u;
+}
+
+/**
+ * @brief Maps anonymous read/write memory.
+ *
+ * @param length Bytes to map, a multiple of the page size.
+ * @param extra_flags Flags added to MAP_PRIVATE | MAP_ANONYMOUS.
+ * @return Start of the mapping, NULL on failure.
+ */
+static void* map_anonymous(size_t length, int extra_flags)
+{
+    void* address = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+
+    return (address == MAP_FAILED) ? NULL : address;
+}
+
+/**
+ * @brief Prefers a NUMA node for the pages of a range.
+ *
+ * @param address Start of the range.
+ * @param length Length of the range.
+ * @param node NUMA node.
+ * @param mbind_flags 0 for pages not faulted yet, OSAL_MEMORY_MPOL_MF_MOVE to migrate faulted ones.
+ * @return true if the policy was set.
+ */
+static bool bind_node(void* address, size_t length, int node, unsigned mbind_flags)
+{
+#if defined(SYS_mbind)
+    const size_t bits = 8u * sizeof(unsigned long);
+    unsigned long mask[OSAL_MEMORY_MAX_NODES / (8u * sizeof(unsigned long))];
+
+    if(node < 0 || (size_t)node >= OSAL_MEMORY_MAX_NODES - 1u)
+        return false;
+
+    memset(mask, 0, sizeof(mask));
+    mask[(size_t)node / bits] |= 1ul << ((size_t)node % bits);
+
+    return syscall(SYS_mbind, address, length, OSAL_MEMORY_MPOL_PREFERRED, mask, (unsigned long)OSAL_MEMORY_MAX_NODES, mbind_flags) == 0;
+#else
+    (void)address;
+    (void)length;
+    (void)node;
+    (void)mbind_flags;
+    return false;
+#endif
+}
+
+/**
+ * @brief Faults every page of a range in for writing.
+ *
+ * @param address Start of the range.
+ * @param length Length of the range.
+ * @param stride Page size of the range.
+ */
+static void prefault(void* address, size_t length, size_t stride)
+{
+    if(madvise(address, length, MADV_POPULATE_WRITE) == 0)
+        return;
+
+    // Older kernels : one write per page, the memory is zero anyway
+    volatile uint8_t* bytes = (volatile uint8_t*)address;
+
+    for(size_t offset = 0; offset < length; offset += stride)
+    {
+        bytes[offset] = 0;
+    }
+}
+
+// Global function definitions
+
+/**
+ * @brief Maps zeroed memory.
+ *
+ * Options are applied in the order that keeps them effective: the node
+ * policy is set before any page is faulted, then the pages are faulted
+ * in, then locked. An option the system refuses (no huge pages reserved,
+ * no CAP_IPC_LOCK, no NUMA) is skipped and missing from applied.
+ *
+ * @param out_memory Receives the mapping.
+ * @param bytes Bytes needed.
+ * @param flags OSAL_MEMORY_* options.
+ * @param numa_node Node for OSAL_MEMORY_NUMA_BIND, OSAL_MEMORY_NODE_LOCAL for the calling thread's node.
+ * @return true on success, false if nothing could be mapped.
+ */
+bool osal_memory_map(osal_memory_t* out_memory, size_t bytes, uint32_t flags, int numa_node)
+{
+    if(out_memory == NULL || bytes == 0)
+        return false;
+
+    memset(out_memory, 0, sizeof(*out_memory));
+
+    const size_t page = page_bytes();
+    size_t stride = page;
+
+    if(bytes > SIZE_MAX - OSAL_MEMORY_HUGE_PAGE_BYTES)
+        return false;
+
+    // Explicit huge pages need a reservation (vm.nr_hugepages), try them first
+    if((flags & OSAL_MEMORY_HUGE_PAGES) != 0)
+    {
+        const size_t length = (bytes + OSAL_MEMORY_HUGE_PAGE_BYTES - 1u) & ~(OSAL_MEMORY_HUGE_PAGE_BYTES - 1u);
+
+        out_memory->address = map_anonymous(length, MAP_HUGETLB);
+
+        if(out_memory->address != NULL)
+        {
+            out_memory->length = length;
+            out_memory->applied |= OSAL_MEMORY_HUGE_PAGES;
+            stride = OSAL_MEMORY_HUGE_PAGE_BYTES;
+        }
+    }
+
+    if(out_memory->address == NULL)
+    {
+        const size_t length = (bytes + page - 1u) & ~(page - 1u);
+
+        out_memory->address = map_anonymous(length, 0);
+
+        if(out_memory->address == NULL)
+            return false;
+
+        out_memory->length = length;
+
+        // Without a reservation ask for transparent huge pages instead
+        if((flags & OSAL_MEMORY_HUGE_PAGES) != 0 && madvise(out_memory->address, length, MADV_HUGEPAGE) == 0)
+            out_memory->applied |= OSAL_MEMORY_TRANSPARENT_HUGE_PAGES;
+    }
+
+    if((flags & OSAL_MEMORY_NUMA_BIND) != 0)
+    {
+        const int node = (numa_node == OSAL_MEMORY_NODE_LOCAL) ? osal_memory_current_node() : numa_node;
+
+        if(bind_node(out_memory->address, out_memory->length, node, 0u))
+        {
+            out_memory->applied |= OSAL_MEMORY_NUMA_BIND;
+            out_memory->node = node;
+        }
+    }
+
+    if((flags & OSAL_MEMORY_PREFAULT) != 0)
+    {
+        prefault(out_memory->address, out_memory->length, stride);
+        out_memory->applied |= OSAL_MEMORY_PREFAULT;
+    }
+
+    if((flags & OSAL_MEMORY_LOCK) != 0 && mlock(out_memory->address, out_memory->length) == 0)
+        out_memory->applied |= OSAL_MEMORY_LOCK;
+
+    return true;
+}
+
+/**
+ * @brief Moves a mapping to a NUMA node.
+ *
+ * For memory mapped before the thread that uses it was known, e.g. a ring
+ * allocated up front and claimed later by a producer. Faulted pages are
+ * migrated, later faults prefer the node; a locked mapping stays locked.
+ *
+ * @param memory Mapping from osal_memory_map.
+ * @param numa_node Target node, OSAL_MEMORY_NODE_LOCAL for the calling thread's node.
+ * @return true if the mapping is bound to the node, false if the system refused or nothing is mapped.
+ */
+bool osal_memory_bind(osal_memory_t* memory, int numa_node)
+{
+    if(memory == NULL || memory->address == NULL)
+        return false;
+
+    const int node = (numa_node == OSAL_MEMORY_NODE_LOCAL) ? osal_memory_current_node() : numa_node;
+
+    if((memory->applied & OSAL_MEMORY_NUMA_BIND) != 0 && memory->node == node)
+        return true;
+
+    if(!bind_node(memory->address, memory->length, node, OSAL_MEMORY_MPOL_MF_MOVE))
+        return false;
+
+    memory->applied |= OSAL_MEMORY_NUMA_BIND;
+    memory->node = node;
+
+    return true;
+}
+
+/**
+ * @brief Unmaps memory.
+ *
+ * @param memory Mapping from osal_memory_map, zeroed afterwards.
+ */
+void osal_memory_unmap(osal_memory_t* memory)
+{
+    if(memory == NULL || memory->address == NULL)
+        return;
+
+    // munmap drops a lock as well
+    (void)munmap(memory->address, memory->length);
+
+    memset(memory, 0, sizeof(*memory));
+}
+
+/**
+ * @brief Returns the NUMA node of the calling thread's CPU.
+ *
+ * @return Node number, 0 if the system does not say.
+ */
+int osal_memory_current_node(void)
+{
+#if defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+
+    if(syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+        return (int)node;
+#endif
+
+    return 0;
+}
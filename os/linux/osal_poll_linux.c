@@ -0,0 +1,237 @@
+/**
+ * @file osal_poll_linux.c
+ * @brief OS abstraction layer for waiting on many descriptors on Linux.
+ *
+ * Provides the poller with epoll, level triggered.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include "osal_poll.h"
+#include "osal_wakeup.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+// Ready descriptors collected per epoll_wait
+#define OSAL_POLLER_BATCH 16
+
+// Poller structure wrapping an epoll instance
+struct osal_poller
+{
+    int epoll_fd;           // epoll instance
+    bool owned;             // Allocated by osal_poller_create, freed by osal_poller_destroy
+};
+
+_Static_assert(sizeof(struct osal_poller) <= OSAL_POLLER_STORAGE_BYTES, "OSAL_POLLER_STORAGE_BYTES is too small");
+
+// Local function definitions
+
+/**
+ * @brief Converts OSAL_POLL_* events to epoll events.
+ *
+ * @param events OSAL_POLL_* events.
+ * @return epoll events.
+ */
+static uint32_t to_epoll_events(uint32_t events)
+{
+    uint32_t epoll_events = 0;
+
+    if((events & OSAL_POLL_READABLE) != 0)
+        epoll_events |= EPOLLIN;
+
+    if((events & OSAL_POLL_WRITABLE) != 0)
+        epoll_events |= EPOLLOUT;
+
+    return epoll_events;
+}
+
+/**
+ * @brief Adds or changes a descriptor.
+ *
+ * @param poller Poller.
+ * @param operation EPOLL_CTL_ADD or EPOLL_CTL_MOD.
+ * @param fd Descriptor.
+ * @param events OSAL_POLL_* events.
+ * @param context Returned with the events.
+ * @return true on success.
+ */
+static bool control(osal_poller_t* poller, int operation, int fd, uint32_t events, void* context)
+{
+    if(poller == NULL || fd < 0)
+        return false;
+
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = to_epoll_events(events);
+    event.data.ptr = context;
+
+    return epoll_ctl(poller->epoll_fd, operation, fd, &event) == 0;
+}
+
+// Global function definitions
+
+/**
+ * @brief Creates a poller.
+ *
+ * @return Pointer to poller, or NULL on failure.
+ */
+osal_poller_t* osal_poller_create(void)
+{
+    osal_poller_t* poller = (osal_poller_t*) calloc(1, sizeof(*poller));
+
+    if(poller == NULL)
+        return NULL;
+
+    poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    poller->owned = true;
+
+    if(poller->epoll_fd < 0)
+    {
+        free(poller);
+        return NULL;
+    }
+
+    return poller;
+}
+
+/**
+ * @brief Creates a poller in caller storage.
+ *
+ * @param memory Storage for the poller, aligned like an int.
+ * @param memory_bytes Size of memory, at least OSAL_POLLER_STORAGE_BYTES.
+ * @return Pointer to poller, or NULL on failure.
+ */
+osal_poller_t* osal_poller_create_static(void* memory, size_t memory_bytes)
+{
+    if(memory == NULL || ((uintptr_t)memory % _Alignof(osal_poller_t)) != 0 || memory_bytes < OSAL_POLLER_STORAGE_BYTES)
+        return NULL;
+
+    osal_poller_t* poller = (osal_poller_t*)memory;
+
+    poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    poller->owned = false;
+
+    if(poller->epoll_fd < 0)
+        return NULL;
+
+    return poller;
+}
+
+/**
+ * @brief Watches a descriptor.
+ *
+ * @param poller Poller.
+ * @param fd Descriptor.
+ * @param events OSAL_POLL_READABLE and/or OSAL_POLL_WRITABLE, 0 for errors only.
+ * @param context Returned with the events, may be NULL.
+ * @return true on success, false if fd is invalid or already watched.
+ */
+bool osal_poller_add(osal_poller_t* poller, int fd, uint32_t events, void* context)
+{
+    return control(poller, EPOLL_CTL_ADD, fd, events, context);
+}
+
+/**
+ * @brief Changes a watched descriptor.
+ *
+ * @param poller Poller.
+ * @param fd Descriptor.
+ * @param events New OSAL_POLL_* events.
+ * @param context New context.
+ * @return true on success, false if fd is not watched.
+ */
+bool osal_poller_modify(osal_poller_t* poller, int fd, uint32_t events, void* context)
+{
+    return control(poller, EPOLL_CTL_MOD, fd, events, context);
+}
+
+/**
+ * @brief Stops watching a descriptor.
+ *
+ * @param poller Poller.
+ * @param fd Descriptor.
+ * @return true on success, false if fd is not watched.
+ */
+bool osal_poller_remove(osal_poller_t* poller, int fd)
+{
+    if(poller == NULL || fd < 0)
+        return false;
+
+    return epoll_ctl(poller->epoll_fd, EPOLL_CTL_DEL, fd, NULL) == 0;
+}
+
+/**
+ * @brief Waits for ready descriptors.
+ *
+ * The timeout is rounded up to whole milliseconds; use an osal_timer_t
+ * in the poller for finer deadlines. A signal ends the wait early with 0.
+ *
+ * @param poller Poller.
+ * @param out_events Receives the ready descriptors.
+ * @param max_events Capacity of out_events.
+ * @param timeout_ns Longest wait, 0 to check, OSAL_WAIT_FOREVER to block.
+ * @return Number of ready descriptors, 0 on timeout, -1 on error.
+ */
+int osal_poller_wait(osal_poller_t* poller, osal_poll_event_t* out_events, size_t max_events, uint64_t timeout_ns)
+{
+    struct epoll_event ready[OSAL_POLLER_BATCH];
+
+    if(poller == NULL || out_events == NULL || max_events == 0)
+        return -1;
+
+    int timeout_ms = -1;
+
+    if(timeout_ns != OSAL_WAIT_FOREVER)
+    {
+        const uint64_t rounded_ms = (timeout_ns / 1000000ull) + ((timeout_ns % 1000000ull) != 0 ? 1u : 0u);
+        timeout_ms = (rounded_ms > (uint64_t)INT32_MAX) ? INT32_MAX : (int)rounded_ms;
+    }
+
+    const int capacity = (max_events < OSAL_POLLER_BATCH) ? (int)max_events : OSAL_POLLER_BATCH;
+    const int count = epoll_wait(poller->epoll_fd, ready, capacity, timeout_ms);
+
+    if(count < 0)
+        return (errno == EINTR) ? 0 : -1;
+
+    for(int index = 0; index < count; index++)
+    {
+        uint32_t events = 0;
+
+        if((ready[index].events & EPOLLIN) != 0)
+            events |= OSAL_POLL_READABLE;
+
+        if((ready[index].events & EPOLLOUT) != 0)
+            events |= OSAL_POLL_WRITABLE;
+
+        if((ready[index].events & (EPOLLERR | EPOLLHUP)) != 0)
+            events |= OSAL_POLL_ERROR;
+
+        out_events[index].context = ready[index].data.ptr;
+        out_events[index].events = events;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Destroys a poller.
+ *
+ * A poller in caller storage is only closed.
+ *
+ * @param poller Poller to destroy.
+ */
+void osal_poller_destroy(osal_poller_t* poller)
+{
+    if(poller == NULL)
+        return;
+
+    close(poller->epoll_fd);
+
+    if(poller->owned)
+        free(poller);
+}
@@ -12,16 +12,226 @@
 
 #include "osal_thread.h"
 
+#include <errno.h>
+#include <limits.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Longest thread name Linux keeps, without the terminator
+#define OSAL_THREAD_NAME_MAX 15u
 
 // Thread structure wrapping POSIX thread
 struct osal_thread
 {
     pthread_t thread_id;
+    osal_thread_fn_t entry_fn;      // Called by the start routine after the placement
+    void* entry_arg;
+    osal_thread_attr_t attr;        // Placement, applied by the new thread
+    atomic_uint applied;            // OSAL_THREAD_APPLIED_* bits
+    bool owned;                     // Allocated by osal_thread_create, freed by osal_thread_destroy
 };
 
+_Static_assert(sizeof(struct osal_thread) <= OSAL_THREAD_STORAGE_BYTES, "OSAL_THREAD_STORAGE_BYTES is too small");
+_Static_assert(OSAL_THREAD_MAX_CPUS <= CPU_SETSIZE, "the affinity mask must fit a cpu_set_t");
+
+// Local function definitions
+
+/**
+ * @brief Pins the calling thread to the CPUs of a mask.
+ *
+ * @param attr Attributes with the mask.
+ * @return true if the mask named CPUs and was applied.
+ */
+static bool apply_affinity(const osal_thread_attr_t* attr)
+{
+    cpu_set_t set;
+    bool any = false;
+
+    CPU_ZERO(&set);
+
+    for(unsigned cpu = 0; cpu < OSAL_THREAD_MAX_CPUS; cpu++)
+    {
+        if((attr->cpu_mask[cpu / 64u] & (1ull << (cpu % 64u))) != 0)
+        {
+            CPU_SET(cpu, &set);
+            any = true;
+        }
+    }
+
+    return any && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/**
+ * @brief Switches the calling thread to a real time policy.
+ *
+ * @param attr Attributes with the policy and priority.
+ * @return true if the policy was applied, false if it is the default or refused.
+ */
+static bool apply_scheduling(const osal_thread_attr_t* attr)
+{
+    int policy = 0;
+
+    switch(attr->policy)
+    {
+        case OSAL_THREAD_POLICY_FIFO: policy = SCHED_FIFO; break;
+        case OSAL_THREAD_POLICY_RR:   policy = SCHED_RR; break;
+        default:                      return false;
+    }
+
+    const int lowest = sched_get_priority_min(policy);
+    const int highest = sched_get_priority_max(policy);
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = (attr->priority < lowest) ? lowest : ((attr->priority > highest) ? highest : attr->priority);
+
+    // Unprivileged threads get EPERM and keep the default policy
+    return pthread_setschedparam(pthread_self(), policy, &param) == 0;
+}
+
+/**
+ * @brief Start routine of every thread.
+ *
+ * Applies the placement on the new thread itself, so a refused affinity or
+ * policy never keeps the thread from running, then runs the hook and the
+ * entry function.
+ *
+ * @param arg The thread handle.
+ * @return Result of the entry function.
+ */
+static void* thread_start(void* arg)
+{
+    osal_thread_t* thread = (osal_thread_t*)arg;
+    uint32_t applied = 0;
+
+    if(apply_affinity(&thread->attr))
+        applied |= OSAL_THREAD_APPLIED_AFFINITY;
+
+    if(apply_scheduling(&thread->attr))
+        applied |= OSAL_THREAD_APPLIED_SCHEDULING;
+
+    atomic_fetch_or_explicit(&thread->applied, applied, memory_order_release);
+
+    if(thread->attr.pre_start != NULL)
+        thread->attr.pre_start(thread->attr.pre_start_context);
+
+    return thread->entry_fn(thread->entry_arg);
+}
+
+/**
+ * @brief Starts the POSIX thread of a handle and names it.
+ *
+ * @param thread Handle to start.
+ * @param entry_fn Thread entry function.
+ * @param entry_arg Argument passed to the thread function.
+ * @param thread_name Optional thread name (Linux only).
+ * @param attr Placement, NULL for the defaults.
+ * @return true on success, false if the thread could not be created.
+ */
+static bool start_thread(osal_thread_t* thread, osal_thread_fn_t entry_fn, void* entry_arg, const char* thread_name,
+                         const osal_thread_attr_t* attr)
+{
+    pthread_attr_t pthread_attr;
+
+    thread->entry_fn = entry_fn;
+    thread->entry_arg = entry_arg;
+    atomic_init(&thread->applied, 0);
+
+    if(attr != NULL)
+        thread->attr = *attr;
+    else
+        osal_thread_attr_init(&thread->attr);
+
+    if(pthread_attr_init(&pthread_attr) != 0)
+    {
+        return false;
+    }
+
+    // Stack size rounded up to whole pages and at least the system minimum
+    if(thread->attr.stack_size != 0)
+    {
+        const long page = sysconf(_SC_PAGESIZE);
+        const size_t stack_min = (size_t)PTHREAD_STACK_MIN;
+        size_t stack_size = (thread->attr.stack_size < stack_min) ? stack_min : thread->attr.stack_size;
+
+        if(page > 0)
+            stack_size = (stack_size + (size_t)page - 1u) & ~((size_t)page - 1u);
+
+        if(pthread_attr_setstacksize(&pthread_attr, stack_size) == 0)
+            atomic_fetch_or_explicit(&thread->applied, OSAL_THREAD_APPLIED_STACK_SIZE, memory_order_relaxed);
+    }
+
+    // Create the POSIX thread
+    int result = pthread_create(&thread->thread_id, &pthread_attr, thread_start, thread);
+
+    pthread_attr_destroy(&pthread_attr);
+
+    if(result!=0)
+    {
+        return false;
+    }
+
+    // Set thread name if supported on Linux
+    #if defined(__linux__)
+
+        // Check if thread name is provided
+        if(thread_name && thread_name[0] != '\0')
+        {
+            // Truncate name to 16 bytes as required by Linux
+            char trunc_thread_name[OSAL_THREAD_NAME_MAX + 1u];
+            strncpy(trunc_thread_name, thread_name, OSAL_THREAD_NAME_MAX);
+            trunc_thread_name[OSAL_THREAD_NAME_MAX] = '\0';
+            pthread_setname_np(thread->thread_id, trunc_thread_name);
+        }
+
+    #else
+        (void)thread_name;
+    #endif
+
+    return true;
+}
+
+// Global function definitions
+
+/**
+ * @brief Fills thread attributes with the defaults.
+ *
+ * Any CPU, the inherited policy, the default stack and no hook.
+ *
+ * @param attr Attributes to initialize.
+ */
+void osal_thread_attr_init(osal_thread_attr_t* attr)
+{
+    if(attr == NULL)
+        return;
+
+    memset(attr, 0, sizeof(*attr));
+    attr->policy = OSAL_THREAD_POLICY_DEFAULT;
+}
+
+/**
+ * @brief Adds a CPU to the affinity mask.
+ *
+ * @param attr Attributes to change.
+ * @param cpu CPU number.
+ * @return true on success, false if cpu is out of range.
+ */
+bool osal_thread_attr_set_cpu(osal_thread_attr_t* attr, unsigned cpu)
+{
+    if(attr == NULL || cpu >= OSAL_THREAD_MAX_CPUS)
+        return false;
+
+    attr->cpu_mask[cpu / 64u] |= 1ull << (cpu % 64u);
+
+    return true;
+}
+
 /**
  * @brief Creates a new thread.
  *
@@ -35,6 +245,26 @@ struct osal_thread
  */
 
 int osal_thread_create(osal_thread_t ** out_thread, osal_thread_fn_t entry_fn, void* entry_arg, const char* thread_name)
+{
+    return osal_thread_create_ex(out_thread, entry_fn, entry_arg, thread_name, NULL);
+}
+
+/**
+ * @brief Creates a new thread with placement attributes.
+ *
+ * Allocates and initializes a new thread using POSIX threads. The stack
+ * size is set at creation, the affinity and the policy by the new thread
+ * before it runs the hook and entry_fn.
+ *
+ * @param out_thread Pointer that will receive the new thread object.
+ * @param entry_fn Thread entry function.
+ * @param entry_arg Argument passed to the thread function.
+ * @param thread_name Optional thread name (Linux only), truncated to 15 characters.
+ * @param attr Placement, NULL for the defaults.
+ * @return 0 on success, negative value on error.
+ */
+int osal_thread_create_ex(osal_thread_t ** out_thread, osal_thread_fn_t entry_fn, void* entry_arg, const char* thread_name,
+                          const osal_thread_attr_t* attr)
 {
     // Validate input parameters
     if(out_thread == NULL || entry_fn == NULL)
@@ -48,37 +278,78 @@ int osal_thread_create(osal_thread_t ** out_thread, osal_thread_fn_t entry_fn, v
     if(thread == NULL)
         return -2;
 
-    // Create the POSIX thread
-    int result = pthread_create(&thread->thread_id, NULL, entry_fn, entry_arg);
+    thread->owned = true;
 
-    if(result!=0)
+    if(!start_thread(thread, entry_fn, entry_arg, thread_name, attr))
     {
         // Free memory if thread creation failed
         free(thread);
         return -3;
     }
 
-    // Set thread name if supported on Linux
-    #if defined(__linux__)
+    *out_thread = thread;
 
-        // Check if thread name is provided
-        if(thread_name && thread_name[0] != '\0')
-        {
-            // Truncate name to 16 bytes as required by Linux
-            char trunc_thread_name[16];
-            strncpy(trunc_thread_name, thread_name, sizeof(thread_name)-1);
-            trunc_thread_name[sizeof(trunc_thread_name)-1] = '\0';
-            pthread_setname_np(thread->thread_id, trunc_thread_name);
-        }
+    // Return success
+    return 0;
+}
 
-    #endif 
+/**
+ * @brief Creates a new thread in caller storage.
+ *
+ * Same as osal_thread_create_ex, but the handle is placed in memory, which
+ * must stay valid until osal_thread_destroy.
+ *
+ * @param out_thread Pointer that will receive the thread object.
+ * @param memory Storage for the handle, aligned like a pointer.
+ * @param memory_bytes Size of memory, at least OSAL_THREAD_STORAGE_BYTES.
+ * @param entry_fn Thread entry function.
+ * @param entry_arg Argument passed to the thread function.
+ * @param thread_name Optional thread name (Linux only).
+ * @param attr Placement, NULL for the defaults.
+ * @return 0 on success, negative value on error.
+ */
+int osal_thread_create_static(osal_thread_t ** out_thread, void* memory, size_t memory_bytes,
+                              osal_thread_fn_t entry_fn, void* entry_arg, const char* thread_name,
+                              const osal_thread_attr_t* attr)
+{
+    // Validate input parameters
+    if(out_thread == NULL || entry_fn == NULL || memory == NULL ||
+       ((uintptr_t)memory % _Alignof(osal_thread_t)) != 0 || memory_bytes < OSAL_THREAD_STORAGE_BYTES)
+    {
+        return -1;
+    }
+
+    osal_thread_t* thread = (osal_thread_t*)memory;
+    memset(thread, 0, sizeof(*thread));
+    thread->owned = false;
+
+    if(!start_thread(thread, entry_fn, entry_arg, thread_name, attr))
+    {
+        return -3;
+    }
 
     *out_thread = thread;
 
-    // Return success
     return 0;
 }
 
+/**
+ * @brief Returns the placement that took effect.
+ *
+ * The affinity and scheduling bits are set by the new thread, before it
+ * runs its hook and entry function.
+ *
+ * @param thread Thread to query.
+ * @return OSAL_THREAD_APPLIED_* bits, 0 for NULL.
+ */
+uint32_t osal_thread_applied(const osal_thread_t* thread)
+{
+    if(thread == NULL)
+        return 0;
+
+    return atomic_load_explicit((atomic_uint*)&thread->applied, memory_order_acquire);
+}
+
 /**
  * @brief Joins a thread.
  *
@@ -101,12 +372,33 @@ int osal_thread_join(osal_thread_t* thread)
 /**
  * @brief Destroys a thread.
  *
- * Frees the thread resources.
+ * Frees the thread resources. A handle in caller storage is left as is.
  *
  * @param thread Thread to destroy.
  */
 void osal_thread_destroy(osal_thread_t* thread)
 {
+    if(thread == NULL || !thread->owned)
+        return;
+
     // Free the thread memory
     free(thread);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Sleeps the calling thread.
+ *
+ * Restarts after signals until the full time has passed.
+ *
+ * @param duration_ns Sleep time in nanoseconds.
+ */
+void osal_thread_sleep_ns(uint64_t duration_ns)
+{
+    struct timespec remaining;
+    remaining.tv_sec = (time_t)(duration_ns / 1000000000ull);
+    remaining.tv_nsec = (long)(duration_ns % 1000000000ull);
+
+    while(nanosleep(&remaining, &remaining) != 0 && errno == EINTR)
+    {
+    }
+}
@@ -1,17 +1,119 @@
+/**
+ * @file osal_time_linux.c
+ * @brief OS abstraction layer for time functions on Linux.
+ *
+ * Monotonic time from an invariant CPU counter when available, with
+ * clock_gettime(CLOCK_MONOTONIC) as fallback.
+ *
+ * The counter is converted as base_ns + ((ticks - base_ticks) * mult) >> 32.
+ * The three parameters are published through a sequence lock, so readers on
+ * any thread never block and the single resync thread can update them.
+ *
+ * The coarse clock service is a thread blocked on a timerfd that stores the
+ * monotonic time into its own cache line every period.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
 #include "osal_time.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/timerfd.h>
 #include <time.h>
+#include <unistd.h>
+
+#if !defined(OSAL_TIME_NO_TSC) && defined(__SIZEOF_INT128__) && (defined(__x86_64__) || defined(__i386__))
+    #include <cpuid.h>
+    #include <x86intrin.h>
+    #define OSAL_TIME_HAVE_COUNTER 1
+#elif !defined(OSAL_TIME_NO_TSC) && defined(__SIZEOF_INT128__) && defined(__aarch64__)
+    #define OSAL_TIME_HAVE_COUNTER 1
+#else
+    #define OSAL_TIME_HAVE_COUNTER 0
+#endif
+
+#if OSAL_TIME_HAVE_COUNTER
+    // 128 bit products keep the conversion exact for any tick distance
+    __extension__ typedef __int128 osal_int128_t;
+    __extension__ typedef unsigned __int128 osal_uint128_t;
+#endif
+
+// Fixed point shift of the tick multiplier
+#define OSAL_TIME_MULT_SHIFT 32u
+
+// Calibration window of the initial counter frequency estimate (2 ms)
+#define OSAL_TIME_CALIBRATION_NS 2000000ull
+
+// Resyncs closer than this are skipped, the rate can't be measured well enough (10 ms)
+#define OSAL_TIME_MIN_RESYNC_NS 10000000ull
+
+// Larger forward errors are stepped instead of slewed, e.g. after a suspend (1 ms)
+#define OSAL_TIME_MAX_SLEW_ERROR_NS 1000000ll
+
+// Largest rate correction applied while slewing, in parts per million
+#define OSAL_TIME_MAX_SLEW_PPM 1000u
+
+// Attempts per paired sample, the one with the shortest counter bracket wins
+#define OSAL_TIME_SAMPLE_ATTEMPTS 5
+
+#define OSAL_TIME_NS_PER_SECOND 1000000000ull
 
+// Sequence lock reads a signal handler tries before it reads the parameters as they are
+#define OSAL_TIME_SIGNAL_SAFE_ATTEMPTS 64
 
+// Struct declaration
+
+typedef struct osal_clock_state_s {
+    // Conversion parameters, read on every timestamp
+    _Alignas(64) atomic_uint sequence;  // Odd while the parameters are being written
+    atomic_uint_fast64_t base_ticks;
+    atomic_uint_fast64_t base_ns;
+    atomic_uint_fast64_t mult;          // Nanoseconds per tick << OSAL_TIME_MULT_SHIFT
+
+    atomic_int source;                  // 0 until osal_time_init() finished
+
+    // Resync state, only touched by the thread holding resync_busy
+    _Alignas(64) atomic_flag resync_busy;
+    uint64_t sync_ticks;                // Raw counter at the last resync
+    uint64_t sync_ns;                   // CLOCK_MONOTONIC at the last resync
+} osal_clock_state_t;
+
+static osal_clock_state_t clock_state = {
+    .resync_busy = ATOMIC_FLAG_INIT
+};
+
+static pthread_once_t clock_once = PTHREAD_ONCE_INIT;
+
+typedef struct osal_coarse_clock_s {
+    // Published time, alone on its cache line so readers only share it with the publisher
+    _Alignas(64) atomic_uint_fast64_t now_ns;   // 0 while the service is not running
+
+    // Service state, guarded by lock
+    _Alignas(64) pthread_mutex_t lock;
+    unsigned users;                     // Outstanding osal_time_coarse_start() calls
+    uint64_t period_ns;
+    int timer_fd;
+    pthread_t thread;
+    atomic_bool stop;
+} osal_coarse_clock_t;
+
+static osal_coarse_clock_t coarse_clock = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .timer_fd = -1
+};
+
+// Local function definitions
 
 /**
- * @brief Returns the current monotonic time in nanoseconds.
- *
- * Uses the monotonic clock, which is not affected by system time changes.
- * The value represents nanoseconds since an unspecified starting point.
+ * @brief Reads CLOCK_MONOTONIC in nanoseconds.
  *
  * @return Monotonic time in nanoseconds.
  */
-uint64_t osal_telemetry_now_monotonic_ns(void)
+static inline uint64_t read_monotonic_ns(void)
 {
     struct timespec ts;
 
@@ -19,6 +121,683 @@ uint64_t osal_telemetry_now_monotonic_ns(void)
     clock_gettime(CLOCK_MONOTONIC, &ts);
 
     // Convert seconds to nanoseconds, then add the nanosecond fraction to the final value.
-    return ((uint64_t) ts.tv_sec * 1000000000ull) + ((uint64_t)ts.tv_nsec);
+    return ((uint64_t) ts.tv_sec * OSAL_TIME_NS_PER_SECOND) + ((uint64_t)ts.tv_nsec);
+}
+
+/**
+ * @brief Reads CLOCK_MONOTONIC_COARSE in nanoseconds.
+ *
+ * @return Monotonic time with kernel tick resolution.
+ */
+static inline uint64_t read_monotonic_coarse_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+
+    return ((uint64_t) ts.tv_sec * OSAL_TIME_NS_PER_SECOND) + ((uint64_t)ts.tv_nsec);
+}
+
+/**
+ * @brief Converts nanoseconds to a timespec.
+ *
+ * @param ns Nanoseconds.
+ * @return Equivalent timespec.
+ */
+static inline struct timespec ns_to_timespec(uint64_t ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(ns / OSAL_TIME_NS_PER_SECOND);
+    ts.tv_nsec = (long)(ns % OSAL_TIME_NS_PER_SECOND);
+
+    return ts;
+}
+
+/**
+ * @brief Coarse clock thread, publishes the time on every timer expiry.
+ *
+ * Signals are blocked so handlers run on other threads. If the timer ever
+ * fails the published time is cleared, readers then fall back to
+ * CLOCK_MONOTONIC_COARSE instead of seeing a frozen time.
+ *
+ * @param arg Unused.
+ * @return NULL.
+ */
+static void* coarse_clock_main(void* arg)
+{
+    sigset_t blocked;
+
+    (void)arg;
+
+    sigfillset(&blocked);
+    pthread_sigmask(SIG_BLOCK, &blocked, NULL);
+
+    while(!atomic_load_explicit(&coarse_clock.stop, memory_order_acquire))
+    {
+        atomic_store_explicit(&coarse_clock.now_ns, osal_telemetry_now_monotonic_ns(), memory_order_relaxed);
+
+        // Missed expirations are simply folded into the next publish
+        uint64_t expirations;
+        ssize_t result;
+
+        do
+        {
+            result = read(coarse_clock.timer_fd, &expirations, sizeof(expirations));
+        }
+        while(result < 0 && errno == EINTR);
+
+        if(result < 0)
+        {
+            atomic_store_explicit(&coarse_clock.now_ns, 0, memory_order_relaxed);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+#if OSAL_TIME_HAVE_COUNTER
+
+/**
+ * @brief Reads the CPU counter.
+ *
+ * @return Counter value in ticks.
+ */
+static inline uint64_t read_counter(void)
+{
+#if defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (uint64_t)__rdtsc();
+#endif
+}
+
+/**
+ * @brief Checks whether the counter runs at a constant rate in all states.
+ *
+ * @param ticks_per_second Receives the architected frequency, 0 if it has
+ *                         to be calibrated.
+ * @return true if the counter can be used as a clock.
+ */
+static bool counter_is_invariant(uint64_t* ticks_per_second)
+{
+#if defined(__aarch64__)
+    // The generic timer is always constant rate and reports its frequency
+    uint64_t frequency;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+    *ticks_per_second = frequency;
+    return (frequency != 0);
+#else
+    unsigned eax, ebx, ecx, edx;
+
+    *ticks_per_second = 0;
+
+    // Invariant TSC: CPUID 0x80000007, EDX bit 8
+    if(__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx) == 0)
+        return false;
+
+    return ((edx & (1u << 8)) != 0);
+#endif
+}
+
+/**
+ * @brief Reads the counter and CLOCK_MONOTONIC at the same instant.
+ *
+ * The counter is read before and after clock_gettime(); the attempt with
+ * the shortest bracket is used and the counter value is its midpoint.
+ *
+ * @param ticks Receives the counter value.
+ * @param ns Receives the monotonic time.
+ */
+static void sample_pair(uint64_t* ticks, uint64_t* ns)
+{
+    uint64_t best_bracket = UINT64_MAX;
+
+    for(int attempt = 0; attempt < OSAL_TIME_SAMPLE_ATTEMPTS; attempt++)
+    {
+        const uint64_t before = read_counter();
+        const uint64_t now_ns = read_monotonic_ns();
+        const uint64_t after = read_counter();
+
+        // The first attempt always fills the outputs
+        if(attempt == 0 || after - before < best_bracket)
+        {
+            best_bracket = after - before;
+            *ticks = before + ((after - before) / 2u);
+            *ns = now_ns;
+        }
+    }
+}
+
+/**
+ * @brief Returns elapsed_ns / elapsed_ticks as a fixed point multiplier.
+ *
+ * @param elapsed_ns Nanoseconds between two samples.
+ * @param elapsed_ticks Ticks between the same samples, not 0.
+ * @return Multiplier for the tick conversion.
+ */
+static inline uint64_t rate_mult(uint64_t elapsed_ns, uint64_t elapsed_ticks)
+{
+    return (uint64_t)(((osal_uint128_t)elapsed_ns << OSAL_TIME_MULT_SHIFT) / elapsed_ticks);
+}
+
+/**
+ * @brief Publishes new conversion parameters.
+ *
+ * Only the thread holding resync_busy (or the init code) may call this.
+ *
+ * @param base_ticks Counter value of the anchor point.
+ * @param base_ns Nanoseconds at the anchor point.
+ * @param mult Nanoseconds per tick, fixed point.
+ */
+static void store_params(uint64_t base_ticks, uint64_t base_ns, uint64_t mult)
+{
+    const unsigned sequence = atomic_load_explicit(&clock_state.sequence, memory_order_relaxed);
+
+    // Odd sequence makes readers retry while the fields change
+    atomic_store_explicit(&clock_state.sequence, sequence + 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&clock_state.base_ticks, base_ticks, memory_order_relaxed);
+    atomic_store_explicit(&clock_state.base_ns, base_ns, memory_order_relaxed);
+    atomic_store_explicit(&clock_state.mult, mult, memory_order_relaxed);
+
+    atomic_store_explicit(&clock_state.sequence, sequence + 2u, memory_order_release);
+}
+
+#endif
+
+/**
+ * @brief Reads a consistent set of conversion parameters.
+ *
+ * @param base_ticks Receives the anchor counter value.
+ * @param base_ns Receives the anchor time.
+ * @param mult Receives the multiplier.
+ */
+static inline void load_params(uint64_t* base_ticks, uint64_t* base_ns, uint64_t* mult)
+{
+    unsigned begin;
+    unsigned end;
+
+    do
+    {
+        begin = atomic_load_explicit(&clock_state.sequence, memory_order_acquire);
+
+        *base_ticks = atomic_load_explicit(&clock_state.base_ticks, memory_order_relaxed);
+        *base_ns = atomic_load_explicit(&clock_state.base_ns, memory_order_relaxed);
+        *mult = atomic_load_explicit(&clock_state.mult, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&clock_state.sequence, memory_order_relaxed);
+    }
+    while((begin & 1u) != 0 || begin != end);
+}
+
+/**
+ * @brief Converts ticks with a given set of parameters.
+ *
+ * Ticks taken before the anchor convert to times before base_ns. The
+ * product is built from 32 bit halves, so loops over many values vectorize.
+ *
+ * @param ticks Counter value.
+ * @param base_ticks Anchor counter value.
+ * @param base_ns Anchor time.
+ * @param mult Multiplier.
+ * @return Monotonic nanoseconds.
+ */
+static inline uint64_t convert_ticks(uint64_t ticks, uint64_t base_ticks, uint64_t base_ns, uint64_t mult)
+{
+    const int64_t delta = (int64_t)(ticks - base_ticks);
+    const uint64_t magnitude = (delta < 0) ? (0u - (uint64_t)delta) : (uint64_t)delta;
+
+    // (magnitude * mult) >> 32 without a 128 bit product
+    _Static_assert(OSAL_TIME_MULT_SHIFT == 32u, "conversion splits the operands at the multiplier shift");
+    const uint64_t delta_high = magnitude >> 32;
+    const uint64_t delta_low = magnitude & 0xFFFFFFFFu;
+    const uint64_t mult_high = mult >> 32;
+    const uint64_t mult_low = mult & 0xFFFFFFFFu;
+
+    const uint64_t scaled = ((delta_high * mult_high) << 32) +
+                            (delta_high * mult_low) +
+                            (delta_low * mult_high) +
+                            ((delta_low * mult_low) >> 32);
+
+    return (delta < 0) ? (base_ns - scaled) : (base_ns + scaled);
+}
+
+/**
+ * @brief Selects and calibrates the clock source, runs once.
+ */
+static void clock_init_once(void)
+{
+    osal_clock_source_t source = OSAL_CLOCK_SOURCE_MONOTONIC;
+
+#if OSAL_TIME_HAVE_COUNTER
+    uint64_t ticks_per_second = 0;
+
+    if(counter_is_invariant(&ticks_per_second))
+    {
+        uint64_t start_ticks;
+        uint64_t start_ns;
+        uint64_t end_ticks;
+        uint64_t end_ns;
+
+        // Measure the frequency over a short window, resync refines it later
+        sample_pair(&start_ticks, &start_ns);
+        do
+        {
+            sample_pair(&end_ticks, &end_ns);
+        }
+        while(end_ns - start_ns < OSAL_TIME_CALIBRATION_NS);
+
+        uint64_t mult = 0;
+
+        if(ticks_per_second != 0)
+        {
+            mult = rate_mult(OSAL_TIME_NS_PER_SECOND, ticks_per_second);
+        }
+        else if(end_ticks > start_ticks)
+        {
+            mult = rate_mult(end_ns - start_ns, end_ticks - start_ticks);
+        }
+
+        // A counter that does not advance is of no use
+        if(mult != 0)
+        {
+            store_params(end_ticks, end_ns, mult);
+            clock_state.sync_ticks = end_ticks;
+            clock_state.sync_ns = end_ns;
+            source = OSAL_CLOCK_SOURCE_TSC;
+        }
+    }
+#endif
+
+    atomic_store_explicit(&clock_state.source, (int)source, memory_order_release);
+}
+
+/**
+ * @brief Returns the clock source, initializing it on first use.
+ *
+ * @return Selected clock source.
+ */
+static inline osal_clock_source_t current_source(void)
+{
+    int source = atomic_load_explicit(&clock_state.source, memory_order_acquire);
+
+    if(source == 0)
+    {
+        pthread_once(&clock_once, clock_init_once);
+        source = atomic_load_explicit(&clock_state.source, memory_order_acquire);
+    }
+
+    return (osal_clock_source_t)source;
+}
+
+// Global function definitions
+
+/**
+ * @brief Returns the current monotonic time in nanoseconds.
+ *
+ * Uses the calibrated CPU counter when available, otherwise the monotonic
+ * clock. Neither is affected by system time changes. The value represents
+ * nanoseconds since an unspecified starting point.
+ *
+ * @return Monotonic time in nanoseconds.
+ */
+uint64_t osal_telemetry_now_monotonic_ns(void)
+{
+    if(current_source() != OSAL_CLOCK_SOURCE_TSC)
+        return read_monotonic_ns();
+
+    return osal_time_ticks_to_ns(osal_telemetry_now_ticks());
+}
+
+/**
+ * @brief Selects and calibrates the clock source.
+ *
+ * Safe to call from several threads and more than once.
+ *
+ * @return Selected clock source.
+ */
+osal_clock_source_t osal_time_init(void)
+{
+    return current_source();
+}
+
+/**
+ * @brief Returns the selected clock source.
+ *
+ * @return Selected clock source.
+ */
+osal_clock_source_t osal_time_source(void)
+{
+    return current_source();
+}
+
+/**
+ * @brief Returns the raw counter value.
+ *
+ * @return CPU counter ticks, or nanoseconds with the monotonic fallback.
+ */
+uint64_t osal_telemetry_now_ticks(void)
+{
+#if OSAL_TIME_HAVE_COUNTER
+    if(current_source() == OSAL_CLOCK_SOURCE_TSC)
+        return read_counter();
+#else
+    (void)current_source();
+#endif
+
+    return read_monotonic_ns();
+}
+
+/**
+ * @brief Converts ticks to monotonic nanoseconds.
+ *
+ * @param ticks Value returned by osal_telemetry_now_ticks().
+ * @return Monotonic time in nanoseconds.
+ */
+uint64_t osal_time_ticks_to_ns(uint64_t ticks)
+{
+    uint64_t base_ticks;
+    uint64_t base_ns;
+    uint64_t mult;
+
+    if(current_source() != OSAL_CLOCK_SOURCE_TSC)
+        return ticks;
+
+    load_params(&base_ticks, &base_ns, &mult);
+
+    return convert_ticks(ticks, base_ticks, base_ns, mult);
+}
+
+/**
+ * @brief Converts ticks to monotonic nanoseconds from a signal handler.
+ *
+ * The handler may have interrupted the resync thread in the middle of an
+ * update, in which case the sequence never becomes even while the handler
+ * runs. After a bounded number of attempts the parameters are used as
+ * they are; a resync only moves them by a small step.
+ *
+ * @param ticks Value returned by osal_telemetry_now_ticks().
+ * @return Monotonic time in nanoseconds.
+ */
+uint64_t osal_time_ticks_to_ns_signal_safe(uint64_t ticks)
+{
+    // No pthread_once here, the clock must already be initialized
+    if(atomic_load_explicit(&clock_state.source, memory_order_acquire) != OSAL_CLOCK_SOURCE_TSC)
+        return ticks;
+
+    for(int attempt = 0; attempt < OSAL_TIME_SIGNAL_SAFE_ATTEMPTS; attempt++)
+    {
+        const unsigned begin = atomic_load_explicit(&clock_state.sequence, memory_order_acquire);
+
+        const uint64_t base_ticks = atomic_load_explicit(&clock_state.base_ticks, memory_order_relaxed);
+        const uint64_t base_ns = atomic_load_explicit(&clock_state.base_ns, memory_order_relaxed);
+        const uint64_t mult = atomic_load_explicit(&clock_state.mult, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+
+        if((begin & 1u) == 0 && begin == atomic_load_explicit(&clock_state.sequence, memory_order_relaxed))
+            return convert_ticks(ticks, base_ticks, base_ns, mult);
+    }
+
+    return convert_ticks(ticks,
+                         atomic_load_explicit(&clock_state.base_ticks, memory_order_relaxed),
+                         atomic_load_explicit(&clock_state.base_ns, memory_order_relaxed),
+                         atomic_load_explicit(&clock_state.mult, memory_order_relaxed));
+}
+
+/**
+ * @brief Converts an array of ticks to monotonic nanoseconds in place.
+ *
+ * The calibration is read once for the whole array, which makes this the
+ * cheap way for a consumer to convert a drained batch.
+ *
+ * @param values Tick values, replaced by nanoseconds.
+ * @param count Number of values.
+ */
+void osal_time_ticks_to_ns_bulk(uint64_t* values, size_t count)
+{
+    uint64_t base_ticks;
+    uint64_t base_ns;
+    uint64_t mult;
+
+    if(values == NULL || current_source() != OSAL_CLOCK_SOURCE_TSC)
+        return;
+
+    load_params(&base_ticks, &base_ns, &mult);
+
+    for(size_t index = 0; index < count; index++)
+    {
+        values[index] = convert_ticks(values[index], base_ticks, base_ns, mult);
+    }
+}
+
+/**
+ * @brief Returns the counter frequency.
+ *
+ * @return Ticks per second.
+ */
+uint64_t osal_time_ticks_per_second(void)
+{
+    uint64_t base_ticks;
+    uint64_t base_ns;
+    uint64_t mult;
+
+    if(current_source() != OSAL_CLOCK_SOURCE_TSC)
+        return OSAL_TIME_NS_PER_SECOND;
+
+    load_params(&base_ticks, &base_ns, &mult);
+
+#if OSAL_TIME_HAVE_COUNTER
+    return (uint64_t)(((osal_uint128_t)OSAL_TIME_NS_PER_SECOND << OSAL_TIME_MULT_SHIFT) / mult);
+#else
+    return OSAL_TIME_NS_PER_SECOND;
+#endif
+}
+
+/**
+ * @brief Corrects the tick conversion against CLOCK_MONOTONIC.
+ *
+ * Measures the counter rate over the time since the previous resync. The
+ * conversion stays continuous at the current instant and its rate is
+ * adjusted so the remaining error disappears over the next interval, with
+ * the correction limited to OSAL_TIME_MAX_SLEW_PPM. A large forward error
+ * (the counter fell behind) is stepped. Concurrent calls are skipped.
+ */
+void osal_time_resync(void)
+{
+#if OSAL_TIME_HAVE_COUNTER
+    if(current_source() != OSAL_CLOCK_SOURCE_TSC)
+        return;
+
+    if(atomic_flag_test_and_set_explicit(&clock_state.resync_busy, memory_order_acquire))
+        return;
+
+    uint64_t now_ticks;
+    uint64_t now_ns;
+    sample_pair(&now_ticks, &now_ns);
+
+    const uint64_t elapsed_ns = now_ns - clock_state.sync_ns;
+    const uint64_t elapsed_ticks = now_ticks - clock_state.sync_ticks;
+
+    if(elapsed_ns >= OSAL_TIME_MIN_RESYNC_NS && elapsed_ticks != 0)
+    {
+        uint64_t base_ticks;
+        uint64_t base_ns;
+        uint64_t mult;
+        load_params(&base_ticks, &base_ns, &mult);
+
+        const uint64_t estimate_ns = convert_ticks(now_ticks, base_ticks, base_ns, mult);
+        const int64_t error_ns = (int64_t)(now_ns - estimate_ns);
+        const uint64_t rate = rate_mult(elapsed_ns, elapsed_ticks);
+
+        if(error_ns > OSAL_TIME_MAX_SLEW_ERROR_NS)
+        {
+            // Far behind, jump forward
+            store_params(now_ticks, now_ns, rate);
+        }
+        else
+        {
+            // Spread the error over the next interval of the same length
+            osal_int128_t correction = ((osal_int128_t)rate * error_ns) / (osal_int128_t)elapsed_ns;
+            const osal_int128_t limit = ((osal_int128_t)rate * OSAL_TIME_MAX_SLEW_PPM) / 1000000;
+
+            if(correction > limit)
+                correction = limit;
+
+            if(correction < -limit)
+                correction = -limit;
+
+            store_params(now_ticks, estimate_ns, (uint64_t)((osal_int128_t)rate + correction));
+        }
+
+        clock_state.sync_ticks = now_ticks;
+        clock_state.sync_ns = now_ns;
+    }
+
+    atomic_flag_clear_explicit(&clock_state.resync_busy, memory_order_release);
+#endif
+}
+
+/**
+ * @brief Returns the coarse monotonic time.
+ *
+ * A single relaxed load while the service runs, the time is at most one
+ * period old. Otherwise CLOCK_MONOTONIC_COARSE is read, which is at most
+ * one kernel tick old.
+ *
+ * @return Monotonic time in nanoseconds.
+ */
+uint64_t osal_telemetry_now_coarse_ns(void)
+{
+    const uint64_t now_ns = atomic_load_explicit(&coarse_clock.now_ns, memory_order_relaxed);
+
+    if(now_ns != 0)
+        return now_ns;
+
+    return read_monotonic_coarse_ns();
+}
+
+/**
+ * @brief Starts the coarse clock service or takes another reference to it.
+ *
+ * @param period_ns Publish period, 0 for OSAL_TIME_COARSE_DEFAULT_PERIOD_NS.
+ *                  Ignored if the service is already running.
+ * @return true on success, false if the period is out of range or the
+ *         timer or thread can not be created.
+ */
+bool osal_time_coarse_start(uint64_t period_ns)
+{
+    if(period_ns == 0)
+        period_ns = OSAL_TIME_COARSE_DEFAULT_PERIOD_NS;
+
+    if(period_ns < OSAL_TIME_COARSE_MIN_PERIOD_NS || period_ns > OSAL_TIME_COARSE_MAX_PERIOD_NS)
+        return false;
+
+    pthread_mutex_lock(&coarse_clock.lock);
+
+    if(coarse_clock.users > 0)
+    {
+        coarse_clock.users++;
+        pthread_mutex_unlock(&coarse_clock.lock);
+        return true;
+    }
+
+    const int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if(timer_fd < 0)
+    {
+        pthread_mutex_unlock(&coarse_clock.lock);
+        return false;
+    }
+
+    struct itimerspec spec;
+    spec.it_interval = ns_to_timespec(period_ns);
+    spec.it_value = spec.it_interval;
+
+    if(timerfd_settime(timer_fd, 0, &spec, NULL) != 0)
+    {
+        close(timer_fd);
+        pthread_mutex_unlock(&coarse_clock.lock);
+        return false;
+    }
+
+    coarse_clock.timer_fd = timer_fd;
+    coarse_clock.period_ns = period_ns;
+    atomic_store_explicit(&coarse_clock.stop, false, memory_order_relaxed);
+
+    // Publish before the thread starts so the caller's first read is already served by the service,
+    // and a thread that fails right away is not overwritten
+    atomic_store_explicit(&coarse_clock.now_ns, osal_telemetry_now_monotonic_ns(), memory_order_relaxed);
+
+    if(pthread_create(&coarse_clock.thread, NULL, coarse_clock_main, NULL) != 0)
+    {
+        atomic_store_explicit(&coarse_clock.now_ns, 0, memory_order_relaxed);
+        close(timer_fd);
+        coarse_clock.timer_fd = -1;
+        pthread_mutex_unlock(&coarse_clock.lock);
+        return false;
+    }
+
+    coarse_clock.users = 1;
+
+    pthread_mutex_unlock(&coarse_clock.lock);
+    return true;
+}
+
+/**
+ * @brief Releases a reference to the coarse clock service.
+ *
+ * The last reference stops the thread and closes the timer; readers fall
+ * back to CLOCK_MONOTONIC_COARSE.
+ */
+void osal_time_coarse_stop(void)
+{
+    pthread_mutex_lock(&coarse_clock.lock);
+
+    if(coarse_clock.users == 0 || --coarse_clock.users > 0)
+    {
+        pthread_mutex_unlock(&coarse_clock.lock);
+        return;
+    }
+
+    atomic_store_explicit(&coarse_clock.stop, true, memory_order_release);
+
+    // Fire the timer right away so the thread sees the stop flag without waiting a period
+    struct itimerspec spec = { { 0, 0 }, { 0, 1 } };
+    timerfd_settime(coarse_clock.timer_fd, 0, &spec, NULL);
+
+    pthread_join(coarse_clock.thread, NULL);
+    close(coarse_clock.timer_fd);
+    coarse_clock.timer_fd = -1;
+
+    atomic_store_explicit(&coarse_clock.now_ns, 0, memory_order_relaxed);
+
+    pthread_mutex_unlock(&coarse_clock.lock);
+}
+
+/**
+ * @brief Returns how old a coarse time can be.
+ *
+ * @return The service period while it runs, otherwise the resolution of
+ *         CLOCK_MONOTONIC_COARSE.
+ */
+uint64_t osal_time_coarse_resolution_ns(void)
+{
+    pthread_mutex_lock(&coarse_clock.lock);
+    const uint64_t period_ns = (coarse_clock.users > 0) ? coarse_clock.period_ns : 0;
+    pthread_mutex_unlock(&coarse_clock.lock);
+
+    if(period_ns != 0)
+        return period_ns;
+
+    struct timespec ts;
+    if(clock_getres(CLOCK_MONOTONIC_COARSE, &ts) != 0)
+        return 0;
 
-}
\ No newline at end of file
+    return ((uint64_t) ts.tv_sec * OSAL_TIME_NS_PER_SECOND) + ((uint64_t)ts.tv_nsec);
+}
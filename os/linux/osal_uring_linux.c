@@ -0,0 +1,453 @@
+/**
+ * @file osal_uring_linux.c
+ * @brief OS abstraction layer for asynchronous socket sends on Linux.
+ *
+ * Provides the send ring with io_uring through raw system calls. The
+ * submission and completion queues are mapped once; queuing a send only
+ * writes a submission entry, and a submit publishes the queue tail and
+ * makes one io_uring_enter call, or none while the SQPOLL thread is awake.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#define _GNU_SOURCE
+
+#include "osal_uring.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Operations asked about by IORING_REGISTER_PROBE
+#define OSAL_URING_PROBE_OPS 256u
+
+// Send ring structure over the mapped io_uring queues
+struct osal_uring
+{
+    int ring_fd;                    // io_uring instance
+    uint32_t applied;               // OSAL_URING_* options that took effect
+
+    _Atomic uint32_t* sq_head;      // Advanced by the kernel as it takes entries
+    _Atomic uint32_t* sq_tail;      // Published by osal_uring_submit
+    _Atomic uint32_t* sq_flags;     // IORING_SQ_NEED_WAKEUP when the SQPOLL thread sleeps
+    uint32_t* sq_array;             // Entry index per queue position
+    uint32_t sq_mask;
+    uint32_t sq_entries;
+    uint32_t sq_local_tail;         // Entries queued, published or not
+    struct io_uring_sqe* sqes;      // Submission entries
+
+    _Atomic uint32_t* cq_head;      // Advanced by osal_uring_reap
+    _Atomic uint32_t* cq_tail;      // Advanced by the kernel
+    uint32_t cq_mask;
+    struct io_uring_cqe* cqes;      // Completion entries
+
+    void* sq_ring;                  // Mapping of the submission queue, and the completion queue with a single mmap
+    size_t sq_ring_bytes;
+    void* cq_ring;                  // Mapping of the completion queue, same as sq_ring with a single mmap
+    size_t cq_ring_bytes;
+    size_t sqes_bytes;
+};
+
+// Local function definitions
+
+static int uring_setup(uint32_t entries, struct io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(int ring_fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(int ring_fd, uint32_t opcode, const void* arg, uint32_t count)
+{
+    return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, count);
+}
+
+/**
+ * @brief Tells whether the kernel knows an operation.
+ *
+ * @param ring_fd io_uring instance.
+ * @param opcode IORING_OP_* operation.
+ * @return true if supported.
+ */
+static bool opcode_supported(int ring_fd, uint8_t opcode)
+{
+    // The probe header is followed by one entry per operation
+    _Alignas(struct io_uring_probe) uint8_t storage[sizeof(struct io_uring_probe) +
+                                                   (OSAL_URING_PROBE_OPS * sizeof(struct io_uring_probe_op))];
+    struct io_uring_probe* probe = (struct io_uring_probe*)storage;
+
+    memset(storage, 0, sizeof(storage));
+
+    if(uring_register(ring_fd, IORING_REGISTER_PROBE, probe, OSAL_URING_PROBE_OPS) < 0)
+        return false;
+
+    return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+/**
+ * @brief Maps the submission and completion queues.
+ *
+ * @param ring Ring with ring_fd set.
+ * @param params Parameters filled by io_uring_setup.
+ * @return true on success.
+ */
+static bool map_queues(osal_uring_t* ring, const struct io_uring_params* params)
+{
+    ring->sq_ring_bytes = params->sq_off.array + params->sq_entries * sizeof(uint32_t);
+    ring->cq_ring_bytes = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+
+    // One mapping holds both rings on every kernel that reports it
+    if((params->features & IORING_FEAT_SINGLE_MMAP) != 0 && ring->cq_ring_bytes > ring->sq_ring_bytes)
+        ring->sq_ring_bytes = ring->cq_ring_bytes;
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring->ring_fd, IORING_OFF_SQ_RING);
+
+    if(ring->sq_ring == MAP_FAILED)
+    {
+        ring->sq_ring = NULL;
+        return false;
+    }
+
+    if((params->features & IORING_FEAT_SINGLE_MMAP) != 0)
+    {
+        ring->cq_ring = ring->sq_ring;
+    }
+    else
+    {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             ring->ring_fd, IORING_OFF_CQ_RING);
+
+        if(ring->cq_ring == MAP_FAILED)
+        {
+            ring->cq_ring = NULL;
+            return false;
+        }
+    }
+
+    ring->sqes_bytes = params->sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                            ring->ring_fd, IORING_OFF_SQES);
+
+    if(ring->sqes == MAP_FAILED)
+    {
+        ring->sqes = NULL;
+        return false;
+    }
+
+    uint8_t* sq = (uint8_t*)ring->sq_ring;
+    uint8_t* cq = (uint8_t*)ring->cq_ring;
+
+    ring->sq_head = (_Atomic uint32_t*)(sq + params->sq_off.head);
+    ring->sq_tail = (_Atomic uint32_t*)(sq + params->sq_off.tail);
+    ring->sq_flags = (_Atomic uint32_t*)(sq + params->sq_off.flags);
+    ring->sq_array = (uint32_t*)(sq + params->sq_off.array);
+    ring->sq_mask = *(uint32_t*)(sq + params->sq_off.ring_mask);
+    ring->sq_entries = params->sq_entries;
+    ring->sq_local_tail = atomic_load_explicit(ring->sq_tail, memory_order_relaxed);
+
+    ring->cq_head = (_Atomic uint32_t*)(cq + params->cq_off.head);
+    ring->cq_tail = (_Atomic uint32_t*)(cq + params->cq_off.tail);
+    ring->cq_mask = *(uint32_t*)(cq + params->cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params->cq_off.cqes);
+
+    return true;
+}
+
+/**
+ * @brief Takes a free submission entry.
+ *
+ * @param ring Send ring.
+ * @return Zeroed entry, or NULL if the queue is full.
+ */
+static struct io_uring_sqe* next_sqe(osal_uring_t* ring)
+{
+    const uint32_t head = atomic_load_explicit(ring->sq_head, memory_order_acquire);
+
+    if(ring->sq_local_tail - head >= ring->sq_entries)
+        return NULL;
+
+    const uint32_t index = ring->sq_local_tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->sq_local_tail++;
+
+    return sqe;
+}
+
+// Global function definitions
+
+/**
+ * @brief Creates a send ring.
+ *
+ * SQPOLL falls back to plain submits and registered buffers to copied
+ * sends when the kernel refuses them; osal_uring_applied() tells.
+ *
+ * @param entries Sends in flight, rounded up to a power of two by the kernel.
+ * @param flags OSAL_URING_SQPOLL and/or OSAL_URING_REGISTERED_BUFFERS.
+ * @param buffer Memory to register, required for OSAL_URING_REGISTERED_BUFFERS.
+ * @param buffer_bytes Size of buffer.
+ * @return Pointer to the ring, or NULL if io_uring is unavailable.
+ */
+osal_uring_t* osal_uring_create(uint32_t entries, uint32_t flags, void* buffer, size_t buffer_bytes)
+{
+    struct io_uring_params params;
+
+    if(entries == 0)
+        return NULL;
+
+    osal_uring_t* ring = (osal_uring_t*) calloc(1, sizeof(*ring));
+
+    if(ring == NULL)
+        return NULL;
+
+    // SQPOLL first if asked for, a plain ring otherwise or when it is refused
+    ring->ring_fd = -1;
+
+    if((flags & OSAL_URING_SQPOLL) != 0)
+    {
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_SQPOLL | IORING_SETUP_CLAMP;
+        params.sq_thread_idle = OSAL_URING_SQPOLL_IDLE_MS;
+        ring->ring_fd = uring_setup(entries, &params);
+
+        if(ring->ring_fd >= 0)
+            ring->applied |= OSAL_URING_SQPOLL;
+    }
+
+    if(ring->ring_fd < 0)
+    {
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CLAMP;
+        ring->ring_fd = uring_setup(entries, &params);
+    }
+
+    // Missing, disabled by io_uring_disabled or filtered by seccomp
+    if(ring->ring_fd < 0 || !map_queues(ring, &params) || !opcode_supported(ring->ring_fd, IORING_OP_SENDMSG))
+    {
+        osal_uring_destroy(ring);
+        return NULL;
+    }
+
+    // Registered pages are pinned, RLIMIT_MEMLOCK may refuse them
+    if((flags & OSAL_URING_REGISTERED_BUFFERS) != 0 && buffer != NULL && buffer_bytes != 0 &&
+       opcode_supported(ring->ring_fd, IORING_OP_SEND_ZC))
+    {
+        struct iovec region = { buffer, buffer_bytes };
+
+        if(uring_register(ring->ring_fd, IORING_REGISTER_BUFFERS, &region, 1) == 0)
+            ring->applied |= OSAL_URING_REGISTERED_BUFFERS;
+    }
+
+    return ring;
+}
+
+/**
+ * @brief Returns the options that took effect.
+ *
+ * @param ring Send ring.
+ * @return OSAL_URING_* bits, 0 for NULL.
+ */
+uint32_t osal_uring_applied(const osal_uring_t* ring)
+{
+    return (ring == NULL) ? 0u : ring->applied;
+}
+
+/**
+ * @brief Queues a sendmsg.
+ *
+ * @param ring Send ring.
+ * @param fd Socket.
+ * @param message Message, valid with its iovec and address until the completion.
+ * @param user_data Returned with the completion.
+ * @return true if queued, false if the queue is full.
+ */
+bool osal_uring_queue_sendmsg(osal_uring_t* ring, int fd, const struct msghdr* message, uint64_t user_data)
+{
+    if(ring == NULL || fd < 0 || message == NULL)
+        return false;
+
+    struct io_uring_sqe* sqe = next_sqe(ring);
+
+    if(sqe == NULL)
+        return false;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)message;
+    sqe->len = 1;
+    sqe->user_data = user_data;
+
+    return true;
+}
+
+/**
+ * @brief Queues a zero-copy send from the registered buffer.
+ *
+ * @param ring Send ring with OSAL_URING_REGISTERED_BUFFERS applied.
+ * @param fd Socket.
+ * @param data Bytes inside the registered buffer.
+ * @param length Number of bytes.
+ * @param address Destination address, read when the send is submitted.
+ * @param address_length Size of address.
+ * @param user_data Returned with both completions.
+ * @return true if queued, false if the queue is full or no buffer is registered.
+ */
+bool osal_uring_queue_send_fixed(osal_uring_t* ring, int fd, const void* data, size_t length,
+                                 const void* address, uint32_t address_length, uint64_t user_data)
+{
+    if(ring == NULL || fd < 0 || data == NULL || (ring->applied & OSAL_URING_REGISTERED_BUFFERS) == 0 ||
+       length > UINT32_MAX || address_length > UINT16_MAX)
+        return false;
+
+    struct io_uring_sqe* sqe = next_sqe(ring);
+
+    if(sqe == NULL)
+        return false;
+
+    sqe->opcode = IORING_OP_SEND_ZC;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)data;
+    sqe->len = (uint32_t)length;
+    sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+    sqe->buf_index = 0;
+    sqe->addr2 = (uint64_t)(uintptr_t)address;
+    sqe->addr_len = (uint16_t)address_length;
+    sqe->user_data = user_data;
+
+    return true;
+}
+
+/**
+ * @brief Hands every queued send to the kernel.
+ *
+ * With SQPOLL applied this is a store, plus a wakeup call only when the
+ * kernel thread went to sleep after OSAL_URING_SQPOLL_IDLE_MS.
+ *
+ * @param ring Send ring.
+ * @return Number of sends handed over, -1 on error.
+ */
+int osal_uring_submit(osal_uring_t* ring)
+{
+    if(ring == NULL)
+        return -1;
+
+    // Entries the kernel has not taken yet, including any a failed call left behind. Read before the
+    // tail is published, a polling thread could take some of them right after.
+    const uint32_t pending = ring->sq_local_tail - atomic_load_explicit(ring->sq_head, memory_order_acquire);
+
+    if(pending == 0)
+        return 0;
+
+    atomic_store_explicit(ring->sq_tail, ring->sq_local_tail, memory_order_release);
+
+    if((ring->applied & OSAL_URING_SQPOLL) != 0)
+    {
+        // The tail store must be visible before the thread's flag is read
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if((atomic_load_explicit(ring->sq_flags, memory_order_relaxed) & IORING_SQ_NEED_WAKEUP) != 0 &&
+           uring_enter(ring->ring_fd, 0, 0, IORING_ENTER_SQ_WAKEUP) < 0)
+            return -1;
+
+        return (int)pending;
+    }
+
+    const int submitted = uring_enter(ring->ring_fd, pending, 0, 0);
+
+    if(submitted < 0)
+        return (errno == EINTR || errno == EAGAIN || errno == EBUSY) ? 0 : -1;
+
+    return submitted;
+}
+
+/**
+ * @brief Reaps completions.
+ *
+ * @param ring Send ring.
+ * @param out_completions Receives the completions.
+ * @param max_completions Capacity of out_completions.
+ * @param wait_count Completions to wait for, 0 never blocks.
+ * @return Number of completions stored.
+ */
+size_t osal_uring_reap(osal_uring_t* ring, osal_uring_completion_t* out_completions, size_t max_completions,
+                       uint32_t wait_count)
+{
+    if(ring == NULL || out_completions == NULL || max_completions == 0)
+        return 0;
+
+    uint32_t head = atomic_load_explicit(ring->cq_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(ring->cq_tail, memory_order_acquire);
+
+    if(wait_count != 0 && tail - head < wait_count)
+    {
+        // A signal ends the wait early, the caller sees fewer completions
+        (void)uring_enter(ring->ring_fd, 0, wait_count, IORING_ENTER_GETEVENTS);
+        tail = atomic_load_explicit(ring->cq_tail, memory_order_acquire);
+    }
+
+    size_t count = 0;
+
+    while(head != tail && count < max_completions)
+    {
+        const struct io_uring_cqe* cqe = &ring->cqes[head & ring->cq_mask];
+
+        out_completions[count].user_data = cqe->user_data;
+
+        // A zero-copy send posts its result with MORE, then a NOTIF once the buffer is free
+        if((cqe->flags & IORING_CQE_F_NOTIF) != 0)
+        {
+            out_completions[count].result = 0;
+            out_completions[count].release = true;
+        }
+        else
+        {
+            out_completions[count].result = cqe->res;
+            out_completions[count].release = (cqe->flags & IORING_CQE_F_MORE) == 0;
+        }
+
+        head++;
+        count++;
+    }
+
+    atomic_store_explicit(ring->cq_head, head, memory_order_release);
+
+    return count;
+}
+
+/**
+ * @brief Destroys a send ring.
+ *
+ * @param ring Send ring to destroy.
+ */
+void osal_uring_destroy(osal_uring_t* ring)
+{
+    if(ring == NULL)
+        return;
+
+    if(ring->sqes != NULL)
+        munmap(ring->sqes, ring->sqes_bytes);
+
+    if(ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring)
+        munmap(ring->cq_ring, ring->cq_ring_bytes);
+
+    if(ring->sq_ring != NULL)
+        munmap(ring->sq_ring, ring->sq_ring_bytes);
+
+    if(ring->ring_fd >= 0)
+        close(ring->ring_fd);
+
+    free(ring);
+}
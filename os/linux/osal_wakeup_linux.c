@@ -2,33 +2,309 @@
  * @file osal_wakeup_linux.c
  * @brief OS abstraction layer for wakeup mechanism on Linux.
  *
- * Provides event-based wakeup notifications using eventfd.
+ * Provides event-based wakeup notifications using eventfd or a futex
+ * word, and periodic timers using timerfd. A wakeup and a timer are waited
+ * on together with ppoll, or with a futex wait bounded by the next timer
+ * expiry.
+ *
+ * The futex word holds one of three states. A notify swaps in NOTIFIED and
+ * only enters the kernel when the previous state was SLEEPING, so notifies
+ * while the waiter is busy cost one atomic exchange. The waiter consumes
+ * NOTIFIED, or moves IDLE to SLEEPING and sleeps in FUTEX_WAIT_BITSET as
+ * long as the word stays SLEEPING.
  *
  * @author Aravinthraj Ganesan
  */
 
+#define _GNU_SOURCE
+
 #include "osal_wakeup.h"
+#include <linux/futex.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include <errno.h>
 
-// Thread-safe wakeup structure using eventfd
+// States of the futex word
+#define OSAL_WAKEUP_IDLE     0u     // Nothing pending, nobody sleeping
+#define OSAL_WAKEUP_PENDING  1u     // Notified since the last wait
+#define OSAL_WAKEUP_SLEEPING 2u     // The waiter sleeps in the kernel
+
+// Backend of OSAL_WAKEUP_BACKEND_DEFAULT
+#if defined(OSAL_WAKEUP_DEFAULT_FUTEX)
+    #define OSAL_WAKEUP_BUILD_BACKEND OSAL_WAKEUP_BACKEND_FUTEX
+#else
+    #define OSAL_WAKEUP_BUILD_BACKEND OSAL_WAKEUP_BACKEND_EVENTFD
+#endif
+
+// Thread-safe wakeup structure using eventfd or a futex word
 struct osal_wakeup
 {
-    int event_fd;           // File descriptor for wakeup notifications
+    osal_wakeup_backend_t backend;  // EVENTFD or FUTEX
+    int event_fd;                   // File descriptor for wakeup notifications, -1 for a futex
+    atomic_uint futex_word;         // OSAL_WAKEUP_IDLE, _PENDING or _SLEEPING
+    bool owned;                     // Allocated by osal_wakeup_create, freed by osal_wakeup_destroy
+};
+
+// Periodic timer structure using timerfd
+struct osal_timer
+{
+    int timer_fd;           // Non-blocking timerfd on CLOCK_MONOTONIC
+    bool owned;             // Allocated by osal_timer_create, freed by osal_timer_destroy
 };
 
+_Static_assert(sizeof(struct osal_wakeup) <= OSAL_WAKEUP_STORAGE_BYTES, "OSAL_WAKEUP_STORAGE_BYTES is too small");
+_Static_assert(sizeof(struct osal_timer) <= OSAL_TIMER_STORAGE_BYTES, "OSAL_TIMER_STORAGE_BYTES is too small");
+
+// Local function definitions
+
+/**
+ * @brief Reads CLOCK_MONOTONIC.
+ *
+ * @return Current time in nanoseconds.
+ */
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Converts nanoseconds to a timespec.
+ *
+ * @param duration_ns Duration in nanoseconds.
+ * @return The same duration as a timespec.
+ */
+static struct timespec to_timespec(uint64_t duration_ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(duration_ns / 1000000000ull);
+    ts.tv_nsec = (long)(duration_ns % 1000000000ull);
+
+    return ts;
+}
+
+/**
+ * @brief Consumes the pending notifications of an eventfd without blocking.
+ *
+ * @param wakeup Wakeup object with an eventfd.
+ * @return 1 if notifications were consumed, 0 if none were pending, -1 on error.
+ */
+static int consume_notifications(osal_wakeup_t* wakeup)
+{
+    uint64_t accumulated_notification_count = 0;
+
+    while(1)
+    {
+        ssize_t bytes_read = read(wakeup->event_fd, &accumulated_notification_count, sizeof(accumulated_notification_count));
+
+        if(bytes_read == (ssize_t)sizeof(accumulated_notification_count))
+            return 1;
+
+        if(bytes_read < 0 && errno == EINTR)
+            continue;
+
+        return (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 0 : -1;
+    }
+}
+
+/**
+ * @brief Waits on the eventfd until notified or a deadline passes.
+ *
+ * The eventfd is non-blocking: a pending notification costs one read, and
+ * only an empty counter leads to ppoll. The descriptor can also sit in an
+ * osal_poller_t, with this function consuming after it polled readable.
+ *
+ * @param wakeup Wakeup object with an eventfd.
+ * @param deadline_ns Monotonic deadline, UINT64_MAX to block.
+ * @return true if notified.
+ */
+static bool eventfd_wait(osal_wakeup_t* wakeup, uint64_t deadline_ns)
+{
+    struct pollfd poll_fd = { wakeup->event_fd, POLLIN, 0 };
+
+    while(1)
+    {
+        const int consumed = consume_notifications(wakeup);
+
+        if(consumed != 0)
+            return consumed > 0;
+
+        const uint64_t now_ns = monotonic_ns();
+
+        if(deadline_ns != UINT64_MAX && now_ns >= deadline_ns)
+            return false;
+
+        const struct timespec remaining = to_timespec((deadline_ns != UINT64_MAX) ? deadline_ns - now_ns : 0);
+
+        // Timed out, or ready and consumed on the next round
+        int ready = ppoll(&poll_fd, 1, (deadline_ns != UINT64_MAX) ? &remaining : NULL, NULL);
+
+        if(ready == 0)
+            return false;
+
+        if(ready < 0 && errno != EINTR)
+            return false;
+    }
+}
+
+/**
+ * @brief Waits on the futex word until notified or a deadline passes.
+ *
+ * FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC deadline, so
+ * signals and spurious wakeups retry without recomputing the timeout.
+ *
+ * @param wakeup Wakeup object with a futex word.
+ * @param deadline_ns Monotonic deadline, UINT64_MAX to block.
+ * @return true if notified.
+ */
+static bool futex_wait(osal_wakeup_t* wakeup, uint64_t deadline_ns)
+{
+    const struct timespec deadline = to_timespec(deadline_ns);
+
+    while(1)
+    {
+        // Fast path : consume a pending notification without a system call
+        if(atomic_exchange_explicit(&wakeup->futex_word, OSAL_WAKEUP_IDLE, memory_order_acquire) == OSAL_WAKEUP_PENDING)
+            return true;
+
+        if(deadline_ns != UINT64_MAX && monotonic_ns() >= deadline_ns)
+            return false;
+
+        // Announce the sleep, a notify in between leaves PENDING and the next round consumes it
+        unsigned expected = OSAL_WAKEUP_IDLE;
+
+        if(!atomic_compare_exchange_strong_explicit(&wakeup->futex_word, &expected, OSAL_WAKEUP_SLEEPING,
+                                                    memory_order_acq_rel, memory_order_acquire))
+            continue;
+
+        // Sleeps only while the word is still SLEEPING
+        long rc = syscall(SYS_futex, &wakeup->futex_word, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, OSAL_WAKEUP_SLEEPING,
+                          (deadline_ns == UINT64_MAX) ? NULL : &deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+
+        if(rc != 0 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+        {
+            (void)atomic_exchange_explicit(&wakeup->futex_word, OSAL_WAKEUP_IDLE, memory_order_acquire);
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Waits on either backend until notified or a deadline passes.
+ *
+ * @param wakeup Wakeup object.
+ * @param deadline_ns Monotonic deadline, UINT64_MAX to block.
+ * @return true if notified.
+ */
+static bool wait_until(osal_wakeup_t* wakeup, uint64_t deadline_ns)
+{
+    if(wakeup->backend == OSAL_WAKEUP_BACKEND_FUTEX)
+        return futex_wait(wakeup, deadline_ns);
+
+    return eventfd_wait(wakeup, deadline_ns);
+}
+
+/**
+ * @brief Sets up a wakeup object.
+ *
+ * @param wakeup Zeroed object to set up.
+ * @param backend Requested backend.
+ * @param owned Whether osal_wakeup_destroy frees the object.
+ * @return true on success.
+ */
+static bool setup_wakeup(osal_wakeup_t* wakeup, osal_wakeup_backend_t backend, bool owned)
+{
+    if(backend == OSAL_WAKEUP_BACKEND_DEFAULT)
+        backend = OSAL_WAKEUP_BUILD_BACKEND;
+
+    wakeup->backend = backend;
+    wakeup->event_fd = -1;
+    wakeup->owned = owned;
+    atomic_init(&wakeup->futex_word, OSAL_WAKEUP_IDLE);
+
+    switch(backend)
+    {
+        case OSAL_WAKEUP_BACKEND_FUTEX:
+            return true;
+
+        case OSAL_WAKEUP_BACKEND_EVENTFD:
+            /* Create a non-blocking eventfd
+                - Initial counter value is 0
+                - CLOEXEC avoids fd leaks across exec()
+                - NONBLOCK lets a wait consume with a single read
+            */
+            wakeup->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            return wakeup->event_fd >= 0;
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Time until the next expiry of a timer.
+ *
+ * @param timer Timer to read.
+ * @return Nanoseconds to the next expiry, UINT64_MAX if the timer is stopped.
+ */
+static uint64_t time_to_expiry(const osal_timer_t* timer)
+{
+    struct itimerspec spec;
+
+    if(timerfd_gettime(timer->timer_fd, &spec) != 0 || (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0))
+        return UINT64_MAX;
+
+    return ((uint64_t)spec.it_value.tv_sec * 1000000000ull) + (uint64_t)spec.it_value.tv_nsec;
+}
+
+/**
+ * @brief Opens a timerfd.
+ *
+ * @param timer Timer to set up.
+ * @param owned Whether osal_timer_destroy frees the timer.
+ * @return true on success.
+ */
+static bool setup_timer(osal_timer_t* timer, bool owned)
+{
+    timer->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    timer->owned = owned;
+
+    return timer->timer_fd >= 0;
+}
+
 // Global function definitions
 
 /**
  * @brief Creates a wakeup object.
  *
- * Allocates and initializes a new wakeup mechanism.
+ * Allocates and initializes a new wakeup mechanism with the build default
+ * backend.
  *
  * @return Pointer to wakeup object, or NULL on failure.
  */
 osal_wakeup_t* osal_wakeup_create(void)
+{
+    return osal_wakeup_create_ex(OSAL_WAKEUP_BACKEND_DEFAULT);
+}
+
+/**
+ * @brief Creates a wakeup object with a given backend.
+ *
+ * @param backend Mechanism to use, OSAL_WAKEUP_BACKEND_DEFAULT for the build default.
+ * @return Pointer to wakeup object, or NULL on failure.
+ */
+osal_wakeup_t* osal_wakeup_create_ex(osal_wakeup_backend_t backend)
 {
     // Allocate memory for the wakeup structure
     osal_wakeup_t* wakeup = (osal_wakeup_t*) calloc(1, sizeof(*wakeup));
@@ -36,26 +312,71 @@ osal_wakeup_t* osal_wakeup_create(void)
     if(wakeup == NULL)
         return NULL;
 
-    /* Create a blocking eventfd
-        - Initial counter value is 0
-        - CLOEXEC avoids fd leaks across exec()
-    */
-    wakeup->event_fd = eventfd(0, EFD_CLOEXEC);
-
-    if(wakeup->event_fd < 0)
+    if(!setup_wakeup(wakeup, backend, true))
     {
         free(wakeup);
         return NULL;
     }
 
     return wakeup;
+}
+
+/**
+ * @brief Creates a wakeup object in caller storage.
+ *
+ * Same as osal_wakeup_create, but the object is placed in memory, which
+ * must stay valid until osal_wakeup_destroy.
+ *
+ * @param memory Storage for the object, aligned like an int.
+ * @param memory_bytes Size of memory, at least OSAL_WAKEUP_STORAGE_BYTES.
+ * @return Pointer to wakeup object, or NULL on failure.
+ */
+osal_wakeup_t* osal_wakeup_create_static(void* memory, size_t memory_bytes)
+{
+    return osal_wakeup_create_static_ex(memory, memory_bytes, OSAL_WAKEUP_BACKEND_DEFAULT);
+}
+
+/**
+ * @brief Creates a wakeup object with a given backend in caller storage.
+ *
+ * @param memory Storage for the object, aligned like an int.
+ * @param memory_bytes Size of memory, at least OSAL_WAKEUP_STORAGE_BYTES.
+ * @param backend Mechanism to use, OSAL_WAKEUP_BACKEND_DEFAULT for the build default.
+ * @return Pointer to wakeup object, or NULL on failure.
+ */
+osal_wakeup_t* osal_wakeup_create_static_ex(void* memory, size_t memory_bytes, osal_wakeup_backend_t backend)
+{
+    if(memory == NULL || ((uintptr_t)memory % _Alignof(osal_wakeup_t)) != 0 || memory_bytes < OSAL_WAKEUP_STORAGE_BYTES)
+        return NULL;
+
+    osal_wakeup_t* wakeup = (osal_wakeup_t*)memory;
+
+    if(!setup_wakeup(wakeup, backend, false))
+        return NULL;
+
+    return wakeup;
+}
 
+/**
+ * @brief Returns the backend of a wakeup object.
+ *
+ * @param wakeup Wakeup object.
+ * @return OSAL_WAKEUP_BACKEND_EVENTFD or OSAL_WAKEUP_BACKEND_FUTEX, DEFAULT for NULL.
+ */
+osal_wakeup_backend_t osal_wakeup_backend(const osal_wakeup_t* wakeup)
+{
+    if(wakeup == NULL)
+        return OSAL_WAKEUP_BACKEND_DEFAULT;
+
+    return wakeup->backend;
 }
 
 /**
  * @brief Notifies the wakeup object.
  *
- * Sends a notification to wake up waiting threads.
+ * Sends a notification to wake up waiting threads. With the futex backend
+ * this is one atomic exchange, plus FUTEX_WAKE only if the waiter sleeps.
+ * Both backends are async-signal-safe.
  *
  * @param wakeup Wakeup object to notify.
  */
@@ -65,6 +386,15 @@ void osal_wakeup_notify(osal_wakeup_t* wakeup)
     if(wakeup == NULL)
         return;
 
+    if(wakeup->backend == OSAL_WAKEUP_BACKEND_FUTEX)
+    {
+        // Sequentially consistent, so the waiter either sees PENDING or is seen SLEEPING
+        if(atomic_exchange(&wakeup->futex_word, OSAL_WAKEUP_PENDING) == OSAL_WAKEUP_SLEEPING)
+            (void)syscall(SYS_futex, &wakeup->futex_word, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, NULL, NULL, 0);
+
+        return;
+    }
+
     const uint64_t notification_value = 1;
     ssize_t bytes_written = write(wakeup->event_fd, &notification_value, sizeof(notification_value));
 
@@ -85,44 +415,328 @@ void osal_wakeup_wait(osal_wakeup_t* wakeup)
     if(wakeup == NULL)
         return;
 
-    uint64_t accumulated_notification_count = 0;
+    // Returns on errors as well
+    (void)wait_until(wakeup, UINT64_MAX);
+}
+
+/**
+ * @brief Waits for a wakeup notification or a timeout.
+ *
+ * Blocks until a notification is received or timeout_ns has elapsed on
+ * the monotonic clock, restarting after signals with the time left. Only
+ * one thread may wait on a wakeup object at a time.
+ *
+ * @param wakeup Wakeup object to wait on.
+ * @param timeout_ns Longest wait, 0 to poll, OSAL_WAIT_FOREVER to block.
+ * @return true if notified, false on timeout or error.
+ */
+bool osal_wakeup_wait_timeout(osal_wakeup_t* wakeup, uint64_t timeout_ns)
+{
+    // Validate wakeup pointer
+    if(wakeup == NULL)
+        return false;
+
+    if(timeout_ns == OSAL_WAIT_FOREVER)
+        return wait_until(wakeup, UINT64_MAX);
+
+    const uint64_t start_ns = monotonic_ns();
+
+    return wait_until(wakeup, (timeout_ns >= UINT64_MAX - start_ns) ? UINT64_MAX - 1u : start_ns + timeout_ns);
+}
+
+/**
+ * @brief Destroys a wakeup object.
+ *
+ * Cleans up resources and frees memory. An object in caller storage is
+ * only closed.
+ *
+ * @param wakeup Wakeup object to destroy.
+ */
+void osal_wakeup_destroy(osal_wakeup_t* wakeup)
+{
+    // Validate wakeup pointer
+    if(wakeup == NULL)
+        return;
+
+    if(wakeup->event_fd >= 0)
+        close(wakeup->event_fd);
+
+    if(wakeup->owned)
+        free(wakeup);
+}
+
+/**
+ * @brief Creates a periodic timer.
+ *
+ * The timer runs on the monotonic clock and is stopped until
+ * osal_timer_start.
+ *
+ * @return Pointer to timer object, or NULL on failure.
+ */
+osal_timer_t* osal_timer_create(void)
+{
+    osal_timer_t* timer = (osal_timer_t*) calloc(1, sizeof(*timer));
+
+    if(timer == NULL)
+        return NULL;
+
+    if(!setup_timer(timer, true))
+    {
+        free(timer);
+        return NULL;
+    }
+
+    return timer;
+}
+
+/**
+ * @brief Creates a periodic timer in caller storage.
+ *
+ * @param memory Storage for the object, aligned like an int.
+ * @param memory_bytes Size of memory, at least OSAL_TIMER_STORAGE_BYTES.
+ * @return Pointer to timer object, or NULL on failure.
+ */
+osal_timer_t* osal_timer_create_static(void* memory, size_t memory_bytes)
+{
+    if(memory == NULL || ((uintptr_t)memory % _Alignof(osal_timer_t)) != 0 || memory_bytes < OSAL_TIMER_STORAGE_BYTES)
+        return NULL;
+
+    osal_timer_t* timer = (osal_timer_t*)memory;
+
+    if(!setup_timer(timer, false))
+        return NULL;
+
+    return timer;
+}
+
+/**
+ * @brief Starts or restarts a timer.
+ *
+ * Pending expirations of an earlier start are dropped.
+ *
+ * @param timer Timer to start.
+ * @param first_ns Time to the first expiry, 0 expires at once.
+ * @param period_ns Time between later expiries, 0 for a one-shot timer.
+ * @return true on success.
+ */
+bool osal_timer_start(osal_timer_t* timer, uint64_t first_ns, uint64_t period_ns)
+{
+    if(timer == NULL)
+        return false;
+
+    struct itimerspec spec;
+
+    // A zero it_value would disarm the timer, the shortest delay expires at once instead
+    spec.it_value = to_timespec((first_ns == 0) ? 1u : first_ns);
+    spec.it_interval = to_timespec(period_ns);
+
+    (void)osal_timer_expirations(timer);
+
+    return timerfd_settime(timer->timer_fd, 0, &spec, NULL) == 0;
+}
+
+/**
+ * @brief Stops a timer.
+ *
+ * @param timer Timer to stop.
+ */
+void osal_timer_stop(osal_timer_t* timer)
+{
+    if(timer == NULL)
+        return;
+
+    const struct itimerspec disarm = { { 0, 0 }, { 0, 0 } };
+
+    (void)timerfd_settime(timer->timer_fd, 0, &disarm, NULL);
+    (void)osal_timer_expirations(timer);
+}
+
+/**
+ * @brief Waits for the next expiry of a timer.
+ *
+ * Returns at once if the timer already expired since the last wait. A
+ * stopped timer blocks until another thread starts it.
+ *
+ * @param timer Timer to wait on.
+ * @return Expirations since the last wait, 0 on error.
+ */
+uint64_t osal_timer_wait(osal_timer_t* timer)
+{
+    if(timer == NULL)
+        return 0;
+
+    struct pollfd poll_fd = { timer->timer_fd, POLLIN, 0 };
 
     while(1)
     {
-        ssize_t bytes_read = read(wakeup->event_fd, &accumulated_notification_count, sizeof(accumulated_notification_count));
+        const uint64_t expirations = osal_timer_expirations(timer);
 
-        if(bytes_read == (ssize_t)sizeof(accumulated_notification_count))
-        {
-            // Successfully consumed the notifications
-            return;
-        }
+        if(expirations != 0)
+            return expirations;
 
-        if(bytes_read < 0 && errno == EINTR)
+        if(poll(&poll_fd, 1, -1) < 0 && errno != EINTR)
+            return 0;
+    }
+}
+
+/**
+ * @brief Collects the expirations of a timer without blocking.
+ *
+ * @param timer Timer to read.
+ * @return Expirations since the last wait, 0 if none.
+ */
+uint64_t osal_timer_expirations(osal_timer_t* timer)
+{
+    if(timer == NULL)
+        return 0;
+
+    uint64_t expirations = 0;
+
+    while(read(timer->timer_fd, &expirations, sizeof(expirations)) < 0)
+    {
+        // Nothing expired yet (EAGAIN) or an error
+        if(errno != EINTR)
+            return 0;
+    }
+
+    return expirations;
+}
+
+/**
+ * @brief Destroys a timer.
+ *
+ * A timer in caller storage is only closed.
+ *
+ * @param timer Timer to destroy.
+ */
+void osal_timer_destroy(osal_timer_t* timer)
+{
+    if(timer == NULL)
+        return;
+
+    close(timer->timer_fd);
+
+    if(timer->owned)
+        free(timer);
+}
+
+/**
+ * @brief Waits on a wakeup object and a timer at once.
+ *
+ * One ppoll on both descriptors, so a thread can react to new work and a
+ * periodic deadline without a second thread or a polling loop. A futex
+ * wakeup has no descriptor; it sleeps on the futex word until the next
+ * expiry instead. Everything that is ready when the wait ends is consumed.
+ *
+ * @param wakeup Wakeup object to wait on.
+ * @param timer Timer to wait on.
+ * @param out_expirations Receives the timer expirations, may be NULL.
+ * @return OSAL_WAKEUP_NOTIFIED and/or OSAL_WAKEUP_EXPIRED, 0 on error.
+ */
+uint32_t osal_wakeup_wait_timer(osal_wakeup_t* wakeup, osal_timer_t* timer, uint64_t* out_expirations)
+{
+    if(out_expirations != NULL)
+        *out_expirations = 0;
+
+    if(wakeup == NULL || timer == NULL)
+        return 0;
+
+    while(wakeup->backend == OSAL_WAKEUP_BACKEND_FUTEX)
+    {
+        uint64_t expirations = osal_timer_expirations(timer);
+        uint64_t deadline_ns = UINT64_MAX;
+
+        // Only check for a notification when the timer already expired
+        if(expirations != 0)
+            deadline_ns = 0;
+        else
         {
-            // Interrupted by signal, retry
-            continue;
+            const uint64_t until_expiry_ns = time_to_expiry(timer);
+
+            if(until_expiry_ns != UINT64_MAX)
+                deadline_ns = monotonic_ns() + until_expiry_ns;
         }
 
-        // Return on any other errors
-        return;
+        uint32_t result = wait_until(wakeup, deadline_ns) ? OSAL_WAKEUP_NOTIFIED : 0;
+
+        if(expirations == 0)
+            expirations = osal_timer_expirations(timer);
+
+        if(expirations != 0)
+            result |= OSAL_WAKEUP_EXPIRED;
+
+        if(out_expirations != NULL)
+            *out_expirations = expirations;
+
+        // Woken before the expiry was counted, wait for the rest
+        if(result != 0)
+            return result;
     }
 
+    struct pollfd poll_fds[2] = {
+        { wakeup->event_fd, POLLIN, 0 },
+        { timer->timer_fd, POLLIN, 0 },
+    };
+
+    while(1)
+    {
+        int ready = ppoll(poll_fds, 2, NULL, NULL);
+
+        if(ready < 0 && errno == EINTR)
+            continue;
+
+        if(ready <= 0)
+            return 0;
+
+        uint32_t result = 0;
+
+        if((poll_fds[0].revents & POLLIN) != 0 && consume_notifications(wakeup) > 0)
+            result |= OSAL_WAKEUP_NOTIFIED;
+
+        const uint64_t expirations = ((poll_fds[1].revents & POLLIN) != 0) ? osal_timer_expirations(timer) : 0;
+
+        if(expirations != 0)
+            result |= OSAL_WAKEUP_EXPIRED;
+
+        if(out_expirations != NULL)
+            *out_expirations = expirations;
+
+        // A timer restarted between ppoll and read has nothing to report, wait again
+        if(result != 0)
+            return result;
+    }
 }
 
 /**
- * @brief Destroys a wakeup object.
+ * @brief Returns the descriptor that polls readable when a wakeup is notified.
  *
- * Cleans up resources and frees memory.
+ * For an osal_poller_t; once it reports the descriptor readable,
+ * osal_wakeup_wait_timeout(wakeup, 0) consumes the notifications.
  *
- * @param wakeup Wakeup object to destroy.
+ * @param wakeup Wakeup object.
+ * @return The eventfd, -1 for a futex wakeup or NULL.
  */
-void osal_wakeup_destroy(osal_wakeup_t* wakeup)
+int osal_wakeup_fd(const osal_wakeup_t* wakeup)
 {
-    // Validate wakeup pointer
     if(wakeup == NULL)
-        return;
+        return -1;
 
-    close(wakeup->event_fd);
-    free(wakeup);
+    return wakeup->event_fd;
 }
 
+/**
+ * @brief Returns the descriptor that polls readable when a timer expired.
+ *
+ * Once an osal_poller_t reports it readable, osal_timer_expirations
+ * collects the expirations.
+ *
+ * @param timer Timer.
+ * @return The timerfd, -1 for NULL.
+ */
+int osal_timer_fd(const osal_timer_t* timer)
+{
+    if(timer == NULL)
+        return -1;
+
+    return timer->timer_fd;
+}
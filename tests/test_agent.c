@@ -0,0 +1,1384 @@
+/**
+ * @file test_agent.c
+ * @brief Unit tests for the telemetry agent.
+ *
+ * This file contains test cases for the agent drain loop and the
+ * heartbeat messages, using a small C transport that records calls.
+ * @author Aravinthraj Ganesan
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "telemetry_agent.h"
+#include "telemetry_emit.h"
+#include "telemetry_protocol.h"
+#include "osal_time.h"
+
+/* Test cases :
+    1. Events are sent and a final heartbeat carries the counters
+    2. Transport failures are counted
+    3. Metrics are published as metrics batches, with the suppressed counters of sampled ids
+    4. Sketched events are summarized in a sketch batch instead of being sent,
+       a rejected sketch batch counts as a transport error
+    5. Raw tick timestamps are converted before the event is sent
+    6. The agent runs the coarse clock service while it is started
+    7. Attached rings are drained and flushed together with the start ring
+    8. Signal handler events are sent, a crash flush sends what is queued
+    9. Pooled payloads reach the transport and their blocks go back to the pool, as fragment
+       messages when the transport has a message limit, and ring_buffer_free returns queued blocks
+    10. An agent, its ring and pool run from static storage and restart in it
+    11. The agent thread takes its placement and pre-start hook from the config
+    12. Heartbeats go out on their interval while no event arrives
+    13. Events and signal handler events reach the transport with the futex wakeup
+    14. Events wait while the transport would block and go out once it has room
+    15. A watched descriptor is served by the agent thread, a refused one frees its slot
+    16. The transport batch is flushed when it is full, when its linger ends and on telemetry_agent_flush,
+        an endless linger never flushes on its own
+*/
+
+// Event id sampled by the metrics test, its suppressed counter is published by the agent
+#define TEST_SAMPLED_EVENT_ID 310u
+
+// Recording transport used by the tests
+typedef struct test_transport_s {
+    atomic_uint events;
+    atomic_uint messages;
+    atomic_uint metrics_batches;
+    atomic_uint sketch_batches;
+    atomic_uint signal_safe_events;
+    atomic_uint pooled_events;
+    atomic_uint fragmented_events;  // Pooled payloads reassembled intact from fragment messages
+    size_t message_limit;           // Reported by test_max_message_bytes
+    bool fail_events;
+    bool fail_messages;
+    uint8_t last_event_flags;
+    uint64_t last_event_timestamp;
+    telemetry_heartbeat_t last_heartbeat;
+    uint64_t last_counter;
+    uint64_t last_suppressed;       // Suppressed counter of TEST_SAMPLED_EVENT_ID
+    uint64_t last_sketch_count;
+    double last_sketch_p50;
+    uint8_t assembled[2048];        // Payload of the transfer being reassembled
+    uint32_t assembled_bytes;
+    uint32_t assembled_transfer;
+} test_transport_t;
+
+// Transport writing one byte per event into a non-blocking pipe
+typedef struct pipe_transport_s {
+    int fds[2];
+    atomic_uint events;
+    atomic_bool would_block;
+    bool in_order;              // Event ids arrived as 0, 1, 2 ...
+} pipe_transport_t;
+
+// Transport holding events until the agent flushes it
+typedef struct batch_transport_s {
+    atomic_uint queued;             // Events since the last flush
+    atomic_uint flushed;            // Events handed over by flushes
+    atomic_uint flushes;            // Flushes that handed over events
+    atomic_uint largest_batch;
+    atomic_uint_fast64_t last_flush_ns;
+} batch_transport_t;
+
+// Descriptor watched by case 15
+typedef struct watch_probe_s {
+    int fds[2];
+    ring_buffer_t* ring;
+    telemetry_agent_t* agent;
+    atomic_uint calls;
+} watch_probe_t;
+
+// Local function prototype declaration
+static void testcase_heartbeat_counters(void);
+static void testcase_transport_errors(void);
+static void testcase_metrics_publish(void);
+static void testcase_sketch_publish(void);
+static void testcase_raw_ticks_converted(void);
+static void testcase_coarse_clock_service(void);
+static void testcase_attached_rings(void);
+static void testcase_signal_safe_emit(void);
+static void testcase_pooled_payload(void);
+static void testcase_static_storage(void);
+static void testcase_thread_placement(void);
+static void testcase_idle_heartbeats(void);
+static void testcase_futex_wakeup(void);
+static void testcase_blocked_transport(osal_wakeup_backend_t backend);
+static void testcase_watch(void);
+static void testcase_flush_policy(osal_wakeup_backend_t backend);
+
+void test_agent(void);
+
+/**
+ * @brief Main entry point for running telemetry agent tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_agent()
+{
+    testcase_heartbeat_counters();
+    testcase_transport_errors();
+    testcase_metrics_publish();
+    testcase_sketch_publish();
+    testcase_raw_ticks_converted();
+    testcase_coarse_clock_service();
+    testcase_attached_rings();
+    testcase_signal_safe_emit();
+    testcase_pooled_payload();
+    testcase_static_storage();
+    testcase_thread_placement();
+    testcase_idle_heartbeats();
+    testcase_futex_wakeup();
+    testcase_blocked_transport(OSAL_WAKEUP_BACKEND_EVENTFD);
+    testcase_blocked_transport(OSAL_WAKEUP_BACKEND_FUTEX);
+    testcase_watch();
+    testcase_flush_policy(OSAL_WAKEUP_BACKEND_EVENTFD);
+    testcase_flush_policy(OSAL_WAKEUP_BACKEND_FUTEX);
+}
+
+static bool test_send_event(void* context, const telemetry_event_t* ev)
+{
+    test_transport_t* t = (test_transport_t*)context;
+
+    t->last_event_flags = ev->reserved;
+    t->last_event_timestamp = ev->timestamp;
+
+    // Pooled test payloads count up from the event id
+    if(telemetry_event_is_pooled(ev))
+    {
+        const uint8_t* payload = telemetry_event_payload(ev);
+        bool intact = (payload != NULL);
+
+        for(size_t index = 0; intact && index < ev->payload_size; index++)
+        {
+            intact = (payload[index] == (uint8_t)(ev->event_id + index));
+        }
+
+        if(intact)
+            atomic_fetch_add(&t->pooled_events, 1);
+    }
+
+    atomic_fetch_add(&t->events, 1);
+    return !t->fail_events;
+}
+
+static bool test_send_event_signal_safe(void* context, const telemetry_event_t* ev)
+{
+    test_transport_t* t = (test_transport_t*)context;
+
+    // Ticks are converted before the event reaches the transport
+    assert((ev->reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0);
+    atomic_fetch_add(&t->signal_safe_events, 1);
+    return true;
+}
+
+static bool test_send_message(void* context, const uint8_t* data, size_t length)
+{
+    test_transport_t* t = (test_transport_t*)context;
+    telemetry_header_t header;
+
+    if(t->fail_messages)
+        return false;
+
+    assert(telemetry_decode_header_v1(&header, data, length) == TELEM_RC_OK);
+
+    if(header.message_type == TELEMETRY_HEART_BEAT_BATCH)
+    {
+        assert(telemetry_decode_heartbeat_v1(&t->last_heartbeat, data + telemetry_header_v1_length(),
+                                             length - telemetry_header_v1_length()) == TELEM_RC_OK);
+    }
+
+    if(header.message_type == TELEMETRY_METRICS_BATCH)
+    {
+        const uint8_t* payload = data + telemetry_header_v1_length();
+        const size_t payload_len = length - telemetry_header_v1_length();
+        uint16_t record_count = 0;
+        telemetry_metric_record_t record;
+
+        size_t position = telemetry_metrics_decode_count(&record_count, payload, payload_len);
+        unsigned own_records = 0;
+
+        // One metric of the test, plus the suppressed counters of ids that have had a sampling policy
+        for(uint16_t index = 0; index < record_count; index++)
+        {
+            const size_t used = telemetry_metrics_decode_record(&record, payload + position, payload_len - position);
+            assert(used != 0);
+            position += used;
+
+            if(record.metric_id < TELEMETRY_SAMPLING_SUPPRESSED_METRIC_BASE)
+            {
+                t->last_counter = record.counter;
+                own_records++;
+            }
+            else if(record.metric_id == TELEMETRY_SAMPLING_SUPPRESSED_METRIC_BASE + TEST_SAMPLED_EVENT_ID)
+            {
+                t->last_suppressed = record.counter;
+            }
+        }
+
+        assert(own_records == 1);
+        atomic_fetch_add(&t->metrics_batches, 1);
+    }
+
+    if(header.message_type == TELEMETRY_SKETCH_BATCH)
+    {
+        const uint8_t* payload = data + telemetry_header_v1_length();
+        const size_t payload_len = length - telemetry_header_v1_length();
+        uint16_t record_count = 0;
+        uint32_t event_id = 0;
+        telemetry_sketch_t* sketch;
+
+        assert(telemetry_sketch_init(&sketch, 0.0, 0) == true);
+
+        size_t position = telemetry_sketches_decode_count(&record_count, payload, payload_len);
+        assert(record_count == 1);
+        assert(telemetry_sketches_decode_record(&event_id, sketch, payload + position, payload_len - position) != 0);
+        assert(event_id == 42);
+
+        t->last_sketch_count = telemetry_sketch_count(sketch);
+        t->last_sketch_p50 = telemetry_sketch_percentile(sketch, 50.0);
+        atomic_fetch_add(&t->sketch_batches, 1);
+
+        telemetry_sketch_free(sketch);
+    }
+
+    if(header.message_type == TELEMETRY_EVENT_FRAGMENT)
+    {
+        telemetry_event_fragment_t fragment;
+
+        assert(length <= t->message_limit);
+        assert(telemetry_decode_event_fragment_v1(&fragment, data + telemetry_header_v1_length(),
+                                                  length - telemetry_header_v1_length()) == TELEM_RC_OK);
+        assert(fragment.payload_len <= sizeof(t->assembled));
+
+        // Fragments of one transfer arrive in order, the first names it
+        if(fragment.fragment_offset == 0)
+        {
+            assert(fragment.transfer_id == header.sequence_counter);
+            t->assembled_transfer = fragment.transfer_id;
+            t->assembled_bytes = 0;
+        }
+
+        assert(fragment.transfer_id == t->assembled_transfer);
+        assert(fragment.fragment_offset == t->assembled_bytes);
+
+        memcpy(&t->assembled[fragment.fragment_offset], fragment.data, fragment.data_length);
+        t->assembled_bytes += fragment.data_length;
+
+        if(t->assembled_bytes == fragment.payload_len)
+        {
+            bool intact = true;
+
+            for(size_t index = 0; intact && index < fragment.payload_len; index++)
+            {
+                intact = (t->assembled[index] == (uint8_t)(fragment.event_id + index));
+            }
+
+            if(intact)
+                atomic_fetch_add(&t->fragmented_events, 1);
+        }
+    }
+
+    atomic_fetch_add(&t->messages, 1);
+    return true;
+}
+
+static size_t test_max_message_bytes(void* context)
+{
+    return ((test_transport_t*)context)->message_limit;
+}
+
+/**
+ * @brief Tests that the final heartbeat reports what the agent did.
+ *
+ * Pushes events, stops the agent and checks the last heartbeat counters.
+ */
+static void testcase_heartbeat_counters()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    test_transport_t t;
+    telemetry_event_t event;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    ring_buffer_init(&rb, 8);
+    assert(telemetry_agent_start(&agent, rb, &transport) == true);
+
+    for(uint32_t index = 0; index < 5; index++)
+    {
+        telemetry_event_make(&event, index, NULL, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(rb, &event) == true);
+        telemetry_agent_notify(agent);
+    }
+
+    telemetry_agent_stop(agent);
+
+    // All events sent, at least the final heartbeat went out
+    assert(atomic_load(&t.events) == 5);
+    assert(atomic_load(&t.messages) >= 1);
+    assert(t.last_heartbeat.sent_count == 5);
+    assert(t.last_heartbeat.wakeup_count == 5);
+    assert(t.last_heartbeat.transport_error_count == 0);
+    assert(t.last_heartbeat.ring_count == 0);
+    assert(t.last_heartbeat.ring_capacity == 8);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent heartbeat counters is passed. \n");
+}
+
+/**
+ * @brief Tests that failed sends show up as transport errors.
+ */
+static void testcase_transport_errors()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    test_transport_t t;
+    telemetry_event_t event;
+    telemetry_agent_config_t config;
+
+    memset(&t, 0, sizeof(t));
+    t.fail_events = true;
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    telemetry_agent_config_init(&config);
+    config.heartbeat_interval_ns = 0;   // Heartbeats off
+
+    ring_buffer_init(&rb, 8);
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    telemetry_event_make(&event, 1, NULL, 0, TELEMETRY_LEVEL_ERROR);
+    assert(ring_buffer_push(rb, &event) == true);
+    assert(ring_buffer_push(rb, &event) == true);
+    telemetry_agent_notify(agent);
+
+    telemetry_agent_stop(agent);
+
+    assert(atomic_load(&t.events) == 2);
+    assert(atomic_load(&t.messages) == 0);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent transport errors is passed. \n");
+}
+
+/**
+ * @brief Tests that the agent publishes a metrics snapshot on stop.
+ */
+static void testcase_metrics_publish()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_metrics_t* metrics;
+    test_transport_t t;
+    telemetry_agent_config_t config;
+    telemetry_sampling_policy_t policy;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    // Room for the suppressed counters the agent registers
+    assert(telemetry_metrics_init(&metrics, 1u + TELEMETRY_EVENT_SAMPLING_POLICIES) == true);
+    telemetry_metric_t* counter = telemetry_metrics_register(metrics, 7, TELEMETRY_METRIC_COUNTER);
+
+    telemetry_sampling_policy_init(&policy);
+    policy.one_in_n = 2;
+    assert(telemetry_event_sampling_set(TEST_SAMPLED_EVENT_ID, &policy) == true);
+
+    telemetry_agent_config_init(&config);
+    config.heartbeat_interval_ns = 0;
+    config.metrics = metrics;
+    config.metrics_interval_ns = 0;     // Only the final snapshot
+
+    ring_buffer_init(&rb, 8);
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    for(int index = 0; index < 100000; index++)
+    {
+        telemetry_metric_add(counter, 1);
+    }
+
+    for(int index = 0; index < 4; index++)
+    {
+        (void)telemetry_event_sampling_keep(TEST_SAMPLED_EVENT_ID);
+    }
+
+    telemetry_agent_stop(agent);
+
+    // One batch instead of 100000 events, with the suppressed count of the sampled id
+    assert(atomic_load(&t.metrics_batches) == 1);
+    assert(t.last_counter == 100000);
+    assert(t.last_suppressed == 2);
+    assert(atomic_load(&t.events) == 0);
+    assert(telemetry_event_sampling_set(TEST_SAMPLED_EVENT_ID, NULL) == true);
+
+    ring_buffer_free(rb);
+    telemetry_metrics_free(metrics);
+
+    printf("Telemetry :: Test case agent metrics publish is passed. \n");
+}
+
+/**
+ * @brief Tests that sketched events are shipped as one sketch batch.
+ */
+static void testcase_sketch_publish()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_sketches_t* sketches;
+    test_transport_t t;
+    telemetry_event_t event;
+    telemetry_agent_config_t config;
+
+    memset(&t, 0, sizeof(t));
+    t.message_limit = 1400;
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message,
+                                .max_message_bytes = test_max_message_bytes };
+    transport_c_t no_messages = { .context = &t, .send_event = test_send_event };
+    transport_c_t no_limit = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    assert(telemetry_sketches_init(&sketches, 4, 0.0, 0) == true);
+    assert(telemetry_sketches_register(sketches, 42, TELEMETRY_SKETCH_VALUE_U32, 0) == true);
+
+    telemetry_agent_config_init(&config);
+    config.heartbeat_interval_ns = 0;
+    config.sketches = sketches;
+    config.metrics_interval_ns = 0;     // Only the final batch
+
+    ring_buffer_init(&rb, 64);
+
+    // Sketches can't be shipped without send_message and a message limit
+    assert(telemetry_agent_start_ex(&agent, rb, &no_messages, &config) == false);
+    assert(telemetry_agent_start_ex(&agent, rb, &no_limit, &config) == false);
+    t.message_limit = 0;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == false);
+    t.message_limit = 1400;
+
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    // Stay below the per-wakeup drain limit
+    for(uint32_t value = 1; value <= 40; value++)
+    {
+        telemetry_event_make(&event, 42, &value, sizeof(value), TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(rb, &event) == true);
+    }
+
+    // Not sketched, sent as usual
+    telemetry_event_make(&event, 43, NULL, 0, TELEMETRY_LEVEL_INFO);
+    assert(ring_buffer_push(rb, &event) == true);
+    telemetry_agent_notify(agent);
+
+    telemetry_agent_stop(agent);
+
+    assert(atomic_load(&t.events) == 1);
+    assert(atomic_load(&t.sketch_batches) == 1);
+    assert(t.last_sketch_count == 40);
+    assert(t.last_sketch_p50 >= 20.0 * 0.99 && t.last_sketch_p50 <= 21.0 * 1.01);
+
+    // A rejected batch counts as a transport error
+    t.fail_messages = true;
+    config.metrics_interval_ns = 1000000ull;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    const uint32_t value = 7;
+    telemetry_event_make(&event, 42, &value, sizeof(value), TELEMETRY_LEVEL_INFO);
+    assert(ring_buffer_push(rb, &event) == true);
+    telemetry_agent_notify(agent);
+
+    for(int retry = 0; retry < 1000 && telemetry_agent_send_error_count(agent) == 0; retry++)
+    {
+        osal_thread_sleep_ns(1000000ull);
+    }
+
+    assert(telemetry_agent_send_error_count(agent) == 1);
+    assert(telemetry_agent_sketch_batch_count(agent) == 0);
+
+    telemetry_agent_stop(agent);
+    assert(atomic_load(&t.sketch_batches) == 1);
+
+    ring_buffer_free(rb);
+    telemetry_sketches_free(sketches);
+
+    printf("Telemetry :: Test case agent sketch publish is passed. \n");
+}
+
+/**
+ * @brief Tests that the agent converts raw tick timestamps.
+ */
+static void testcase_raw_ticks_converted()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    test_transport_t t;
+    telemetry_event_t event;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    ring_buffer_init(&rb, 8);
+    assert(telemetry_agent_start(&agent, rb, &transport) == true);
+
+    telemetry_event_set_level_clock(TELEMETRY_LEVEL_DEBUG, TELEMETRY_CLOCK_TICKS);
+    const uint64_t before_ns = osal_telemetry_now_monotonic_ns();
+    telemetry_event_make(&event, 5, NULL, 0, TELEMETRY_LEVEL_DEBUG);
+    telemetry_event_set_level_clock(TELEMETRY_LEVEL_DEBUG, TELEMETRY_CLOCK_PRECISE);
+
+    assert((event.reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) != 0);
+    assert(ring_buffer_push(rb, &event) == true);
+    telemetry_agent_notify(agent);
+
+    telemetry_agent_stop(agent);
+
+    // The transport saw nanoseconds, not ticks
+    assert(atomic_load(&t.events) == 1);
+    assert((t.last_event_flags & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0);
+    assert(t.last_event_timestamp + 1000 >= before_ns);
+    assert(t.last_event_timestamp <= osal_telemetry_now_monotonic_ns());
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent raw ticks converted is passed. \n");
+}
+
+/**
+ * @brief Tests that the agent owns the coarse clock service.
+ */
+static void testcase_coarse_clock_service()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_agent_config_t config;
+    test_transport_t t;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    ring_buffer_init(&rb, 8);
+    telemetry_agent_config_init(&config);
+    assert(config.coarse_clock_period_ns == 0);
+
+    // Out of range period fails the start
+    config.coarse_clock_period_ns = 1;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == false);
+
+    config.coarse_clock_period_ns = 2000000ull;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+    assert(osal_time_coarse_resolution_ns() == 2000000ull);
+
+    telemetry_agent_stop(agent);
+    assert(osal_time_coarse_resolution_ns() != 2000000ull);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent coarse clock service is passed. \n");
+}
+
+/**
+ * @brief Tests an agent draining several ring buffers.
+ */
+static void testcase_attached_rings()
+{
+    ring_buffer_t* first;
+    ring_buffer_t* second;
+    telemetry_agent_t* agent = NULL;
+    test_transport_t t;
+    telemetry_event_t event;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    ring_buffer_init(&first, 32);
+    ring_buffer_init(&second, 32);
+    assert(telemetry_agent_start(&agent, first, &transport) == true);
+    assert(telemetry_agent_attach_ring(agent, second) == true);
+    assert(telemetry_agent_attach_ring(agent, NULL) == false);
+
+    // Pushed without a notify, the flush wakes the agent
+    for(int index = 0; index < 20; index++)
+    {
+        telemetry_event_make(&event, 1, NULL, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(first, &event) == true);
+        telemetry_event_make(&event, 2, NULL, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(second, &event) == true);
+    }
+
+    assert(telemetry_agent_flush(agent, 1000000000ull) == true);
+    assert(ring_buffer_count(first) == 0 && ring_buffer_count(second) == 0);
+
+    // The slot table is bounded, the same ring fills the remaining slots
+    size_t attached = 2;
+    while(telemetry_agent_attach_ring(agent, second))
+    {
+        attached++;
+    }
+    assert(attached == TELEMETRY_AGENT_MAX_RINGS);
+
+    telemetry_agent_stop(agent);
+
+    assert(atomic_load(&t.events) == 40);
+    assert(t.last_heartbeat.ring_capacity == 32u * TELEMETRY_AGENT_MAX_RINGS);
+
+    ring_buffer_free(first);
+    ring_buffer_free(second);
+
+    printf("Telemetry :: Test case agent attached rings is passed. \n");
+}
+
+static telemetry_agent_t* handler_agent;
+
+static void emit_from_handler(int signal_number)
+{
+    (void)telemetry_agent_emit_signal_safe(handler_agent, (uint32_t)signal_number, &signal_number,
+                                           sizeof(signal_number), TELEMETRY_LEVEL_ERROR);
+}
+
+/**
+ * @brief Tests the signal handler path and the crash flush.
+ */
+static void testcase_signal_safe_emit()
+{
+    ring_buffer_t* rb;
+    test_transport_t t;
+    telemetry_event_t event;
+    telemetry_agent_config_t config;
+    struct sigaction action;
+    struct sigaction previous;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message,
+                                 .send_event_signal_safe = test_send_event_signal_safe };
+
+    telemetry_agent_config_init(&config);
+    config.signal_ring_capacity = 4;
+
+    ring_buffer_init(&rb, 16);
+    assert(telemetry_agent_start_ex(&handler_agent, rb, &transport, &config) == true);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = emit_from_handler;
+    sigemptyset(&action.sa_mask);
+    assert(sigaction(SIGUSR2, &action, &previous) == 0);
+
+    // The agent sends handler events like any other
+    assert(raise(SIGUSR2) == 0);
+    assert(telemetry_agent_flush(handler_agent, 1000000000ull) == true);
+    assert(atomic_load(&t.events) == 1);
+
+    // Queued events leave through the signal safe path, or through the agent if it was faster
+    for(int index = 0; index < 4; index++)
+    {
+        telemetry_event_make(&event, 7, NULL, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(rb, &event) == true);
+    }
+    assert(raise(SIGUSR2) == 0);
+
+    const size_t flushed = telemetry_agent_crash_flush(handler_agent);
+    assert(flushed == atomic_load(&t.signal_safe_events));
+
+    assert(telemetry_agent_flush(handler_agent, 1000000000ull) == true);
+    assert(atomic_load(&t.events) + atomic_load(&t.signal_safe_events) == 6);
+
+    telemetry_agent_stop(handler_agent);
+    assert(sigaction(SIGUSR2, &previous, NULL) == 0);
+
+    assert(telemetry_agent_emit_signal_safe(NULL, 1, NULL, 0, TELEMETRY_LEVEL_ERROR) == false);
+    assert(telemetry_agent_crash_flush(NULL) == 0);
+
+    // Without a reserved ring the path is off
+    config.signal_ring_capacity = 0;
+    assert(telemetry_agent_start_ex(&handler_agent, rb, &transport, &config) == true);
+    assert(telemetry_agent_emit_signal_safe(handler_agent, 1, NULL, 0, TELEMETRY_LEVEL_ERROR) == false);
+    telemetry_agent_stop(handler_agent);
+    handler_agent = NULL;
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent signal safe emit is passed. \n");
+}
+
+/**
+ * @brief Tests that pooled payloads are sent and their blocks returned.
+ */
+static void testcase_pooled_payload()
+{
+    ring_buffer_t* rb;
+    ring_buffer_t* full;
+    telemetry_agent_t* agent = NULL;
+    memory_pool_t* pool;
+    memory_pool_stats_t stats;
+    test_transport_t t;
+    telemetry_event_t event;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    assert(memory_pool_init(&pool, 2048, 64) == true);
+    ring_buffer_init(&rb, 16);
+    assert(telemetry_agent_start(&agent, rb, &transport) == true);
+
+    for(uint32_t id = 1; id <= 4; id++)
+    {
+        uint8_t* block = (uint8_t*)memory_pool_alloc(pool);
+        assert(block != NULL);
+
+        for(size_t index = 0; index < 1500; index++)
+        {
+            block[index] = (uint8_t)(id + index);
+        }
+
+        assert(telemetry_emit_pooled(rb, agent, id, pool, block, 1500, TELEMETRY_LEVEL_INFO) == true);
+    }
+
+    // Inline events still go the usual way
+    assert(telemetry_emit(rb, agent, 9, "x", 1, TELEMETRY_LEVEL_INFO) == true);
+
+    telemetry_agent_stop(agent);
+
+    assert(atomic_load(&t.events) == 5);
+    assert(atomic_load(&t.pooled_events) == 4);
+
+    // The agent gave every block back
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0);
+
+    // A full ring returns the block right away
+    ring_buffer_init(&full, 2);
+    telemetry_event_make(&event, 1, NULL, 0, TELEMETRY_LEVEL_INFO);
+    while(ring_buffer_push(full, &event))
+    {
+    }
+
+    assert(telemetry_emit_pooled(full, NULL, 1, pool, memory_pool_alloc(pool), 16, TELEMETRY_LEVEL_INFO) == false);
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0);
+
+    ring_buffer_free(full);
+    ring_buffer_free(rb);
+
+    // With a message limit the payloads go out as fragments no larger than it
+    memset(&t, 0, sizeof(t));
+    t.message_limit = 200;
+    transport.max_message_bytes = test_max_message_bytes;
+
+    ring_buffer_init(&rb, 16);
+    assert(telemetry_agent_start(&agent, rb, &transport) == true);
+
+    for(uint32_t id = 1; id <= 4; id++)
+    {
+        uint8_t* block = (uint8_t*)memory_pool_alloc(pool);
+        assert(block != NULL);
+
+        for(size_t index = 0; index < 1500; index++)
+        {
+            block[index] = (uint8_t)(id + index);
+        }
+
+        assert(telemetry_emit_pooled(rb, agent, id, pool, block, 1500, TELEMETRY_LEVEL_INFO) == true);
+    }
+
+    assert(telemetry_emit(rb, agent, 9, "x", 1, TELEMETRY_LEVEL_INFO) == true);
+
+    telemetry_agent_stop(agent);
+
+    assert(atomic_load(&t.fragmented_events) == 4);
+    assert(atomic_load(&t.events) == 1);
+    assert(t.last_heartbeat.sent_count == 5);
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0);
+
+    // Events nobody sent go back to the pool with their ring
+    for(uint32_t id = 1; id <= 3; id++)
+    {
+        assert(telemetry_emit_pooled(rb, NULL, id, pool, memory_pool_alloc(pool), 64, TELEMETRY_LEVEL_INFO) == true);
+    }
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 3);
+
+    ring_buffer_free(rb);
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0);
+
+    memory_pool_free(pool);
+
+    printf("Telemetry :: Test case agent pooled payload is passed. \n");
+}
+
+/**
+ * @brief Tests an agent whose ring, pool and own state are in static storage.
+ */
+static void testcase_static_storage()
+{
+    static TELEMETRY_STORAGE(ring_memory, RING_BUFFER_STORAGE_BYTES(16));
+    static TELEMETRY_STORAGE(pool_memory, MEMORY_POOL_STORAGE_BYTES(256, 8));
+    static TELEMETRY_STORAGE(agent_memory, TELEMETRY_AGENT_DEFAULT_STORAGE_BYTES);
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    memory_pool_t* pool;
+    memory_pool_stats_t stats;
+    test_transport_t t;
+    telemetry_agent_config_t config;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message,
+                                 .send_event_signal_safe = test_send_event_signal_safe };
+
+    assert(ring_buffer_init_static(&rb, ring_memory, sizeof(ring_memory), 16) == true);
+    assert(memory_pool_init_static(&pool, pool_memory, sizeof(pool_memory), 256, 8) == true);
+
+    // Too little or misaligned storage is refused
+    assert(telemetry_agent_start_static(&agent, agent_memory, sizeof(agent_memory) - 1u, rb, &transport, NULL) == false);
+    assert(telemetry_agent_start_static(&agent, agent_memory + 1, sizeof(agent_memory) - 1u, rb, &transport, NULL) == false);
+
+    telemetry_agent_config_init(&config);
+    config.max_message_bytes = TELEMETRY_AGENT_DEFAULT_MAX_MESSAGE_BYTES * 2u;
+    assert(telemetry_agent_start_static(&agent, agent_memory, sizeof(agent_memory), rb, &transport, &config) == false);
+
+    // Started twice in the same storage, stopping leaves it reusable
+    for(uint32_t round = 0; round < 2; round++)
+    {
+        memset(&t, 0, sizeof(t));
+        assert(telemetry_agent_start_static(&agent, agent_memory, sizeof(agent_memory), rb, &transport, NULL) == true);
+        assert((uint8_t*)agent == agent_memory);
+
+        uint8_t* block = (uint8_t*)memory_pool_alloc(pool);
+        assert(block != NULL);
+
+        for(size_t index = 0; index < 200; index++)
+        {
+            block[index] = (uint8_t)(7u + index);
+        }
+
+        assert(telemetry_emit_pooled(rb, agent, 7, pool, block, 200, TELEMETRY_LEVEL_INFO) == true);
+        assert(telemetry_emit(rb, agent, 8, "x", 1, TELEMETRY_LEVEL_INFO) == true);
+        assert(telemetry_agent_emit_signal_safe(agent, 9, NULL, 0, TELEMETRY_LEVEL_ERROR) == true);
+        assert(telemetry_agent_flush(agent, 1000000000ull) == true);
+
+        telemetry_agent_stop(agent);
+
+        assert(atomic_load(&t.events) == 3);
+        assert(atomic_load(&t.pooled_events) == 1);
+        assert(t.last_heartbeat.wakeup_count >= 1);
+    }
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0 && stats.block_count == 8);
+
+    memory_pool_free(pool);
+    ring_buffer_free(rb);
+
+    // The ring storage can hold a new ring after the free
+    assert(ring_buffer_init_static(&rb, ring_memory, sizeof(ring_memory), 16) == true);
+    assert(ring_buffer_capacity(rb) == 16 && ring_buffer_count(rb) == 0);
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent static storage is passed. \n");
+}
+
+static void count_hook(void* context)
+{
+    atomic_fetch_add((atomic_uint*)context, 1);
+}
+
+/**
+ * @brief Tests the placement of the agent thread.
+ */
+static void testcase_thread_placement()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_agent_config_t config;
+    test_transport_t t;
+    atomic_uint hook_calls;
+
+    memset(&t, 0, sizeof(t));
+    atomic_init(&hook_calls, 0);
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    ring_buffer_init(&rb, 8);
+    telemetry_agent_config_init(&config);
+    assert(config.thread_attr.policy == OSAL_THREAD_POLICY_DEFAULT && config.thread_attr.pre_start == NULL);
+
+    assert(osal_thread_attr_set_cpu(&config.thread_attr, 0) == true);
+    config.thread_attr.policy = OSAL_THREAD_POLICY_FIFO;
+    config.thread_attr.priority = 10;
+    config.thread_attr.stack_size = 128u * 1024u;
+    config.thread_attr.pre_start = count_hook;
+    config.thread_attr.pre_start_context = &hook_calls;
+
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+    assert(telemetry_emit(rb, agent, 1, "x", 1, TELEMETRY_LEVEL_INFO) == true);
+    assert(telemetry_agent_flush(agent, 1000000000ull) == true);
+
+    // The thread has run its loop, so its placement is settled; the policy needs privileges
+    const uint32_t applied = telemetry_agent_thread_applied(agent);
+    assert((applied & OSAL_THREAD_APPLIED_AFFINITY) != 0);
+    assert((applied & OSAL_THREAD_APPLIED_STACK_SIZE) != 0);
+    assert(atomic_load(&hook_calls) == 1);
+    assert(atomic_load(&t.events) == 1);
+
+    telemetry_agent_stop(agent);
+    assert(telemetry_agent_thread_applied(NULL) == 0);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent thread placement is passed. \n");
+}
+
+/**
+ * @brief Tests that the agent wakes for heartbeats on its own.
+ */
+static void testcase_idle_heartbeats()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_agent_config_t config;
+    test_transport_t t;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    telemetry_agent_config_init(&config);
+    config.heartbeat_interval_ns = 10000000ull;
+
+    ring_buffer_init(&rb, 8);
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    // No event and no notify, the wait times out at each heartbeat deadline
+    osal_thread_sleep_ns(100000000ull);
+
+    assert(telemetry_agent_heartbeat_count(agent) >= 3);
+    assert(telemetry_agent_wakeup_count(agent) == 0);
+
+    telemetry_agent_stop(agent);
+
+    assert(atomic_load(&t.events) == 0);
+    assert(t.last_heartbeat.sent_count == 0);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent idle heartbeats is passed. \n");
+}
+
+/**
+ * @brief Tests an agent woken through the futex backend.
+ */
+static void testcase_futex_wakeup()
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_agent_config_t config;
+    test_transport_t t;
+
+    memset(&t, 0, sizeof(t));
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message,
+                                 .send_event_signal_safe = test_send_event_signal_safe };
+
+    telemetry_agent_config_init(&config);
+    assert(config.wakeup_backend == OSAL_WAKEUP_BACKEND_DEFAULT);
+    config.wakeup_backend = OSAL_WAKEUP_BACKEND_FUTEX;
+
+    ring_buffer_init(&rb, 64);
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    // Bursts while the agent drains and single events while it sleeps
+    for(uint32_t index = 0; index < 200; index++)
+    {
+        while(telemetry_emit(rb, agent, index, "x", 1, TELEMETRY_LEVEL_INFO) == false)
+        {
+            osal_thread_sleep_ns(100000ull);
+        }
+
+        if(index % 50 == 0)
+            osal_thread_sleep_ns(2000000ull);
+    }
+
+    assert(telemetry_agent_emit_signal_safe(agent, 500, NULL, 0, TELEMETRY_LEVEL_ERROR) == true);
+    assert(telemetry_agent_flush(agent, 1000000000ull) == true);
+
+    telemetry_agent_stop(agent);
+
+    assert(atomic_load(&t.events) == 201);
+    assert(t.last_heartbeat.sent_count == 201);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent futex wakeup is passed. \n");
+}
+
+static bool pipe_send_event(void* context, const telemetry_event_t* ev)
+{
+    pipe_transport_t* t = (pipe_transport_t*)context;
+    const uint8_t byte = (uint8_t)ev->event_id;
+
+    if(write(t->fds[1], &byte, 1) != 1)
+    {
+        atomic_store(&t->would_block, errno == EAGAIN);
+        return false;
+    }
+
+    atomic_store(&t->would_block, false);
+
+    if(ev->event_id != atomic_fetch_add(&t->events, 1))
+        t->in_order = false;
+
+    return true;
+}
+
+static int pipe_poll_fd(void* context)
+{
+    return ((pipe_transport_t*)context)->fds[1];
+}
+
+static bool pipe_would_block(void* context)
+{
+    return atomic_load(&((pipe_transport_t*)context)->would_block);
+}
+
+/**
+ * @brief Fills a non-blocking pipe.
+ *
+ * @param fd Write end.
+ */
+static void fill_pipe(int fd)
+{
+    static const uint8_t chunk[4096];
+
+    while(write(fd, chunk, sizeof(chunk)) > 0)
+    {
+    }
+
+    while(write(fd, chunk, 1) > 0)
+    {
+    }
+}
+
+/**
+ * @brief Empties a non-blocking pipe.
+ *
+ * @param fd Read end.
+ */
+static void empty_pipe(int fd)
+{
+    uint8_t chunk[4096];
+
+    while(read(fd, chunk, sizeof(chunk)) > 0)
+    {
+    }
+}
+
+static void testcase_blocked_transport(osal_wakeup_backend_t backend)
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_agent_config_t config;
+    pipe_transport_t t;
+
+    memset(&t, 0, sizeof(t));
+    atomic_init(&t.events, 0);
+    atomic_init(&t.would_block, false);
+    t.in_order = true;
+    assert(pipe2(t.fds, O_NONBLOCK | O_CLOEXEC) == 0);
+
+    transport_c_t transport = { .context = &t, .send_event = pipe_send_event, .poll_fd = pipe_poll_fd,
+                                 .would_block = pipe_would_block };
+
+    telemetry_agent_config_init(&config);
+    config.wakeup_backend = backend;
+
+    ring_buffer_init(&rb, 64);
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    // Full pipe : the first send would block, the rest stays in the ring
+    fill_pipe(t.fds[1]);
+
+    for(uint32_t index = 0; index < 40; index++)
+    {
+        assert(telemetry_emit(rb, agent, index, "x", 1, TELEMETRY_LEVEL_INFO) == true);
+    }
+
+    assert(telemetry_agent_flush(agent, 20000000ull) == false);
+    assert(atomic_load(&t.events) == 0);
+    assert(telemetry_agent_send_error_count(agent) == 0);
+
+    // Room again : everything goes out in order, nothing counts as an error
+    empty_pipe(t.fds[0]);
+    assert(telemetry_agent_flush(agent, 1000000000ull) == true);
+
+    assert(atomic_load(&t.events) == 40);
+    assert(telemetry_agent_sent_count(agent) == 40);
+    assert(telemetry_agent_send_error_count(agent) == 0);
+    assert(t.in_order);
+
+    // Still blocked on stop : the events count as errors after a short grace period
+    fill_pipe(t.fds[1]);
+
+    for(uint32_t index = 0; index < 5; index++)
+    {
+        assert(telemetry_emit(rb, agent, index, "x", 1, TELEMETRY_LEVEL_INFO) == true);
+    }
+
+    assert(telemetry_agent_flush(agent, 10000000ull) == false);
+
+    // Counters are gone with the agent, the transport saw no event go through
+    telemetry_agent_stop(agent);
+    assert(atomic_load(&t.events) == 40);
+
+    ring_buffer_free(rb);
+    close(t.fds[0]);
+    close(t.fds[1]);
+
+    printf("Telemetry :: Test case agent blocked transport (%s) is passed. \n",
+           (backend == OSAL_WAKEUP_BACKEND_FUTEX) ? "futex" : "eventfd");
+}
+
+static void watch_callback(void* context, uint32_t events)
+{
+    watch_probe_t* probe = (watch_probe_t*)context;
+    uint8_t byte = 0;
+
+    assert((events & OSAL_POLL_READABLE) != 0);
+    atomic_fetch_add(&probe->calls, 1);
+
+    // The agent thread is the only producer of this ring
+    while(read(probe->fds[0], &byte, 1) == 1)
+    {
+        assert(telemetry_emit(probe->ring, probe->agent, 700u + byte, NULL, 0, TELEMETRY_LEVEL_INFO) == true);
+    }
+}
+
+static void testcase_watch()
+{
+    ring_buffer_t* rb;
+    ring_buffer_t* watch_rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_agent_config_t config;
+    test_transport_t t;
+    watch_probe_t probe;
+
+    memset(&t, 0, sizeof(t));
+    memset(&probe, 0, sizeof(probe));
+    atomic_init(&probe.calls, 0);
+    transport_c_t transport = { .context = &t, .send_event = test_send_event, .send_message = test_send_message };
+
+    assert(pipe2(probe.fds, O_NONBLOCK | O_CLOEXEC) == 0);
+
+    ring_buffer_init(&rb, 64);
+    ring_buffer_init(&watch_rb, 64);
+
+    // Watches need the poller of the eventfd wakeup, whatever the build default
+    telemetry_agent_config_init(&config);
+    config.wakeup_backend = OSAL_WAKEUP_BACKEND_EVENTFD;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+    assert(telemetry_agent_attach_ring(agent, watch_rb) == true);
+
+    probe.ring = watch_rb;
+    probe.agent = agent;
+
+    assert(telemetry_agent_watch(agent, -1, OSAL_POLL_READABLE, watch_callback, &probe) == false);
+    assert(telemetry_agent_watch(agent, probe.fds[0], OSAL_POLL_READABLE, NULL, &probe) == false);
+    assert(telemetry_agent_watch(NULL, probe.fds[0], OSAL_POLL_READABLE, watch_callback, &probe) == false);
+
+    // A descriptor the poller refuses gives its slot back, however often it is tried
+    const int closed_fd = dup(probe.fds[0]);
+    assert(closed_fd >= 0 && close(closed_fd) == 0);
+
+    for(unsigned attempt = 0; attempt < TELEMETRY_AGENT_MAX_WATCHES * 2u; attempt++)
+        assert(telemetry_agent_watch(agent, closed_fd, OSAL_POLL_READABLE, watch_callback, &probe) == false);
+
+    assert(telemetry_agent_watch(agent, probe.fds[0], OSAL_POLL_READABLE, watch_callback, &probe) == true);
+
+    // Bytes become events on the agent thread and are drained in the same wake
+    const uint8_t bytes[3] = { 1, 2, 3 };
+    assert(write(probe.fds[1], bytes, sizeof(bytes)) == (ssize_t)sizeof(bytes));
+
+    for(int retry = 0; retry < 1000 && atomic_load(&t.events) < 3; retry++)
+    {
+        osal_thread_sleep_ns(1000000ull);
+    }
+
+    assert(atomic_load(&t.events) == 3);
+    assert(atomic_load(&probe.calls) >= 1);
+
+    telemetry_agent_stop(agent);
+
+    // The futex wakeup has no poller to add descriptors to
+    config.wakeup_backend = OSAL_WAKEUP_BACKEND_FUTEX;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+    assert(telemetry_agent_watch(agent, probe.fds[0], OSAL_POLL_READABLE, watch_callback, &probe) == false);
+    telemetry_agent_stop(agent);
+
+    ring_buffer_free(watch_rb);
+    ring_buffer_free(rb);
+    close(probe.fds[0]);
+    close(probe.fds[1]);
+
+    printf("Telemetry :: Test case agent watch is passed. \n");
+}
+
+static bool batch_send_event(void* context, const telemetry_event_t* ev)
+{
+    batch_transport_t* t = (batch_transport_t*)context;
+
+    (void)ev;
+    atomic_fetch_add(&t->queued, 1);
+    return true;
+}
+
+static bool batch_flush(void* context)
+{
+    batch_transport_t* t = (batch_transport_t*)context;
+    const unsigned count = atomic_exchange(&t->queued, 0);
+
+    // Reports flush an empty batch too
+    if(count == 0)
+        return true;
+
+    if(count > atomic_load(&t->largest_batch))
+        atomic_store(&t->largest_batch, count);
+
+    atomic_fetch_add(&t->flushed, count);
+    atomic_store(&t->last_flush_ns, osal_telemetry_now_monotonic_ns());
+    atomic_fetch_add(&t->flushes, 1);
+    return true;
+}
+
+static void wait_for_flushed(batch_transport_t* t, unsigned count)
+{
+    for(int retry = 0; retry < 1000 && atomic_load(&t->flushed) < count; retry++)
+    {
+        osal_thread_sleep_ns(1000000ull);
+    }
+}
+
+static void testcase_flush_policy(osal_wakeup_backend_t backend)
+{
+    ring_buffer_t* rb;
+    telemetry_agent_t* agent = NULL;
+    telemetry_agent_config_t config;
+    batch_transport_t t;
+    telemetry_event_t event;
+    uint8_t payload[40];
+
+    memset(&t, 0, sizeof(t));
+    memset(payload, 0x11, sizeof(payload));
+    transport_c_t transport = { .context = &t, .send_event = batch_send_event, .flush = batch_flush };
+
+    ring_buffer_init(&rb, 64);
+
+    telemetry_agent_config_init(&config);
+    assert(config.max_batch_events == TELEMETRY_AGENT_DEFAULT_MAX_BATCH_EVENTS);
+    assert(config.max_batch_bytes == TELEMETRY_AGENT_DEFAULT_MAX_BATCH_BYTES);
+    assert(config.max_linger_ns == TELEMETRY_AGENT_DEFAULT_MAX_LINGER_NS);
+
+    // Size limit : full batches go out, the rest lingers until telemetry_agent_flush
+    config.wakeup_backend = backend;
+    config.max_batch_events = 10;
+    config.max_batch_bytes = 0;
+    config.max_linger_ns = 10000000000ull;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    for(uint32_t index = 0; index < 25; index++)
+    {
+        telemetry_event_make(&event, index, NULL, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(rb, &event) == true);
+    }
+
+    telemetry_agent_notify(agent);
+    wait_for_flushed(&t, 20);
+    osal_thread_sleep_ns(20000000ull);
+
+    assert(atomic_load(&t.flushed) == 20);
+    assert(atomic_load(&t.flushes) == 2);
+    assert(atomic_load(&t.largest_batch) == 10);
+    assert(atomic_load(&t.queued) == 5);
+
+    assert(telemetry_agent_flush(agent, 1000000000ull) == true);
+    assert(atomic_load(&t.flushed) == 25);
+
+    telemetry_agent_stop(agent);
+
+    // Byte limit : 40 payload bytes per event, a batch of 100 bytes fills with the third
+    memset(&t, 0, sizeof(t));
+    config.max_batch_events = 0;
+    config.max_batch_bytes = 100;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    for(uint32_t index = 0; index < 7; index++)
+    {
+        telemetry_event_make(&event, index, payload, sizeof(payload), TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(rb, &event) == true);
+    }
+
+    telemetry_agent_notify(agent);
+    wait_for_flushed(&t, 6);
+    assert(atomic_load(&t.flushed) == 6);
+    assert(atomic_load(&t.largest_batch) == 3);
+
+    // Stopping flushes what lingers
+    telemetry_agent_stop(agent);
+    assert(atomic_load(&t.flushed) == 7);
+
+    // Linger : a batch below the limits goes out once its first event waited max_linger_ns
+    memset(&t, 0, sizeof(t));
+    config.max_batch_events = 64;
+    config.max_batch_bytes = 0;
+    config.max_linger_ns = 30000000ull;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    const uint64_t start_ns = osal_telemetry_now_monotonic_ns();
+
+    for(uint32_t index = 0; index < 3; index++)
+    {
+        telemetry_event_make(&event, index, NULL, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(rb, &event) == true);
+    }
+
+    telemetry_agent_notify(agent);
+    wait_for_flushed(&t, 3);
+
+    assert(atomic_load(&t.flushed) == 3);
+    assert(atomic_load(&t.flushes) == 1);
+    assert(atomic_load(&t.last_flush_ns) - start_ns >= config.max_linger_ns);
+
+    telemetry_agent_stop(agent);
+
+    // Endless linger : size limits only, the batch waits for telemetry_agent_flush
+    memset(&t, 0, sizeof(t));
+    config.max_linger_ns = UINT64_MAX;
+    assert(telemetry_agent_start_ex(&agent, rb, &transport, &config) == true);
+
+    for(uint32_t index = 0; index < 3; index++)
+    {
+        telemetry_event_make(&event, index, NULL, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(rb, &event) == true);
+    }
+
+    telemetry_agent_notify(agent);
+    osal_thread_sleep_ns(20000000ull);
+    assert(atomic_load(&t.queued) == 3);
+    assert(atomic_load(&t.flushed) == 0);
+
+    assert(telemetry_agent_flush(agent, 1000000000ull) == true);
+    assert(atomic_load(&t.flushed) == 3);
+
+    telemetry_agent_stop(agent);
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case agent flush policy (%s) is passed. \n",
+           (backend == OSAL_WAKEUP_BACKEND_FUTEX) ? "futex" : "eventfd");
+}
@@ -8,6 +8,9 @@
  */
 
 #include <event.h>
+#include <memory_pool.h>
+#include <ring_buffer.h>
+#include <osal_time.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
@@ -17,6 +20,9 @@
 static void test_payload_copy(void);
 static void test_monotonic_timestamp(void);
 static void test_oversized_payload(void);
+static void test_raw_ticks_timestamp(void);
+static void test_id_clock_override(void);
+static void test_pooled_payload(void);
 void test_event(void);
 
 // Test main function
@@ -32,6 +38,9 @@ void test_event()
     test_payload_copy();
     test_monotonic_timestamp();
     test_oversized_payload();
+    test_raw_ticks_timestamp();
+    test_id_clock_override();
+    test_pooled_payload();
 }
 
 /**
@@ -111,4 +120,151 @@ static void test_oversized_payload()
     assert(!ok);
 
     printf("Telemetry :: Test case test_oversized_payload is passed. \n");
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Tests raw tick timestamps and their batch conversion.
+ *
+ * Events of a level set to TELEMETRY_CLOCK_TICKS carry the counter value
+ * and the flag until a consumer converts them.
+ */
+static void test_raw_ticks_timestamp()
+{
+    telemetry_event_t events[3];
+
+    telemetry_event_set_level_clock(TELEMETRY_LEVEL_DEBUG, TELEMETRY_CLOCK_TICKS);
+    assert(telemetry_event_level_clock(TELEMETRY_LEVEL_DEBUG) == TELEMETRY_CLOCK_TICKS);
+    assert(telemetry_event_level_clock(TELEMETRY_LEVEL_INFO) == TELEMETRY_CLOCK_PRECISE);
+
+    const uint64_t before_ns = osal_telemetry_now_monotonic_ns();
+    assert(telemetry_event_make(&events[0], 0x10, NULL, 0, TELEMETRY_LEVEL_DEBUG));
+    assert(telemetry_event_make(&events[1], 0x11, NULL, 0, TELEMETRY_LEVEL_INFO));
+    assert(telemetry_event_make(&events[2], 0x12, NULL, 0, TELEMETRY_LEVEL_DEBUG));
+    const uint64_t after_ns = osal_telemetry_now_monotonic_ns();
+
+    telemetry_event_set_level_clock(TELEMETRY_LEVEL_DEBUG, TELEMETRY_CLOCK_PRECISE);
+
+    assert((events[0].reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) != 0);
+    assert((events[1].reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0);
+
+    const uint64_t first_ns = telemetry_event_timestamp_ns(&events[0]);
+
+    telemetry_event_resolve_timestamps(events, 3);
+
+    // All flags cleared, every timestamp in nanoseconds and in order
+    for(int index = 0; index < 3; index++)
+    {
+        assert((events[index].reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0);
+        assert(events[index].timestamp + 1000 >= before_ns && events[index].timestamp <= after_ns + 1000);
+    }
+
+    assert(events[0].timestamp == first_ns);
+    assert(events[0].timestamp <= events[2].timestamp);
+
+    printf("Telemetry :: Test case test_raw_ticks_timestamp is passed. \n");
+}
+
+/**
+ * @brief Tests per event id clocks and the coarse clock.
+ */
+static void test_id_clock_override()
+{
+    telemetry_event_t event;
+
+    // Id overrides win over the level clock
+    telemetry_event_set_level_clock(TELEMETRY_LEVEL_INFO, TELEMETRY_CLOCK_TICKS);
+    assert(telemetry_event_set_id_clock(0x20, TELEMETRY_CLOCK_COARSE) == true);
+    assert(telemetry_event_set_id_clock(0x21, TELEMETRY_CLOCK_PRECISE) == true);
+    assert(telemetry_event_set_id_clock(0x22, (telemetry_clock_t)9) == false);
+
+    assert(telemetry_event_clock_for(0x20, TELEMETRY_LEVEL_INFO) == TELEMETRY_CLOCK_COARSE);
+    assert(telemetry_event_clock_for(0x21, TELEMETRY_LEVEL_INFO) == TELEMETRY_CLOCK_PRECISE);
+    assert(telemetry_event_clock_for(0x22, TELEMETRY_LEVEL_INFO) == TELEMETRY_CLOCK_TICKS);
+    assert(telemetry_event_clock_for(0x20, TELEMETRY_LEVEL_ERROR) == TELEMETRY_CLOCK_COARSE);
+
+    // Coarse events are stamped in nanoseconds, without the raw ticks flag
+    const uint64_t before_ns = osal_telemetry_now_coarse_ns();
+    assert(telemetry_event_make(&event, 0x20, NULL, 0, TELEMETRY_LEVEL_INFO));
+    assert((event.reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0);
+    assert(event.timestamp >= before_ns && event.timestamp <= osal_telemetry_now_monotonic_ns() + 1000000ull);
+
+    assert(telemetry_event_make(&event, 0x22, NULL, 0, TELEMETRY_LEVEL_INFO));
+    assert((event.reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) != 0);
+
+    // Cleared ids follow their level again, a changed override replaces the old one
+    telemetry_event_clear_id_clock(0x20);
+    assert(telemetry_event_clock_for(0x20, TELEMETRY_LEVEL_INFO) == TELEMETRY_CLOCK_TICKS);
+    assert(telemetry_event_set_id_clock(0x20, TELEMETRY_CLOCK_PRECISE) == true);
+    assert(telemetry_event_clock_for(0x20, TELEMETRY_LEVEL_INFO) == TELEMETRY_CLOCK_PRECISE);
+
+    telemetry_event_clear_id_clock(0x20);
+    telemetry_event_clear_id_clock(0x21);
+    telemetry_event_set_level_clock(TELEMETRY_LEVEL_INFO, TELEMETRY_CLOCK_PRECISE);
+    assert(telemetry_event_clock_for(0x21, TELEMETRY_LEVEL_INFO) == TELEMETRY_CLOCK_PRECISE);
+
+    printf("Telemetry :: Test case test_id_clock_override is passed. \n");
+}
+
+/**
+ * @brief Tests events whose payload lives in a memory pool block.
+ *
+ * The ring carries only the handle; the block is reached through it and
+ * given back once.
+ */
+static void test_pooled_payload()
+{
+    memory_pool_t* pool;
+    memory_pool_t* other;
+    memory_pool_stats_t stats;
+    ring_buffer_t* rb;
+    telemetry_event_t event;
+    telemetry_event_t popped;
+
+    assert(memory_pool_init(&pool, 4096, 4) == true);
+    assert(memory_pool_init(&other, 4096, 1) == true);
+    assert(ring_buffer_init(&rb, 4) == true);
+
+    uint8_t* block = (uint8_t*)memory_pool_alloc(pool);
+    for(size_t index = 0; index < 3000; index++)
+    {
+        block[index] = (uint8_t)index;
+    }
+
+    // Too large for the block, or a block of another pool
+    assert(telemetry_event_make_pooled(&event, 7, pool, block, 4097, TELEMETRY_LEVEL_INFO) == false);
+    assert(telemetry_event_make_pooled(&event, 7, other, block, 16, TELEMETRY_LEVEL_INFO) == false);
+    assert(telemetry_event_make_pooled(&event, 7, pool, block + 1, 16, TELEMETRY_LEVEL_INFO) == false);
+
+    assert(telemetry_event_make_pooled(&event, 7, pool, block, 3000, TELEMETRY_LEVEL_INFO) == true);
+    assert(telemetry_event_is_pooled(&event));
+    assert(event.payload_size == 3000);
+    assert(telemetry_event_payload(&event) == block);
+
+    // The payload is not copied on the way through the ring
+    assert(ring_buffer_push(rb, &event) == true);
+    assert(ring_buffer_pop(rb, &popped) == true);
+    assert(telemetry_event_payload(&popped) == block);
+    assert(telemetry_event_payload(&popped)[2999] == (uint8_t)2999);
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 1);
+
+    telemetry_event_release_payload(&popped);
+    assert(!telemetry_event_is_pooled(&popped) && popped.payload_size == 0);
+    telemetry_event_release_payload(&popped);
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0);
+
+    // Inline events are untouched
+    assert(telemetry_event_make(&event, 8, "abc", 3, TELEMETRY_LEVEL_INFO));
+    assert(telemetry_event_payload(&event) == event.payload);
+    telemetry_event_release_payload(&event);
+    assert(event.payload_size == 3);
+
+    ring_buffer_free(rb);
+    memory_pool_free(other);
+    memory_pool_free(pool);
+
+    printf("Telemetry :: Test case test_pooled_payload is passed. \n");
+}
@@ -0,0 +1,144 @@
+/**
+ * @file test_filter.c
+ * @brief Unit tests for the emit filters.
+ *
+ * This file contains test cases for the runtime per event id bitmap and
+ * the build time minimum level of the emit macros.
+ * @author Aravinthraj Ganesan
+ */
+
+// Build as a release configuration would, with DEBUG and INFO stripped
+#undef TELEMETRY_MIN_LEVEL
+#define TELEMETRY_MIN_LEVEL 2
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "telemetry_emit.h"
+
+/* Test cases :
+    1. Disabled ids are not built, their payload expressions are not evaluated
+    2. Ids outside the bitmap can not be disabled
+    3. Levels below the minimum are compiled out, the others pass
+*/
+
+// Local function prototype declaration
+static void testcase_runtime_filter(void);
+static void testcase_filter_range(void);
+static void testcase_min_level(void);
+
+void test_filter(void);
+
+// Counts payload evaluations
+static int payload_builds;
+
+/**
+ * @brief Main entry point for running filter tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_filter()
+{
+    testcase_runtime_filter();
+    testcase_filter_range();
+    testcase_min_level();
+}
+
+/**
+ * @brief Payload expression that records it was evaluated.
+ */
+static const void* build_payload(const uint32_t* value)
+{
+    payload_builds++;
+    return value;
+}
+
+/**
+ * @brief Tests emitting with an id disabled and enabled again.
+ */
+static void testcase_runtime_filter()
+{
+    ring_buffer_t* rb;
+    telemetry_event_t event;
+    const uint32_t value = 42;
+
+    assert(ring_buffer_init(&rb, 8) == true);
+    payload_builds = 0;
+
+    assert(telemetry_event_filter_enabled(7) == true);
+    assert(telemetry_event_filter_set(7, false) == true);
+    assert(telemetry_event_filter_enabled(7) == false);
+
+    // Neighbours in the same word are not affected
+    assert(telemetry_event_filter_enabled(6) == true && telemetry_event_filter_enabled(8) == true);
+
+    TELEMETRY_EMIT_ERROR(rb, NULL, 7, build_payload(&value), sizeof(value));
+    assert(payload_builds == 0);
+    assert(ring_buffer_pop(rb, &event) == false);
+
+    assert(telemetry_event_filter_set(7, true) == true);
+    TELEMETRY_EMIT_ERROR(rb, NULL, 7, build_payload(&value), sizeof(value));
+    assert(payload_builds == 1);
+    assert(ring_buffer_pop(rb, &event) == true);
+    assert(event.event_id == 7 && event.level == TELEMETRY_LEVEL_ERROR && event.payload_size == sizeof(value));
+
+    // Reset enables everything again
+    assert(telemetry_event_filter_set(64, false) == true);
+    telemetry_event_filter_reset();
+    assert(telemetry_event_filter_enabled(64) == true);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case runtime id filter is passed. \n");
+}
+
+/**
+ * @brief Tests ids at and beyond the end of the bitmap.
+ */
+static void testcase_filter_range()
+{
+    assert(telemetry_event_filter_set(TELEMETRY_EVENT_FILTER_IDS - 1u, false) == true);
+    assert(telemetry_event_filter_enabled(TELEMETRY_EVENT_FILTER_IDS - 1u) == false);
+    assert(telemetry_event_filter_set(TELEMETRY_EVENT_FILTER_IDS - 1u, true) == true);
+
+    assert(telemetry_event_filter_set(TELEMETRY_EVENT_FILTER_IDS, false) == false);
+    assert(telemetry_event_filter_enabled(TELEMETRY_EVENT_FILTER_IDS) == true);
+    assert(telemetry_event_filter_enabled(TELEMETRY_EVENT_ID_RESERVED_BASE) == true);
+
+    printf("Telemetry :: Test case id filter range is passed. \n");
+}
+
+/**
+ * @brief Tests the build time minimum level.
+ */
+static void testcase_min_level()
+{
+    ring_buffer_t* rb;
+    telemetry_event_t event;
+    const uint32_t value = 1;
+
+    assert(ring_buffer_init(&rb, 8) == true);
+    payload_builds = 0;
+
+    // Constant conditions, usable where a constant expression is needed
+    _Static_assert(!TELEMETRY_LEVEL_COMPILED(TELEMETRY_LEVEL_INFO), "INFO is below the minimum");
+    _Static_assert(TELEMETRY_LEVEL_COMPILED(TELEMETRY_LEVEL_WARNING), "WARNING is compiled in");
+
+    TELEMETRY_EMIT_DEBUG(rb, NULL, 1, build_payload(&value), sizeof(value));
+    TELEMETRY_EMIT_INFO(rb, NULL, 2, build_payload(&value), sizeof(value));
+    assert(payload_builds == 0);
+    assert(ring_buffer_pop(rb, &event) == false);
+
+    TELEMETRY_EMIT_WARNING(rb, NULL, 3, build_payload(&value), sizeof(value));
+    TELEMETRY_EMIT(rb, NULL, 4, build_payload(&value), sizeof(value), TELEMETRY_LEVEL_ERROR);
+    assert(payload_builds == 2);
+    assert(ring_buffer_pop(rb, &event) == true && event.event_id == 3);
+    assert(ring_buffer_pop(rb, &event) == true && event.event_id == 4);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case minimum level is passed. \n");
+}
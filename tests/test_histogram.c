@@ -0,0 +1,280 @@
+/**
+ * @file test_histogram.c
+ * @brief Unit tests for the log-linear latency histogram.
+ *
+ * This file contains test cases for bucket mapping, percentiles, merging,
+ * the histogram wire encoding and snapshots taken while the writer records.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "histogram.h"
+#include "osal_thread.h"
+
+/* Test cases :
+    1. Bucket mapping covers the full range with bounded relative error
+    2. Percentiles of a known distribution
+    3. Merge of two snapshots
+    4. Encode and decode round trip, truncated input rejected
+    5. Snapshots taken while the single writer records keep min and max within the recorded values
+*/
+
+// Histograms the writer fills one after the other, each snapshotted while its first values go in
+#define TEST_HISTOGRAMS 256
+#define TEST_WRITER_VALUES 64u
+#define TEST_VALUE_LOW 1000u
+#define TEST_VALUE_HIGH 5000u
+
+// Local function prototype declaration
+static void testcase_bucket_mapping(void);
+static void testcase_percentiles(void);
+static void testcase_merge(void);
+static void testcase_encode_decode(void);
+static void testcase_snapshot_during_record(void);
+
+void test_histogram(void);
+
+// Snapshots are large, keep them off the stack
+static telemetry_histogram_snapshot_t snapshot_a;
+static telemetry_histogram_snapshot_t snapshot_b;
+
+/**
+ * @brief Main entry point for running histogram tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_histogram()
+{
+    testcase_bucket_mapping();
+    testcase_percentiles();
+    testcase_merge();
+    testcase_encode_decode();
+    testcase_snapshot_during_record();
+}
+
+/**
+ * @brief Tests bucket index and bounds.
+ */
+static void testcase_bucket_mapping()
+{
+    // Small values are exact
+    for(uint64_t value = 0; value < TELEMETRY_HISTOGRAM_SUB_BUCKETS; value++)
+    {
+        assert(telemetry_histogram_bucket_index(value) == value);
+        assert(telemetry_histogram_bucket_lower(value) == value);
+        assert(telemetry_histogram_bucket_upper(value) == value);
+    }
+
+    // Bounds are contiguous and every value maps inside its bucket
+    for(size_t index = 1; index < TELEMETRY_HISTOGRAM_BUCKETS; index++)
+    {
+        assert(telemetry_histogram_bucket_lower(index) == telemetry_histogram_bucket_upper(index - 1) + 1);
+    }
+
+    const uint64_t values[] = { 16, 17, 31, 32, 1000, 123456789ull, 1ull << 40, UINT64_MAX };
+
+    for(size_t index = 0; index < sizeof(values) / sizeof(values[0]); index++)
+    {
+        const size_t bucket = telemetry_histogram_bucket_index(values[index]);
+        const uint64_t lower = telemetry_histogram_bucket_lower(bucket);
+        const uint64_t upper = telemetry_histogram_bucket_upper(bucket);
+
+        assert(bucket < TELEMETRY_HISTOGRAM_BUCKETS);
+        assert(lower <= values[index] && values[index] <= upper);
+
+        // Width is at most 1/SUB_BUCKETS of the value
+        assert((upper - lower) <= lower / TELEMETRY_HISTOGRAM_SUB_BUCKETS);
+    }
+
+    assert(telemetry_histogram_bucket_index(UINT64_MAX) == TELEMETRY_HISTOGRAM_BUCKETS - 1);
+    assert(telemetry_histogram_bucket_upper(TELEMETRY_HISTOGRAM_BUCKETS - 1) == UINT64_MAX);
+
+    printf("Telemetry :: Test case histogram bucket mapping is passed. \n");
+}
+
+/**
+ * @brief Tests percentiles of 1..10000.
+ */
+static void testcase_percentiles()
+{
+    telemetry_histogram_t* histogram;
+
+    assert(telemetry_histogram_init(&histogram) == true);
+
+    telemetry_histogram_snapshot(histogram, &snapshot_a);
+    assert(snapshot_a.count == 0 && snapshot_a.min == 0 && snapshot_a.max == 0);
+    assert(telemetry_histogram_snapshot_percentile(&snapshot_a, 99.0) == 0);
+
+    for(uint64_t value = 1; value <= 10000; value++)
+    {
+        telemetry_histogram_record(histogram, value);
+    }
+
+    telemetry_histogram_snapshot(histogram, &snapshot_a);
+    assert(snapshot_a.count == 10000 && snapshot_a.sum == 50005000ull);
+    assert(snapshot_a.min == 1 && snapshot_a.max == 10000);
+
+    // Results are the bucket upper bound, within 1/16 of the exact value
+    const uint64_t p50 = telemetry_histogram_snapshot_percentile(&snapshot_a, 50.0);
+    const uint64_t p99 = telemetry_histogram_snapshot_percentile(&snapshot_a, 99.0);
+
+    assert(p50 >= 5000 && p50 <= 5000 + 5000 / 16);
+    assert(p99 >= 9900 && p99 <= 10000);
+    assert(telemetry_histogram_snapshot_percentile(&snapshot_a, 0.0) == 1);
+    assert(telemetry_histogram_snapshot_percentile(&snapshot_a, 100.0) == 10000);
+
+    telemetry_histogram_free(histogram);
+
+    printf("Telemetry :: Test case histogram percentiles is passed. \n");
+}
+
+/**
+ * @brief Tests merging two snapshots.
+ */
+static void testcase_merge()
+{
+    telemetry_histogram_t* first;
+    telemetry_histogram_t* second;
+
+    assert(telemetry_histogram_init(&first) == true);
+    assert(telemetry_histogram_init(&second) == true);
+
+    telemetry_histogram_record(first, 10);
+    telemetry_histogram_record(first, 20);
+    telemetry_histogram_record_shared(second, 5);
+    telemetry_histogram_record_shared(second, 5000);
+
+    telemetry_histogram_snapshot(first, &snapshot_a);
+    telemetry_histogram_snapshot(second, &snapshot_b);
+    telemetry_histogram_snapshot_merge(&snapshot_a, &snapshot_b);
+
+    assert(snapshot_a.count == 4 && snapshot_a.sum == 5035);
+    assert(snapshot_a.min == 5 && snapshot_a.max == 5000);
+    assert(snapshot_a.buckets[telemetry_histogram_bucket_index(5000)] == 1);
+    assert(telemetry_histogram_snapshot_percentile(&snapshot_a, 100.0) == 5000);
+
+    telemetry_histogram_free(first);
+    telemetry_histogram_free(second);
+
+    printf("Telemetry :: Test case histogram merge is passed. \n");
+}
+
+/**
+ * @brief Tests the wire encoding round trip.
+ */
+static void testcase_encode_decode()
+{
+    telemetry_histogram_t* histogram;
+    uint8_t buffer[256];
+
+    assert(telemetry_histogram_init(&histogram) == true);
+
+    telemetry_histogram_record(histogram, 0);
+    telemetry_histogram_record(histogram, 700);
+    telemetry_histogram_record(histogram, 700);
+    telemetry_histogram_record(histogram, 1ull << 50);
+
+    telemetry_histogram_snapshot(histogram, &snapshot_a);
+
+    size_t length = telemetry_histogram_encode(&snapshot_a, buffer, sizeof(buffer));
+    assert(length > 0 && length < 64);
+
+    assert(telemetry_histogram_decode(&snapshot_b, buffer, length) == length);
+    assert(snapshot_b.count == snapshot_a.count && snapshot_b.sum == snapshot_a.sum);
+    assert(snapshot_b.min == 0 && snapshot_b.max == (1ull << 50));
+
+    for(size_t index = 0; index < TELEMETRY_HISTOGRAM_BUCKETS; index++)
+    {
+        assert(snapshot_b.buckets[index] == snapshot_a.buckets[index]);
+    }
+
+    // Truncated input and a small buffer are rejected
+    assert(telemetry_histogram_decode(&snapshot_b, buffer, length - 1) == 0);
+    assert(telemetry_histogram_encode(&snapshot_a, buffer, 4) == 0);
+
+    telemetry_histogram_free(histogram);
+
+    printf("Telemetry :: Test case histogram encode decode is passed. \n");
+}
+
+static telemetry_histogram_t* concurrent_histograms[TEST_HISTOGRAMS];
+static atomic_int concurrent_current;
+
+static void* record_worker(void* arg)
+{
+    (void)arg;
+
+    for(int index = 0; index < TEST_HISTOGRAMS; index++)
+    {
+        atomic_store_explicit(&concurrent_current, index, memory_order_release);
+
+        for(uint32_t value = 0; value < TEST_WRITER_VALUES; value++)
+        {
+            telemetry_histogram_record(concurrent_histograms[index],
+                                       TEST_VALUE_LOW + ((value * 61u) % (TEST_VALUE_HIGH - TEST_VALUE_LOW)));
+        }
+    }
+
+    atomic_store_explicit(&concurrent_current, TEST_HISTOGRAMS, memory_order_release);
+
+    return NULL;
+}
+
+/**
+ * @brief Tests snapshots taken while the writer records.
+ */
+static void testcase_snapshot_during_record()
+{
+    osal_thread_t* writer;
+
+    for(int index = 0; index < TEST_HISTOGRAMS; index++)
+    {
+        assert(telemetry_histogram_init(&concurrent_histograms[index]) == true);
+    }
+
+    atomic_init(&concurrent_current, -1);
+    assert(osal_thread_create(&writer, record_worker, NULL, "test_record") == 0);
+
+    for(;;)
+    {
+        const int current = atomic_load_explicit(&concurrent_current, memory_order_acquire);
+
+        if(current >= TEST_HISTOGRAMS)
+            break;
+
+        if(current < 0)
+            continue;
+
+        telemetry_histogram_snapshot(concurrent_histograms[current], &snapshot_a);
+
+        if(snapshot_a.count == 0)
+            continue;
+
+        // Every bound and percentile stays within the buckets of the recorded values
+        assert(snapshot_a.min >= telemetry_histogram_bucket_lower(telemetry_histogram_bucket_index(TEST_VALUE_LOW)));
+        assert(snapshot_a.max <= telemetry_histogram_bucket_upper(telemetry_histogram_bucket_index(TEST_VALUE_HIGH)));
+        assert(snapshot_a.min <= snapshot_a.max);
+        assert(telemetry_histogram_snapshot_percentile(&snapshot_a, 100.0) <= snapshot_a.max);
+        assert(telemetry_histogram_snapshot_percentile(&snapshot_a, 0.0) >= snapshot_a.min);
+    }
+
+    osal_thread_join(writer);
+    osal_thread_destroy(writer);
+
+    for(int index = 0; index < TEST_HISTOGRAMS; index++)
+    {
+        // Once the writer is done the bounds are the exact recorded ones
+        telemetry_histogram_snapshot(concurrent_histograms[index], &snapshot_a);
+        assert(snapshot_a.count == TEST_WRITER_VALUES);
+        assert(snapshot_a.min == TEST_VALUE_LOW);
+        assert(snapshot_a.max <= TEST_VALUE_HIGH);
+        telemetry_histogram_free(concurrent_histograms[index]);
+    }
+
+    printf("Telemetry :: Test case histogram snapshot during record is passed. \n");
+}
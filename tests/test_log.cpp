@@ -0,0 +1,283 @@
+/**
+ * @file test_log.cpp
+ * @brief Unit tests for the deferred-format logging.
+ *
+ * This file contains test cases for the argument packing, the dictionary
+ * events, the offline formatter and the C++ logging front end.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "telemetry_log.hpp"
+
+/* Test cases :
+    1. Packed arguments are formatted back with flags, width and precision
+    2. Missing or damaged arguments print as <?>
+    3. Long formats are split into dictionary chunks and reassembled
+    4. The front end ships the dictionary once, then only ids and arguments
+    5. A full ring buffer drops the line and ships the dictionary later
+*/
+
+// Local function prototype declaration
+static void testcase_format_arguments(void);
+static void testcase_missing_arguments(void);
+static void testcase_dictionary_chunks(void);
+static void testcase_logger(void);
+static void testcase_logger_full_ring(void);
+
+extern "C" void test_log(void);
+
+/**
+ * @brief Main entry point for running logging tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_log()
+{
+    testcase_format_arguments();
+    testcase_missing_arguments();
+    testcase_dictionary_chunks();
+    testcase_logger();
+    testcase_logger_full_ring();
+}
+
+/**
+ * @brief Decodes a popped dictionary event and appends its chunk.
+ */
+static void append_chunk(const telemetry_event_t& event, std::string& text, telemetry_log_dictionary_t& entry)
+{
+    assert(event.event_id == TELEMETRY_LOG_DICTIONARY_EVENT_ID);
+    assert(telemetry_log_dictionary_decode(&entry, event.payload, event.payload_size) == true);
+    assert(entry.offset == text.size());
+
+    text.append(entry.chunk, entry.chunk_length);
+}
+
+/**
+ * @brief Formats a log event with a format and its types.
+ */
+static std::string format_event(const telemetry_event_t& event, const std::string& format, const telemetry_log_dictionary_t& entry)
+{
+    char text[256];
+
+    telemetry_log_format(text, sizeof(text), format.c_str(), entry.arg_types, entry.arg_count, event.payload, event.payload_size);
+
+    return std::string(text);
+}
+
+/**
+ * @brief Tests packing and formatting every argument type.
+ */
+static void testcase_format_arguments()
+{
+    uint8_t args[TELEMETRY_EVENT_PAYLOAD_MAX];
+    char text[128];
+    size_t length = 0;
+
+    const uint8_t types[] = {
+        TELEMETRY_LOG_ARG_UNSIGNED, TELEMETRY_LOG_ARG_SIGNED, TELEMETRY_LOG_ARG_DOUBLE,
+        TELEMETRY_LOG_ARG_FLOAT, TELEMETRY_LOG_ARG_STRING, TELEMETRY_LOG_ARG_UNSIGNED, TELEMETRY_LOG_ARG_SIGNED
+    };
+
+    length += telemetry_log_put_unsigned(args + length, sizeof(args) - length, 300);
+    length += telemetry_log_put_signed(args + length, sizeof(args) - length, -42);
+    length += telemetry_log_put_double(args + length, sizeof(args) - length, 3.25);
+    length += telemetry_log_put_float(args + length, sizeof(args) - length, 0.5f);
+    length += telemetry_log_put_string(args + length, sizeof(args) - length, "eth0", 4);
+    length += telemetry_log_put_unsigned(args + length, sizeof(args) - length, 0xBEEF);
+    length += telemetry_log_put_signed(args + length, sizeof(args) - length, 'A');
+
+    // Small values take few bytes
+    assert(length == 2 + 1 + 8 + 4 + 5 + 3 + 2);
+
+    telemetry_log_format(text, sizeof(text), "n=%u d=%5ld t=%.2f h=%g if=%-6s| x=%#x c=%c 100%%",
+                         types, 7, args, length);
+    assert(std::strcmp(text, "n=300 d=  -42 t=3.25 h=0.5 if=eth0  | x=0xbeef c=A 100%") == 0);
+
+    // Truncated output stays terminated
+    char small[8];
+    assert(telemetry_log_format(small, sizeof(small), "n=%u d=%d", types, 2, args, length) == 7);
+    assert(std::strcmp(small, "n=300 d") == 0);
+
+    std::printf("Telemetry :: Test case log format arguments is passed. \n");
+}
+
+/**
+ * @brief Tests formatting with fewer packed arguments than conversions.
+ */
+static void testcase_missing_arguments()
+{
+    uint8_t args[16];
+    char text[64];
+    const uint8_t types[] = { TELEMETRY_LOG_ARG_UNSIGNED, TELEMETRY_LOG_ARG_STRING };
+
+    const size_t length = telemetry_log_put_unsigned(args, sizeof(args), 7);
+
+    // Second argument is declared but missing, third is not declared
+    telemetry_log_format(text, sizeof(text), "a=%u b=%s c=%d %q", types, 2, args, length);
+    assert(std::strcmp(text, "a=7 b=<?> c=<?> %q") == 0);
+
+    // A string is truncated to the space left
+    assert(telemetry_log_put_string(args, 4, "abcdef", 6) == 4);
+    telemetry_log_format(text, sizeof(text), "[%s]", &types[1], 1, args, 4);
+    assert(std::strcmp(text, "[abc]") == 0);
+
+    std::printf("Telemetry :: Test case log missing arguments is passed. \n");
+}
+
+/**
+ * @brief Tests splitting a long format into dictionary chunks.
+ */
+static void testcase_dictionary_chunks()
+{
+    std::string format(300, 'x');
+    std::string rebuilt;
+    uint8_t payload[TELEMETRY_EVENT_PAYLOAD_MAX];
+    telemetry_log_dictionary_t entry;
+    telemetry_log_dictionary_t decoded;
+
+    entry.format_id = 77;
+    entry.format_length = static_cast<uint32_t>(format.size());
+    entry.arg_count = 1;
+    entry.arg_types[0] = TELEMETRY_LOG_ARG_SIGNED;
+
+    size_t offset = 0;
+    int chunks = 0;
+
+    while(offset < format.size())
+    {
+        size_t written = 0;
+
+        entry.offset = static_cast<uint32_t>(offset);
+        entry.chunk = format.c_str() + offset;
+        entry.chunk_length = format.size() - offset;
+
+        const size_t length = telemetry_log_dictionary_encode(payload, sizeof(payload), &entry, &written);
+        assert(length > 0 && written > 0);
+
+        assert(telemetry_log_dictionary_decode(&decoded, payload, length) == true);
+        assert(decoded.format_id == 77 && decoded.arg_count == 1 && decoded.arg_types[0] == TELEMETRY_LOG_ARG_SIGNED);
+        assert(decoded.offset == offset);
+
+        rebuilt.append(decoded.chunk, decoded.chunk_length);
+        offset += written;
+        chunks++;
+    }
+
+    assert(chunks == 3);
+    assert(rebuilt == format);
+
+    // A chunk claiming to run past the format is rejected
+    entry.offset = 0;
+    entry.format_length = 4;
+    entry.chunk = "abcdef";
+    entry.chunk_length = 6;
+    size_t written = 0;
+    const size_t length = telemetry_log_dictionary_encode(payload, sizeof(payload), &entry, &written);
+    assert(telemetry_log_dictionary_decode(&decoded, payload, length) == false);
+
+    std::printf("Telemetry :: Test case log dictionary chunks is passed. \n");
+}
+
+/**
+ * @brief Tests the front end from the call site to the reconstructed line.
+ */
+static void testcase_logger()
+{
+    ring_buffer_t* rb;
+    telemetry_event_t event;
+    telemetry_log_dictionary_t entry;
+
+    assert(ring_buffer_init(&rb, 16) == true);
+    telemetry::log::Logger logger(rb);
+
+    for(int index = 0; index < 3; index++)
+    {
+        TELEMETRY_LOG(logger, TELEMETRY_LEVEL_WARNING, "queue %s depth %d of %u", "rx", -index, 8u);
+    }
+
+    // One dictionary event, then three log events
+    std::string format;
+    assert(ring_buffer_pop(rb, &event) == true);
+    append_chunk(event, format, entry);
+    assert(format == "queue %s depth %d of %u");
+    assert(entry.arg_count == 3);
+
+    const uint32_t format_id = entry.format_id;
+    uint32_t decoded_id = 0;
+
+    for(int index = 0; index < 3; index++)
+    {
+        assert(ring_buffer_pop(rb, &event) == true);
+        assert(telemetry_log_format_id(event.event_id, &decoded_id) && decoded_id == format_id);
+        assert(event.level == TELEMETRY_LEVEL_WARNING);
+        assert(event.payload_size == 3 + 1 + 1);
+        assert(format_event(event, format, entry) == "queue rx depth " + std::to_string(-index) + " of 8");
+    }
+
+    assert(ring_buffer_pop(rb, &event) == false);
+
+    // Republishing sends every registered format again
+    assert(logger.publishDictionary() == true);
+    assert(ring_buffer_pop(rb, &event) == true);
+    assert(event.event_id == TELEMETRY_LOG_DICTIONARY_EVENT_ID);
+
+    ring_buffer_free(rb);
+
+    std::printf("Telemetry :: Test case log front end is passed. \n");
+}
+
+/**
+ * @brief Tests a logger whose ring buffer is full.
+ */
+static void testcase_logger_full_ring()
+{
+    ring_buffer_t* rb;
+    telemetry_event_t event;
+    telemetry_log_dictionary_t entry;
+
+    // Two slots, both taken by other events
+    assert(ring_buffer_init(&rb, 2) == true);
+    telemetry::log::Logger logger(rb);
+
+    telemetry_event_make(&event, 1, NULL, 0, TELEMETRY_LEVEL_INFO);
+    while(ring_buffer_push(rb, &event))
+    {
+    }
+
+    for(int attempt = 0; attempt < 2; attempt++)
+    {
+        TELEMETRY_LOG(logger, TELEMETRY_LEVEL_ERROR, "link %s down", std::string("eth1"));
+        if(attempt == 0)
+        {
+            assert(logger.dropped() == 1);
+
+            // Drain the ring, the next call ships the dictionary first
+            while(ring_buffer_pop(rb, &event))
+            {
+            }
+        }
+    }
+
+    assert(logger.dropped() == 1);
+
+    // Dictionary and line fill the ring, a line after the shipped dictionary is lost too
+    TELEMETRY_LOG(logger, TELEMETRY_LEVEL_ERROR, "link %s down", std::string("eth2"));
+    assert(logger.dropped() == 2);
+
+    std::string format;
+    assert(ring_buffer_pop(rb, &event) == true);
+    append_chunk(event, format, entry);
+    assert(ring_buffer_pop(rb, &event) == true);
+    assert(format_event(event, format, entry) == "link eth1 down");
+
+    ring_buffer_free(rb);
+
+    std::printf("Telemetry :: Test case log full ring is passed. \n");
+}
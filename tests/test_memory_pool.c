@@ -0,0 +1,345 @@
+/**
+ * @file test_memory_pool.c
+ * @brief Unit tests for the fixed block memory pool.
+ *
+ * This file contains test cases for exhaustion, reuse, statistics,
+ * block indices and concurrent use of the memory pool.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "memory_pool.h"
+#include "osal_thread.h"
+
+/* Test cases :
+    1. Exactly block_count blocks can be taken, the next alloc fails and is counted
+    2. Released blocks are reused and statistics follow
+    3. Block indices map to blocks and back, foreign pointers are rejected
+    4. Concurrent alloc and release from several threads never hand out a block twice
+    5. A failed alloc makes other threads return their cached blocks
+*/
+
+#define TEST_THREADS 4
+#define TEST_ROUNDS 20000
+#define TEST_HELD 8
+#define TEST_BLOCKS 256
+
+// Local function prototype declaration
+static void testcase_exhaustion(void);
+static void testcase_reuse(void);
+static void testcase_index(void);
+static void testcase_concurrent(void);
+static void testcase_drain(void);
+
+void test_memory_pool(void);
+
+/**
+ * @brief Main entry point for running memory pool tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_memory_pool()
+{
+    testcase_exhaustion();
+    testcase_reuse();
+    testcase_index();
+    testcase_concurrent();
+    testcase_drain();
+}
+
+/**
+ * @brief Tests that every block can be taken and no more.
+ */
+static void testcase_exhaustion()
+{
+    memory_pool_t* pool;
+    memory_pool_stats_t stats;
+    void* blocks[TEST_BLOCKS];
+
+    assert(memory_pool_init(&pool, 0, 4) == false);
+    assert(memory_pool_init(&pool, 8, 0) == false);
+
+    // More blocks than one magazine holds
+    assert(memory_pool_init(&pool, 20, TEST_BLOCKS) == true);
+    assert(memory_pool_block_size(pool) == 32);
+    assert(memory_pool_block_count(pool) == TEST_BLOCKS);
+
+    for(int index = 0; index < TEST_BLOCKS; index++)
+    {
+        blocks[index] = memory_pool_alloc(pool);
+        assert(blocks[index] != NULL);
+        assert(((uintptr_t)blocks[index] % MEMORY_POOL_BLOCK_ALIGN) == 0);
+        memset(blocks[index], index, memory_pool_block_size(pool));
+    }
+
+    assert(memory_pool_alloc(pool) == NULL);
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == TEST_BLOCKS);
+    assert(stats.high_water == TEST_BLOCKS);
+    assert(stats.failures == 1);
+
+    // No block was handed out twice
+    for(int index = 0; index < TEST_BLOCKS; index++)
+    {
+        assert(((uint8_t*)blocks[index])[31] == (uint8_t)index);
+    }
+
+    memory_pool_free(pool);
+
+    printf("Telemetry :: Test case memory pool exhaustion is passed. \n");
+}
+
+/**
+ * @brief Tests reuse of released blocks and the statistics.
+ */
+static void testcase_reuse()
+{
+    memory_pool_t* pool;
+    memory_pool_stats_t stats;
+    void* blocks[TEST_BLOCKS];
+
+    assert(memory_pool_init(&pool, 64, TEST_BLOCKS) == true);
+
+    for(int round = 0; round < 3; round++)
+    {
+        for(int index = 0; index < TEST_BLOCKS; index++)
+        {
+            blocks[index] = memory_pool_alloc(pool);
+            assert(blocks[index] != NULL);
+        }
+
+        for(int index = 0; index < TEST_BLOCKS; index++)
+        {
+            memory_pool_release(pool, blocks[index]);
+        }
+    }
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0);
+    assert(stats.high_water == TEST_BLOCKS);
+    assert(stats.failures == 0);
+
+    // A block released last comes back first
+    void* block = memory_pool_alloc(pool);
+    memory_pool_release(pool, block);
+    assert(memory_pool_alloc(pool) == block);
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 1);
+
+    memory_pool_free(pool);
+
+    printf("Telemetry :: Test case memory pool reuse is passed. \n");
+}
+
+/**
+ * @brief Tests block indices and pointers that do not belong to the pool.
+ */
+static void testcase_index()
+{
+    memory_pool_t* pool;
+    memory_pool_stats_t stats;
+    uint8_t foreign[64];
+
+    assert(memory_pool_init(&pool, 48, 8) == true);
+
+    uint8_t* block = (uint8_t*)memory_pool_alloc(pool);
+    const uint32_t index = memory_pool_index(pool, block);
+
+    assert(index < 8);
+    assert(memory_pool_block(pool, index) == block);
+    assert(memory_pool_block(pool, 8) == NULL);
+
+    assert(memory_pool_index(pool, block + 1) == MEMORY_POOL_INVALID_INDEX);
+    assert(memory_pool_index(pool, foreign) == MEMORY_POOL_INVALID_INDEX);
+    assert(memory_pool_index(pool, NULL) == MEMORY_POOL_INVALID_INDEX);
+
+    // Foreign and misaligned pointers are not taken in
+    memory_pool_release(pool, foreign);
+    memory_pool_release(pool, block + 1);
+    memory_pool_release(pool, NULL);
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 1);
+
+    memory_pool_release(pool, block);
+    memory_pool_free(pool);
+
+    printf("Telemetry :: Test case memory pool index is passed. \n");
+}
+
+typedef struct churn_arg_s {
+    memory_pool_t* pool;
+    uint8_t tag;
+} churn_arg_t;
+
+static void* churn_worker(void* arg)
+{
+    memory_pool_t* pool = ((churn_arg_t*)arg)->pool;
+    const uint8_t tag = ((churn_arg_t*)arg)->tag;
+    uint8_t* held[TEST_HELD];
+
+    for(int round = 0; round < TEST_ROUNDS; round++)
+    {
+        for(int index = 0; index < TEST_HELD; index++)
+        {
+            held[index] = (uint8_t*)memory_pool_alloc(pool);
+            assert(held[index] != NULL);
+            memset(held[index], tag + index, memory_pool_block_size(pool));
+        }
+
+        // A block handed to two threads would be overwritten by the other
+        for(int index = 0; index < TEST_HELD; index++)
+        {
+            assert(held[index][0] == (uint8_t)(tag + index));
+            assert(held[index][memory_pool_block_size(pool) - 1u] == (uint8_t)(tag + index));
+            memory_pool_release(pool, held[index]);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Tests alloc and release from several threads at once.
+ */
+static void testcase_concurrent()
+{
+    memory_pool_t* pool;
+    memory_pool_stats_t stats;
+    osal_thread_t* threads[TEST_THREADS];
+    churn_arg_t args[TEST_THREADS];
+
+    // Room for every thread's blocks and magazine, so the shared stack never runs dry
+    const size_t block_count = TEST_THREADS * (TEST_HELD + MEMORY_POOL_MAGAZINE_SIZE) + TEST_HELD;
+    assert(memory_pool_init(&pool, 32, block_count) == true);
+
+    for(int index = 0; index < TEST_THREADS; index++)
+    {
+        args[index].pool = pool;
+        args[index].tag = (uint8_t)(index * TEST_HELD);
+        assert(osal_thread_create(&threads[index], churn_worker, &args[index], "test_pool") == 0);
+    }
+
+    for(int index = 0; index < TEST_THREADS; index++)
+    {
+        osal_thread_join(threads[index]);
+        osal_thread_destroy(threads[index]);
+    }
+
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0);
+    assert(stats.failures == 0);
+
+    // Every block is still reachable after the threads cached them
+    for(size_t index = 0; index < block_count; index++)
+    {
+        assert(memory_pool_alloc(pool) != NULL);
+    }
+
+    assert(memory_pool_alloc(pool) == NULL);
+
+    memory_pool_free(pool);
+
+    printf("Telemetry :: Test case memory pool concurrent is passed. \n");
+}
+
+typedef struct drain_arg_s {
+    memory_pool_t* pool;
+    atomic_int step;
+} drain_arg_t;
+
+static void* drain_worker(void* arg)
+{
+    drain_arg_t* drain = (drain_arg_t*)arg;
+    void* held[TEST_HELD];
+
+    for(int index = 0; index < TEST_HELD; index++)
+    {
+        held[index] = memory_pool_alloc(drain->pool);
+    }
+
+    // Leave blocks cached in this thread's magazine, keep one
+    for(int index = 1; index < TEST_HELD; index++)
+    {
+        memory_pool_release(drain->pool, held[index]);
+    }
+
+    atomic_store(&drain->step, 1);
+
+    while(atomic_load(&drain->step) != 2)
+    {
+    }
+
+    // The next call returns the cached blocks
+    memory_pool_release(drain->pool, held[0]);
+
+    atomic_store(&drain->step, 3);
+
+    while(atomic_load(&drain->step) != 4)
+    {
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Tests that cached blocks come back after a failed alloc.
+ */
+static void testcase_drain()
+{
+    drain_arg_t drain;
+    osal_thread_t* thread;
+    memory_pool_stats_t stats;
+    const size_t block_count = 2u * MEMORY_POOL_MAGAZINES * TEST_HELD;
+    size_t taken = 0;
+
+    assert(memory_pool_init(&drain.pool, 16, block_count) == true);
+    atomic_init(&drain.step, 0);
+
+    assert(osal_thread_create(&thread, drain_worker, &drain, "test_drain") == 0);
+
+    while(atomic_load(&drain.step) != 1)
+    {
+    }
+
+    while(memory_pool_alloc(drain.pool) != NULL)
+    {
+        taken++;
+    }
+
+    // Some blocks were still cached by the worker
+    assert(taken < block_count);
+
+    atomic_store(&drain.step, 2);
+
+    while(atomic_load(&drain.step) != 3)
+    {
+    }
+
+    while(memory_pool_alloc(drain.pool) != NULL)
+    {
+        taken++;
+    }
+
+    assert(taken == block_count);
+
+    memory_pool_stats(drain.pool, &stats);
+    assert(stats.failures == 2);
+    assert(stats.in_use == block_count);
+
+    atomic_store(&drain.step, 4);
+    osal_thread_join(thread);
+    osal_thread_destroy(thread);
+
+    memory_pool_free(drain.pool);
+
+    printf("Telemetry :: Test case memory pool drain is passed. \n");
+}
@@ -0,0 +1,241 @@
+/**
+ * @file test_metrics.c
+ * @brief Unit tests for the telemetry metrics registry.
+ *
+ * This file contains test cases for counters, gauges and histograms, the
+ * metrics batch encoding, splitting of large snapshots and registration
+ * from several threads.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "metrics.h"
+#include "osal_thread.h"
+
+/* Test cases :
+    1. Register metrics, duplicate ids and full registry
+    2. Encode and decode counters, gauges and histograms
+    3. Snapshot split over several payloads
+    4. Threads registering the same ids at once share one slot per id
+*/
+
+// Threads and ids of the concurrent registration test
+#define TEST_REGISTER_THREADS 4
+#define TEST_REGISTER_IDS 1024u
+
+// Local function prototype declaration
+static void testcase_register(void);
+static void testcase_encode_decode(void);
+static void testcase_split_payload(void);
+static void testcase_concurrent_register(void);
+
+void test_metrics(void);
+
+/**
+ * @brief Main entry point for running telemetry metrics tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_metrics()
+{
+    testcase_register();
+    testcase_encode_decode();
+    testcase_split_payload();
+    testcase_concurrent_register();
+}
+
+/**
+ * @brief Tests metric registration rules.
+ */
+static void testcase_register()
+{
+    telemetry_metrics_t* metrics;
+
+    assert(telemetry_metrics_init(&metrics, 2) == true);
+
+    telemetry_metric_t* counter = telemetry_metrics_register(metrics, 10, TELEMETRY_METRIC_COUNTER);
+    assert(counter != NULL);
+
+    // Same id and type returns the same handle, another type is rejected
+    assert(telemetry_metrics_register(metrics, 10, TELEMETRY_METRIC_COUNTER) == counter);
+    assert(telemetry_metrics_register(metrics, 10, TELEMETRY_METRIC_GAUGE) == NULL);
+
+    assert(telemetry_metrics_register(metrics, 11, TELEMETRY_METRIC_GAUGE) != NULL);
+
+    // Registry is full
+    assert(telemetry_metrics_register(metrics, 12, TELEMETRY_METRIC_COUNTER) == NULL);
+    assert(telemetry_metrics_count(metrics) == 2);
+
+    telemetry_metrics_free(metrics);
+
+    printf("Telemetry :: Test case metrics register is passed. \n");
+}
+
+/**
+ * @brief Tests that encoded metrics decode to the recorded values.
+ */
+static void testcase_encode_decode()
+{
+    telemetry_metrics_t* metrics;
+    uint8_t buffer[512];
+    size_t cursor = 0;
+    uint16_t record_count = 0;
+    telemetry_metric_record_t record;
+
+    assert(telemetry_metrics_init(&metrics, 8) == true);
+
+    telemetry_metric_t* counter = telemetry_metrics_register(metrics, 1, TELEMETRY_METRIC_COUNTER);
+    telemetry_metric_t* gauge = telemetry_metrics_register(metrics, 2, TELEMETRY_METRIC_GAUGE);
+    telemetry_metric_t* histogram = telemetry_metrics_register(metrics, 3, TELEMETRY_METRIC_HISTOGRAM);
+
+    for(int index = 0; index < 1000; index++)
+    {
+        telemetry_metric_add(counter, 2);
+    }
+
+    telemetry_metric_set(gauge, -42);
+
+    telemetry_metric_record(histogram, 0);
+    telemetry_metric_record(histogram, 5);
+    telemetry_metric_record(histogram, 6);
+    telemetry_metric_record(histogram, 1000);
+
+    size_t length = telemetry_metrics_encode(metrics, buffer, sizeof(buffer), &cursor);
+    assert(length > 0);
+    assert(cursor == 3);
+
+    // Nothing left for a second payload
+    assert(telemetry_metrics_encode(metrics, buffer + length, sizeof(buffer) - length, &cursor) == 0);
+
+    size_t position = telemetry_metrics_decode_count(&record_count, buffer, length);
+    assert(record_count == 3);
+
+    position += telemetry_metrics_decode_record(&record, buffer + position, length - position);
+    assert(record.type == TELEMETRY_METRIC_COUNTER && record.metric_id == 1 && record.counter == 2000);
+
+    position += telemetry_metrics_decode_record(&record, buffer + position, length - position);
+    assert(record.type == TELEMETRY_METRIC_GAUGE && record.metric_id == 2 && record.gauge == -42);
+
+    position += telemetry_metrics_decode_record(&record, buffer + position, length - position);
+    assert(record.type == TELEMETRY_METRIC_HISTOGRAM && record.metric_id == 3);
+    assert(record.histogram.count == 4 && record.histogram.sum == 1011);
+    assert(record.histogram.min == 0 && record.histogram.max == 1000);
+
+    // Small values are exact, 1000 lands in its log-linear bucket
+    assert(record.histogram.buckets[0] == 1 && record.histogram.buckets[5] == 1 && record.histogram.buckets[6] == 1);
+    assert(record.histogram.buckets[telemetry_histogram_bucket_index(1000)] == 1);
+
+    assert(position == length);
+
+    telemetry_metrics_free(metrics);
+
+    printf("Telemetry :: Test case metrics encode decode is passed. \n");
+}
+
+/**
+ * @brief Tests that a snapshot larger than one payload is split.
+ */
+static void testcase_split_payload()
+{
+    telemetry_metrics_t* metrics;
+    uint8_t buffer[32];
+    size_t cursor = 0;
+    size_t total = 0;
+    int payloads = 0;
+
+    assert(telemetry_metrics_init(&metrics, 20) == true);
+
+    for(uint32_t id = 0; id < 20; id++)
+    {
+        telemetry_metric_add(telemetry_metrics_register(metrics, 1000 + id, TELEMETRY_METRIC_COUNTER), 100000);
+    }
+
+    while(telemetry_metrics_encode(metrics, buffer, sizeof(buffer), &cursor) > 0)
+    {
+        uint16_t record_count = 0;
+        telemetry_metrics_decode_count(&record_count, buffer, sizeof(buffer));
+        total += record_count;
+        payloads++;
+    }
+
+    assert(total == 20);
+    assert(payloads > 1);
+
+    telemetry_metrics_free(metrics);
+
+    printf("Telemetry :: Test case metrics split payload is passed. \n");
+}
+
+// Shared by the registration threads
+typedef struct {
+    telemetry_metrics_t* metrics;
+    atomic_int* ready;
+    telemetry_metric_t* handles[TEST_REGISTER_IDS];
+} register_worker_t;
+
+static void* register_worker(void* arg)
+{
+    register_worker_t* worker = (register_worker_t*)arg;
+
+    // Start together to widen the race
+    atomic_fetch_add_explicit(worker->ready, 1, memory_order_acq_rel);
+    while(atomic_load_explicit(worker->ready, memory_order_acquire) < TEST_REGISTER_THREADS)
+    {
+    }
+
+    for(uint32_t id = 0; id < TEST_REGISTER_IDS; id++)
+    {
+        // Every third id is a histogram, allocated before its slot is claimed
+        const telemetry_metric_type_t type = ((id % 3u) == 0) ? TELEMETRY_METRIC_HISTOGRAM : TELEMETRY_METRIC_COUNTER;
+
+        worker->handles[id] = telemetry_metrics_register(worker->metrics, 100u + id, type);
+        assert(worker->handles[id] != NULL);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Tests registrations of the same ids from several threads.
+ */
+static void testcase_concurrent_register()
+{
+    static register_worker_t workers[TEST_REGISTER_THREADS];
+    osal_thread_t* threads[TEST_REGISTER_THREADS];
+    telemetry_metrics_t* metrics;
+    atomic_int ready;
+
+    assert(telemetry_metrics_init(&metrics, TEST_REGISTER_IDS) == true);
+    atomic_init(&ready, 0);
+
+    for(int index = 0; index < TEST_REGISTER_THREADS; index++)
+    {
+        workers[index].metrics = metrics;
+        workers[index].ready = &ready;
+        assert(osal_thread_create(&threads[index], register_worker, &workers[index], "test_register") == 0);
+    }
+
+    for(int index = 0; index < TEST_REGISTER_THREADS; index++)
+    {
+        osal_thread_join(threads[index]);
+        osal_thread_destroy(threads[index]);
+    }
+
+    // One slot per id, and every thread got it : a full registry means no duplicate was claimed
+    assert(telemetry_metrics_count(metrics) == TEST_REGISTER_IDS);
+
+    for(uint32_t id = 0; id < TEST_REGISTER_IDS; id++)
+    {
+        for(int index = 1; index < TEST_REGISTER_THREADS; index++)
+            assert(workers[index].handles[id] == workers[0].handles[id]);
+    }
+
+    telemetry_metrics_free(metrics);
+
+    printf("Telemetry :: Test case metrics concurrent register is passed. \n");
+}
@@ -0,0 +1,204 @@
+/**
+ * @file test_poll.c
+ * @brief Unit tests for the OSAL poller.
+ *
+ * This file contains test cases for watching pipes, wakeup objects and
+ * timers with one poller.
+ * @author Aravinthraj Ganesan
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "osal_poll.h"
+#include "osal_thread.h"
+#include "osal_wakeup.h"
+#include "static_storage.h"
+
+/* Test cases :
+    1. Pipe ends are reported readable and writable, modify and remove take effect
+    2. An eventfd wakeup and a timer are waited on together through their descriptors
+    3. A poller runs from caller storage and refuses bad arguments
+*/
+
+// 1 ms in nanoseconds
+#define TEST_POLL_MS 1000000ull
+
+// Local function prototype declaration
+static void testcase_pipe(void);
+static void testcase_wakeup_and_timer(void);
+static void testcase_static_and_arguments(void);
+
+void test_poll(void);
+
+/**
+ * @brief Main entry point for running poller tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_poll()
+{
+    testcase_pipe();
+    testcase_wakeup_and_timer();
+    testcase_static_and_arguments();
+}
+
+static uint64_t clock_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Tests readable and writable pipe ends.
+ */
+static void testcase_pipe()
+{
+    osal_poll_event_t events[4];
+    int fds[2];
+    char byte = 'x';
+    int read_context = 0;
+    int write_context = 0;
+
+    assert(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0);
+
+    osal_poller_t* poller = osal_poller_create();
+    assert(poller != NULL);
+
+    assert(osal_poller_add(poller, fds[0], OSAL_POLL_READABLE, &read_context) == true);
+    assert(osal_poller_add(poller, fds[0], OSAL_POLL_READABLE, &read_context) == false);
+
+    // Empty pipe : nothing to read, the wait times out
+    const uint64_t start_ns = clock_monotonic_ns();
+    assert(osal_poller_wait(poller, events, 4, 5u * TEST_POLL_MS) == 0);
+    assert(clock_monotonic_ns() - start_ns >= 5u * TEST_POLL_MS);
+
+    // Data to read, reported until it is read
+    assert(write(fds[1], &byte, 1) == 1);
+
+    for(int round = 0; round < 2; round++)
+    {
+        assert(osal_poller_wait(poller, events, 4, 0) == 1);
+        assert(events[0].context == &read_context);
+        assert(events[0].events == OSAL_POLL_READABLE);
+    }
+
+    assert(read(fds[0], &byte, 1) == 1);
+    assert(osal_poller_wait(poller, events, 4, 0) == 0);
+
+    // The write end has room, then is switched to errors only
+    assert(osal_poller_add(poller, fds[1], OSAL_POLL_WRITABLE, &write_context) == true);
+    assert(osal_poller_wait(poller, events, 4, 0) == 1);
+    assert(events[0].context == &write_context);
+    assert(events[0].events == OSAL_POLL_WRITABLE);
+
+    assert(osal_poller_modify(poller, fds[1], 0, &write_context) == true);
+    assert(osal_poller_wait(poller, events, 4, 0) == 0);
+
+    // Removed descriptors are no longer reported
+    assert(write(fds[1], &byte, 1) == 1);
+    assert(osal_poller_remove(poller, fds[0]) == true);
+    assert(osal_poller_remove(poller, fds[0]) == false);
+    assert(osal_poller_wait(poller, events, 4, 0) == 0);
+
+    // Closing the read end hangs up the write end
+    close(fds[0]);
+    assert(osal_poller_wait(poller, events, 4, 0) == 1);
+    assert((events[0].events & OSAL_POLL_ERROR) != 0);
+
+    osal_poller_destroy(poller);
+    close(fds[1]);
+
+    printf("Telemetry :: Test case poll pipe is passed. \n");
+}
+
+/**
+ * @brief Tests a wakeup object and a timer in one poller.
+ */
+static void testcase_wakeup_and_timer()
+{
+    osal_poll_event_t events[4];
+    osal_wakeup_t* wakeup = osal_wakeup_create_ex(OSAL_WAKEUP_BACKEND_EVENTFD);
+    osal_wakeup_t* futex = osal_wakeup_create_ex(OSAL_WAKEUP_BACKEND_FUTEX);
+    osal_timer_t* timer = osal_timer_create();
+    osal_poller_t* poller = osal_poller_create();
+
+    assert(wakeup != NULL && futex != NULL && timer != NULL && poller != NULL);
+
+    // The futex word has no descriptor
+    assert(osal_wakeup_fd(futex) < 0);
+    assert(osal_wakeup_fd(NULL) < 0);
+    assert(osal_timer_fd(NULL) < 0);
+
+    assert(osal_poller_add(poller, osal_wakeup_fd(wakeup), OSAL_POLL_READABLE, wakeup) == true);
+    assert(osal_poller_add(poller, osal_timer_fd(timer), OSAL_POLL_READABLE, timer) == true);
+
+    // A notification, consumed by a zero timeout wait on the wakeup
+    osal_wakeup_notify(wakeup);
+    assert(osal_poller_wait(poller, events, 4, OSAL_WAIT_FOREVER) == 1);
+    assert(events[0].context == wakeup);
+    assert(osal_wakeup_wait_timeout(wakeup, 0) == true);
+    assert(osal_poller_wait(poller, events, 4, 0) == 0);
+
+    // A timer shorter than a millisecond ends a wait that has no timeout
+    const uint64_t start_ns = clock_monotonic_ns();
+    assert(osal_timer_start(timer, 200000ull, 0) == true);
+    assert(osal_poller_wait(poller, events, 4, OSAL_WAIT_FOREVER) == 1);
+    assert(events[0].context == timer);
+    assert(clock_monotonic_ns() - start_ns >= 200000ull);
+    assert(osal_timer_expirations(timer) == 1);
+
+    // Both ready at once
+    assert(osal_timer_start(timer, 0, 0) == true);
+    osal_wakeup_notify(wakeup);
+    osal_thread_sleep_ns(TEST_POLL_MS);
+    assert(osal_poller_wait(poller, events, 4, 0) == 2);
+    assert(events[0].context != events[1].context);
+
+    osal_poller_destroy(poller);
+    osal_timer_destroy(timer);
+    osal_wakeup_destroy(futex);
+    osal_wakeup_destroy(wakeup);
+
+    printf("Telemetry :: Test case poll wakeup and timer is passed. \n");
+}
+
+/**
+ * @brief Tests caller storage and argument checks.
+ */
+static void testcase_static_and_arguments()
+{
+    static TELEMETRY_STORAGE(poller_memory, OSAL_POLLER_STORAGE_BYTES);
+    osal_poll_event_t events[1];
+
+    assert(osal_poller_create_static(poller_memory, sizeof(poller_memory) - 1u) == NULL);
+    assert(osal_poller_create_static(NULL, sizeof(poller_memory)) == NULL);
+
+    osal_poller_t* poller = osal_poller_create_static(poller_memory, sizeof(poller_memory));
+    assert(poller == (osal_poller_t*)poller_memory);
+
+    assert(osal_poller_add(poller, -1, OSAL_POLL_READABLE, NULL) == false);
+    assert(osal_poller_add(NULL, 0, OSAL_POLL_READABLE, NULL) == false);
+    assert(osal_poller_modify(poller, -1, OSAL_POLL_READABLE, NULL) == false);
+    assert(osal_poller_remove(NULL, 0) == false);
+    assert(osal_poller_wait(poller, NULL, 1, 0) == -1);
+    assert(osal_poller_wait(poller, events, 0, 0) == -1);
+    assert(osal_poller_wait(NULL, events, 1, 0) == -1);
+
+    // Nothing watched : a plain timeout
+    assert(osal_poller_wait(poller, events, 1, 0) == 0);
+
+    osal_poller_destroy(poller);
+    osal_poller_destroy(NULL);
+
+    printf("Telemetry :: Test case poll static and arguments is passed. \n");
+}
@@ -0,0 +1,171 @@
+/**
+ * @file test_protocol.c
+ * @brief Unit tests for the telemetry wire protocol helpers.
+ *
+ * This file contains test cases for header and heartbeat encoding,
+ * decoding, byte order and error conditions.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "telemetry_protocol.h"
+
+/* Test cases :
+    1. Header encode/decode round trip and big-endian layout
+    2. Header decode rejects bad magic
+    3. Heartbeat encode/decode round trip
+    4. Event fragment encode/decode round trip, fragments past the payload are rejected
+*/
+
+// Local function prototype declaration
+static void testcase_header_round_trip(void);
+static void testcase_header_bad_magic(void);
+static void testcase_heartbeat_round_trip(void);
+static void testcase_event_fragment_round_trip(void);
+
+void test_protocol(void);
+
+/**
+ * @brief Main entry point for running telemetry protocol tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_protocol()
+{
+    testcase_header_round_trip();
+    testcase_header_bad_magic();
+    testcase_heartbeat_round_trip();
+    testcase_event_fragment_round_trip();
+}
+
+/**
+ * @brief Tests that an encoded header decodes to the same values.
+ *
+ * Also checks the magic value is written most significant byte first.
+ */
+static void testcase_header_round_trip()
+{
+    uint8_t buffer[64];
+    telemetry_header_t header, decoded;
+
+    telemetry_header_v1_make(&header, TELEMETRY_EVENT_BATCH, 0x01020304u, 0x1122334455667788ull, 16);
+
+    // Header plus the announced payload must fit in the buffer on decode
+    assert(telemetry_encode_header_v1(buffer, sizeof(buffer), &header) == telemetry_header_v1_length());
+
+    // "TEL1" on the wire
+    assert(buffer[0] == 'T' && buffer[1] == 'E' && buffer[2] == 'L' && buffer[3] == '1');
+
+    assert(telemetry_decode_header_v1(&decoded, buffer, sizeof(buffer)) == TELEM_RC_OK);
+    assert(decoded.message_type == TELEMETRY_EVENT_BATCH);
+    assert(decoded.sequence_counter == 0x01020304u);
+    assert(decoded.timestamp_monotonic_ns == 0x1122334455667788ull);
+    assert(decoded.payload_len == 16);
+
+    // Too small output buffer is rejected
+    assert(telemetry_encode_header_v1(buffer, telemetry_header_v1_length() - 1, &header) == 0);
+
+    printf("Telemetry :: Test case header round trip is passed. \n");
+}
+
+/**
+ * @brief Tests that a buffer without the protocol magic is rejected.
+ */
+static void testcase_header_bad_magic()
+{
+    uint8_t buffer[64];
+    telemetry_header_t decoded;
+
+    memset(buffer, 0x00, sizeof(buffer));
+    assert(telemetry_decode_header_v1(&decoded, buffer, sizeof(buffer)) == TELEM_RC_ERR_MAGIC);
+
+    // Truncated input
+    assert(telemetry_decode_header_v1(&decoded, buffer, 8) == TELEM_RC_ERR_TRUNC);
+
+    printf("Telemetry :: Test case header bad magic is passed. \n");
+}
+
+/**
+ * @brief Tests heartbeat payload encoding and decoding.
+ */
+static void testcase_heartbeat_round_trip()
+{
+    uint8_t buffer[TELEMETRY_HEARTBEAT_PAYLOAD_LEN];
+    telemetry_heartbeat_t heartbeat, decoded;
+
+    heartbeat.uptime_ns = 5000000000ull;
+    heartbeat.sent_count = 1234;
+    heartbeat.wakeup_count = 99;
+    heartbeat.ring_dropped = 7;
+    heartbeat.transport_error_count = 3;
+    heartbeat.ring_count = 12;
+    heartbeat.ring_capacity = 1024;
+
+    assert(telemetry_encode_heartbeat_v1(buffer, sizeof(buffer), &heartbeat) == TELEMETRY_HEARTBEAT_PAYLOAD_LEN);
+    assert(telemetry_decode_heartbeat_v1(&decoded, buffer, sizeof(buffer)) == TELEM_RC_OK);
+
+    assert(decoded.uptime_ns == heartbeat.uptime_ns);
+    assert(decoded.sent_count == heartbeat.sent_count);
+    assert(decoded.wakeup_count == heartbeat.wakeup_count);
+    assert(decoded.ring_dropped == heartbeat.ring_dropped);
+    assert(decoded.transport_error_count == heartbeat.transport_error_count);
+    assert(decoded.ring_count == heartbeat.ring_count);
+    assert(decoded.ring_capacity == heartbeat.ring_capacity);
+
+    // Short buffers are rejected both ways
+    assert(telemetry_encode_heartbeat_v1(buffer, sizeof(buffer) - 1, &heartbeat) == 0);
+    assert(telemetry_decode_heartbeat_v1(&decoded, buffer, sizeof(buffer) - 1) == TELEM_RC_ERR_TRUNC);
+
+    printf("Telemetry :: Test case heartbeat round trip is passed. \n");
+}
+
+/**
+ * @brief Tests event fragment payload encoding and decoding.
+ */
+static void testcase_event_fragment_round_trip()
+{
+    uint8_t buffer[TELEMETRY_EVENT_FRAGMENT_HEADER_LEN + 16];
+    const uint8_t data[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    telemetry_event_fragment_t fragment, decoded;
+
+    fragment.event_id = 77;
+    fragment.transfer_id = 0x01020304u;
+    fragment.timestamp_ns = 0x1122334455667788ull;
+    fragment.payload_len = 40;
+    fragment.fragment_offset = 24;
+    fragment.level = 3;
+    fragment.data = data;
+    fragment.data_length = sizeof(data);
+
+    assert(telemetry_encode_event_fragment_v1(buffer, sizeof(buffer), &fragment) == sizeof(buffer));
+
+    // Event id first, most significant byte first
+    assert(buffer[0] == 0 && buffer[3] == 77);
+
+    assert(telemetry_decode_event_fragment_v1(&decoded, buffer, sizeof(buffer)) == TELEM_RC_OK);
+    assert(decoded.event_id == fragment.event_id);
+    assert(decoded.transfer_id == fragment.transfer_id);
+    assert(decoded.timestamp_ns == fragment.timestamp_ns);
+    assert(decoded.payload_len == fragment.payload_len);
+    assert(decoded.fragment_offset == fragment.fragment_offset);
+    assert(decoded.level == fragment.level);
+    assert(decoded.data_length == sizeof(data));
+    assert(memcmp(decoded.data, data, sizeof(data)) == 0);
+
+    // Short buffers are rejected both ways
+    assert(telemetry_encode_event_fragment_v1(buffer, sizeof(buffer) - 1, &fragment) == 0);
+    assert(telemetry_decode_event_fragment_v1(&decoded, buffer, TELEMETRY_EVENT_FRAGMENT_HEADER_LEN - 1) == TELEM_RC_ERR_TRUNC);
+
+    // A fragment reaching past the payload is neither written nor accepted
+    fragment.fragment_offset = 25;
+    assert(telemetry_encode_event_fragment_v1(buffer, sizeof(buffer), &fragment) == 0);
+
+    buffer[23] = 25;
+    assert(telemetry_decode_event_fragment_v1(&decoded, buffer, sizeof(buffer)) == TELEM_RC_ERR_RANGE);
+
+    printf("Telemetry :: Test case event fragment round trip is passed. \n");
+}
@@ -18,6 +18,8 @@
     3. Test the FIFO order and test count consistency
     4. Test the wrap aroud/ ring buffer and Dropout when the ring buffer is full
     5. SPSC thread stress test
+    6. A ring in caller storage works like an allocated one and refuses bad storage
+    7. Mapped slots with every memory option work, refused options fall back, the slots can move to another node
 */
 
 // Local function prototype declaration
@@ -26,6 +28,8 @@ static void testcase_single_push_pop(void);
 static void testcase_fifo_check(void);
 static void testcase_wraparound_check(void);
 static void testcase_spsc_stress(void);
+static void testcase_static_storage(void);
+static void testcase_mapped_slots(void);
 
 void test_ring_buffer(void);
 
@@ -42,6 +46,8 @@ void test_ring_buffer()
     testcase_single_push_pop();
     testcase_fifo_check();
     testcase_wraparound_check();
+    testcase_static_storage();
+    testcase_mapped_slots();
 }
 
 /**
@@ -218,4 +224,119 @@ static void testcase_wraparound_check()
 static void testcase_spsc_stress()
 {
 
-}
\ No newline at end of file
+}
+/**
+ * @brief Tests a ring buffer placed in caller storage.
+ *
+ * Fills and drains a ring in a static array, checks that too small or
+ * misaligned storage is refused and that the storage is reusable.
+ */
+static void testcase_static_storage()
+{
+    static TELEMETRY_STORAGE(memory, RING_BUFFER_STORAGE_BYTES(4));
+    ring_buffer_t* rb;
+    telemetry_event_t event;
+
+    // Storage that is too small or not aligned
+    assert(ring_buffer_init_static(&rb, memory, sizeof(memory) - 1u, 4) == false);
+    assert(ring_buffer_init_static(&rb, memory + 8, sizeof(memory) - 8u, 1) == false);
+    assert(ring_buffer_init_static(&rb, NULL, sizeof(memory), 4) == false);
+    assert(ring_buffer_init_static(&rb, memory, sizeof(memory), 0) == false);
+
+    assert(ring_buffer_init_static(&rb, memory, sizeof(memory), 4) == true);
+    assert(ring_buffer_capacity(rb) == 4);
+
+    for(uint32_t index = 0; index < 5; index++)
+    {
+        telemetry_event_make(&event, index, NULL, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(rb, &event) == (index < 4));
+    }
+
+    assert(ring_buffer_dropped(rb) == 1);
+
+    for(uint32_t index = 0; index < 4; index++)
+    {
+        assert(ring_buffer_pop(rb, &event) == true);
+        assert(event.event_id == index);
+    }
+
+    ring_buffer_free(rb);
+
+    // A fresh ring in the same storage
+    assert(ring_buffer_init_static(&rb, memory, sizeof(memory), 2) == true);
+    assert(ring_buffer_count(rb) == 0 && ring_buffer_dropped(rb) == 0);
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case ring buffer static storage is passed. \n");
+}
+
+/**
+ * @brief Tests a ring whose slots come from osal_memory_map.
+ *
+ * Huge pages, locking and NUMA binding depend on the system, so only the
+ * options that always apply are checked; the ring must work either way.
+ */
+static void testcase_mapped_slots()
+{
+    ring_buffer_t* rb;
+    ring_buffer_options_t options;
+    telemetry_event_t event;
+
+    // Without memory flags the slots are allocated as usual
+    ring_buffer_options_init(&options);
+    assert(ring_buffer_init_ex(&rb, 8, &options) == true);
+    assert(ring_buffer_memory_flags(rb) == 0);
+    ring_buffer_free(rb);
+
+    assert(ring_buffer_init_ex(&rb, 8, NULL) == true);
+    ring_buffer_free(rb);
+
+    options.memory_flags = OSAL_MEMORY_HUGE_PAGES | OSAL_MEMORY_PREFAULT | OSAL_MEMORY_LOCK | OSAL_MEMORY_NUMA_BIND;
+    assert(ring_buffer_init_ex(&rb, 0, &options) == false);
+    assert(ring_buffer_init_ex(&rb, 1000, &options) == true);
+    assert(ring_buffer_capacity(rb) == 1000);
+    assert((ring_buffer_memory_flags(rb) & OSAL_MEMORY_PREFAULT) != 0);
+
+    for(uint32_t round = 0; round < 3; round++)
+    {
+        for(uint32_t index = 0; index < 1000; index++)
+        {
+            telemetry_event_make(&event, index, &round, sizeof(round), TELEMETRY_LEVEL_INFO);
+            assert(ring_buffer_push(rb, &event) == true);
+        }
+
+        assert(ring_buffer_push(rb, &event) == false);
+
+        for(uint32_t index = 0; index < 1000; index++)
+        {
+            assert(ring_buffer_pop(rb, &event) == true);
+            assert(event.event_id == index && event.payload[0] == round);
+        }
+    }
+
+    ring_buffer_free(rb);
+
+    // A node that does not exist is skipped, the ring still works
+    options.memory_flags = OSAL_MEMORY_NUMA_BIND;
+    options.numa_node = 1000;
+    assert(ring_buffer_init_ex(&rb, 4, &options) == true);
+    assert((ring_buffer_memory_flags(rb) & OSAL_MEMORY_NUMA_BIND) == 0);
+
+    // Moving the slots later keeps the events, a missing node is refused
+    telemetry_event_make(&event, 7, NULL, 0, TELEMETRY_LEVEL_INFO);
+    assert(ring_buffer_push(rb, &event) == true);
+    assert(ring_buffer_bind_node(rb, 1000) == false);
+
+    if(ring_buffer_bind_node(rb, OSAL_MEMORY_NODE_LOCAL))
+        assert((ring_buffer_memory_flags(rb) & OSAL_MEMORY_NUMA_BIND) != 0);
+
+    assert(ring_buffer_pop(rb, &event) == true && event.event_id == 7);
+    ring_buffer_free(rb);
+
+    // Slots that are not mapped cannot move
+    assert(ring_buffer_init(&rb, 4) == true);
+    assert(ring_buffer_bind_node(rb, OSAL_MEMORY_NODE_LOCAL) == false);
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case ring buffer mapped slots is passed. \n");
+}
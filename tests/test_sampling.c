@@ -0,0 +1,299 @@
+/**
+ * @file test_sampling.c
+ * @brief Unit tests for event sampling and rate limiting.
+ *
+ * This file contains test cases for 1-in-N and probabilistic sampling,
+ * the token bucket, its achieved rate and the suppressed event counters.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "telemetry_emit.h"
+
+/* Test cases :
+    1. One in N keeps every n-th emit and counts the rest
+    2. Probabilistic sampling keeps about the requested share
+    3. The token bucket passes a burst, then suppresses until it refills
+    4. Suppressed counts are published as metrics, also for all ids at once, invalid policies are rejected
+    5. A fast token bucket keeps its configured rate over a window
+*/
+
+// Rate and window of the achieved rate test, 2000 events expected
+#define TEST_SAMPLING_RATE 20000u
+#define TEST_SAMPLING_WINDOW_NS 100000000ull
+
+// Local function prototype declaration
+static void testcase_one_in_n(void);
+static void testcase_probability(void);
+static void testcase_token_bucket(void);
+static void testcase_metrics_and_limits(void);
+static void testcase_token_bucket_rate(void);
+
+void test_sampling(void);
+
+/**
+ * @brief Main entry point for running sampling tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_sampling()
+{
+    testcase_one_in_n();
+    testcase_probability();
+    testcase_token_bucket();
+    testcase_metrics_and_limits();
+    testcase_token_bucket_rate();
+}
+
+/**
+ * @brief Tests one in N sampling through the emit macro.
+ */
+static void testcase_one_in_n()
+{
+    ring_buffer_t* rb;
+    telemetry_event_t event;
+    telemetry_sampling_policy_t policy;
+    uint32_t value = 0;
+
+    assert(ring_buffer_init(&rb, 16) == true);
+
+    telemetry_sampling_policy_init(&policy);
+    policy.one_in_n = 4;
+    assert(telemetry_event_sampling_set(300, &policy) == true);
+
+    for(value = 0; value < 12; value++)
+    {
+        TELEMETRY_EMIT_ERROR(rb, NULL, 300, &value, sizeof(value));
+    }
+
+    // The first, fifth and ninth emit pass
+    assert(ring_buffer_count(rb) == 3);
+    for(uint32_t expected = 0; expected < 12; expected += 4)
+    {
+        assert(ring_buffer_pop(rb, &event) == true);
+        assert(*(const uint32_t*)event.payload == expected);
+    }
+    assert(telemetry_event_sampling_suppressed(300) == 9);
+
+    // Removing the policy keeps everything again, the count stays
+    assert(telemetry_event_sampling_set(300, NULL) == true);
+    for(value = 0; value < 5; value++)
+    {
+        TELEMETRY_EMIT_ERROR(rb, NULL, 300, &value, sizeof(value));
+    }
+    assert(ring_buffer_count(rb) == 5);
+    assert(telemetry_event_sampling_suppressed(300) == 9);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case sampling one in n is passed. \n");
+}
+
+/**
+ * @brief Tests probabilistic sampling.
+ */
+static void testcase_probability()
+{
+    telemetry_sampling_policy_t policy;
+    uint32_t kept = 0;
+
+    telemetry_sampling_policy_init(&policy);
+    policy.probability = 0.25;
+    assert(telemetry_event_sampling_set(301, &policy) == true);
+
+    for(int index = 0; index < 40000; index++)
+    {
+        if(telemetry_event_sampling_keep(301))
+            kept++;
+    }
+
+    // 10000 expected, a 5 sigma band is about +-430
+    assert(kept > 9500 && kept < 10500);
+    assert(telemetry_event_sampling_suppressed(301) == 40000u - kept);
+
+    // Zero suppresses everything, one keeps everything
+    policy.probability = 0.0;
+    assert(telemetry_event_sampling_set(301, &policy) == true);
+    assert(telemetry_event_sampling_keep(301) == false);
+
+    policy.probability = 1.0;
+    assert(telemetry_event_sampling_set(301, &policy) == true);
+    assert(telemetry_event_sampling_keep(301) == true);
+
+    printf("Telemetry :: Test case sampling probability is passed. \n");
+}
+
+/**
+ * @brief Tests the token bucket.
+ */
+static void testcase_token_bucket()
+{
+    telemetry_sampling_policy_t policy;
+    uint32_t kept = 0;
+
+    // One token per second, so the test can not refill it in time
+    telemetry_sampling_policy_init(&policy);
+    policy.rate_per_second = 1;
+    policy.burst = 10;
+    assert(telemetry_event_sampling_set(302, &policy) == true);
+
+    for(int index = 0; index < 100; index++)
+    {
+        if(telemetry_event_sampling_keep(302))
+            kept++;
+    }
+
+    assert(kept == 10);
+    assert(telemetry_event_sampling_suppressed(302) == 90);
+
+    // A fast rate refills within a few milliseconds
+    policy.rate_per_second = 100000;
+    policy.burst = 1;
+    assert(telemetry_event_sampling_set(302, &policy) == true);
+    assert(telemetry_event_sampling_keep(302) == true);
+
+    struct timespec pause = { 0, 20000000 };
+    nanosleep(&pause, NULL);
+    assert(telemetry_event_sampling_keep(302) == true);
+
+    // Sampling runs first, only kept events take tokens
+    policy.one_in_n = 2;
+    policy.rate_per_second = 1;
+    policy.burst = 2;
+    assert(telemetry_event_sampling_set(302, &policy) == true);
+
+    kept = 0;
+    for(int index = 0; index < 4; index++)
+    {
+        if(telemetry_event_sampling_keep(302))
+            kept++;
+    }
+    assert(kept == 2);
+
+    printf("Telemetry :: Test case sampling token bucket is passed. \n");
+}
+
+/**
+ * @brief Tests the suppressed counter metric and invalid policies.
+ */
+static void testcase_metrics_and_limits()
+{
+    telemetry_metrics_t* metrics;
+    telemetry_sampling_policy_t policy;
+    telemetry_metric_record_t record;
+    uint8_t buffer[1024];
+    uint16_t record_count = 0;
+    size_t cursor = 0;
+
+    assert(telemetry_metrics_init(&metrics, 4) == true);
+
+    // No policy yet, nothing to publish
+    assert(telemetry_event_sampling_register_metric(metrics, 303, 9) == false);
+
+    telemetry_sampling_policy_init(&policy);
+    policy.one_in_n = 3;
+    assert(telemetry_event_sampling_set(303, &policy) == true);
+    assert(telemetry_event_sampling_register_metric(metrics, 303, 9) == true);
+
+    for(int index = 0; index < 6; index++)
+    {
+        (void)telemetry_event_sampling_keep(303);
+    }
+
+    const size_t length = telemetry_metrics_encode(metrics, buffer, sizeof(buffer), &cursor);
+    const size_t position = telemetry_metrics_decode_count(&record_count, buffer, length);
+    assert(record_count == 1);
+    assert(telemetry_metrics_decode_record(&record, buffer + position, length - position) != 0);
+    assert(record.metric_id == 9 && record.counter == 4);
+
+    // Invalid values and ids outside the filter
+    policy.probability = 1.5;
+    assert(telemetry_event_sampling_set(303, &policy) == false);
+    telemetry_sampling_policy_init(&policy);
+    policy.rate_per_second = 10;
+    policy.burst = 0;
+    assert(telemetry_event_sampling_set(303, &policy) == false);
+    policy.burst = 1;
+    assert(telemetry_event_sampling_set(TELEMETRY_EVENT_FILTER_IDS, &policy) == false);
+    assert(telemetry_event_sampling_keep(TELEMETRY_EVENT_FILTER_IDS) == true);
+
+    assert(telemetry_event_sampling_set(303, NULL) == true);
+    telemetry_metrics_free(metrics);
+
+    // The agent's registration covers every id that has had a policy, under its reserved metric id
+    assert(telemetry_metrics_init(&metrics, TELEMETRY_EVENT_SAMPLING_POLICIES) == true);
+    assert(telemetry_event_sampling_policy_count() >= 1);
+    assert(telemetry_event_sampling_register_metrics(metrics) == telemetry_event_sampling_policy_count());
+    assert(telemetry_metrics_count(metrics) == telemetry_event_sampling_policy_count());
+
+    cursor = 0;
+    const size_t all_length = telemetry_metrics_encode(metrics, buffer, sizeof(buffer), &cursor);
+    size_t offset = telemetry_metrics_decode_count(&record_count, buffer, all_length);
+    bool found = false;
+
+    for(uint16_t index = 0; index < record_count; index++)
+    {
+        const size_t used = telemetry_metrics_decode_record(&record, buffer + offset, all_length - offset);
+        assert(used != 0);
+        offset += used;
+
+        if(record.metric_id == TELEMETRY_SAMPLING_SUPPRESSED_METRIC_BASE + 303u)
+            found = (record.counter == 4);
+    }
+
+    assert(found == true);
+    telemetry_metrics_free(metrics);
+
+    printf("Telemetry :: Test case sampling metrics and limits is passed. \n");
+}
+
+static uint64_t clock_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Tests the rate a token bucket achieves over a window.
+ */
+static void testcase_token_bucket_rate()
+{
+    telemetry_sampling_policy_t policy;
+    uint64_t kept = 0;
+    uint64_t attempts = 0;
+
+    // Far more tokens per second than clock ticks
+    telemetry_sampling_policy_init(&policy);
+    policy.rate_per_second = TEST_SAMPLING_RATE;
+    policy.burst = 1;
+    assert(telemetry_event_sampling_set(304, &policy) == true);
+
+    const uint64_t start_ns = clock_monotonic_ns();
+
+    while(clock_monotonic_ns() - start_ns < TEST_SAMPLING_WINDOW_NS)
+    {
+        if(telemetry_event_sampling_keep(304))
+            kept++;
+
+        attempts++;
+    }
+
+    const uint64_t expected = (TEST_SAMPLING_RATE * TEST_SAMPLING_WINDOW_NS) / 1000000000ull;
+
+    // Never above the rate plus the burst, and well above one burst per clock tick
+    assert(attempts > expected * 4u);
+    assert(kept <= expected + 1u + (expected / 10u));
+    assert(kept >= expected / 2u);
+    assert(telemetry_event_sampling_suppressed(304) == attempts - kept);
+
+    assert(telemetry_event_sampling_set(304, NULL) == true);
+
+    printf("Telemetry :: Test case sampling token bucket rate is passed. \n");
+}
@@ -0,0 +1,176 @@
+/**
+ * @file test_schema.cpp
+ * @brief Unit tests for the typed event schemas.
+ *
+ * This file contains test cases for the compile time layout, the encode
+ * and decode round trip and the field description used by receivers.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include "telemetry.hpp"
+
+/* Test cases :
+    1. Offsets and the payload size are compile time constants without padding
+    2. Encoded bytes are little-endian and decode back to the same values
+    3. The description formats a payload without the type
+    4. emit() honours the runtime id filter
+*/
+
+namespace {
+
+    enum class LinkState : uint8_t { Down = 0, Up = 1 };
+
+    struct LinkStats
+    {
+        uint32_t rx_packets;
+        int16_t temperature;
+        LinkState state;
+        bool errors;
+        double load;
+        uint64_t bytes;
+
+        static constexpr uint32_t telemetry_event_id = 0x100;
+        static constexpr auto telemetry_fields = telemetry::schema::fields(
+            telemetry::schema::field("rx_packets", &LinkStats::rx_packets),
+            telemetry::schema::field("temperature", &LinkStats::temperature),
+            telemetry::schema::field("state", &LinkStats::state),
+            telemetry::schema::field("errors", &LinkStats::errors),
+            telemetry::schema::field("load", &LinkStats::load),
+            telemetry::schema::field("bytes", &LinkStats::bytes));
+    };
+
+    // Layout is fixed at compile time
+    static_assert(telemetry::schema::field_count<LinkStats> == 6);
+    static_assert(telemetry::schema::field_offset<LinkStats, 1> == 4);
+    static_assert(telemetry::schema::field_offset<LinkStats, 4> == 8);
+    static_assert(telemetry::schema::payload_size<LinkStats> == 24);
+    static_assert(telemetry::schema::describe<LinkStats>()[2].type == telemetry::schema::FieldType::U8);
+}
+
+// Local function prototype declaration
+static void testcase_layout(void);
+static void testcase_round_trip(void);
+static void testcase_describe(void);
+static void testcase_emit(void);
+
+extern "C" void test_schema(void);
+
+/**
+ * @brief Main entry point for running schema tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_schema()
+{
+    testcase_layout();
+    testcase_round_trip();
+    testcase_describe();
+    testcase_emit();
+}
+
+/**
+ * @brief Tests the byte layout of an encoded event.
+ */
+static void testcase_layout()
+{
+    telemetry_event_t event;
+    const LinkStats stats = { 0x01020304u, -2, LinkState::Up, true, 0.5, 7 };
+
+    telemetry::schema::make_event(event, stats, TELEMETRY_LEVEL_INFO);
+
+    assert(event.event_id == 0x100);
+    assert(event.level == TELEMETRY_LEVEL_INFO);
+    assert(event.payload_size == 24);
+
+    // Little-endian fields back to back
+    const uint8_t expected_head[8] = { 0x04, 0x03, 0x02, 0x01, 0xFE, 0xFF, 0x01, 0x01 };
+    assert(std::memcmp(event.payload, expected_head, sizeof(expected_head)) == 0);
+    assert(event.payload[16] == 7 && event.payload[23] == 0);
+
+    std::printf("Telemetry :: Test case schema layout is passed. \n");
+}
+
+/**
+ * @brief Tests decoding what was encoded.
+ */
+static void testcase_round_trip()
+{
+    telemetry_event_t event;
+    LinkStats decoded{};
+    const LinkStats stats = { 4000000000u, -300, LinkState::Down, false, -12.75, 0xFFFFFFFFFFull };
+
+    telemetry::schema::make_event(event, stats, TELEMETRY_LEVEL_DEBUG);
+
+    assert(telemetry::schema::decode(event, decoded) == true);
+    assert(decoded.rx_packets == stats.rx_packets);
+    assert(decoded.temperature == stats.temperature);
+    assert(decoded.state == stats.state);
+    assert(decoded.errors == stats.errors);
+    assert(decoded.load == stats.load);
+    assert(decoded.bytes == stats.bytes);
+
+    // Wrong size or id is rejected
+    assert(telemetry::schema::decode(event.payload, 23, decoded) == false);
+    event.event_id = 0x101;
+    assert(telemetry::schema::decode(event, decoded) == false);
+
+    std::printf("Telemetry :: Test case schema round trip is passed. \n");
+}
+
+/**
+ * @brief Tests formatting a payload from its description.
+ */
+static void testcase_describe()
+{
+    telemetry_event_t event;
+    char text[160];
+    const LinkStats stats = { 12, -5, LinkState::Up, false, 0.25, 1000 };
+
+    telemetry::schema::make_event(event, stats, TELEMETRY_LEVEL_INFO);
+
+    constexpr auto description = telemetry::schema::describe<LinkStats>();
+    assert(std::strcmp(description[4].name, "load") == 0 && description[4].offset == 8 && description[4].size == 8);
+
+    telemetry::schema::format_fields(description.data(), description.size(), event.payload, event.payload_size, text, sizeof(text));
+    assert(std::strcmp(text, "rx_packets=12 temperature=-5 state=1 errors=false load=0.25 bytes=1000") == 0);
+
+    // A short payload stops at the first field it does not hold
+    telemetry::schema::format_fields(description.data(), description.size(), event.payload, 7, text, sizeof(text));
+    assert(std::strcmp(text, "rx_packets=12 temperature=-5 state=1") == 0);
+
+    std::printf("Telemetry :: Test case schema describe is passed. \n");
+}
+
+/**
+ * @brief Tests emitting a typed event through the filters.
+ */
+static void testcase_emit()
+{
+    ring_buffer_t* rb;
+    telemetry_event_t event;
+    LinkStats decoded{};
+    const LinkStats stats = { 1, 2, LinkState::Up, true, 3.0, 4 };
+
+    assert(ring_buffer_init(&rb, 4) == true);
+
+    assert(telemetry::schema::emit<TELEMETRY_LEVEL_WARNING>(rb, stats) == true);
+    assert(ring_buffer_pop(rb, &event) == true);
+    assert(event.level == TELEMETRY_LEVEL_WARNING);
+    assert(telemetry::schema::decode(event, decoded) == true && decoded.bytes == 4);
+
+    // A disabled id is not built
+    assert(telemetry_event_filter_set(LinkStats::telemetry_event_id, false) == true);
+    assert(telemetry::schema::emit<TELEMETRY_LEVEL_WARNING>(rb, stats) == false);
+    assert(ring_buffer_pop(rb, &event) == false);
+    assert(telemetry_event_filter_set(LinkStats::telemetry_event_id, true) == true);
+
+    ring_buffer_free(rb);
+
+    std::printf("Telemetry :: Test case schema emit is passed. \n");
+}
@@ -0,0 +1,136 @@
+/**
+ * @file test_sharded_counter.c
+ * @brief Unit tests for the sharded counter.
+ *
+ * This file contains test cases for shard sizing, concurrent increments
+ * and the sharded counter metric.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include "sharded_counter.h"
+#include "metrics.h"
+#include "osal_thread.h"
+
+/* Test cases :
+    1. Shard count is rounded to a power of two
+    2. Concurrent increments from several threads are all counted
+    3. Sharded counter published through the metrics registry
+*/
+
+#define TEST_THREADS 4
+#define TEST_INCREMENTS 100000
+
+// Local function prototype declaration
+static void testcase_shard_count(void);
+static void testcase_concurrent_add(void);
+static void testcase_sharded_metric(void);
+
+void test_sharded_counter(void);
+
+/**
+ * @brief Main entry point for running sharded counter tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_sharded_counter()
+{
+    testcase_shard_count();
+    testcase_concurrent_add();
+    testcase_sharded_metric();
+}
+
+/**
+ * @brief Tests shard count rounding and the default.
+ */
+static void testcase_shard_count()
+{
+    sharded_counter_t* counter;
+
+    assert(sharded_counter_init(&counter, 5) == true);
+    assert(sharded_counter_shards(counter) == 8);
+    assert(sharded_counter_sum(counter) == 0);
+    sharded_counter_free(counter);
+
+    assert(sharded_counter_init(&counter, 0) == true);
+    assert(sharded_counter_shards(counter) == SHARDED_COUNTER_DEFAULT_SHARDS);
+    sharded_counter_free(counter);
+
+    printf("Telemetry :: Test case sharded counter shard count is passed. \n");
+}
+
+static void* add_worker(void* arg)
+{
+    sharded_counter_t* counter = (sharded_counter_t*)arg;
+
+    for(int index = 0; index < TEST_INCREMENTS; index++)
+    {
+        sharded_counter_add(counter, 1);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Tests that increments from several threads are not lost.
+ */
+static void testcase_concurrent_add()
+{
+    sharded_counter_t* counter;
+    osal_thread_t* threads[TEST_THREADS];
+
+    assert(sharded_counter_init(&counter, 2) == true);
+
+    for(int index = 0; index < TEST_THREADS; index++)
+    {
+        assert(osal_thread_create(&threads[index], add_worker, counter, "test_add") == 0);
+    }
+
+    for(int index = 0; index < TEST_THREADS; index++)
+    {
+        osal_thread_join(threads[index]);
+        osal_thread_destroy(threads[index]);
+    }
+
+    assert(sharded_counter_sum(counter) == (uint64_t)TEST_THREADS * TEST_INCREMENTS);
+
+    sharded_counter_free(counter);
+
+    printf("Telemetry :: Test case sharded counter concurrent add is passed. \n");
+}
+
+/**
+ * @brief Tests that a sharded counter metric encodes the slot sum.
+ */
+static void testcase_sharded_metric()
+{
+    sharded_counter_t* counter;
+    telemetry_metrics_t* metrics;
+    telemetry_metric_record_t record;
+    uint8_t buffer[64];
+    size_t cursor = 0;
+    uint16_t record_count = 0;
+
+    assert(sharded_counter_init(&counter, 4) == true);
+    assert(telemetry_metrics_init(&metrics, 2) == true);
+
+    telemetry_metric_t* metric = telemetry_metrics_register_sharded(metrics, 5, counter);
+    assert(metric != NULL);
+
+    sharded_counter_add(counter, 40);
+    telemetry_metric_add(metric, 2);
+
+    size_t length = telemetry_metrics_encode(metrics, buffer, sizeof(buffer), &cursor);
+    size_t position = telemetry_metrics_decode_count(&record_count, buffer, length);
+    assert(record_count == 1);
+    assert(telemetry_metrics_decode_record(&record, buffer + position, length - position) != 0);
+    assert(record.type == TELEMETRY_METRIC_COUNTER && record.counter == 42);
+
+    telemetry_metrics_free(metrics);
+    sharded_counter_free(counter);
+
+    printf("Telemetry :: Test case sharded counter metric is passed. \n");
+}
@@ -0,0 +1,245 @@
+/**
+ * @file test_signal_ring.c
+ * @brief Unit tests for the async-signal-safe event queue.
+ *
+ * This file contains test cases for ordering and overflow, concurrent
+ * producers and consumers, and pushes from a signal handler.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "signal_ring.h"
+#include "osal_thread.h"
+
+/* Test cases :
+    1. Events come out in order, a full ring drops and counts
+    2. Concurrent producers and consumers lose and repeat nothing
+    3. A signal handler pushes while the interrupted thread does not
+*/
+
+#define TEST_SIGNAL_RING_PRODUCERS 2
+#define TEST_SIGNAL_RING_EVENTS 20000u
+
+// Shared with the worker threads
+typedef struct signal_ring_test_s {
+    signal_ring_t* ring;
+    uint32_t first_id;
+    atomic_uint consumed;
+    atomic_uint_fast64_t id_sum;
+} signal_ring_test_t;
+
+// Local function prototype declaration
+static void testcase_order_and_overflow(void);
+static void testcase_concurrent(void);
+static void testcase_signal_handler(void);
+
+void test_signal_ring(void);
+
+/**
+ * @brief Main entry point for running signal ring tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_signal_ring()
+{
+    testcase_order_and_overflow();
+    testcase_concurrent();
+    testcase_signal_handler();
+}
+
+/**
+ * @brief Tests ordering, rounding and a full ring.
+ */
+static void testcase_order_and_overflow()
+{
+    signal_ring_t* ring;
+    telemetry_event_t event;
+
+    assert(signal_ring_init(&ring, 0) == false);
+    assert(signal_ring_init(&ring, 3) == true);
+    assert(signal_ring_capacity(ring) == 4);
+
+    // Several laps, so every slot is reused
+    for(uint32_t lap = 0; lap < 3; lap++)
+    {
+        for(uint32_t index = 0; index < 4; index++)
+        {
+            telemetry_event_make(&event, lap * 4u + index, NULL, 0, TELEMETRY_LEVEL_ERROR);
+            assert(signal_ring_push(ring, &event) == true);
+        }
+
+        assert(signal_ring_count(ring) == 4);
+        assert(signal_ring_push(ring, &event) == false);
+
+        for(uint32_t index = 0; index < 4; index++)
+        {
+            assert(signal_ring_pop(ring, &event) == true);
+            assert(event.event_id == lap * 4u + index);
+        }
+
+        assert(signal_ring_pop(ring, &event) == false);
+    }
+
+    assert(signal_ring_dropped(ring) == 3);
+
+    signal_ring_free(ring);
+
+    printf("Telemetry :: Test case signal ring order and overflow is passed. \n");
+}
+
+static void* produce_worker(void* arg)
+{
+    signal_ring_test_t* test = (signal_ring_test_t*)arg;
+    telemetry_event_t event;
+    const uint32_t first_id = test->first_id;
+
+    for(uint32_t index = 0; index < TEST_SIGNAL_RING_EVENTS; index++)
+    {
+        telemetry_event_make(&event, first_id + index, NULL, 0, TELEMETRY_LEVEL_INFO);
+
+        // Retry until a consumer made room
+        while(!signal_ring_push(test->ring, &event))
+        {
+            osal_thread_sleep_ns(1000);
+        }
+    }
+
+    return NULL;
+}
+
+static void* consume_worker(void* arg)
+{
+    signal_ring_test_t* test = (signal_ring_test_t*)arg;
+    telemetry_event_t event;
+
+    while(atomic_load(&test->consumed) < TEST_SIGNAL_RING_PRODUCERS * TEST_SIGNAL_RING_EVENTS)
+    {
+        if(signal_ring_pop(test->ring, &event))
+        {
+            atomic_fetch_add(&test->id_sum, event.event_id);
+            atomic_fetch_add(&test->consumed, 1);
+        }
+        else
+        {
+            osal_thread_sleep_ns(1000);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Tests several producers and consumers at once.
+ */
+static void testcase_concurrent()
+{
+    signal_ring_test_t tests[TEST_SIGNAL_RING_PRODUCERS];
+    osal_thread_t* producers[TEST_SIGNAL_RING_PRODUCERS];
+    osal_thread_t* consumers[2];
+    signal_ring_t* ring;
+
+    assert(signal_ring_init(&ring, 64) == true);
+
+    // Producer n pushes ids n * 1000000 + 0 ... EVENTS - 1
+    uint64_t expected_sum = 0;
+    for(int index = 0; index < TEST_SIGNAL_RING_PRODUCERS; index++)
+    {
+        tests[index].ring = ring;
+        tests[index].first_id = (uint32_t)index * 1000000u;
+
+        for(uint32_t event = 0; event < TEST_SIGNAL_RING_EVENTS; event++)
+        {
+            expected_sum += tests[index].first_id + event;
+        }
+    }
+
+    // Both consumers share the counters of the first entry
+    atomic_init(&tests[0].consumed, 0);
+    atomic_init(&tests[0].id_sum, 0);
+
+    for(int index = 0; index < 2; index++)
+    {
+        assert(osal_thread_create(&consumers[index], consume_worker, &tests[0], "test_consume") == 0);
+    }
+
+    for(int index = 0; index < TEST_SIGNAL_RING_PRODUCERS; index++)
+    {
+        assert(osal_thread_create(&producers[index], produce_worker, &tests[index], "test_produce") == 0);
+    }
+
+    for(int index = 0; index < TEST_SIGNAL_RING_PRODUCERS; index++)
+    {
+        osal_thread_join(producers[index]);
+        osal_thread_destroy(producers[index]);
+    }
+
+    for(int index = 0; index < 2; index++)
+    {
+        osal_thread_join(consumers[index]);
+        osal_thread_destroy(consumers[index]);
+    }
+
+    assert(atomic_load(&tests[0].consumed) == TEST_SIGNAL_RING_PRODUCERS * TEST_SIGNAL_RING_EVENTS);
+    assert(atomic_load(&tests[0].id_sum) == expected_sum);
+    assert(signal_ring_count(ring) == 0);
+
+    signal_ring_free(ring);
+
+    printf("Telemetry :: Test case signal ring concurrent is passed. \n");
+}
+
+static signal_ring_t* handler_ring;
+
+static void push_from_handler(int signal_number)
+{
+    telemetry_event_t event;
+
+    // No library calls besides memcpy inside the push
+    event.event_id = (uint32_t)signal_number;
+    event.level = TELEMETRY_LEVEL_ERROR;
+    event.reserved = 0;
+    event.payload_size = 0;
+    event.timestamp = 0;
+
+    (void)signal_ring_push(handler_ring, &event);
+}
+
+/**
+ * @brief Tests pushing from a signal handler.
+ */
+static void testcase_signal_handler()
+{
+    struct sigaction action;
+    struct sigaction previous;
+    telemetry_event_t event;
+
+    assert(signal_ring_init(&handler_ring, 4) == true);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = push_from_handler;
+    sigemptyset(&action.sa_mask);
+    assert(sigaction(SIGUSR1, &action, &previous) == 0);
+
+    telemetry_event_make(&event, 1, NULL, 0, TELEMETRY_LEVEL_INFO);
+    assert(signal_ring_push(handler_ring, &event) == true);
+
+    // raise() runs the handler before it returns
+    assert(raise(SIGUSR1) == 0);
+
+    assert(sigaction(SIGUSR1, &previous, NULL) == 0);
+
+    assert(signal_ring_pop(handler_ring, &event) == true && event.event_id == 1);
+    assert(signal_ring_pop(handler_ring, &event) == true && event.event_id == SIGUSR1);
+    assert(signal_ring_pop(handler_ring, &event) == false);
+
+    signal_ring_free(handler_ring);
+    handler_ring = NULL;
+
+    printf("Telemetry :: Test case signal ring signal handler is passed. \n");
+}
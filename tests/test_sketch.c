@@ -0,0 +1,325 @@
+/**
+ * @file test_sketch.c
+ * @brief Unit tests for the quantile sketches.
+ *
+ * This file contains test cases for sketch accuracy, merging, bin
+ * collapsing, the wire encoding and the event id keyed sketch set.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "quantile_sketch.h"
+
+/* Test cases :
+    1. Percentiles stay within the relative accuracy
+    2. Negative, zero and positive samples
+    3. Merge of two sketches, accuracy mismatch rejected
+    4. Collapsing keeps the high percentiles accurate
+    5. Encode and decode round trip
+    6. Sketch set absorbs registered events and encodes a batch
+    7. Infinite samples are ignored, accuracies too fine for the bin keys are rejected
+*/
+
+// Local function prototype declaration
+static void testcase_accuracy(void);
+static void testcase_signed_values(void);
+static void testcase_merge(void);
+static void testcase_collapse(void);
+static void testcase_encode_decode(void);
+static void testcase_sketch_set(void);
+static void testcase_non_finite(void);
+
+void test_sketch(void);
+
+/**
+ * @brief Main entry point for running quantile sketch tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_sketch()
+{
+    testcase_accuracy();
+    testcase_signed_values();
+    testcase_merge();
+    testcase_collapse();
+    testcase_encode_decode();
+    testcase_sketch_set();
+    testcase_non_finite();
+}
+
+/**
+ * @brief Returns true if value is within accuracy of expected.
+ */
+static bool within(double value, double expected, double accuracy)
+{
+    return fabs(value - expected) <= fabs(expected) * accuracy + 1e-12;
+}
+
+/**
+ * @brief Tests percentiles of 1..1000.
+ */
+static void testcase_accuracy()
+{
+    telemetry_sketch_t* sketch;
+
+    assert(telemetry_sketch_init(&sketch, 0.01, 1024) == true);
+    assert(telemetry_sketch_percentile(sketch, 50.0) == 0.0);
+
+    for(int value = 1; value <= 1000; value++)
+    {
+        telemetry_sketch_add(sketch, (double)value);
+    }
+
+    assert(telemetry_sketch_count(sketch) == 1000);
+    assert(telemetry_sketch_sum(sketch) == 500500.0);
+    assert(telemetry_sketch_min(sketch) == 1.0 && telemetry_sketch_max(sketch) == 1000.0);
+
+    // Rank p * (n - 1) rounded up : p50 -> 500th value, p99 -> 990th value
+    assert(within(telemetry_sketch_percentile(sketch, 50.0), 500.0, 0.01));
+    assert(within(telemetry_sketch_percentile(sketch, 99.0), 990.0, 0.01));
+    assert(telemetry_sketch_percentile(sketch, 0.0) == 1.0);
+    assert(telemetry_sketch_percentile(sketch, 100.0) == 1000.0);
+
+    telemetry_sketch_free(sketch);
+
+    printf("Telemetry :: Test case sketch accuracy is passed. \n");
+}
+
+/**
+ * @brief Tests negative, zero and positive samples together.
+ */
+static void testcase_signed_values()
+{
+    telemetry_sketch_t* sketch;
+
+    assert(telemetry_sketch_init(&sketch, 0.0, 0) == true);
+    assert(telemetry_sketch_relative_accuracy(sketch) == TELEMETRY_SKETCH_DEFAULT_RELATIVE_ACCURACY);
+
+    telemetry_sketch_add(sketch, -40.0);
+    telemetry_sketch_add(sketch, -10.0);
+    telemetry_sketch_add(sketch, 0.0);
+    telemetry_sketch_add(sketch, 25.0);
+    telemetry_sketch_add(sketch, 80.0);
+    telemetry_sketch_add(sketch, NAN);
+
+    assert(telemetry_sketch_count(sketch) == 5);
+    assert(telemetry_sketch_min(sketch) == -40.0);
+    assert(within(telemetry_sketch_percentile(sketch, 25.0), -10.0, 0.01));
+    assert(telemetry_sketch_percentile(sketch, 50.0) == 0.0);
+    assert(within(telemetry_sketch_percentile(sketch, 75.0), 25.0, 0.01));
+
+    telemetry_sketch_free(sketch);
+
+    printf("Telemetry :: Test case sketch signed values is passed. \n");
+}
+
+/**
+ * @brief Tests merging two sketches.
+ */
+static void testcase_merge()
+{
+    telemetry_sketch_t* first;
+    telemetry_sketch_t* second;
+    telemetry_sketch_t* other_accuracy;
+
+    assert(telemetry_sketch_init(&first, 0.01, 0) == true);
+    assert(telemetry_sketch_init(&second, 0.01, 0) == true);
+    assert(telemetry_sketch_init(&other_accuracy, 0.05, 0) == true);
+
+    for(int value = 1; value <= 50; value++)
+    {
+        telemetry_sketch_add(first, (double)value);
+        telemetry_sketch_add(second, (double)(value + 50));
+    }
+
+    assert(telemetry_sketch_merge(first, second) == true);
+    assert(telemetry_sketch_count(first) == 100);
+    assert(telemetry_sketch_min(first) == 1.0 && telemetry_sketch_max(first) == 100.0);
+    assert(within(telemetry_sketch_percentile(first, 90.0), 90.0, 0.01));
+
+    assert(telemetry_sketch_merge(first, other_accuracy) == false);
+
+    telemetry_sketch_free(first);
+    telemetry_sketch_free(second);
+    telemetry_sketch_free(other_accuracy);
+
+    printf("Telemetry :: Test case sketch merge is passed. \n");
+}
+
+/**
+ * @brief Tests that a small sketch collapses its lowest bins.
+ */
+static void testcase_collapse()
+{
+    telemetry_sketch_t* sketch;
+
+    // 32 bins at 1 % cover less than a factor of 2
+    assert(telemetry_sketch_init(&sketch, 0.01, 32) == true);
+
+    for(int value = 1; value <= 10000; value++)
+    {
+        telemetry_sketch_add(sketch, (double)value);
+    }
+
+    assert(telemetry_sketch_count(sketch) == 10000);
+    assert(within(telemetry_sketch_percentile(sketch, 99.0), 9900.0, 0.01));
+    assert(within(telemetry_sketch_percentile(sketch, 99.9), 9990.0, 0.01));
+
+    // Low values were collapsed upwards but stay within the recorded range
+    const double p1 = telemetry_sketch_percentile(sketch, 1.0);
+    assert(p1 >= 1.0 && p1 < 9900.0);
+
+    telemetry_sketch_free(sketch);
+
+    printf("Telemetry :: Test case sketch collapse is passed. \n");
+}
+
+/**
+ * @brief Tests the wire encoding round trip.
+ */
+static void testcase_encode_decode()
+{
+    telemetry_sketch_t* sketch;
+    telemetry_sketch_t* decoded;
+    uint8_t buffer[512];
+
+    assert(telemetry_sketch_init(&sketch, 0.02, 0) == true);
+    assert(telemetry_sketch_init(&decoded, 0.0, 0) == true);
+
+    for(int value = -20; value <= 100; value += 3)
+    {
+        telemetry_sketch_add(sketch, (double)value * 0.5);
+    }
+
+    size_t length = telemetry_sketch_encode(sketch, buffer, sizeof(buffer));
+    assert(length > 0);
+
+    assert(telemetry_sketch_decode(decoded, buffer, length) == length);
+    assert(telemetry_sketch_relative_accuracy(decoded) == 0.02);
+    assert(telemetry_sketch_count(decoded) == telemetry_sketch_count(sketch));
+    assert(telemetry_sketch_sum(decoded) == telemetry_sketch_sum(sketch));
+    assert(telemetry_sketch_min(decoded) == telemetry_sketch_min(sketch));
+    assert(telemetry_sketch_max(decoded) == telemetry_sketch_max(sketch));
+
+    for(double percentile = 0.0; percentile <= 100.0; percentile += 12.5)
+    {
+        assert(telemetry_sketch_percentile(decoded, percentile) == telemetry_sketch_percentile(sketch, percentile));
+    }
+
+    // Truncated input and a small buffer are rejected
+    assert(telemetry_sketch_decode(decoded, buffer, length - 1) == 0);
+    assert(telemetry_sketch_encode(sketch, buffer, 16) == 0);
+
+    telemetry_sketch_free(sketch);
+    telemetry_sketch_free(decoded);
+
+    printf("Telemetry :: Test case sketch encode decode is passed. \n");
+}
+
+/**
+ * @brief Tests absorbing events and encoding a sketch batch.
+ */
+static void testcase_sketch_set()
+{
+    telemetry_sketches_t* sketches;
+    telemetry_sketch_t* decoded;
+    telemetry_event_t event;
+    uint8_t buffer[512];
+    size_t cursor = 0;
+    uint16_t record_count = 0;
+    uint32_t event_id = 0;
+
+    assert(telemetry_sketches_init(&sketches, 2, 0.0, 0) == true);
+    assert(telemetry_sketch_init(&decoded, 0.0, 0) == true);
+
+    assert(telemetry_sketches_register(sketches, 10, TELEMETRY_SKETCH_VALUE_FLOAT, 4) == true);
+    assert(telemetry_sketches_register(sketches, 11, TELEMETRY_SKETCH_VALUE_I16, 0) == true);
+    assert(telemetry_sketches_register(sketches, 12, TELEMETRY_SKETCH_VALUE_U32, 0) == false);   // full
+    assert(telemetry_sketches_register(sketches, 10, 99, 0) == false);
+
+    // Temperature at offset 4, behind a sensor index
+    struct { uint32_t sensor; float celsius; } sample = { 3, 36.5f };
+    telemetry_event_make(&event, 10, &sample, sizeof(sample), TELEMETRY_LEVEL_INFO);
+    assert(telemetry_sketches_absorb(sketches, &event) == true);
+
+    // Payload too short for the value, left to be sent
+    telemetry_event_make(&event, 10, &sample, 4, TELEMETRY_LEVEL_INFO);
+    assert(telemetry_sketches_absorb(sketches, &event) == false);
+
+    // Not registered
+    telemetry_event_make(&event, 12, &sample, sizeof(sample), TELEMETRY_LEVEL_INFO);
+    assert(telemetry_sketches_absorb(sketches, &event) == false);
+
+    assert(telemetry_sketch_count(telemetry_sketches_find(sketches, 10)) == 1);
+    assert(telemetry_sketches_find(sketches, 12) == NULL);
+
+    // Only the non-empty sketch is encoded
+    size_t length = telemetry_sketches_encode(sketches, buffer, sizeof(buffer), &cursor);
+    assert(length > 0);
+    assert(telemetry_sketches_encode(sketches, buffer, sizeof(buffer), &cursor) == 0);
+
+    size_t position = telemetry_sketches_decode_count(&record_count, buffer, length);
+    assert(record_count == 1);
+    position += telemetry_sketches_decode_record(&event_id, decoded, buffer + position, length - position);
+    assert(position == length);
+    assert(event_id == 10 && telemetry_sketch_max(decoded) == 36.5);
+
+    // Reset empties the sketches for the next interval
+    telemetry_sketches_reset(sketches);
+    cursor = 0;
+    assert(telemetry_sketches_encode(sketches, buffer, sizeof(buffer), &cursor) == 0);
+
+    telemetry_sketch_free(decoded);
+    telemetry_sketches_free(sketches);
+
+    printf("Telemetry :: Test case sketch set is passed. \n");
+}
+
+/**
+ * @brief Tests infinite samples and the accuracy bounds.
+ */
+static void testcase_non_finite()
+{
+    telemetry_sketches_t* sketches;
+    telemetry_sketch_t* sketch;
+    telemetry_event_t event;
+    double value = INFINITY;
+
+    assert(telemetry_sketches_init(&sketches, 1, 0.0, 0) == true);
+    assert(telemetry_sketches_register(sketches, 20, TELEMETRY_SKETCH_VALUE_DOUBLE, 0) == true);
+
+    // Absorbed like any registered event, but no bin takes it
+    telemetry_event_make(&event, 20, &value, sizeof(value), TELEMETRY_LEVEL_INFO);
+    assert(telemetry_sketches_absorb(sketches, &event) == true);
+    value = -INFINITY;
+    telemetry_event_make(&event, 20, &value, sizeof(value), TELEMETRY_LEVEL_INFO);
+    assert(telemetry_sketches_absorb(sketches, &event) == true);
+    assert(telemetry_sketch_count(telemetry_sketches_find(sketches, 20)) == 0);
+
+    value = 2.5;
+    telemetry_event_make(&event, 20, &value, sizeof(value), TELEMETRY_LEVEL_INFO);
+    assert(telemetry_sketches_absorb(sketches, &event) == true);
+    assert(telemetry_sketch_count(telemetry_sketches_find(sketches, 20)) == 1);
+    assert(telemetry_sketch_max(telemetry_sketches_find(sketches, 20)) == 2.5);
+
+    telemetry_sketches_free(sketches);
+
+    // Below one ppm the keys of large values would leave int32
+    assert(telemetry_sketch_init(&sketch, 1e-12, 0) == false);
+    assert(telemetry_sketches_init(&sketches, 1, 1e-12, 0) == false);
+    assert(telemetry_sketch_init(&sketch, TELEMETRY_SKETCH_MIN_RELATIVE_ACCURACY, 0) == true);
+
+    telemetry_sketch_add(sketch, 1e300);
+    telemetry_sketch_add(sketch, -1e300);
+    assert(telemetry_sketch_count(sketch) == 2);
+    assert(within(telemetry_sketch_max(sketch), 1e300, 1e-12));
+
+    telemetry_sketch_free(sketch);
+
+    printf("Telemetry :: Test case sketch non finite is passed. \n");
+}
@@ -0,0 +1,239 @@
+/**
+ * @file test_span.c
+ * @brief Unit tests for the tracing spans.
+ *
+ * This file contains test cases for span nesting, the span record
+ * encoding, filtered spans and explicit parents.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "span.h"
+#include "event_filter.h"
+
+/* Test cases :
+    1. Nested spans share the trace and record their parent and duration
+    2. A disabled span records nothing and its children attach to its parent
+    3. An explicit parent continues a trace, a full ring still closes the span
+    4. Records leave the producer in ticks and are converted in bulk or one by one
+*/
+
+// Local function prototype declaration
+static void testcase_nesting(void);
+static void testcase_filtered_span(void);
+static void testcase_explicit_parent(void);
+static void testcase_resolve_records(void);
+
+void test_span(void);
+
+/**
+ * @brief Main entry point for running span tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_span()
+{
+    testcase_nesting();
+    testcase_filtered_span();
+    testcase_explicit_parent();
+    testcase_resolve_records();
+}
+
+static void sleep_us(long microseconds)
+{
+    struct timespec ts = { 0, microseconds * 1000l };
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * @brief Pops a span record and decodes it.
+ */
+static telemetry_span_record_t pop_record(ring_buffer_t* rb)
+{
+    telemetry_event_t event;
+    telemetry_span_record_t record;
+
+    assert(ring_buffer_pop(rb, &event) == true);
+    assert(event.event_id == TELEMETRY_SPAN_EVENT_ID);
+    assert(telemetry_span_record_decode(&record, &event) == true);
+
+    return record;
+}
+
+/**
+ * @brief Tests a parent span with a child span.
+ */
+static void testcase_nesting()
+{
+    ring_buffer_t* rb;
+    telemetry_span_t outer;
+    telemetry_span_t inner;
+
+    assert(ring_buffer_init(&rb, 8) == true);
+    assert(telemetry_span_current() == NULL);
+
+    telemetry_span_begin(&outer, 10, TELEMETRY_LEVEL_INFO);
+    assert(telemetry_span_current() == &outer);
+    assert(outer.parent_id == 0 && outer.trace_id == outer.span_id && outer.span_id != 0);
+
+    telemetry_span_begin(&inner, 11, TELEMETRY_LEVEL_DEBUG);
+    assert(telemetry_span_current() == &inner);
+    assert(inner.trace_id == outer.trace_id && inner.parent_id == outer.span_id);
+    assert(inner.span_id != outer.span_id);
+
+    sleep_us(2000);
+    assert(telemetry_span_end(&inner, rb) == true);
+    assert(telemetry_span_current() == &outer);
+    assert(telemetry_span_end(&outer, rb) == true);
+    assert(telemetry_span_current() == NULL);
+
+    // Ending twice does nothing
+    assert(telemetry_span_end(&outer, rb) == false);
+
+    // The child finishes first
+    const telemetry_span_record_t child = pop_record(rb);
+    const telemetry_span_record_t parent = pop_record(rb);
+
+    assert(child.name_id == 11 && child.parent_id == parent.span_id && child.trace_id == parent.trace_id);
+    assert(parent.name_id == 10 && parent.parent_id == 0);
+    assert(child.duration_ns >= 2000000ull);
+    assert(parent.start_ns <= child.start_ns);
+    assert(parent.start_ns + parent.duration_ns >= child.start_ns + child.duration_ns);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case span nesting is passed. \n");
+}
+
+/**
+ * @brief Tests a span whose name id is disabled.
+ */
+static void testcase_filtered_span()
+{
+    ring_buffer_t* rb;
+    telemetry_span_t outer;
+    telemetry_span_t skipped;
+    telemetry_span_t inner;
+    telemetry_event_t event;
+
+    assert(ring_buffer_init(&rb, 8) == true);
+    assert(telemetry_event_filter_set(21, false) == true);
+
+    telemetry_span_begin(&outer, 20, TELEMETRY_LEVEL_INFO);
+    telemetry_span_begin(&skipped, 21, TELEMETRY_LEVEL_INFO);
+    assert(skipped.active == false);
+    assert(telemetry_span_current() == &outer);
+
+    telemetry_span_begin(&inner, 22, TELEMETRY_LEVEL_INFO);
+    assert(inner.parent_id == outer.span_id);
+
+    assert(telemetry_span_end(&inner, rb) == true);
+    assert(telemetry_span_end(&skipped, rb) == false);
+    assert(telemetry_span_end(&outer, rb) == true);
+
+    assert(pop_record(rb).name_id == 22);
+    assert(pop_record(rb).name_id == 20);
+    assert(ring_buffer_pop(rb, &event) == false);
+
+    assert(telemetry_event_filter_set(21, true) == true);
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case span filtered is passed. \n");
+}
+
+/**
+ * @brief Tests continuing a trace and a full ring.
+ */
+static void testcase_explicit_parent()
+{
+    ring_buffer_t* rb;
+    telemetry_span_t remote;
+    telemetry_event_t event;
+
+    assert(ring_buffer_init(&rb, 1) == true);
+
+    telemetry_span_begin_with_parent(&remote, 30, TELEMETRY_LEVEL_WARNING, 777, 778);
+    assert(remote.trace_id == 777 && remote.parent_id == 778);
+    assert(telemetry_span_end(&remote, rb) == true);
+
+    const telemetry_span_record_t record = pop_record(rb);
+    assert(record.trace_id == 777 && record.parent_id == 778 && record.name_id == 30);
+
+    // Fill the ring, the record is dropped but the span is closed
+    telemetry_event_make(&event, 1, NULL, 0, TELEMETRY_LEVEL_INFO);
+    assert(ring_buffer_push(rb, &event) == true);
+
+    telemetry_span_begin(&remote, 31, TELEMETRY_LEVEL_INFO);
+    assert(telemetry_span_end(&remote, rb) == false);
+    assert(telemetry_span_current() == NULL);
+
+    // Other events are not span records
+    telemetry_span_record_t decoded;
+    assert(telemetry_span_record_decode(&decoded, &event) == false);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case span explicit parent is passed. \n");
+}
+
+/**
+ * @brief Tests converting raw tick span records.
+ */
+static void testcase_resolve_records()
+{
+    ring_buffer_t* rb;
+    telemetry_span_t span;
+    telemetry_event_t events[3];
+    telemetry_span_record_t raw;
+    telemetry_span_record_t resolved;
+
+    assert(ring_buffer_init(&rb, 4) == true);
+
+    for(uint32_t index = 0; index < 2; index++)
+    {
+        telemetry_span_begin(&span, 40 + index, TELEMETRY_LEVEL_INFO);
+        sleep_us(1000);
+        assert(telemetry_span_end(&span, rb) == true);
+        assert(ring_buffer_pop(rb, &events[index]) == true);
+        assert((events[index].reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) != 0);
+    }
+
+    // Other events in the batch are left alone
+    telemetry_event_make(&events[2], 1, NULL, 0, TELEMETRY_LEVEL_INFO);
+    events[2].timestamp = 5;
+    events[2].reserved = TELEMETRY_EVENT_FLAG_RAW_TICKS;
+
+    assert(telemetry_span_record_decode(&raw, &events[0]) == true);
+
+    telemetry_span_resolve_records(events, 3);
+    assert((events[0].reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0);
+    assert((events[1].reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0);
+    assert(events[2].timestamp == 5 && events[2].reserved == TELEMETRY_EVENT_FLAG_RAW_TICKS);
+
+    // The agent's conversion gives what a receiver decodes from the raw record
+    assert(telemetry_span_record_decode(&resolved, &events[0]) == true);
+    assert(resolved.name_id == 40 && resolved.span_id == raw.span_id);
+    assert(resolved.start_ns == raw.start_ns && resolved.duration_ns == raw.duration_ns);
+    assert(resolved.duration_ns >= 1000000ull);
+
+    // The crash flush path converts one record
+    telemetry_span_begin(&span, 42, TELEMETRY_LEVEL_INFO);
+    assert(telemetry_span_end(&span, rb) == true);
+    assert(ring_buffer_pop(rb, &events[0]) == true);
+    assert(telemetry_span_record_decode(&raw, &events[0]) == true);
+
+    telemetry_span_resolve_record_signal_safe(&events[0]);
+    assert((events[0].reserved & TELEMETRY_EVENT_FLAG_RAW_TICKS) == 0);
+    assert(telemetry_span_record_decode(&resolved, &events[0]) == true);
+    assert(resolved.name_id == 42 && resolved.start_ns == raw.start_ns && resolved.duration_ns == raw.duration_ns);
+
+    ring_buffer_free(rb);
+
+    printf("Telemetry :: Test case span resolve records is passed. \n");
+}
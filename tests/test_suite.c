@@ -11,8 +11,48 @@
 
 void main()
 {
+    // Test the OSAL clock
+    test_time();
+    // Test the OSAL threads
+    test_thread();
+    // Test the OSAL wakeup and timers
+    test_wakeup();
+    // Test the OSAL poller
+    test_poll();
+    // Test the OSAL send ring
+    test_uring();
     // Test the event function
     test_event();
     // Test the ring buffer functionality
     test_ring_buffer();
+    // Test the wire protocol helpers
+    test_protocol();
+    // Test the metrics registry
+    test_metrics();
+    // Test the sharded counter
+    test_sharded_counter();
+    // Test the memory pool
+    test_memory_pool();
+    // Test the latency histogram
+    test_histogram();
+    // Test the quantile sketches
+    test_sketch();
+    // Test the emit filters
+    test_filter();
+    // Test the sampling and rate limits
+    test_sampling();
+    // Test the tracing spans
+    test_span();
+    // Test the async-signal-safe queue
+    test_signal_ring();
+    // Test the deferred-format logging
+    test_log();
+    // Test the typed event schemas
+    test_schema();
+    // Test the agent and heartbeats
+    test_agent();
+    // Test the UDP transport and its io_uring path
+    test_udp_transport();
+    // Test the C++ facade
+    test_telemetry();
 }
\ No newline at end of file
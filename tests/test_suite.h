@@ -11,4 +11,24 @@
 
 
 extern void test_ring_buffer(void);
-extern void test_event(void);
\ No newline at end of file
+extern void test_event(void);
+extern void test_time(void);
+extern void test_thread(void);
+extern void test_wakeup(void);
+extern void test_poll(void);
+extern void test_uring(void);
+extern void test_protocol(void);
+extern void test_agent(void);
+extern void test_metrics(void);
+extern void test_sharded_counter(void);
+extern void test_memory_pool(void);
+extern void test_histogram(void);
+extern void test_sketch(void);
+extern void test_filter(void);
+extern void test_sampling(void);
+extern void test_span(void);
+extern void test_signal_ring(void);
+extern void test_log(void);
+extern void test_schema(void);
+extern void test_udp_transport(void);
+extern void test_telemetry(void);
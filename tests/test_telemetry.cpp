@@ -0,0 +1,445 @@
+/**
+ * @file test_telemetry.cpp
+ * @brief Unit tests for the C++ telemetry facade.
+ *
+ * This file contains test cases for the startup, the producer handles and
+ * the bounded flush of telemetry::Telemetry.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "telemetry.hpp"
+#include "mock_transport.hpp"
+#include "transport_adapter.hpp"
+
+/* Test cases :
+    1. A failed transport leaves nothing running
+    2. Producer handles own distinct rings and give them back
+    3. Thread local handles emit from several threads, all events arrive, the destructor invalidates them
+    4. Teardown waits for a slow transport only up to the flush timeout
+    5. Scoped spans push their records through a producer
+    6. Large payloads go through the payload pool and come back to it, oversized blocks are refused
+    7. A static ring and agent send without allocating and start again in place
+*/
+
+namespace {
+
+    // Counters and switch of a TestTransport, owned by the test so they outlive the facade
+    struct TransportState
+    {
+        std::atomic<bool> blocked{false};
+        std::atomic<uint64_t> sent{0};
+        std::atomic<int> shutdowns{0};
+    };
+
+    // Transport that counts into a TransportState and holds every event while it is blocked
+    class TestTransport final : public transport::ITransport
+    {
+    public:
+        explicit TestTransport(TransportState& state, bool init_result = true) : state_(state), init_result_(init_result) {}
+
+        bool Init(const transport::Config&) override { return init_result_; }
+
+        bool sendEvent(const telemetry_event_t&) override
+        {
+            while(state_.blocked.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            state_.sent.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void shutdown() override { state_.shutdowns.fetch_add(1, std::memory_order_relaxed); }
+
+    private:
+        TransportState& state_;
+        bool init_result_;
+    };
+
+    telemetry::Config small_config()
+    {
+        telemetry::Config config;
+        config.ring_capacity = 64;
+        config.max_producers = 3;
+        config.agent.heartbeat_interval_ns = 0;
+        return config;
+    }
+}
+
+// Local function prototype declaration
+static void testcase_failed_start(void);
+static void testcase_producer_handles(void);
+static void testcase_thread_local_producers(void);
+static void testcase_bounded_flush(void);
+static void testcase_scoped_spans(void);
+static void testcase_payload_pool(void);
+static void testcase_static_agent(void);
+
+extern "C" void test_telemetry(void);
+
+/**
+ * @brief Main entry point for running facade tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_telemetry()
+{
+    testcase_failed_start();
+    testcase_producer_handles();
+    testcase_thread_local_producers();
+    testcase_bounded_flush();
+    testcase_scoped_spans();
+    testcase_payload_pool();
+    testcase_static_agent();
+}
+
+/**
+ * @brief Tests a transport that fails to initialize.
+ */
+static void testcase_failed_start()
+{
+    TransportState state;
+
+    {
+        telemetry::Telemetry telemetry(std::make_unique<TestTransport>(state, false), small_config());
+
+        assert(telemetry.started() == false);
+        assert(telemetry.producer().valid() == false);
+        assert(telemetry.local().emit(1, nullptr, 0, TELEMETRY_LEVEL_ERROR) == false);
+        assert(telemetry.flush(0) == false);
+    }
+
+    // Too many producers for one agent
+    telemetry::Config config = small_config();
+    config.max_producers = TELEMETRY_AGENT_MAX_RINGS + 1u;
+    telemetry::Telemetry telemetry(std::make_unique<TestTransport>(state), config);
+    assert(telemetry.started() == false);
+
+    std::printf("Telemetry :: Test case facade failed start is passed. \n");
+}
+
+/**
+ * @brief Tests claiming and releasing rings.
+ */
+static void testcase_producer_handles()
+{
+    auto owned = std::make_unique<transport::MockTransport>(false);
+    transport::MockTransport* mock = owned.get();
+    telemetry::Telemetry telemetry(std::move(owned), small_config());
+
+    assert(telemetry.started() == true);
+
+    telemetry::Producer first = telemetry.producer();
+    telemetry::Producer second = telemetry.producer();
+    telemetry::Producer third = telemetry.producer();
+    assert(first.valid() && second.valid() && third.valid());
+    assert(first.ring() != second.ring() && second.ring() != third.ring() && first.ring() != third.ring());
+
+    // All rings taken
+    assert(telemetry.producer().valid() == false);
+
+    // A moved handle keeps the ring, a released one frees it
+    telemetry::Producer moved = std::move(second);
+    assert(second.valid() == false && moved.valid() == true);
+    moved = telemetry::Producer();
+
+    telemetry::Producer again = telemetry.producer();
+    assert(again.valid() == true);
+
+    for(uint32_t index = 0; index < 10; index++)
+    {
+        assert(first.emit(index, &index, sizeof(index), TELEMETRY_LEVEL_INFO) == true);
+        assert(again.emit(index, nullptr, 0, TELEMETRY_LEVEL_INFO) == true);
+    }
+
+    assert(telemetry.flush(1000000000ull) == true);
+
+    // Flushed rings are popped; the last batch may still be in the transport
+    for(int attempt = 0; attempt < 1000 && mock->sendCount() < 20; attempt++)
+    {
+        std::this_thread::yield();
+    }
+    assert(mock->sendCount() == 20);
+
+    std::printf("Telemetry :: Test case facade producer handles is passed. \n");
+}
+
+/**
+ * @brief Tests the thread local handles from several threads.
+ */
+static void testcase_thread_local_producers()
+{
+    TransportState state;
+    constexpr int kThreads = 3;
+    constexpr uint32_t kEvents = 40;
+
+    // A ring released by an exiting thread may be taken by the next one before the agent ran
+    telemetry::Config config = small_config();
+    config.ring_capacity = 2u * kThreads * kEvents;
+
+    {
+        telemetry::Telemetry telemetry(std::make_unique<TestTransport>(state), config);
+        assert(telemetry.started() == true);
+
+        for(int round = 0; round < 2; round++)
+        {
+            std::thread threads[kThreads];
+
+            for(std::thread& thread : threads)
+            {
+                thread = std::thread([&telemetry]() {
+                    telemetry::Producer& producer = telemetry.local();
+                    assert(producer.valid() == true);
+                    assert(&telemetry.local() == &producer);
+
+                    for(uint32_t index = 0; index < kEvents; index++)
+                    {
+                        assert(producer.emit(index, &index, sizeof(index), TELEMETRY_LEVEL_INFO) == true);
+                    }
+                });
+            }
+
+            for(std::thread& thread : threads)
+            {
+                thread.join();
+            }
+
+            assert(telemetry.flush(1000000000ull) == true);
+        }
+
+        // The exited threads gave their rings back
+        telemetry::Producer first = telemetry.producer();
+        telemetry::Producer second = telemetry.producer();
+        telemetry::Producer third = telemetry.producer();
+        assert(first.valid() && second.valid() && third.valid());
+    }
+
+    // Teardown stopped the agent, everything was sent
+    assert(state.sent.load() == 2u * kThreads * kEvents);
+
+    // A handle cached by a live thread is invalidated by the destructor
+    std::atomic<int> step{0};
+    auto* telemetry = new telemetry::Telemetry(std::make_unique<TestTransport>(state), config);
+    std::thread holder([telemetry, &step]() {
+        telemetry::Producer& producer = telemetry->local();
+        assert(producer.emit(1, nullptr, 0, TELEMETRY_LEVEL_INFO) == true);
+        step.store(1, std::memory_order_release);
+
+        while(step.load(std::memory_order_acquire) != 2)
+        {
+            std::this_thread::yield();
+        }
+
+        assert(producer.valid() == false);
+        assert(producer.emit(2, nullptr, 0, TELEMETRY_LEVEL_INFO) == false);
+    });
+
+    while(step.load(std::memory_order_acquire) != 1)
+    {
+        std::this_thread::yield();
+    }
+
+    delete telemetry;
+    step.store(2, std::memory_order_release);
+    holder.join();
+
+    std::printf("Telemetry :: Test case facade thread local producers is passed. \n");
+}
+
+/**
+ * @brief Tests that teardown does not wait for a stuck transport longer than configured.
+ */
+static void testcase_bounded_flush()
+{
+    TransportState state;
+    telemetry::Config config = small_config();
+    config.flush_timeout_ns = 20000000ull;
+
+    auto* telemetry = new telemetry::Telemetry(std::make_unique<TestTransport>(state), config);
+    assert(telemetry->started() == true);
+
+    state.blocked.store(true, std::memory_order_release);
+    {
+        telemetry::Producer producer = telemetry->producer();
+        for(uint32_t index = 0; index < 40; index++)
+        {
+            assert(producer.emit(index, nullptr, 0, TELEMETRY_LEVEL_WARNING) == true);
+        }
+    }
+
+    // The agent is stuck in the first send, the rings do not drain
+    assert(telemetry->flush(5000000ull) == false);
+
+    // Release the transport from another thread once the teardown flush timed out
+    const auto start = std::chrono::steady_clock::now();
+    std::thread release([&state]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        state.blocked.store(false, std::memory_order_release);
+    });
+
+    delete telemetry;
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    release.join();
+
+    // The flush gave up after its timeout, the stop then sent the rest
+    assert(elapsed >= std::chrono::milliseconds(20));
+    assert(state.sent.load() == 40);
+    assert(state.shutdowns.load() == 1);
+
+    std::printf("Telemetry :: Test case facade bounded flush is passed. \n");
+}
+
+/**
+ * @brief Tests the RAII span.
+ */
+static void testcase_scoped_spans()
+{
+    TransportState state;
+
+    {
+        telemetry::Telemetry telemetry(std::make_unique<TestTransport>(state), small_config());
+        telemetry::Producer producer = telemetry.producer();
+        uint64_t trace_id = 0;
+
+        {
+            telemetry::Span request(producer, 100);
+            trace_id = request.traceId();
+            assert(request.active() == true);
+
+            {
+                telemetry::Span step(producer, 101, TELEMETRY_LEVEL_DEBUG);
+                assert(step.traceId() == trace_id && step.spanId() != request.spanId());
+            }
+
+            // Ended early, the destructor does nothing more
+            request.end();
+            assert(request.active() == false);
+        }
+
+        // An invalid producer gives an inactive span
+        telemetry::Producer none;
+        telemetry::Span unused(none, 102);
+        assert(unused.active() == false);
+        assert(telemetry_span_current() == nullptr);
+        assert(trace_id != 0);
+    }
+
+    assert(state.sent.load() == 2);
+
+    std::printf("Telemetry :: Test case facade scoped spans is passed. \n");
+}
+
+/**
+ * @brief Tests large payloads through the facade's pool.
+ */
+static void testcase_payload_pool()
+{
+    auto owned = std::make_unique<transport::MockTransport>(false);
+    transport::MockTransport* mock = owned.get();
+    telemetry::Config config = small_config();
+    memory_pool_stats_t stats;
+
+    // Without a configured pool there are no blocks
+    {
+        telemetry::Telemetry plain(std::make_unique<transport::MockTransport>(false), small_config());
+        assert(plain.payloadPool() == nullptr);
+        assert(plain.producer().allocPayload() == nullptr);
+    }
+
+    // Blocks larger than any event payload are refused
+    {
+        telemetry::Config oversize = small_config();
+        oversize.payload_block_size = TELEMETRY_EVENT_POOLED_PAYLOAD_MAX + 1u;
+        oversize.payload_block_count = 2;
+
+        telemetry::Telemetry refused(std::make_unique<transport::MockTransport>(false), oversize);
+        assert(refused.started() == false);
+        assert(refused.payloadPool() == nullptr);
+    }
+
+    config.payload_block_size = 4096;
+    config.payload_block_count = 8;
+    telemetry::Telemetry telemetry(std::move(owned), config);
+    telemetry::Producer producer = telemetry.producer();
+
+    assert(telemetry.payloadPool() != nullptr);
+
+    for(uint32_t index = 0; index < 3; index++)
+    {
+        uint8_t* block = static_cast<uint8_t*>(producer.allocPayload());
+        assert(block != nullptr);
+        std::memset(block, static_cast<int>(index), 4000);
+        assert(producer.emitPayload(200, block, 4000, TELEMETRY_LEVEL_INFO) == true);
+    }
+
+    // A filtered event gives its block back at once
+    assert(telemetry_event_filter_set(201, false) == true);
+    assert(producer.emitPayload(201, producer.allocPayload(), 100, TELEMETRY_LEVEL_INFO) == false);
+    assert(telemetry_event_filter_set(201, true) == true);
+
+    assert(telemetry.flush(1000000000ull) == true);
+
+    for(int attempt = 0; attempt < 1000 && mock->sendCount() < 3; attempt++)
+    {
+        std::this_thread::yield();
+    }
+    assert(mock->sendCount() == 3);
+
+    // Blocks return after the send, poll for the last one
+    memory_pool_stats(telemetry.payloadPool(), &stats);
+    for(int attempt = 0; attempt < 1000 && stats.in_use != 0; attempt++)
+    {
+        std::this_thread::yield();
+        memory_pool_stats(telemetry.payloadPool(), &stats);
+    }
+    assert(stats.in_use == 0);
+
+    std::printf("Telemetry :: Test case facade payload pool is passed. \n");
+}
+
+/**
+ * @brief Tests the ring and agent templates with their own storage.
+ */
+static void testcase_static_agent()
+{
+    static telemetry::StaticRing<32> ring;
+    static telemetry::StaticAgent<> agent;
+    transport::MockTransport mock(false);
+    transport_c_t c_transport = transport_adapter::make_transport_adapter(mock);
+    telemetry_event_t event;
+
+    assert(ring.get() != nullptr);
+    assert(ring_buffer_capacity(ring.get()) == 32);
+    assert(agent.get() == nullptr);
+
+    for(int round = 0; round < 2; round++)
+    {
+        assert(agent.start(ring.get(), &c_transport) == true);
+        assert(agent.start(ring.get(), &c_transport) == false);
+
+        for(uint32_t index = 0; index < 10; index++)
+        {
+            telemetry_event_make(&event, index, nullptr, 0, TELEMETRY_LEVEL_INFO);
+            assert(ring_buffer_push(ring.get(), &event) == true);
+        }
+
+        telemetry_agent_notify(agent.get());
+        assert(telemetry_agent_flush(agent.get(), 1000000000ull) == true);
+
+        agent.stop();
+        assert(agent.get() == nullptr);
+    }
+
+    assert(mock.sendCount() == 20);
+
+    std::printf("Telemetry :: Test case facade static ring and agent is passed. \n");
+}
@@ -0,0 +1,241 @@
+/**
+ * @file test_thread.c
+ * @brief Unit tests for the OSAL threads.
+ *
+ * This file contains test cases for the thread names and the placement
+ * attributes: CPU affinity, real time policy, stack size and the
+ * pre-start hook.
+ * @author Aravinthraj Ganesan
+ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "osal_thread.h"
+
+/* Test cases :
+    1. Default thread runs, applies nothing and keeps a 15 character name
+    2. Affinity pins the thread to CPU 0, out of range CPUs are refused
+    3. Real time policy is applied or refused, the thread runs either way
+    4. Stack size is applied and the hook runs on the thread before entry
+*/
+
+// Requested stack size of case 4
+#define TEST_THREAD_STACK_BYTES (256u * 1024u)
+
+typedef struct thread_probe_s {
+    atomic_bool release;        // Set by the test once the handle is complete
+    atomic_int hook_calls;
+    bool hook_before_entry;
+    char name[32];
+    int cpu_count;              // CPUs in the affinity of the thread
+    int cpu;                    // CPU the thread ran on
+    int policy;
+    size_t stack_size;
+    pthread_t hook_thread;
+    pthread_t entry_thread;
+} thread_probe_t;
+
+// Local function prototype declaration
+static void testcase_default(void);
+static void testcase_affinity(void);
+static void testcase_scheduling(void);
+static void testcase_stack_and_hook(void);
+
+void test_thread(void);
+
+/**
+ * @brief Main entry point for running thread tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_thread()
+{
+    testcase_default();
+    testcase_affinity();
+    testcase_scheduling();
+    testcase_stack_and_hook();
+}
+
+static void probe_hook(void* context)
+{
+    thread_probe_t* probe = (thread_probe_t*)context;
+
+    probe->hook_thread = pthread_self();
+    atomic_fetch_add(&probe->hook_calls, 1);
+}
+
+static void* probe_worker(void* arg)
+{
+    thread_probe_t* probe = (thread_probe_t*)arg;
+    struct sched_param param;
+    pthread_attr_t attr;
+    cpu_set_t set;
+
+    probe->entry_thread = pthread_self();
+    probe->hook_before_entry = atomic_load(&probe->hook_calls) == 1;
+
+    // The name is set by the creating thread after pthread_create
+    while(!atomic_load(&probe->release))
+    {
+        sched_yield();
+    }
+
+    (void)pthread_getname_np(pthread_self(), probe->name, sizeof(probe->name));
+
+    CPU_ZERO(&set);
+    assert(pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0);
+    probe->cpu_count = CPU_COUNT(&set);
+    probe->cpu = sched_getcpu();
+
+    assert(pthread_getschedparam(pthread_self(), &probe->policy, &param) == 0);
+
+    assert(pthread_getattr_np(pthread_self(), &attr) == 0);
+    assert(pthread_attr_getstacksize(&attr, &probe->stack_size) == 0);
+    pthread_attr_destroy(&attr);
+
+    return NULL;
+}
+
+/**
+ * @brief Runs the probe on a new thread and waits for it.
+ *
+ * @param probe Probe to fill.
+ * @param name Thread name.
+ * @param attr Placement, NULL for the defaults.
+ * @return Applied bits of the thread.
+ */
+static uint32_t run_probe(thread_probe_t* probe, const char* name, const osal_thread_attr_t* attr)
+{
+    osal_thread_t* thread = NULL;
+
+    memset(probe, 0, sizeof(*probe));
+    atomic_init(&probe->release, false);
+    atomic_init(&probe->hook_calls, 0);
+
+    if(attr == NULL)
+        assert(osal_thread_create(&thread, probe_worker, probe, name) == 0);
+    else
+        assert(osal_thread_create_ex(&thread, probe_worker, probe, name, attr) == 0);
+
+    atomic_store(&probe->release, true);
+    assert(osal_thread_join(thread) == 0);
+
+    const uint32_t applied = osal_thread_applied(thread);
+    osal_thread_destroy(thread);
+
+    return applied;
+}
+
+/**
+ * @brief Tests a thread without attributes and its name.
+ */
+static void testcase_default()
+{
+    thread_probe_t probe;
+
+    // Longest name Linux keeps, it used to be cut after the size of a pointer
+    assert(run_probe(&probe, "telemetry_agent", NULL) == 0);
+    assert(strcmp(probe.name, "telemetry_agent") == 0);
+    assert(probe.policy == SCHED_OTHER);
+
+    // Longer names are truncated to 15 characters
+    assert(run_probe(&probe, "telemetry_agent_consumer", NULL) == 0);
+    assert(strcmp(probe.name, "telemetry_agent") == 0);
+
+    assert(osal_thread_create(NULL, probe_worker, &probe, "test") != 0);
+    assert(osal_thread_applied(NULL) == 0);
+
+    printf("Telemetry :: Test case thread default is passed. \n");
+}
+
+/**
+ * @brief Tests the CPU affinity.
+ */
+static void testcase_affinity()
+{
+    osal_thread_attr_t attr;
+    thread_probe_t probe;
+
+    osal_thread_attr_init(&attr);
+    assert(osal_thread_attr_set_cpu(&attr, OSAL_THREAD_MAX_CPUS) == false);
+    assert(osal_thread_attr_set_cpu(NULL, 0) == false);
+    assert(osal_thread_attr_set_cpu(&attr, 0) == true);
+
+    const uint32_t applied = run_probe(&probe, "test_affinity", &attr);
+
+    assert((applied & OSAL_THREAD_APPLIED_AFFINITY) != 0);
+    assert(probe.cpu_count == 1);
+    assert(probe.cpu == 0);
+
+    printf("Telemetry :: Test case thread affinity is passed. \n");
+}
+
+/**
+ * @brief Tests the real time policy and its fallback.
+ */
+static void testcase_scheduling()
+{
+    osal_thread_attr_t attr;
+    thread_probe_t probe;
+
+    osal_thread_attr_init(&attr);
+    attr.policy = OSAL_THREAD_POLICY_FIFO;
+    attr.priority = 1000;                   // Clamped to the highest priority
+
+    uint32_t applied = run_probe(&probe, "test_fifo", &attr);
+
+    // Without CAP_SYS_NICE the thread keeps the default policy but still runs
+    if((applied & OSAL_THREAD_APPLIED_SCHEDULING) != 0)
+        assert(probe.policy == SCHED_FIFO);
+    else
+        assert(probe.policy == SCHED_OTHER);
+
+    attr.policy = OSAL_THREAD_POLICY_RR;
+    attr.priority = 1;
+
+    applied = run_probe(&probe, "test_rr", &attr);
+
+    if((applied & OSAL_THREAD_APPLIED_SCHEDULING) != 0)
+        assert(probe.policy == SCHED_RR);
+    else
+        assert(probe.policy == SCHED_OTHER);
+
+    printf("Telemetry :: Test case thread scheduling is passed. \n");
+}
+
+/**
+ * @brief Tests the stack size and the pre-start hook.
+ */
+static void testcase_stack_and_hook()
+{
+    osal_thread_attr_t attr;
+    thread_probe_t probe;
+
+    osal_thread_attr_init(&attr);
+    attr.stack_size = TEST_THREAD_STACK_BYTES;
+    attr.pre_start = probe_hook;
+    attr.pre_start_context = &probe;
+
+    const uint32_t applied = run_probe(&probe, "test_stack", &attr);
+
+    assert((applied & OSAL_THREAD_APPLIED_STACK_SIZE) != 0);
+    assert((applied & OSAL_THREAD_APPLIED_AFFINITY) == 0);
+    assert(probe.stack_size >= TEST_THREAD_STACK_BYTES);
+    assert(probe.stack_size < 2u * TEST_THREAD_STACK_BYTES);
+
+    // Once, on the new thread, before the entry function
+    assert(atomic_load(&probe.hook_calls) == 1);
+    assert(probe.hook_before_entry);
+    assert(pthread_equal(probe.hook_thread, probe.entry_thread));
+
+    printf("Telemetry :: Test case thread stack and hook is passed. \n");
+}
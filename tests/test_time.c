@@ -0,0 +1,262 @@
+/**
+ * @file test_time.c
+ * @brief Unit tests for the OSAL clock.
+ *
+ * This file contains test cases for the clock source selection, the tick
+ * conversion, the resync against CLOCK_MONOTONIC and the coarse clock,
+ * also while signals are delivered.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "osal_time.h"
+
+/* Test cases :
+    1. A clock source is selected and reports its frequency
+    2. Time never goes backwards on one thread
+    3. Converted ticks track CLOCK_MONOTONIC, also across a resync
+    4. Ticks converted later give the time they were taken
+    5. Coarse clock lags by at most its period, with and without the service
+    6. Signals without SA_RESTART do not stop the coarse clock service
+*/
+
+// Largest accepted distance to CLOCK_MONOTONIC (1 ms)
+#define TEST_TIME_TOLERANCE_NS 1000000ll
+
+// Local function prototype declaration
+static void testcase_source(void);
+static void testcase_monotonic(void);
+static void testcase_track_monotonic(void);
+static void testcase_deferred_conversion(void);
+static void testcase_coarse_clock(void);
+static void testcase_coarse_clock_signals(void);
+
+void test_time(void);
+
+/**
+ * @brief Main entry point for running clock tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_time()
+{
+    testcase_source();
+    testcase_monotonic();
+    testcase_track_monotonic();
+    testcase_deferred_conversion();
+    testcase_coarse_clock();
+    testcase_coarse_clock_signals();
+}
+
+static uint64_t clock_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(long milliseconds)
+{
+    struct timespec ts = { 0, milliseconds * 1000000l };
+    nanosleep(&ts, NULL);
+}
+
+static int64_t distance_to_monotonic(void)
+{
+    return (int64_t)(osal_telemetry_now_monotonic_ns() - clock_monotonic_ns());
+}
+
+/**
+ * @brief Tests the clock source selection.
+ */
+static void testcase_source()
+{
+    const osal_clock_source_t source = osal_time_init();
+
+    assert(source == OSAL_CLOCK_SOURCE_MONOTONIC || source == OSAL_CLOCK_SOURCE_TSC);
+    assert(osal_time_source() == source);
+    assert(osal_time_ticks_per_second() > 0);
+
+    if(source == OSAL_CLOCK_SOURCE_MONOTONIC)
+    {
+        assert(osal_time_ticks_per_second() == 1000000000ull);
+    }
+
+    printf("Telemetry :: Test case clock source is passed. \n");
+}
+
+/**
+ * @brief Tests that consecutive reads never decrease.
+ */
+static void testcase_monotonic()
+{
+    uint64_t previous = osal_telemetry_now_monotonic_ns();
+
+    for(int index = 0; index < 100000; index++)
+    {
+        const uint64_t now = osal_telemetry_now_monotonic_ns();
+        assert(now >= previous);
+        previous = now;
+    }
+
+    printf("Telemetry :: Test case clock monotonic is passed. \n");
+}
+
+/**
+ * @brief Tests that the clock stays close to CLOCK_MONOTONIC.
+ */
+static void testcase_track_monotonic()
+{
+    int64_t distance = distance_to_monotonic();
+    assert(distance < TEST_TIME_TOLERANCE_NS && distance > -TEST_TIME_TOLERANCE_NS);
+
+    // Resync needs some time since the last one to measure the rate
+    sleep_ms(20);
+    const uint64_t before = osal_telemetry_now_monotonic_ns();
+    osal_time_resync();
+    assert(osal_telemetry_now_monotonic_ns() >= before);
+
+    distance = distance_to_monotonic();
+    assert(distance < TEST_TIME_TOLERANCE_NS && distance > -TEST_TIME_TOLERANCE_NS);
+
+    printf("Telemetry :: Test case clock tracks monotonic is passed. \n");
+}
+
+/**
+ * @brief Tests converting ticks some time after they were taken.
+ */
+static void testcase_deferred_conversion()
+{
+    const uint64_t ticks = osal_telemetry_now_ticks();
+    const uint64_t taken_ns = clock_monotonic_ns();
+
+    sleep_ms(5);
+    osal_time_resync();
+
+    const int64_t distance = (int64_t)(osal_time_ticks_to_ns(ticks) - taken_ns);
+    assert(distance < TEST_TIME_TOLERANCE_NS && distance > -TEST_TIME_TOLERANCE_NS);
+    assert(osal_time_ticks_to_ns(osal_telemetry_now_ticks()) >= osal_time_ticks_to_ns(ticks) + 5000000ull);
+
+    printf("Telemetry :: Test case clock deferred conversion is passed. \n");
+}
+
+/**
+ * @brief Returns true if coarse is behind precise by no more than lag_ns.
+ */
+static bool coarse_within(uint64_t coarse_ns, uint64_t precise_ns, uint64_t lag_ns)
+{
+    return (coarse_ns <= precise_ns + (uint64_t)TEST_TIME_TOLERANCE_NS) &&
+           (coarse_ns + lag_ns + (uint64_t)TEST_TIME_TOLERANCE_NS >= precise_ns);
+}
+
+/**
+ * @brief Tests the coarse clock service and its fallback.
+ */
+static void testcase_coarse_clock()
+{
+    // Fallback to CLOCK_MONOTONIC_COARSE, the scheduler may add a few ticks on a busy machine
+    const uint64_t fallback_lag_ns = osal_time_coarse_resolution_ns() * 4u;
+    assert(fallback_lag_ns > 0);
+    assert(coarse_within(osal_telemetry_now_coarse_ns(), osal_telemetry_now_monotonic_ns(), fallback_lag_ns));
+
+    assert(osal_time_coarse_start(OSAL_TIME_COARSE_MIN_PERIOD_NS - 1u) == false);
+    assert(osal_time_coarse_start(0) == true);
+    assert(osal_time_coarse_resolution_ns() == OSAL_TIME_COARSE_DEFAULT_PERIOD_NS);
+
+    // A second user shares the running service and its period
+    assert(osal_time_coarse_start(OSAL_TIME_COARSE_MAX_PERIOD_NS) == true);
+    assert(osal_time_coarse_resolution_ns() == OSAL_TIME_COARSE_DEFAULT_PERIOD_NS);
+
+    const uint64_t first_ns = osal_telemetry_now_coarse_ns();
+    assert(coarse_within(first_ns, osal_telemetry_now_monotonic_ns(), 20000000ull));
+
+    sleep_ms(10);
+
+    const uint64_t later_ns = osal_telemetry_now_coarse_ns();
+    assert(later_ns > first_ns);
+    assert(coarse_within(later_ns, osal_telemetry_now_monotonic_ns(), 20000000ull));
+
+    // Still running after the first release
+    osal_time_coarse_stop();
+    assert(osal_time_coarse_resolution_ns() == OSAL_TIME_COARSE_DEFAULT_PERIOD_NS);
+
+    // The last release falls back to the kernel clock
+    osal_time_coarse_stop();
+    assert(osal_time_coarse_resolution_ns() * 4u == fallback_lag_ns);
+
+    // Extra releases are ignored
+    osal_time_coarse_stop();
+    assert(coarse_within(osal_telemetry_now_coarse_ns(), osal_telemetry_now_monotonic_ns(), fallback_lag_ns));
+
+    printf("Telemetry :: Test case coarse clock is passed. \n");
+}
+
+static atomic_uint coarse_signals;
+
+static void count_signal(int signal_number)
+{
+    (void)signal_number;
+    atomic_fetch_add_explicit(&coarse_signals, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Tests that the coarse clock keeps running while signals arrive.
+ */
+static void testcase_coarse_clock_signals()
+{
+    struct sigaction action;
+    struct sigaction previous;
+    sigset_t usr1;
+    sigset_t old_mask;
+
+    atomic_init(&coarse_signals, 0);
+
+    // No SA_RESTART : a blocking read in the receiving thread fails with EINTR
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = count_signal;
+    sigemptyset(&action.sa_mask);
+    assert(sigaction(SIGUSR1, &action, &previous) == 0);
+
+    assert(osal_time_coarse_start(0) == true);
+
+    // Blocked here, a process signal can only go to a thread that accepts it
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    assert(pthread_sigmask(SIG_BLOCK, &usr1, &old_mask) == 0);
+
+    for(int index = 0; index < 20; index++)
+    {
+        assert(kill(getpid(), SIGUSR1) == 0);
+        sleep_ms(1);
+    }
+
+    sleep_ms(20);
+
+    // The service still publishes
+    const uint64_t first_ns = osal_telemetry_now_coarse_ns();
+    sleep_ms(20);
+    const uint64_t later_ns = osal_telemetry_now_coarse_ns();
+
+    assert(later_ns > first_ns);
+    assert(coarse_within(later_ns, osal_telemetry_now_monotonic_ns(), 20000000ull));
+
+    // The pending signal runs here once it is unblocked
+    assert(pthread_sigmask(SIG_SETMASK, &old_mask, NULL) == 0);
+    assert(atomic_load_explicit(&coarse_signals, memory_order_relaxed) >= 1u);
+
+    osal_time_coarse_stop();
+    assert(sigaction(SIGUSR1, &previous, NULL) == 0);
+
+    printf("Telemetry :: Test case coarse clock signals is passed. \n");
+}
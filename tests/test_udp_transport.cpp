@@ -0,0 +1,514 @@
+/**
+ * @file test_udp_transport.cpp
+ * @brief Unit tests for the UDP transport.
+ *
+ * This file contains test cases for sending events and messages to a
+ * loopback receiver with sendto and through the io_uring send path, on
+ * its own and driven by the agent.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "udp_transport.hpp"
+#include "transport_adapter.hpp"
+
+extern "C" {
+    #include "telemetry_agent.h"
+    #include "ring_buffer.h"
+    #include "memory_pool.h"
+    #include "telemetry_protocol.h"
+}
+
+/* Test cases :
+    1. sendto : events arrive as JSON datagrams, messages as they are
+    2. io_uring : more events than slots arrive once each after a flush
+    3. io_uring with SQPOLL and registered buffers, driven by the agent's flush hook
+    4. Pooled payloads : sent whole beyond 128 bytes, refused when they do not fit a datagram
+    5. io_uring and sendto refuse the same events at a limit that is not a multiple of 64
+    6. The agent sends pooled payloads larger than a datagram as fragment messages that reassemble
+*/
+
+// Events per test
+#define TEST_UDP_EVENTS 100u
+
+// Pooled payload sizes : larger than an inline payload, and larger than a datagram
+#define TEST_UDP_POOLED_BYTES 300u
+#define TEST_UDP_OVERSIZE_BYTES 1024u
+// Pooled payload the agent splits into fragments
+#define TEST_UDP_FRAGMENTED_BYTES 5000u
+
+// Local function prototype declaration
+static void testcase_sendto(void);
+static void testcase_io_uring(void);
+static void testcase_io_uring_agent(void);
+static void testcase_pooled_payload(void);
+static void testcase_io_uring_limit(void);
+static void testcase_pooled_fragments(void);
+
+extern "C" void test_udp_transport(void);
+
+/**
+ * @brief Main entry point for running UDP transport tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_udp_transport()
+{
+    testcase_sendto();
+    testcase_io_uring();
+    testcase_io_uring_agent();
+    testcase_pooled_payload();
+    testcase_io_uring_limit();
+    testcase_pooled_fragments();
+}
+
+/**
+ * @brief Opens a loopback receiver and returns its "127.0.0.1:port" endpoint.
+ */
+static int open_receiver(std::string& endpoint)
+{
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const int receiver = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    assert(receiver >= 0);
+
+    // Room for every datagram of a test, loopback drops what does not fit
+    int receive_buffer = 4 << 20;
+    (void)::setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+
+    assert(::bind(receiver, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    assert(::getsockname(receiver, reinterpret_cast<sockaddr*>(&address), &length) == 0);
+
+    endpoint = "127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+
+    return receiver;
+}
+
+/**
+ * @brief Receives one datagram, waiting up to a second.
+ *
+ * @return Datagram bytes, empty on timeout.
+ */
+static std::string receive_datagram(int receiver)
+{
+    pollfd ready{ receiver, POLLIN, 0 };
+    char buffer[2048];
+
+    if(::poll(&ready, 1, 1000) != 1)
+        return std::string();
+
+    const ssize_t length = ::recv(receiver, buffer, sizeof(buffer), 0);
+    assert(length > 0);
+
+    return std::string(buffer, static_cast<size_t> (length));
+}
+
+/**
+ * @brief Receives JSON event datagrams and checks every id arrives once.
+ *
+ * Binary messages such as heartbeats are skipped.
+ */
+static void expect_events(int receiver, uint32_t first_id, uint32_t count)
+{
+    std::vector<bool> seen(count, false);
+    uint32_t received = 0;
+
+    while(received < count)
+    {
+        const std::string datagram = receive_datagram(receiver);
+        assert(!datagram.empty());
+
+        if(datagram[0] != '{')
+            continue;
+
+        const unsigned long id = std::strtoul(datagram.c_str() + std::strlen("{\"id\":"), nullptr, 10);
+
+        assert(datagram.compare(0, 6, "{\"id\":") == 0);
+        assert(id >= first_id && id < first_id + count);
+        assert(!seen[id - first_id]);
+
+        seen[id - first_id] = true;
+        received++;
+    }
+}
+
+/**
+ * @brief Tests the sendto path.
+ */
+static void testcase_sendto()
+{
+    transport::UdpTransport udp;
+    transport::Config config;
+    telemetry_event_t event;
+    std::string endpoint;
+    const uint8_t message[4] = { 0xAB, 1, 2, 3 };
+
+    const int receiver = open_receiver(endpoint);
+    config.endpoint = endpoint.c_str();
+
+    assert(udp.Init(config) == true);
+    assert(udp.usesIoUring() == false);
+    assert(udp.ioUringApplied() == 0);
+
+    for(uint32_t index = 0; index < 10u; index++)
+    {
+        telemetry_event_make(&event, 500u + index, nullptr, 0, TELEMETRY_LEVEL_INFO);
+        assert(udp.sendEvent(event) == true);
+    }
+
+    // Sent right away, nothing to flush
+    assert(udp.flush() == true);
+    expect_events(receiver, 500u, 10u);
+
+    assert(udp.sendMessage(message, sizeof(message)) == true);
+    assert(receive_datagram(receiver) == std::string(reinterpret_cast<const char*>(message), sizeof(message)));
+
+    udp.shutdown();
+    assert(udp.sendEvent(event) == false);
+    ::close(receiver);
+
+    std::printf("Telemetry :: Test case udp transport sendto is passed. \n");
+}
+
+/**
+ * @brief Tests the io_uring path with more events than slots.
+ */
+static void testcase_io_uring()
+{
+    transport::UdpTransport udp;
+    transport::Config config;
+    telemetry_event_t event;
+    std::string endpoint;
+    const uint8_t message[4] = { 0xCD, 4, 5, 6 };
+
+    const int receiver = open_receiver(endpoint);
+    config.endpoint = endpoint.c_str();
+    config.io_uring = true;
+    config.io_uring_entries = 8;
+
+    // Falls back to sendto where the kernel has no io_uring, the datagrams are the same
+    assert(udp.Init(config) == true);
+    assert(udp.ioUringApplied() == 0);
+
+    for(uint32_t index = 0; index < TEST_UDP_EVENTS; index++)
+    {
+        telemetry_event_make(&event, 1000u + index, nullptr, 0, TELEMETRY_LEVEL_INFO);
+        assert(udp.sendEvent(event) == true);
+    }
+
+    assert(udp.flush() == true);
+    expect_events(receiver, 1000u, TEST_UDP_EVENTS);
+
+    assert(udp.sendMessage(message, sizeof(message)) == true);
+    assert(udp.flush() == true);
+    assert(receive_datagram(receiver) == std::string(reinterpret_cast<const char*>(message), sizeof(message)));
+
+    assert(udp.asyncSendErrors() == 0);
+
+    udp.shutdown();
+    assert(udp.usesIoUring() == false);
+    ::close(receiver);
+
+    std::printf("Telemetry :: Test case udp transport io_uring is passed. \n");
+}
+
+/**
+ * @brief Tests the io_uring options behind the agent.
+ */
+static void testcase_io_uring_agent()
+{
+    transport::UdpTransport udp;
+    transport::Config config;
+    telemetry_event_t event;
+    std::string endpoint;
+    ring_buffer_t* ring = nullptr;
+    telemetry_agent_t* agent = nullptr;
+
+    const int receiver = open_receiver(endpoint);
+    config.endpoint = endpoint.c_str();
+    config.io_uring = true;
+    config.io_uring_entries = 16;
+    config.io_uring_sqpoll = true;
+    config.io_uring_registered_buffers = true;
+
+    assert(udp.Init(config) == true);
+
+    transport_c_t c_transport = transport_adapter::make_transport_adapter(udp);
+    assert(c_transport.flush != nullptr);
+
+    assert(ring_buffer_init(&ring, 256) == true);
+    assert(telemetry_agent_start(&agent, ring, &c_transport) == true);
+
+    for(uint32_t index = 0; index < TEST_UDP_EVENTS; index++)
+    {
+        telemetry_event_make(&event, 2000u + index, nullptr, 0, TELEMETRY_LEVEL_INFO);
+        assert(ring_buffer_push(ring, &event) == true);
+    }
+
+    telemetry_agent_notify(agent);
+
+    // The agent flushes before it waits again, no explicit flush needed
+    expect_events(receiver, 2000u, TEST_UDP_EVENTS);
+
+    telemetry_agent_stop(agent);
+    ring_buffer_free(ring);
+
+    assert(udp.asyncSendErrors() == 0);
+    udp.shutdown();
+    ::close(receiver);
+
+    std::printf("Telemetry :: Test case udp transport io_uring agent is passed. \n");
+}
+
+/**
+ * @brief Checks that a datagram carries every byte of a pattern payload.
+ */
+static void expect_payload(const std::string& datagram, uint32_t id, uint32_t payload_bytes)
+{
+    static const char* strHex = "0123456789abcdef";
+    std::string payload_hex;
+
+    for(uint32_t index = 0; index < payload_bytes; index++)
+    {
+        const uint8_t value = static_cast<uint8_t> (index);
+
+        payload_hex.push_back(strHex[value >> 4]);
+        payload_hex.push_back(strHex[value & 0x0F]);
+    }
+
+    assert(datagram.compare(0, 6, "{\"id\":") == 0);
+    assert(std::strtoul(datagram.c_str() + 6, nullptr, 10) == id);
+    assert(datagram.find("\"payload_len\":" + std::to_string(payload_bytes) + ",") != std::string::npos);
+    assert(datagram.find("\"payload_hex\":\"" + payload_hex + "\"}\n") != std::string::npos);
+}
+
+/**
+ * @brief Tests pooled payloads larger than an inline payload.
+ */
+static void testcase_pooled_payload()
+{
+    transport::UdpTransport udp;
+    transport::Config config;
+    telemetry_event_t event;
+    std::string endpoint;
+    memory_pool_t* pool = nullptr;
+
+    const int receiver = open_receiver(endpoint);
+    config.endpoint = endpoint.c_str();
+    config.mtu = 1200;
+
+    assert(udp.Init(config) == true);
+    assert(memory_pool_init(&pool, TEST_UDP_OVERSIZE_BYTES, 2) == true);
+
+    uint8_t* block = static_cast<uint8_t*> (memory_pool_alloc(pool));
+    assert(block != nullptr);
+
+    for(uint32_t index = 0; index < TEST_UDP_OVERSIZE_BYTES; index++)
+        block[index] = static_cast<uint8_t> (index);
+
+    // Every byte arrives, with sendEvent and from a signal handler
+    assert(telemetry_event_make_pooled(&event, 3000u, pool, block, TEST_UDP_POOLED_BYTES, TELEMETRY_LEVEL_INFO) == true);
+    assert(udp.sendEvent(event) == true);
+    expect_payload(receive_datagram(receiver), 3000u, TEST_UDP_POOLED_BYTES);
+
+    assert(udp.sendEventSignalSafe(event) == true);
+    expect_payload(receive_datagram(receiver), 3000u, TEST_UDP_POOLED_BYTES);
+    telemetry_event_release_payload(&event);
+
+    // Too large for one datagram : refused and counted, nothing cut short is sent
+    block = static_cast<uint8_t*> (memory_pool_alloc(pool));
+    assert(block != nullptr);
+
+    for(uint32_t index = 0; index < TEST_UDP_OVERSIZE_BYTES; index++)
+        block[index] = static_cast<uint8_t> (index);
+
+    assert(telemetry_event_make_pooled(&event, 3001u, pool, block, TEST_UDP_OVERSIZE_BYTES, TELEMETRY_LEVEL_INFO) == true);
+    assert(udp.sendEvent(event) == false);
+    assert(udp.sendEventSignalSafe(event) == false);
+    assert(udp.oversizeEvents() == 2u);
+    telemetry_event_release_payload(&event);
+
+    pollfd ready{ receiver, POLLIN, 0 };
+    assert(::poll(&ready, 1, 100) == 0);
+
+    udp.shutdown();
+    memory_pool_free(pool);
+    ::close(receiver);
+
+    std::printf("Telemetry :: Test case udp transport pooled payload is passed. \n");
+}
+
+/**
+ * @brief Tests that the io_uring slots keep the sendto datagram limit.
+ */
+static void testcase_io_uring_limit()
+{
+    transport::UdpTransport sendto_udp;
+    transport::UdpTransport uring_udp;
+    transport::Config sendto_config;
+    transport::Config uring_config;
+    telemetry_event_t event;
+    std::string sendto_endpoint;
+    std::string uring_endpoint;
+    uint8_t payload[TELEMETRY_EVENT_PAYLOAD_MAX];
+    uint32_t sent = 0;
+    uint32_t refused = 0;
+
+    const int sendto_receiver = open_receiver(sendto_endpoint);
+    const int uring_receiver = open_receiver(uring_endpoint);
+
+    // Slots are 320 bytes apart, datagrams stay within 300
+    sendto_config.endpoint = sendto_endpoint.c_str();
+    sendto_config.mtu = 300;
+    uring_config.endpoint = uring_endpoint.c_str();
+    uring_config.mtu = 300;
+    uring_config.io_uring = true;
+    uring_config.io_uring_entries = 8;
+
+    assert(sendto_udp.Init(sendto_config) == true);
+    assert(uring_udp.Init(uring_config) == true);
+
+    std::memset(payload, 0x5A, sizeof(payload));
+
+    // The JSON line grows by two bytes per payload byte and crosses the limit
+    for(uint32_t size = 64; size <= TELEMETRY_EVENT_PAYLOAD_MAX; size++)
+    {
+        telemetry_event_make(&event, 4000u + size, payload, size, TELEMETRY_LEVEL_INFO);
+
+        const bool sendto_sent = sendto_udp.sendEvent(event);
+        assert(uring_udp.sendEvent(event) == sendto_sent);
+
+        if(sendto_sent)
+            sent++;
+        else
+            refused++;
+    }
+
+    assert(sent > 0 && refused > 0);
+    assert(uring_udp.flush() == true);
+
+    for(uint32_t index = 0; index < sent; index++)
+    {
+        assert(receive_datagram(sendto_receiver).size() <= 300u);
+        assert(receive_datagram(uring_receiver).size() <= 300u);
+    }
+
+    assert(sendto_udp.oversizeEvents() == refused);
+    assert(uring_udp.oversizeEvents() == refused);
+
+    sendto_udp.shutdown();
+    uring_udp.shutdown();
+    ::close(sendto_receiver);
+    ::close(uring_receiver);
+
+    std::printf("Telemetry :: Test case udp transport io_uring limit is passed. \n");
+}
+
+/**
+ * @brief Tests pooled payloads the agent splits into fragment messages.
+ */
+static void testcase_pooled_fragments()
+{
+    transport::UdpTransport udp;
+    transport::Config config;
+    telemetry_event_t event;
+    std::string endpoint;
+    ring_buffer_t* ring = nullptr;
+    telemetry_agent_t* agent = nullptr;
+    telemetry_agent_config_t agent_config;
+    memory_pool_t* pool = nullptr;
+    memory_pool_stats_t stats;
+
+    const int receiver = open_receiver(endpoint);
+    config.endpoint = endpoint.c_str();
+    config.mtu = 1200;
+
+    assert(udp.Init(config) == true);
+    assert(udp.maxMessageBytes() == 1200u);
+
+    transport_c_t c_transport = transport_adapter::make_transport_adapter(udp);
+
+    // Messages as large as a datagram, so each fragment fills one
+    telemetry_agent_config_init(&agent_config);
+    agent_config.max_message_bytes = 2048;
+
+    assert(memory_pool_init(&pool, TEST_UDP_FRAGMENTED_BYTES, 2) == true);
+    assert(ring_buffer_init(&ring, 16) == true);
+    assert(telemetry_agent_start_ex(&agent, ring, &c_transport, &agent_config) == true);
+
+    uint8_t* block = static_cast<uint8_t*> (memory_pool_alloc(pool));
+    assert(block != nullptr);
+
+    for(uint32_t index = 0; index < TEST_UDP_FRAGMENTED_BYTES; index++)
+        block[index] = static_cast<uint8_t> (index * 7u);
+
+    assert(telemetry_event_make_pooled(&event, 3100u, pool, block, TEST_UDP_FRAGMENTED_BYTES, TELEMETRY_LEVEL_INFO) == true);
+    assert(ring_buffer_push(ring, &event) == true);
+    telemetry_agent_notify(agent);
+
+    // Reassemble, skipping heartbeats; every fragment fits the datagram limit
+    std::vector<uint8_t> payload(TEST_UDP_FRAGMENTED_BYTES, 0);
+    uint32_t received = 0;
+    uint32_t fragments = 0;
+
+    while(received < TEST_UDP_FRAGMENTED_BYTES)
+    {
+        const std::string datagram = receive_datagram(receiver);
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*> (datagram.data());
+        telemetry_header_t header;
+        telemetry_event_fragment_t fragment;
+
+        assert(!datagram.empty() && datagram.size() <= 1200u);
+        assert(telemetry_decode_header_v1(&header, bytes, datagram.size()) == TELEM_RC_OK);
+
+        if(header.message_type != TELEMETRY_EVENT_FRAGMENT)
+            continue;
+
+        assert(telemetry_decode_event_fragment_v1(&fragment, bytes + telemetry_header_v1_length(),
+                                                  datagram.size() - telemetry_header_v1_length()) == TELEM_RC_OK);
+        assert(fragment.event_id == 3100u);
+        assert(fragment.payload_len == TEST_UDP_FRAGMENTED_BYTES);
+        assert(fragment.fragment_offset == received);
+
+        std::memcpy(&payload[fragment.fragment_offset], fragment.data, fragment.data_length);
+        received += fragment.data_length;
+        fragments++;
+    }
+
+    const uint32_t fragment_bytes = 1200u - static_cast<uint32_t> (telemetry_header_v1_length()) - TELEMETRY_EVENT_FRAGMENT_HEADER_LEN;
+    assert(fragments == (TEST_UDP_FRAGMENTED_BYTES + fragment_bytes - 1u) / fragment_bytes);
+
+    for(uint32_t index = 0; index < TEST_UDP_FRAGMENTED_BYTES; index++)
+        assert(payload[index] == static_cast<uint8_t> (index * 7u));
+
+    telemetry_agent_stop(agent);
+    ring_buffer_free(ring);
+
+    // Nothing went out as JSON, and the block is back
+    assert(udp.oversizeEvents() == 0u);
+    memory_pool_stats(pool, &stats);
+    assert(stats.in_use == 0);
+
+    memory_pool_free(pool);
+    ::close(receiver);
+
+    std::printf("Telemetry :: Test case udp transport pooled fragments is passed. \n");
+}
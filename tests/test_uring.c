@@ -0,0 +1,330 @@
+/**
+ * @file test_uring.c
+ * @brief Unit tests for the OSAL send ring.
+ *
+ * This file contains test cases for queuing datagram sends, submitting
+ * them in one call and reaping their completions. Where the kernel has no
+ * io_uring only the refusal is checked.
+ * @author Aravinthraj Ganesan
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "osal_memory.h"
+#include "osal_uring.h"
+
+/* Test cases :
+    1. Queued sendmsg datagrams go out with one submit and complete in one reap
+    2. SQPOLL and registered buffers send zero-copy and release their buffers, or fall back
+    3. A full queue refuses more sends, bad arguments are refused
+*/
+
+// Datagrams per test
+#define TEST_URING_DATAGRAMS 8u
+
+// Local function prototype declaration
+static void testcase_sendmsg(void);
+static void testcase_sqpoll_registered(void);
+static void testcase_full_and_arguments(void);
+
+void test_uring(void);
+
+/**
+ * @brief Main entry point for running send ring tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_uring()
+{
+    testcase_sendmsg();
+    testcase_sqpoll_registered();
+    testcase_full_and_arguments();
+}
+
+/**
+ * @brief Opens a loopback UDP receiver and a sender socket.
+ */
+static void open_sockets(int* out_receiver, int* out_sender, struct sockaddr_in* out_address)
+{
+    socklen_t length = sizeof(*out_address);
+
+    memset(out_address, 0, sizeof(*out_address));
+    out_address->sin_family = AF_INET;
+    out_address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    *out_receiver = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    *out_sender = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    assert(*out_receiver >= 0 && *out_sender >= 0);
+
+    assert(bind(*out_receiver, (struct sockaddr*)out_address, sizeof(*out_address)) == 0);
+    assert(getsockname(*out_receiver, (struct sockaddr*)out_address, &length) == 0);
+}
+
+/**
+ * @brief Receives one datagram and checks its first byte.
+ */
+static void expect_datagram(int receiver, uint8_t first_byte, size_t length)
+{
+    uint8_t buffer[256];
+
+    assert(recv(receiver, buffer, sizeof(buffer), MSG_DONTWAIT) == (ssize_t)length);
+    assert(buffer[0] == first_byte);
+}
+
+/**
+ * @brief Tests queued sendmsg datagrams.
+ */
+static void testcase_sendmsg()
+{
+    osal_uring_completion_t completions[TEST_URING_DATAGRAMS * 2u];
+    struct msghdr messages[TEST_URING_DATAGRAMS];
+    struct iovec vectors[TEST_URING_DATAGRAMS];
+    uint8_t payloads[TEST_URING_DATAGRAMS][16];
+    struct sockaddr_in address;
+    int receiver = -1;
+    int sender = -1;
+
+    open_sockets(&receiver, &sender, &address);
+
+    osal_uring_t* ring = osal_uring_create(TEST_URING_DATAGRAMS, 0, NULL, 0);
+
+    if(ring == NULL)
+    {
+        // No io_uring here, callers keep their synchronous path
+        assert(osal_uring_applied(NULL) == 0);
+        close(sender);
+        close(receiver);
+        printf("Telemetry :: Test case uring sendmsg is passed. \n");
+        return;
+    }
+
+    assert(osal_uring_applied(ring) == 0);
+
+    // Nothing queued : nothing to submit or reap
+    assert(osal_uring_submit(ring) == 0);
+    assert(osal_uring_reap(ring, completions, TEST_URING_DATAGRAMS, 0) == 0);
+
+    for(uint32_t index = 0; index < TEST_URING_DATAGRAMS; index++)
+    {
+        memset(payloads[index], (int)('a' + index), sizeof(payloads[index]));
+
+        vectors[index].iov_base = payloads[index];
+        vectors[index].iov_len = 10u + index;
+
+        memset(&messages[index], 0, sizeof(messages[index]));
+        messages[index].msg_name = &address;
+        messages[index].msg_namelen = sizeof(address);
+        messages[index].msg_iov = &vectors[index];
+        messages[index].msg_iovlen = 1;
+
+        assert(osal_uring_queue_sendmsg(ring, sender, &messages[index], 100u + index) == true);
+    }
+
+    // Queued only : nothing sent before the submit
+    assert(recv(receiver, payloads[0], 1, MSG_DONTWAIT | MSG_PEEK) < 0);
+
+    assert(osal_uring_submit(ring) == (int)TEST_URING_DATAGRAMS);
+
+    size_t reaped = 0;
+
+    while(reaped < TEST_URING_DATAGRAMS)
+    {
+        reaped += osal_uring_reap(ring, &completions[reaped], TEST_URING_DATAGRAMS - reaped,
+                                  (uint32_t)(TEST_URING_DATAGRAMS - reaped));
+    }
+
+    for(size_t index = 0; index < reaped; index++)
+    {
+        const uint64_t slot = completions[index].user_data - 100u;
+
+        assert(slot < TEST_URING_DATAGRAMS);
+        assert(completions[index].result == (int32_t)(10u + slot));
+        assert(completions[index].release == true);
+    }
+
+    for(uint32_t index = 0; index < TEST_URING_DATAGRAMS; index++)
+        expect_datagram(receiver, (uint8_t)('a' + index), 10u + index);
+
+    assert(osal_uring_reap(ring, completions, TEST_URING_DATAGRAMS, 0) == 0);
+
+    osal_uring_destroy(ring);
+    close(sender);
+    close(receiver);
+
+    printf("Telemetry :: Test case uring sendmsg is passed. \n");
+}
+
+/**
+ * @brief Tests SQPOLL and zero-copy sends from registered buffers.
+ */
+static void testcase_sqpoll_registered()
+{
+    osal_uring_completion_t completions[TEST_URING_DATAGRAMS * 2u];
+    osal_memory_t memory;
+    struct sockaddr_in address;
+    int receiver = -1;
+    int sender = -1;
+
+    open_sockets(&receiver, &sender, &address);
+    assert(osal_memory_map(&memory, 4096u, OSAL_MEMORY_PREFAULT, OSAL_MEMORY_NODE_LOCAL) == true);
+
+    osal_uring_t* ring = osal_uring_create(TEST_URING_DATAGRAMS, OSAL_URING_SQPOLL | OSAL_URING_REGISTERED_BUFFERS,
+                                           memory.address, memory.length);
+
+    if(ring == NULL)
+    {
+        osal_memory_unmap(&memory);
+        close(sender);
+        close(receiver);
+        printf("Telemetry :: Test case uring sqpoll and registered buffers is passed. \n");
+        return;
+    }
+
+    // Only options that were asked for
+    assert((osal_uring_applied(ring) & ~(OSAL_URING_SQPOLL | OSAL_URING_REGISTERED_BUFFERS)) == 0);
+
+    const bool registered = (osal_uring_applied(ring) & OSAL_URING_REGISTERED_BUFFERS) != 0;
+    uint8_t* buffer = (uint8_t*)memory.address;
+    struct msghdr messages[TEST_URING_DATAGRAMS];
+    struct iovec vectors[TEST_URING_DATAGRAMS];
+
+    for(uint32_t index = 0; index < TEST_URING_DATAGRAMS; index++)
+    {
+        uint8_t* data = buffer + (index * 64u);
+
+        memset(data, (int)('A' + index), 32u);
+
+        if(registered)
+        {
+            assert(osal_uring_queue_send_fixed(ring, sender, data, 32u, &address, sizeof(address), index) == true);
+        }
+        else
+        {
+            // Refused zero-copy : the same datagrams through sendmsg
+            assert(osal_uring_queue_send_fixed(ring, sender, data, 32u, &address, sizeof(address), index) == false);
+
+            vectors[index].iov_base = data;
+            vectors[index].iov_len = 32u;
+            memset(&messages[index], 0, sizeof(messages[index]));
+            messages[index].msg_name = &address;
+            messages[index].msg_namelen = sizeof(address);
+            messages[index].msg_iov = &vectors[index];
+            messages[index].msg_iovlen = 1;
+            assert(osal_uring_queue_sendmsg(ring, sender, &messages[index], index) == true);
+        }
+    }
+
+    assert(osal_uring_submit(ring) == (int)TEST_URING_DATAGRAMS);
+
+    // Every buffer is released once, after a successful result
+    uint32_t released = 0;
+    uint32_t results = 0;
+
+    while(released < TEST_URING_DATAGRAMS)
+    {
+        const size_t count = osal_uring_reap(ring, completions, TEST_URING_DATAGRAMS * 2u, 1);
+
+        for(size_t index = 0; index < count; index++)
+        {
+            assert(completions[index].user_data < TEST_URING_DATAGRAMS);
+            assert(completions[index].result >= 0);
+
+            if(completions[index].result == 32)
+                results++;
+
+            if(completions[index].release)
+                released++;
+        }
+    }
+
+    assert(results == TEST_URING_DATAGRAMS);
+
+    for(uint32_t index = 0; index < TEST_URING_DATAGRAMS; index++)
+        expect_datagram(receiver, (uint8_t)('A' + index), 32u);
+
+    osal_uring_destroy(ring);
+    osal_memory_unmap(&memory);
+    close(sender);
+    close(receiver);
+
+    printf("Telemetry :: Test case uring sqpoll and registered buffers is passed. \n");
+}
+
+/**
+ * @brief Tests a full queue and argument checks.
+ */
+static void testcase_full_and_arguments()
+{
+    osal_uring_completion_t completions[8];
+    struct sockaddr_in address;
+    struct msghdr message;
+    struct iovec vector;
+    uint8_t byte = 'z';
+    int receiver = -1;
+    int sender = -1;
+
+    assert(osal_uring_create(0, 0, NULL, 0) == NULL);
+    assert(osal_uring_queue_sendmsg(NULL, 0, &message, 0) == false);
+    assert(osal_uring_submit(NULL) == -1);
+    assert(osal_uring_reap(NULL, completions, 8, 0) == 0);
+    osal_uring_destroy(NULL);
+
+    osal_uring_t* ring = osal_uring_create(4, 0, NULL, 0);
+
+    if(ring == NULL)
+    {
+        printf("Telemetry :: Test case uring full queue and arguments is passed. \n");
+        return;
+    }
+
+    open_sockets(&receiver, &sender, &address);
+
+    vector.iov_base = &byte;
+    vector.iov_len = 1;
+    memset(&message, 0, sizeof(message));
+    message.msg_name = &address;
+    message.msg_namelen = sizeof(address);
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+
+    assert(osal_uring_queue_sendmsg(ring, -1, &message, 0) == false);
+    assert(osal_uring_queue_sendmsg(ring, sender, NULL, 0) == false);
+    assert(osal_uring_reap(ring, NULL, 8, 0) == 0);
+
+    // No registered buffer : no zero-copy send
+    assert(osal_uring_queue_send_fixed(ring, sender, &byte, 1, &address, sizeof(address), 0) == false);
+
+    // Four entries fit, the fifth waits for a submit
+    for(uint32_t index = 0; index < 4u; index++)
+        assert(osal_uring_queue_sendmsg(ring, sender, &message, index) == true);
+
+    assert(osal_uring_queue_sendmsg(ring, sender, &message, 4u) == false);
+    assert(osal_uring_submit(ring) == 4);
+    assert(osal_uring_queue_sendmsg(ring, sender, &message, 4u) == true);
+    assert(osal_uring_submit(ring) == 1);
+
+    size_t reaped = 0;
+
+    while(reaped < 5u)
+        reaped += osal_uring_reap(ring, completions, 8, 1);
+
+    assert(reaped == 5u);
+
+    osal_uring_destroy(ring);
+    close(sender);
+    close(receiver);
+
+    printf("Telemetry :: Test case uring full queue and arguments is passed. \n");
+}
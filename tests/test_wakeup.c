@@ -0,0 +1,305 @@
+/**
+ * @file test_wakeup.c
+ * @brief Unit tests for the OSAL wakeup and timer objects.
+ *
+ * This file contains test cases for the timed wait, the periodic timer and
+ * the combined wait on a wakeup object and a timer, run with the eventfd
+ * and the futex backend.
+ * @author Aravinthraj Ganesan
+ */
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "osal_thread.h"
+#include "osal_wakeup.h"
+#include "static_storage.h"
+
+/* Test cases :
+    1. A timed wait returns false after its timeout and true when notified
+    2. A notification from another thread ends a timed wait early
+    3. Periodic and one-shot timers expire on time and stop
+    4. One wait reports a notification, a timer expiry or both
+    5. Backends are selected at create time and lose no notification under load
+*/
+
+// 1 ms and 1 s in nanoseconds
+#define TEST_WAKEUP_MS 1000000ull
+#define TEST_WAKEUP_S  1000000000ull
+
+// Notifies of case 5
+#define TEST_WAKEUP_NOTIFIES 20000u
+
+typedef struct wakeup_load_s {
+    osal_wakeup_t* wakeup;
+    atomic_uint produced;
+} wakeup_load_t;
+
+// Local function prototype declaration
+static void testcase_wait_timeout(osal_wakeup_backend_t backend);
+static void testcase_notify_from_thread(osal_wakeup_backend_t backend);
+static void testcase_timer(void);
+static void testcase_wait_timer(osal_wakeup_backend_t backend);
+static void testcase_backends(void);
+
+void test_wakeup(void);
+
+/**
+ * @brief Main entry point for running wakeup tests.
+ *
+ * Executes all test functions in sequence.
+ *
+ * @return void
+ */
+void test_wakeup()
+{
+    static const osal_wakeup_backend_t backends[] = { OSAL_WAKEUP_BACKEND_EVENTFD, OSAL_WAKEUP_BACKEND_FUTEX };
+
+    for(size_t index = 0; index < sizeof(backends) / sizeof(backends[0]); index++)
+    {
+        testcase_wait_timeout(backends[index]);
+        testcase_notify_from_thread(backends[index]);
+        testcase_wait_timer(backends[index]);
+    }
+
+    testcase_timer();
+    testcase_backends();
+}
+
+static const char* backend_name(osal_wakeup_backend_t backend)
+{
+    return (backend == OSAL_WAKEUP_BACKEND_FUTEX) ? "futex" : "eventfd";
+}
+
+static uint64_t clock_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static void* notify_worker(void* arg)
+{
+    osal_thread_sleep_ns(20u * TEST_WAKEUP_MS);
+    osal_wakeup_notify((osal_wakeup_t*)arg);
+    return NULL;
+}
+
+/**
+ * @brief Tests the timed wait on one thread.
+ */
+static void testcase_wait_timeout(osal_wakeup_backend_t backend)
+{
+    osal_wakeup_t* wakeup = osal_wakeup_create_ex(backend);
+    assert(wakeup != NULL);
+    assert(osal_wakeup_backend(wakeup) == backend);
+
+    // Nothing pending : a zero timeout polls, a short one elapses
+    assert(osal_wakeup_wait_timeout(wakeup, 0) == false);
+
+    uint64_t start_ns = clock_monotonic_ns();
+    assert(osal_wakeup_wait_timeout(wakeup, 10u * TEST_WAKEUP_MS) == false);
+    assert(clock_monotonic_ns() - start_ns >= 10u * TEST_WAKEUP_MS);
+
+    // Pending notifications end the wait at once and are consumed together
+    osal_wakeup_notify(wakeup);
+    osal_wakeup_notify(wakeup);
+
+    start_ns = clock_monotonic_ns();
+    assert(osal_wakeup_wait_timeout(wakeup, TEST_WAKEUP_S) == true);
+    assert(clock_monotonic_ns() - start_ns < TEST_WAKEUP_S);
+    assert(osal_wakeup_wait_timeout(wakeup, 0) == false);
+
+    assert(osal_wakeup_wait_timeout(NULL, 0) == false);
+
+    osal_wakeup_destroy(wakeup);
+
+    printf("Telemetry :: Test case wakeup wait timeout (%s) is passed. \n", backend_name(backend));
+}
+
+/**
+ * @brief Tests a timed wait ended by another thread.
+ */
+static void testcase_notify_from_thread(osal_wakeup_backend_t backend)
+{
+    osal_thread_t* thread = NULL;
+    osal_wakeup_t* wakeup = osal_wakeup_create_ex(backend);
+    assert(wakeup != NULL);
+
+    const uint64_t start_ns = clock_monotonic_ns();
+    assert(osal_thread_create(&thread, notify_worker, wakeup, "test_notify") == 0);
+
+    // The wait ends with the notification, long before its timeout
+    assert(osal_wakeup_wait_timeout(wakeup, 10u * TEST_WAKEUP_S) == true);
+
+    const uint64_t waited_ns = clock_monotonic_ns() - start_ns;
+    assert(waited_ns >= 15u * TEST_WAKEUP_MS);
+    assert(waited_ns < 5u * TEST_WAKEUP_S);
+
+    assert(osal_thread_join(thread) == 0);
+    osal_thread_destroy(thread);
+    osal_wakeup_destroy(wakeup);
+
+    printf("Telemetry :: Test case wakeup notify from thread (%s) is passed. \n", backend_name(backend));
+}
+
+/**
+ * @brief Tests periodic and one-shot timers.
+ */
+static void testcase_timer()
+{
+    static TELEMETRY_STORAGE(timer_memory, OSAL_TIMER_STORAGE_BYTES);
+
+    osal_timer_t* timer = osal_timer_create();
+    assert(timer != NULL);
+
+    // A stopped timer never expires
+    assert(osal_timer_expirations(timer) == 0);
+
+    uint64_t start_ns = clock_monotonic_ns();
+    assert(osal_timer_start(timer, 5u * TEST_WAKEUP_MS, 5u * TEST_WAKEUP_MS) == true);
+
+    uint64_t expirations = 0;
+
+    while(expirations < 4)
+    {
+        const uint64_t expired = osal_timer_wait(timer);
+        assert(expired >= 1);
+        expirations += expired;
+    }
+
+    assert(clock_monotonic_ns() - start_ns >= 4u * 5u * TEST_WAKEUP_MS);
+
+    // Missed periods are reported together
+    osal_thread_sleep_ns(30u * TEST_WAKEUP_MS);
+    assert(osal_timer_expirations(timer) >= 4);
+
+    osal_timer_stop(timer);
+    osal_thread_sleep_ns(10u * TEST_WAKEUP_MS);
+    assert(osal_timer_expirations(timer) == 0);
+
+    osal_timer_destroy(timer);
+
+    // One-shot timer in static storage, zero delay expires at once
+    assert(osal_timer_create_static(timer_memory, sizeof(timer_memory) - 1u) == NULL);
+    timer = osal_timer_create_static(timer_memory, sizeof(timer_memory));
+    assert(timer == (osal_timer_t*)timer_memory);
+
+    assert(osal_timer_start(timer, 0, 0) == true);
+    assert(osal_timer_wait(timer) == 1);
+
+    start_ns = clock_monotonic_ns();
+    assert(osal_timer_start(timer, 10u * TEST_WAKEUP_MS, 0) == true);
+    assert(osal_timer_wait(timer) == 1);
+    assert(clock_monotonic_ns() - start_ns >= 10u * TEST_WAKEUP_MS);
+
+    osal_thread_sleep_ns(20u * TEST_WAKEUP_MS);
+    assert(osal_timer_expirations(timer) == 0);
+
+    osal_timer_destroy(timer);
+
+    assert(osal_timer_start(NULL, 1, 1) == false);
+    assert(osal_timer_wait(NULL) == 0);
+
+    printf("Telemetry :: Test case wakeup timer is passed. \n");
+}
+
+/**
+ * @brief Tests the combined wait.
+ */
+static void testcase_wait_timer(osal_wakeup_backend_t backend)
+{
+    osal_wakeup_t* wakeup = osal_wakeup_create_ex(backend);
+    osal_timer_t* timer = osal_timer_create();
+    uint64_t expirations = 0;
+
+    assert(wakeup != NULL && timer != NULL);
+
+    // Notified with a stopped timer
+    osal_wakeup_notify(wakeup);
+    assert(osal_wakeup_wait_timer(wakeup, timer, &expirations) == OSAL_WAKEUP_NOTIFIED);
+    assert(expirations == 0);
+
+    // Timer only
+    assert(osal_timer_start(timer, 5u * TEST_WAKEUP_MS, 5u * TEST_WAKEUP_MS) == true);
+    assert(osal_wakeup_wait_timer(wakeup, timer, &expirations) == OSAL_WAKEUP_EXPIRED);
+    assert(expirations >= 1);
+
+    // Both ready when the wait starts
+    osal_thread_sleep_ns(10u * TEST_WAKEUP_MS);
+    osal_wakeup_notify(wakeup);
+    assert(osal_wakeup_wait_timer(wakeup, timer, NULL) == (OSAL_WAKEUP_NOTIFIED | OSAL_WAKEUP_EXPIRED));
+
+    assert(osal_wakeup_wait_timer(NULL, timer, &expirations) == 0);
+    assert(expirations == 0);
+
+    osal_timer_destroy(timer);
+    osal_wakeup_destroy(wakeup);
+
+    printf("Telemetry :: Test case wakeup wait timer (%s) is passed. \n", backend_name(backend));
+}
+
+static void* load_worker(void* arg)
+{
+    wakeup_load_t* load = (wakeup_load_t*)arg;
+
+    for(uint32_t index = 0; index < TEST_WAKEUP_NOTIFIES; index++)
+    {
+        atomic_fetch_add(&load->produced, 1);
+        osal_wakeup_notify(load->wakeup);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Tests the backend selection and a notify storm.
+ */
+static void testcase_backends()
+{
+    static TELEMETRY_STORAGE(wakeup_memory, OSAL_WAKEUP_STORAGE_BYTES);
+
+    // The default follows the build, a bad backend is refused
+    osal_wakeup_t* wakeup = osal_wakeup_create();
+    assert(wakeup != NULL);
+    assert(osal_wakeup_backend(wakeup) == OSAL_WAKEUP_BACKEND_EVENTFD ||
+           osal_wakeup_backend(wakeup) == OSAL_WAKEUP_BACKEND_FUTEX);
+    osal_wakeup_destroy(wakeup);
+
+    assert(osal_wakeup_create_ex((osal_wakeup_backend_t)42) == NULL);
+    assert(osal_wakeup_backend(NULL) == OSAL_WAKEUP_BACKEND_DEFAULT);
+
+    wakeup = osal_wakeup_create_static_ex(wakeup_memory, sizeof(wakeup_memory), OSAL_WAKEUP_BACKEND_FUTEX);
+    assert(wakeup == (osal_wakeup_t*)wakeup_memory);
+    assert(osal_wakeup_backend(wakeup) == OSAL_WAKEUP_BACKEND_FUTEX);
+
+    // A waiter that only sleeps when it saw nothing new must see every notify burst end
+    wakeup_load_t load;
+    osal_thread_t* thread = NULL;
+
+    load.wakeup = wakeup;
+    atomic_init(&load.produced, 0);
+
+    assert(osal_thread_create(&thread, load_worker, &load, "test_load") == 0);
+
+    uint32_t seen = 0;
+
+    while(seen < TEST_WAKEUP_NOTIFIES)
+    {
+        const uint32_t produced = atomic_load(&load.produced);
+
+        if(produced == seen)
+            assert(osal_wakeup_wait_timeout(wakeup, 5u * TEST_WAKEUP_S) == true);
+
+        seen = produced;
+    }
+
+    assert(osal_thread_join(thread) == 0);
+    osal_thread_destroy(thread);
+    osal_wakeup_destroy(wakeup);
+
+    printf("Telemetry :: Test case wakeup backends is passed. \n");
+}
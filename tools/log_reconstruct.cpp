@@ -0,0 +1,242 @@
+/**
+ * @file log_reconstruct.cpp
+ * @brief Offline formatter for deferred-format log events.
+ *
+ * Reads the JSON event lines written by the UDP transport (as printed by
+ * udp_console_receiver or captured to a file), collects the format
+ * dictionary events and prints every log event as a text line. Other
+ * lines are passed through unchanged.
+ *
+ * Usage: log_reconstruct [capture file], reads stdin without an argument.
+ *
+ * @author Aravinthraj Ganesan
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include "log_record.h"
+}
+
+namespace {
+
+// Longest input line, an event with a full payload is well below this
+constexpr size_t kMaxLineBytes = 4096;
+// Longest reconstructed text
+constexpr size_t kMaxTextBytes = 1024;
+
+// Fields of one JSON event line
+struct EventLine
+{
+    uint32_t event_id = 0;
+    unsigned level = 0;
+    unsigned long long timestamp_ns = 0;
+    std::vector<uint8_t> payload;
+};
+
+// A format being reassembled from its dictionary chunks
+struct DictionaryFormat
+{
+    std::string text;
+    size_t filled = 0;          // Bytes received without a gap
+    uint8_t arg_count = 0;
+    uint8_t arg_types[TELEMETRY_LOG_MAX_ARGS] = {};
+};
+
+/**
+ * @brief Reads an unsigned number that follows a JSON key.
+ *
+ * @param line Input line.
+ * @param key Key including the quotes and colon, e.g. "\"id\":".
+ * @param value Receives the number.
+ * @return true if the key was found.
+ */
+bool read_number(const char* line, const char* key, unsigned long long& value)
+{
+    const char* position = std::strstr(line, key);
+    if(position == nullptr)
+        return false;
+
+    char* end = nullptr;
+    value = std::strtoull(position + std::strlen(key), &end, 10);
+
+    return (end != position + std::strlen(key));
+}
+
+/**
+ * @brief Parses a JSON event line written by the UDP transport.
+ *
+ * @param line Input line, may carry a receiver prefix.
+ * @param event Receives the fields.
+ * @return true if the line holds an event.
+ */
+bool parse_event_line(const char* line, EventLine& event)
+{
+    unsigned long long event_id;
+    unsigned long long level;
+    unsigned long long payload_length;
+
+    if(!read_number(line, "\"id\":", event_id) || !read_number(line, "\"level\":", level) ||
+       !read_number(line, "\"ts_ns\":", event.timestamp_ns) || !read_number(line, "\"payload_len\":", payload_length))
+    {
+        return false;
+    }
+
+    event.event_id = static_cast<uint32_t>(event_id);
+    event.level = static_cast<unsigned>(level);
+    event.payload.clear();
+
+    const char* hex = std::strstr(line, "\"payload_hex\":\"");
+    if(hex == nullptr)
+        return false;
+
+    hex += std::strlen("\"payload_hex\":\"");
+
+    // Two hex digits per byte up to the closing quote
+    while(hex[0] != '"' && hex[0] != '\0' && hex[1] != '\0')
+    {
+        const char digits[3] = { hex[0], hex[1], '\0' };
+        char* end = nullptr;
+        const unsigned long byte = std::strtoul(digits, &end, 16);
+
+        if(end != digits + 2)
+            return false;
+
+        event.payload.push_back(static_cast<uint8_t>(byte));
+        hex += 2;
+    }
+
+    return (event.payload.size() == payload_length);
+}
+
+/**
+ * @brief Adds one dictionary chunk.
+ *
+ * Chunks are accepted in order; repeated chunks, e.g. from a dictionary
+ * that was published again, are ignored.
+ *
+ * @param formats Formats by id.
+ * @param event Dictionary event.
+ */
+void add_dictionary_chunk(std::map<uint32_t, DictionaryFormat>& formats, const EventLine& event)
+{
+    telemetry_log_dictionary_t entry;
+
+    if(!telemetry_log_dictionary_decode(&entry, event.payload.data(), event.payload.size()))
+    {
+        std::fprintf(stderr, "log_reconstruct: damaged dictionary event\n");
+        return;
+    }
+
+    DictionaryFormat& format = formats[entry.format_id];
+
+    // A new or changed format starts over
+    if(entry.offset == 0 && (format.text.size() != entry.format_length || format.filled == format.text.size()))
+    {
+        format.text.assign(entry.format_length, '\0');
+        format.filled = 0;
+        format.arg_count = entry.arg_count;
+        std::memcpy(format.arg_types, entry.arg_types, sizeof(format.arg_types));
+    }
+
+    if(format.text.size() != entry.format_length || entry.offset > format.filled)
+        return;
+
+    format.text.replace(entry.offset, entry.chunk_length, entry.chunk, entry.chunk_length);
+
+    if(entry.offset + entry.chunk_length > format.filled)
+        format.filled = entry.offset + entry.chunk_length;
+}
+
+/**
+ * @brief Returns the name of a severity level.
+ *
+ * @param level Level value.
+ * @return Level name.
+ */
+const char* level_name(unsigned level)
+{
+    switch(level)
+    {
+        case TELEMETRY_LEVEL_DEBUG:   return "DEBUG";
+        case TELEMETRY_LEVEL_INFO:    return "INFO";
+        case TELEMETRY_LEVEL_WARNING: return "WARN";
+        case TELEMETRY_LEVEL_ERROR:   return "ERROR";
+        default:                      return "?";
+    }
+}
+
+}
+
+/**
+ * @brief Program entry point.
+ *
+ * @param arg_count  Number of command-line arguments.
+ * @param arg_vector Array of strings; each string is one argument.
+ * @return 0 on success, 1 if the input can not be opened.
+ */
+int main(int arg_count, char** arg_vector)
+{
+    std::FILE* input = stdin;
+
+    if(arg_count == 2)
+    {
+        input = std::fopen(arg_vector[1], "r");
+        if(input == nullptr)
+        {
+            std::perror(arg_vector[1]);
+            return 1;
+        }
+    }
+
+    std::map<uint32_t, DictionaryFormat> formats;
+    char line[kMaxLineBytes];
+    char text[kMaxTextBytes];
+    EventLine event;
+
+    while(std::fgets(line, sizeof(line), input) != nullptr)
+    {
+        uint32_t format_id = 0;
+
+        if(!parse_event_line(line, event))
+        {
+            std::fputs(line, stdout);
+            continue;
+        }
+
+        if(event.event_id == TELEMETRY_LOG_DICTIONARY_EVENT_ID)
+        {
+            add_dictionary_chunk(formats, event);
+            continue;
+        }
+
+        if(!telemetry_log_format_id(event.event_id, &format_id))
+        {
+            std::fputs(line, stdout);
+            continue;
+        }
+
+        const auto found = formats.find(format_id);
+        if(found == formats.end() || found->second.filled != found->second.text.size())
+        {
+            std::printf("%llu %-5s <unknown format %u>\n", event.timestamp_ns, level_name(event.level), format_id);
+            continue;
+        }
+
+        const DictionaryFormat& format = found->second;
+        telemetry_log_format(text, sizeof(text), format.text.c_str(), format.arg_types, format.arg_count,
+                             event.payload.data(), event.payload.size());
+
+        std::printf("%llu %-5s %s\n", event.timestamp_ns, level_name(event.level), text);
+    }
+
+    if(input != stdin)
+        std::fclose(input);
+
+    return 0;
+}
@@ -16,11 +16,18 @@
 #include <cstring>
 #include <string>
 #include <cstdlib>
+
+#include "telemetry_protocol.h"
+#include "metrics.h"
+#include "quantile_sketch.h"
+
 namespace {
 
 
 constexpr uint16_t kListenPort = 9000;
 constexpr size_t kMaxDatagrambytes = 2048;
+// Bins of the sketch used for decoding, wide enough for any sender default
+constexpr size_t kSketchDecodeBins = 4096;
 
 /**
  * @brief Creates and binds a UDP socket for receiving datagrams.
@@ -93,6 +100,125 @@ void format_sender(const sockaddr_in& sender, char* out, size_t out_capacity)
 
 }
 
+/**
+ * @brief Prints a binary protocol message in readable form.
+ *
+ * JSON events are printed as received; binary messages start with the
+ * protocol magic and are decoded here.
+ *
+ * @param data   Received datagram.
+ * @param length Number of bytes received.
+ * @return true if the datagram was a protocol message and was printed.
+ */
+bool print_protocol_message(const uint8_t* data, size_t length)
+{
+    telemetry_header_t header{};
+
+    if(telemetry_decode_header_v1(&header, data, length) != TELEM_RC_OK)
+        return false;
+
+    const uint8_t* payload = data + telemetry_header_v1_length();
+    const size_t payload_len = length - telemetry_header_v1_length();
+
+    if(header.message_type == TELEMETRY_HEART_BEAT_BATCH)
+    {
+        telemetry_heartbeat_t hb{};
+        if(telemetry_decode_heartbeat_v1(&hb, payload, payload_len) != TELEM_RC_OK)
+            return false;
+
+        std::printf("heartbeat seq=%u uptime_ms=%llu sent=%llu wakeups=%llu dropped=%llu "
+                    "transport_errors=%llu ring=%u/%u\n",
+                    header.sequence_counter,
+                    static_cast<unsigned long long>(hb.uptime_ns / 1000000ull),
+                    static_cast<unsigned long long>(hb.sent_count),
+                    static_cast<unsigned long long>(hb.wakeup_count),
+                    static_cast<unsigned long long>(hb.ring_dropped),
+                    static_cast<unsigned long long>(hb.transport_error_count),
+                    hb.ring_count, hb.ring_capacity);
+        return true;
+    }
+
+    if(header.message_type == TELEMETRY_METRICS_BATCH)
+    {
+        uint16_t record_count = 0;
+        size_t position = telemetry_metrics_decode_count(&record_count, payload, payload_len);
+        if(position == 0)
+            return false;
+
+        std::printf("metrics seq=%u records=%u\n", header.sequence_counter, record_count);
+
+        for(uint16_t index = 0; index < record_count; index++)
+        {
+            telemetry_metric_record_t record{};
+            const size_t consumed = telemetry_metrics_decode_record(&record, payload + position, payload_len - position);
+            if(consumed == 0)
+                break;
+            position += consumed;
+
+            if(record.type == TELEMETRY_METRIC_COUNTER)
+            {
+                std::printf("    counter   id=%u value=%llu\n", record.metric_id,
+                            static_cast<unsigned long long>(record.counter));
+            }
+            else if(record.type == TELEMETRY_METRIC_GAUGE)
+            {
+                std::printf("    gauge     id=%u value=%lld\n", record.metric_id,
+                            static_cast<long long>(record.gauge));
+            }
+            else
+            {
+                const telemetry_histogram_snapshot_t& histogram = record.histogram;
+                std::printf("    histogram id=%u count=%llu sum=%llu min=%llu max=%llu p50=%llu p99=%llu p999=%llu\n",
+                            record.metric_id,
+                            static_cast<unsigned long long>(histogram.count),
+                            static_cast<unsigned long long>(histogram.sum),
+                            static_cast<unsigned long long>(histogram.min),
+                            static_cast<unsigned long long>(histogram.max),
+                            static_cast<unsigned long long>(telemetry_histogram_snapshot_percentile(&histogram, 50.0)),
+                            static_cast<unsigned long long>(telemetry_histogram_snapshot_percentile(&histogram, 99.0)),
+                            static_cast<unsigned long long>(telemetry_histogram_snapshot_percentile(&histogram, 99.9)));
+            }
+        }
+        return true;
+    }
+
+    if(header.message_type == TELEMETRY_SKETCH_BATCH)
+    {
+        static telemetry_sketch_t* sketch = nullptr;
+        if(sketch == nullptr && !telemetry_sketch_init(&sketch, 0.0, kSketchDecodeBins))
+            return false;
+
+        uint16_t record_count = 0;
+        size_t position = telemetry_sketches_decode_count(&record_count, payload, payload_len);
+        if(position == 0)
+            return false;
+
+        std::printf("sketches seq=%u records=%u\n", header.sequence_counter, record_count);
+
+        for(uint16_t index = 0; index < record_count; index++)
+        {
+            uint32_t event_id = 0;
+            const size_t consumed = telemetry_sketches_decode_record(&event_id, sketch, payload + position, payload_len - position);
+            if(consumed == 0)
+                break;
+            position += consumed;
+
+            std::printf("    sketch    id=%u count=%llu min=%g max=%g p50=%g p99=%g p999=%g\n", event_id,
+                        static_cast<unsigned long long>(telemetry_sketch_count(sketch)),
+                        telemetry_sketch_min(sketch),
+                        telemetry_sketch_max(sketch),
+                        telemetry_sketch_percentile(sketch, 50.0),
+                        telemetry_sketch_percentile(sketch, 99.0),
+                        telemetry_sketch_percentile(sketch, 99.9));
+        }
+        return true;
+    }
+
+    std::printf("message type=%u seq=%u payload_len=%u\n",
+                header.message_type, header.sequence_counter, header.payload_len);
+    return true;
+}
+
 }
 
 
@@ -155,8 +281,15 @@ int main(int arg_count, char** arg_vector)
         char sender_text[64];
         format_sender(sender, sender_text, sizeof(sender_text));
 
-        // Display the received message with sender information
-        std::printf(" From %-21s | %zd bytes | %s", sender_text, bytes, datagram_msg);
+        // Binary protocol messages are decoded, everything else is printed as text
+        std::printf(" From %-21s | %zd bytes | ", sender_text, bytes);
+        if(print_protocol_message(reinterpret_cast<const uint8_t*>(datagram_msg), static_cast<size_t>(bytes)))
+        {
+            continue;
+        }
+
+        // Display the received message
+        std::printf("%s", datagram_msg);
 
         // Add newline if the message did not include one
         if(bytes > 0 && datagram_msg[bytes - 1] != '\n')
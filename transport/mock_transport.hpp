@@ -29,6 +29,7 @@ namespace transport {
             bool Init(const Config&) override
             {
                 sent_counter.store(0, std::memory_order_relaxed);
+                message_counter.store(0, std::memory_order_relaxed);
                 return true;
             }
 
@@ -44,6 +45,26 @@ namespace transport {
                 return true;
             }
 
+            // Send an encoded protocol message (simulated)
+            bool sendMessage(const uint8_t* data, size_t length) override
+            {
+                (void)data;
+                message_counter.fetch_add(1, std::memory_order_relaxed);
+                if(enable_print_ == true)
+                {
+                    printf("Message length :%zu\n", length);
+                }
+                return true;
+            }
+
+            // Send a telemetry event from a signal handler (simulated, never prints)
+            bool sendEventSignalSafe(const telemetry_event_t& event) override
+            {
+                signal_safe_counter.fetch_add(1, std::memory_order_relaxed);
+                last_signal_safe_id.store(event.event_id, std::memory_order_relaxed);
+                return true;
+            }
+
             // Shutdown the transport (no-op for mock)
             void shutdown() {}
 
@@ -53,9 +74,30 @@ namespace transport {
                 return sent_counter.load(std::memory_order_relaxed);
             }
 
+            // Get the number of protocol messages sent
+            uint64_t messageCount() const
+            {
+                return message_counter.load(std::memory_order_relaxed);
+            }
+
+            // Get the number of events sent from a signal handler
+            uint64_t signalSafeCount() const
+            {
+                return signal_safe_counter.load(std::memory_order_relaxed);
+            }
+
+            // Get the id of the last event sent from a signal handler
+            uint32_t lastSignalSafeId() const
+            {
+                return last_signal_safe_id.load(std::memory_order_relaxed);
+            }
+
         private:
             bool enable_print_;                     // Flag to enable/disable event printing
             std::atomic<uint64_t> sent_counter{0};  // Counter for sent events
+            std::atomic<uint64_t> message_counter{0}; // Counter for sent protocol messages
+            std::atomic<uint64_t> signal_safe_counter{0};   // Counter for events sent from signal handlers
+            std::atomic<uint32_t> last_signal_safe_id{0};   // Id of the last of them
 
     };
 
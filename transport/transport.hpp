@@ -22,6 +22,11 @@ namespace transport {
         // declare the memeber for port access and chunksize
         const char* endpoint = NULL;        // later have to defined the port address here
         uint32_t mtu = 512;                 // Maximum transmission unit/ chunksize
+        bool nonblocking = false;           // Sends fail with wouldBlock() instead of waiting for buffer space
+        bool io_uring = false;              // Queue sends on an io_uring and reap them in batches, sendto if unavailable
+        uint32_t io_uring_entries = 256;    // Sends in flight on the io_uring
+        bool io_uring_sqpoll = false;       // A kernel thread submits the queued sends, no system call per flush
+        bool io_uring_registered_buffers = false;   // Zero-copy sends from registered datagram buffers
     };
 
     // Interface for Transport
@@ -32,5 +37,47 @@ namespace transport {
         virtual bool sendEvent(const telemetry_event_t &event) = 0; // Send a telemetry event
         virtual void shutdown() = 0;                                // Shutdown the transport
 
+        // Send an encoded protocol message (heartbeat, metrics). Transports without binary support return false.
+        virtual bool sendMessage(const uint8_t* data, size_t length)
+        {
+            (void)data;
+            (void)length;
+            return false;
+        }
+
+        // Send an event from a signal handler, used by the crash flush. Implementations may only
+        // use async-signal-safe calls: no locks, no allocation, no stdio. Unsupported by default.
+        virtual bool sendEventSignalSafe(const telemetry_event_t& event)
+        {
+            (void)event;
+            return false;
+        }
+
+        // Descriptor the agent polls for writability after a send would have blocked, -1 if none.
+        virtual int pollFd() const
+        {
+            return -1;
+        }
+
+        // true if the last failed send would have blocked, so the agent retries it when pollFd() is writable.
+        virtual bool wouldBlock() const
+        {
+            return false;
+        }
+
+        // Hand sends queued by sendEvent/sendMessage to the OS, called by the agent before it waits.
+        // Transports that send right away have nothing to do.
+        virtual bool flush()
+        {
+            return true;
+        }
+
+        // Largest message sendMessage() accepts; pooled event payloads are then split into
+        // fragment messages of at most this size. 0 sends them whole through sendEvent().
+        virtual size_t maxMessageBytes() const
+        {
+            return 0;
+        }
+
     };
 }
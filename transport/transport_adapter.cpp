@@ -24,6 +24,66 @@ namespace transport_adapter {
         
     }
 
+    static bool send_message_adapter(void* context, const uint8_t* data, size_t length)
+    {
+        if (context == NULL || data == NULL)
+            return false;
+
+        auto* transport = static_cast<transport::ITransport*>(context);
+
+        return transport->sendMessage(data, length);
+    }
+
+    static bool send_event_signal_safe_adapter(void* context, const telemetry_event_t* event)
+    {
+        if (context == NULL || event == NULL)
+            return false;
+
+        auto* transport = static_cast<transport::ITransport*>(context);
+
+        return transport->sendEventSignalSafe(*event);
+    }
+
+    static int poll_fd_adapter(void* context)
+    {
+        if (context == NULL)
+            return -1;
+
+        auto* transport = static_cast<transport::ITransport*>(context);
+
+        return transport->pollFd();
+    }
+
+    static bool would_block_adapter(void* context)
+    {
+        if (context == NULL)
+            return false;
+
+        auto* transport = static_cast<transport::ITransport*>(context);
+
+        return transport->wouldBlock();
+    }
+
+    static bool flush_adapter(void* context)
+    {
+        if (context == NULL)
+            return false;
+
+        auto* transport = static_cast<transport::ITransport*>(context);
+
+        return transport->flush();
+    }
+
+    static size_t max_message_bytes_adapter(void* context)
+    {
+        if (context == NULL)
+            return 0;
+
+        auto* transport = static_cast<transport::ITransport*>(context);
+
+        return transport->maxMessageBytes();
+    }
+
     transport_c_t make_transport_adapter(transport::ITransport& transport_obj) 
     {
         transport_c_t transport{};
@@ -31,6 +91,12 @@ namespace transport_adapter {
         transport.context = &transport_obj;
         transport.send_event = send_event_adapter;
         transport.shutdown = shutdown_event_adapter;
+        transport.send_message = send_message_adapter;
+        transport.send_event_signal_safe = send_event_signal_safe_adapter;
+        transport.poll_fd = poll_fd_adapter;
+        transport.would_block = would_block_adapter;
+        transport.flush = flush_adapter;
+        transport.max_message_bytes = max_message_bytes_adapter;
         
         return transport;
     }
@@ -20,6 +20,26 @@ typedef struct transport_c {
     // function pointer for shutdown
     void (*shutdown)(void* context);  
 
+    // Optional: send an already encoded protocol message (header + payload), NULL if unsupported
+    bool (*send_message)(void* context, const uint8_t* data, size_t length);
+
+    // Optional: send an event from a signal handler (no locks, no allocation, no stdio), NULL if unsupported
+    bool (*send_event_signal_safe)(void* context, const telemetry_event_t* ev);
+
+    // Optional: descriptor that polls writable when a send that would have blocked can be retried, NULL if unsupported
+    int (*poll_fd)(void* context);
+
+    // Optional: true if the last failed send would have blocked. The agent keeps the event and
+    // retries once poll_fd is writable instead of counting an error. NULL if sends always block.
+    bool (*would_block)(void* context);
+
+    // Optional: hand queued sends to the OS, called before the agent waits and when it stops. NULL if sends go out right away.
+    bool (*flush)(void* context);
+
+    // Optional: largest message send_message accepts. Pooled event payloads are then sent as
+    // TELEMETRY_EVENT_FRAGMENT messages instead of through send_event. NULL or 0 if unsupported.
+    size_t (*max_message_bytes)(void* context);
+
 }transport_c_t;
 
 
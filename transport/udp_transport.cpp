@@ -12,6 +12,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <cerrno>
 #include <unistd.h>
 
 #include <string>
@@ -25,6 +26,15 @@ namespace transport {
 // Typical MTU is 1500 bytes; we use 1200 to stay safe.
 static constexpr size_t kRecommendedMaxUdpPayload = 1200;
 
+// Upper bound of Config::io_uring_entries
+static constexpr uint32_t kMaxUringEntries = 4096;
+
+// Completions taken per reap
+static constexpr size_t kUringReapBatch = 64;
+
+// Waits for a finished send when every slot is in flight, a zero-copy send completes twice
+static constexpr int kUringSlotWaitAttempts = 8;
+
 
 /**
  * @brief Destructor for UDP transport.
@@ -71,6 +81,62 @@ static std::string bytes_to_hex_conversion(const uint8_t* data_bytes, uint32_t b
 }
 
 
+/**
+ * @brief Appends a string without any library call.
+ *
+ * @param output Output buffer.
+ * @param capacity Output buffer size.
+ * @param position Write position, advanced.
+ * @param text NUL terminated text.
+ * @return false if the text did not fit.
+ */
+static bool append_text_signal_safe(char* output, size_t capacity, size_t& position, const char* text)
+{
+    for(; *text != '\0'; text++)
+    {
+        if(position >= capacity)
+            return false;
+
+        output[position++] = *text;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Appends an unsigned decimal number without any library call.
+ *
+ * @param output Output buffer.
+ * @param capacity Output buffer size.
+ * @param position Write position, advanced.
+ * @param value Number to write.
+ * @return false if the number did not fit.
+ */
+static bool append_unsigned_signal_safe(char* output, size_t capacity, size_t& position, unsigned long long value)
+{
+    char digits[20];
+    size_t count = 0;
+
+    do
+    {
+        digits[count++] = static_cast<char>('0' + (value % 10u));
+        value /= 10u;
+    }
+    while(value != 0);
+
+    while(count > 0)
+    {
+        if(position >= capacity)
+            return false;
+
+        output[position++] = digits[--count];
+    }
+
+    return true;
+}
+
+
 /**
  * @brief Initializes the UDP transport with configuration.
  *
@@ -103,6 +169,13 @@ bool UdpTransport::Init(const Config& config)
 
     maximum_datagram_bytes_ = requested;
 
+    // Queue sends on an io_uring, keep sendto where the kernel has none
+    if(config.io_uring && uring_ == nullptr)
+        (void)setup_io_uring(config);
+
+    // io_uring sends never block the agent, a full socket buffer only delays their completions
+    nonblocking_ = config.nonblocking && uring_ == nullptr;
+
     // Open and configure the UDP socket
     if(open_udp_socket() == false)
         return false;
@@ -133,6 +206,26 @@ bool UdpTransport::sendEvent(const telemetry_event_t& event)
     if(ready_ == false || socket_fd_ < 0 || dst_len_ == 0)
         return false;
     
+    // Serialize straight into a datagram slot of the io_uring
+    if(uring_ != nullptr)
+    {
+        uint32_t slot = 0;
+
+        if(!acquire_slot(slot))
+            return false;
+
+        char* slot_buf = static_cast<char*>(slots_[slot].vector.iov_base);
+
+        if(!serialize_event_json(slot_buf, slot_capacity_, event))
+        {
+            free_slots_.push_back(slot);
+            oversize_events_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return queue_datagram(slot, std::strlen(slot_buf));
+    }
+
     // Use the configured buffer size or minimum 256 bytes
     const size_t buf_capacity = (maximum_datagram_bytes_ < 256) ? 256 : maximum_datagram_bytes_;
 
@@ -144,30 +237,261 @@ bool UdpTransport::sendEvent(const telemetry_event_t& event)
     // Calculate actual buffer capacity (use smaller of configured or buffer size)
     const size_t acutal_capacity =  (buf_capacity > sizeof(msg_buf))? sizeof(msg_buf) : buf_capacity;
 
-    // Convert event to JSON format
+    // Convert event to JSON format, a payload too large for one datagram is not sent
     if(!serialize_event_json(msg_buf, acutal_capacity, event))
+    {
+        oversize_events_.fetch_add(1, std::memory_order_relaxed);
         return false;
+    }
 
     // Get the length of the JSON string
     const size_t len = std::strlen(msg_buf);
 
-    // Get the destination address pointer
+    // Send the message to the destination
+    const bool sent = send_datagram(msg_buf, len);
+
+    // Debug code, a full non-blocking socket is not an error
+    if (!sent && !would_block_)
+        std::perror("sendto");
+
+    return sent;
+
+}
+
+
+/**
+ * @brief Sends an encoded protocol message over UDP.
+ *
+ * Transmits the bytes as-is in a single datagram. Used for binary messages
+ * such as heartbeats that are built by the agent.
+ *
+ * @param data Encoded message (header followed by payload).
+ * @param length Number of bytes in the message.
+ * @return true if the whole message is sent, false on failure.
+ */
+bool UdpTransport::sendMessage(const uint8_t* data, size_t length)
+{
+    // Check if transport is ready and socket is valid
+    if(ready_ == false || socket_fd_ < 0 || dst_len_ == 0 || data == NULL)
+        return false;
+
+    // A message never gets split, so it must fit in one datagram
+    if(length == 0 || length > maximum_datagram_bytes_)
+        return false;
+
+    if(uring_ != nullptr)
+    {
+        uint32_t slot = 0;
+
+        if(!acquire_slot(slot))
+            return false;
+
+        std::memcpy(slots_[slot].vector.iov_base, data, length);
+
+        return queue_datagram(slot, length);
+    }
+
+    return send_datagram(data, length);
+}
+
+
+/**
+ * @brief Returns the socket for the agent's poller.
+ *
+ * @return Socket descriptor, -1 when not initialized.
+ */
+int UdpTransport::pollFd() const
+{
+    return socket_fd_;
+}
+
+
+/**
+ * @brief Tells whether the last send failed on a full socket buffer.
+ *
+ * Only a non-blocking socket (Config::nonblocking) fails this way; the
+ * agent keeps the event and retries when the socket polls writable.
+ *
+ * @return true if the last failed send would have blocked.
+ */
+bool UdpTransport::wouldBlock() const
+{
+    return would_block_;
+}
+
+
+/**
+ * @brief Returns the largest message sendMessage() sends.
+ *
+ * The MTU of Init, capped at 1200 bytes. The agent splits pooled event
+ * payloads into fragment messages of this size.
+ *
+ * @return Datagram limit in bytes, 0 when not initialized.
+ */
+size_t UdpTransport::maxMessageBytes() const
+{
+    return ready_ ? maximum_datagram_bytes_ : 0;
+}
+
+
+/**
+ * @brief Hands the queued io_uring sends to the kernel.
+ *
+ * Also takes the finished sends back without waiting. The agent calls
+ * this before it sleeps, so a drained batch goes out with one system
+ * call, or none while the SQPOLL thread is awake. Nothing to do on the
+ * sendto path.
+ *
+ * @return false if the submit failed or a send failed since the last flush.
+ */
+bool UdpTransport::flush()
+{
+    if(uring_ == nullptr)
+        return true;
+
+    const bool submitted = osal_uring_submit(uring_) >= 0;
+
+    (void)reap_completions(0);
+
+    const bool clean = submitted && unreported_errors_ == 0;
+    unreported_errors_ = 0;
+
+    return clean;
+}
+
+
+/**
+ * @brief Tells whether sends go through an io_uring.
+ *
+ * @return true if Config::io_uring was set and the kernel provided one.
+ */
+bool UdpTransport::usesIoUring() const
+{
+    return uring_ != nullptr;
+}
+
+
+/**
+ * @brief Returns the io_uring options that took effect.
+ *
+ * @return OSAL_URING_SQPOLL and/or OSAL_URING_REGISTERED_BUFFERS, 0 on the sendto path.
+ */
+uint32_t UdpTransport::ioUringApplied() const
+{
+    return osal_uring_applied(uring_);
+}
+
+
+/**
+ * @brief Returns the number of io_uring sends that completed with an error.
+ *
+ * sendEvent() and sendMessage() only queue on the io_uring, so a send that
+ * fails later is counted here.
+ *
+ * @return Failed sends since Init.
+ */
+uint64_t UdpTransport::asyncSendErrors() const
+{
+    return async_errors_.load(std::memory_order_relaxed);
+}
+
+
+/**
+ * @brief Returns the number of events refused for a payload too large for one datagram.
+ *
+ * An event's JSON line, payload hex included, must fit the MTU: about
+ * 550 payload bytes at the 1200 byte maximum. Larger payloads are refused
+ * whole, never cut; the agent sends pooled ones as fragment messages
+ * through sendMessage() instead.
+ *
+ * @return Refused events since construction.
+ */
+uint64_t UdpTransport::oversizeEvents() const
+{
+    return oversize_events_.load(std::memory_order_relaxed);
+}
+
+
+/**
+ * @brief Sends one datagram to the configured destination.
+ *
+ * @param data Datagram bytes.
+ * @param length Number of bytes.
+ * @return true if the whole datagram is sent.
+ */
+bool UdpTransport::send_datagram(const void* data, size_t length)
+{
     const sockaddr_in* dst = reinterpret_cast<const sockaddr_in*>(dst_storage_);
 
-    // Send the message to the destination
-    const ssize_t sent = ::sendto(socket_fd_, 
-                                  msg_buf, len, 0, 
-                                  reinterpret_cast<const sockaddr*>(dst), 
+    const ssize_t sent = ::sendto(socket_fd_,
+                                  data, length, 0,
+                                  reinterpret_cast<const sockaddr*>(dst),
                                   static_cast<socklen_t> (dst_len_)
                                 );
 
-    // Debug code
-    if (sent < 0) 
-        std::perror("sendto");
+    would_block_ = (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+
+    return (sent == static_cast<ssize_t>(length));
+}
+
+
+/**
+ * @brief Sends a telemetry event from a signal handler.
+ *
+ * Writes the same JSON line as sendEvent() by hand into a stack buffer and
+ * sends it with sendto(), which is async-signal-safe. No allocation, no
+ * stdio and no locks.
+ *
+ * @param event Telemetry event structure to send.
+ * @return true if event is sent successfully, false on failure.
+ */
+bool UdpTransport::sendEventSignalSafe(const telemetry_event_t& event)
+{
+    static const char* strHex = "0123456789abcdef";
+
+    if(ready_ == false || socket_fd_ < 0 || dst_len_ == 0)
+        return false;
+
+    char msg_buf[1300];
+    const size_t capacity = (maximum_datagram_bytes_ < sizeof(msg_buf)) ? maximum_datagram_bytes_ : sizeof(msg_buf);
+    size_t position = 0;
+
+    // The whole payload or nothing, as in serialize_event_json
+    const uint8_t* payload = telemetry_event_payload(&event);
+    const uint32_t payload_capacity = (payload == nullptr) ? 0u : event.payload_size;
+
+    bool ok = append_text_signal_safe(msg_buf, capacity, position, "{\"id\":") &&
+              append_unsigned_signal_safe(msg_buf, capacity, position, event.event_id) &&
+              append_text_signal_safe(msg_buf, capacity, position, ",\"level\":") &&
+              append_unsigned_signal_safe(msg_buf, capacity, position, event.level) &&
+              append_text_signal_safe(msg_buf, capacity, position, ",\"ts_ns\":") &&
+              append_unsigned_signal_safe(msg_buf, capacity, position, event.timestamp) &&
+              append_text_signal_safe(msg_buf, capacity, position, ",\"payload_len\":") &&
+              append_unsigned_signal_safe(msg_buf, capacity, position, event.payload_size) &&
+              append_text_signal_safe(msg_buf, capacity, position, ",\"payload_hex\":\"");
+
+    for(uint32_t i = 0; ok && i < payload_capacity; i++)
+    {
+        const char hex[3] = { strHex[payload[i] >> 4], strHex[payload[i] & 0x0F], '\0' };
+        ok = append_text_signal_safe(msg_buf, capacity, position, hex);
+    }
+
+    if(!ok || !append_text_signal_safe(msg_buf, capacity, position, "\"}\n"))
+    {
+        // Lock-free counter, safe in a signal handler
+        oversize_events_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
 
-    // Return true if all bytes were sent
-    return (sent == static_cast<size_t>(len));
+    const sockaddr_in* dst = reinterpret_cast<const sockaddr_in*>(dst_storage_);
 
+    const ssize_t sent = ::sendto(socket_fd_,
+                                  msg_buf, position, 0,
+                                  reinterpret_cast<const sockaddr*>(dst),
+                                  static_cast<socklen_t> (dst_len_)
+                                );
+
+    return (sent == static_cast<ssize_t>(position));
 }
 
 
@@ -178,6 +502,9 @@ bool UdpTransport::sendEvent(const telemetry_event_t& event)
  */
 void UdpTransport::shutdown()
 {
+    // Sends in flight still use the socket and the slots
+    teardown_io_uring();
+
     // Close socket if it is open
     if(socket_fd_ >= 0)
     {
@@ -186,11 +513,216 @@ void UdpTransport::shutdown()
     }
 
     ready_ = false;                // Mark transport as not ready
+    would_block_ = false;          // Nothing left to retry
     dst_len_ = 0;                  // Clear destination address info
 
 }
 
 
+/**
+ * @brief Creates the io_uring and its datagram slots.
+ *
+ * One slot per io_uring entry, each as large as the sendto buffer, in
+ * prefaulted pages that are registered with the io_uring when
+ * Config::io_uring_registered_buffers is set.
+ *
+ * @param config Configuration with the io_uring options.
+ * @return true if sends go through the io_uring, false to keep sendto.
+ */
+bool UdpTransport::setup_io_uring(const Config& config)
+{
+    uint32_t entries = config.io_uring_entries;
+
+    if(entries == 0)
+        entries = 1;
+
+    if(entries > kMaxUringEntries)
+        entries = kMaxUringEntries;
+
+    // Same capacity as the sendto buffer, slots start on cache lines
+    slot_capacity_ = (maximum_datagram_bytes_ < 256) ? 256 : maximum_datagram_bytes_;
+    slot_bytes_ = (slot_capacity_ + 63u) & ~static_cast<size_t>(63u);
+
+    if(!osal_memory_map(&slot_memory_, slot_bytes_ * entries, OSAL_MEMORY_PREFAULT, OSAL_MEMORY_NODE_LOCAL))
+        return false;
+
+    uint32_t flags = 0;
+
+    if(config.io_uring_sqpoll)
+        flags |= OSAL_URING_SQPOLL;
+
+    if(config.io_uring_registered_buffers)
+        flags |= OSAL_URING_REGISTERED_BUFFERS;
+
+    uring_ = osal_uring_create(entries, flags, slot_memory_.address, slot_memory_.length);
+
+    if(uring_ == nullptr)
+    {
+        osal_memory_unmap(&slot_memory_);
+        return false;
+    }
+
+    slots_.assign(entries, UringSlot{});
+    free_slots_.clear();
+    free_slots_.reserve(entries);
+
+    // Lowest slot on top of the stack
+    for(uint32_t index = entries; index > 0; index--)
+    {
+        UringSlot& slot = slots_[index - 1u];
+
+        slot.vector.iov_base = static_cast<uint8_t*>(slot_memory_.address) + ((index - 1u) * slot_bytes_);
+        slot.message.msg_name = dst_storage_;
+        slot.message.msg_iov = &slot.vector;
+        slot.message.msg_iovlen = 1;
+
+        free_slots_.push_back(index - 1u);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Takes a free datagram slot.
+ *
+ * Reaps finished sends first; with every slot in flight it submits and
+ * waits for the kernel to finish one.
+ *
+ * @param out_slot Receives the slot.
+ * @return true if a slot was taken.
+ */
+bool UdpTransport::acquire_slot(uint32_t& out_slot)
+{
+    if(free_slots_.empty())
+        (void)reap_completions(0);
+
+    if(free_slots_.empty())
+    {
+        if(osal_uring_submit(uring_) < 0)
+            return false;
+
+        for(int attempt = 0; free_slots_.empty() && attempt < kUringSlotWaitAttempts; attempt++)
+            (void)reap_completions(1);
+    }
+
+    if(free_slots_.empty())
+        return false;
+
+    out_slot = free_slots_.back();
+    free_slots_.pop_back();
+
+    return true;
+}
+
+
+/**
+ * @brief Queues the datagram held by a slot.
+ *
+ * Handed to the kernel at the next flush(), so the agent's flush policy
+ * decides the batch, or once every slot is in use.
+ *
+ * @param slot Slot holding the datagram.
+ * @param length Datagram bytes.
+ * @return true if queued, false gives the slot back.
+ */
+bool UdpTransport::queue_datagram(uint32_t slot, size_t length)
+{
+    UringSlot& entry = slots_[slot];
+    bool queued = false;
+
+    // The padding up to slot_bytes_ is not part of the datagram limit
+    if(length > slot_capacity_)
+    {
+        free_slots_.push_back(slot);
+        return false;
+    }
+
+    if((osal_uring_applied(uring_) & OSAL_URING_REGISTERED_BUFFERS) != 0)
+    {
+        queued = osal_uring_queue_send_fixed(uring_, socket_fd_, entry.vector.iov_base, length,
+                                             dst_storage_, dst_len_, slot);
+    }
+    else
+    {
+        entry.vector.iov_len = length;
+        entry.message.msg_namelen = static_cast<socklen_t> (dst_len_);
+        queued = osal_uring_queue_sendmsg(uring_, socket_fd_, &entry.message, slot);
+    }
+
+    if(!queued)
+    {
+        free_slots_.push_back(slot);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Takes the finished sends back.
+ *
+ * @param wait_count Completions to wait for, 0 never blocks.
+ * @return Number of completions reaped.
+ */
+size_t UdpTransport::reap_completions(uint32_t wait_count)
+{
+    osal_uring_completion_t completions[kUringReapBatch];
+    size_t total = 0;
+    size_t count = osal_uring_reap(uring_, completions, kUringReapBatch, wait_count);
+
+    while(count > 0)
+    {
+        for(size_t index = 0; index < count; index++)
+        {
+            if(completions[index].result < 0)
+            {
+                async_errors_.fetch_add(1, std::memory_order_relaxed);
+                unreported_errors_++;
+            }
+
+            // A zero-copy send keeps its slot until the kernel lets go of the buffer
+            if(completions[index].release)
+                free_slots_.push_back(static_cast<uint32_t> (completions[index].user_data));
+        }
+
+        total += count;
+        count = osal_uring_reap(uring_, completions, kUringReapBatch, 0);
+    }
+
+    return total;
+}
+
+
+/**
+ * @brief Waits for the sends in flight and frees the io_uring.
+ *
+ * A wait interrupted without a completion gives up; closing the io_uring
+ * cancels what is left.
+ */
+void UdpTransport::teardown_io_uring()
+{
+    if(uring_ == nullptr)
+        return;
+
+    if(osal_uring_submit(uring_) >= 0)
+    {
+        while(free_slots_.size() < slots_.size() && reap_completions(1) > 0)
+        {
+        }
+    }
+
+    osal_uring_destroy(uring_);
+    uring_ = nullptr;
+
+    osal_memory_unmap(&slot_memory_);
+    slots_.clear();
+    free_slots_.clear();
+    unreported_errors_ = 0;
+}
+
+
 /**
  * @brief Opens a UDP socket for network communication.
  *
@@ -205,8 +737,9 @@ bool UdpTransport::open_udp_socket()
     if(socket_fd_ >= 0)
         return true;
 
-    // Create a new UDP socket using AF_INET (IPv4) and SOCK_DGRAM (datagram)
-    socket_fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    // Create a new UDP socket using AF_INET (IPv4) and SOCK_DGRAM (datagram),
+    // non-blocking if the agent should poll it instead of waiting in sendto
+    socket_fd_ = ::socket(AF_INET, SOCK_DGRAM | (nonblocking_ ? SOCK_NONBLOCK : 0), 0);
 
     if(socket_fd_ < 0)
     {
@@ -298,7 +831,8 @@ bool UdpTransport::configure_destination(const char* endpoint_string)
  *
  * Serializes a telemetry event into JSON text format containing the event ID,
  * severity level, timestamp, payload size, and hexadecimal payload data.
- * Limits payload to 128 bytes for network efficiency.
+ * The whole payload is written, a payload whose hex does not fit the buffer
+ * is refused rather than cut.
  *
  * @param output_buffer Output buffer to store the JSON string.
  * @param buffer_capacity Maximum capacity of the output buffer in bytes.
@@ -311,17 +845,19 @@ bool UdpTransport::serialize_event_json(char* output_buffer, size_t buffer_capac
     if(output_buffer == NULL || buffer_capacity == 0)
         return false;
 
+    // Inline bytes or the pool block of a large payload
+    const uint8_t* payload = telemetry_event_payload(&event);
     uint32_t payload_len = static_cast<uint32_t> (event.payload_size);
-    uint32_t payload_capacity = payload_len;
+    uint32_t payload_capacity = (payload == nullptr) ? 0u : payload_len;
 
-    // Limit the payload to 128 bytes for efficiency
-    if(payload_capacity > 128)
-        payload_capacity = 128u;
+    // Two hex characters per byte, a payload that cannot fit is refused before it is converted
+    if(static_cast<size_t> (payload_capacity) * 2 >= buffer_capacity)
+        return false;
 
     std::string payload_hex;
     if(payload_capacity > 0)
     {
-        payload_hex = bytes_to_hex_conversion(reinterpret_cast<const uint8_t*>(event.payload), payload_capacity);
+        payload_hex = bytes_to_hex_conversion(payload, payload_capacity);
     }
 
     int n = std::snprintf(output_buffer, buffer_capacity, 
@@ -2,6 +2,15 @@
 
 #include "transport.hpp"
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <vector>
+
+#include "../os/include/osal_memory.h"
+#include "../os/include/osal_uring.h"
+
 // This module provides UDP transport for sending telemetry events.
 // It implements the ITransport interface to send data over UDP sockets.
 
@@ -19,6 +28,26 @@ namespace transport {
             bool Init(const Config& config) override;
             // Sends a telemetry event over UDP
             bool sendEvent(const telemetry_event_t& event) override;
+            // Sends an encoded protocol message as a single datagram
+            bool sendMessage(const uint8_t* data, size_t length) override;
+            // Sends a telemetry event from a signal handler, same JSON as sendEvent
+            bool sendEventSignalSafe(const telemetry_event_t& event) override;
+            // Returns the socket, polled for writability by the agent
+            int pollFd() const override;
+            // Returns true if the last send failed because the socket buffer was full
+            bool wouldBlock() const override;
+            // Submits the sends queued on the io_uring and reaps finished ones without waiting
+            bool flush() override;
+            // Returns the datagram limit, the largest message sendMessage takes
+            size_t maxMessageBytes() const override;
+            // Returns true if sends go through an io_uring (Config::io_uring and the kernel supports it)
+            bool usesIoUring() const;
+            // Returns the OSAL_URING_* options that took effect on the io_uring
+            uint32_t ioUringApplied() const;
+            // Returns the number of io_uring sends that completed with an error
+            uint64_t asyncSendErrors() const;
+            // Returns the number of events whose payload did not fit one datagram, refused rather than cut
+            uint64_t oversizeEvents() const;
             // Shuts down the UDP transport and cleans up resources
             void shutdown() override;
 
@@ -29,12 +58,35 @@ namespace transport {
             bool configure_destination(const char* endpoint_string);
             // Converts the telemetry event to JSON format for transmission
             bool serialize_event_json(char* output_buffer, size_t buffer_capacity, const telemetry_event_t& event) const;
+            // Sends one datagram to the destination, recording a full socket buffer
+            bool send_datagram(const void* data, size_t length);
+            // Creates the io_uring and its datagram slots, false to keep sendto
+            bool setup_io_uring(const Config& config);
+            // Takes a free datagram slot, reaping or waiting for a finished send if none is free
+            bool acquire_slot(uint32_t& out_slot);
+            // Queues the datagram held by a slot on the io_uring
+            bool queue_datagram(uint32_t slot, size_t length);
+            // Returns the slots of finished sends, waiting for wait_count completions first
+            size_t reap_completions(uint32_t wait_count);
+            // Waits for every send in flight, then frees the io_uring and its slots
+            void teardown_io_uring();
+
+            // One datagram buffer of the io_uring path and the message that sends it
+            struct UringSlot
+            {
+                msghdr message;
+                iovec vector;
+            };
 
         private:
             // File descriptor for the UDP socket
             int socket_fd_ = -1;
             // Flag to check if the transport is ready to send data
             bool ready_ = false;
+            // Socket in non-blocking mode (Config::nonblocking)
+            bool nonblocking_ = false;
+            // Last send failed with EAGAIN on a non-blocking socket
+            bool would_block_ = false;
 
             // Maximum size of a UDP datagram in bytes
             size_t maximum_datagram_bytes_ = 512;
@@ -45,6 +97,23 @@ namespace transport {
             alignas(8) unsigned char dst_storage_[32];
 
             unsigned dst_len_ = 0;
+
+            // io_uring send path (Config::io_uring), nullptr while sending with sendto
+            osal_uring_t* uring_ = nullptr;
+            // Datagram buffers, slot_bytes_ each, registered with the io_uring if asked for
+            osal_memory_t slot_memory_{};
+            size_t slot_bytes_ = 0;
+            // Usable bytes of a slot, the same limit as the sendto path; slot_bytes_ is only the stride
+            size_t slot_capacity_ = 0;
+            std::vector<UringSlot> slots_;
+            // Slots not in flight, used as a stack
+            std::vector<uint32_t> free_slots_;
+            // Sends that failed since the last flush, reported by its return value
+            uint32_t unreported_errors_ = 0;
+            // Sends that completed with an error
+            std::atomic<uint64_t> async_errors_{0};
+            // Events refused because their JSON line did not fit a datagram
+            std::atomic<uint64_t> oversize_events_{0};
     };
 
 }
\ No newline at end of file